@@ -25,6 +25,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include <termios.h>
 #include <utils/util_misc.h>
+#include <utils/util_attitude.h>
 #include <utils/util_file.h>
 #include <utils/cJSON.h>
 #include <dji_aircraft_info.h>
@@ -32,7 +33,9 @@
 #include "dji_flight_controller.h"
 #include "dji_logger.h"
 #include "dji_fc_subscription.h"
+#include "fc_subscription/test_fc_subscription_snapshot.h"
 #include "cmath"
+#include "cstddef"
 
 #ifdef OPEN_CV_INSTALLED
 
@@ -51,8 +54,27 @@ using namespace cv;
 #define DJI_TEST_COMMAND_FLYING_CONFIG_DIR_PATH_LEN_MAX                  (256)
 
 /* Private types -------------------------------------------------------------*/
+typedef struct {
+    T_DjiFcSubscriptionQuaternion quaternion;
+    T_DjiFcSubscriptionGpsPosition gpsPosition;
+    T_DjiFcSubscriptionHeightFusion heightFusion;
+    T_DjiFcSubscriptionPositionVO positionVo;
+    T_DjiFcSubscriptionControlDevice controlDevice;
+} T_DjiUserFlightStatusSnapshot;
 
 /* Private values -------------------------------------------------------------*/
+static const T_DjiTestFcSubscriptionSnapshotTopicConfig s_flightStatusTopics[] = {
+    {DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION,     DJI_DATA_SUBSCRIPTION_TOPIC_50_HZ,
+        sizeof(T_DjiFcSubscriptionQuaternion),    offsetof(T_DjiUserFlightStatusSnapshot, quaternion)},
+    {DJI_FC_SUBSCRIPTION_TOPIC_GPS_POSITION,   DJI_DATA_SUBSCRIPTION_TOPIC_5_HZ,
+        sizeof(T_DjiFcSubscriptionGpsPosition),   offsetof(T_DjiUserFlightStatusSnapshot, gpsPosition)},
+    {DJI_FC_SUBSCRIPTION_TOPIC_HEIGHT_FUSION,  DJI_DATA_SUBSCRIPTION_TOPIC_10_HZ,
+        sizeof(T_DjiFcSubscriptionHeightFusion),  offsetof(T_DjiUserFlightStatusSnapshot, heightFusion)},
+    {DJI_FC_SUBSCRIPTION_TOPIC_POSITION_VO,    DJI_DATA_SUBSCRIPTION_TOPIC_10_HZ,
+        sizeof(T_DjiFcSubscriptionPositionVO),    offsetof(T_DjiUserFlightStatusSnapshot, positionVo)},
+    {DJI_FC_SUBSCRIPTION_TOPIC_CONTROL_DEVICE, DJI_DATA_SUBSCRIPTION_TOPIC_5_HZ,
+        sizeof(T_DjiFcSubscriptionControlDevice), offsetof(T_DjiUserFlightStatusSnapshot, controlDevice)},
+};
 static T_DjiTaskHandle s_commandFlyingTaskHandle;
 static T_DjiTaskHandle s_statusDisplayTaskHandle;
 static T_DjiFlightControllerJoystickCommand s_flyingCommand = {0};
@@ -76,11 +98,10 @@ static void DjiUser_FlightControllerVelocityAndYawRateCtrl(T_DjiFlightController
 static int DjiUser_ScanKeyboardInput(void);
 static T_DjiReturnCode
 DjiUser_FlightCtrlJoystickCtrlAuthSwitchEventCb(T_DjiFlightControllerJoystickCtrlAuthorityEventInfo eventData);
-static T_DjiVector3f DjiUser_FlightControlGetValueOfQuaternion(void);
-static T_DjiFcSubscriptionGpsPosition DjiUser_FlightControlGetValueOfGpsPosition(void);
-static T_DjiFcSubscriptionAltitudeOfHomePoint DjiUser_FlightControlGetValueOfRelativeHeight(void);
-static T_DjiFcSubscriptionPositionVO DjiUser_FlightControlGetValueOfPositionVo(void);
-static T_DjiFcSubscriptionControlDevice DjiUser_FlightControlGetValueOfControlDevice(void);
+static T_DjiUserFlightStatusSnapshot DjiUser_FlightControlGetFlightStatusSnapshot(void);
+#ifdef OPEN_CV_INSTALLED
+static T_DjiVector3f DjiUser_FlightControlQuaternionToAngles(T_DjiFcSubscriptionQuaternion quaternion);
+#endif
 static T_DjiFcSubscriptionSingleBatteryInfo DjiUser_FlightControlGetValueOfBattery1(void);
 static T_DjiFcSubscriptionSingleBatteryInfo DjiUser_FlightControlGetValueOfBattery2(void);
 static T_DjiReturnCode DjiUser_FlightControlUpdateConfig(void);
@@ -313,44 +334,11 @@ static void *DjiUser_FlightControllerCommandFlyingTask(void *arg)
         return NULL;
     }
 
-    /*! subscribe fc data */
-    returnCode = DjiFcSubscription_SubscribeTopic(DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION,
-                                                  DJI_DATA_SUBSCRIPTION_TOPIC_50_HZ,
-                                                  NULL);
-    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("Subscribe topic flight status failed, error code:0x%08llX", returnCode);
-        return NULL;
-    }
-
-    returnCode = DjiFcSubscription_SubscribeTopic(DJI_FC_SUBSCRIPTION_TOPIC_GPS_POSITION,
-                                                  DJI_DATA_SUBSCRIPTION_TOPIC_5_HZ,
-                                                  NULL);
-    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("Subscribe topic gps failed, error code:0x%08llX", returnCode);
-        return NULL;
-    }
-
-    returnCode = DjiFcSubscription_SubscribeTopic(DJI_FC_SUBSCRIPTION_TOPIC_HEIGHT_FUSION,
-                                                  DJI_DATA_SUBSCRIPTION_TOPIC_10_HZ,
-                                                  NULL);
-    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("Subscribe topic altitude failed, error code:0x%08llX", returnCode);
-        return NULL;
-    }
-
-    returnCode = DjiFcSubscription_SubscribeTopic(DJI_FC_SUBSCRIPTION_TOPIC_POSITION_VO,
-                                                  DJI_DATA_SUBSCRIPTION_TOPIC_10_HZ,
-                                                  NULL);
-    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("Subscribe topic altitude failed, error code:0x%08llX", returnCode);
-        return NULL;
-    }
-
-    returnCode = DjiFcSubscription_SubscribeTopic(DJI_FC_SUBSCRIPTION_TOPIC_CONTROL_DEVICE,
-                                                  DJI_DATA_SUBSCRIPTION_TOPIC_5_HZ,
-                                                  NULL);
+    /*! subscribe fc data, the status display reads all topics with one snapshot per tick */
+    returnCode = DjiTest_FcSubscriptionSnapshotInit(s_flightStatusTopics, UTIL_ARRAY_SIZE(s_flightStatusTopics),
+                                                    sizeof(T_DjiUserFlightStatusSnapshot));
     if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("Subscribe topic altitude failed, error code:0x%08llX", returnCode);
+        USER_LOG_ERROR("Subscribe flight status topics failed, error code:0x%08llX", returnCode);
         return NULL;
     }
 
@@ -420,8 +408,7 @@ static void DjiUser_ShowFlightStatusByOpenCV(void)
     E_DjiFlightControllerObstacleAvoidanceEnableStatus horizontalVisEnable;
 //    E_DjiFlightControllerObstacleAvoidanceEnableStatus upwardsRadarEnable;
 //    E_DjiFlightControllerObstacleAvoidanceEnableStatus horizontalRadarEnable;
-    T_DjiFcSubscriptionControlDevice controlDevice;
-    T_DjiFcSubscriptionPositionVO positionVo;
+    T_DjiUserFlightStatusSnapshot flightStatus;
     T_DjiAircraftInfoBaseInfo aircraftInfoBaseInfo;
     T_DjiReturnCode returnCode;
 
@@ -444,11 +431,10 @@ static void DjiUser_ShowFlightStatusByOpenCV(void)
 //    DjiFlightController_GetHorizontalRadarObstacleAvoidanceEnableStatus(&horizontalRadarEnable);
     DjiFlightController_GetHorizontalVisualObstacleAvoidanceEnableStatus(&horizontalVisEnable);
 
-    controlDevice = DjiUser_FlightControlGetValueOfControlDevice();
-    aircraftAngles = DjiUser_FlightControlGetValueOfQuaternion();
-    s_gpsPosition = DjiUser_FlightControlGetValueOfGpsPosition();
-    altitudeOfHomePoint = DjiUser_FlightControlGetValueOfRelativeHeight();
-    positionVo = DjiUser_FlightControlGetValueOfPositionVo();
+    flightStatus = DjiUser_FlightControlGetFlightStatusSnapshot();
+    aircraftAngles = DjiUser_FlightControlQuaternionToAngles(flightStatus.quaternion);
+    s_gpsPosition = flightStatus.gpsPosition;
+    altitudeOfHomePoint = flightStatus.heightFusion;
 
     if (s_statusDisplayTaskCnt++ % 20 == 0) {
         singleBatteryInfo1 = DjiUser_FlightControlGetValueOfBattery1();
@@ -465,9 +451,9 @@ static void DjiUser_ShowFlightStatusByOpenCV(void)
                 cv::Scalar(200, 0, 0));
     cv::putText(img, "Yaw: " + cv::format("%.4f", aircraftAngles.z), cv::Point(50, 110), FONT_HERSHEY_SIMPLEX, 0.5,
                 cv::Scalar(200, 0, 0));
-    cv::putText(img, "WorldX: " + cv::format("%.4f", positionVo.x), cv::Point(50, 140), FONT_HERSHEY_SIMPLEX, 0.5,
+    cv::putText(img, "WorldX: " + cv::format("%.4f", flightStatus.positionVo.x), cv::Point(50, 140), FONT_HERSHEY_SIMPLEX, 0.5,
                 cv::Scalar(200, 0, 0));
-    cv::putText(img, "WorldY: " + cv::format("%.4f", positionVo.y), cv::Point(50, 170), FONT_HERSHEY_SIMPLEX, 0.5,
+    cv::putText(img, "WorldY: " + cv::format("%.4f", flightStatus.positionVo.y), cv::Point(50, 170), FONT_HERSHEY_SIMPLEX, 0.5,
                 cv::Scalar(200, 0, 0));
     cv::putText(img, "WorldZ: " + cv::format("%.4f", altitudeOfHomePoint), cv::Point(50, 200), FONT_HERSHEY_SIMPLEX,
                 0.5, cv::Scalar(200, 0, 0));
@@ -501,7 +487,7 @@ static void DjiUser_ShowFlightStatusByOpenCV(void)
                 FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(200, 0, 0));
     cv::putText(img, "-> horizontalVisEnable(Sync APP): " + cv::format("%d", horizontalVisEnable), cv::Point(320, 290),
                 FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(200, 0, 0));
-    cv::putText(img, "-> ControlDevice: " + cv::format("%d", controlDevice.deviceStatus), cv::Point(320, 320),
+    cv::putText(img, "-> ControlDevice: " + cv::format("%d", flightStatus.controlDevice.deviceStatus), cv::Point(320, 320),
                 FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(200, 0, 0));
 
     cv::putText(img,
@@ -625,124 +611,45 @@ DjiUser_FlightCtrlJoystickCtrlAuthSwitchEventCb(T_DjiFlightControllerJoystickCtr
     return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
 }
 
-static T_DjiVector3f DjiUser_FlightControlGetValueOfQuaternion(void)
+static T_DjiUserFlightStatusSnapshot DjiUser_FlightControlGetFlightStatusSnapshot(void)
 {
     T_DjiReturnCode djiStat;
-    T_DjiFcSubscriptionQuaternion quaternion = {0};
-    T_DjiDataTimestamp quaternionTimestamp = {0};
-    dji_f64_t pitch, yaw, roll;
-    T_DjiVector3f vector3F;
-
-    djiStat = DjiFcSubscription_GetLatestValueOfTopic(DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION,
-                                                      (uint8_t *) &quaternion,
-                                                      sizeof(T_DjiFcSubscriptionQuaternion),
-                                                      &quaternionTimestamp);
+    T_DjiUserFlightStatusSnapshot flightStatus = {0};
+    T_DjiTestFcSubscriptionSnapshotInfo snapshotInfo;
 
+    djiStat = DjiTest_FcSubscriptionSnapshotGet(&flightStatus, sizeof(T_DjiUserFlightStatusSnapshot), &snapshotInfo);
     if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("Get value of topic quaternion error, error code: 0x%08X", djiStat);
+        USER_LOG_ERROR("Get flight status snapshot error, error code: 0x%08X", djiStat);
     } else {
-        USER_LOG_DEBUG("Timestamp: millisecond %u microsecond %u.", quaternionTimestamp.millisecond,
-                       quaternionTimestamp.microsecond);
-        USER_LOG_DEBUG("Quaternion: %f %f %f %f.", quaternion.q0, quaternion.q1, quaternion.q2, quaternion.q3);
-    }
-
-    pitch = (dji_f64_t) asinf(-2 * quaternion.q1 * quaternion.q3 + 2 * quaternion.q0 * quaternion.q2) * 57.3;
-    roll = (dji_f64_t) atan2f(2 * quaternion.q2 * quaternion.q3 + 2 * quaternion.q0 * quaternion.q1,
-                              -2 * quaternion.q1 * quaternion.q1 - 2 * quaternion.q2 * quaternion.q2 + 1) * 57.3;
-    yaw = (dji_f64_t) atan2f(2 * quaternion.q1 * quaternion.q2 + 2 * quaternion.q0 * quaternion.q3,
-                             -2 * quaternion.q2 * quaternion.q2 - 2 * quaternion.q3 * quaternion.q3 + 1) *
-          57.3;
-
-    vector3F.x = pitch;
-    vector3F.y = roll;
-    vector3F.z = yaw;
-
-    return vector3F;
-}
-
-static T_DjiFcSubscriptionGpsPosition DjiUser_FlightControlGetValueOfGpsPosition(void)
-{
-    T_DjiReturnCode djiStat;
-    T_DjiDataTimestamp timestamp = {0};
-    T_DjiFcSubscriptionGpsPosition gpsPosition;
-
-    djiStat = DjiFcSubscription_GetLatestValueOfTopic(DJI_FC_SUBSCRIPTION_TOPIC_GPS_POSITION,
-                                                      (uint8_t *) &gpsPosition,
-                                                      sizeof(T_DjiFcSubscriptionGpsPosition),
-                                                      &timestamp);
-
-    if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("Get value of topic quaternion error, error code: 0x%08X", djiStat);
-    } else {
-        USER_LOG_DEBUG("Timestamp: millisecond %u microsecond %u.", timestamp.millisecond,
-                       timestamp.microsecond);
+        USER_LOG_DEBUG("Topic age: quaternion %u ms, gps %u ms, height %u ms, vo %u ms, control device %u ms.",
+                       snapshotInfo.ageMs[0], snapshotInfo.ageMs[1], snapshotInfo.ageMs[2], snapshotInfo.ageMs[3],
+                       snapshotInfo.ageMs[4]);
+        USER_LOG_DEBUG("Quaternion: %f %f %f %f.", flightStatus.quaternion.q0, flightStatus.quaternion.q1,
+                       flightStatus.quaternion.q2, flightStatus.quaternion.q3);
     }
 
-    return gpsPosition;
+    return flightStatus;
 }
 
-static T_DjiFcSubscriptionAltitudeOfHomePoint DjiUser_FlightControlGetValueOfRelativeHeight(void)
-{
-    T_DjiReturnCode djiStat;
-    T_DjiDataTimestamp timestamp = {0};
-    T_DjiFcSubscriptionAltitudeOfHomePoint altitudeOfHomePoint;
-
-    djiStat = DjiFcSubscription_GetLatestValueOfTopic(DJI_FC_SUBSCRIPTION_TOPIC_HEIGHT_FUSION,
-                                                      (uint8_t *) &altitudeOfHomePoint,
-                                                      sizeof(T_DjiFcSubscriptionAltitudeOfHomePoint),
-                                                      &timestamp);
-
-    if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("Get value of topic quaternion error, error code: 0x%08X", djiStat);
-    } else {
-        USER_LOG_DEBUG("Timestamp: millisecond %u microsecond %u.", timestamp.millisecond,
-                       timestamp.microsecond);
-    }
-
-    return altitudeOfHomePoint;
-}
-
-static T_DjiFcSubscriptionPositionVO DjiUser_FlightControlGetValueOfPositionVo(void)
-{
-    T_DjiReturnCode djiStat;
-    T_DjiDataTimestamp timestamp = {0};
-    T_DjiFcSubscriptionPositionVO positionVo;
-
-    djiStat = DjiFcSubscription_GetLatestValueOfTopic(DJI_FC_SUBSCRIPTION_TOPIC_POSITION_VO,
-                                                      (uint8_t *) &positionVo,
-                                                      sizeof(T_DjiFcSubscriptionPositionVO),
-                                                      &timestamp);
-
-    if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("Get value of topic quaternion error, error code: 0x%08X", djiStat);
-    } else {
-        USER_LOG_DEBUG("Timestamp: millisecond %u microsecond %u.", timestamp.millisecond,
-                       timestamp.microsecond);
-    }
-
-    return positionVo;
-}
-
-static T_DjiFcSubscriptionControlDevice DjiUser_FlightControlGetValueOfControlDevice(void)
+#ifdef OPEN_CV_INSTALLED
+static T_DjiVector3f DjiUser_FlightControlQuaternionToAngles(T_DjiFcSubscriptionQuaternion quaternion)
 {
-    T_DjiReturnCode djiStat;
-    T_DjiDataTimestamp timestamp = {0};
-    T_DjiFcSubscriptionControlDevice controlDevice;
+    T_UtilAttitudeQuaternion attitudeQuaternion = {quaternion.q0, quaternion.q1, quaternion.q2, quaternion.q3};
+    T_UtilAttitudeEuler euler = UtilAttitude_QuaternionToEuler(attitudeQuaternion);
+    dji_f64_t pitch, yaw, roll;
+    T_DjiVector3f vector3F;
 
-    djiStat = DjiFcSubscription_GetLatestValueOfTopic(DJI_FC_SUBSCRIPTION_TOPIC_CONTROL_DEVICE,
-                                                      (uint8_t *) &controlDevice,
-                                                      sizeof(T_DjiFcSubscriptionControlDevice),
-                                                      &timestamp);
+    pitch = (dji_f64_t) euler.pitch * UTIL_ATTITUDE_RAD_TO_DEG;
+    roll = (dji_f64_t) euler.roll * UTIL_ATTITUDE_RAD_TO_DEG;
+    yaw = (dji_f64_t) euler.yaw * UTIL_ATTITUDE_RAD_TO_DEG;
 
-    if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("Get value of topic quaternion error, error code: 0x%08X", djiStat);
-    } else {
-        USER_LOG_DEBUG("Timestamp: millisecond %u microsecond %u.", timestamp.millisecond,
-                       timestamp.microsecond);
-    }
+    vector3F.x = pitch;
+    vector3F.y = roll;
+    vector3F.z = yaw;
 
-    return controlDevice;
+    return vector3F;
 }
+#endif
 
 static T_DjiFcSubscriptionSingleBatteryInfo DjiUser_FlightControlGetValueOfBattery1(void)
 {
@@ -938,7 +845,7 @@ static T_DjiReturnCode DjiUser_FlightControlUpdateConfig(void)
 
     if (isFirstUpdateConfig == false) {
         USER_LOG_INFO("Using current aircraft location, not use config home location.");
-        s_gpsPosition = DjiUser_FlightControlGetValueOfGpsPosition();
+        s_gpsPosition = DjiUser_FlightControlGetFlightStatusSnapshot().gpsPosition;
         s_homeLocation.latitude = (dji_f64_t) s_gpsPosition.y / 10000000;
         s_homeLocation.longitude = (dji_f64_t) s_gpsPosition.x / 10000000;
 
@@ -29,6 +29,7 @@
 #include "test_gimbal_entry.hpp"
 #include "dji_logger.h"
 #include "utils/util_misc.h"
+#include "utils/util_attitude.h"
 #include "dji_gimbal.h"
 #include "dji_gimbal_manager.h"
 #include <iostream>
@@ -311,6 +312,7 @@ start:
                 dji_f32_t qPitch, qRoll, qYaw;
                 dji_f32_t yawOffset = 0;
                 T_DjiFcSubscriptionImuAttiNaviDataWithTimestamp naviData = {0};
+                T_UtilAttitudeQuaternion attitudeQuaternion;
 
                 osalHandler->TaskSleepMs(5);
                 printf("gimbal mode: 0: free, 1: fpv, 2: yaw-follow, 3: exit sample\n");
@@ -349,8 +351,8 @@ start:
                         USER_LOG_ERROR("returnCode = 0x%08X", returnCode);
                     }
 
-                    nYaw = (dji_f64_t) atan2f(2 * naviData.q[1] * naviData.q[2] + 2 * naviData.q[0] * naviData.q[3],
-                                            -2 * naviData.q[2] * naviData.q[2] - 2 * naviData.q[3] * naviData.q[3] + 1) * 57.3;
+                    attitudeQuaternion = {naviData.q[0], naviData.q[1], naviData.q[2], naviData.q[3]};
+                    nYaw = (dji_f64_t) UtilAttitude_QuaternionToEuler(attitudeQuaternion).yaw * UTIL_ATTITUDE_RAD_TO_DEG;
 
                     returnCode = DjiFcSubscription_GetLatestValueOfTopic(DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION,
                                                                         (uint8_t *) &quat,
@@ -361,8 +363,8 @@ start:
                         goto end;
                     }
 
-                    qYaw = (dji_f64_t) atan2f(2 * quat.q1 * quat.q2 + 2 * quat.q0 * quat.q3,
-                                            -2 * quat.q2 * quat.q2 - 2 * quat.q3 * quat.q3 + 1) * 57.3;
+                    attitudeQuaternion = {quat.q0, quat.q1, quat.q2, quat.q3};
+                    qYaw = (dji_f64_t) UtilAttitude_QuaternionToEuler(attitudeQuaternion).yaw * UTIL_ATTITUDE_RAD_TO_DEG;
 
 
                     yawOffset = nYaw - qYaw;
@@ -0,0 +1,466 @@
+/**
+ ********************************************************************
+ * @file    dji_radar_frame_processor.cpp
+ * @brief   Converts millimeter wave radar packets into Cartesian point cloud sweeps and queues them
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_radar_frame_processor.hpp"
+#include <cmath>
+#include <cfloat>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "dji_logger.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define DJI_RADAR_ANGLE_UNIT_RAD            0.001f
+/* Raw angles are 0.001 rad steps of [0, 2 PI), sine and cosine of larger values are computed directly. */
+#define DJI_RADAR_ANGLE_TABLE_SIZE          6284
+#define DJI_RADAR_RADIUS_UNIT_M             0.01f
+#define DJI_RADAR_ENERGY_UNIT               0.01f
+#define DJI_RADAR_VELOCITY_OFFSET           32767
+#define DJI_RADAR_VELOCITY_UNIT_MPS         0.01f
+#define DJI_RADAR_BEAM_ANGLE_UNIT_DEG       0.1f
+#define DJI_RADAR_BEAM_ANGLE_POSITIVE_MAX   450
+#define DJI_RADAR_BEAM_ANGLE_WRAP_DEG       90.0f
+/* Arrays of a sweep start on a cache line. */
+#define DJI_RADAR_FRAME_ARRAY_ALIGNMENT     64
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    float sine[DJI_RADAR_ANGLE_TABLE_SIZE];
+    float cosine[DJI_RADAR_ANGLE_TABLE_SIZE];
+} T_DjiRadarAngleTable;
+
+/* Private values -------------------------------------------------------------*/
+
+/* Private functions declaration ---------------------------------------------*/
+static const T_DjiRadarAngleTable *DjiRadarFrameProcessor_GetAngleTable(void);
+static inline void DjiRadarFrameProcessor_SinCos(const T_DjiRadarAngleTable *table, uint16_t rawAngle,
+                                                 float *sine, float *cosine);
+static uint32_t DjiRadarFrameProcessor_AlignedArrayLen(uint32_t len, uint32_t elementSize);
+
+/* Exported functions definition ---------------------------------------------*/
+void DjiRadarFrameProcessor_GetDefaultGateConfig(T_DjiRadarGateConfig *gateConfig)
+{
+    memset(gateConfig, 0, sizeof(T_DjiRadarGateConfig));
+    gateConfig->minSnr = 1;
+}
+
+DJIRadarFrameProcessor::DJIRadarFrameProcessor(E_DjiPerceptionRadarPosition position, uint32_t maxPointNum,
+                                               uint32_t queueDepth)
+    : position(position),
+      maxPointNum(maxPointNum),
+      queueDepth(queueDepth),
+      frames(nullptr),
+      pointBuffer(nullptr),
+      notifySema(nullptr),
+      ownNotifySema(false),
+      sweep(nullptr),
+      expectedPack(0),
+      sequence(0),
+      dropping(false),
+      head(0),
+      tail(0),
+      packetCount(0),
+      malformedPacketCount(0),
+      sweepCount(0),
+      incompleteSweepCount(0),
+      droppedSweepCount(0),
+      rawPointCount(0),
+      gatedPointCount(0),
+      truncatedPointCount(0),
+      processTimeUs(0)
+{
+    DjiRadarFrameProcessor_GetDefaultGateConfig(&gate);
+}
+
+DJIRadarFrameProcessor::~DJIRadarFrameProcessor()
+{
+    cleanup();
+}
+
+T_DjiReturnCode DJIRadarFrameProcessor::init(T_DjiSemaHandle notifySema)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    uint32_t floatArrayLen = DjiRadarFrameProcessor_AlignedArrayLen(maxPointNum + 1, sizeof(float));
+    uint32_t byteArrayLen = DjiRadarFrameProcessor_AlignedArrayLen(maxPointNum + 1, sizeof(uint8_t));
+    uint32_t frameBufferLen = 6 * floatArrayLen + byteArrayLen;
+    T_DjiReturnCode returnCode;
+    uint8_t *frameBuffer;
+
+    if (frames != nullptr) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+    }
+    if (maxPointNum == 0 || queueDepth == 0 || (queueDepth & (queueDepth - 1)) != 0) {
+        USER_LOG_ERROR("Radar queue depth %u is not a power of two.", queueDepth);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    frames = new(std::nothrow) T_DjiRadarPointCloud[queueDepth];
+    if (frames == nullptr ||
+        posix_memalign((void **) &pointBuffer, DJI_RADAR_FRAME_ARRAY_ALIGNMENT,
+                       (size_t) frameBufferLen * queueDepth) != 0) {
+        USER_LOG_ERROR("Malloc radar sweep buffers failed.");
+        pointBuffer = nullptr;
+        cleanup();
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+
+    for (uint32_t i = 0; i < queueDepth; i++) {
+        frameBuffer = pointBuffer + (size_t) frameBufferLen * i;
+        memset(&frames[i], 0, sizeof(T_DjiRadarPointCloud));
+        frames[i].position = position;
+        frames[i].capacity = maxPointNum;
+        frames[i].x = (float *) (frameBuffer);
+        frames[i].y = (float *) (frameBuffer + floatArrayLen);
+        frames[i].z = (float *) (frameBuffer + 2 * floatArrayLen);
+        frames[i].velocity = (float *) (frameBuffer + 3 * floatArrayLen);
+        frames[i].energy = (float *) (frameBuffer + 4 * floatArrayLen);
+        frames[i].beamAngle = (float *) (frameBuffer + 5 * floatArrayLen);
+        frames[i].snr = frameBuffer + 6 * floatArrayLen;
+    }
+
+    if (notifySema != nullptr) {
+        this->notifySema = notifySema;
+        ownNotifySema = false;
+    } else {
+        returnCode = osalHandler->SemaphoreCreate(0, &this->notifySema);
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            USER_LOG_ERROR("Create radar sweep semaphore failed, error: 0x%08llX.", returnCode);
+            cleanup();
+            return returnCode;
+        }
+        ownNotifySema = true;
+    }
+
+    DjiRadarFrameProcessor_GetAngleTable();
+    sweep = nullptr;
+    dropping = false;
+    expectedPack = 0;
+    head.store(0);
+    tail.store(0);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+void DJIRadarFrameProcessor::cleanup()
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    if (ownNotifySema && notifySema != nullptr) {
+        osalHandler->SemaphoreDestroy(notifySema);
+    }
+    notifySema = nullptr;
+    ownNotifySema = false;
+
+    free(pointBuffer);
+    pointBuffer = nullptr;
+    delete[] frames;
+    frames = nullptr;
+    sweep = nullptr;
+}
+
+void DJIRadarFrameProcessor::setGateConfig(const T_DjiRadarGateConfig &gateConfig)
+{
+    gate = gateConfig;
+}
+
+E_DjiPerceptionRadarPosition DJIRadarFrameProcessor::getPosition() const
+{
+    return position;
+}
+
+/**
+ * @brief Convert a radar packet and append it to the sweep being assembled. The sweep is published when its last
+ * packet arrives, or with packets missing when a packet of the next sweep arrives first.
+ */
+T_DjiReturnCode DJIRadarFrameProcessor::processPacket(const uint8_t *radarDataBuffer, uint32_t bufferLen)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    const T_DjiRadarDataFrame *radarData = (const T_DjiRadarDataFrame *) radarDataBuffer;
+    uint32_t unitNum;
+    uint8_t curPack;
+    uint8_t packNum;
+    uint64_t startTimeUs = 0;
+    uint64_t endTimeUs = 0;
+    uint32_t kept;
+
+    if (frames == nullptr) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
+    }
+    if (radarDataBuffer == nullptr || bufferLen < sizeof(T_DjiRadarDataHeader)) {
+        malformedPacketCount.fetch_add(1, std::memory_order_relaxed);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    osalHandler->GetTimeUs(&startTimeUs);
+    packetCount.fetch_add(1, std::memory_order_relaxed);
+
+    unitNum = radarData->headInfo.dataLen;
+    if (unitNum > (bufferLen - sizeof(T_DjiRadarDataHeader)) / sizeof(T_DjiRadarCloudUnit)) {
+        unitNum = (bufferLen - sizeof(T_DjiRadarDataHeader)) / sizeof(T_DjiRadarCloudUnit);
+        malformedPacketCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    packNum = radarData->headInfo.packNum > 0 ? radarData->headInfo.packNum : 1;
+    curPack = radarData->headInfo.curPack > 0 ? radarData->headInfo.curPack : 1;
+
+    if ((sweep != nullptr || dropping) && (curPack < expectedPack || (sweep != nullptr && packNum != sweep->packNum))) {
+        publishSweep();
+    }
+    if (sweep == nullptr && !dropping) {
+        startSweep(packNum, startTimeUs);
+    }
+
+    if (sweep != nullptr) {
+        kept = convertUnits(radarData->data, unitNum, sweep, sweep->pointCount);
+        sweep->rawPointCount += unitNum;
+        sweep->pointCount += kept;
+        sweep->receivedPackNum++;
+        sweep->lastPacketTimeUs = startTimeUs;
+        rawPointCount.fetch_add(unitNum, std::memory_order_relaxed);
+    }
+
+    expectedPack = curPack + 1;
+    if (curPack >= packNum) {
+        publishSweep();
+    }
+
+    osalHandler->GetTimeUs(&endTimeUs);
+    processTimeUs.fetch_add(endTimeUs - startTimeUs, std::memory_order_relaxed);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiRadarPointCloud *DJIRadarFrameProcessor::acquireFrame()
+{
+    uint32_t curTail;
+
+    if (frames == nullptr) {
+        return nullptr;
+    }
+
+    curTail = tail.load(std::memory_order_relaxed);
+    if (curTail == head.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+
+    return &frames[curTail & (queueDepth - 1)];
+}
+
+/**
+ * @note Sweeps are released in the order they were acquired, releasing hands the slot back to the radar callback.
+ */
+void DJIRadarFrameProcessor::releaseFrame(T_DjiRadarPointCloud *frame)
+{
+    uint32_t curTail = tail.load(std::memory_order_relaxed);
+
+    if (frame == nullptr || frame != &frames[curTail & (queueDepth - 1)] ||
+        curTail == head.load(std::memory_order_acquire)) {
+        USER_LOG_WARN("Release of radar sweep %p out of order.", frame);
+        return;
+    }
+
+    tail.store(curTail + 1, std::memory_order_release);
+}
+
+T_DjiRadarPointCloud *DJIRadarFrameProcessor::waitFrame(uint32_t timeoutMs)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiRadarPointCloud *frame = acquireFrame();
+
+    if (frame == nullptr && ownNotifySema) {
+        osalHandler->SemaphoreTimedWait(notifySema, timeoutMs);
+        frame = acquireFrame();
+    }
+
+    return frame;
+}
+
+void DJIRadarFrameProcessor::getStatistics(T_DjiRadarFrameProcessorStatistics *statistics) const
+{
+    statistics->packetCount = packetCount.load(std::memory_order_relaxed);
+    statistics->malformedPacketCount = malformedPacketCount.load(std::memory_order_relaxed);
+    statistics->sweepCount = sweepCount.load(std::memory_order_relaxed);
+    statistics->incompleteSweepCount = incompleteSweepCount.load(std::memory_order_relaxed);
+    statistics->droppedSweepCount = droppedSweepCount.load(std::memory_order_relaxed);
+    statistics->rawPointCount = rawPointCount.load(std::memory_order_relaxed);
+    statistics->gatedPointCount = gatedPointCount.load(std::memory_order_relaxed);
+    statistics->truncatedPointCount = truncatedPointCount.load(std::memory_order_relaxed);
+    statistics->processTimeUs = processTimeUs.load(std::memory_order_relaxed);
+}
+
+/* Private functions definition-----------------------------------------------*/
+/**
+ * @brief Take the free slot at the head of the ring for a new sweep, or drop the sweep when the ring is full.
+ */
+bool DJIRadarFrameProcessor::startSweep(uint8_t packNum, uint64_t timeUs)
+{
+    uint32_t curHead = head.load(std::memory_order_relaxed);
+
+    if (curHead - tail.load(std::memory_order_acquire) >= queueDepth) {
+        droppedSweepCount.fetch_add(1, std::memory_order_relaxed);
+        sequence++;
+        dropping = true;
+        return false;
+    }
+
+    sweep = &frames[curHead & (queueDepth - 1)];
+    sweep->sequence = sequence++;
+    sweep->firstPacketTimeUs = timeUs;
+    sweep->lastPacketTimeUs = timeUs;
+    sweep->packNum = packNum;
+    sweep->receivedPackNum = 0;
+    sweep->rawPointCount = 0;
+    sweep->pointCount = 0;
+
+    return true;
+}
+
+void DJIRadarFrameProcessor::publishSweep()
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    dropping = false;
+    if (sweep == nullptr) {
+        return;
+    }
+
+    if (sweep->receivedPackNum < sweep->packNum) {
+        incompleteSweepCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    sweep = nullptr;
+    sweepCount.fetch_add(1, std::memory_order_relaxed);
+    head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    osalHandler->SemaphorePost(notifySema);
+}
+
+/**
+ * @brief Convert the units of a packet in one pass, written at offset of the sweep arrays. Every unit is stored
+ * at the current end and the end only advances for units that pass the gate, so the loop has no data dependent
+ * branches. The arrays hold one spare entry for the last rejected unit.
+ * @return Number of units kept.
+ */
+uint32_t DJIRadarFrameProcessor::convertUnits(const T_DjiRadarCloudUnit *units, uint32_t unitNum,
+                                              T_DjiRadarPointCloud *frame, uint32_t offset)
+{
+    const T_DjiRadarAngleTable *table = DjiRadarFrameProcessor_GetAngleTable();
+    const float maxAbsVelocity = gate.maxAbsVelocity > 0 ? gate.maxAbsVelocity : FLT_MAX;
+    const float maxRadius = gate.maxRadius > 0 ? gate.maxRadius : FLT_MAX;
+    const uint32_t minSnr = gate.minSnr;
+    const uint32_t dropClutter = gate.dropClutter ? 1 : 0;
+    float *x = frame->x;
+    float *y = frame->y;
+    float *z = frame->z;
+    float *velocity = frame->velocity;
+    float *energy = frame->energy;
+    float *beamAngle = frame->beamAngle;
+    uint8_t *snr = frame->snr;
+    uint32_t end = offset;
+    uint32_t passed = 0;
+    uint32_t truncated = 0;
+
+    for (uint32_t i = 0; i < unitNum; i++) {
+        const T_DjiRadarCloudUnit *unit = &units[i];
+        const uint32_t unitSnr = unit->base_info.snr;
+        const uint32_t unitBeamAngle = unit->base_info.beamAngle;
+        const float radius = unit->radius * DJI_RADAR_RADIUS_UNIT_M;
+        const float unitVelocity = ((int32_t) unit->base_info.velocity - DJI_RADAR_VELOCITY_OFFSET) *
+                                   DJI_RADAR_VELOCITY_UNIT_MPS;
+        const float absVelocity = fabsf(unitVelocity);
+        float sinAzimuth;
+        float cosAzimuth;
+        float sinElevation;
+        float cosElevation;
+        uint32_t keep;
+        uint32_t fits;
+
+        DjiRadarFrameProcessor_SinCos(table, unit->azimuth, &sinAzimuth, &cosAzimuth);
+        DjiRadarFrameProcessor_SinCos(table, unit->elevation, &sinElevation, &cosElevation);
+
+        x[end] = radius * cosElevation * cosAzimuth;
+        y[end] = radius * cosElevation * sinAzimuth;
+        z[end] = radius * sinElevation;
+        velocity[end] = unitVelocity;
+        energy[end] = unit->ene * DJI_RADAR_ENERGY_UNIT;
+        beamAngle[end] = unitBeamAngle * DJI_RADAR_BEAM_ANGLE_UNIT_DEG -
+                         (unitBeamAngle > DJI_RADAR_BEAM_ANGLE_POSITIVE_MAX ? DJI_RADAR_BEAM_ANGLE_WRAP_DEG : 0.0f);
+        snr[end] = (uint8_t) unitSnr;
+
+        keep = (unitSnr >= minSnr) & ((unit->base_info.clitterFlag & dropClutter) == 0) &
+               (absVelocity >= gate.minAbsVelocity) & (absVelocity <= maxAbsVelocity) &
+               (radius >= gate.minRadius) & (radius <= maxRadius);
+        fits = end < frame->capacity;
+        passed += keep;
+        truncated += keep & (fits ^ 1);
+        end += keep & fits;
+    }
+
+    gatedPointCount.fetch_add(unitNum - passed, std::memory_order_relaxed);
+    if (truncated > 0) {
+        truncatedPointCount.fetch_add(truncated, std::memory_order_relaxed);
+    }
+
+    return end - offset;
+}
+
+/**
+ * @brief Sine and cosine of the raw angles, built once. Angles are raw / 1000 - 2 PI rad, the offset of a full
+ * turn does not change them.
+ */
+static const T_DjiRadarAngleTable *DjiRadarFrameProcessor_GetAngleTable(void)
+{
+    static T_DjiRadarAngleTable *s_angleTable = []() {
+        T_DjiRadarAngleTable *table = new T_DjiRadarAngleTable;
+
+        for (uint32_t i = 0; i < DJI_RADAR_ANGLE_TABLE_SIZE; i++) {
+            table->sine[i] = (float) sin(i * (double) DJI_RADAR_ANGLE_UNIT_RAD);
+            table->cosine[i] = (float) cos(i * (double) DJI_RADAR_ANGLE_UNIT_RAD);
+        }
+
+        return table;
+    }();
+
+    return s_angleTable;
+}
+
+static inline void DjiRadarFrameProcessor_SinCos(const T_DjiRadarAngleTable *table, uint16_t rawAngle,
+                                                 float *sine, float *cosine)
+{
+    if (rawAngle < DJI_RADAR_ANGLE_TABLE_SIZE) {
+        *sine = table->sine[rawAngle];
+        *cosine = table->cosine[rawAngle];
+    } else {
+        *sine = sinf(rawAngle * DJI_RADAR_ANGLE_UNIT_RAD);
+        *cosine = cosf(rawAngle * DJI_RADAR_ANGLE_UNIT_RAD);
+    }
+}
+
+static uint32_t DjiRadarFrameProcessor_AlignedArrayLen(uint32_t len, uint32_t elementSize)
+{
+    uint32_t size = len * elementSize;
+
+    return (size + DJI_RADAR_FRAME_ARRAY_ALIGNMENT - 1) / DJI_RADAR_FRAME_ARRAY_ALIGNMENT *
+           DJI_RADAR_FRAME_ARRAY_ALIGNMENT;
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,174 @@
+/**
+ ********************************************************************
+ * @file    dji_radar_frame_processor.hpp
+ * @brief   This is the header file for "dji_radar_frame_processor.cpp", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef DJI_RADAR_FRAME_PROCESSOR_H
+#define DJI_RADAR_FRAME_PROCESSOR_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <atomic>
+#include "dji_perception.h"
+#include "dji_platform.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Points of one radar sweep kept at most, further points of the sweep are counted and dropped. */
+#define DJI_RADAR_FRAME_DEFAULT_MAX_POINT_NUM      4096
+/* Sweeps queued between the radar callback and the consumer, a power of two. */
+#define DJI_RADAR_FRAME_DEFAULT_QUEUE_DEPTH        8
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+    /*! Points with a lower SNR, in dB, are dropped. The default of 1 drops the null points without echo. */
+    uint8_t minSnr;
+    /*! Drop points flagged as clutter by planar radars. */
+    bool dropClutter;
+    /*! Points with a lower absolute radial velocity, in m/s, are dropped. 0 keeps static points. */
+    float minAbsVelocity;
+    /*! Points with a higher absolute radial velocity, in m/s, are dropped. 0 disables the limit. */
+    float maxAbsVelocity;
+    /*! Range limits of the points, in m. A max of 0 disables the upper limit. */
+    float minRadius;
+    float maxRadius;
+} T_DjiRadarGateConfig;
+
+/**
+ * @brief One radar sweep, the packets of a circle merged and converted to Cartesian coordinates of the radar
+ * coordinate system: x = r * cos(elevation) * cos(azimuth), y = r * cos(elevation) * sin(azimuth),
+ * z = r * sin(elevation). Each field is a separate array of pointCount entries.
+ */
+typedef struct {
+    E_DjiPerceptionRadarPosition position;
+    /*! Sweep counter of the radar position, gaps show sweeps dropped because the queue was full. */
+    uint32_t sequence;
+    /*! Local time the first and last packet of the sweep were received. */
+    uint64_t firstPacketTimeUs;
+    uint64_t lastPacketTimeUs;
+    /*! Packets of the sweep announced by the radar and received, they differ if packets were lost. */
+    uint8_t packNum;
+    uint8_t receivedPackNum;
+    /*! Points received in the sweep, before gating and truncation. */
+    uint32_t rawPointCount;
+    uint32_t pointCount;
+    uint32_t capacity;
+    float *x;
+    float *y;
+    float *z;
+    /*! Radial velocity in m/s, positive when the target moves closer. */
+    float *velocity;
+    float *energy;
+    /*! Beam emission angle in degrees. */
+    float *beamAngle;
+    uint8_t *snr;
+} T_DjiRadarPointCloud;
+
+typedef struct {
+    uint64_t packetCount;
+    uint64_t malformedPacketCount;
+    uint64_t sweepCount;
+    /*! Sweeps published with packets missing. */
+    uint64_t incompleteSweepCount;
+    /*! Sweeps dropped because the consumer did not release the queued ones in time. */
+    uint64_t droppedSweepCount;
+    uint64_t rawPointCount;
+    uint64_t gatedPointCount;
+    uint64_t truncatedPointCount;
+    /*! Time spent converting packets in the radar callback. */
+    uint64_t processTimeUs;
+} T_DjiRadarFrameProcessorStatistics;
+
+/**
+ * @brief Converts the radar packets of one position into point cloud sweeps and hands them to one consumer.
+ * processPacket is called from the radar callback only, acquireFrame, releaseFrame and waitFrame from a single
+ * consumer thread. The sweeps live in a preallocated ring, so no memory is allocated and no lock is taken while
+ * streaming.
+ */
+class DJIRadarFrameProcessor {
+public:
+    explicit DJIRadarFrameProcessor(E_DjiPerceptionRadarPosition position,
+                                    uint32_t maxPointNum = DJI_RADAR_FRAME_DEFAULT_MAX_POINT_NUM,
+                                    uint32_t queueDepth = DJI_RADAR_FRAME_DEFAULT_QUEUE_DEPTH);
+    ~DJIRadarFrameProcessor();
+    /**
+     * @param notifySema: semaphore posted for every published sweep, so one consumer can wait on several
+     * processors. nullptr to use a semaphore of the processor for waitFrame.
+     */
+    T_DjiReturnCode init(T_DjiSemaHandle notifySema = nullptr);
+    void cleanup();
+    /* Only while no packets are processed. */
+    void setGateConfig(const T_DjiRadarGateConfig &gateConfig);
+    E_DjiPerceptionRadarPosition getPosition() const;
+
+    T_DjiReturnCode processPacket(const uint8_t *radarDataBuffer, uint32_t bufferLen);
+
+    /* Oldest published sweep, or nullptr if none. It stays valid until released. */
+    T_DjiRadarPointCloud *acquireFrame();
+    void releaseFrame(T_DjiRadarPointCloud *frame);
+    /* Wait for a published sweep on the semaphore of the processor, see init. */
+    T_DjiRadarPointCloud *waitFrame(uint32_t timeoutMs);
+    void getStatistics(T_DjiRadarFrameProcessorStatistics *statistics) const;
+
+private:
+    DJIRadarFrameProcessor(const DJIRadarFrameProcessor &);
+    DJIRadarFrameProcessor &operator=(const DJIRadarFrameProcessor &);
+
+    bool startSweep(uint8_t packNum, uint64_t timeUs);
+    void publishSweep();
+    uint32_t convertUnits(const T_DjiRadarCloudUnit *units, uint32_t unitNum, T_DjiRadarPointCloud *frame,
+                          uint32_t offset);
+
+    E_DjiPerceptionRadarPosition position;
+    uint32_t maxPointNum;
+    uint32_t queueDepth;
+    T_DjiRadarGateConfig gate;
+    T_DjiRadarPointCloud *frames;
+    uint8_t *pointBuffer;
+    T_DjiSemaHandle notifySema;
+    bool ownNotifySema;
+
+    /* Producer state: the sweep being assembled is frames[head % queueDepth], not yet visible to the consumer. */
+    T_DjiRadarPointCloud *sweep;
+    uint8_t expectedPack;
+    uint32_t sequence;
+    bool dropping;
+
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+
+    std::atomic<uint64_t> packetCount;
+    std::atomic<uint64_t> malformedPacketCount;
+    std::atomic<uint64_t> sweepCount;
+    std::atomic<uint64_t> incompleteSweepCount;
+    std::atomic<uint64_t> droppedSweepCount;
+    std::atomic<uint64_t> rawPointCount;
+    std::atomic<uint64_t> gatedPointCount;
+    std::atomic<uint64_t> truncatedPointCount;
+    std::atomic<uint64_t> processTimeUs;
+};
+
+/* Exported functions --------------------------------------------------------*/
+void DjiRadarFrameProcessor_GetDefaultGateConfig(T_DjiRadarGateConfig *gateConfig);
+
+#endif // DJI_RADAR_FRAME_PROCESSOR_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
@@ -0,0 +1,837 @@
+/**
+ ********************************************************************
+ * @file    dji_radar_fusion.cpp
+ * @brief   Fuses the sweeps of the millimeter wave radars into a rolling 2.5D occupancy grid
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_radar_fusion.hpp"
+#include <cmath>
+#include <cfloat>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include "dji_logger.h"
+#include "utils/cJSON.h"
+#include "utils/util_file.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+/* Private constants ---------------------------------------------------------*/
+#define DJI_RADAR_FUSION_TASK_STACK_SIZE           4096
+#define DJI_RADAR_FUSION_SWEEP_WAIT_TIMEOUT_MS     100
+/* Sweeps further than this from the nearest pose are counted as fused without a pose. */
+#define DJI_RADAR_FUSION_POSE_MAX_GAP_US           100000
+#define DJI_RADAR_FUSION_TAG_MASK                  0xFFFF
+#define DJI_RADAR_FUSION_DEG_TO_RAD                (3.14159265358979323846 / 180.0)
+
+/* Private types -------------------------------------------------------------*/
+struct DJIRadarFusion::T_Cell {
+    /*! Upper bits of the world cell held, cells are addressed by the lower bits. */
+    uint32_t tag;
+    /*! Time of the last hit in ms since init plus one, 0 for a cell never hit. */
+    uint32_t stampMs;
+    float occupancy;
+    float height;
+};
+
+typedef struct {
+    E_DjiPerceptionRadarPosition position;
+    const char *name;
+    float rollDeg;
+    float pitchDeg;
+    float yawDeg;
+} T_DjiRadarFusionMounting;
+
+/* Private values -------------------------------------------------------------*/
+/* Nominal mounting directions, the radar x axis along the boresight. Calibrated values come from the config file. */
+static const T_DjiRadarFusionMounting s_defaultMountings[] = {
+    {RADAR_POSITION_LEFT,  "left",  0, 0,   -90},
+    {RADAR_POSITION_RIGHT, "right", 0, 0,   90},
+    {RADAR_POSITION_DOWN,  "down",  0, -90, 0},
+    {RADAR_POSITION_UP,    "up",    0, 90,  0},
+    {RADAR_POSITION_FRONT, "front", 0, 0,   0},
+    {RADAR_POSITION_BACK,  "back",  0, 0,   180},
+};
+static DJIRadarFusion *s_radarFusion = nullptr;
+
+/* Private functions declaration ---------------------------------------------*/
+static void DjiRadarFusion_RpyToRotation(float rollDeg, float pitchDeg, float yawDeg, float rotation[3][3]);
+static void DjiRadarFusion_QuaternionToRotation(const float *quaternion, float rotation[3][3]);
+static uint32_t DjiRadarFusion_GetTimeMs(uint64_t startTimeUs, uint64_t timeUs);
+
+/* Exported functions definition ---------------------------------------------*/
+void DjiRadarFusion_GetDefaultConfig(T_DjiRadarFusionConfig *config)
+{
+    config->cellSize = 0.5f;
+    config->gridWidth = 128;
+    config->minRelativeHeight = -30.0f;
+    config->maxRelativeHeight = 30.0f;
+    config->decayHalfLifeMs = 2000;
+    config->hitWeight = 1.0f;
+    config->maxOccupancy = 10.0f;
+    config->maxSweepAgeMs = 500;
+}
+
+DJIRadarFusion::DJIRadarFusion()
+    : gridShift(0),
+      cells(nullptr),
+      mutex(nullptr),
+      startTimeUs(0),
+      scratchCapacity(0),
+      cellNorth(nullptr),
+      cellEast(nullptr),
+      pointHeight(nullptr),
+      poseCount(0),
+      poseHead(0),
+      positionMask(0),
+      sweepSema(nullptr),
+      task(nullptr),
+      taskExitSema(nullptr),
+      taskStop(false)
+{
+    DjiRadarFusion_GetDefaultConfig(&config);
+    memset(processors, 0, sizeof(processors));
+    memset(&statistics, 0, sizeof(statistics));
+    for (uint32_t i = 0; i < sizeof(s_defaultMountings) / sizeof(s_defaultMountings[0]); i++) {
+        memset(&extrinsics[s_defaultMountings[i].position], 0, sizeof(T_DjiRadarExtrinsics));
+        DjiRadarFusion_RpyToRotation(s_defaultMountings[i].rollDeg, s_defaultMountings[i].pitchDeg,
+                                     s_defaultMountings[i].yawDeg, extrinsics[s_defaultMountings[i].position].rotation);
+    }
+}
+
+DJIRadarFusion::~DJIRadarFusion()
+{
+    cleanup();
+}
+
+T_DjiReturnCode DJIRadarFusion::init(const T_DjiRadarFusionConfig &config)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiReturnCode returnCode;
+    uint32_t cellNum;
+
+    if (cells != nullptr) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+    }
+    if (config.cellSize <= 0 || config.gridWidth < 2 || config.gridWidth > 4096 ||
+        (config.gridWidth & (config.gridWidth - 1)) != 0 || config.decayHalfLifeMs == 0) {
+        USER_LOG_ERROR("Invalid radar fusion config, grid width %u, cell size %.2f.", config.gridWidth,
+                       config.cellSize);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    this->config = config;
+    for (gridShift = 0; (1u << gridShift) < config.gridWidth; gridShift++) {
+    }
+
+    cellNum = config.gridWidth * config.gridWidth;
+    scratchCapacity = DJI_RADAR_FRAME_DEFAULT_MAX_POINT_NUM;
+    cells = new(std::nothrow) T_Cell[cellNum];
+    cellNorth = new(std::nothrow) int32_t[scratchCapacity];
+    cellEast = new(std::nothrow) int32_t[scratchCapacity];
+    pointHeight = new(std::nothrow) float[scratchCapacity];
+    if (cells == nullptr || cellNorth == nullptr || cellEast == nullptr || pointHeight == nullptr) {
+        USER_LOG_ERROR("Malloc radar occupancy grid failed.");
+        cleanup();
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+    memset(cells, 0, sizeof(T_Cell) * cellNum);
+
+    returnCode = osalHandler->MutexCreate(&mutex);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Create radar fusion mutex failed, error: 0x%08llX.", returnCode);
+        cleanup();
+        return returnCode;
+    }
+
+    osalHandler->GetTimeUs(&startTimeUs);
+    poseCount = 0;
+    poseHead = 0;
+    memset(&statistics, 0, sizeof(statistics));
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+void DJIRadarFusion::cleanup()
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    stop();
+    if (mutex != nullptr) {
+        osalHandler->MutexDestroy(mutex);
+        mutex = nullptr;
+    }
+    delete[] cells;
+    cells = nullptr;
+    delete[] cellNorth;
+    cellNorth = nullptr;
+    delete[] cellEast;
+    cellEast = nullptr;
+    delete[] pointHeight;
+    pointHeight = nullptr;
+}
+
+/**
+ * @brief Each mounting is an object with "translation_m" [x, y, z] in the body frame and "rotation_rpy_deg"
+ * [roll, pitch, yaw] of the radar frame. Mountings missing in the file are kept.
+ */
+T_DjiReturnCode DJIRadarFusion::loadExtrinsics(const char *path)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiReturnCode returnCode;
+    T_DjiRadarExtrinsics radarExtrinsics;
+    uint32_t fileSize = 0;
+    uint32_t readRealSize = 0;
+    uint8_t *jsonData;
+    cJSON *jsonRoot;
+    cJSON *jsonItem;
+    cJSON *jsonTranslation;
+    cJSON *jsonRotation;
+    float rpy[3];
+
+    returnCode = UtilFile_GetFileSizeByPath(path, &fileSize);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Get radar extrinsics file size failed, stat = 0x%08llX", returnCode);
+        return returnCode;
+    }
+
+    jsonData = static_cast<uint8_t *>(osalHandler->Malloc(fileSize + 1));
+    if (jsonData == nullptr) {
+        USER_LOG_ERROR("Malloc failed.");
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+
+    UtilFile_GetFileDataByPath(path, 0, fileSize, jsonData, &readRealSize);
+    jsonData[readRealSize] = '\0';
+
+    jsonRoot = cJSON_Parse((char *) jsonData);
+    osalHandler->Free(jsonData);
+    if (jsonRoot == nullptr) {
+        USER_LOG_ERROR("Parse radar extrinsics %s failed.", path);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+    }
+
+    for (uint32_t i = 0; i < sizeof(s_defaultMountings) / sizeof(s_defaultMountings[0]); i++) {
+        jsonItem = cJSON_GetObjectItem(jsonRoot, s_defaultMountings[i].name);
+        if (jsonItem == nullptr) {
+            continue;
+        }
+
+        jsonTranslation = cJSON_GetObjectItem(jsonItem, "translation_m");
+        jsonRotation = cJSON_GetObjectItem(jsonItem, "rotation_rpy_deg");
+        if (cJSON_GetArraySize(jsonTranslation) != 3 || cJSON_GetArraySize(jsonRotation) != 3) {
+            USER_LOG_WARN("Radar extrinsics of %s need 3 values each, ignored.", s_defaultMountings[i].name);
+            continue;
+        }
+
+        for (int j = 0; j < 3; j++) {
+            radarExtrinsics.translation[j] = (float) cJSON_GetArrayItem(jsonTranslation, j)->valuedouble;
+            rpy[j] = (float) cJSON_GetArrayItem(jsonRotation, j)->valuedouble;
+        }
+        DjiRadarFusion_RpyToRotation(rpy[0], rpy[1], rpy[2], radarExtrinsics.rotation);
+        setExtrinsics(s_defaultMountings[i].position, radarExtrinsics);
+    }
+
+    cJSON_Delete(jsonRoot);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+void DJIRadarFusion::setExtrinsics(E_DjiPerceptionRadarPosition position, const T_DjiRadarExtrinsics &extrinsics)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    if (position >= MAX_RADAR_NUM) {
+        return;
+    }
+
+    if (mutex != nullptr) {
+        osalHandler->MutexLock(mutex);
+    }
+    this->extrinsics[position] = extrinsics;
+    if (mutex != nullptr) {
+        osalHandler->MutexUnlock(mutex);
+    }
+}
+
+T_DjiReturnCode DJIRadarFusion::start(uint32_t positionMask)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiReturnCode returnCode;
+
+    if (cells == nullptr) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
+    }
+    if (s_radarFusion != nullptr) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+    }
+
+    returnCode = osalHandler->SemaphoreCreate(0, &sweepSema);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return returnCode;
+    }
+    returnCode = osalHandler->SemaphoreCreate(0, &taskExitSema);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        osalHandler->SemaphoreDestroy(sweepSema);
+        sweepSema = nullptr;
+        return returnCode;
+    }
+
+    for (int i = 0; i < MAX_RADAR_NUM; i++) {
+        if ((positionMask & (1u << i)) == 0) {
+            continue;
+        }
+
+        processors[i] = new(std::nothrow) DJIRadarFrameProcessor((E_DjiPerceptionRadarPosition) i);
+        if (processors[i] == nullptr || processors[i]->init(sweepSema) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            USER_LOG_ERROR("Init radar frame processor of position %d failed.", i);
+            returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+            goto startFailed;
+        }
+    }
+
+    s_radarFusion = this;
+    taskStop = false;
+    returnCode = osalHandler->TaskCreate("radar_fusion", fusionTask, DJI_RADAR_FUSION_TASK_STACK_SIZE, this, &task);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Create radar fusion task failed, error: 0x%08llX.", returnCode);
+        task = nullptr;
+        goto startFailed;
+    }
+
+    for (int i = 0; i < MAX_RADAR_NUM; i++) {
+        if (processors[i] == nullptr) {
+            continue;
+        }
+
+        if (DjiPerception_SubscribeRadarData((E_DjiPerceptionRadarPosition) i, radarCallback) !=
+            DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            USER_LOG_WARN("Subscribe radar of position %d failed, it is not fused.", i);
+            continue;
+        }
+        this->positionMask |= 1u << i;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+
+startFailed:
+    stop();
+    return returnCode;
+}
+
+void DJIRadarFusion::stop()
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    for (int i = 0; i < MAX_RADAR_NUM; i++) {
+        if ((positionMask & (1u << i)) != 0) {
+            DjiPerception_UnsubscribeRadarData((E_DjiPerceptionRadarPosition) i);
+        }
+    }
+    positionMask = 0;
+
+    if (task != nullptr) {
+        taskStop = true;
+        osalHandler->SemaphorePost(sweepSema);
+        osalHandler->SemaphoreWait(taskExitSema);
+        osalHandler->TaskDestroy(task);
+        task = nullptr;
+    }
+    if (s_radarFusion == this) {
+        s_radarFusion = nullptr;
+    }
+
+    for (int i = 0; i < MAX_RADAR_NUM; i++) {
+        delete processors[i];
+        processors[i] = nullptr;
+    }
+    if (taskExitSema != nullptr) {
+        osalHandler->SemaphoreDestroy(taskExitSema);
+        taskExitSema = nullptr;
+    }
+    if (sweepSema != nullptr) {
+        osalHandler->SemaphoreDestroy(sweepSema);
+        sweepSema = nullptr;
+    }
+}
+
+/**
+ * @note Poses are expected in time order, a pose older than the newest one is ignored.
+ */
+void DJIRadarFusion::updatePose(const T_DjiRadarFusionPose &pose)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    uint32_t newest = (poseHead + DJI_RADAR_FUSION_POSE_HISTORY_NUM - 1) % DJI_RADAR_FUSION_POSE_HISTORY_NUM;
+
+    if (mutex == nullptr) {
+        return;
+    }
+
+    osalHandler->MutexLock(mutex);
+    if (poseCount == 0 || pose.timeUs > poses[newest].timeUs) {
+        poses[poseHead] = pose;
+        poseHead = (poseHead + 1) % DJI_RADAR_FUSION_POSE_HISTORY_NUM;
+        if (poseCount < DJI_RADAR_FUSION_POSE_HISTORY_NUM) {
+            poseCount++;
+        }
+    }
+    osalHandler->MutexUnlock(mutex);
+}
+
+/**
+ * @brief Transform the points of a sweep into the local frame at the pose of the sweep time and accumulate them
+ * into the grid. Called from one thread at a time.
+ */
+T_DjiReturnCode DJIRadarFusion::fuseSweep(const T_DjiRadarPointCloud *sweep)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    const uint32_t mask = config.gridWidth - 1;
+    T_DjiRadarFusionPose pose;
+    uint64_t sweepTimeUs;
+    uint64_t startUs = 0;
+    uint64_t endUs = 0;
+    uint32_t nowMs;
+    uint32_t binned;
+    uint32_t rejected = 0;
+    int32_t originCellNorth;
+    int32_t originCellEast;
+    bool hasPose;
+
+    if (cells == nullptr || sweep == nullptr || sweep->position >= MAX_RADAR_NUM) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    osalHandler->GetTimeUs(&startUs);
+    sweepTimeUs = sweep->firstPacketTimeUs + (sweep->lastPacketTimeUs - sweep->firstPacketTimeUs) / 2;
+    if (startUs > sweepTimeUs + (uint64_t) config.maxSweepAgeMs * 1000) {
+        osalHandler->MutexLock(mutex);
+        statistics.staleSweepCount++;
+        osalHandler->MutexUnlock(mutex);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_TIMEOUT;
+    }
+
+    osalHandler->MutexLock(mutex);
+    hasPose = interpolatePose(sweepTimeUs, &pose);
+    osalHandler->MutexUnlock(mutex);
+    getOriginCell(pose.position, &originCellNorth, &originCellEast);
+    nowMs = DjiRadarFusion_GetTimeMs(startTimeUs, sweepTimeUs);
+
+    for (uint32_t offset = 0; offset < sweep->pointCount; offset += scratchCapacity) {
+        binned = binPoints(sweep, pose, originCellNorth, originCellEast, offset);
+
+        osalHandler->MutexLock(mutex);
+        for (uint32_t i = 0; i < binned; i++) {
+            if (cellNorth[i] < 0) {
+                rejected++;
+                continue;
+            }
+
+            int32_t worldNorth = originCellNorth + cellNorth[i];
+            int32_t worldEast = originCellEast + cellEast[i];
+            uint32_t tag = (((uint32_t) (worldNorth >> gridShift) & DJI_RADAR_FUSION_TAG_MASK) << 16) |
+                           ((uint32_t) (worldEast >> gridShift) & DJI_RADAR_FUSION_TAG_MASK);
+            T_Cell *cell = &cells[(((uint32_t) worldNorth & mask) << gridShift) | ((uint32_t) worldEast & mask)];
+            float occupancy = 0;
+
+            if (cell->stampMs != 0 && cell->tag == tag) {
+                occupancy = cell->occupancy;
+                if (nowMs > cell->stampMs) {
+                    occupancy *= exp2f(-(float) (nowMs - cell->stampMs) / (float) config.decayHalfLifeMs);
+                }
+            }
+            if (occupancy < config.hitWeight || pointHeight[i] > cell->height) {
+                cell->height = pointHeight[i];
+            }
+            occupancy += config.hitWeight;
+            cell->occupancy = occupancy < config.maxOccupancy ? occupancy : config.maxOccupancy;
+            cell->tag = tag;
+            cell->stampMs = nowMs > cell->stampMs ? nowMs : cell->stampMs;
+        }
+        osalHandler->MutexUnlock(mutex);
+    }
+
+    osalHandler->GetTimeUs(&endUs);
+    osalHandler->MutexLock(mutex);
+    statistics.sweepCount++;
+    statistics.poselessSweepCount += hasPose ? 0 : 1;
+    statistics.pointCount += sweep->pointCount;
+    statistics.rejectedPointCount += rejected;
+    statistics.updateTimeUs += endUs - startUs;
+    if (endUs - startUs > statistics.updateTimeMaxUs) {
+        statistics.updateTimeMaxUs = (uint32_t) (endUs - startUs);
+    }
+    osalHandler->MutexUnlock(mutex);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Fill the grid around the newest pose with the occupancy decayed to the current time.
+ */
+T_DjiReturnCode DJIRadarFusion::getOccupancyGrid(T_DjiRadarOccupancyGrid *grid)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    const uint32_t mask = config.gridWidth - 1;
+    const float occupiedThreshold = config.hitWeight / 2;
+    const float decayPerMs = 1.0f / (float) config.decayHalfLifeMs;
+    T_DjiRadarFusionPose pose;
+    uint64_t startUs = 0;
+    uint64_t endUs = 0;
+    uint32_t nowMs;
+    uint32_t occupiedCellCount = 0;
+
+    if (cells == nullptr || grid == nullptr || grid->occupancy == nullptr) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    osalHandler->GetTimeUs(&startUs);
+    nowMs = DjiRadarFusion_GetTimeMs(startTimeUs, startUs);
+
+    osalHandler->MutexLock(mutex);
+    interpolatePose(startUs, &pose);
+    getOriginCell(pose.position, &grid->originCellNorth, &grid->originCellEast);
+    grid->timeUs = startUs;
+    grid->gridWidth = config.gridWidth;
+    grid->cellSize = config.cellSize;
+
+    for (uint32_t row = 0; row < config.gridWidth; row++) {
+        int32_t worldNorth = grid->originCellNorth + (int32_t) row;
+        const T_Cell *cellRow = &cells[((uint32_t) worldNorth & mask) << gridShift];
+        uint32_t tagNorth = ((uint32_t) (worldNorth >> gridShift) & DJI_RADAR_FUSION_TAG_MASK) << 16;
+        float *occupancyRow = &grid->occupancy[row * config.gridWidth];
+        float *heightRow = grid->height != nullptr ? &grid->height[row * config.gridWidth] : nullptr;
+
+        for (uint32_t col = 0; col < config.gridWidth; col++) {
+            int32_t worldEast = grid->originCellEast + (int32_t) col;
+            const T_Cell *cell = &cellRow[(uint32_t) worldEast & mask];
+            uint32_t tag = tagNorth | ((uint32_t) (worldEast >> gridShift) & DJI_RADAR_FUSION_TAG_MASK);
+            float occupancy = 0;
+
+            if (cell->stampMs != 0 && cell->tag == tag) {
+                occupancy = cell->occupancy;
+                if (nowMs > cell->stampMs) {
+                    occupancy *= exp2f(-(float) (nowMs - cell->stampMs) * decayPerMs);
+                }
+            }
+
+            occupancyRow[col] = occupancy;
+            if (heightRow != nullptr) {
+                heightRow[col] = occupancy > 0 ? cell->height : 0;
+            }
+            occupiedCellCount += occupancy >= occupiedThreshold ? 1 : 0;
+        }
+    }
+    grid->occupiedCellCount = occupiedCellCount;
+
+    osalHandler->GetTimeUs(&endUs);
+    statistics.queryCount++;
+    statistics.queryTimeUs += endUs - startUs;
+    if (endUs - startUs > statistics.queryTimeMaxUs) {
+        statistics.queryTimeMaxUs = (uint32_t) (endUs - startUs);
+    }
+    osalHandler->MutexUnlock(mutex);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+void DJIRadarFusion::getStatistics(T_DjiRadarFusionStatistics *statistics)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    if (mutex == nullptr) {
+        memset(statistics, 0, sizeof(T_DjiRadarFusionStatistics));
+        return;
+    }
+
+    osalHandler->MutexLock(mutex);
+    *statistics = this->statistics;
+    osalHandler->MutexUnlock(mutex);
+}
+
+/* Private functions definition-----------------------------------------------*/
+void DJIRadarFusion::radarCallback(E_DjiPerceptionRadarPosition radarPosition, uint8_t *radarDataBuffer,
+                                   uint32_t bufferLen)
+{
+    DJIRadarFusion *fusion = s_radarFusion;
+
+    if (fusion == nullptr || radarPosition >= MAX_RADAR_NUM || fusion->processors[radarPosition] == nullptr) {
+        return;
+    }
+
+    fusion->processors[radarPosition]->processPacket(radarDataBuffer, bufferLen);
+}
+
+void *DJIRadarFusion::fusionTask(void *arg)
+{
+    DJIRadarFusion *fusion = (DJIRadarFusion *) arg;
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiRadarPointCloud *sweep;
+
+    while (!fusion->taskStop) {
+        osalHandler->SemaphoreTimedWait(fusion->sweepSema, DJI_RADAR_FUSION_SWEEP_WAIT_TIMEOUT_MS);
+
+        for (int i = 0; i < MAX_RADAR_NUM; i++) {
+            if (fusion->processors[i] == nullptr) {
+                continue;
+            }
+
+            while ((sweep = fusion->processors[i]->acquireFrame()) != nullptr) {
+                fusion->fuseSweep(sweep);
+                fusion->processors[i]->releaseFrame(sweep);
+            }
+        }
+    }
+
+    osalHandler->SemaphorePost(fusion->taskExitSema);
+
+    return nullptr;
+}
+
+/**
+ * @brief Pose at a time, interpolated between the two poses around it. Called with the mutex held.
+ * @return false if the pose is further than DJI_RADAR_FUSION_POSE_MAX_GAP_US from any pose in the history.
+ */
+bool DJIRadarFusion::interpolatePose(uint64_t timeUs, T_DjiRadarFusionPose *pose)
+{
+    const T_DjiRadarFusionPose *after = nullptr;
+    const T_DjiRadarFusionPose *before = nullptr;
+    const T_DjiRadarFusionPose *nearest;
+    uint64_t gapUs;
+    float ratio;
+    float sign;
+    float norm;
+
+    for (uint32_t i = 1; i <= poseCount; i++) {
+        const T_DjiRadarFusionPose *candidate =
+            &poses[(poseHead + DJI_RADAR_FUSION_POSE_HISTORY_NUM - i) % DJI_RADAR_FUSION_POSE_HISTORY_NUM];
+        if (candidate->timeUs <= timeUs) {
+            before = candidate;
+            break;
+        }
+        after = candidate;
+    }
+
+    if (before == nullptr && after == nullptr) {
+        memset(pose, 0, sizeof(T_DjiRadarFusionPose));
+        pose->timeUs = timeUs;
+        pose->quaternion[0] = 1.0f;
+        return false;
+    }
+    if (before == nullptr || after == nullptr) {
+        nearest = before != nullptr ? before : after;
+        *pose = *nearest;
+        gapUs = nearest->timeUs > timeUs ? nearest->timeUs - timeUs : timeUs - nearest->timeUs;
+        return gapUs <= DJI_RADAR_FUSION_POSE_MAX_GAP_US;
+    }
+
+    ratio = (float) (timeUs - before->timeUs) / (float) (after->timeUs - before->timeUs);
+    sign = before->quaternion[0] * after->quaternion[0] + before->quaternion[1] * after->quaternion[1] +
+           before->quaternion[2] * after->quaternion[2] + before->quaternion[3] * after->quaternion[3] < 0 ? -1 : 1;
+    norm = 0;
+    for (int i = 0; i < 4; i++) {
+        pose->quaternion[i] = before->quaternion[i] * (1 - ratio) + sign * after->quaternion[i] * ratio;
+        norm += pose->quaternion[i] * pose->quaternion[i];
+    }
+    norm = norm > 0 ? 1.0f / sqrtf(norm) : 0;
+    for (int i = 0; i < 4; i++) {
+        pose->quaternion[i] *= norm;
+    }
+    for (int i = 0; i < 3; i++) {
+        pose->position[i] = before->position[i] + (after->position[i] - before->position[i]) * ratio;
+    }
+    pose->timeUs = timeUs;
+
+    return timeUs - before->timeUs <= DJI_RADAR_FUSION_POSE_MAX_GAP_US ||
+           after->timeUs - timeUs <= DJI_RADAR_FUSION_POSE_MAX_GAP_US;
+}
+
+/**
+ * @brief Transform up to scratchCapacity points from offset into grid coordinates relative to the origin cell,
+ * four points per SIMD step. Points outside the grid or the height band get cell -1.
+ * @return Number of points binned.
+ */
+uint32_t DJIRadarFusion::binPoints(const T_DjiRadarPointCloud *sweep, const T_DjiRadarFusionPose &pose,
+                                   int32_t originCellNorth, int32_t originCellEast, uint32_t offset)
+{
+    const T_DjiRadarExtrinsics &radarExtrinsics = extrinsics[sweep->position];
+    const uint32_t count = sweep->pointCount - offset < scratchCapacity ? sweep->pointCount - offset : scratchCapacity;
+    const float invCellSize = 1.0f / config.cellSize;
+    const float width = (float) config.gridWidth;
+    float attitude[3][3];
+    float rotation[3][3];
+    float translation[3];
+
+    DjiRadarFusion_QuaternionToRotation(pose.quaternion, attitude);
+    for (int i = 0; i < 3; i++) {
+        translation[i] = pose.position[i];
+        for (int j = 0; j < 3; j++) {
+            rotation[i][j] = attitude[i][0] * radarExtrinsics.rotation[0][j] +
+                             attitude[i][1] * radarExtrinsics.rotation[1][j] +
+                             attitude[i][2] * radarExtrinsics.rotation[2][j];
+            translation[i] += attitude[i][j] * radarExtrinsics.translation[j];
+        }
+    }
+
+    /* North and east in cells from the origin cell, down in m relative to the aircraft. */
+    const float n0 = rotation[0][0] * invCellSize, n1 = rotation[0][1] * invCellSize;
+    const float n2 = rotation[0][2] * invCellSize;
+    const float nOffset = (translation[0] - (float) originCellNorth * config.cellSize) * invCellSize;
+    const float e0 = rotation[1][0] * invCellSize, e1 = rotation[1][1] * invCellSize;
+    const float e2 = rotation[1][2] * invCellSize;
+    const float eOffset = (translation[1] - (float) originCellEast * config.cellSize) * invCellSize;
+    const float d0 = rotation[2][0], d1 = rotation[2][1], d2 = rotation[2][2];
+    const float dOffset = translation[2] - pose.position[2];
+    const float groundHeight = -pose.position[2];
+    const float minRelativeHeight = config.minRelativeHeight;
+    const float maxRelativeHeight = config.maxRelativeHeight;
+    const float *x = sweep->x + offset;
+    const float *y = sweep->y + offset;
+    const float *z = sweep->z + offset;
+    uint32_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 vWidth = _mm_set1_ps(width);
+    const __m128 vMinHeight = _mm_set1_ps(minRelativeHeight);
+    const __m128 vMaxHeight = _mm_set1_ps(maxRelativeHeight);
+    const __m128 vGroundHeight = _mm_set1_ps(groundHeight);
+    const __m128i outside = _mm_set1_epi32(-1);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 vy = _mm_loadu_ps(y + i);
+        __m128 vz = _mm_loadu_ps(z + i);
+        __m128 north = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(n0), vx), _mm_mul_ps(_mm_set1_ps(n1), vy)),
+                                  _mm_add_ps(_mm_mul_ps(_mm_set1_ps(n2), vz), _mm_set1_ps(nOffset)));
+        __m128 east = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(e0), vx), _mm_mul_ps(_mm_set1_ps(e1), vy)),
+                                 _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e2), vz), _mm_set1_ps(eOffset)));
+        __m128 relativeHeight = _mm_sub_ps(zero, _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(d0), vx), _mm_mul_ps(_mm_set1_ps(d1), vy)),
+            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(d2), vz), _mm_set1_ps(dOffset))));
+        __m128 valid = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(north, zero), _mm_cmplt_ps(north, vWidth)),
+                                  _mm_and_ps(_mm_cmpge_ps(east, zero), _mm_cmplt_ps(east, vWidth)));
+        __m128i validMask;
+
+        valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(relativeHeight, vMinHeight),
+                                             _mm_cmple_ps(relativeHeight, vMaxHeight)));
+        validMask = _mm_castps_si128(valid);
+        _mm_storeu_si128((__m128i *) (cellNorth + i),
+                         _mm_or_si128(_mm_and_si128(validMask, _mm_cvttps_epi32(north)),
+                                      _mm_andnot_si128(validMask, outside)));
+        _mm_storeu_si128((__m128i *) (cellEast + i), _mm_and_si128(validMask, _mm_cvttps_epi32(east)));
+        _mm_storeu_ps(pointHeight + i, _mm_add_ps(relativeHeight, vGroundHeight));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const float32x4_t zero = vdupq_n_f32(0);
+    const float32x4_t vWidth = vdupq_n_f32(width);
+    const float32x4_t vMinHeight = vdupq_n_f32(minRelativeHeight);
+    const float32x4_t vMaxHeight = vdupq_n_f32(maxRelativeHeight);
+    const float32x4_t vGroundHeight = vdupq_n_f32(groundHeight);
+    const int32x4_t outside = vdupq_n_s32(-1);
+    const int32x4_t zeroCell = vdupq_n_s32(0);
+
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t vx = vld1q_f32(x + i);
+        float32x4_t vy = vld1q_f32(y + i);
+        float32x4_t vz = vld1q_f32(z + i);
+        float32x4_t north = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(nOffset), vx, n0), vy, n1), vz, n2);
+        float32x4_t east = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(eOffset), vx, e0), vy, e1), vz, e2);
+        float32x4_t relativeHeight = vnegq_f32(
+            vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(dOffset), vx, d0), vy, d1), vz, d2));
+        uint32x4_t valid = vandq_u32(vandq_u32(vcgeq_f32(north, zero), vcltq_f32(north, vWidth)),
+                                     vandq_u32(vcgeq_f32(east, zero), vcltq_f32(east, vWidth)));
+
+        valid = vandq_u32(valid, vandq_u32(vcgeq_f32(relativeHeight, vMinHeight),
+                                           vcleq_f32(relativeHeight, vMaxHeight)));
+        vst1q_s32(cellNorth + i, vbslq_s32(valid, vcvtq_s32_f32(north), outside));
+        vst1q_s32(cellEast + i, vbslq_s32(valid, vcvtq_s32_f32(east), zeroCell));
+        vst1q_f32(pointHeight + i, vaddq_f32(relativeHeight, vGroundHeight));
+    }
+#endif
+
+    //scalar tail
+    for (; i < count; i++) {
+        float north = n0 * x[i] + n1 * y[i] + n2 * z[i] + nOffset;
+        float east = e0 * x[i] + e1 * y[i] + e2 * z[i] + eOffset;
+        float relativeHeight = -(d0 * x[i] + d1 * y[i] + d2 * z[i] + dOffset);
+        int32_t valid = (north >= 0) & (north < width) & (east >= 0) & (east < width) &
+                        (relativeHeight >= minRelativeHeight) & (relativeHeight <= maxRelativeHeight);
+
+        cellNorth[i] = (int32_t) (valid ? north : -1.0f);
+        cellEast[i] = (int32_t) (valid ? east : 0.0f);
+        pointHeight[i] = relativeHeight + groundHeight;
+    }
+
+    return count;
+}
+
+void DJIRadarFusion::getOriginCell(const float *position, int32_t *originCellNorth, int32_t *originCellEast) const
+{
+    *originCellNorth = (int32_t) floorf(position[0] / config.cellSize) - (int32_t) (config.gridWidth / 2);
+    *originCellEast = (int32_t) floorf(position[1] / config.cellSize) - (int32_t) (config.gridWidth / 2);
+}
+
+/**
+ * @brief Rotation of a frame rotated by yaw, then pitch, then roll, about its own axes.
+ */
+static void DjiRadarFusion_RpyToRotation(float rollDeg, float pitchDeg, float yawDeg, float rotation[3][3])
+{
+    double cr = cos(rollDeg * DJI_RADAR_FUSION_DEG_TO_RAD), sr = sin(rollDeg * DJI_RADAR_FUSION_DEG_TO_RAD);
+    double cp = cos(pitchDeg * DJI_RADAR_FUSION_DEG_TO_RAD), sp = sin(pitchDeg * DJI_RADAR_FUSION_DEG_TO_RAD);
+    double cy = cos(yawDeg * DJI_RADAR_FUSION_DEG_TO_RAD), sy = sin(yawDeg * DJI_RADAR_FUSION_DEG_TO_RAD);
+
+    rotation[0][0] = (float) (cy * cp);
+    rotation[0][1] = (float) (cy * sp * sr - sy * cr);
+    rotation[0][2] = (float) (cy * sp * cr + sy * sr);
+    rotation[1][0] = (float) (sy * cp);
+    rotation[1][1] = (float) (sy * sp * sr + cy * cr);
+    rotation[1][2] = (float) (sy * sp * cr - cy * sr);
+    rotation[2][0] = (float) (-sp);
+    rotation[2][1] = (float) (cp * sr);
+    rotation[2][2] = (float) (cp * cr);
+}
+
+static void DjiRadarFusion_QuaternionToRotation(const float *quaternion, float rotation[3][3])
+{
+    float q0 = quaternion[0], q1 = quaternion[1], q2 = quaternion[2], q3 = quaternion[3];
+
+    rotation[0][0] = 1 - 2 * (q2 * q2 + q3 * q3);
+    rotation[0][1] = 2 * (q1 * q2 - q0 * q3);
+    rotation[0][2] = 2 * (q1 * q3 + q0 * q2);
+    rotation[1][0] = 2 * (q1 * q2 + q0 * q3);
+    rotation[1][1] = 1 - 2 * (q1 * q1 + q3 * q3);
+    rotation[1][2] = 2 * (q2 * q3 - q0 * q1);
+    rotation[2][0] = 2 * (q1 * q3 - q0 * q2);
+    rotation[2][1] = 2 * (q2 * q3 + q0 * q1);
+    rotation[2][2] = 1 - 2 * (q1 * q1 + q2 * q2);
+}
+
+static uint32_t DjiRadarFusion_GetTimeMs(uint64_t startTimeUs, uint64_t timeUs)
+{
+    return timeUs > startTimeUs ? (uint32_t) ((timeUs - startTimeUs) / 1000) + 1 : 1;
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,178 @@
+/**
+ ********************************************************************
+ * @file    dji_radar_fusion.hpp
+ * @brief   This is the header file for "dji_radar_fusion.cpp", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef DJI_RADAR_FUSION_H
+#define DJI_RADAR_FUSION_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_radar_frame_processor.hpp"
+
+/* Exported constants --------------------------------------------------------*/
+/* Poses kept to align the sweeps with, 1.28 s at 50 Hz. */
+#define DJI_RADAR_FUSION_POSE_HISTORY_NUM          64
+#define DJI_RADAR_FUSION_POSITION_MASK_ALL         ((1 << MAX_RADAR_NUM) - 1)
+
+/* Exported types ------------------------------------------------------------*/
+/**
+ * @brief Mounting of a radar: p_body = rotation * p_radar + translation, with the body frame forward, right, down.
+ */
+typedef struct {
+    float rotation[3][3];
+    float translation[3];
+} T_DjiRadarExtrinsics;
+
+typedef struct {
+    /*! Edge length of a grid cell in m. */
+    float cellSize;
+    /*! Cells per side of the grid centered on the aircraft, a power of two. */
+    uint32_t gridWidth;
+    /*! Points are fused when their height relative to the aircraft, in m and positive up, is inside the band. */
+    float minRelativeHeight;
+    float maxRelativeHeight;
+    /*! Time for the occupancy of a cell to halve without new hits. */
+    uint32_t decayHalfLifeMs;
+    /*! Occupancy added per point and upper limit of the occupancy of a cell. */
+    float hitWeight;
+    float maxOccupancy;
+    /*! Sweeps older than this when fused are skipped. */
+    uint32_t maxSweepAgeMs;
+} T_DjiRadarFusionConfig;
+
+/**
+ * @brief Aircraft pose in a local level frame, north, east, down, e.g. from the quaternion and position VO topics.
+ */
+typedef struct {
+    /*! Local time the pose was valid, on the clock of the radar sweep timestamps. */
+    uint64_t timeUs;
+    /*! Rotation of the body frame to the local frame, q0 is the scalar part. */
+    float quaternion[4];
+    float position[3];
+} T_DjiRadarFusionPose;
+
+/**
+ * @brief Occupancy around the aircraft. Cell (row, col) of the arrays covers the local frame square starting at
+ * north = (originCellNorth + row) * cellSize and east = (originCellEast + col) * cellSize.
+ */
+typedef struct {
+    uint64_t timeUs;
+    uint32_t gridWidth;
+    float cellSize;
+    int32_t originCellNorth;
+    int32_t originCellEast;
+    /*! gridWidth * gridWidth decayed occupancies, row major, provided by the caller. */
+    float *occupancy;
+    /*! Optional, gridWidth * gridWidth heights in m, positive up, of the highest hit of each cell, 0 if empty. */
+    float *height;
+    uint32_t occupiedCellCount;
+} T_DjiRadarOccupancyGrid;
+
+typedef struct {
+    uint64_t sweepCount;
+    uint64_t staleSweepCount;
+    uint64_t pointCount;
+    /*! Points outside of the grid or the height band. */
+    uint64_t rejectedPointCount;
+    /*! Sweeps fused without a pose within 100 ms of their time. */
+    uint64_t poselessSweepCount;
+    uint64_t updateTimeUs;
+    uint32_t updateTimeMaxUs;
+    uint64_t queryCount;
+    uint64_t queryTimeUs;
+    uint32_t queryTimeMaxUs;
+} T_DjiRadarFusionStatistics;
+
+/**
+ * @brief Fuses the sweeps of up to six radars into a 2.5D occupancy grid in the local level frame. The grid rolls
+ * with the aircraft: cells are addressed modulo the grid width and tagged with the world cell they hold, so moving
+ * never clears or copies cells, and occupancy decays lazily when a cell is hit or read.
+ */
+class DJIRadarFusion {
+public:
+    DJIRadarFusion();
+    ~DJIRadarFusion();
+    T_DjiReturnCode init(const T_DjiRadarFusionConfig &config);
+    void cleanup();
+
+    /* Read "front", "back", "left", "right", "up" and "down" mountings from a json file, see config/. */
+    T_DjiReturnCode loadExtrinsics(const char *path);
+    void setExtrinsics(E_DjiPerceptionRadarPosition position, const T_DjiRadarExtrinsics &extrinsics);
+
+    /* Subscribe the radars of the position mask and fuse their sweeps on a task of the fusion. */
+    T_DjiReturnCode start(uint32_t positionMask = DJI_RADAR_FUSION_POSITION_MASK_ALL);
+    void stop();
+
+    void updatePose(const T_DjiRadarFusionPose &pose);
+    /* Fuse one sweep, called by the fusion task. The sweep is not released. */
+    T_DjiReturnCode fuseSweep(const T_DjiRadarPointCloud *sweep);
+    T_DjiReturnCode getOccupancyGrid(T_DjiRadarOccupancyGrid *grid);
+    void getStatistics(T_DjiRadarFusionStatistics *statistics);
+
+private:
+    DJIRadarFusion(const DJIRadarFusion &);
+    DJIRadarFusion &operator=(const DJIRadarFusion &);
+
+    static void radarCallback(E_DjiPerceptionRadarPosition radarPosition, uint8_t *radarDataBuffer,
+                              uint32_t bufferLen);
+    static void *fusionTask(void *arg);
+    bool interpolatePose(uint64_t timeUs, T_DjiRadarFusionPose *pose);
+    uint32_t binPoints(const T_DjiRadarPointCloud *sweep, const T_DjiRadarFusionPose &pose,
+                       int32_t originCellNorth, int32_t originCellEast, uint32_t offset);
+    void getOriginCell(const float *position, int32_t *originCellNorth, int32_t *originCellEast) const;
+
+    struct T_Cell;
+
+    T_DjiRadarFusionConfig config;
+    uint32_t gridShift;
+    T_Cell *cells;
+    T_DjiRadarExtrinsics extrinsics[MAX_RADAR_NUM];
+    T_DjiMutexHandle mutex;
+    uint64_t startTimeUs;
+
+    /* Scratch of binPoints, one entry per point of the largest sweep. */
+    uint32_t scratchCapacity;
+    int32_t *cellNorth;
+    int32_t *cellEast;
+    float *pointHeight;
+
+    T_DjiRadarFusionPose poses[DJI_RADAR_FUSION_POSE_HISTORY_NUM];
+    uint32_t poseCount;
+    uint32_t poseHead;
+
+    DJIRadarFrameProcessor *processors[MAX_RADAR_NUM];
+    uint32_t positionMask;
+    T_DjiSemaHandle sweepSema;
+    T_DjiTaskHandle task;
+    T_DjiSemaHandle taskExitSema;
+    volatile bool taskStop;
+
+    T_DjiRadarFusionStatistics statistics;
+};
+
+/* Exported functions --------------------------------------------------------*/
+void DjiRadarFusion_GetDefaultConfig(T_DjiRadarFusionConfig *config);
+
+#endif // DJI_RADAR_FUSION_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
@@ -0,0 +1,1140 @@
+/**
+ ********************************************************************
+ * @file    dji_stereo_depth.cpp
+ * @brief   Stereo depth of the perception cameras: pairing, rectification and tiled block matching.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_stereo_depth.hpp"
+#include "dji_stereo_image_buffer.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <unistd.h>
+#include "dji_logger.h"
+
+#ifdef OPEN_CV_INSTALLED
+#include "opencv2/opencv.hpp"
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+/* Private constants ---------------------------------------------------------*/
+#define DJI_STEREO_DEPTH_TASK_STACK_SIZE       4096
+#define DJI_STEREO_DEPTH_WAIT_TIMEOUT_MS       100
+#define DJI_STEREO_DEPTH_DISPARITY_ALIGN       16
+#define DJI_STEREO_DEPTH_COST_INVALID          0xFFFF
+/* Rotations and baselines closer than this to an x axis baseline are taken as already rectified. */
+#define DJI_STEREO_DEPTH_RECTIFIED_TOLERANCE   1e-3f
+/* Process time over this share of the budget of a direction downscales it, and a finer scale is chosen when
+ * its estimated cost, 8 times the current one with the disparity range growing with the size, fits the lower
+ * share. Directions without a depth map in the last second do not take a share. */
+#define DJI_STEREO_DEPTH_BUDGET_HIGH           0.9f
+#define DJI_STEREO_DEPTH_BUDGET_LOW            0.6f
+#define DJI_STEREO_DEPTH_UPSCALE_COST_FACTOR   8
+#define DJI_STEREO_DEPTH_ADAPT_SAMPLE_NUM      4
+#define DJI_STEREO_DEPTH_ACTIVE_TIMEOUT_US     1000000
+
+/* Private types -------------------------------------------------------------*/
+typedef enum {
+    DJI_STEREO_DEPTH_PAIR_IDLE = 0,
+    DJI_STEREO_DEPTH_PAIR_READY,
+    DJI_STEREO_DEPTH_PAIR_PROCESSING,
+} E_DjiStereoDepthPairState;
+
+typedef struct {
+    T_DjiPerceptionImageInfo info;
+    uint64_t receiveTimeUs;
+    uint32_t capacity;
+    uint8_t *data;
+    bool valid;
+} T_DjiStereoDepthImage;
+
+struct DJIStereoDepth::T_Direction {
+    E_DjiPerceptionDirection direction;
+
+    /* Camera model, set before streaming. */
+    bool rectify;
+    float focalLength;
+    float baseline;
+    float principalPoint[2];
+    float leftIntrinsics[9];
+    float rightIntrinsics[9];
+    /* Rotations of the rectified camera frame into the left and the right camera frame. */
+    float rectToCamera[2][9];
+
+    /* Images waiting for their partner, owned by addImage. */
+    T_DjiStereoDepthImage pending[2];
+    uint64_t nextDueUs;
+
+    /* Pair handed to the depth task under the mutex. */
+    E_DjiStereoDepthPairState state;
+    T_DjiStereoDepthImage work[2];
+    uint64_t pairTimeUs;
+
+    /* Owned by the depth task. */
+    uint32_t downscale;
+    float processTimeAvgUs;
+    uint32_t adaptSampleCount;
+    uint64_t lastDepthMapUs;
+    uint32_t lutSourceWidth;
+    uint32_t lutSourceHeight;
+    uint32_t lutDownscale;
+    int32_t *lut[2];
+    uint8_t *rectified[2];
+    const uint8_t *matchImage[2];
+    float *depth;
+    uint32_t capacity;
+
+    T_DjiStereoDepthStatistics statistics;
+};
+
+struct DJIStereoDepth::T_Worker {
+    DJIStereoDepth *owner;
+    T_DjiTaskHandle task;
+    T_DjiSemaHandle startSema;
+    /* Per disparity: column sums of the absolute differences over the block rows, and block costs of a row. */
+    uint32_t stride;
+    uint32_t disparityCapacity;
+    uint16_t *columnSum;
+    uint16_t *cost;
+    uint16_t *bestCost;
+    uint8_t *bestDisparity;
+#ifdef OPEN_CV_INSTALLED
+    cv::Ptr<cv::StereoMatcher> matcher;
+    uint32_t matcherDisparityNum;
+#endif
+};
+
+/* Private values -------------------------------------------------------------*/
+
+/* Private functions declaration ---------------------------------------------*/
+static void DjiStereoDepth_SetupCamera(const T_DjiPerceptionCameraParameters *parameters, float *leftIntrinsics,
+                                       float *rightIntrinsics, float rectToCamera[2][9], bool *rectify,
+                                       float *baseline);
+static void DjiStereoDepth_BuildLut(const float *intrinsics, const float *rectToCamera, float focalLength,
+                                    const float *principalPoint, uint32_t sourceWidth, uint32_t sourceHeight,
+                                    uint32_t downscale, int32_t *lut);
+static void DjiStereoDepth_Downscale(const uint8_t *source, uint32_t sourceWidth, uint32_t downscale,
+                                     uint32_t width, uint32_t height, uint8_t *output);
+static void DjiStereoDepth_AccumulateRow(uint16_t *columnSum, uint32_t stride, const uint8_t *left,
+                                         const uint8_t *right, uint32_t width, uint32_t disparityNum, bool add);
+static bool DjiStereoDepth_Reserve(void **buffer, uint32_t *capacity, uint32_t size);
+
+/* Exported functions definition ---------------------------------------------*/
+void DjiStereoDepth_GetDefaultConfig(T_DjiStereoDepthConfig *config)
+{
+    long cpuNum = sysconf(_SC_NPROCESSORS_ONLN);
+
+    memset(config, 0, sizeof(T_DjiStereoDepthConfig));
+    config->matcher = DJI_STEREO_DEPTH_MATCHER_SAD;
+    config->targetRateHz = 10;
+    config->disparityNum = 64;
+    config->blockSize = 9;
+    config->uniquenessRatio = 10;
+    config->maxDownscale = DJI_STEREO_DEPTH_DOWNSCALE_MAX;
+    config->workerNum = cpuNum > 1 ? (uint32_t) cpuNum - 1 : 0;
+    if (config->workerNum > DJI_STEREO_DEPTH_WORKER_NUM_MAX) {
+        config->workerNum = DJI_STEREO_DEPTH_WORKER_NUM_MAX;
+    }
+    config->tileRows = 16;
+    config->maxPairTimeDiff = 0;
+}
+
+DJIStereoDepth::DJIStereoDepth()
+    : callback(nullptr),
+      userData(nullptr),
+      directions(nullptr),
+      mutex(nullptr),
+      pairSema(nullptr),
+      task(nullptr),
+      taskExitSema(nullptr),
+      taskStop(false),
+      nextDirection(0),
+      workers(nullptr),
+      jobDoneSema(nullptr),
+      jobLeft(nullptr),
+      jobRight(nullptr),
+      jobDepth(nullptr),
+      jobWidth(0),
+      jobHeight(0),
+      jobDisparityNum(0),
+      jobFocalBaseline(0),
+      jobTileCount(0),
+      jobNextTile(0)
+{
+    DjiStereoDepth_GetDefaultConfig(&config);
+}
+
+DJIStereoDepth::~DJIStereoDepth()
+{
+    cleanup();
+}
+
+T_DjiReturnCode DJIStereoDepth::init(const T_DjiStereoDepthConfig &config, DjiStereoDepthCallback callback,
+                                     void *userData)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    uint32_t maxBlockSize = config.matcher == DJI_STEREO_DEPTH_MATCHER_SAD ? DJI_STEREO_DEPTH_BLOCK_SIZE_MAX : 255;
+    T_DjiReturnCode returnCode;
+
+    if (directions != nullptr) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+    }
+    if (config.targetRateHz == 0 || config.disparityNum < DJI_STEREO_DEPTH_DISPARITY_ALIGN ||
+        config.disparityNum > 256 || config.blockSize < 3 || config.blockSize > maxBlockSize ||
+        config.blockSize % 2 == 0 || config.tileRows == 0 || config.workerNum > DJI_STEREO_DEPTH_WORKER_NUM_MAX ||
+        (config.maxDownscale != 1 && config.maxDownscale != 2 && config.maxDownscale != 4)) {
+        USER_LOG_ERROR("Invalid stereo depth config.");
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+#ifndef OPEN_CV_INSTALLED
+    if (config.matcher != DJI_STEREO_DEPTH_MATCHER_SAD) {
+        USER_LOG_ERROR("OpenCV stereo matchers need OpenCV, use the built-in matcher.");
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
+    }
+#endif
+
+    this->config = config;
+    this->callback = callback;
+    this->userData = userData;
+    taskStop = false;
+    nextDirection = 0;
+
+    directions = new(std::nothrow) T_Direction[IMAGE_MAX_DIRECTION_NUM]();
+    workers = new(std::nothrow) T_Worker[config.workerNum + 1]();
+    if (directions == nullptr || workers == nullptr) {
+        USER_LOG_ERROR("Malloc stereo depth state failed.");
+        cleanup();
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+
+    for (uint32_t i = 0; i < IMAGE_MAX_DIRECTION_NUM; i++) {
+        directions[i].direction = (E_DjiPerceptionDirection) i;
+        directions[i].focalLength = 1;
+        directions[i].baseline = 1;
+        directions[i].downscale = config.maxDownscale;
+        directions[i].statistics.downscale = config.maxDownscale;
+    }
+
+    returnCode = osalHandler->MutexCreate(&mutex);
+    if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        returnCode = osalHandler->SemaphoreCreate(0, &pairSema);
+    }
+    if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        returnCode = osalHandler->SemaphoreCreate(0, &jobDoneSema);
+    }
+    if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        returnCode = osalHandler->SemaphoreCreate(0, &taskExitSema);
+    }
+    for (uint32_t i = 0; i < config.workerNum && returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS; i++) {
+        workers[i].owner = this;
+        returnCode = osalHandler->SemaphoreCreate(0, &workers[i].startSema);
+        if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            returnCode = osalHandler->TaskCreate("stereo_depth_worker", workerTask, DJI_STEREO_DEPTH_TASK_STACK_SIZE,
+                                                 &workers[i], &workers[i].task);
+        }
+    }
+    workers[config.workerNum].owner = this;
+    if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        returnCode = osalHandler->TaskCreate("stereo_depth", depthTask, DJI_STEREO_DEPTH_TASK_STACK_SIZE, this,
+                                             &task);
+    }
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Create stereo depth tasks failed, error code: 0x%08llX", returnCode);
+        cleanup();
+        return returnCode;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+void DJIStereoDepth::cleanup()
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    uint32_t runningWorkerNum = 0;
+
+    taskStop = true;
+    if (task != nullptr) {
+        osalHandler->SemaphorePost(pairSema);
+        osalHandler->SemaphoreWait(taskExitSema);
+        osalHandler->TaskDestroy(task);
+        task = nullptr;
+    }
+
+    if (workers != nullptr) {
+        for (uint32_t i = 0; i < config.workerNum; i++) {
+            if (workers[i].task != nullptr) {
+                osalHandler->SemaphorePost(workers[i].startSema);
+                runningWorkerNum++;
+            }
+        }
+        for (uint32_t i = 0; i < runningWorkerNum; i++) {
+            osalHandler->SemaphoreWait(jobDoneSema);
+        }
+        for (uint32_t i = 0; i <= config.workerNum; i++) {
+            if (workers[i].task != nullptr) {
+                osalHandler->TaskDestroy(workers[i].task);
+            }
+            if (workers[i].startSema != nullptr) {
+                osalHandler->SemaphoreDestroy(workers[i].startSema);
+            }
+            free(workers[i].columnSum);
+            free(workers[i].cost);
+            free(workers[i].bestCost);
+            free(workers[i].bestDisparity);
+        }
+        delete[] workers;
+        workers = nullptr;
+    }
+
+    if (directions != nullptr) {
+        for (uint32_t i = 0; i < IMAGE_MAX_DIRECTION_NUM; i++) {
+            for (uint32_t j = 0; j < 2; j++) {
+                free(directions[i].pending[j].data);
+                free(directions[i].work[j].data);
+                free(directions[i].lut[j]);
+                free(directions[i].rectified[j]);
+            }
+            free(directions[i].depth);
+        }
+        delete[] directions;
+        directions = nullptr;
+    }
+
+    if (taskExitSema != nullptr) {
+        osalHandler->SemaphoreDestroy(taskExitSema);
+        taskExitSema = nullptr;
+    }
+    if (jobDoneSema != nullptr) {
+        osalHandler->SemaphoreDestroy(jobDoneSema);
+        jobDoneSema = nullptr;
+    }
+    if (pairSema != nullptr) {
+        osalHandler->SemaphoreDestroy(pairSema);
+        pairSema = nullptr;
+    }
+    if (mutex != nullptr) {
+        osalHandler->MutexDestroy(mutex);
+        mutex = nullptr;
+    }
+    taskStop = false;
+}
+
+T_DjiReturnCode DJIStereoDepth::setCameraParameters(const T_DjiPerceptionCameraParametersPacket &packet)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    const T_DjiPerceptionCameraParameters *parameters;
+    T_Direction *direction;
+
+    if (directions == nullptr) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE;
+    }
+
+    osalHandler->MutexLock(mutex);
+    for (uint32_t i = 0; i < packet.directionNum && i < IMAGE_MAX_DIRECTION_NUM; i++) {
+        parameters = &packet.cameraParameters[i];
+        if (parameters->direction >= IMAGE_MAX_DIRECTION_NUM) {
+            continue;
+        }
+
+        direction = &directions[parameters->direction];
+        DjiStereoDepth_SetupCamera(parameters, direction->leftIntrinsics, direction->rightIntrinsics,
+                                   direction->rectToCamera, &direction->rectify, &direction->baseline);
+        direction->focalLength = direction->leftIntrinsics[0];
+        direction->principalPoint[0] = direction->leftIntrinsics[2];
+        direction->principalPoint[1] = direction->leftIntrinsics[5];
+        direction->lutDownscale = 0;
+        USER_LOG_INFO("Stereo depth [%d] focal %.2f px, baseline %.4f, %s.", parameters->direction,
+                      direction->focalLength, direction->baseline,
+                      direction->rectify ? "rectified with the camera parameters" : "already rectified");
+    }
+    osalHandler->MutexUnlock(mutex);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DJIStereoDepth::addImage(const T_DjiPerceptionImageInfo &info, const uint8_t *data,
+                                         uint32_t dataLen)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    int32_t cameraIndex = DjiStereoImageBuffer_GetCameraIndex(info.dataType);
+    uint32_t imageSize = info.rawInfo.width * info.rawInfo.height;
+    uint64_t periodUs = 1000000 / config.targetRateHz;
+    T_DjiStereoDepthImage *image;
+    T_DjiStereoDepthImage *partner;
+    T_DjiStereoDepthImage swapImage;
+    T_Direction *direction;
+    uint64_t timeDiff;
+    uint64_t nowUs = 0;
+    bool replaced;
+    bool posted = false;
+
+    if (directions == nullptr) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE;
+    }
+    if (cameraIndex < 0 || data == nullptr || imageSize == 0 || dataLen < imageSize) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    osalHandler->GetTimeUs(&nowUs);
+    direction = &directions[cameraIndex / 2];
+    image = &direction->pending[cameraIndex % 2];
+    partner = &direction->pending[1 - cameraIndex % 2];
+
+    replaced = image->valid;
+    image->valid = false;
+    if (!DjiStereoDepth_Reserve((void **) &image->data, &image->capacity, imageSize)) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+    memcpy(image->data, data, imageSize);
+    image->info = info;
+    image->receiveTimeUs = nowUs;
+    image->valid = true;
+
+    osalHandler->MutexLock(mutex);
+    direction->statistics.imageCount++;
+    if (replaced) {
+        direction->statistics.unpairedImageCount++;
+    }
+
+    if (partner->valid) {
+        timeDiff = info.timeStamp > partner->info.timeStamp ? info.timeStamp - partner->info.timeStamp :
+                   partner->info.timeStamp - info.timeStamp;
+        if (timeDiff > config.maxPairTimeDiff || partner->info.rawInfo.width != info.rawInfo.width ||
+            partner->info.rawInfo.height != info.rawInfo.height) {
+            partner->valid = false;
+            direction->statistics.unpairedImageCount++;
+        } else {
+            direction->statistics.pairCount++;
+            if (direction->state == DJI_STEREO_DEPTH_PAIR_PROCESSING || nowUs + periodUs / 4 < direction->nextDueUs) {
+                direction->statistics.skippedPairCount++;
+            } else {
+                if (direction->state == DJI_STEREO_DEPTH_PAIR_READY) {
+                    direction->statistics.skippedPairCount++;
+                }
+                for (uint32_t i = 0; i < 2; i++) {
+                    swapImage = direction->work[i];
+                    direction->work[i] = direction->pending[i];
+                    direction->pending[i] = swapImage;
+                }
+                direction->state = DJI_STEREO_DEPTH_PAIR_READY;
+                direction->pairTimeUs = nowUs;
+                direction->nextDueUs = nowUs > direction->nextDueUs + periodUs / 4 ? nowUs + periodUs :
+                                       direction->nextDueUs + periodUs;
+                posted = true;
+            }
+            direction->pending[0].valid = false;
+            direction->pending[1].valid = false;
+        }
+    }
+    osalHandler->MutexUnlock(mutex);
+
+    if (posted) {
+        osalHandler->SemaphorePost(pairSema);
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+void DJIStereoDepth::getStatistics(E_DjiPerceptionDirection direction, T_DjiStereoDepthStatistics *statistics)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    memset(statistics, 0, sizeof(T_DjiStereoDepthStatistics));
+    if (directions == nullptr || (uint32_t) direction >= IMAGE_MAX_DIRECTION_NUM) {
+        return;
+    }
+
+    osalHandler->MutexLock(mutex);
+    *statistics = directions[direction].statistics;
+    osalHandler->MutexUnlock(mutex);
+}
+
+/* Private functions definition-----------------------------------------------*/
+void *DJIStereoDepth::depthTask(void *arg)
+{
+    auto *depth = (DJIStereoDepth *) arg;
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_Direction *direction;
+    uint64_t nowUs = 0;
+
+    while (!depth->taskStop) {
+        osalHandler->SemaphoreTimedWait(depth->pairSema, DJI_STEREO_DEPTH_WAIT_TIMEOUT_MS);
+
+        /* Serve the directions round robin, so a fast direction can not starve the others. */
+        while (!depth->taskStop) {
+            direction = nullptr;
+            osalHandler->MutexLock(depth->mutex);
+            for (uint32_t i = 0; i < IMAGE_MAX_DIRECTION_NUM; i++) {
+                T_Direction *candidate = &depth->directions[(depth->nextDirection + i) % IMAGE_MAX_DIRECTION_NUM];
+                if (candidate->state == DJI_STEREO_DEPTH_PAIR_READY) {
+                    candidate->state = DJI_STEREO_DEPTH_PAIR_PROCESSING;
+                    depth->nextDirection = (candidate->direction + 1) % IMAGE_MAX_DIRECTION_NUM;
+                    direction = candidate;
+                    break;
+                }
+            }
+            osalHandler->MutexUnlock(depth->mutex);
+            if (direction == nullptr) {
+                break;
+            }
+
+            osalHandler->GetTimeUs(&nowUs);
+            depth->processPair(direction, nowUs);
+
+            osalHandler->MutexLock(depth->mutex);
+            direction->state = DJI_STEREO_DEPTH_PAIR_IDLE;
+            osalHandler->MutexUnlock(depth->mutex);
+        }
+    }
+
+    osalHandler->SemaphorePost(depth->taskExitSema);
+
+    return nullptr;
+}
+
+void *DJIStereoDepth::workerTask(void *arg)
+{
+    auto *worker = (T_Worker *) arg;
+    DJIStereoDepth *depth = worker->owner;
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    while (true) {
+        osalHandler->SemaphoreWait(worker->startSema);
+        if (depth->taskStop) {
+            break;
+        }
+        depth->matchTiles(worker);
+        osalHandler->SemaphorePost(depth->jobDoneSema);
+    }
+
+    osalHandler->SemaphorePost(depth->jobDoneSema);
+
+    return nullptr;
+}
+
+void DJIStereoDepth::processPair(T_Direction *direction, uint64_t startTimeUs)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    const T_DjiStereoDepthImage *left = &direction->work[0];
+    uint32_t downscale = direction->downscale;
+    uint32_t width = left->info.rawInfo.width / downscale;
+    uint32_t height = left->info.rawInfo.height / downscale;
+    uint32_t disparityNum;
+    T_DjiStereoDepthMap depthMap;
+    uint64_t endTimeUs = 0;
+    uint32_t processTimeUs;
+    uint32_t latencyUs;
+
+    /* The disparity range is given for the camera images, the downscaled images need a smaller one. */
+    disparityNum = (config.disparityNum + downscale - 1) / downscale;
+    disparityNum = (disparityNum + DJI_STEREO_DEPTH_DISPARITY_ALIGN - 1) & ~(DJI_STEREO_DEPTH_DISPARITY_ALIGN - 1);
+    if (disparityNum + config.blockSize > width) {
+        disparityNum = width > config.blockSize ? (width - config.blockSize) & ~(DJI_STEREO_DEPTH_DISPARITY_ALIGN - 1)
+                                                : 0;
+    }
+    if (disparityNum == 0 || height < config.blockSize) {
+        USER_LOG_WARN("Stereo images of %ux%u are too small to match.", width, height);
+        return;
+    }
+
+    if (!prepareImages(direction, downscale) ||
+        prepareWorkers(width, disparityNum) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Malloc stereo depth buffers failed.");
+        return;
+    }
+
+    jobLeft = direction->matchImage[0];
+    jobRight = direction->matchImage[1];
+    jobDepth = direction->depth;
+    jobWidth = width;
+    jobHeight = height;
+    jobDisparityNum = disparityNum;
+    jobFocalBaseline = direction->focalLength / (float) downscale * direction->baseline;
+    jobTileCount = (height + config.tileRows - 1) / config.tileRows;
+    jobNextTile.store(0, std::memory_order_relaxed);
+
+    for (uint32_t i = 0; i < config.workerNum; i++) {
+        osalHandler->SemaphorePost(workers[i].startSema);
+    }
+    matchTiles(&workers[config.workerNum]);
+    for (uint32_t i = 0; i < config.workerNum; i++) {
+        osalHandler->SemaphoreWait(jobDoneSema);
+    }
+
+    osalHandler->GetTimeUs(&endTimeUs);
+    processTimeUs = endTimeUs > startTimeUs ? (uint32_t) (endTimeUs - startTimeUs) : 0;
+    latencyUs = endTimeUs > direction->pairTimeUs ? (uint32_t) (endTimeUs - direction->pairTimeUs) : 0;
+
+    depthMap.direction = direction->direction;
+    depthMap.timeStamp = left->info.timeStamp;
+    depthMap.sequence = left->info.sequence;
+    depthMap.width = width;
+    depthMap.height = height;
+    depthMap.downscale = downscale;
+    depthMap.focalLength = direction->focalLength / (float) downscale;
+    depthMap.baseline = direction->baseline;
+    depthMap.depth = direction->depth;
+    depthMap.latencyUs = latencyUs;
+    depthMap.processTimeUs = processTimeUs;
+    if (callback != nullptr) {
+        callback(&depthMap, userData);
+    }
+
+    osalHandler->MutexLock(mutex);
+    direction->statistics.depthMapCount++;
+    direction->statistics.processTimeUs += processTimeUs;
+    if (processTimeUs > direction->statistics.processTimeMaxUs) {
+        direction->statistics.processTimeMaxUs = processTimeUs;
+    }
+    direction->statistics.latencyUs += latencyUs;
+    if (latencyUs > direction->statistics.latencyMaxUs) {
+        direction->statistics.latencyMaxUs = latencyUs;
+    }
+    direction->processTimeAvgUs = direction->adaptSampleCount == 0 ? (float) processTimeUs :
+                                  0.75f * direction->processTimeAvgUs + 0.25f * (float) processTimeUs;
+    direction->adaptSampleCount++;
+    direction->lastDepthMapUs = endTimeUs;
+    adaptDownscale(direction, endTimeUs);
+    direction->statistics.downscale = direction->downscale;
+    osalHandler->MutexUnlock(mutex);
+}
+
+/**
+ * @brief Rectify and downscale the pair into the images matched, or match the camera images in place when they
+ * are already rectified and not downscaled.
+ */
+bool DJIStereoDepth::prepareImages(T_Direction *direction, uint32_t downscale)
+{
+    uint32_t sourceWidth = direction->work[0].info.rawInfo.width;
+    uint32_t sourceHeight = direction->work[0].info.rawInfo.height;
+    uint32_t width = sourceWidth / downscale;
+    uint32_t height = sourceHeight / downscale;
+    uint32_t pixelNum = width * height;
+    const uint8_t *source;
+    const int32_t *lut;
+    uint8_t *output;
+
+    if (pixelNum > direction->capacity) {
+        for (uint32_t i = 0; i < 2; i++) {
+            free(direction->rectified[i]);
+            free(direction->lut[i]);
+            direction->rectified[i] = (uint8_t *) malloc(pixelNum);
+            direction->lut[i] = (int32_t *) malloc(pixelNum * sizeof(int32_t));
+        }
+        free(direction->depth);
+        direction->depth = (float *) malloc(pixelNum * sizeof(float));
+        direction->lutDownscale = 0;
+        if (direction->rectified[0] == nullptr || direction->rectified[1] == nullptr || direction->lut[0] == nullptr ||
+            direction->lut[1] == nullptr || direction->depth == nullptr) {
+            direction->capacity = 0;
+            return false;
+        }
+        direction->capacity = pixelNum;
+    }
+
+    if (direction->rectify && (direction->lutDownscale != downscale || direction->lutSourceWidth != sourceWidth ||
+                               direction->lutSourceHeight != sourceHeight)) {
+        for (uint32_t i = 0; i < 2; i++) {
+            DjiStereoDepth_BuildLut(i == 0 ? direction->leftIntrinsics : direction->rightIntrinsics,
+                                    direction->rectToCamera[i], direction->focalLength, direction->principalPoint,
+                                    sourceWidth, sourceHeight, downscale, direction->lut[i]);
+        }
+        direction->lutDownscale = downscale;
+        direction->lutSourceWidth = sourceWidth;
+        direction->lutSourceHeight = sourceHeight;
+    }
+
+    for (uint32_t i = 0; i < 2; i++) {
+        source = direction->work[i].data;
+        output = direction->rectified[i];
+        if (direction->rectify) {
+            lut = direction->lut[i];
+            for (uint32_t j = 0; j < pixelNum; j++) {
+                output[j] = lut[j] >= 0 ? source[lut[j]] : 0;
+            }
+            direction->matchImage[i] = output;
+        } else if (downscale > 1) {
+            DjiStereoDepth_Downscale(source, sourceWidth, downscale, width, height, output);
+            direction->matchImage[i] = output;
+        } else {
+            direction->matchImage[i] = source;
+        }
+    }
+
+    return true;
+}
+
+/* Called by the depth task while the workers wait. */
+T_DjiReturnCode DJIStereoDepth::prepareWorkers(uint32_t width, uint32_t disparityNum)
+{
+    uint32_t stride = (width + 15) & ~15u;
+    T_Worker *worker;
+
+    if (config.matcher != DJI_STEREO_DEPTH_MATCHER_SAD) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    for (uint32_t i = 0; i <= config.workerNum; i++) {
+        worker = &workers[i];
+        if (worker->stride >= stride && worker->disparityCapacity >= disparityNum) {
+            continue;
+        }
+
+        free(worker->columnSum);
+        free(worker->cost);
+        free(worker->bestCost);
+        free(worker->bestDisparity);
+        worker->columnSum = (uint16_t *) malloc((size_t) disparityNum * stride * sizeof(uint16_t));
+        worker->cost = (uint16_t *) malloc((size_t) disparityNum * stride * sizeof(uint16_t));
+        worker->bestCost = (uint16_t *) malloc(stride * sizeof(uint16_t));
+        worker->bestDisparity = (uint8_t *) malloc(stride);
+        if (worker->columnSum == nullptr || worker->cost == nullptr || worker->bestCost == nullptr ||
+            worker->bestDisparity == nullptr) {
+            worker->stride = 0;
+            worker->disparityCapacity = 0;
+            return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+        }
+        worker->stride = stride;
+        worker->disparityCapacity = disparityNum;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+void DJIStereoDepth::matchTiles(T_Worker *worker)
+{
+    uint32_t tile;
+
+    while ((tile = jobNextTile.fetch_add(1, std::memory_order_relaxed)) < jobTileCount) {
+        if (config.matcher == DJI_STEREO_DEPTH_MATCHER_SAD) {
+            matchTileSad(worker, tile);
+        } else {
+            matchTileOpenCv(worker, tile);
+        }
+    }
+}
+
+/**
+ * @brief Sum of absolute differences over blockSize x blockSize blocks for each disparity. Column sums over the
+ * block rows are updated by one row in and one row out per output row, block costs are running sums over the
+ * columns. Disparities not beating all others except the neighbours by uniquenessRatio are dropped, the rest
+ * are refined to sub pixels with a parabola through the neighbouring costs.
+ */
+void DJIStereoDepth::matchTileSad(T_Worker *worker, uint32_t tile)
+{
+    const uint32_t width = jobWidth;
+    const uint32_t height = jobHeight;
+    const uint32_t disparityNum = jobDisparityNum;
+    const uint32_t stride = worker->stride;
+    const int32_t radius = (int32_t) config.blockSize / 2;
+    const uint32_t firstValidX = disparityNum - 1 + radius;
+    const uint32_t rowBegin = tile * config.tileRows;
+    const uint32_t rowEnd = rowBegin + config.tileRows < height ? rowBegin + config.tileRows : height;
+    uint16_t *columnSum = worker->columnSum;
+    uint16_t *cost = worker->cost;
+    uint16_t *bestCost = worker->bestCost;
+    uint8_t *bestDisparity = worker->bestDisparity;
+    int32_t row;
+
+    memset(columnSum, 0, (size_t) disparityNum * stride * sizeof(uint16_t));
+    for (int32_t k = -radius; k <= radius; k++) {
+        row = (int32_t) rowBegin + k;
+        row = row < 0 ? 0 : (row >= (int32_t) height ? (int32_t) height - 1 : row);
+        DjiStereoDepth_AccumulateRow(columnSum, stride, jobLeft + (size_t) row * width,
+                                     jobRight + (size_t) row * width, width, disparityNum, true);
+    }
+
+    for (uint32_t y = rowBegin; y < rowEnd; y++) {
+        float *depthRow = jobDepth + (size_t) y * width;
+
+        if (y > rowBegin) {
+            row = (int32_t) y + radius;
+            row = row >= (int32_t) height ? (int32_t) height - 1 : row;
+            DjiStereoDepth_AccumulateRow(columnSum, stride, jobLeft + (size_t) row * width,
+                                         jobRight + (size_t) row * width, width, disparityNum, true);
+            row = (int32_t) y - radius - 1;
+            row = row < 0 ? 0 : row;
+            DjiStereoDepth_AccumulateRow(columnSum, stride, jobLeft + (size_t) row * width,
+                                         jobRight + (size_t) row * width, width, disparityNum, false);
+        }
+
+        for (uint32_t x = 0; x < width; x++) {
+            bestCost[x] = DJI_STEREO_DEPTH_COST_INVALID;
+            bestDisparity[x] = 0;
+        }
+
+        for (uint32_t d = 0; d < disparityNum; d++) {
+            const uint16_t *sum = columnSum + (size_t) d * stride;
+            uint16_t *costRow = cost + (size_t) d * stride;
+            uint32_t first = d + radius;
+            uint32_t last = width - 1 - radius;
+            uint32_t blockSum = 0;
+
+            for (uint32_t x = 0; x < first; x++) {
+                costRow[x] = DJI_STEREO_DEPTH_COST_INVALID;
+            }
+            for (uint32_t x = last + 1; x < width; x++) {
+                costRow[x] = DJI_STEREO_DEPTH_COST_INVALID;
+            }
+            for (uint32_t x = d; x <= d + 2 * radius; x++) {
+                blockSum += sum[x];
+            }
+            costRow[first] = (uint16_t) blockSum;
+            for (uint32_t x = first + 1; x <= last; x++) {
+                blockSum += (uint32_t) sum[x + radius] - sum[x - radius - 1];
+                costRow[x] = (uint16_t) blockSum;
+            }
+            for (uint32_t x = first; x <= last; x++) {
+                if (costRow[x] < bestCost[x]) {
+                    bestCost[x] = costRow[x];
+                    bestDisparity[x] = (uint8_t) d;
+                }
+            }
+        }
+
+        for (uint32_t x = 0; x < width; x++) {
+            uint32_t best = bestCost[x];
+            uint32_t bestD = bestDisparity[x];
+            float disparity;
+
+            depthRow[x] = 0;
+            if (x < firstValidX || x + radius >= width || bestD == 0 || best == DJI_STEREO_DEPTH_COST_INVALID) {
+                continue;
+            }
+
+            if (config.uniquenessRatio > 0) {
+                uint32_t threshold = best + best * config.uniquenessRatio / 100;
+                bool unique = true;
+                for (uint32_t d = 0; d < disparityNum && unique; d++) {
+                    if ((d + 1 < bestD || d > bestD + 1) && cost[(size_t) d * stride + x] <= threshold) {
+                        unique = false;
+                    }
+                }
+                if (!unique) {
+                    continue;
+                }
+            }
+
+            disparity = (float) bestD;
+            if (bestD + 1 < disparityNum) {
+                int32_t previous = cost[(size_t) (bestD - 1) * stride + x];
+                int32_t next = cost[(size_t) (bestD + 1) * stride + x];
+                int32_t denominator = previous + next - 2 * (int32_t) best;
+                if (denominator > 0) {
+                    disparity += (float) (previous - next) / (float) (2 * denominator);
+                }
+            }
+            depthRow[x] = jobFocalBaseline / disparity;
+        }
+    }
+}
+
+/**
+ * @brief Match a tile with OpenCV, with rows of a block size above and below for context. Every worker keeps
+ * its own matcher, they are not meant to be shared between threads.
+ */
+void DJIStereoDepth::matchTileOpenCv(T_Worker *worker, uint32_t tile)
+{
+#ifdef OPEN_CV_INSTALLED
+    const int blockSize = (int) config.blockSize;
+    const int rowBegin = (int) (tile * config.tileRows);
+    const int rowEnd = rowBegin + (int) config.tileRows < (int) jobHeight ? rowBegin + (int) config.tileRows :
+                       (int) jobHeight;
+    const int contextBegin = rowBegin > blockSize ? rowBegin - blockSize : 0;
+    const int contextEnd = rowEnd + blockSize < (int) jobHeight ? rowEnd + blockSize : (int) jobHeight;
+    cv::Mat left((int) jobHeight, (int) jobWidth, CV_8U, (void *) jobLeft);
+    cv::Mat right((int) jobHeight, (int) jobWidth, CV_8U, (void *) jobRight);
+    cv::Mat disparity;
+
+    if (worker->matcher.empty() || worker->matcherDisparityNum != jobDisparityNum) {
+        if (config.matcher == DJI_STEREO_DEPTH_MATCHER_OPENCV_BM) {
+            cv::Ptr<cv::StereoBM> matcher = cv::StereoBM::create((int) jobDisparityNum, blockSize);
+            matcher->setUniquenessRatio((int) config.uniquenessRatio);
+            worker->matcher = matcher;
+        } else {
+            worker->matcher = cv::StereoSGBM::create(0, (int) jobDisparityNum, blockSize, 8 * blockSize * blockSize,
+                                                     32 * blockSize * blockSize, 1, 0,
+                                                     (int) config.uniquenessRatio);
+        }
+        worker->matcherDisparityNum = jobDisparityNum;
+    }
+
+    worker->matcher->compute(left.rowRange(contextBegin, contextEnd), right.rowRange(contextBegin, contextEnd),
+                             disparity);
+
+    for (int y = rowBegin; y < rowEnd; y++) {
+        const int16_t *disparityRow = disparity.ptr<int16_t>(y - contextBegin);
+        float *depthRow = jobDepth + (size_t) y * jobWidth;
+        for (uint32_t x = 0; x < jobWidth; x++) {
+            /* Fixed point disparities with 4 fractional bits, negative where no match was found. */
+            depthRow[x] = disparityRow[x] > 0 ? jobFocalBaseline * 16.0f / (float) disparityRow[x] : 0;
+        }
+    }
+#else
+    (void) worker;
+    (void) tile;
+#endif
+}
+
+void DJIStereoDepth::adaptDownscale(T_Direction *direction, uint64_t nowUs)
+{
+    uint32_t activeNum = 0;
+    float budgetUs;
+
+    if (direction->adaptSampleCount < DJI_STEREO_DEPTH_ADAPT_SAMPLE_NUM) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < IMAGE_MAX_DIRECTION_NUM; i++) {
+        if (directions[i].lastDepthMapUs != 0 &&
+            nowUs - directions[i].lastDepthMapUs < DJI_STEREO_DEPTH_ACTIVE_TIMEOUT_US) {
+            activeNum++;
+        }
+    }
+    /* The directions share the depth task, so each gets its part of the period. */
+    budgetUs = 1000000.0f / (float) config.targetRateHz / (float) (activeNum > 0 ? activeNum : 1);
+
+    if (direction->processTimeAvgUs > DJI_STEREO_DEPTH_BUDGET_HIGH * budgetUs &&
+        direction->downscale < config.maxDownscale) {
+        direction->downscale *= 2;
+        direction->adaptSampleCount = 0;
+    } else if (direction->processTimeAvgUs * DJI_STEREO_DEPTH_UPSCALE_COST_FACTOR <
+               DJI_STEREO_DEPTH_BUDGET_LOW * budgetUs && direction->downscale > 1) {
+        direction->downscale /= 2;
+        direction->adaptSampleCount = 0;
+    }
+}
+
+/**
+ * @brief Camera model of a direction. The rectified frame has its x axis along the baseline and its z axis as
+ * close as possible to the one of the left camera, the left camera keeps its intrinsics.
+ */
+static void DjiStereoDepth_SetupCamera(const T_DjiPerceptionCameraParameters *parameters, float *leftIntrinsics,
+                                       float *rightIntrinsics, float rectToCamera[2][9], bool *rectify,
+                                       float *baseline)
+{
+    const float *rotation = parameters->rotationLeftInRight;
+    const float *translation = parameters->translationLeftInRight;
+    float center[3];
+    float axes[9];
+    float norm;
+    float error = 0;
+
+    memcpy(leftIntrinsics, parameters->leftIntrinsics, sizeof(float) * 9);
+    memcpy(rightIntrinsics, parameters->rightIntrinsics, sizeof(float) * 9);
+
+    /* Center of the right camera in the left camera frame, -R^T * t with x_right = R * x_left + t. */
+    for (uint32_t i = 0; i < 3; i++) {
+        center[i] = -(rotation[i] * translation[0] + rotation[3 + i] * translation[1] +
+                      rotation[6 + i] * translation[2]);
+    }
+    norm = sqrtf(center[0] * center[0] + center[1] * center[1] + center[2] * center[2]);
+    *baseline = norm > 0 ? norm : 1;
+    if (norm <= 0) {
+        center[0] = 1;
+        norm = 1;
+    }
+    /* The right camera has to be on the positive x side, a translation given the other way round is flipped. */
+    if (center[0] < 0) {
+        for (uint32_t i = 0; i < 3; i++) {
+            center[i] = -center[i];
+        }
+    }
+
+    axes[0] = center[0] / norm;
+    axes[1] = center[1] / norm;
+    axes[2] = center[2] / norm;
+    norm = sqrtf(axes[0] * axes[0] + axes[1] * axes[1]);
+    axes[3] = -axes[1] / norm;
+    axes[4] = axes[0] / norm;
+    axes[5] = 0;
+    axes[6] = axes[1] * axes[5] - axes[2] * axes[4];
+    axes[7] = axes[2] * axes[3] - axes[0] * axes[5];
+    axes[8] = axes[0] * axes[4] - axes[1] * axes[3];
+
+    *rectify = false;
+    for (uint32_t i = 0; i < 9; i++) {
+        float identity = (i % 4 == 0) ? 1.0f : 0.0f;
+        error = fmaxf(error, fabsf(rotation[i] - identity));
+        error = fmaxf(error, fabsf(axes[i] - identity));
+    }
+    if (error > DJI_STEREO_DEPTH_RECTIFIED_TOLERANCE) {
+        *rectify = true;
+    }
+
+    /* Left: x_left = A^T * x_rect. Right: x_right = R * A^T * x_rect, translation does not move rays. */
+    for (uint32_t i = 0; i < 3; i++) {
+        for (uint32_t j = 0; j < 3; j++) {
+            rectToCamera[0][i * 3 + j] = axes[j * 3 + i];
+        }
+    }
+    for (uint32_t i = 0; i < 3; i++) {
+        for (uint32_t j = 0; j < 3; j++) {
+            rectToCamera[1][i * 3 + j] = rotation[i * 3 + 0] * rectToCamera[0][0 * 3 + j] +
+                                         rotation[i * 3 + 1] * rectToCamera[0][1 * 3 + j] +
+                                         rotation[i * 3 + 2] * rectToCamera[0][2 * 3 + j];
+        }
+    }
+}
+
+/* Nearest source pixel of each pixel of the downscaled rectified image, -1 outside of the camera image. */
+static void DjiStereoDepth_BuildLut(const float *intrinsics, const float *rectToCamera, float focalLength,
+                                    const float *principalPoint, uint32_t sourceWidth, uint32_t sourceHeight,
+                                    uint32_t downscale, int32_t *lut)
+{
+    uint32_t width = sourceWidth / downscale;
+    uint32_t height = sourceHeight / downscale;
+    float ray[3];
+    float camera[3];
+    float u;
+    float v;
+    int32_t column;
+    int32_t row;
+
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            ray[0] = (((float) x + 0.5f) * (float) downscale - 0.5f - principalPoint[0]) / focalLength;
+            ray[1] = (((float) y + 0.5f) * (float) downscale - 0.5f - principalPoint[1]) / focalLength;
+            ray[2] = 1;
+            for (uint32_t i = 0; i < 3; i++) {
+                camera[i] = rectToCamera[i * 3] * ray[0] + rectToCamera[i * 3 + 1] * ray[1] +
+                            rectToCamera[i * 3 + 2] * ray[2];
+            }
+
+            lut[y * width + x] = -1;
+            if (camera[2] <= 0) {
+                continue;
+            }
+            u = intrinsics[0] * camera[0] / camera[2] + intrinsics[1] * camera[1] / camera[2] + intrinsics[2];
+            v = intrinsics[4] * camera[1] / camera[2] + intrinsics[5];
+            column = (int32_t) lroundf(u);
+            row = (int32_t) lroundf(v);
+            if (column >= 0 && row >= 0 && column < (int32_t) sourceWidth && row < (int32_t) sourceHeight) {
+                lut[y * width + x] = row * (int32_t) sourceWidth + column;
+            }
+        }
+    }
+}
+
+/* Box filter of downscale x downscale pixels. */
+static void DjiStereoDepth_Downscale(const uint8_t *source, uint32_t sourceWidth, uint32_t downscale,
+                                     uint32_t width, uint32_t height, uint8_t *output)
+{
+    uint32_t shift = downscale == 4 ? 4 : 2;
+
+    for (uint32_t y = 0; y < height; y++) {
+        const uint8_t *sourceRow = source + (size_t) y * downscale * sourceWidth;
+        uint8_t *outputRow = output + (size_t) y * width;
+        for (uint32_t x = 0; x < width; x++) {
+            uint32_t sum = 0;
+            for (uint32_t i = 0; i < downscale; i++) {
+                for (uint32_t j = 0; j < downscale; j++) {
+                    sum += sourceRow[(size_t) i * sourceWidth + x * downscale + j];
+                }
+            }
+            outputRow[x] = (uint8_t) ((sum + (1u << (shift - 1))) >> shift);
+        }
+    }
+}
+
+/**
+ * @brief Add or remove the absolute differences of one row to the column sums of every disparity, where the
+ * left pixel x is compared with the right pixel x - d.
+ */
+static void DjiStereoDepth_AccumulateRow(uint16_t *columnSum, uint32_t stride, const uint8_t *left,
+                                         const uint8_t *right, uint32_t width, uint32_t disparityNum, bool add)
+{
+    for (uint32_t d = 0; d < disparityNum; d++) {
+        uint16_t *sum = columnSum + (size_t) d * stride;
+        uint32_t x = d;
+
+#if defined(__SSE2__)
+        const __m128i zero = _mm_setzero_si128();
+        for (; x + 16 <= width; x += 16) {
+            __m128i l = _mm_loadu_si128((const __m128i *) (left + x));
+            __m128i r = _mm_loadu_si128((const __m128i *) (right + x - d));
+            __m128i diff = _mm_or_si128(_mm_subs_epu8(l, r), _mm_subs_epu8(r, l));
+            __m128i low = _mm_unpacklo_epi8(diff, zero);
+            __m128i high = _mm_unpackhi_epi8(diff, zero);
+            __m128i sumLow = _mm_loadu_si128((const __m128i *) (sum + x));
+            __m128i sumHigh = _mm_loadu_si128((const __m128i *) (sum + x + 8));
+            if (add) {
+                sumLow = _mm_add_epi16(sumLow, low);
+                sumHigh = _mm_add_epi16(sumHigh, high);
+            } else {
+                sumLow = _mm_sub_epi16(sumLow, low);
+                sumHigh = _mm_sub_epi16(sumHigh, high);
+            }
+            _mm_storeu_si128((__m128i *) (sum + x), sumLow);
+            _mm_storeu_si128((__m128i *) (sum + x + 8), sumHigh);
+        }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        for (; x + 16 <= width; x += 16) {
+            uint8x16_t diff = vabdq_u8(vld1q_u8(left + x), vld1q_u8(right + x - d));
+            uint16x8_t sumLow = vld1q_u16(sum + x);
+            uint16x8_t sumHigh = vld1q_u16(sum + x + 8);
+            if (add) {
+                sumLow = vaddw_u8(sumLow, vget_low_u8(diff));
+                sumHigh = vaddw_u8(sumHigh, vget_high_u8(diff));
+            } else {
+                sumLow = vsubw_u8(sumLow, vget_low_u8(diff));
+                sumHigh = vsubw_u8(sumHigh, vget_high_u8(diff));
+            }
+            vst1q_u16(sum + x, sumLow);
+            vst1q_u16(sum + x + 8, sumHigh);
+        }
+#endif
+        //scalar tail
+        for (; x < width; x++) {
+            uint16_t diff = (uint16_t) (left[x] > right[x - d] ? left[x] - right[x - d] : right[x - d] - left[x]);
+            sum[x] = (uint16_t) (add ? sum[x] + diff : sum[x] - diff);
+        }
+    }
+}
+
+/* Grow a buffer to size bytes, capacity is the current size in bytes. */
+static bool DjiStereoDepth_Reserve(void **buffer, uint32_t *capacity, uint32_t size)
+{
+    void *newBuffer;
+
+    if (*buffer != nullptr && *capacity >= size) {
+        return true;
+    }
+
+    newBuffer = malloc(size);
+    if (newBuffer == nullptr) {
+        return false;
+    }
+    free(*buffer);
+    *buffer = newBuffer;
+    *capacity = size;
+
+    return true;
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,175 @@
+/**
+ ********************************************************************
+ * @file    dji_stereo_depth.hpp
+ * @brief   This is the header file for "dji_stereo_depth.cpp", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef DJI_STEREO_DEPTH_H
+#define DJI_STEREO_DEPTH_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <atomic>
+#include "dji_perception.h"
+#include "dji_platform.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Cost sums of the built-in matcher are 16 bit, which limits the block to 11 x 11 pixels. */
+#define DJI_STEREO_DEPTH_BLOCK_SIZE_MAX        11
+#define DJI_STEREO_DEPTH_DOWNSCALE_MAX         4
+#define DJI_STEREO_DEPTH_WORKER_NUM_MAX        8
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum {
+    /*! Built-in SAD block matcher, available without OpenCV. */
+    DJI_STEREO_DEPTH_MATCHER_SAD = 0,
+    /*! cv::StereoBM and cv::StereoSGBM, only if built with OpenCV. */
+    DJI_STEREO_DEPTH_MATCHER_OPENCV_BM,
+    DJI_STEREO_DEPTH_MATCHER_OPENCV_SGBM,
+} E_DjiStereoDepthMatcher;
+
+typedef struct {
+    E_DjiStereoDepthMatcher matcher;
+    /*! Depth maps published per direction and second, pairs arriving faster are skipped. */
+    uint32_t targetRateHz;
+    /*! Disparity search range in pixels of the camera images, it shrinks with the downscale. */
+    uint32_t disparityNum;
+    /*! Odd edge length of the matching block, at most DJI_STEREO_DEPTH_BLOCK_SIZE_MAX for the built-in matcher. */
+    uint32_t blockSize;
+    /*! Percent by which the best cost has to beat all other disparities, 0 to disable the check. */
+    uint32_t uniquenessRatio;
+    /*! Largest downscale of the images before matching, 1, 2 or 4. The downscale of each direction adapts
+     *  between 1 and this to hold the target rate. */
+    uint32_t maxDownscale;
+    /*! Tasks matching tiles next to the depth task, 0 to match on the depth task only. */
+    uint32_t workerNum;
+    /*! Rows of the matched image per tile. */
+    uint32_t tileRows;
+    /*! Largest difference of the timestamps of a left and a right image to be paired, in the unit of
+     *  T_DjiPerceptionImageInfo.timeStamp. Both images of a pair carry the same capture time, so 0 by default. */
+    uint64_t maxPairTimeDiff;
+} T_DjiStereoDepthConfig;
+
+typedef struct {
+    E_DjiPerceptionDirection direction;
+    /*! Timestamp and sequence of the left image of the pair. */
+    uint64_t timeStamp;
+    uint16_t sequence;
+    uint32_t width;
+    uint32_t height;
+    uint32_t downscale;
+    /*! Focal length in pixels of the depth map and baseline, depth = focalLength * baseline / disparity. */
+    float focalLength;
+    float baseline;
+    /*! width * height depths in the unit of translationLeftInRight, 0 where no disparity was found. */
+    float *depth;
+    /*! Time from the completion of the pair to the publication, and time spent matching. */
+    uint32_t latencyUs;
+    uint32_t processTimeUs;
+} T_DjiStereoDepthMap;
+
+/* Called on the depth task, the map is only valid during the call. */
+typedef void (*DjiStereoDepthCallback)(const T_DjiStereoDepthMap *depthMap, void *userData);
+
+typedef struct {
+    uint64_t imageCount;
+    uint64_t pairCount;
+    /*! Images replaced before a partner close enough in time arrived. */
+    uint64_t unpairedImageCount;
+    /*! Pairs skipped to hold the target rate or replaced by a newer pair while the depth task was busy. */
+    uint64_t skippedPairCount;
+    uint64_t depthMapCount;
+    uint64_t processTimeUs;
+    uint32_t processTimeMaxUs;
+    uint64_t latencyUs;
+    uint32_t latencyMaxUs;
+    uint32_t downscale;
+} T_DjiStereoDepthStatistics;
+
+/**
+ * @brief Pairs the left and right images of the stereo cameras by timestamp, rectifies them with the camera
+ * parameters and matches them into depth maps. Matching is split into row tiles shared by the depth task and
+ * the worker tasks. Each direction is paced to the target rate and downscaled when matching can not keep up.
+ */
+class DJIStereoDepth {
+public:
+    DJIStereoDepth();
+    ~DJIStereoDepth();
+
+    T_DjiReturnCode init(const T_DjiStereoDepthConfig &config, DjiStereoDepthCallback callback, void *userData);
+    void cleanup();
+
+    /* Call before images are added. Directions without parameters are matched as if already rectified, with a
+     * focal length and a baseline of 1. */
+    T_DjiReturnCode setCameraParameters(const T_DjiPerceptionCameraParametersPacket &packet);
+    /* Copy an 8 bit image of a stereo camera, called from one thread only. */
+    T_DjiReturnCode addImage(const T_DjiPerceptionImageInfo &info, const uint8_t *data, uint32_t dataLen);
+
+    void getStatistics(E_DjiPerceptionDirection direction, T_DjiStereoDepthStatistics *statistics);
+
+private:
+    DJIStereoDepth(const DJIStereoDepth &);
+    DJIStereoDepth &operator=(const DJIStereoDepth &);
+
+    struct T_Direction;
+    struct T_Worker;
+
+    static void *depthTask(void *arg);
+    static void *workerTask(void *arg);
+    void processPair(T_Direction *direction, uint64_t nowUs);
+    bool prepareImages(T_Direction *direction, uint32_t downscale);
+    T_DjiReturnCode prepareWorkers(uint32_t width, uint32_t disparityNum);
+    void matchTiles(T_Worker *worker);
+    void matchTileSad(T_Worker *worker, uint32_t tile);
+    void matchTileOpenCv(T_Worker *worker, uint32_t tile);
+    void adaptDownscale(T_Direction *direction, uint64_t nowUs);
+
+    T_DjiStereoDepthConfig config;
+    DjiStereoDepthCallback callback;
+    void *userData;
+    T_Direction *directions;
+    T_DjiMutexHandle mutex;
+    T_DjiSemaHandle pairSema;
+    T_DjiTaskHandle task;
+    T_DjiSemaHandle taskExitSema;
+    volatile bool taskStop;
+    uint32_t nextDirection;
+
+    /* Tile job of the pair being matched, set by the depth task while the workers wait. */
+    T_Worker *workers;
+    T_DjiSemaHandle jobDoneSema;
+    const uint8_t *jobLeft;
+    const uint8_t *jobRight;
+    float *jobDepth;
+    uint32_t jobWidth;
+    uint32_t jobHeight;
+    uint32_t jobDisparityNum;
+    float jobFocalBaseline;
+    uint32_t jobTileCount;
+    std::atomic<uint32_t> jobNextTile;
+};
+
+/* Exported functions --------------------------------------------------------*/
+void DjiStereoDepth_GetDefaultConfig(T_DjiStereoDepthConfig *config);
+
+#endif // DJI_STEREO_DEPTH_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
@@ -0,0 +1,310 @@
+/**
+ ********************************************************************
+ * @file    dji_stereo_image_buffer.cpp
+ * @brief   Per camera triple buffers handing the perception stereo images from the SDK callback to
+ * one consumer.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_stereo_image_buffer.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "dji_logger.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define DJI_STEREO_IMAGE_SLOT_NUM              3
+#define DJI_STEREO_IMAGE_SLOT_INDEX_MASK       0x3
+/* Set in the ready slot index while the consumer has not taken the image. */
+#define DJI_STEREO_IMAGE_SLOT_FRESH            0x4
+/* Sequence steps of at least half the range are reordered or restarted streams, not gaps. */
+#define DJI_STEREO_IMAGE_SEQUENCE_GAP_MAX      0x8000
+
+/* Private types -------------------------------------------------------------*/
+struct DJIStereoImageBuffer::T_Camera {
+    T_DjiStereoImage slots[DJI_STEREO_IMAGE_SLOT_NUM];
+    /* Owned by the producer. */
+    uint32_t writeSlot;
+    bool sequenceValid;
+    uint16_t lastSequence;
+    /* Owned by the consumer. */
+    uint32_t readSlot;
+    /* Swapped by both, slot index and DJI_STEREO_IMAGE_SLOT_FRESH. */
+    std::atomic<uint32_t> readySlot;
+
+    std::atomic<uint64_t> imageCount;
+    std::atomic<uint64_t> overwrittenImageCount;
+    std::atomic<uint64_t> sequenceGapCount;
+    std::atomic<uint64_t> droppedImageCount;
+    std::atomic<uint32_t> allocCount;
+    std::atomic<uint64_t> pushTimeUs;
+    std::atomic<uint32_t> pushTimeMaxUs;
+};
+
+/* Private values -------------------------------------------------------------*/
+
+/* Private functions declaration ---------------------------------------------*/
+
+/* Exported functions definition ---------------------------------------------*/
+int32_t DjiStereoImageBuffer_GetCameraIndex(uint32_t cameraPosition)
+{
+    if (cameraPosition >= RECTIFY_DOWN_LEFT && cameraPosition <= RECTIFY_REAR_RIGHT) {
+        return (int32_t) (cameraPosition - RECTIFY_DOWN_LEFT);
+    }
+    if (cameraPosition >= RECTIFY_UP_LEFT && cameraPosition <= RECTIFY_RIGHT_RIGHT) {
+        return (int32_t) (cameraPosition - RECTIFY_UP_LEFT) + 2 * DJI_PERCEPTION_RECTIFY_UP;
+    }
+
+    return -1;
+}
+
+DJIStereoImageBuffer::DJIStereoImageBuffer()
+    : cameras(nullptr),
+      notifySema(nullptr),
+      nextCameraIndex(0)
+{
+}
+
+DJIStereoImageBuffer::~DJIStereoImageBuffer()
+{
+    cleanup();
+}
+
+T_DjiReturnCode DJIStereoImageBuffer::init()
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiReturnCode returnCode;
+
+    if (cameras != nullptr) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+    }
+
+    cameras = new(std::nothrow) T_Camera[DJI_STEREO_IMAGE_CAMERA_NUM]();
+    if (cameras == nullptr) {
+        USER_LOG_ERROR("Malloc stereo image cameras failed.");
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+
+    for (uint32_t i = 0; i < DJI_STEREO_IMAGE_CAMERA_NUM; i++) {
+        for (uint32_t j = 0; j < DJI_STEREO_IMAGE_SLOT_NUM; j++) {
+            cameras[i].slots[j].cameraIndex = i;
+            cameras[i].slots[j].direction = (E_DjiPerceptionDirection) (i / 2);
+        }
+        cameras[i].writeSlot = 0;
+        cameras[i].readySlot.store(1, std::memory_order_relaxed);
+        cameras[i].readSlot = 2;
+    }
+
+    returnCode = osalHandler->SemaphoreCreate(0, &notifySema);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Create stereo image semaphore failed, error code: 0x%08llX", returnCode);
+        notifySema = nullptr;
+        cleanup();
+        return returnCode;
+    }
+    nextCameraIndex = 0;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+void DJIStereoImageBuffer::cleanup()
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    if (cameras != nullptr) {
+        for (uint32_t i = 0; i < DJI_STEREO_IMAGE_CAMERA_NUM; i++) {
+            for (uint32_t j = 0; j < DJI_STEREO_IMAGE_SLOT_NUM; j++) {
+                free(cameras[i].slots[j].data);
+            }
+        }
+        delete[] cameras;
+        cameras = nullptr;
+    }
+
+    if (notifySema != nullptr) {
+        osalHandler->SemaphoreDestroy(notifySema);
+        notifySema = nullptr;
+    }
+}
+
+T_DjiReturnCode DJIStereoImageBuffer::pushImage(const T_DjiPerceptionImageInfo &info, const uint8_t *data,
+                                                uint32_t dataLen)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    int32_t cameraIndex = DjiStereoImageBuffer_GetCameraIndex(info.dataType);
+    T_DjiStereoImage *slot;
+    T_Camera *camera;
+    uint64_t startTimeUs = 0;
+    uint64_t endTimeUs = 0;
+    uint32_t pushTimeUs;
+    uint32_t allocSlotNum;
+    uint32_t readySlot;
+    uint16_t sequenceGap;
+
+    if (cameras == nullptr) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE;
+    }
+    if (cameraIndex < 0 || data == nullptr || dataLen == 0) {
+        /* Without a known camera position the image is counted for the direction the SDK reported. */
+        if (cameraIndex >= 0) {
+            cameras[cameraIndex].droppedImageCount.fetch_add(1, std::memory_order_relaxed);
+        } else if (info.rawInfo.direction < IMAGE_MAX_DIRECTION_NUM) {
+            cameras[2 * info.rawInfo.direction].droppedImageCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    osalHandler->GetTimeUs(&startTimeUs);
+    camera = &cameras[cameraIndex];
+
+    if (camera->sequenceValid) {
+        sequenceGap = (uint16_t) (info.sequence - camera->lastSequence - 1);
+        if (sequenceGap != 0 && sequenceGap < DJI_STEREO_IMAGE_SEQUENCE_GAP_MAX) {
+            camera->sequenceGapCount.fetch_add(sequenceGap, std::memory_order_relaxed);
+        }
+    }
+    camera->sequenceValid = true;
+    camera->lastSequence = info.sequence;
+
+    /* Before the first image is published the consumer touches no slot, so all three are sized at once. Later
+     * only the write slot, owned by this callback, is grown. */
+    allocSlotNum = camera->imageCount.load(std::memory_order_relaxed) == 0 ? DJI_STEREO_IMAGE_SLOT_NUM : 1;
+    for (uint32_t i = 0; i < allocSlotNum; i++) {
+        slot = &camera->slots[(camera->writeSlot + i) % DJI_STEREO_IMAGE_SLOT_NUM];
+        if (slot->capacity >= dataLen) {
+            continue;
+        }
+        free(slot->data);
+        slot->data = (uint8_t *) malloc(dataLen);
+        if (slot->data == nullptr) {
+            slot->capacity = 0;
+            camera->droppedImageCount.fetch_add(1, std::memory_order_relaxed);
+            return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+        }
+        slot->capacity = dataLen;
+        camera->allocCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    slot = &camera->slots[camera->writeSlot];
+    memcpy(slot->data, data, dataLen);
+    slot->dataLen = dataLen;
+    slot->info = info;
+    slot->receiveTimeUs = startTimeUs;
+
+    readySlot = camera->readySlot.exchange(camera->writeSlot | DJI_STEREO_IMAGE_SLOT_FRESH,
+                                           std::memory_order_acq_rel);
+    camera->writeSlot = readySlot & DJI_STEREO_IMAGE_SLOT_INDEX_MASK;
+    if (readySlot & DJI_STEREO_IMAGE_SLOT_FRESH) {
+        camera->overwrittenImageCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    camera->imageCount.fetch_add(1, std::memory_order_relaxed);
+    osalHandler->SemaphorePost(notifySema);
+
+    osalHandler->GetTimeUs(&endTimeUs);
+    pushTimeUs = endTimeUs > startTimeUs ? (uint32_t) (endTimeUs - startTimeUs) : 0;
+    camera->pushTimeUs.fetch_add(pushTimeUs, std::memory_order_relaxed);
+    if (pushTimeUs > camera->pushTimeMaxUs.load(std::memory_order_relaxed)) {
+        camera->pushTimeMaxUs.store(pushTimeUs, std::memory_order_relaxed);
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+const T_DjiStereoImage *DJIStereoImageBuffer::acquireImage(uint32_t cameraIndex)
+{
+    T_Camera *camera;
+    uint32_t readySlot;
+
+    if (cameras == nullptr || cameraIndex >= DJI_STEREO_IMAGE_CAMERA_NUM) {
+        return nullptr;
+    }
+
+    camera = &cameras[cameraIndex];
+    if ((camera->readySlot.load(std::memory_order_relaxed) & DJI_STEREO_IMAGE_SLOT_FRESH) == 0) {
+        return nullptr;
+    }
+
+    /* Only the producer changes the ready slot in between, and it always leaves a fresh image there. */
+    readySlot = camera->readySlot.exchange(camera->readSlot, std::memory_order_acq_rel);
+    camera->readSlot = readySlot & DJI_STEREO_IMAGE_SLOT_INDEX_MASK;
+
+    return &camera->slots[camera->readSlot];
+}
+
+const T_DjiStereoImage *DJIStereoImageBuffer::waitImage(uint32_t timeoutMs)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    const T_DjiStereoImage *image = acquireNextImage();
+
+    /* The semaphore is posted per pushed image, overwritten images leave posts without an image to take. */
+    if (image == nullptr && notifySema != nullptr) {
+        osalHandler->SemaphoreTimedWait(notifySema, timeoutMs);
+        image = acquireNextImage();
+    }
+
+    return image;
+}
+
+void DJIStereoImageBuffer::getStatistics(E_DjiPerceptionDirection direction,
+                                         T_DjiStereoImageBufferStatistics *statistics) const
+{
+    const T_Camera *camera;
+    uint32_t pushTimeMaxUs;
+
+    memset(statistics, 0, sizeof(T_DjiStereoImageBufferStatistics));
+    if (cameras == nullptr || (uint32_t) direction >= IMAGE_MAX_DIRECTION_NUM) {
+        return;
+    }
+
+    for (uint32_t i = 2 * direction; i < 2 * (uint32_t) direction + 2; i++) {
+        camera = &cameras[i];
+        statistics->imageCount += camera->imageCount.load(std::memory_order_relaxed);
+        statistics->overwrittenImageCount += camera->overwrittenImageCount.load(std::memory_order_relaxed);
+        statistics->sequenceGapCount += camera->sequenceGapCount.load(std::memory_order_relaxed);
+        statistics->droppedImageCount += camera->droppedImageCount.load(std::memory_order_relaxed);
+        statistics->allocCount += camera->allocCount.load(std::memory_order_relaxed);
+        statistics->pushTimeUs += camera->pushTimeUs.load(std::memory_order_relaxed);
+        pushTimeMaxUs = camera->pushTimeMaxUs.load(std::memory_order_relaxed);
+        if (pushTimeMaxUs > statistics->pushTimeMaxUs) {
+            statistics->pushTimeMaxUs = pushTimeMaxUs;
+        }
+    }
+}
+
+/* Private functions definition-----------------------------------------------*/
+const T_DjiStereoImage *DJIStereoImageBuffer::acquireNextImage()
+{
+    const T_DjiStereoImage *image;
+    uint32_t cameraIndex;
+
+    for (uint32_t i = 0; i < DJI_STEREO_IMAGE_CAMERA_NUM; i++) {
+        cameraIndex = (nextCameraIndex + i) % DJI_STEREO_IMAGE_CAMERA_NUM;
+        image = acquireImage(cameraIndex);
+        if (image != nullptr) {
+            nextCameraIndex = (cameraIndex + 1) % DJI_STEREO_IMAGE_CAMERA_NUM;
+            return image;
+        }
+    }
+
+    return nullptr;
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,115 @@
+/**
+ ********************************************************************
+ * @file    dji_stereo_image_buffer.hpp
+ * @brief   This is the header file for "dji_stereo_image_buffer.cpp", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef DJI_STEREO_IMAGE_BUFFER_H
+#define DJI_STEREO_IMAGE_BUFFER_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <atomic>
+#include "dji_perception.h"
+#include "dji_platform.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* A left and a right camera per direction. */
+#define DJI_STEREO_IMAGE_CAMERA_NUM            (IMAGE_MAX_DIRECTION_NUM * 2)
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+    T_DjiPerceptionImageInfo info;
+    /*! Index of the camera, 2 * direction for the left and 2 * direction + 1 for the right camera. */
+    uint32_t cameraIndex;
+    E_DjiPerceptionDirection direction;
+    /*! Local time the image callback was entered. */
+    uint64_t receiveTimeUs;
+    uint32_t dataLen;
+    uint32_t capacity;
+    uint8_t *data;
+} T_DjiStereoImage;
+
+typedef struct {
+    uint64_t imageCount;
+    /*! Images replaced by a newer one before the consumer took them. */
+    uint64_t overwrittenImageCount;
+    /*! Images missing in the sequence numbers delivered by the SDK. */
+    uint64_t sequenceGapCount;
+    /*! Images dropped as empty, unallocatable or of unknown camera position, the latter by raw info direction. */
+    uint64_t droppedImageCount;
+    /*! Buffers (re)allocated, three per camera for the first image and one per image larger than before. */
+    uint32_t allocCount;
+    /*! Time spent in pushImage. */
+    uint64_t pushTimeUs;
+    uint32_t pushTimeMaxUs;
+} T_DjiStereoImageBufferStatistics;
+
+/**
+ * @brief Hands the stereo images of all cameras from the perception image callback to one consumer thread.
+ * Each camera has a triple buffer: the callback fills its write slot and swaps it with the ready slot, the
+ * consumer swaps the ready slot with its read slot. Slots are sized from the first image of the camera, so
+ * streaming takes no lock and allocates no memory. The consumer always gets the newest image of a camera,
+ * older ones are counted as overwritten.
+ */
+class DJIStereoImageBuffer {
+public:
+    DJIStereoImageBuffer();
+    ~DJIStereoImageBuffer();
+
+    T_DjiReturnCode init();
+    /* Only while no image is pushed and no consumer waits. */
+    void cleanup();
+
+    /* Called from the perception image callback only. */
+    T_DjiReturnCode pushImage(const T_DjiPerceptionImageInfo &info, const uint8_t *data, uint32_t dataLen);
+
+    /**
+     * @brief Newest unread image of a camera, or nullptr if none. It stays valid until the next acquireImage or
+     * waitImage of the same camera.
+     */
+    const T_DjiStereoImage *acquireImage(uint32_t cameraIndex);
+    /* Wait until any camera has an unread image and acquire it, cameras are served round robin. */
+    const T_DjiStereoImage *waitImage(uint32_t timeoutMs);
+
+    /* Statistics of the left and the right camera of a direction added up. */
+    void getStatistics(E_DjiPerceptionDirection direction, T_DjiStereoImageBufferStatistics *statistics) const;
+
+private:
+    DJIStereoImageBuffer(const DJIStereoImageBuffer &);
+    DJIStereoImageBuffer &operator=(const DJIStereoImageBuffer &);
+
+    struct T_Camera;
+
+    const T_DjiStereoImage *acquireNextImage();
+
+    T_Camera *cameras;
+    T_DjiSemaHandle notifySema;
+    uint32_t nextCameraIndex;
+};
+
+/* Exported functions --------------------------------------------------------*/
+/* Camera index of DjiPerceptionImageInfo.dataType, -1 for an unknown camera position. */
+int32_t DjiStereoImageBuffer_GetCameraIndex(uint32_t cameraPosition);
+
+#endif // DJI_STEREO_IMAGE_BUFFER_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
@@ -28,6 +28,9 @@
 #include "dji_logger.h"
 #include "dji_perception.h"
 #include "test_perception.hpp"
+#include "dji_stereo_image_buffer.hpp"
+#include "dji_stereo_depth.hpp"
+#include "utils/util_misc.h"
 #include <iostream>
 
 #ifdef OPEN_CV_INSTALLED
@@ -41,15 +44,10 @@
 #define USER_PERCEPTION_TASK_STACK_SIZE    (1024)
 #define USER_PERCEPTION_DIRECTION_NUM      (12)
 #define FPS_STRING_LEN                     (50)
+#define USER_PERCEPTION_WAIT_TIMEOUT_MS    (100)
+#define USER_PERCEPTION_DEPTH_LOG_PERIOD_US (1000000)
 
 /* Private types -------------------------------------------------------------*/
-typedef struct {
-    T_DjiPerceptionImageInfo info;
-    uint8_t *imageRawBuffer;
-    T_DjiMutexHandle mutex;
-    bool gotData;
-} T_DjiTestStereoImagePacket;
-
 typedef struct {
     E_DjiPerceptionCameraPosition cameraPosition;
     char const *name;
@@ -62,11 +60,11 @@ typedef struct {
 
 /* Private values -------------------------------------------------------------*/
 static T_DjiTaskHandle s_stereoImageThread;
-static T_DjiTestStereoImagePacket s_stereoImagePacket = {
-    .info           = {0},
-    .imageRawBuffer = nullptr,
-    .mutex          = nullptr,
-    .gotData        = false};
+static bool s_stereoImageTaskStop = false;
+static T_DjiSemaHandle s_stereoImageTaskExitSema = nullptr;
+static DJIStereoImageBuffer s_stereoImageBuffer;
+static DJIStereoDepth s_stereoDepth;
+static uint64_t s_stereoDepthLogTimeUs[IMAGE_MAX_DIRECTION_NUM] = {0};
 
 static const T_DjiTestPerceptionDirectionName directionName[] = {
     {.direction = DJI_PERCEPTION_RECTIFY_DOWN, .name = "down"},
@@ -96,6 +94,8 @@ static const T_DjiTestPerceptionCameraPositionName positionName[] = {
 static void DjiTest_PerceptionImageCallback(T_DjiPerceptionImageInfo imageInfo, uint8_t *imageRawBuffer,
                                             uint32_t bufferLen);
 static void *DjiTest_StereoImagesDisplayTask(void *arg);
+static void DjiTest_StereoDepthCallback(const T_DjiStereoDepthMap *depthMap, void *userData);
+static void DjiTest_PrintStereoImageStatistics(E_DjiPerceptionDirection direction);
 
 /* Exported functions definition ---------------------------------------------*/
 void DjiUser_RunStereoVisionViewSample(void)
@@ -105,6 +105,7 @@ void DjiUser_RunStereoVisionViewSample(void)
     char isQuit;
     T_DjiReturnCode returnCode;
     T_DjiPerceptionCameraParametersPacket cameraParametersPacket = {0};
+    T_DjiStereoDepthConfig depthConfig;
 
     PerceptionSample *perceptionSample;
     try {
@@ -113,17 +114,24 @@ void DjiUser_RunStereoVisionViewSample(void)
         return;
     }
 
-    returnCode = osalHandler->MutexCreate(&s_stereoImagePacket.mutex);
+    returnCode = s_stereoImageBuffer.init();
     if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("Crete mutex failed, return code:0x%08X", returnCode);
+        USER_LOG_ERROR("Init stereo image buffer failed, return code:0x%08X", returnCode);
         goto DeletePerception;
     }
 
+    __atomic_store_n(&s_stereoImageTaskStop, false, __ATOMIC_RELAXED);
+    returnCode = osalHandler->SemaphoreCreate(0, &s_stereoImageTaskExitSema);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Create task exit semaphore failed, return code:0x%08X", returnCode);
+        goto CleanupBuffer;
+    }
+
     returnCode = osalHandler->TaskCreate("user_perception_task", DjiTest_StereoImagesDisplayTask,
-                                         USER_PERCEPTION_TASK_STACK_SIZE, &s_stereoImagePacket, &s_stereoImageThread);
+                                         USER_PERCEPTION_TASK_STACK_SIZE, &s_stereoImageBuffer, &s_stereoImageThread);
     if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
         USER_LOG_ERROR("Crete task failed, return code:0x%08X", returnCode);
-        goto DestroyMutex;
+        goto DestroyExitSema;
     }
 
     returnCode = DjiPerception_GetStereoCameraParameters(&cameraParametersPacket);
@@ -174,6 +182,14 @@ void DjiUser_RunStereoVisionViewSample(void)
         osalHandler->TaskSleepMs(100);
     }
 
+    DjiStereoDepth_GetDefaultConfig(&depthConfig);
+    returnCode = s_stereoDepth.init(depthConfig, DjiTest_StereoDepthCallback, nullptr);
+    if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        s_stereoDepth.setCameraParameters(cameraParametersPacket);
+    } else {
+        USER_LOG_WARN("Init stereo depth failed, only show the images, return code:0x%08X", returnCode);
+    }
+
     while (true) {
         std::cout
             << "| Available commands:                                            |"
@@ -259,26 +275,32 @@ void DjiUser_RunStereoVisionViewSample(void)
             case 'd':
                 USER_LOG_INFO("Unsubscribe down stereo camera pair images.");
                 perceptionSample->UnSubscribeDownImage();
+                DjiTest_PrintStereoImageStatistics(DJI_PERCEPTION_RECTIFY_DOWN);
                 break;
             case 'f':
                 USER_LOG_INFO("Unsubscribe front stereo camera pair images.");
                 perceptionSample->UnSubscribeFrontImage();
+                DjiTest_PrintStereoImageStatistics(DJI_PERCEPTION_RECTIFY_FRONT);
                 break;
             case 'r':
                 USER_LOG_INFO("Unsubscribe rear stereo camera pair images.");
                 perceptionSample->UnSubscribeRearImage();
+                DjiTest_PrintStereoImageStatistics(DJI_PERCEPTION_RECTIFY_REAR);
                 break;
             case 'u':
                 USER_LOG_INFO("Unsubscribe up stereo camera pair images.");
                 perceptionSample->UnSubscribeUpImage();
+                DjiTest_PrintStereoImageStatistics(DJI_PERCEPTION_RECTIFY_UP);
                 break;
             case 'l':
                 USER_LOG_INFO("Unsubscribe left stereo camera pair images.");
                 perceptionSample->UnSubscribeLeftImage();
+                DjiTest_PrintStereoImageStatistics(DJI_PERCEPTION_RECTIFY_LEFT);
                 break;
             case 't':
                 USER_LOG_INFO("Unsubscribe right stereo camera pair images.");
                 perceptionSample->UnSubscribeRightImage();
+                DjiTest_PrintStereoImageStatistics(DJI_PERCEPTION_RECTIFY_RIGHT);
                 break;
             default:
                 break;
@@ -289,16 +311,25 @@ void DjiUser_RunStereoVisionViewSample(void)
     }
 
 DestroyTask:
+    /*! Deinit perception first, no image may be pushed once the display task is gone and the buffers are freed. */
+    delete perceptionSample;
+    perceptionSample = nullptr;
+
+    __atomic_store_n(&s_stereoImageTaskStop, true, __ATOMIC_RELEASE);
+    osalHandler->SemaphoreWait(s_stereoImageTaskExitSema);
     returnCode = osalHandler->TaskDestroy(s_stereoImageThread);
     if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
         USER_LOG_ERROR("Destroy task failed, return code:0x%08X", returnCode);
     }
 
-DestroyMutex:
-    returnCode = osalHandler->MutexDestroy(s_stereoImagePacket.mutex);
-    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("Destroy mutex failed, return code:0x%08X", returnCode);
-    }
+    s_stereoDepth.cleanup();
+
+DestroyExitSema:
+    osalHandler->SemaphoreDestroy(s_stereoImageTaskExitSema);
+    s_stereoImageTaskExitSema = nullptr;
+
+CleanupBuffer:
+    s_stereoImageBuffer.cleanup();
 
 DeletePerception:
     delete perceptionSample;
@@ -308,30 +339,24 @@ DeletePerception:
 static void DjiTest_PerceptionImageCallback(T_DjiPerceptionImageInfo imageInfo, uint8_t *imageRawBuffer,
                                             uint32_t bufferLen)
 {
-    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiReturnCode returnCode;
+
+    if (imageRawBuffer == nullptr) {
+        return;
+    }
 
-    USER_LOG_INFO("image info : dataId(%d) seq(%d) timestamp(%llu) datatype(%d) index(%d) h(%d) w(%d) dir(%d) "
-                  "bpp(%d) bufferlen(%d)", imageInfo.dataId, imageInfo.sequence, imageInfo.timeStamp,
-                  imageInfo.dataType,
-                  imageInfo.rawInfo.index, imageInfo.rawInfo.height, imageInfo.rawInfo.width,
-                  imageInfo.rawInfo.direction,
-                  imageInfo.rawInfo.bpp, bufferLen);
-
-    if (imageRawBuffer) {
-        osalHandler->MutexLock(s_stereoImagePacket.mutex);
-        s_stereoImagePacket.info = imageInfo;
-        if (s_stereoImagePacket.imageRawBuffer) osalHandler->Free(s_stereoImagePacket.imageRawBuffer);
-        s_stereoImagePacket.imageRawBuffer = (uint8_t *) osalHandler->Malloc(bufferLen);
-        memcpy(s_stereoImagePacket.imageRawBuffer, imageRawBuffer, bufferLen);
-        s_stereoImagePacket.gotData = true;
-        osalHandler->MutexUnlock(s_stereoImagePacket.mutex);
+    returnCode = s_stereoImageBuffer.pushImage(imageInfo, imageRawBuffer, bufferLen);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_WARN("Drop image: dataType(%d) seq(%d) bufferlen(%d), return code:0x%08X", imageInfo.dataType,
+                      imageInfo.sequence, bufferLen, returnCode);
     }
 }
 
 static void *DjiTest_StereoImagesDisplayTask(void *arg)
 {
-    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
-    auto *pack = (T_DjiTestStereoImagePacket *) arg;
+    auto *buffer = (DJIStereoImageBuffer *) arg;
+    const T_DjiStereoImage *image;
+#ifdef OPEN_CV_INSTALLED
     char nameStr[32] = {0};
     char fpsStr[20] = "FPS: ";
     int fps = 0;
@@ -340,35 +365,31 @@ static void *DjiTest_StereoImagesDisplayTask(void *arg)
     double timeFess[USER_PERCEPTION_DIRECTION_NUM] = {0};
     int count[USER_PERCEPTION_DIRECTION_NUM] = {1};
     char showFpsString[USER_PERCEPTION_DIRECTION_NUM][FPS_STRING_LEN] = {0};
-    int i = 0;
+    uint32_t i = 0;
+#else
+    uint32_t imageCount = 0;
+#endif
 
-    while (true) {
-        osalHandler->TaskSleepMs(1);
-#ifdef OPEN_CV_INSTALLED
-        /*! Get data here */
-        osalHandler->MutexLock(pack->mutex);
-        if (!pack->gotData) {
-            osalHandler->MutexUnlock(pack->mutex);
+    while (!__atomic_load_n(&s_stereoImageTaskStop, __ATOMIC_ACQUIRE)) {
+        image = buffer->waitImage(USER_PERCEPTION_WAIT_TIMEOUT_MS);
+        if (image == nullptr) {
             continue;
         }
-        cv::Mat cv_img_stereo = cv::Mat(pack->info.rawInfo.height, pack->info.rawInfo.width, CV_8U);
-        int copySize = pack->info.rawInfo.height * pack->info.rawInfo.width;
-        if (pack->imageRawBuffer) {
-            memcpy(cv_img_stereo.data, pack->imageRawBuffer, copySize);
-            osalHandler->Free(pack->imageRawBuffer);
-            pack->imageRawBuffer = NULL;
+        s_stereoDepth.addImage(image->info, image->data, image->dataLen);
+#ifdef OPEN_CV_INSTALLED
+        /*! The image stays valid until the next image of its camera is acquired, so it is shown without a copy. */
+        if ((uint64_t) image->info.rawInfo.height * image->info.rawInfo.width > image->dataLen) {
+            continue;
         }
+        cv::Mat cv_img_stereo = cv::Mat(image->info.rawInfo.height, image->info.rawInfo.width, CV_8U, image->data);
 
         for (i = 0; i < sizeof(positionName) / sizeof(T_DjiTestPerceptionCameraPositionName); ++i) {
-            if (positionName[i].cameraPosition == pack->info.dataType) {
+            if (positionName[i].cameraPosition == image->info.dataType) {
                 sprintf(nameStr, "Image position: %s", positionName[i].name);
                 break;
             }
         }
 
-        pack->gotData = false;
-        osalHandler->MutexUnlock(pack->mutex);
-
         if (i < USER_PERCEPTION_DIRECTION_NUM) {
             /*! Calculate frame rate */
             timeNow[i] = (double) cv::getTickCount();
@@ -390,10 +411,72 @@ static void *DjiTest_StereoImagesDisplayTask(void *arg)
         cv::imshow(nameStr, cv_img_stereo);
         cv::waitKey(1);
 #else
-        osalHandler->TaskSleepMs(1000);
-        USER_LOG_WARN("Please install opencv to run this stereo image display sample.");
+        if (imageCount++ % 100 == 0) {
+            USER_LOG_INFO("image info : dataId(%d) seq(%d) timestamp(%llu) datatype(%d) index(%d) h(%d) w(%d) "
+                          "dir(%d) bpp(%d) bufferlen(%d)", image->info.dataId, image->info.sequence,
+                          image->info.timeStamp, image->info.dataType, image->info.rawInfo.index,
+                          image->info.rawInfo.height, image->info.rawInfo.width, image->info.rawInfo.direction,
+                          image->info.rawInfo.bpp, image->dataLen);
+            USER_LOG_WARN("Please install opencv to run this stereo image display sample.");
+        }
 #endif
     }
+
+    DjiPlatform_GetOsalHandler()->SemaphorePost(s_stereoImageTaskExitSema);
+
+    return nullptr;
+}
+
+/**
+ * @brief Log the depth in the middle of the map and the share of pixels with a depth, once per second and
+ * direction.
+ */
+static void DjiTest_StereoDepthCallback(const T_DjiStereoDepthMap *depthMap, void *userData)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    uint32_t pixelNum = depthMap->width * depthMap->height;
+    uint32_t validNum = 0;
+    uint64_t nowUs = 0;
+
+    USER_UTIL_UNUSED(userData);
+
+    osalHandler->GetTimeUs(&nowUs);
+    if (nowUs - s_stereoDepthLogTimeUs[depthMap->direction] < USER_PERCEPTION_DEPTH_LOG_PERIOD_US) {
+        return;
+    }
+    s_stereoDepthLogTimeUs[depthMap->direction] = nowUs;
+
+    for (uint32_t i = 0; i < pixelNum; i++) {
+        if (depthMap->depth[i] > 0) {
+            validNum++;
+        }
+    }
+
+    USER_LOG_INFO("[%-05s] depth %ux%u (1/%u) seq(%d) center %.3f, valid %u%%, latency %u us, process %u us",
+                  directionName[depthMap->direction].name, depthMap->width, depthMap->height, depthMap->downscale,
+                  depthMap->sequence, depthMap->depth[depthMap->height / 2 * depthMap->width + depthMap->width / 2],
+                  pixelNum > 0 ? validNum * 100 / pixelNum : 0, depthMap->latencyUs, depthMap->processTimeUs);
+}
+
+static void DjiTest_PrintStereoImageStatistics(E_DjiPerceptionDirection direction)
+{
+    T_DjiStereoImageBufferStatistics statistics;
+    T_DjiStereoDepthStatistics depthStatistics;
+
+    s_stereoImageBuffer.getStatistics(direction, &statistics);
+    USER_LOG_INFO("[%-05s] images %llu, overwritten %llu, sequence gaps %llu, dropped %llu, allocs %u, "
+                  "push avg %llu us max %u us.", directionName[direction].name, statistics.imageCount,
+                  statistics.overwrittenImageCount, statistics.sequenceGapCount, statistics.droppedImageCount,
+                  statistics.allocCount, statistics.imageCount ? statistics.pushTimeUs / statistics.imageCount : 0,
+                  statistics.pushTimeMaxUs);
+
+    s_stereoDepth.getStatistics(direction, &depthStatistics);
+    USER_LOG_INFO("[%-05s] pairs %llu, unpaired images %llu, skipped pairs %llu, depth maps %llu (1/%u), "
+                  "latency avg %llu us max %u us.", directionName[direction].name, depthStatistics.pairCount,
+                  depthStatistics.unpairedImageCount, depthStatistics.skippedPairCount, depthStatistics.depthMapCount,
+                  depthStatistics.downscale,
+                  depthStatistics.depthMapCount ? depthStatistics.latencyUs / depthStatistics.depthMapCount : 0,
+                  depthStatistics.latencyMaxUs);
 }
 
 /****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -24,21 +24,47 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "test_radar_entry.hpp"
+#include "dji_radar_frame_processor.hpp"
+#include "dji_radar_fusion.hpp"
 #include "dji_logger.h"
+#include "dji_fc_subscription.h"
+#include "fc_subscription/test_fc_subscription_snapshot.h"
+#include "utils/util_misc.h"
 #include <iostream>
+#include <cmath>
 #include <ctime>
 #include <chrono>
+#include <cstddef>
+#include <vector>
 /* Private constants ---------------------------------------------------------*/
+#define RADAR_SWEEP_TASK_STACK_SIZE      2048
+#define RADAR_SWEEP_WAIT_TIMEOUT_MS      100
+#define RADAR_FUSION_QUERY_PERIOD_MS     20
+#define RADAR_FUSION_LOG_PERIOD_MS       1000
+#define RADAR_FUSION_FILE_PATH_LEN_MAX   256
 
 /* Private types -------------------------------------------------------------*/
+typedef struct {
+    T_DjiFcSubscriptionQuaternion quaternion;
+    T_DjiFcSubscriptionPositionVO positionVo;
+} T_DjiTestRadarFusionPoseSnapshot;
 
 /* Private values -------------------------------------------------------------*/
+static DJIRadarFrameProcessor *s_radarFrameProcessor = nullptr;
+static volatile bool s_radarSweepTaskStop = false;
+static T_DjiSemaHandle s_radarSweepTaskExitSema = nullptr;
+static const T_DjiTestFcSubscriptionSnapshotTopicConfig s_radarFusionPoseTopics[] = {
+    {DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION,  DJI_DATA_SUBSCRIPTION_TOPIC_50_HZ,
+        sizeof(T_DjiFcSubscriptionQuaternion), offsetof(T_DjiTestRadarFusionPoseSnapshot, quaternion)},
+    {DJI_FC_SUBSCRIPTION_TOPIC_POSITION_VO, DJI_DATA_SUBSCRIPTION_TOPIC_50_HZ,
+        sizeof(T_DjiFcSubscriptionPositionVO), offsetof(T_DjiTestRadarFusionPoseSnapshot, positionVo)},
+};
 
 /* Private functions declaration ---------------------------------------------*/
 static void DjiTest_PerceptionRadarCallback(E_DjiPerceptionRadarPosition radarPosition,
                                              uint8_t *radarDataBuffer, uint32_t bufferLen);
-static float parseVelocity(uint16_t velocity);
-static float parseBeamAngle(uint16_t beamAngle);
+static void *DjiTest_RadarSweepTask(void *arg);
+static void DjiTest_RunRadarFusion(int durationS);
 /* Exported functions definition ---------------------------------------------*/
 void DjiUser_RunRadarDataSubscriptionSample(void) {
     int subscriptionDuration = 10;
@@ -46,6 +72,8 @@ void DjiUser_RunRadarDataSubscriptionSample(void) {
     char inputChar;
     T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
     E_DjiPerceptionRadarPosition curPosition = MAX_RADAR_NUM;
+    T_DjiTaskHandle sweepTask;
+    T_DjiRadarFrameProcessorStatistics statistics;
     returnCode = DjiPerception_Init();
     if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
         USER_LOG_ERROR("DjiPerception Init failed");
@@ -81,6 +109,10 @@ inputAgain:
         << "| [r] Subscribe to rightward millimeter wave radar data.       |"
         <<
         std::endl;
+    std::cout
+        << "| [a] Fuse all millimeter wave radars into an occupancy grid.  |"
+        <<
+        std::endl;
     std::cout
         << "| [q] quit                                                     |"
         <<
@@ -112,12 +144,41 @@ inputAgain:
             USER_LOG_INFO("Subscribe to rightward millimeter wave radar data.");
             curPosition = RADAR_POSITION_RIGHT;
             break;
+        case 'a':
+            USER_LOG_INFO("Fuse all millimeter wave radars into an occupancy grid.");
+            DjiTest_RunRadarFusion(subscriptionDuration);
+            goto inputAgain;
         case 'q':
             goto endOfSample;
         default:
             goto inputAgain;
     }
 
+    s_radarFrameProcessor = new DJIRadarFrameProcessor(curPosition);
+    returnCode = s_radarFrameProcessor->init();
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Init radar frame processor failed");
+        delete s_radarFrameProcessor;
+        s_radarFrameProcessor = nullptr;
+        goto inputAgain;
+    }
+
+    s_radarSweepTaskStop = false;
+    returnCode = osalHandler->SemaphoreCreate(0, &s_radarSweepTaskExitSema);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Create radar sweep exit semaphore failed");
+        delete s_radarFrameProcessor;
+        s_radarFrameProcessor = nullptr;
+        goto inputAgain;
+    }
+
+    returnCode = osalHandler->TaskCreate("radar_sweep", DjiTest_RadarSweepTask, RADAR_SWEEP_TASK_STACK_SIZE,
+                                         s_radarFrameProcessor, &sweepTask);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Create radar sweep task failed");
+        goto taskCreateFailed;
+    }
+
     returnCode = DjiPerception_SubscribeRadarData(curPosition, DjiTest_PerceptionRadarCallback);
     if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
         USER_LOG_ERROR("Request to subscribe radar data failed");
@@ -132,6 +193,21 @@ subscribeFailed:
     if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
         USER_LOG_ERROR("Request to unsubscribe Radar data failed");
     }
+
+    s_radarSweepTaskStop = true;
+    osalHandler->SemaphoreWait(s_radarSweepTaskExitSema);
+    osalHandler->TaskDestroy(sweepTask);
+
+taskCreateFailed:
+    osalHandler->SemaphoreDestroy(s_radarSweepTaskExitSema);
+    s_radarFrameProcessor->getStatistics(&statistics);
+    USER_LOG_INFO("Radar packets %llu, sweeps %llu, incomplete %llu, dropped %llu, points %llu, gated %llu, "
+                  "process time %llu us.",
+                  statistics.packetCount, statistics.sweepCount, statistics.incompleteSweepCount,
+                  statistics.droppedSweepCount, statistics.rawPointCount, statistics.gatedPointCount,
+                  statistics.processTimeUs);
+    delete s_radarFrameProcessor;
+    s_radarFrameProcessor = nullptr;
     goto inputAgain;
 
 endOfSample:
@@ -145,46 +221,174 @@ endOfSample:
 /* Private functions definition-----------------------------------------------*/
 static void DjiTest_PerceptionRadarCallback(E_DjiPerceptionRadarPosition radarPosition,
                                              uint8_t *radarDataBuffer, uint32_t bufferLen) {
-    T_DjiRadarDataFrame* radarData;
-    radarData = (T_DjiRadarDataFrame*)radarDataBuffer;
+    DJIRadarFrameProcessor *processor = s_radarFrameProcessor;
 
     if (radarDataBuffer == nullptr || bufferLen == 0) {
         USER_LOG_ERROR("Invalid radar data: buffer=%p len=%u", radarDataBuffer, bufferLen);
         return;
     }
 
-    USER_LOG_INFO("RadarData[pos:%d][len:%u][units:%u][pack:%u/%u]",
-                  radarPosition,
-                  bufferLen,
-                  static_cast<unsigned>(radarData->headInfo.dataLen),
-                  static_cast<unsigned>(radarData->headInfo.curPack),
-                  static_cast<unsigned>(radarData->headInfo.packNum));
-
-    for (uint32_t i = 0; i < radarData->headInfo.dataLen; ++i) {
-        const T_DjiRadarCloudUnit* unit = &radarData->data[i];
-        float azimuth = unit->azimuth / 1000.0f - 2*3.14;
-        float elevation = unit->elevation / 1000.0f - 2*3.14;
-        float radius = unit->radius / 100.0f;
-        float energy = unit->ene / 100.0f;
-        float velocity = parseVelocity(unit->base_info.velocity);
-        uint8_t snr = unit->base_info.snr;
-        float beamAngle = parseBeamAngle(unit->base_info.beamAngle);
-
-        USER_LOG_INFO(
-            "[Unit%d] Azimuth=%.3f(rad), Elevation=%.3f(rad), Radius=%.2f(m), Energy=%.2f, "
-            "Velocity=%.2f(m/s), SNR=%u(dB), BeamAngle=%.2f(deg)",
-            i, azimuth, elevation, radius, energy, velocity, snr, beamAngle);
+    if (processor == nullptr || processor->getPosition() != radarPosition) {
+        return;
     }
+
+    processor->processPacket(radarDataBuffer, bufferLen);
 }
 
-static float parseVelocity(uint16_t velocity) {
-    return (velocity - 32767) / 100.0f;
+/**
+ * @brief Log one line per converted sweep instead of one per point, with the nearest and the fastest point.
+ */
+static void *DjiTest_RadarSweepTask(void *arg) {
+    DJIRadarFrameProcessor *processor = (DJIRadarFrameProcessor *) arg;
+    T_DjiRadarPointCloud *frame;
+
+    while (!s_radarSweepTaskStop) {
+        frame = processor->waitFrame(RADAR_SWEEP_WAIT_TIMEOUT_MS);
+        if (frame == nullptr) {
+            continue;
+        }
+
+        float nearestRange = 0;
+        float fastestVelocity = 0;
+        for (uint32_t i = 0; i < frame->pointCount; ++i) {
+            float range = sqrtf(frame->x[i] * frame->x[i] + frame->y[i] * frame->y[i] + frame->z[i] * frame->z[i]);
+            if (i == 0 || range < nearestRange) {
+                nearestRange = range;
+            }
+            if (fabsf(frame->velocity[i]) > fabsf(fastestVelocity)) {
+                fastestVelocity = frame->velocity[i];
+            }
+        }
+
+        USER_LOG_INFO("RadarSweep[pos:%d][seq:%u][pack:%u/%u][points:%u/%u] nearest=%.2f(m), fastest=%.2f(m/s)",
+                      frame->position, frame->sequence, frame->receivedPackNum, frame->packNum,
+                      frame->pointCount, frame->rawPointCount, nearestRange, fastestVelocity);
+        processor->releaseFrame(frame);
+    }
+
+    DjiPlatform_GetOsalHandler()->SemaphorePost(s_radarSweepTaskExitSema);
+
+    return nullptr;
 }
-static float parseBeamAngle(uint16_t beamAngle) {
-    if (beamAngle <= 450) {
-        return beamAngle / 10.0f;
-    } else {
-        return (beamAngle / 10.0f) - 90.0f;
+
+/**
+ * @brief Fuse the sweeps of all radars with the attitude and the VO position of the aircraft, and query the
+ * occupancy grid at the rate a planner would.
+ */
+static void DjiTest_RunRadarFusion(int durationS)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiReturnCode returnCode;
+    T_DjiRadarFusionConfig config;
+    T_DjiRadarFusionStatistics statistics;
+    T_DjiRadarFusionPose pose;
+    T_DjiRadarOccupancyGrid grid;
+    T_DjiTestRadarFusionPoseSnapshot snapshot;
+    T_DjiTestFcSubscriptionSnapshotInfo snapshotInfo;
+    char curFileDirPath[RADAR_FUSION_FILE_PATH_LEN_MAX];
+    char extrinsicsPath[RADAR_FUSION_FILE_PATH_LEN_MAX + 32];
+    uint64_t lastPoseTimestampUs = 0;
+    uint32_t elapsedMs;
+    DJIRadarFusion fusion;
+
+    DjiRadarFusion_GetDefaultConfig(&config);
+    returnCode = fusion.init(config);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Init radar fusion failed, error code: 0x%08llX", returnCode);
+        return;
+    }
+
+    returnCode = DjiUserUtil_GetCurrentFileDirPath(__FILE__, RADAR_FUSION_FILE_PATH_LEN_MAX, curFileDirPath);
+    if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        snprintf(extrinsicsPath, sizeof(extrinsicsPath), "%s/config/radar_extrinsics.json", curFileDirPath);
+        returnCode = fusion.loadExtrinsics(extrinsicsPath);
+    }
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_WARN("Load radar extrinsics failed, use the nominal mountings.");
+    }
+
+    returnCode = DjiFcSubscription_Init();
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Init data subscription module failed, error code: 0x%08llX", returnCode);
+        return;
+    }
+
+    returnCode = DjiTest_FcSubscriptionSnapshotInit(s_radarFusionPoseTopics, UTIL_ARRAY_SIZE(s_radarFusionPoseTopics),
+                                                    sizeof(T_DjiTestRadarFusionPoseSnapshot));
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Init pose snapshot failed, error code: 0x%08llX", returnCode);
+        goto snapshotInitFailed;
+    }
+
+    returnCode = fusion.start();
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Start radar fusion failed, error code: 0x%08llX", returnCode);
+        goto fusionStartFailed;
+    }
+
+    {
+        std::vector<float> occupancy(config.gridWidth * config.gridWidth);
+        std::vector<float> height(config.gridWidth * config.gridWidth);
+
+        grid.occupancy = occupancy.data();
+        grid.height = height.data();
+        for (elapsedMs = 0; elapsedMs < (uint32_t) durationS * 1000; elapsedMs += RADAR_FUSION_QUERY_PERIOD_MS) {
+            osalHandler->TaskSleepMs(RADAR_FUSION_QUERY_PERIOD_MS);
+
+            returnCode = DjiTest_FcSubscriptionSnapshotGet(&snapshot, sizeof(snapshot), &snapshotInfo);
+            if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS &&
+                snapshotInfo.ageMs[0] != DJI_TEST_FC_SUBSCRIPTION_SNAPSHOT_AGE_INVALID &&
+                snapshotInfo.ageMs[1] != DJI_TEST_FC_SUBSCRIPTION_SNAPSHOT_AGE_INVALID &&
+                snapshotInfo.timestampUs[0] != lastPoseTimestampUs) {
+                lastPoseTimestampUs = snapshotInfo.timestampUs[0];
+                pose.timeUs = snapshotInfo.snapshotTimeUs - (uint64_t) snapshotInfo.ageMs[0] * 1000;
+                pose.quaternion[0] = snapshot.quaternion.q0;
+                pose.quaternion[1] = snapshot.quaternion.q1;
+                pose.quaternion[2] = snapshot.quaternion.q2;
+                pose.quaternion[3] = snapshot.quaternion.q3;
+                pose.position[0] = snapshot.positionVo.x;
+                pose.position[1] = snapshot.positionVo.y;
+                pose.position[2] = snapshot.positionVo.z;
+                fusion.updatePose(pose);
+            }
+
+            returnCode = fusion.getOccupancyGrid(&grid);
+            if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS ||
+                (elapsedMs + RADAR_FUSION_QUERY_PERIOD_MS) % RADAR_FUSION_LOG_PERIOD_MS != 0) {
+                continue;
+            }
+
+            float nearestDistance = -1;
+            int32_t center = (int32_t) grid.gridWidth / 2;
+            for (uint32_t i = 0; i < grid.gridWidth * grid.gridWidth; ++i) {
+                if (grid.occupancy[i] < config.hitWeight / 2) {
+                    continue;
+                }
+                float north = (float) ((int32_t) (i / grid.gridWidth) - center) * grid.cellSize;
+                float east = (float) ((int32_t) (i % grid.gridWidth) - center) * grid.cellSize;
+                float distance = sqrtf(north * north + east * east);
+                if (nearestDistance < 0 || distance < nearestDistance) {
+                    nearestDistance = distance;
+                }
+            }
+
+            USER_LOG_INFO("RadarFusion[origin:%d,%d] occupied cells=%u, nearest=%.2f(m)",
+                          grid.originCellNorth, grid.originCellEast, grid.occupiedCellCount, nearestDistance);
+        }
     }
+
+    fusion.stop();
+    fusion.getStatistics(&statistics);
+    USER_LOG_INFO("Radar fusion sweeps %llu, stale %llu, poseless %llu, points %llu, rejected %llu, "
+                  "update max %u us, queries %llu, query max %u us.",
+                  statistics.sweepCount, statistics.staleSweepCount, statistics.poselessSweepCount,
+                  statistics.pointCount, statistics.rejectedPointCount, statistics.updateTimeMaxUs,
+                  statistics.queryCount, statistics.queryTimeMaxUs);
+
+fusionStartFailed:
+    DjiTest_FcSubscriptionSnapshotDeInit();
+snapshotInitFailed:
+    DjiFcSubscription_DeInit();
+    fusion.cleanup();
 }
 /****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,167 @@
+/**
+ ********************************************************************
+ * @file    dji_camera_capture_core.c
+ * @brief   The file selects the camera capture backend and dispatches to its operation item.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include <dji_logger.h>
+
+#include "dji_camera_capture_core.h"
+#include "dji_camera_capture_pipe.h"
+#include "dji_camera_capture_file.h"
+#include "dji_camera_capture_v4l2.h"
+#include "dji_platform.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define DJI_CAMERA_CAPTURE_DEFAULT_WIDTH            1280
+#define DJI_CAMERA_CAPTURE_DEFAULT_HEIGHT           720
+#define DJI_CAMERA_CAPTURE_DEFAULT_FRAME_RATE       25
+#define DJI_CAMERA_CAPTURE_DEFAULT_BIT_RATE         2000000
+
+/* Private types -------------------------------------------------------------*/
+
+/* Private functions declaration ---------------------------------------------*/
+
+/* Private values ------------------------------------------------------------*/
+//@formatter:off
+static const T_DjiCameraCaptureOptItem s_cameraCaptureOpt[] =
+{
+    {
+        DJI_CAMERA_CAPTURE_TYPE_PIPE,
+        "pipe",
+        DjiCameraCapture_Open_Pipe,
+        DjiCameraCapture_ReadStream_Pipe,
+        DjiCameraCapture_TakePhoto_Pipe,
+        DjiCameraCapture_Close_Pipe,
+    },
+    {
+        DJI_CAMERA_CAPTURE_TYPE_FILE,
+        "file",
+        DjiCameraCapture_Open_File,
+        DjiCameraCapture_ReadStream_File,
+        DjiCameraCapture_TakePhoto_File,
+        DjiCameraCapture_Close_File,
+    },
+    {
+        DJI_CAMERA_CAPTURE_TYPE_V4L2,
+        "v4l2",
+        DjiCameraCapture_Open_V4l2,
+        DjiCameraCapture_ReadStream_V4l2,
+        DjiCameraCapture_TakePhoto_V4l2,
+        DjiCameraCapture_Close_V4l2,
+    },
+};
+static const uint32_t s_cameraCaptureOptCount = sizeof(s_cameraCaptureOpt) / sizeof(T_DjiCameraCaptureOptItem);
+//@formatter:on
+
+/* Exported functions definition ---------------------------------------------*/
+void DjiCameraCapture_GetDefaultConfig(T_DjiCameraCaptureConfig *config)
+{
+    memset(config, 0, sizeof(T_DjiCameraCaptureConfig));
+    config->width = DJI_CAMERA_CAPTURE_DEFAULT_WIDTH;
+    config->height = DJI_CAMERA_CAPTURE_DEFAULT_HEIGHT;
+    config->frameRate = DJI_CAMERA_CAPTURE_DEFAULT_FRAME_RATE;
+    config->bitRate = DJI_CAMERA_CAPTURE_DEFAULT_BIT_RATE;
+    strncpy(config->capturePath, "/dev/video0", sizeof(config->capturePath) - 1);
+    strncpy(config->encoderPath, "/dev/video11", sizeof(config->encoderPath) - 1);
+    strncpy(config->jpegEncoderPath, "/dev/video31", sizeof(config->jpegEncoderPath) - 1);
+    config->replayLoop = true;
+}
+
+T_DjiReturnCode DjiCameraCapture_Open(E_DjiCameraCaptureType captureType, const T_DjiCameraCaptureConfig *config,
+                                      T_DjiCameraCaptureHandle *pCaptureHandle)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiCameraCaptureHandle captureHandle;
+    T_DjiReturnCode returnCode;
+    uint32_t optIndex;
+
+    for (optIndex = 0; optIndex < s_cameraCaptureOptCount; optIndex++) {
+        if (s_cameraCaptureOpt[optIndex].captureType == captureType) {
+            break;
+        }
+    }
+
+    if (optIndex == s_cameraCaptureOptCount || config == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    captureHandle = osalHandler->Malloc(sizeof(T_DjiCameraCapture));
+    if (captureHandle == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+
+    memset(captureHandle, 0, sizeof(T_DjiCameraCapture));
+    captureHandle->config = *config;
+    captureHandle->captureOptItem = s_cameraCaptureOpt[optIndex];
+
+    returnCode = captureHandle->captureOptItem.openFunc(captureHandle);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Open %s camera capture error: 0x%08llX", captureHandle->captureOptItem.name, returnCode);
+        osalHandler->Free(captureHandle);
+        return returnCode;
+    }
+
+    USER_LOG_INFO("Camera capture %s opened, %ux%u@%u", captureHandle->captureOptItem.name,
+                  config->width, config->height, config->frameRate);
+    *pCaptureHandle = captureHandle;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiCameraCapture_ReadStream(T_DjiCameraCaptureHandle captureHandle, uint8_t *data, uint32_t len,
+                                            uint32_t *realLen, uint32_t timeoutMs)
+{
+    if (captureHandle == NULL || captureHandle->captureOptItem.readStreamFunc == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    return captureHandle->captureOptItem.readStreamFunc(captureHandle, data, len, realLen, timeoutMs);
+}
+
+T_DjiReturnCode DjiCameraCapture_TakePhoto(T_DjiCameraCaptureHandle captureHandle, const char *filePath)
+{
+    if (captureHandle == NULL || captureHandle->captureOptItem.takePhotoFunc == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    return captureHandle->captureOptItem.takePhotoFunc(captureHandle, filePath);
+}
+
+T_DjiReturnCode DjiCameraCapture_Close(T_DjiCameraCaptureHandle captureHandle)
+{
+    T_DjiReturnCode returnCode;
+
+    if (captureHandle == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    returnCode = captureHandle->captureOptItem.closeFunc(captureHandle);
+    DjiPlatform_GetOsalHandler()->Free(captureHandle);
+
+    return returnCode;
+}
+
+/* Private functions definition-----------------------------------------------*/
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,102 @@
+/**
+ ********************************************************************
+ * @file    dji_camera_capture_core.h
+ * @brief   This is the header file for "dji_camera_capture_core.c", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef DJI_CAMERA_CAPTURE_CORE_H
+#define DJI_CAMERA_CAPTURE_CORE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <dji_typedef.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define DJI_CAMERA_CAPTURE_PATH_LEN_MAX        256
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum {
+    /*! libcamera-vid/libcamera-still child processes, the stream is restarted for every photo. */
+    DJI_CAMERA_CAPTURE_TYPE_PIPE = 0,
+    /*! Replay of a recorded Annex-B H.264 file, no camera needed. */
+    DJI_CAMERA_CAPTURE_TYPE_FILE,
+    /*! V4L2 capture device feeding a V4L2 memory-to-memory H.264 encoder through DMABUF. */
+    DJI_CAMERA_CAPTURE_TYPE_V4L2,
+} E_DjiCameraCaptureType;
+
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+    uint32_t frameRate;
+    uint32_t bitRate;
+    /*! Capture device for the V4L2 backend, e.g. "/dev/video0". */
+    char capturePath[DJI_CAMERA_CAPTURE_PATH_LEN_MAX];
+    /*! H.264 memory-to-memory encoder for the V4L2 backend, e.g. "/dev/video11" on Raspberry Pi. */
+    char encoderPath[DJI_CAMERA_CAPTURE_PATH_LEN_MAX];
+    /*! JPEG memory-to-memory encoder used for stills by the V4L2 backend, e.g. "/dev/video31" on Raspberry Pi. */
+    char jpegEncoderPath[DJI_CAMERA_CAPTURE_PATH_LEN_MAX];
+    /*! Annex-B H.264 file for the file backend. */
+    char replayFilePath[DJI_CAMERA_CAPTURE_PATH_LEN_MAX];
+    /*! Restart the replay file from the beginning at its end. */
+    bool replayLoop;
+} T_DjiCameraCaptureConfig;
+
+struct _DjiCameraCapture;
+
+typedef struct {
+    E_DjiCameraCaptureType captureType;
+    const char *name;
+    T_DjiReturnCode (*openFunc)(struct _DjiCameraCapture *captureHandle);
+    T_DjiReturnCode (*readStreamFunc)(struct _DjiCameraCapture *captureHandle, uint8_t *data, uint32_t len,
+                                      uint32_t *realLen, uint32_t timeoutMs);
+    T_DjiReturnCode (*takePhotoFunc)(struct _DjiCameraCapture *captureHandle, const char *filePath);
+    T_DjiReturnCode (*closeFunc)(struct _DjiCameraCapture *captureHandle);
+} T_DjiCameraCaptureOptItem;
+
+typedef struct _DjiCameraCapture {
+    T_DjiCameraCaptureConfig config;
+    T_DjiCameraCaptureOptItem captureOptItem;
+    /*! Increased by the backend whenever the stream restarts, pending stream data must be dropped then. */
+    uint32_t streamGeneration;
+    void *privData;
+} T_DjiCameraCapture, *T_DjiCameraCaptureHandle;
+
+/* Exported functions --------------------------------------------------------*/
+void DjiCameraCapture_GetDefaultConfig(T_DjiCameraCaptureConfig *config);
+T_DjiReturnCode DjiCameraCapture_Open(E_DjiCameraCaptureType captureType, const T_DjiCameraCaptureConfig *config,
+                                      T_DjiCameraCaptureHandle *pCaptureHandle);
+T_DjiReturnCode DjiCameraCapture_ReadStream(T_DjiCameraCaptureHandle captureHandle, uint8_t *data, uint32_t len,
+                                            uint32_t *realLen, uint32_t timeoutMs);
+T_DjiReturnCode DjiCameraCapture_TakePhoto(T_DjiCameraCaptureHandle captureHandle, const char *filePath);
+T_DjiReturnCode DjiCameraCapture_Close(T_DjiCameraCaptureHandle captureHandle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DJI_CAMERA_CAPTURE_CORE_H
+
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
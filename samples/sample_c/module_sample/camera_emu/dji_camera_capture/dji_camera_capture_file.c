@@ -0,0 +1,150 @@
+/**
+ ********************************************************************
+ * @file    dji_camera_capture_file.c
+ * @brief   The file defines the camera capture backend replaying a recorded Annex-B H.264 file at the configured
+ * bit rate, used to run the camera samples without a camera.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_camera_capture_file.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <dji_logger.h>
+#include "dji_platform.h"
+#include "utils/util_misc.h"
+
+/* Private constants ---------------------------------------------------------*/
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    int fd;
+    uint64_t startTimeUs;
+    uint64_t deliveredBytes;
+    uint32_t bytesPerSecond;
+    uint32_t bytesPerFrame;
+} T_DjiCameraCaptureFile;
+
+/* Private functions declaration ---------------------------------------------*/
+
+/* Private values ------------------------------------------------------------*/
+
+/* Exported functions definition ---------------------------------------------*/
+T_DjiReturnCode DjiCameraCapture_Open_File(struct _DjiCameraCapture *captureHandle)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiCameraCaptureConfig *config = &captureHandle->config;
+    T_DjiCameraCaptureFile *captureFile;
+
+    if (config->bitRate == 0 || config->frameRate == 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    captureFile = osalHandler->Malloc(sizeof(T_DjiCameraCaptureFile));
+    if (captureFile == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+    memset(captureFile, 0, sizeof(T_DjiCameraCaptureFile));
+
+    captureFile->fd = open(config->replayFilePath, O_RDONLY | O_CLOEXEC);
+    if (captureFile->fd < 0) {
+        USER_LOG_ERROR("Open replay file %s error: %s", config->replayFilePath, strerror(errno));
+        osalHandler->Free(captureFile);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+    }
+
+    captureFile->bytesPerSecond = config->bitRate / 8;
+    captureFile->bytesPerFrame = USER_UTIL_MAX(captureFile->bytesPerSecond / config->frameRate, 1);
+    osalHandler->GetTimeUs(&captureFile->startTimeUs);
+    captureHandle->privData = captureFile;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Deliver the file in chunks of one average frame, paced against the time the stream started so the
+ * replay keeps the configured bit rate without accumulating drift.
+ */
+T_DjiReturnCode DjiCameraCapture_ReadStream_File(struct _DjiCameraCapture *captureHandle, uint8_t *data, uint32_t len,
+                                                 uint32_t *realLen, uint32_t timeoutMs)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiCameraCaptureFile *captureFile = captureHandle->privData;
+    uint64_t currentTimeUs;
+    uint64_t dueTimeUs;
+    ssize_t readLen;
+
+    *realLen = 0;
+
+    dueTimeUs = captureFile->startTimeUs + captureFile->deliveredBytes * 1000000 / captureFile->bytesPerSecond;
+    osalHandler->GetTimeUs(&currentTimeUs);
+    if (currentTimeUs < dueTimeUs) {
+        if (dueTimeUs - currentTimeUs > (uint64_t) timeoutMs * 1000) {
+            osalHandler->TaskSleepMs(timeoutMs);
+            return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+        }
+        usleep((useconds_t) (dueTimeUs - currentTimeUs));
+    }
+
+    readLen = read(captureFile->fd, data, USER_UTIL_MIN(len, captureFile->bytesPerFrame));
+    if (readLen < 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    if (readLen == 0) {
+        if (!captureHandle->config.replayLoop) {
+            osalHandler->TaskSleepMs(timeoutMs);
+            return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+        }
+        lseek(captureFile->fd, 0, SEEK_SET);
+        captureHandle->streamGeneration++;
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    captureFile->deliveredBytes += (uint64_t) readLen;
+    *realLen = (uint32_t) readLen;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiCameraCapture_TakePhoto_File(struct _DjiCameraCapture *captureHandle, const char *filePath)
+{
+    USER_UTIL_UNUSED(captureHandle);
+    USER_LOG_WARN("Replay capture can not take photo %s", filePath);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
+}
+
+T_DjiReturnCode DjiCameraCapture_Close_File(struct _DjiCameraCapture *captureHandle)
+{
+    T_DjiCameraCaptureFile *captureFile = captureHandle->privData;
+
+    close(captureFile->fd);
+    DjiPlatform_GetOsalHandler()->Free(captureFile);
+    captureHandle->privData = NULL;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/* Private functions definition-----------------------------------------------*/
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,57 @@
+/**
+ ********************************************************************
+ * @file    dji_camera_capture_file.h
+ * @brief   This is the header file for "dji_camera_capture_file.c", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef DJI_CAMERA_CAPTURE_FILE_H
+#define DJI_CAMERA_CAPTURE_FILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <dji_typedef.h>
+#include "dji_camera_capture_core.h"
+
+/* Exported constants --------------------------------------------------------*/
+
+
+/* Exported types ------------------------------------------------------------*/
+
+
+/* Exported functions --------------------------------------------------------*/
+T_DjiReturnCode DjiCameraCapture_Open_File(struct _DjiCameraCapture *captureHandle);
+T_DjiReturnCode DjiCameraCapture_ReadStream_File(struct _DjiCameraCapture *captureHandle, uint8_t *data, uint32_t len,
+                                                 uint32_t *realLen, uint32_t timeoutMs);
+T_DjiReturnCode DjiCameraCapture_TakePhoto_File(struct _DjiCameraCapture *captureHandle, const char *filePath);
+T_DjiReturnCode DjiCameraCapture_Close_File(struct _DjiCameraCapture *captureHandle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DJI_CAMERA_CAPTURE_FILE_H
+
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
@@ -0,0 +1,238 @@
+/**
+ ********************************************************************
+ * @file    dji_camera_capture_pipe.c
+ * @brief   The file defines the camera capture backend reading H.264 from a libcamera-vid child process.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_camera_capture_pipe.h"
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dji_logger.h>
+#include "dji_platform.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define DJI_CAMERA_CAPTURE_PIPE_CMD_LEN_MAX     512
+/* Minimum time between two starts of libcamera-vid, so a camera that keeps failing is not restarted in a loop. */
+#define DJI_CAMERA_CAPTURE_PIPE_RESTART_INTERVAL_MS     1000
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    FILE *stream;
+    T_DjiMutexHandle streamMutex;
+    char videoCmd[DJI_CAMERA_CAPTURE_PIPE_CMD_LEN_MAX];
+    uint32_t startTimeMs;
+    uint32_t restartCount;
+} T_DjiCameraCapturePipe;
+
+/* Private functions declaration ---------------------------------------------*/
+static T_DjiReturnCode DjiCameraCapture_StartStream_Pipe(struct _DjiCameraCapture *captureHandle);
+static T_DjiReturnCode DjiCameraCapture_RestartStream_Pipe(struct _DjiCameraCapture *captureHandle,
+                                                           uint32_t timeoutMs);
+
+/* Private values ------------------------------------------------------------*/
+
+/* Exported functions definition ---------------------------------------------*/
+T_DjiReturnCode DjiCameraCapture_Open_Pipe(struct _DjiCameraCapture *captureHandle)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiCameraCaptureConfig *config = &captureHandle->config;
+    T_DjiCameraCapturePipe *capturePipe;
+
+    capturePipe = osalHandler->Malloc(sizeof(T_DjiCameraCapturePipe));
+    if (capturePipe == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+    memset(capturePipe, 0, sizeof(T_DjiCameraCapturePipe));
+
+    snprintf(capturePipe->videoCmd, sizeof(capturePipe->videoCmd),
+             "libcamera-vid -t 0 --width %u --height %u --framerate %u --codec h264 --inline --output - "
+             " --denoise auto --profile high --bitrate %u", config->width, config->height, config->frameRate,
+             config->bitRate);
+
+    if (osalHandler->MutexCreate(&capturePipe->streamMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        osalHandler->Free(capturePipe);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    captureHandle->privData = capturePipe;
+    if (DjiCameraCapture_StartStream_Pipe(captureHandle) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        osalHandler->MutexDestroy(capturePipe->streamMutex);
+        osalHandler->Free(capturePipe);
+        captureHandle->privData = NULL;
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Read the H.264 stream of libcamera-vid.
+ * @note When libcamera-vid exits, the stream is restarted at most once per DJI_CAMERA_CAPTURE_PIPE_RESTART_INTERVAL_MS.
+ * Every read without a running libcamera-vid returns an error, so the caller sees a camera that keeps failing.
+ */
+T_DjiReturnCode DjiCameraCapture_ReadStream_Pipe(struct _DjiCameraCapture *captureHandle, uint8_t *data, uint32_t len,
+                                                 uint32_t *realLen, uint32_t timeoutMs)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiCameraCapturePipe *capturePipe = captureHandle->privData;
+    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    struct pollfd pollFd;
+    ssize_t readLen;
+
+    *realLen = 0;
+
+    osalHandler->MutexLock(capturePipe->streamMutex);
+    if (capturePipe->stream == NULL) {
+        returnCode = DjiCameraCapture_RestartStream_Pipe(captureHandle, timeoutMs);
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            osalHandler->MutexUnlock(capturePipe->streamMutex);
+            return returnCode;
+        }
+    }
+
+    pollFd.fd = fileno(capturePipe->stream);
+    pollFd.events = POLLIN;
+    if (poll(&pollFd, 1, (int) timeoutMs) > 0) {
+        // read() returns as soon as the pipe has data, unlike fread() which waits for the whole length
+        readLen = read(pollFd.fd, data, len);
+        if (readLen > 0) {
+            *realLen = (uint32_t) readLen;
+        } else if (readLen == 0) {
+            USER_LOG_WARN("libcamera-vid stream ended, exit status 0x%X", pclose(capturePipe->stream));
+            capturePipe->stream = NULL;
+            returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        }
+    }
+    osalHandler->MutexUnlock(capturePipe->streamMutex);
+
+    return returnCode;
+}
+
+/**
+ * @brief libcamera-still can not share the camera with libcamera-vid, the video stream is stopped while
+ * the photo is taken and restarted afterwards.
+ */
+T_DjiReturnCode DjiCameraCapture_TakePhoto_Pipe(struct _DjiCameraCapture *captureHandle, const char *filePath)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiCameraCapturePipe *capturePipe = captureHandle->privData;
+    T_DjiCameraCaptureConfig *config = &captureHandle->config;
+    char cmd[DJI_CAMERA_CAPTURE_PIPE_CMD_LEN_MAX];
+    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+
+    if (filePath == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    snprintf(cmd, sizeof(cmd),
+             "libcamera-still -o %s --width %u --height %u --quality 90 --timeout 100 --framerate %u --verbose 0 2>/dev/null",
+             filePath, config->width, config->height, config->frameRate);
+
+    osalHandler->MutexLock(capturePipe->streamMutex);
+    if (capturePipe->stream != NULL) {
+        pclose(capturePipe->stream);
+        capturePipe->stream = NULL;
+    }
+    osalHandler->TaskSleepMs(100);
+
+    USER_LOG_INFO("Taking photo: %s", filePath);
+    system(cmd);
+    if (access(filePath, F_OK) != 0) {
+        USER_LOG_ERROR("Failed to capture photo: %s", filePath);
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    // on failure the next read restarts the stream
+    DjiCameraCapture_StartStream_Pipe(captureHandle);
+    osalHandler->MutexUnlock(capturePipe->streamMutex);
+
+    return returnCode;
+}
+
+T_DjiReturnCode DjiCameraCapture_Close_Pipe(struct _DjiCameraCapture *captureHandle)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiCameraCapturePipe *capturePipe = captureHandle->privData;
+
+    if (capturePipe->stream != NULL) {
+        pclose(capturePipe->stream);
+    }
+    osalHandler->MutexDestroy(capturePipe->streamMutex);
+    osalHandler->Free(capturePipe);
+    captureHandle->privData = NULL;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/* Private functions definition-----------------------------------------------*/
+/**
+ * @brief Start libcamera-vid, must be called with the stream mutex held once the backend is open.
+ */
+static T_DjiReturnCode DjiCameraCapture_StartStream_Pipe(struct _DjiCameraCapture *captureHandle)
+{
+    T_DjiCameraCapturePipe *capturePipe = captureHandle->privData;
+
+    DjiPlatform_GetOsalHandler()->GetTimeMs(&capturePipe->startTimeMs);
+    capturePipe->stream = popen(capturePipe->videoCmd, "r");
+    if (capturePipe->stream == NULL) {
+        USER_LOG_ERROR("popen libcamera-vid error: %s", strerror(errno));
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+    captureHandle->streamGeneration++;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Restart libcamera-vid after it exited, waiting up to timeoutMs for the restart interval to pass.
+ * @return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY while the restart interval has not passed yet.
+ */
+static T_DjiReturnCode DjiCameraCapture_RestartStream_Pipe(struct _DjiCameraCapture *captureHandle,
+                                                           uint32_t timeoutMs)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiCameraCapturePipe *capturePipe = captureHandle->privData;
+    uint32_t currentTimeMs;
+    uint32_t elapsedTimeMs;
+
+    osalHandler->GetTimeMs(&currentTimeMs);
+    elapsedTimeMs = currentTimeMs - capturePipe->startTimeMs;
+    if (elapsedTimeMs < DJI_CAMERA_CAPTURE_PIPE_RESTART_INTERVAL_MS) {
+        if (DJI_CAMERA_CAPTURE_PIPE_RESTART_INTERVAL_MS - elapsedTimeMs > timeoutMs) {
+            osalHandler->TaskSleepMs(timeoutMs);
+            return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+        }
+        osalHandler->TaskSleepMs(DJI_CAMERA_CAPTURE_PIPE_RESTART_INTERVAL_MS - elapsedTimeMs);
+    }
+
+    capturePipe->restartCount++;
+    USER_LOG_WARN("Restart libcamera-vid, restart count %u", capturePipe->restartCount);
+
+    return DjiCameraCapture_StartStream_Pipe(captureHandle);
+}
+
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,760 @@
+/**
+ ********************************************************************
+ * @file    dji_camera_capture_v4l2.c
+ * @brief   The file defines the camera capture backend built on a V4L2 capture device and a V4L2
+ * memory-to-memory H.264 encoder. Captured frames are handed to the encoder as DMABUF without copy.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_camera_capture_v4l2.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <linux/videodev2.h>
+#include <dji_logger.h>
+#include "dji_platform.h"
+#include "utils/util_misc.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define DJI_CAMERA_CAPTURE_V4L2_FRAME_BUFFER_NUM        4
+#define DJI_CAMERA_CAPTURE_V4L2_ENCODED_BUFFER_NUM      4
+#define DJI_CAMERA_CAPTURE_V4L2_ENCODED_BUFFER_SIZE     (1024 * 1024)
+#define DJI_CAMERA_CAPTURE_V4L2_STILL_TIMEOUT_MS        2000
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    void *start;
+    uint32_t length;
+} T_DjiCameraCaptureV4l2Mapping;
+
+typedef struct {
+    int captureFd;
+    int encoderFd;
+    uint32_t width;
+    uint32_t height;
+    uint32_t bytesPerLine;
+    uint32_t frameSize;
+    uint32_t frameBufferNum;
+    T_DjiCameraCaptureV4l2Mapping frameBuffers[DJI_CAMERA_CAPTURE_V4L2_FRAME_BUFFER_NUM];
+    int frameDmabufFds[DJI_CAMERA_CAPTURE_V4L2_FRAME_BUFFER_NUM];
+    uint32_t encodedBufferNum;
+    T_DjiCameraCaptureV4l2Mapping encodedBuffers[DJI_CAMERA_CAPTURE_V4L2_ENCODED_BUFFER_NUM];
+    int pendingIndex;
+    uint32_t pendingOffset;
+    uint32_t pendingLen;
+    volatile bool stillRequest;
+    uint8_t *stillFrame;
+    T_DjiSemaHandle stillSema;
+} T_DjiCameraCaptureV4l2;
+
+/* Private functions declaration ---------------------------------------------*/
+static int DjiCameraCapture_V4l2Ioctl(int fd, unsigned long request, void *arg);
+static T_DjiReturnCode DjiCameraCapture_V4l2SetupCapture(T_DjiCameraCaptureV4l2 *v4l2,
+                                                         const T_DjiCameraCaptureConfig *config);
+static T_DjiReturnCode DjiCameraCapture_V4l2SetupEncoder(T_DjiCameraCaptureV4l2 *v4l2,
+                                                         const T_DjiCameraCaptureConfig *config);
+static void DjiCameraCapture_V4l2SetControl(int fd, uint32_t id, int32_t value, const char *name);
+static void DjiCameraCapture_V4l2HandleFrame(T_DjiCameraCaptureV4l2 *v4l2);
+static void DjiCameraCapture_V4l2RecycleFrame(T_DjiCameraCaptureV4l2 *v4l2);
+static bool DjiCameraCapture_V4l2DequeueEncoded(T_DjiCameraCaptureV4l2 *v4l2);
+static uint32_t DjiCameraCapture_V4l2CopyPending(T_DjiCameraCaptureV4l2 *v4l2, uint8_t *data, uint32_t len);
+static T_DjiReturnCode DjiCameraCapture_V4l2EncodeJpeg(const char *encoderPath, const T_DjiCameraCaptureV4l2 *v4l2,
+                                                       const char *filePath);
+static void DjiCameraCapture_V4l2Release(T_DjiCameraCaptureV4l2 *v4l2);
+
+/* Private values ------------------------------------------------------------*/
+
+/* Exported functions definition ---------------------------------------------*/
+T_DjiReturnCode DjiCameraCapture_Open_V4l2(struct _DjiCameraCapture *captureHandle)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiCameraCaptureV4l2 *v4l2;
+    enum v4l2_buf_type bufType;
+    T_DjiReturnCode returnCode;
+    uint32_t i;
+
+    // stills are only ever stored as jpeg, a board without the encoder is better served by another backend
+    if (strlen(captureHandle->config.jpegEncoderPath) == 0 ||
+        access(captureHandle->config.jpegEncoderPath, R_OK | W_OK) != 0) {
+        USER_LOG_WARN("Jpeg encoder %s not available for stills", captureHandle->config.jpegEncoderPath);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
+    }
+
+    v4l2 = osalHandler->Malloc(sizeof(T_DjiCameraCaptureV4l2));
+    if (v4l2 == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+    memset(v4l2, 0, sizeof(T_DjiCameraCaptureV4l2));
+    v4l2->captureFd = -1;
+    v4l2->encoderFd = -1;
+    v4l2->pendingIndex = -1;
+    for (i = 0; i < DJI_CAMERA_CAPTURE_V4L2_FRAME_BUFFER_NUM; i++) {
+        v4l2->frameDmabufFds[i] = -1;
+    }
+
+    returnCode = DjiCameraCapture_V4l2SetupCapture(v4l2, &captureHandle->config);
+    if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        returnCode = DjiCameraCapture_V4l2SetupEncoder(v4l2, &captureHandle->config);
+    }
+    if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS &&
+        osalHandler->SemaphoreCreate(0, &v4l2->stillSema) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        DjiCameraCapture_V4l2Release(v4l2);
+        return returnCode;
+    }
+
+    for (i = 0; i < v4l2->frameBufferNum; i++) {
+        struct v4l2_buffer buf = {0};
+
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        DjiCameraCapture_V4l2Ioctl(v4l2->captureFd, VIDIOC_QBUF, &buf);
+    }
+
+    bufType = V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE;
+    if (DjiCameraCapture_V4l2Ioctl(v4l2->encoderFd, VIDIOC_STREAMON, &bufType) != 0) {
+        USER_LOG_ERROR("Encoder output stream on error: %s", strerror(errno));
+        DjiCameraCapture_V4l2Release(v4l2);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+    bufType = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+    if (DjiCameraCapture_V4l2Ioctl(v4l2->encoderFd, VIDIOC_STREAMON, &bufType) != 0) {
+        USER_LOG_ERROR("Encoder capture stream on error: %s", strerror(errno));
+        DjiCameraCapture_V4l2Release(v4l2);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+    bufType = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (DjiCameraCapture_V4l2Ioctl(v4l2->captureFd, VIDIOC_STREAMON, &bufType) != 0) {
+        USER_LOG_ERROR("Capture stream on error: %s", strerror(errno));
+        DjiCameraCapture_V4l2Release(v4l2);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    captureHandle->privData = v4l2;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Drive both devices until encoded data is available: captured frames go to the encoder output queue as
+ * DMABUF, frames released by the encoder go back to the capture device, and encoded buffers are copied out.
+ */
+T_DjiReturnCode DjiCameraCapture_ReadStream_V4l2(struct _DjiCameraCapture *captureHandle, uint8_t *data, uint32_t len,
+                                                 uint32_t *realLen, uint32_t timeoutMs)
+{
+    T_DjiCameraCaptureV4l2 *v4l2 = captureHandle->privData;
+    struct pollfd pollFds[2];
+    int result;
+
+    *realLen = DjiCameraCapture_V4l2CopyPending(v4l2, data, len);
+    if (*realLen > 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    pollFds[0].fd = v4l2->captureFd;
+    pollFds[0].events = POLLIN;
+    pollFds[1].fd = v4l2->encoderFd;
+    pollFds[1].events = POLLIN | POLLOUT;
+
+    result = poll(pollFds, UTIL_ARRAY_SIZE(pollFds), (int) timeoutMs);
+    if (result < 0 && errno != EINTR) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+    if (result <= 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    if (pollFds[0].revents & POLLIN) {
+        DjiCameraCapture_V4l2HandleFrame(v4l2);
+    }
+    if (pollFds[1].revents & POLLOUT) {
+        DjiCameraCapture_V4l2RecycleFrame(v4l2);
+    }
+    if ((pollFds[1].revents & POLLIN) && DjiCameraCapture_V4l2DequeueEncoded(v4l2)) {
+        *realLen = DjiCameraCapture_V4l2CopyPending(v4l2, data, len);
+    }
+    if ((pollFds[0].revents | pollFds[1].revents) & (POLLERR | POLLHUP)) {
+        USER_LOG_ERROR("V4L2 capture device error");
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Take the next frame of the running stream as a still, the video stream is not interrupted.
+ * @note The frame is copied by the task calling DjiCameraCapture_ReadStream, so the stream must be read meanwhile.
+ */
+T_DjiReturnCode DjiCameraCapture_TakePhoto_V4l2(struct _DjiCameraCapture *captureHandle, const char *filePath)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiCameraCaptureV4l2 *v4l2 = captureHandle->privData;
+    T_DjiReturnCode returnCode;
+
+    if (filePath == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    // the media browser only lists jpg photos, so without a jpeg encoder there is no photo at all
+    if (strlen(captureHandle->config.jpegEncoderPath) == 0) {
+        USER_LOG_ERROR("No jpeg encoder configured for stills");
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
+    }
+
+    if (v4l2->stillFrame == NULL) {
+        v4l2->stillFrame = osalHandler->Malloc(v4l2->frameSize);
+        if (v4l2->stillFrame == NULL) {
+            return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+        }
+    }
+
+    // a frame posted after an earlier timeout left a count behind, it must not be taken for this request
+    while (osalHandler->SemaphoreTimedWait(v4l2->stillSema, 0) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+    }
+
+    v4l2->stillRequest = true;
+    if (osalHandler->SemaphoreTimedWait(v4l2->stillSema, DJI_CAMERA_CAPTURE_V4L2_STILL_TIMEOUT_MS) !=
+        DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        v4l2->stillRequest = false;
+        USER_LOG_ERROR("Wait still frame timeout");
+        return DJI_ERROR_SYSTEM_MODULE_CODE_TIMEOUT;
+    }
+
+    returnCode = DjiCameraCapture_V4l2EncodeJpeg(captureHandle->config.jpegEncoderPath, v4l2, filePath);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Encode still with %s error: 0x%08llX", captureHandle->config.jpegEncoderPath, returnCode);
+    }
+
+    return returnCode;
+}
+
+T_DjiReturnCode DjiCameraCapture_Close_V4l2(struct _DjiCameraCapture *captureHandle)
+{
+    T_DjiCameraCaptureV4l2 *v4l2 = captureHandle->privData;
+    enum v4l2_buf_type bufType;
+
+    bufType = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    DjiCameraCapture_V4l2Ioctl(v4l2->captureFd, VIDIOC_STREAMOFF, &bufType);
+    bufType = V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE;
+    DjiCameraCapture_V4l2Ioctl(v4l2->encoderFd, VIDIOC_STREAMOFF, &bufType);
+    bufType = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+    DjiCameraCapture_V4l2Ioctl(v4l2->encoderFd, VIDIOC_STREAMOFF, &bufType);
+
+    DjiCameraCapture_V4l2Release(v4l2);
+    captureHandle->privData = NULL;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/* Private functions definition-----------------------------------------------*/
+static int DjiCameraCapture_V4l2Ioctl(int fd, unsigned long request, void *arg)
+{
+    int result;
+
+    do {
+        result = ioctl(fd, request, arg);
+    } while (result == -1 && errno == EINTR);
+
+    return result;
+}
+
+static T_DjiReturnCode DjiCameraCapture_V4l2SetupCapture(T_DjiCameraCaptureV4l2 *v4l2,
+                                                         const T_DjiCameraCaptureConfig *config)
+{
+    struct v4l2_capability cap = {0};
+    struct v4l2_format fmt = {0};
+    struct v4l2_streamparm parm = {0};
+    struct v4l2_requestbuffers req = {0};
+    uint32_t caps;
+    uint32_t i;
+
+    v4l2->captureFd = open(config->capturePath, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (v4l2->captureFd < 0) {
+        USER_LOG_ERROR("Open capture device %s error: %s", config->capturePath, strerror(errno));
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+    }
+
+    if (DjiCameraCapture_V4l2Ioctl(v4l2->captureFd, VIDIOC_QUERYCAP, &cap) != 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+    caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+    if (!(caps & V4L2_CAP_VIDEO_CAPTURE) || !(caps & V4L2_CAP_STREAMING)) {
+        USER_LOG_ERROR("%s is not a streaming capture device", config->capturePath);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
+    }
+
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    fmt.fmt.pix.width = config->width;
+    fmt.fmt.pix.height = config->height;
+    fmt.fmt.pix.pixelformat = V4L2_PIX_FMT_YUV420;
+    fmt.fmt.pix.field = V4L2_FIELD_NONE;
+    if (DjiCameraCapture_V4l2Ioctl(v4l2->captureFd, VIDIOC_S_FMT, &fmt) != 0 ||
+        fmt.fmt.pix.pixelformat != V4L2_PIX_FMT_YUV420) {
+        USER_LOG_ERROR("Capture device does not support YUV420");
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
+    }
+    v4l2->width = fmt.fmt.pix.width;
+    v4l2->height = fmt.fmt.pix.height;
+    v4l2->bytesPerLine = fmt.fmt.pix.bytesperline;
+    v4l2->frameSize = fmt.fmt.pix.sizeimage;
+
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    parm.parm.capture.timeperframe.numerator = 1;
+    parm.parm.capture.timeperframe.denominator = config->frameRate;
+    if (DjiCameraCapture_V4l2Ioctl(v4l2->captureFd, VIDIOC_S_PARM, &parm) != 0) {
+        USER_LOG_WARN("Set capture frame rate error: %s", strerror(errno));
+    }
+
+    req.count = DJI_CAMERA_CAPTURE_V4L2_FRAME_BUFFER_NUM;
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    if (DjiCameraCapture_V4l2Ioctl(v4l2->captureFd, VIDIOC_REQBUFS, &req) != 0 || req.count == 0) {
+        USER_LOG_ERROR("Request capture buffers error: %s", strerror(errno));
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+    v4l2->frameBufferNum = USER_UTIL_MIN(req.count, DJI_CAMERA_CAPTURE_V4L2_FRAME_BUFFER_NUM);
+
+    for (i = 0; i < v4l2->frameBufferNum; i++) {
+        struct v4l2_buffer buf = {0};
+        struct v4l2_exportbuffer expbuf = {0};
+
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        if (DjiCameraCapture_V4l2Ioctl(v4l2->captureFd, VIDIOC_QUERYBUF, &buf) != 0) {
+            return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        }
+
+        // the mapping is only read for stills, the encoder gets the buffer through its dmabuf
+        v4l2->frameBuffers[i].length = buf.length;
+        v4l2->frameBuffers[i].start = mmap(NULL, buf.length, PROT_READ, MAP_SHARED, v4l2->captureFd, buf.m.offset);
+        if (v4l2->frameBuffers[i].start == MAP_FAILED) {
+            v4l2->frameBuffers[i].start = NULL;
+            return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        }
+
+        expbuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        expbuf.index = i;
+        expbuf.flags = O_RDONLY | O_CLOEXEC;
+        if (DjiCameraCapture_V4l2Ioctl(v4l2->captureFd, VIDIOC_EXPBUF, &expbuf) != 0) {
+            USER_LOG_ERROR("Export capture buffer as dmabuf error: %s", strerror(errno));
+            return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
+        }
+        v4l2->frameDmabufFds[i] = expbuf.fd;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+static T_DjiReturnCode DjiCameraCapture_V4l2SetupEncoder(T_DjiCameraCaptureV4l2 *v4l2,
+                                                         const T_DjiCameraCaptureConfig *config)
+{
+    struct v4l2_capability cap = {0};
+    struct v4l2_format fmt = {0};
+    struct v4l2_streamparm parm = {0};
+    struct v4l2_requestbuffers req = {0};
+    uint32_t caps;
+    uint32_t i;
+
+    v4l2->encoderFd = open(config->encoderPath, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (v4l2->encoderFd < 0) {
+        USER_LOG_ERROR("Open encoder device %s error: %s", config->encoderPath, strerror(errno));
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+    }
+
+    if (DjiCameraCapture_V4l2Ioctl(v4l2->encoderFd, VIDIOC_QUERYCAP, &cap) != 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+    caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+    if (!(caps & V4L2_CAP_VIDEO_M2M_MPLANE)) {
+        USER_LOG_ERROR("%s is not a multi-planar m2m encoder", config->encoderPath);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
+    }
+
+    fmt.type = V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE;
+    fmt.fmt.pix_mp.width = v4l2->width;
+    fmt.fmt.pix_mp.height = v4l2->height;
+    fmt.fmt.pix_mp.pixelformat = V4L2_PIX_FMT_YUV420;
+    fmt.fmt.pix_mp.field = V4L2_FIELD_NONE;
+    fmt.fmt.pix_mp.num_planes = 1;
+    fmt.fmt.pix_mp.plane_fmt[0].bytesperline = v4l2->bytesPerLine;
+    fmt.fmt.pix_mp.plane_fmt[0].sizeimage = v4l2->frameSize;
+    if (DjiCameraCapture_V4l2Ioctl(v4l2->encoderFd, VIDIOC_S_FMT, &fmt) != 0) {
+        USER_LOG_ERROR("Set encoder input format error: %s", strerror(errno));
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
+    }
+
+    memset(&fmt, 0, sizeof(fmt));
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+    fmt.fmt.pix_mp.width = v4l2->width;
+    fmt.fmt.pix_mp.height = v4l2->height;
+    fmt.fmt.pix_mp.pixelformat = V4L2_PIX_FMT_H264;
+    fmt.fmt.pix_mp.field = V4L2_FIELD_NONE;
+    fmt.fmt.pix_mp.num_planes = 1;
+    fmt.fmt.pix_mp.plane_fmt[0].sizeimage = DJI_CAMERA_CAPTURE_V4L2_ENCODED_BUFFER_SIZE;
+    if (DjiCameraCapture_V4l2Ioctl(v4l2->encoderFd, VIDIOC_S_FMT, &fmt) != 0) {
+        USER_LOG_ERROR("Set encoder output format error: %s", strerror(errno));
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
+    }
+
+    // same settings as the libcamera-vid command line: high profile, inline headers, given bit rate
+    DjiCameraCapture_V4l2SetControl(v4l2->encoderFd, V4L2_CID_MPEG_VIDEO_BITRATE, (int32_t) config->bitRate,
+                                    "bitrate");
+    DjiCameraCapture_V4l2SetControl(v4l2->encoderFd, V4L2_CID_MPEG_VIDEO_H264_PROFILE,
+                                    V4L2_MPEG_VIDEO_H264_PROFILE_HIGH, "profile");
+    DjiCameraCapture_V4l2SetControl(v4l2->encoderFd, V4L2_CID_MPEG_VIDEO_H264_I_PERIOD,
+                                    (int32_t) config->frameRate, "i period");
+    DjiCameraCapture_V4l2SetControl(v4l2->encoderFd, V4L2_CID_MPEG_VIDEO_REPEAT_SEQ_HEADER, 1, "inline headers");
+
+    parm.type = V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE;
+    parm.parm.output.timeperframe.numerator = 1;
+    parm.parm.output.timeperframe.denominator = config->frameRate;
+    DjiCameraCapture_V4l2Ioctl(v4l2->encoderFd, VIDIOC_S_PARM, &parm);
+
+    req.count = v4l2->frameBufferNum;
+    req.type = V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE;
+    req.memory = V4L2_MEMORY_DMABUF;
+    if (DjiCameraCapture_V4l2Ioctl(v4l2->encoderFd, VIDIOC_REQBUFS, &req) != 0 || req.count < v4l2->frameBufferNum) {
+        USER_LOG_ERROR("Request encoder dmabuf input buffers error: %s", strerror(errno));
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
+    }
+
+    memset(&req, 0, sizeof(req));
+    req.count = DJI_CAMERA_CAPTURE_V4L2_ENCODED_BUFFER_NUM;
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+    req.memory = V4L2_MEMORY_MMAP;
+    if (DjiCameraCapture_V4l2Ioctl(v4l2->encoderFd, VIDIOC_REQBUFS, &req) != 0 || req.count == 0) {
+        USER_LOG_ERROR("Request encoder output buffers error: %s", strerror(errno));
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+    v4l2->encodedBufferNum = USER_UTIL_MIN(req.count, DJI_CAMERA_CAPTURE_V4L2_ENCODED_BUFFER_NUM);
+
+    for (i = 0; i < v4l2->encodedBufferNum; i++) {
+        struct v4l2_buffer buf = {0};
+        struct v4l2_plane planes[VIDEO_MAX_PLANES] = {0};
+
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        buf.m.planes = planes;
+        buf.length = VIDEO_MAX_PLANES;
+        if (DjiCameraCapture_V4l2Ioctl(v4l2->encoderFd, VIDIOC_QUERYBUF, &buf) != 0) {
+            return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        }
+
+        v4l2->encodedBuffers[i].length = planes[0].length;
+        v4l2->encodedBuffers[i].start = mmap(NULL, planes[0].length, PROT_READ | PROT_WRITE, MAP_SHARED,
+                                             v4l2->encoderFd, planes[0].m.mem_offset);
+        if (v4l2->encodedBuffers[i].start == MAP_FAILED) {
+            v4l2->encodedBuffers[i].start = NULL;
+            return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        }
+
+        if (DjiCameraCapture_V4l2Ioctl(v4l2->encoderFd, VIDIOC_QBUF, &buf) != 0) {
+            return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        }
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+static void DjiCameraCapture_V4l2SetControl(int fd, uint32_t id, int32_t value, const char *name)
+{
+    struct v4l2_control ctrl = {0};
+
+    ctrl.id = id;
+    ctrl.value = value;
+    if (DjiCameraCapture_V4l2Ioctl(fd, VIDIOC_S_CTRL, &ctrl) != 0) {
+        USER_LOG_WARN("Set encoder %s error: %s", name, strerror(errno));
+    }
+}
+
+static void DjiCameraCapture_V4l2HandleFrame(T_DjiCameraCaptureV4l2 *v4l2)
+{
+    struct v4l2_buffer buf = {0};
+    struct v4l2_buffer encBuf = {0};
+    struct v4l2_plane encPlane = {0};
+
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    if (DjiCameraCapture_V4l2Ioctl(v4l2->captureFd, VIDIOC_DQBUF, &buf) != 0) {
+        return;
+    }
+
+    if (v4l2->stillRequest && v4l2->stillFrame != NULL) {
+        memcpy(v4l2->stillFrame, v4l2->frameBuffers[buf.index].start, USER_UTIL_MIN(buf.bytesused, v4l2->frameSize));
+        v4l2->stillRequest = false;
+        DjiPlatform_GetOsalHandler()->SemaphorePost(v4l2->stillSema);
+    }
+
+    encPlane.m.fd = v4l2->frameDmabufFds[buf.index];
+    encPlane.bytesused = buf.bytesused;
+    encPlane.length = v4l2->frameBuffers[buf.index].length;
+    encBuf.type = V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE;
+    encBuf.memory = V4L2_MEMORY_DMABUF;
+    encBuf.index = buf.index;
+    encBuf.timestamp = buf.timestamp;
+    encBuf.m.planes = &encPlane;
+    encBuf.length = 1;
+    if (DjiCameraCapture_V4l2Ioctl(v4l2->encoderFd, VIDIOC_QBUF, &encBuf) != 0) {
+        // encoder is not accepting input, drop the frame and give the buffer back to the camera
+        DjiCameraCapture_V4l2Ioctl(v4l2->captureFd, VIDIOC_QBUF, &buf);
+    }
+}
+
+static void DjiCameraCapture_V4l2RecycleFrame(T_DjiCameraCaptureV4l2 *v4l2)
+{
+    struct v4l2_buffer encBuf = {0};
+    struct v4l2_plane encPlane = {0};
+    struct v4l2_buffer buf = {0};
+
+    encBuf.type = V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE;
+    encBuf.memory = V4L2_MEMORY_DMABUF;
+    encBuf.m.planes = &encPlane;
+    encBuf.length = 1;
+    while (DjiCameraCapture_V4l2Ioctl(v4l2->encoderFd, VIDIOC_DQBUF, &encBuf) == 0) {
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = encBuf.index;
+        DjiCameraCapture_V4l2Ioctl(v4l2->captureFd, VIDIOC_QBUF, &buf);
+    }
+}
+
+static bool DjiCameraCapture_V4l2DequeueEncoded(T_DjiCameraCaptureV4l2 *v4l2)
+{
+    struct v4l2_buffer buf = {0};
+    struct v4l2_plane plane = {0};
+
+    if (v4l2->pendingIndex >= 0) {
+        return true;
+    }
+
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.m.planes = &plane;
+    buf.length = 1;
+    if (DjiCameraCapture_V4l2Ioctl(v4l2->encoderFd, VIDIOC_DQBUF, &buf) != 0) {
+        return false;
+    }
+
+    v4l2->pendingIndex = (int) buf.index;
+    v4l2->pendingOffset = plane.data_offset;
+    v4l2->pendingLen = plane.bytesused > plane.data_offset ? plane.bytesused - plane.data_offset : 0;
+
+    return true;
+}
+
+static uint32_t DjiCameraCapture_V4l2CopyPending(T_DjiCameraCaptureV4l2 *v4l2, uint8_t *data, uint32_t len)
+{
+    struct v4l2_buffer buf = {0};
+    struct v4l2_plane plane = {0};
+    uint32_t copyLen;
+
+    if (v4l2->pendingIndex < 0) {
+        return 0;
+    }
+
+    copyLen = USER_UTIL_MIN(len, v4l2->pendingLen);
+    memcpy(data, (uint8_t *) v4l2->encodedBuffers[v4l2->pendingIndex].start + v4l2->pendingOffset, copyLen);
+    v4l2->pendingOffset += copyLen;
+    v4l2->pendingLen -= copyLen;
+
+    if (v4l2->pendingLen == 0) {
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = (uint32_t) v4l2->pendingIndex;
+        buf.m.planes = &plane;
+        buf.length = 1;
+        DjiCameraCapture_V4l2Ioctl(v4l2->encoderFd, VIDIOC_QBUF, &buf);
+        v4l2->pendingIndex = -1;
+    }
+
+    return copyLen;
+}
+
+/**
+ * @brief One-shot encode of the still frame with a V4L2 memory-to-memory JPEG encoder.
+ */
+static T_DjiReturnCode DjiCameraCapture_V4l2EncodeJpeg(const char *encoderPath, const T_DjiCameraCaptureV4l2 *v4l2,
+                                                       const char *filePath)
+{
+    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    struct v4l2_format fmt = {0};
+    struct v4l2_requestbuffers req = {0};
+    struct v4l2_buffer buf = {0};
+    struct v4l2_plane plane = {0};
+    struct pollfd pollFd;
+    enum v4l2_buf_type bufType;
+    void *inMap = MAP_FAILED;
+    void *outMap = MAP_FAILED;
+    uint32_t inLen = 0;
+    uint32_t outLen = 0;
+    FILE *jpegFile;
+    int fd;
+
+    fd = open(encoderPath, O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        USER_LOG_WARN("Open jpeg encoder %s error: %s", encoderPath, strerror(errno));
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+    }
+
+    fmt.type = V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE;
+    fmt.fmt.pix_mp.width = v4l2->width;
+    fmt.fmt.pix_mp.height = v4l2->height;
+    fmt.fmt.pix_mp.pixelformat = V4L2_PIX_FMT_YUV420;
+    fmt.fmt.pix_mp.num_planes = 1;
+    fmt.fmt.pix_mp.plane_fmt[0].bytesperline = v4l2->bytesPerLine;
+    fmt.fmt.pix_mp.plane_fmt[0].sizeimage = v4l2->frameSize;
+    if (DjiCameraCapture_V4l2Ioctl(fd, VIDIOC_S_FMT, &fmt) != 0) {
+        goto out;
+    }
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+    fmt.fmt.pix_mp.pixelformat = V4L2_PIX_FMT_JPEG;
+    fmt.fmt.pix_mp.plane_fmt[0].bytesperline = 0;
+    if (DjiCameraCapture_V4l2Ioctl(fd, VIDIOC_S_FMT, &fmt) != 0) {
+        goto out;
+    }
+
+    req.count = 1;
+    req.memory = V4L2_MEMORY_MMAP;
+    req.type = V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE;
+    if (DjiCameraCapture_V4l2Ioctl(fd, VIDIOC_REQBUFS, &req) != 0) {
+        goto out;
+    }
+    req.count = 1;
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+    if (DjiCameraCapture_V4l2Ioctl(fd, VIDIOC_REQBUFS, &req) != 0) {
+        goto out;
+    }
+
+    buf.type = V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.m.planes = &plane;
+    buf.length = 1;
+    if (DjiCameraCapture_V4l2Ioctl(fd, VIDIOC_QUERYBUF, &buf) != 0) {
+        goto out;
+    }
+    inLen = plane.length;
+    inMap = mmap(NULL, inLen, PROT_READ | PROT_WRITE, MAP_SHARED, fd, plane.m.mem_offset);
+    if (inMap == MAP_FAILED) {
+        goto out;
+    }
+    memcpy(inMap, v4l2->stillFrame, USER_UTIL_MIN(inLen, v4l2->frameSize));
+    plane.bytesused = USER_UTIL_MIN(inLen, v4l2->frameSize);
+    if (DjiCameraCapture_V4l2Ioctl(fd, VIDIOC_QBUF, &buf) != 0) {
+        goto out;
+    }
+
+    memset(&buf, 0, sizeof(buf));
+    memset(&plane, 0, sizeof(plane));
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.m.planes = &plane;
+    buf.length = 1;
+    if (DjiCameraCapture_V4l2Ioctl(fd, VIDIOC_QUERYBUF, &buf) != 0) {
+        goto out;
+    }
+    outLen = plane.length;
+    outMap = mmap(NULL, outLen, PROT_READ | PROT_WRITE, MAP_SHARED, fd, plane.m.mem_offset);
+    if (outMap == MAP_FAILED || DjiCameraCapture_V4l2Ioctl(fd, VIDIOC_QBUF, &buf) != 0) {
+        goto out;
+    }
+
+    bufType = V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE;
+    DjiCameraCapture_V4l2Ioctl(fd, VIDIOC_STREAMON, &bufType);
+    bufType = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+    DjiCameraCapture_V4l2Ioctl(fd, VIDIOC_STREAMON, &bufType);
+
+    pollFd.fd = fd;
+    pollFd.events = POLLIN;
+    if (poll(&pollFd, 1, DJI_CAMERA_CAPTURE_V4L2_STILL_TIMEOUT_MS) <= 0 ||
+        DjiCameraCapture_V4l2Ioctl(fd, VIDIOC_DQBUF, &buf) != 0) {
+        USER_LOG_ERROR("Jpeg encode timeout");
+        goto out;
+    }
+
+    jpegFile = fopen(filePath, "wb");
+    if (jpegFile != NULL) {
+        fwrite((uint8_t *) outMap + plane.data_offset, 1, plane.bytesused - plane.data_offset, jpegFile);
+        fclose(jpegFile);
+        USER_LOG_INFO("Photo captured successfully: %s", filePath);
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+out:
+    bufType = V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE;
+    DjiCameraCapture_V4l2Ioctl(fd, VIDIOC_STREAMOFF, &bufType);
+    bufType = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+    DjiCameraCapture_V4l2Ioctl(fd, VIDIOC_STREAMOFF, &bufType);
+    if (inMap != MAP_FAILED) {
+        munmap(inMap, inLen);
+    }
+    if (outMap != MAP_FAILED) {
+        munmap(outMap, outLen);
+    }
+    close(fd);
+
+    return returnCode;
+}
+
+static void DjiCameraCapture_V4l2Release(T_DjiCameraCaptureV4l2 *v4l2)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    uint32_t i;
+
+    for (i = 0; i < DJI_CAMERA_CAPTURE_V4L2_FRAME_BUFFER_NUM; i++) {
+        if (v4l2->frameBuffers[i].start != NULL) {
+            munmap(v4l2->frameBuffers[i].start, v4l2->frameBuffers[i].length);
+        }
+        if (v4l2->frameDmabufFds[i] >= 0) {
+            close(v4l2->frameDmabufFds[i]);
+        }
+    }
+    for (i = 0; i < DJI_CAMERA_CAPTURE_V4L2_ENCODED_BUFFER_NUM; i++) {
+        if (v4l2->encodedBuffers[i].start != NULL) {
+            munmap(v4l2->encodedBuffers[i].start, v4l2->encodedBuffers[i].length);
+        }
+    }
+    if (v4l2->encoderFd >= 0) {
+        close(v4l2->encoderFd);
+    }
+    if (v4l2->captureFd >= 0) {
+        close(v4l2->captureFd);
+    }
+    if (v4l2->stillSema != NULL) {
+        osalHandler->SemaphoreDestroy(v4l2->stillSema);
+    }
+    if (v4l2->stillFrame != NULL) {
+        osalHandler->Free(v4l2->stillFrame);
+    }
+    osalHandler->Free(v4l2);
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
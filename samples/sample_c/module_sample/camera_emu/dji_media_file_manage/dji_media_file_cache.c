@@ -0,0 +1,296 @@
+/**
+ ********************************************************************
+ * @file    dji_media_file_cache.c
+ * @brief   The file defines the cache of open media files used by the media download of the camera
+ * emulator. Files stay open between the chunk requests of a download and are read with preadv.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <dji_logger.h>
+
+#include "dji_media_file_cache.h"
+#include "dji_platform.h"
+#include "utils/util_misc.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define PSDK_MEDIA_FILE_CACHE_READAHEAD_MIN        (1024 * 1024)
+#define PSDK_MEDIA_FILE_CACHE_READAHEAD_MAX        (8 * 1024 * 1024)
+/* Readahead covers this many chunks of the current request size. */
+#define PSDK_MEDIA_FILE_CACHE_READAHEAD_CHUNKS     8
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    char filePath[PSDK_MEDIA_FILE_PATH_LEN_MAX];
+    T_DjiMediaFileHandle mediaFileHandle;
+    /*! Descriptor owned by mediaFileHandle, -1 when the entry is unused. */
+    int fd;
+    uint32_t lastAccessMs;
+    uint64_t nextOffset;
+    uint64_t readaheadEnd;
+} T_DjiMediaFileCacheEntry;
+
+/* Private functions declaration ---------------------------------------------*/
+static T_DjiMediaFileCacheEntry *DjiMediaFileCache_GetEntry(const char *filePath, uint32_t nowMs);
+static void DjiMediaFileCache_CloseEntry(T_DjiMediaFileCacheEntry *entry);
+static void DjiMediaFileCache_Readahead(T_DjiMediaFileCacheEntry *entry, uint64_t offset, uint32_t len);
+
+/* Private values ------------------------------------------------------------*/
+static T_DjiMediaFileCacheEntry s_mediaFileCacheEntries[PSDK_MEDIA_FILE_CACHE_ENTRY_NUM];
+static T_DjiMutexHandle s_mediaFileCacheMutex = NULL;
+static T_DjiMediaFileCacheStatistics s_mediaFileCacheStatistics;
+
+/* Exported functions definition ---------------------------------------------*/
+T_DjiReturnCode DjiMediaFileCache_Init(void)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiReturnCode returnCode;
+    uint32_t i;
+
+    if (s_mediaFileCacheMutex != NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    returnCode = osalHandler->MutexCreate(&s_mediaFileCacheMutex);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Media file cache mutex create error stat:0x%08llX", returnCode);
+        return returnCode;
+    }
+
+    memset(s_mediaFileCacheEntries, 0, sizeof(s_mediaFileCacheEntries));
+    for (i = 0; i < PSDK_MEDIA_FILE_CACHE_ENTRY_NUM; i++) {
+        s_mediaFileCacheEntries[i].fd = -1;
+    }
+    memset(&s_mediaFileCacheStatistics, 0, sizeof(s_mediaFileCacheStatistics));
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiMediaFileCache_DeInit(void)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    uint32_t i;
+
+    if (s_mediaFileCacheMutex == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    osalHandler->MutexLock(s_mediaFileCacheMutex);
+    for (i = 0; i < PSDK_MEDIA_FILE_CACHE_ENTRY_NUM; i++) {
+        DjiMediaFileCache_CloseEntry(&s_mediaFileCacheEntries[i]);
+    }
+    osalHandler->MutexUnlock(s_mediaFileCacheMutex);
+
+    osalHandler->MutexDestroy(s_mediaFileCacheMutex);
+    s_mediaFileCacheMutex = NULL;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Read original data of a media file through the cache.
+ * @note The file is opened on the first chunk and kept open until it is the least recently used one or idle for
+ * PSDK_MEDIA_FILE_CACHE_IDLE_TIMEOUT_MS, so a download costs one preadv per chunk. Sequential reads advise the
+ * kernel to read ahead a window sized by the chunk size.
+ */
+T_DjiReturnCode DjiMediaFileCache_GetDataOrg(const char *filePath, uint32_t offset, uint32_t len,
+                                             uint8_t *data, uint32_t *realLen)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    T_DjiMediaFileCacheEntry *entry;
+    struct iovec iov = {data, len};
+    uint32_t nowMs = 0;
+    uint32_t readLen = 0;
+
+    if (filePath == NULL || data == NULL || realLen == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+    if (s_mediaFileCacheMutex == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE;
+    }
+
+    osalHandler->GetTimeMs(&nowMs);
+    osalHandler->MutexLock(s_mediaFileCacheMutex);
+
+    entry = DjiMediaFileCache_GetEntry(filePath, nowMs);
+    if (entry == NULL) {
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+        goto out;
+    }
+
+    DjiMediaFileCache_Readahead(entry, offset, len);
+
+    returnCode = DjiMediaFile_GetDataOrgVec(entry->mediaFileHandle, offset, &iov, 1, &readLen);
+    s_mediaFileCacheStatistics.readCount++;
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        goto out;
+    }
+    s_mediaFileCacheStatistics.readBytes += readLen;
+
+    entry->nextOffset = (uint64_t) offset + readLen;
+    *realLen = readLen;
+
+out:
+    osalHandler->MutexUnlock(s_mediaFileCacheMutex);
+
+    return returnCode;
+}
+
+/**
+ * @brief Close the cached file of the path, called when the file is deleted or rewritten.
+ */
+T_DjiReturnCode DjiMediaFileCache_Invalidate(const char *filePath)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    uint32_t i;
+
+    if (s_mediaFileCacheMutex == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    osalHandler->MutexLock(s_mediaFileCacheMutex);
+    for (i = 0; i < PSDK_MEDIA_FILE_CACHE_ENTRY_NUM; i++) {
+        if (s_mediaFileCacheEntries[i].fd >= 0 && strcmp(s_mediaFileCacheEntries[i].filePath, filePath) == 0) {
+            DjiMediaFileCache_CloseEntry(&s_mediaFileCacheEntries[i]);
+        }
+    }
+    osalHandler->MutexUnlock(s_mediaFileCacheMutex);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+void DjiMediaFileCache_GetStatistics(T_DjiMediaFileCacheStatistics *statistics)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    if (s_mediaFileCacheMutex == NULL) {
+        *statistics = s_mediaFileCacheStatistics;
+        return;
+    }
+
+    osalHandler->MutexLock(s_mediaFileCacheMutex);
+    *statistics = s_mediaFileCacheStatistics;
+    osalHandler->MutexUnlock(s_mediaFileCacheMutex);
+}
+
+/* Private functions definition-----------------------------------------------*/
+/**
+ * @brief Find the entry of the path or open it in place of the least recently used entry. Entries idle for too
+ * long are closed on the way. Called with the cache mutex held.
+ */
+static T_DjiMediaFileCacheEntry *DjiMediaFileCache_GetEntry(const char *filePath, uint32_t nowMs)
+{
+    T_DjiMediaFileCacheEntry *entry = NULL;
+    T_DjiMediaFileCacheEntry *lruEntry = NULL;
+    T_DjiReturnCode returnCode;
+    uint32_t i;
+
+    if (strlen(filePath) >= PSDK_MEDIA_FILE_PATH_LEN_MAX) {
+        return NULL;
+    }
+
+    for (i = 0; i < PSDK_MEDIA_FILE_CACHE_ENTRY_NUM; i++) {
+        T_DjiMediaFileCacheEntry *cur = &s_mediaFileCacheEntries[i];
+
+        if (cur->fd >= 0 && strcmp(cur->filePath, filePath) == 0) {
+            entry = cur;
+            continue;
+        }
+        if (cur->fd >= 0 && nowMs - cur->lastAccessMs > PSDK_MEDIA_FILE_CACHE_IDLE_TIMEOUT_MS) {
+            DjiMediaFileCache_CloseEntry(cur);
+        }
+        if (lruEntry == NULL || cur->fd < 0 || (lruEntry->fd >= 0 && cur->lastAccessMs < lruEntry->lastAccessMs)) {
+            lruEntry = cur;
+        }
+    }
+
+    if (entry != NULL) {
+        s_mediaFileCacheStatistics.hitCount++;
+        entry->lastAccessMs = nowMs;
+        return entry;
+    }
+
+    entry = lruEntry;
+    DjiMediaFileCache_CloseEntry(entry);
+
+    returnCode = DjiMediaFile_CreateHandle(filePath, &entry->mediaFileHandle);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Media file create handle error stat:0x%08llX", returnCode);
+        entry->mediaFileHandle = NULL;
+        return NULL;
+    }
+
+    returnCode = DjiMediaFile_GetFdOrg(entry->mediaFileHandle, &entry->fd);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        DjiMediaFileCache_CloseEntry(entry);
+        return NULL;
+    }
+    posix_fadvise(entry->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    strcpy(entry->filePath, filePath);
+    entry->lastAccessMs = nowMs;
+    entry->nextOffset = 0;
+    entry->readaheadEnd = 0;
+    s_mediaFileCacheStatistics.openCount++;
+
+    return entry;
+}
+
+static void DjiMediaFileCache_CloseEntry(T_DjiMediaFileCacheEntry *entry)
+{
+    if (entry->mediaFileHandle != NULL) {
+        DjiMediaFile_DestroyHandle(entry->mediaFileHandle);
+        entry->mediaFileHandle = NULL;
+    }
+    entry->fd = -1;
+    entry->filePath[0] = '\0';
+}
+
+/**
+ * @brief Keep a window of PSDK_MEDIA_FILE_CACHE_READAHEAD_CHUNKS chunks ahead of a sequential download in the
+ * page cache. The window is renewed when the reader has consumed half of it, a seek restarts it.
+ */
+static void DjiMediaFileCache_Readahead(T_DjiMediaFileCacheEntry *entry, uint64_t offset, uint32_t len)
+{
+    uint64_t window;
+
+    window = (uint64_t) len * PSDK_MEDIA_FILE_CACHE_READAHEAD_CHUNKS;
+    window = USER_UTIL_MAX(window, PSDK_MEDIA_FILE_CACHE_READAHEAD_MIN);
+    window = USER_UTIL_MIN(window, PSDK_MEDIA_FILE_CACHE_READAHEAD_MAX);
+
+    if (offset != entry->nextOffset) {
+        entry->readaheadEnd = 0;
+    }
+    if (offset + len + window / 2 <= entry->readaheadEnd) {
+        return;
+    }
+
+    posix_fadvise(entry->fd, (off_t) offset, (off_t) (len + window), POSIX_FADV_WILLNEED);
+    entry->readaheadEnd = offset + len + window;
+    s_mediaFileCacheStatistics.readaheadCount++;
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
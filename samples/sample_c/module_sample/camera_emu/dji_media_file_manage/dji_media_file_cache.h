@@ -0,0 +1,65 @@
+/**
+ ********************************************************************
+ * @file    dji_media_file_cache.h
+ * @brief   This is the header file for "dji_media_file_cache.c", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef PSDK_MEDIA_FILE_CACHE_H
+#define PSDK_MEDIA_FILE_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <dji_typedef.h>
+#include "dji_media_file_core.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define PSDK_MEDIA_FILE_CACHE_ENTRY_NUM            8
+#define PSDK_MEDIA_FILE_CACHE_IDLE_TIMEOUT_MS      10000
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+    uint32_t openCount;
+    uint32_t hitCount;
+    uint32_t readCount;
+    uint32_t readaheadCount;
+    uint64_t readBytes;
+} T_DjiMediaFileCacheStatistics;
+
+/* Exported functions --------------------------------------------------------*/
+T_DjiReturnCode DjiMediaFileCache_Init(void);
+T_DjiReturnCode DjiMediaFileCache_DeInit(void);
+T_DjiReturnCode DjiMediaFileCache_GetDataOrg(const char *filePath, uint32_t offset, uint32_t len,
+                                             uint8_t *data, uint32_t *realLen);
+T_DjiReturnCode DjiMediaFileCache_Invalidate(const char *filePath);
+void DjiMediaFileCache_GetStatistics(T_DjiMediaFileCacheStatistics *statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSDK_MEDIA_FILE_CACHE_H
+
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
@@ -23,15 +23,21 @@
  */
 
 /* Includes ------------------------------------------------------------------*/
+#include <errno.h>
+#include <fcntl.h>
 #include <string.h>
+#include <unistd.h>
 #include <dji_logger.h>
 
 #include "dji_media_file_core.h"
 #include "dji_media_file_jpg.h"
 #include "dji_media_file_mp4.h"
 #include "dji_platform.h"
+#include "utils/util_misc.h"
 
 /* Private constants ---------------------------------------------------------*/
+/* Length limit of the getDataOrgFunc entry, used when an item has no getDataOrgVecFunc. */
+#define PSDK_MEDIA_FILE_LEGACY_READ_LEN_MAX    UINT16_MAX
 
 /* Private types -------------------------------------------------------------*/
 
@@ -47,6 +53,7 @@ static const T_DjiMediaFileOptItem s_mediaFileOpt[] =
         DjiMediaFile_IsSupported_JPG,
         DjiMediaFile_GetAttrFunc_JPG,
         DjiMediaFile_GetDataOrigin_JPG,
+        DjiMediaFile_GetDataOrgVec_JPG,
         DjiMediaFile_GetFileSizeOrigin_JPG,
         DjiMediaFile_CreateThumbNail_JPG,
         DjiMediaFile_GetFileSizeThumbNail_JPG,
@@ -63,6 +70,7 @@ static const T_DjiMediaFileOptItem s_mediaFileOpt[] =
         DjiMediaFile_IsSupported_MP4,
         DjiMediaFile_GetAttrFunc_MP4,
         DjiMediaFile_GetDataOrigin_MP4,
+        DjiMediaFile_GetDataOrgVec_MP4,
         DjiMediaFile_GetFileSizeOrigin_MP4,
         DjiMediaFile_CreateThumbNail_MP4,
         DjiMediaFile_GetFileSizeThumbNail_MP4,
@@ -117,6 +125,7 @@ T_DjiReturnCode DjiMediaFile_CreateHandle(const char *filePath, T_DjiMediaFileHa
     }
 
     (*pMediaFileHandle)->mediaFileOptItem = s_mediaFileOpt[optIndex];
+    (*pMediaFileHandle)->orgFd = -1;
     (*pMediaFileHandle)->mediaFileThm.privThm = NULL;
     (*pMediaFileHandle)->mediaFileScr.privScr = NULL;
 
@@ -129,6 +138,9 @@ T_DjiReturnCode DjiMediaFile_DestroyHandle(T_DjiMediaFileHandle mediaFileHandle)
 {
     T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
 
+    if (mediaFileHandle->orgFd >= 0) {
+        close(mediaFileHandle->orgFd);
+    }
     osalHandler->Free(mediaFileHandle->filePath);
     osalHandler->Free(mediaFileHandle);
 
@@ -165,6 +177,69 @@ T_DjiReturnCode DjiMediaFile_GetDataOrg(struct _DjiMediaFile *mediaFileHandle, u
     return mediaFileHandle->mediaFileOptItem.getDataOrgFunc(mediaFileHandle, offset, len, data, realLen);
 }
 
+/**
+ * @brief Read original data at offset into a list of buffers, the length of a read is only limited by the buffers.
+ * @note Items without getDataOrgVecFunc are served by repeated getDataOrgFunc calls of up to 64 KB.
+ */
+T_DjiReturnCode DjiMediaFile_GetDataOrgVec(struct _DjiMediaFile *mediaFileHandle, uint32_t offset,
+                                           const struct iovec *iov, uint32_t iovCount, uint32_t *realLen)
+{
+    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    uint32_t totalLen = 0;
+    uint32_t bufferOffset;
+    uint32_t readLen;
+    uint32_t i;
+
+    if (mediaFileHandle->mediaFileOptItem.getDataOrgVecFunc != NULL) {
+        return mediaFileHandle->mediaFileOptItem.getDataOrgVecFunc(mediaFileHandle, offset, iov, iovCount, realLen);
+    }
+    if (mediaFileHandle->mediaFileOptItem.getDataOrgFunc == NULL) {
+        USER_LOG_ERROR("Media file handle getDataOrgFunc null error");
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    for (i = 0; i < iovCount; i++) {
+        for (bufferOffset = 0; bufferOffset < iov[i].iov_len; bufferOffset += readLen) {
+            readLen = 0;
+            returnCode = mediaFileHandle->mediaFileOptItem.getDataOrgFunc(
+                mediaFileHandle, offset + totalLen,
+                (uint16_t) USER_UTIL_MIN(iov[i].iov_len - bufferOffset, PSDK_MEDIA_FILE_LEGACY_READ_LEN_MAX),
+                (uint8_t *) iov[i].iov_base + bufferOffset, &readLen);
+            if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS || readLen == 0) {
+                goto out;
+            }
+            totalLen += readLen;
+        }
+    }
+
+out:
+    if (totalLen == 0) {
+        return returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS ? returnCode :
+               DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+    *realLen = totalLen;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Get the descriptor of the original file, it is opened on first use and closed with the handle.
+ */
+T_DjiReturnCode DjiMediaFile_GetFdOrg(struct _DjiMediaFile *mediaFileHandle, int *fd)
+{
+    if (mediaFileHandle->orgFd < 0) {
+        mediaFileHandle->orgFd = open(mediaFileHandle->filePath, O_RDONLY | O_CLOEXEC);
+        if (mediaFileHandle->orgFd < 0) {
+            USER_LOG_ERROR("Media file open error: %s, errno %d", mediaFileHandle->filePath, errno);
+            return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        }
+    }
+
+    *fd = mediaFileHandle->orgFd;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
 T_DjiReturnCode DjiMediaFile_GetFileSizeOrg(struct _DjiMediaFile *mediaFileHandle, uint32_t *fileSize)
 {
     if (mediaFileHandle->mediaFileOptItem.getFileSizeOrgFunc == NULL) {
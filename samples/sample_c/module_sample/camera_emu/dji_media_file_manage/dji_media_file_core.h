@@ -34,6 +34,7 @@ extern "C" {
 /* Includes ------------------------------------------------------------------*/
 #include <dji_typedef.h>
 #include <dji_payload_camera.h>
+#include <sys/uio.h>
 
 /* Exported constants --------------------------------------------------------*/
 #define PSDK_MEDIA_FILE_PATH_LEN_MAX           512             /*max file path len */
@@ -58,6 +59,8 @@ typedef struct {
 
     T_DjiReturnCode (*getDataOrgFunc)(struct _DjiMediaFile *mediaFileHandle, uint32_t offset, uint16_t len,
                                       uint8_t *data, uint32_t *realLen);
+    T_DjiReturnCode (*getDataOrgVecFunc)(struct _DjiMediaFile *mediaFileHandle, uint32_t offset,
+                                         const struct iovec *iov, uint32_t iovCount, uint32_t *realLen);
     T_DjiReturnCode (*getFileSizeOrgFunc)(struct _DjiMediaFile *mediaFileHandle, uint32_t *fileSize);
 
     T_DjiReturnCode (*createThmFunc)(struct _DjiMediaFile *mediaFileHandle);
@@ -75,6 +78,7 @@ typedef struct {
 
 typedef struct _DjiMediaFile {
     char *filePath;
+    int orgFd;
     T_DjiMediaFileOptItem mediaFileOptItem;
     T_DjiMediaFileThm mediaFileThm;
     T_DjiMediaFileScr mediaFileScr;
@@ -92,6 +96,9 @@ T_DjiReturnCode DjiMediaFile_GetMediaFileAttr(T_DjiMediaFileHandle mediaFileHand
 
 T_DjiReturnCode DjiMediaFile_GetDataOrg(struct _DjiMediaFile *mediaFileHandle, uint32_t offset, uint16_t len,
                                         uint8_t *data, uint32_t *realLen);
+T_DjiReturnCode DjiMediaFile_GetDataOrgVec(struct _DjiMediaFile *mediaFileHandle, uint32_t offset,
+                                           const struct iovec *iov, uint32_t iovCount, uint32_t *realLen);
+T_DjiReturnCode DjiMediaFile_GetFdOrg(struct _DjiMediaFile *mediaFileHandle, int *fd);
 T_DjiReturnCode DjiMediaFile_GetFileSizeOrg(struct _DjiMediaFile *mediaFileHandle, uint32_t *fileSize);
 
 T_DjiReturnCode DjiMediaFile_CreateThm(T_DjiMediaFileHandle mediaFileHandle);
@@ -26,6 +26,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include "dji_media_file_jpg.h"
 #include "dji_media_file_core.h"
+#include "dji_media_file_preview.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -38,23 +39,16 @@
 
 /* Private constants ---------------------------------------------------------*/
 #define JPG_FILE_SUFFIX                 ".jpg"
-#define JPG_TEMP_FILE_TEMPLATE_STR      "JPG_TEMP_XXXXXX.jpg"
-#define JPG_TEMP_FILE_PATH_MAX_LEN      50
-#define FFMPEG_CMD_BUF_SIZE             1024
-
-#define JPG_THM_SCALE_CFG_STR           "scale=100:-1"
-#define JPG_SCR_SCALE_CFG_STR           "scale=600:-1"
 
 /* Private types -------------------------------------------------------------*/
 typedef struct {
-    FILE *tempFile;
-    char tempfilePath[JPG_TEMP_FILE_PATH_MAX_LEN];
-} T_DjiJPGTempFilePriv;
+    FILE *previewFile;
+} T_DjiJPGPreviewPriv;
 
 /* Private functions declaration ---------------------------------------------*/
-static T_DjiReturnCode DjiMediaFile_CreateTempFilePriv_JPG(const char *srcFilePath, const char *scaleCfgStr,
-                                                           T_DjiJPGTempFilePriv **pTempFilePrivHandle);
-static T_DjiReturnCode DjiMediaFile_DestroyTempFilePriv_JPG(T_DjiJPGTempFilePriv *tempFilePrivHandle);
+static T_DjiReturnCode DjiMediaFile_CreatePreviewPriv_JPG(const char *srcFilePath, E_DjiMediaFilePreviewType type,
+                                                          T_DjiJPGPreviewPriv **pPreviewPrivHandle);
+static T_DjiReturnCode DjiMediaFile_DestroyPreviewPriv_JPG(T_DjiJPGPreviewPriv *previewPrivHandle);
 
 /* Exported functions definition ---------------------------------------------*/
 bool DjiMediaFile_IsSupported_JPG(const char *filePath)
@@ -84,7 +78,23 @@ T_DjiReturnCode DjiMediaFile_GetAttrFunc_JPG(struct _DjiMediaFile *mediaFileHand
 T_DjiReturnCode DjiMediaFile_GetDataOrigin_JPG(struct _DjiMediaFile *mediaFileHandle, uint32_t offset, uint16_t len,
                                                uint8_t *data, uint32_t *realLen)
 {
-    return UtilFile_GetFileDataByPath(mediaFileHandle->filePath, offset, len, data, realLen);
+    struct iovec iov = {data, len};
+
+    return DjiMediaFile_GetDataOrgVec_JPG(mediaFileHandle, offset, &iov, 1, realLen);
+}
+
+T_DjiReturnCode DjiMediaFile_GetDataOrgVec_JPG(struct _DjiMediaFile *mediaFileHandle, uint32_t offset,
+                                              const struct iovec *iov, uint32_t iovCount, uint32_t *realLen)
+{
+    T_DjiReturnCode psdkStat;
+    int fd;
+
+    psdkStat = DjiMediaFile_GetFdOrg(mediaFileHandle, &fd);
+    if (psdkStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return psdkStat;
+    }
+
+    return UtilFile_GetFileDataVec(fd, offset, iov, iovCount, realLen);
 }
 
 T_DjiReturnCode DjiMediaFile_GetFileSizeOrigin_JPG(struct _DjiMediaFile *mediaFileHandle, uint32_t *fileSize)
@@ -94,133 +104,87 @@ T_DjiReturnCode DjiMediaFile_GetFileSizeOrigin_JPG(struct _DjiMediaFile *mediaFi
 
 T_DjiReturnCode DjiMediaFile_CreateThumbNail_JPG(struct _DjiMediaFile *mediaFileHandle)
 {
-    return DjiMediaFile_CreateTempFilePriv_JPG(mediaFileHandle->filePath, JPG_THM_SCALE_CFG_STR,
-                                               (T_DjiJPGTempFilePriv **) &mediaFileHandle->mediaFileThm.privThm);
+    return DjiMediaFile_CreatePreviewPriv_JPG(mediaFileHandle->filePath, PSDK_MEDIA_FILE_PREVIEW_TYPE_THM,
+                                              (T_DjiJPGPreviewPriv **) &mediaFileHandle->mediaFileThm.privThm);
 }
 
 T_DjiReturnCode DjiMediaFile_GetFileSizeThumbNail_JPG(struct _DjiMediaFile *mediaFileHandle, uint32_t *fileSize)
 {
-    T_DjiJPGTempFilePriv *jpgFileThmPriv = (T_DjiJPGTempFilePriv *) mediaFileHandle->mediaFileThm.privThm;
+    T_DjiJPGPreviewPriv *jpgFileThmPriv = (T_DjiJPGPreviewPriv *) mediaFileHandle->mediaFileThm.privThm;
 
-    return UtilFile_GetFileSize(jpgFileThmPriv->tempFile, fileSize);
+    return UtilFile_GetFileSize(jpgFileThmPriv->previewFile, fileSize);
 }
 
 T_DjiReturnCode
 DjiMediaFile_GetDataThumbNail_JPG(struct _DjiMediaFile *mediaFileHandle, uint32_t offset, uint16_t len,
                                   uint8_t *data, uint16_t *realLen)
 {
-    T_DjiJPGTempFilePriv *jpgFileThmPriv = (T_DjiJPGTempFilePriv *) mediaFileHandle->mediaFileThm.privThm;
+    T_DjiJPGPreviewPriv *jpgFileThmPriv = (T_DjiJPGPreviewPriv *) mediaFileHandle->mediaFileThm.privThm;
 
-    return UtilFile_GetFileData(jpgFileThmPriv->tempFile, offset, len, data, realLen);
+    return UtilFile_GetFileData(jpgFileThmPriv->previewFile, offset, len, data, realLen);
 }
 
 T_DjiReturnCode DjiMediaFile_DestroyThumbNail_JPG(struct _DjiMediaFile *mediaFileHandle)
 {
-    return DjiMediaFile_DestroyTempFilePriv_JPG(mediaFileHandle->mediaFileThm.privThm);
+    return DjiMediaFile_DestroyPreviewPriv_JPG(mediaFileHandle->mediaFileThm.privThm);
 }
 
 T_DjiReturnCode DjiMediaFile_CreateScreenNail_JPG(struct _DjiMediaFile *mediaFileHandle)
 {
-    return DjiMediaFile_CreateTempFilePriv_JPG(mediaFileHandle->filePath, JPG_SCR_SCALE_CFG_STR,
-                                               (T_DjiJPGTempFilePriv **) &mediaFileHandle->mediaFileScr.privScr);
+    return DjiMediaFile_CreatePreviewPriv_JPG(mediaFileHandle->filePath, PSDK_MEDIA_FILE_PREVIEW_TYPE_SCR,
+                                              (T_DjiJPGPreviewPriv **) &mediaFileHandle->mediaFileScr.privScr);
 }
 
 T_DjiReturnCode DjiMediaFile_GetFileSizeScreenNail_JPG(struct _DjiMediaFile *mediaFileHandle, uint32_t *fileSize)
 {
-    T_DjiJPGTempFilePriv *jpgFileScrPriv = (T_DjiJPGTempFilePriv *) mediaFileHandle->mediaFileScr.privScr;
+    T_DjiJPGPreviewPriv *jpgFileScrPriv = (T_DjiJPGPreviewPriv *) mediaFileHandle->mediaFileScr.privScr;
 
-    return UtilFile_GetFileSize(jpgFileScrPriv->tempFile, fileSize);
+    return UtilFile_GetFileSize(jpgFileScrPriv->previewFile, fileSize);
 }
 
 T_DjiReturnCode
 DjiMediaFile_GetDataScreenNail_JPG(struct _DjiMediaFile *mediaFileHandle, uint32_t offset, uint16_t len,
                                    uint8_t *data, uint16_t *realLen)
 {
-    T_DjiJPGTempFilePriv *jpgFileScrPriv = (T_DjiJPGTempFilePriv *) mediaFileHandle->mediaFileScr.privScr;
+    T_DjiJPGPreviewPriv *jpgFileScrPriv = (T_DjiJPGPreviewPriv *) mediaFileHandle->mediaFileScr.privScr;
 
-    return UtilFile_GetFileData(jpgFileScrPriv->tempFile, offset, len, data, realLen);
+    return UtilFile_GetFileData(jpgFileScrPriv->previewFile, offset, len, data, realLen);
 }
 
 T_DjiReturnCode DjiMediaFile_DestroyScreenNail_JPG(struct _DjiMediaFile *mediaFileHandle)
 {
-    return DjiMediaFile_DestroyTempFilePriv_JPG(mediaFileHandle->mediaFileScr.privScr);
+    return DjiMediaFile_DestroyPreviewPriv_JPG(mediaFileHandle->mediaFileScr.privScr);
 }
 
 /* Private functions definition-----------------------------------------------*/
-static T_DjiReturnCode DjiMediaFile_CreateTempFilePriv_JPG(const char *srcFilePath, const char *scaleCfgStr,
-                                                           T_DjiJPGTempFilePriv **pTempFilePrivHandle)
+static T_DjiReturnCode DjiMediaFile_CreatePreviewPriv_JPG(const char *srcFilePath, E_DjiMediaFilePreviewType type,
+                                                          T_DjiJPGPreviewPriv **pPreviewPrivHandle)
 {
-    char ffmpeg_cmd[FFMPEG_CMD_BUF_SIZE];
-    int cmdRet;
-    T_DjiRunTimeStamps tiStart, tiEnd;
-    T_DjiJPGTempFilePriv *jpgTempFilePriv;
     T_DjiReturnCode psdkStat;
-    int tempFd;
     T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
 
-    tiStart = DjiUtilTime_GetRunTimeStamps();
-
-    *pTempFilePrivHandle = osalHandler->Malloc(sizeof(T_DjiJPGTempFilePriv));
-    if (*pTempFilePrivHandle == NULL) {
+    *pPreviewPrivHandle = osalHandler->Malloc(sizeof(T_DjiJPGPreviewPriv));
+    if (*pPreviewPrivHandle == NULL) {
         return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
     }
 
-    jpgTempFilePriv = *pTempFilePrivHandle;
-
-    //get temp file name
-    strcpy(jpgTempFilePriv->tempfilePath, JPG_TEMP_FILE_TEMPLATE_STR);
-    tempFd = mkstemps(jpgTempFilePriv->tempfilePath, strlen(JPG_FILE_SUFFIX));
-    if (tempFd < 0) {
-        USER_LOG_ERROR("JPG Create Temp File Error, tempFd = %d\n", tempFd);
-        psdkStat = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
-        goto err_create_temp;
-    }
-    close(tempFd);
-    unlink(jpgTempFilePriv->tempfilePath);
-
-    //ffmpeg cmd send
-    snprintf(ffmpeg_cmd, FFMPEG_CMD_BUF_SIZE, "ffmpeg -i \"%s\" -vf %s %s 1>/dev/null 2>&1",
-             srcFilePath, scaleCfgStr, jpgTempFilePriv->tempfilePath);
-
-    cmdRet = system(ffmpeg_cmd);
-
-    tiEnd = DjiUtilTime_GetRunTimeStamps();
-
-    USER_LOG_DEBUG("JPG Create TempFile, RealTime = %ld us\n", tiEnd.realUsec - tiStart.realUsec);
-
-    if (cmdRet != 0) {
-        USER_LOG_ERROR("JPG ffmpeg cmd call error, ret = %d\n", cmdRet);
-        psdkStat = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
-        goto err_system_cmd;
+    //the preview is generated on first use and served from the preview cache afterwards
+    psdkStat = DjiMediaFilePreview_Open(srcFilePath, type, &(*pPreviewPrivHandle)->previewFile);
+    if (psdkStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("JPG open preview error, stat = 0x%08llX\n", psdkStat);
+        osalHandler->Free(*pPreviewPrivHandle);
+        return psdkStat;
     }
 
-    //open temp file
-    jpgTempFilePriv->tempFile = fopen(jpgTempFilePriv->tempfilePath, "rb+");
-    if (jpgTempFilePriv->tempFile == NULL) {
-        psdkStat = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
-        goto err_file_open;
-    }
-
-    //unlink temp file
-    unlink(jpgTempFilePriv->tempfilePath);
-
     return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
-
-err_file_open:
-    unlink(jpgTempFilePriv->tempfilePath);
-err_system_cmd:
-err_create_temp:
-    osalHandler->Free(*pTempFilePrivHandle);
-
-    return psdkStat;
 }
 
-static T_DjiReturnCode DjiMediaFile_DestroyTempFilePriv_JPG(T_DjiJPGTempFilePriv *tempFilePrivHandle)
+static T_DjiReturnCode DjiMediaFile_DestroyPreviewPriv_JPG(T_DjiJPGPreviewPriv *previewPrivHandle)
 {
     T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
 
-    fclose(tempFilePrivHandle->tempFile);
-    osalHandler->Free(tempFilePrivHandle);
+    fclose(previewPrivHandle->previewFile);
+    osalHandler->Free(previewPrivHandle);
 
     return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
 }
@@ -50,6 +50,8 @@ T_DjiReturnCode DjiMediaFile_GetAttrFunc_JPG(struct _DjiMediaFile *mediaFileHand
 
 T_DjiReturnCode DjiMediaFile_GetDataOrigin_JPG(struct _DjiMediaFile *mediaFileHandle, uint32_t offset, uint16_t len,
                                                uint8_t *data, uint32_t *realLen);
+T_DjiReturnCode DjiMediaFile_GetDataOrgVec_JPG(struct _DjiMediaFile *mediaFileHandle, uint32_t offset,
+                                              const struct iovec *iov, uint32_t iovCount, uint32_t *realLen);
 T_DjiReturnCode DjiMediaFile_GetFileSizeOrigin_JPG(struct _DjiMediaFile *mediaFileHandle, uint32_t *fileSize);
 
 T_DjiReturnCode DjiMediaFile_CreateThumbNail_JPG(struct _DjiMediaFile *mediaFileHandle);
@@ -26,6 +26,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include "dji_media_file_mp4.h"
 #include "dji_media_file_core.h"
+#include "dji_media_file_preview.h"
 #include <string.h>
 #include <unistd.h>
 #include <stdio.h>
@@ -35,26 +36,25 @@
 #include "utils/util_time.h"
 #include "utils/util_file.h"
 
+#ifdef FFMPEG_INSTALLED
+#include <libavformat/avformat.h>
+#endif
+
 /* Private constants ---------------------------------------------------------*/
 
 #define MP4_FILE_SUFFIX                 ".mp4"
-#define MP4_TEMP_FILE_TEMPLATE_STR      "MP4_TEMP_XXXXXX.jpg"
-#define MP4_TEMP_FILE_PATH_MAX_LEN      50
 #define FFMPEG_CMD_BUF_SIZE             (256 + 256)
 
-#define MP4_THM_SCALE_CFG_STR           "scale=100:-1"
-#define MP4_SCR_SCALE_CFG_STR           "scale=600:-1"
-
 /* Private types -------------------------------------------------------------*/
 typedef struct {
-    FILE *tempFile;
-    char tempfilePath[MP4_TEMP_FILE_PATH_MAX_LEN];
-} T_DjiMP4TempPicPriv;
+    FILE *previewFile;
+} T_DjiMP4PreviewPriv;
 
 /* Private functions declaration ---------------------------------------------*/
-static T_DjiReturnCode DjiMediaFile_CreateTempPicPriv_MP4(const char *srcFilePath, const char *scaleCfgStr,
-                                                          T_DjiMP4TempPicPriv **pTempPicPrivHandle);
-static T_DjiReturnCode DjiMediaFile_DestroyTempPicPriv_MP4(T_DjiMP4TempPicPriv *tempPicPrivHandle);
+static T_DjiReturnCode DjiMediaFile_CreatePreviewPriv_MP4(const char *srcFilePath, E_DjiMediaFilePreviewType type,
+                                                          T_DjiMP4PreviewPriv **pPreviewPrivHandle);
+static T_DjiReturnCode DjiMediaFile_DestroyPreviewPriv_MP4(T_DjiMP4PreviewPriv *previewPrivHandle);
+static T_DjiReturnCode DjiMediaFile_GetDuration_MP4(const char *filePath, float *durationS);
 
 /* Private values ------------------------------------------------------------*/
 
@@ -76,28 +76,16 @@ bool DjiMediaFile_IsSupported_MP4(const char *filePath)
 T_DjiReturnCode DjiMediaFile_GetAttrFunc_MP4(struct _DjiMediaFile *mediaFileHandle,
                                              T_DjiCameraMediaFileAttr *mediaFileAttr)
 {
-    FILE *fp;
-    char ffmpegCmdStr[FFMPEG_CMD_BUF_SIZE];
-    float hour, minute, second;
-    char tempTailStr[128];
-    int ret;
+    float durationS;
     T_DjiReturnCode psdkStat;
 
-    snprintf(ffmpegCmdStr, FFMPEG_CMD_BUF_SIZE, "ffmpeg -i \"%s\" 2>&1 | grep \"Duration\"", mediaFileHandle->filePath);
-    fp = popen(ffmpegCmdStr, "r");
-
-    if (fp == NULL) {
-        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
-    }
-
-    ret = fscanf(fp, "  Duration: %f:%f:%f,%127s", &hour, &minute, &second, tempTailStr);
-    if (ret <= 0) {
+    psdkStat = DjiMediaFile_GetDuration_MP4(mediaFileHandle->filePath, &durationS);
+    if (psdkStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
         USER_LOG_ERROR("MP4 File Get Duration Error\n");
-        psdkStat = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
-        goto out;
+        return psdkStat;
     }
 
-    mediaFileAttr->attrVideoDuration = (uint32_t) (hour * 3600 + minute * 60 + second + 0.5);
+    mediaFileAttr->attrVideoDuration = (uint32_t) (durationS + 0.5f);
 
     /*! The user needs to obtain the frame rate and resolution of the video file by ffmpeg tools.
      * Also the frame rate and resolution of video need convert to enum E_DjiCameraVideoFrameRate or
@@ -106,18 +94,29 @@ T_DjiReturnCode DjiMediaFile_GetAttrFunc_MP4(struct _DjiMediaFile *mediaFileHand
     mediaFileAttr->attrVideoFrameRate = DJI_CAMERA_VIDEO_FRAME_RATE_30_FPS;
     mediaFileAttr->attrVideoResolution = DJI_CAMERA_VIDEO_RESOLUTION_1920x1080;
 
-    psdkStat = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
-
-out:
-    pclose(fp);
-
-    return psdkStat;
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
 }
 
 T_DjiReturnCode DjiMediaFile_GetDataOrigin_MP4(struct _DjiMediaFile *mediaFileHandle, uint32_t offset, uint16_t len,
                                                uint8_t *data, uint32_t *realLen)
 {
-    return UtilFile_GetFileDataByPath(mediaFileHandle->filePath, offset, len, data, realLen);
+    struct iovec iov = {data, len};
+
+    return DjiMediaFile_GetDataOrgVec_MP4(mediaFileHandle, offset, &iov, 1, realLen);
+}
+
+T_DjiReturnCode DjiMediaFile_GetDataOrgVec_MP4(struct _DjiMediaFile *mediaFileHandle, uint32_t offset,
+                                              const struct iovec *iov, uint32_t iovCount, uint32_t *realLen)
+{
+    T_DjiReturnCode psdkStat;
+    int fd;
+
+    psdkStat = DjiMediaFile_GetFdOrg(mediaFileHandle, &fd);
+    if (psdkStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return psdkStat;
+    }
+
+    return UtilFile_GetFileDataVec(fd, offset, iov, iovCount, realLen);
 }
 
 T_DjiReturnCode DjiMediaFile_GetFileSizeOrigin_MP4(struct _DjiMediaFile *mediaFileHandle, uint32_t *fileSize)
@@ -128,135 +127,157 @@ T_DjiReturnCode DjiMediaFile_GetFileSizeOrigin_MP4(struct _DjiMediaFile *mediaFi
 T_DjiReturnCode DjiMediaFile_CreateThumbNail_MP4(struct _DjiMediaFile *mediaFileHandle)
 {
 
-    return DjiMediaFile_CreateTempPicPriv_MP4(mediaFileHandle->filePath, MP4_THM_SCALE_CFG_STR,
-                                              (T_DjiMP4TempPicPriv **) &mediaFileHandle->mediaFileThm.privThm);
+    return DjiMediaFile_CreatePreviewPriv_MP4(mediaFileHandle->filePath, PSDK_MEDIA_FILE_PREVIEW_TYPE_THM,
+                                              (T_DjiMP4PreviewPriv **) &mediaFileHandle->mediaFileThm.privThm);
 }
 
 T_DjiReturnCode DjiMediaFile_GetFileSizeThumbNail_MP4(struct _DjiMediaFile *mediaFileHandle, uint32_t *fileSize)
 {
-    T_DjiMP4TempPicPriv *jpgFileThmPriv = (T_DjiMP4TempPicPriv *) mediaFileHandle->mediaFileThm.privThm;
+    T_DjiMP4PreviewPriv *jpgFileThmPriv = (T_DjiMP4PreviewPriv *) mediaFileHandle->mediaFileThm.privThm;
 
-    return UtilFile_GetFileSize(jpgFileThmPriv->tempFile, fileSize);
+    return UtilFile_GetFileSize(jpgFileThmPriv->previewFile, fileSize);
 }
 
 T_DjiReturnCode
 DjiMediaFile_GetDataThumbNail_MP4(struct _DjiMediaFile *mediaFileHandle, uint32_t offset, uint16_t len,
                                   uint8_t *data, uint16_t *realLen)
 {
-    T_DjiMP4TempPicPriv *jpgFileThmPriv = (T_DjiMP4TempPicPriv *) mediaFileHandle->mediaFileThm.privThm;
+    T_DjiMP4PreviewPriv *jpgFileThmPriv = (T_DjiMP4PreviewPriv *) mediaFileHandle->mediaFileThm.privThm;
 
-    return UtilFile_GetFileData(jpgFileThmPriv->tempFile, offset, len, data, realLen);
+    return UtilFile_GetFileData(jpgFileThmPriv->previewFile, offset, len, data, realLen);
 }
 
 T_DjiReturnCode DjiMediaFile_DestroyThumbNail_MP4(struct _DjiMediaFile *MediaFileHandle)
 {
-    return DjiMediaFile_DestroyTempPicPriv_MP4(MediaFileHandle->mediaFileThm.privThm);
+    return DjiMediaFile_DestroyPreviewPriv_MP4(MediaFileHandle->mediaFileThm.privThm);
 }
 
 T_DjiReturnCode DjiMediaFile_CreateScreenNail_MP4(struct _DjiMediaFile *mediaFileHandle)
 {
-    return DjiMediaFile_CreateTempPicPriv_MP4(mediaFileHandle->filePath, MP4_SCR_SCALE_CFG_STR,
-                                              (T_DjiMP4TempPicPriv **) &mediaFileHandle->mediaFileScr.privScr);
+    return DjiMediaFile_CreatePreviewPriv_MP4(mediaFileHandle->filePath, PSDK_MEDIA_FILE_PREVIEW_TYPE_SCR,
+                                              (T_DjiMP4PreviewPriv **) &mediaFileHandle->mediaFileScr.privScr);
 }
 
 T_DjiReturnCode DjiMediaFile_GetFileSizeScreenNail_MP4(struct _DjiMediaFile *mediaFileHandle, uint32_t *fileSize)
 {
-    T_DjiMP4TempPicPriv *jpgFileScrPriv = (T_DjiMP4TempPicPriv *) mediaFileHandle->mediaFileScr.privScr;
+    T_DjiMP4PreviewPriv *jpgFileScrPriv = (T_DjiMP4PreviewPriv *) mediaFileHandle->mediaFileScr.privScr;
 
-    return UtilFile_GetFileSize(jpgFileScrPriv->tempFile, fileSize);
+    return UtilFile_GetFileSize(jpgFileScrPriv->previewFile, fileSize);
 }
 
 T_DjiReturnCode
 DjiMediaFile_GetDataScreenNail_MP4(struct _DjiMediaFile *mediaFileHandle, uint32_t offset, uint16_t len,
                                    uint8_t *data, uint16_t *realLen)
 {
-    T_DjiMP4TempPicPriv *jpgFileScrPriv = (T_DjiMP4TempPicPriv *) mediaFileHandle->mediaFileScr.privScr;
+    T_DjiMP4PreviewPriv *jpgFileScrPriv = (T_DjiMP4PreviewPriv *) mediaFileHandle->mediaFileScr.privScr;
 
-    return UtilFile_GetFileData(jpgFileScrPriv->tempFile, offset, len, data, realLen);
+    return UtilFile_GetFileData(jpgFileScrPriv->previewFile, offset, len, data, realLen);
 }
 
 T_DjiReturnCode DjiMediaFile_DestroyScreenNail_MP4(struct _DjiMediaFile *mediaFileHandle)
 {
-    return DjiMediaFile_DestroyTempPicPriv_MP4(mediaFileHandle->mediaFileScr.privScr);
+    return DjiMediaFile_DestroyPreviewPriv_MP4(mediaFileHandle->mediaFileScr.privScr);
 }
 
 /* Private functions definition-----------------------------------------------*/
-static T_DjiReturnCode DjiMediaFile_CreateTempPicPriv_MP4(const char *srcFilePath, const char *scaleCfgStr,
-                                                          T_DjiMP4TempPicPriv **pTempPicPrivHandle)
+static T_DjiReturnCode DjiMediaFile_CreatePreviewPriv_MP4(const char *srcFilePath, E_DjiMediaFilePreviewType type,
+                                                          T_DjiMP4PreviewPriv **pPreviewPrivHandle)
 {
-    char ffmpeg_cmd[FFMPEG_CMD_BUF_SIZE];
-    int cmdRet;
-    T_DjiRunTimeStamps tiStart, tiEnd;
-    T_DjiMP4TempPicPriv *mp4TempPicFile;
     T_DjiReturnCode psdkStat;
-    int tempFd;
     T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
 
-    tiStart = DjiUtilTime_GetRunTimeStamps();
-
-    *pTempPicPrivHandle = osalHandler->Malloc(sizeof(T_DjiMP4TempPicPriv));
-    if (*pTempPicPrivHandle == NULL) {
+    *pPreviewPrivHandle = osalHandler->Malloc(sizeof(T_DjiMP4PreviewPriv));
+    if (*pPreviewPrivHandle == NULL) {
         return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
     }
 
-    mp4TempPicFile = *pTempPicPrivHandle;
-
-    //get temp file name
-    strcpy(mp4TempPicFile->tempfilePath, MP4_TEMP_FILE_TEMPLATE_STR);
-    tempFd = mkstemps(mp4TempPicFile->tempfilePath, strlen(MP4_FILE_SUFFIX));
-    if (tempFd < 0) {
-        USER_LOG_ERROR("JPG Create Temp File Error, tempFd = %d\n", tempFd);
-        psdkStat = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
-        goto err_create_temp;
+    //the preview is generated on first use and served from the preview cache afterwards
+    psdkStat = DjiMediaFilePreview_Open(srcFilePath, type, &(*pPreviewPrivHandle)->previewFile);
+    if (psdkStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("MP4 open preview error, stat = 0x%08llX\n", psdkStat);
+        osalHandler->Free(*pPreviewPrivHandle);
+        return psdkStat;
     }
-    close(tempFd);
-    unlink(mp4TempPicFile->tempfilePath);
 
-    //ffmpeg cmd send
-    snprintf(ffmpeg_cmd, FFMPEG_CMD_BUF_SIZE, "ffmpeg -i \"%s\" -vf %s -ss 00:00:00 -vframes 1 %s 1>/dev/null 2>&1",
-             srcFilePath, scaleCfgStr, mp4TempPicFile->tempfilePath);
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
 
-    cmdRet = system(ffmpeg_cmd);
+static T_DjiReturnCode DjiMediaFile_DestroyPreviewPriv_MP4(T_DjiMP4PreviewPriv *previewPrivHandle)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
 
-    tiEnd = DjiUtilTime_GetRunTimeStamps();
+    fclose(previewPrivHandle->previewFile);
+    osalHandler->Free(previewPrivHandle);
 
-    USER_LOG_DEBUG("JPG Create TempFile, RealTime = %ld us\n", tiEnd.realUsec - tiStart.realUsec);
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
 
-    if (cmdRet != 0) {
-        USER_LOG_ERROR("JPG ffmpeg cmd call error, ret = %d\n", cmdRet);
-        psdkStat = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
-        goto err_system_cmd;
+#ifdef FFMPEG_INSTALLED
+
+/**
+ * @brief Read the duration from the container header, no frame is decoded.
+ */
+static T_DjiReturnCode DjiMediaFile_GetDuration_MP4(const char *filePath, float *durationS)
+{
+    AVFormatContext *formatContext = NULL;
+    T_DjiReturnCode psdkStat = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    int ret;
+
+    ret = avformat_open_input(&formatContext, filePath, NULL, NULL);
+    if (ret < 0) {
+        USER_LOG_ERROR("MP4 open %s error: %s\n", filePath, av_err2str(ret));
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
     }
 
-    //open temp file
-    mp4TempPicFile->tempFile = fopen(mp4TempPicFile->tempfilePath, "rb+");
-    if (mp4TempPicFile->tempFile == NULL) {
+    if (formatContext->duration == AV_NOPTS_VALUE) {
+        avformat_find_stream_info(formatContext, NULL);
+    }
+    if (formatContext->duration == AV_NOPTS_VALUE || formatContext->duration < 0) {
         psdkStat = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
-        goto err_file_open;
+        goto out;
     }
 
-    //unlink temp file
-    unlink(mp4TempPicFile->tempfilePath);
+    *durationS = (float) formatContext->duration / AV_TIME_BASE;
 
-    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
-
-err_file_open:
-    unlink(mp4TempPicFile->tempfilePath);
-err_system_cmd:
-err_create_temp:
-    osalHandler->Free(*pTempPicPrivHandle);
+out:
+    avformat_close_input(&formatContext);
 
     return psdkStat;
 }
 
-static T_DjiReturnCode DjiMediaFile_DestroyTempPicPriv_MP4(T_DjiMP4TempPicPriv *tempPicPrivHandle)
+#else
+
+static T_DjiReturnCode DjiMediaFile_GetDuration_MP4(const char *filePath, float *durationS)
 {
-    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    FILE *fp;
+    char ffmpegCmdStr[FFMPEG_CMD_BUF_SIZE];
+    float hour, minute, second;
+    char tempTailStr[128];
+    int ret;
+    T_DjiReturnCode psdkStat;
 
-    fclose(tempPicPrivHandle->tempFile);
-    osalHandler->Free(tempPicPrivHandle);
+    snprintf(ffmpegCmdStr, FFMPEG_CMD_BUF_SIZE, "ffmpeg -i \"%s\" 2>&1 | grep \"Duration\"", filePath);
+    fp = popen(ffmpegCmdStr, "r");
 
-    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    if (fp == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    ret = fscanf(fp, "  Duration: %f:%f:%f,%127s", &hour, &minute, &second, tempTailStr);
+    if (ret <= 0) {
+        psdkStat = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        goto out;
+    }
+
+    *durationS = hour * 3600 + minute * 60 + second;
+    psdkStat = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+
+out:
+    pclose(fp);
+
+    return psdkStat;
 }
 
+#endif
+
 /****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,691 @@
+/**
+ ********************************************************************
+ * @file    dji_media_file_preview.c
+ * @brief   The file defines the thumbnail and screennail cache of media files. Previews are generated once,
+ *          stored next to the media files keyed by path, size and modify time, and reused afterwards.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <dirent.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <dji_logger.h>
+
+#include "dji_media_file_preview.h"
+#include "dji_platform.h"
+#include "utils/util_misc.h"
+
+#if defined(FFMPEG_INSTALLED) && defined(FFMPEG_SWSCALE_INSTALLED)
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+#endif
+
+/* Private constants ---------------------------------------------------------*/
+#define PSDK_MEDIA_FILE_PREVIEW_SUFFIX              ".jpg"
+#define PSDK_MEDIA_FILE_PREVIEW_TEMP_SUFFIX         ".part"
+#define PSDK_MEDIA_FILE_PREVIEW_SUFFIX_LEN_MAX      16
+#define PSDK_MEDIA_FILE_PREVIEW_JPEG_QSCALE         3
+#define PSDK_MEDIA_FILE_PREVIEW_STOP_TIMEOUT_MS     5000
+#define PSDK_MEDIA_FILE_PREVIEW_FNV_OFFSET_BASIS    0xcbf29ce484222325ULL
+#define PSDK_MEDIA_FILE_PREVIEW_FNV_PRIME           0x100000001b3ULL
+#define FFMPEG_CMD_BUF_SIZE                         (PSDK_MEDIA_FILE_PATH_LEN_MAX * 2 + 256)
+
+/* Private types -------------------------------------------------------------*/
+
+/* Private functions declaration ---------------------------------------------*/
+static uint64_t DjiMediaFilePreview_Hash(uint64_t hash, const void *data, uint32_t len);
+static T_DjiReturnCode DjiMediaFilePreview_Prepare(const char *filePath, E_DjiMediaFilePreviewType type,
+                                                   char *cachePath, uint32_t cachePathSize);
+static T_DjiReturnCode DjiMediaFilePreview_Generate(const char *filePath, E_DjiMediaFilePreviewType type,
+                                                    const char *cachePath);
+static T_DjiReturnCode DjiMediaFilePreview_Encode(const char *filePath, uint32_t width, const char *outPath);
+static void DjiMediaFilePreview_WarmPath(const char *path);
+static void DjiMediaFilePreview_WarmFile(const char *filePath);
+static void *DjiMediaFilePreview_WarmTask(void *arg);
+
+/* Private values ------------------------------------------------------------*/
+static const char *s_previewTypeName[PSDK_MEDIA_FILE_PREVIEW_TYPE_NUM] = {"thm", "scr"};
+static const uint32_t s_previewWidth[PSDK_MEDIA_FILE_PREVIEW_TYPE_NUM] = {
+    PSDK_MEDIA_FILE_PREVIEW_THM_WIDTH,
+    PSDK_MEDIA_FILE_PREVIEW_SCR_WIDTH,
+};
+static T_DjiMutexHandle s_previewMutex = NULL;
+static T_DjiMutexHandle s_previewGenerateMutex = NULL;
+static T_DjiSemaHandle s_previewWarmSema = NULL;
+static T_DjiSemaHandle s_previewWarmExitSema = NULL;
+static T_DjiTaskHandle s_previewWarmTask = NULL;
+static char *s_previewWarmQueue[PSDK_MEDIA_FILE_PREVIEW_WARM_QUEUE_SIZE];
+static uint32_t s_previewWarmQueueHead = 0;
+static uint32_t s_previewWarmQueueCount = 0;
+static volatile bool s_previewWarmStopRequest = false;
+static T_DjiMediaFilePreviewStatistics s_previewStatistics;
+
+/* Exported functions definition ---------------------------------------------*/
+T_DjiReturnCode DjiMediaFilePreview_Init(void)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiReturnCode returnCode;
+
+    if (s_previewMutex != NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    memset(&s_previewStatistics, 0, sizeof(s_previewStatistics));
+    s_previewWarmQueueHead = 0;
+    s_previewWarmQueueCount = 0;
+    s_previewWarmStopRequest = false;
+
+    returnCode = osalHandler->MutexCreate(&s_previewMutex);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Media file preview mutex create error stat:0x%08llX", returnCode);
+        goto err;
+    }
+    returnCode = osalHandler->MutexCreate(&s_previewGenerateMutex);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Media file preview mutex create error stat:0x%08llX", returnCode);
+        goto err;
+    }
+    returnCode = osalHandler->SemaphoreCreate(0, &s_previewWarmSema);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Media file preview semaphore create error stat:0x%08llX", returnCode);
+        goto err;
+    }
+    returnCode = osalHandler->SemaphoreCreate(0, &s_previewWarmExitSema);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Media file preview semaphore create error stat:0x%08llX", returnCode);
+        goto err;
+    }
+
+    returnCode = osalHandler->TaskCreate("media_preview_warm", DjiMediaFilePreview_WarmTask, 2048, NULL,
+                                         &s_previewWarmTask);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Media file preview task create error stat:0x%08llX", returnCode);
+        s_previewWarmTask = NULL;
+        goto err;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+
+err:
+    DjiMediaFilePreview_DeInit();
+    return returnCode;
+}
+
+T_DjiReturnCode DjiMediaFilePreview_DeInit(void)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    if (s_previewWarmTask != NULL) {
+        s_previewWarmStopRequest = true;
+        osalHandler->SemaphorePost(s_previewWarmSema);
+        if (osalHandler->SemaphoreTimedWait(s_previewWarmExitSema, PSDK_MEDIA_FILE_PREVIEW_STOP_TIMEOUT_MS) !=
+            DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            USER_LOG_WARN("Media file preview warm task stop timeout.");
+        }
+        osalHandler->TaskDestroy(s_previewWarmTask);
+        s_previewWarmTask = NULL;
+    }
+
+    while (s_previewWarmQueueCount > 0) {
+        osalHandler->Free(s_previewWarmQueue[s_previewWarmQueueHead]);
+        s_previewWarmQueueHead = (s_previewWarmQueueHead + 1) % PSDK_MEDIA_FILE_PREVIEW_WARM_QUEUE_SIZE;
+        s_previewWarmQueueCount--;
+    }
+
+    if (s_previewWarmExitSema != NULL) {
+        osalHandler->SemaphoreDestroy(s_previewWarmExitSema);
+        s_previewWarmExitSema = NULL;
+    }
+    if (s_previewWarmSema != NULL) {
+        osalHandler->SemaphoreDestroy(s_previewWarmSema);
+        s_previewWarmSema = NULL;
+    }
+    if (s_previewGenerateMutex != NULL) {
+        osalHandler->MutexDestroy(s_previewGenerateMutex);
+        s_previewGenerateMutex = NULL;
+    }
+    if (s_previewMutex != NULL) {
+        osalHandler->MutexDestroy(s_previewMutex);
+        s_previewMutex = NULL;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Get the cache path of a preview. The name is a hash of the media file path, size and modify time, so a
+ * replaced media file gets a new preview and the old one is never served.
+ */
+T_DjiReturnCode DjiMediaFilePreview_GetCachePath(const char *filePath, E_DjiMediaFilePreviewType type,
+                                                 char *cachePath, uint32_t cachePathSize)
+{
+    struct stat fileStat;
+    const char *fileName;
+    uint64_t key;
+    int64_t keyField;
+    int dirLen;
+    int ret;
+
+    if (filePath == NULL || cachePath == NULL || type >= PSDK_MEDIA_FILE_PREVIEW_TYPE_NUM) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    if (stat(filePath, &fileStat) != 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+    }
+
+    key = DjiMediaFilePreview_Hash(PSDK_MEDIA_FILE_PREVIEW_FNV_OFFSET_BASIS, filePath, strlen(filePath));
+    keyField = (int64_t) fileStat.st_size;
+    key = DjiMediaFilePreview_Hash(key, &keyField, sizeof(keyField));
+    keyField = (int64_t) fileStat.st_mtim.tv_sec;
+    key = DjiMediaFilePreview_Hash(key, &keyField, sizeof(keyField));
+    keyField = (int64_t) fileStat.st_mtim.tv_nsec;
+    key = DjiMediaFilePreview_Hash(key, &keyField, sizeof(keyField));
+
+    fileName = strrchr(filePath, '/');
+    fileName = fileName == NULL ? filePath : fileName + 1;
+    dirLen = (int) (fileName - filePath);
+
+    ret = snprintf(cachePath, cachePathSize, "%.*s%s", dirLen, filePath, PSDK_MEDIA_FILE_PREVIEW_CACHE_DIR_NAME);
+    if (ret < 0 || (uint32_t) ret >= cachePathSize) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
+    }
+    if (mkdir(cachePath, 0755) != 0 && errno != EEXIST) {
+        USER_LOG_ERROR("create preview cache directory %s error: %d.", cachePath, errno);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    ret = snprintf(cachePath, cachePathSize, "%.*s%s/%016llx_%s%s", dirLen, filePath,
+                   PSDK_MEDIA_FILE_PREVIEW_CACHE_DIR_NAME, (unsigned long long) key, s_previewTypeName[type],
+                   PSDK_MEDIA_FILE_PREVIEW_SUFFIX);
+    if (ret < 0 || (uint32_t) ret >= cachePathSize) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Open the preview of a media file for reading, generating it first if it is not in the cache yet.
+ * @note The returned file stays valid after the preview is removed from the cache, the caller closes it.
+ */
+T_DjiReturnCode DjiMediaFilePreview_Open(const char *filePath, E_DjiMediaFilePreviewType type, FILE **file)
+{
+    char cachePath[PSDK_MEDIA_FILE_PATH_LEN_MAX];
+    T_DjiReturnCode returnCode;
+
+    returnCode = DjiMediaFilePreview_Prepare(filePath, type, cachePath, sizeof(cachePath));
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return returnCode;
+    }
+
+    *file = fopen(cachePath, "rb");
+    if (*file == NULL) {
+        USER_LOG_ERROR("open preview %s error: %d.", cachePath, errno);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Queue a media file or a directory of media files for preview generation in the background, so the
+ * previews are ready when the media list is browsed.
+ */
+T_DjiReturnCode DjiMediaFilePreview_Warm(const char *path)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    uint32_t pathLen;
+    char *pathCopy;
+
+    if (path == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+    if (s_previewWarmTask == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE;
+    }
+
+    pathLen = strlen(path);
+    pathCopy = osalHandler->Malloc(pathLen + 1);
+    if (pathCopy == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+    memcpy(pathCopy, path, pathLen + 1);
+
+    osalHandler->MutexLock(s_previewMutex);
+    if (s_previewWarmQueueCount >= PSDK_MEDIA_FILE_PREVIEW_WARM_QUEUE_SIZE) {
+        s_previewStatistics.warmDropCount++;
+        osalHandler->MutexUnlock(s_previewMutex);
+        osalHandler->Free(pathCopy);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+    }
+    s_previewWarmQueue[(s_previewWarmQueueHead + s_previewWarmQueueCount) % PSDK_MEDIA_FILE_PREVIEW_WARM_QUEUE_SIZE] =
+        pathCopy;
+    s_previewWarmQueueCount++;
+    s_previewStatistics.warmCount++;
+    osalHandler->MutexUnlock(s_previewMutex);
+
+    osalHandler->SemaphorePost(s_previewWarmSema);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Remove the cached previews of a media file, call it before the media file itself is deleted.
+ */
+T_DjiReturnCode DjiMediaFilePreview_Remove(const char *filePath)
+{
+    char cachePath[PSDK_MEDIA_FILE_PATH_LEN_MAX];
+    T_DjiReturnCode returnCode;
+    int type;
+
+    for (type = 0; type < PSDK_MEDIA_FILE_PREVIEW_TYPE_NUM; type++) {
+        returnCode = DjiMediaFilePreview_GetCachePath(filePath, (E_DjiMediaFilePreviewType) type, cachePath,
+                                                      sizeof(cachePath));
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            return returnCode;
+        }
+        if (unlink(cachePath) != 0 && errno != ENOENT) {
+            USER_LOG_WARN("remove preview %s error: %d.", cachePath, errno);
+        }
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+void DjiMediaFilePreview_GetStatistics(T_DjiMediaFilePreviewStatistics *statistics)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    if (s_previewMutex == NULL) {
+        memset(statistics, 0, sizeof(T_DjiMediaFilePreviewStatistics));
+        return;
+    }
+
+    osalHandler->MutexLock(s_previewMutex);
+    *statistics = s_previewStatistics;
+    osalHandler->MutexUnlock(s_previewMutex);
+}
+
+/* Private functions definition-----------------------------------------------*/
+static uint64_t DjiMediaFilePreview_Hash(uint64_t hash, const void *data, uint32_t len)
+{
+    const uint8_t *bytes = data;
+    uint32_t i;
+
+    for (i = 0; i < len; i++) {
+        hash ^= bytes[i];
+        hash *= PSDK_MEDIA_FILE_PREVIEW_FNV_PRIME;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Make sure the preview is in the cache and return its path. Generation is serialized, a preview that was
+ * generated by the warm task while waiting is not generated again.
+ */
+static T_DjiReturnCode DjiMediaFilePreview_Prepare(const char *filePath, E_DjiMediaFilePreviewType type,
+                                                   char *cachePath, uint32_t cachePathSize)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+
+    if (s_previewMutex == NULL) {
+        USER_LOG_ERROR("Media file preview is not initialized.");
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE;
+    }
+
+    returnCode = DjiMediaFilePreview_GetCachePath(filePath, type, cachePath, cachePathSize);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Get preview cache path of %s error stat:0x%08llX", filePath, returnCode);
+        return returnCode;
+    }
+
+    if (access(cachePath, R_OK) == 0) {
+        osalHandler->MutexLock(s_previewMutex);
+        s_previewStatistics.hitCount++;
+        osalHandler->MutexUnlock(s_previewMutex);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    osalHandler->MutexLock(s_previewGenerateMutex);
+    if (access(cachePath, R_OK) != 0) {
+        returnCode = DjiMediaFilePreview_Generate(filePath, type, cachePath);
+    }
+    osalHandler->MutexUnlock(s_previewGenerateMutex);
+
+    return returnCode;
+}
+
+static T_DjiReturnCode DjiMediaFilePreview_Generate(const char *filePath, E_DjiMediaFilePreviewType type,
+                                                    const char *cachePath)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    char tempPath[PSDK_MEDIA_FILE_PATH_LEN_MAX + PSDK_MEDIA_FILE_PREVIEW_SUFFIX_LEN_MAX];
+    T_DjiReturnCode returnCode;
+    uint64_t startTimeUs = 0;
+    uint64_t endTimeUs = 0;
+    uint32_t costUs;
+
+    osalHandler->GetTimeUs(&startTimeUs);
+
+    //generate into a temp file and rename, a reader never sees a partial preview
+    snprintf(tempPath, sizeof(tempPath), "%s%s", cachePath, PSDK_MEDIA_FILE_PREVIEW_TEMP_SUFFIX);
+    returnCode = DjiMediaFilePreview_Encode(filePath, s_previewWidth[type], tempPath);
+    if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS && rename(tempPath, cachePath) != 0) {
+        USER_LOG_ERROR("rename preview %s error: %d.", tempPath, errno);
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        unlink(tempPath);
+    }
+
+    osalHandler->GetTimeUs(&endTimeUs);
+    costUs = (uint32_t) (endTimeUs - startTimeUs);
+
+    osalHandler->MutexLock(s_previewMutex);
+    if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        s_previewStatistics.generateCount++;
+        s_previewStatistics.generateTimeUs += costUs;
+        s_previewStatistics.generateTimeMaxUs = USER_UTIL_MAX(s_previewStatistics.generateTimeMaxUs, costUs);
+    } else {
+        s_previewStatistics.generateFailCount++;
+    }
+    osalHandler->MutexUnlock(s_previewMutex);
+
+    USER_LOG_DEBUG("Create %s preview of %s, RealTime = %u us, stat:0x%08llX", s_previewTypeName[type], filePath,
+                   costUs, returnCode);
+
+    return returnCode;
+}
+
+#if defined(FFMPEG_INSTALLED) && defined(FFMPEG_SWSCALE_INSTALLED)
+
+/**
+ * @brief Decode the first key frame of a picture or video, scale it to the preview width keeping the aspect ratio
+ * and encode it as JPEG.
+ */
+static T_DjiReturnCode DjiMediaFilePreview_Encode(const char *filePath, uint32_t width, const char *outPath)
+{
+    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    AVFormatContext *formatContext = NULL;
+    AVCodecContext *decoderContext = NULL;
+    AVCodecContext *encoderContext = NULL;
+    struct SwsContext *swsContext = NULL;
+    const AVCodec *decoder;
+    const AVCodec *encoder;
+    AVPacket *packet = NULL;
+    AVFrame *frame = NULL;
+    AVFrame *scaledFrame = NULL;
+    bool isInputFinished = false;
+    bool isFrameDecoded = false;
+    FILE *outFile;
+    int streamIndex;
+    int height;
+    int ret;
+
+    ret = avformat_open_input(&formatContext, filePath, NULL, NULL);
+    if (ret < 0) {
+        USER_LOG_ERROR("open %s error: %s.", filePath, av_err2str(ret));
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    streamIndex = av_find_best_stream(formatContext, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
+    if (streamIndex < 0) {
+        USER_LOG_ERROR("no picture in %s.", filePath);
+        goto out;
+    }
+
+    decoder = avcodec_find_decoder(formatContext->streams[streamIndex]->codecpar->codec_id);
+    decoderContext = avcodec_alloc_context3(decoder);
+    if (decoder == NULL || decoderContext == NULL ||
+        avcodec_parameters_to_context(decoderContext, formatContext->streams[streamIndex]->codecpar) < 0) {
+        USER_LOG_ERROR("create decoder of %s error.", filePath);
+        goto out;
+    }
+    //one key frame is needed, skip the others and do not wait for frame threads to fill up
+    decoderContext->skip_frame = AVDISCARD_NONKEY;
+    decoderContext->thread_count = 1;
+    ret = avcodec_open2(decoderContext, decoder, NULL);
+    if (ret < 0) {
+        USER_LOG_ERROR("open decoder of %s error: %s.", filePath, av_err2str(ret));
+        goto out;
+    }
+
+    packet = av_packet_alloc();
+    frame = av_frame_alloc();
+    scaledFrame = av_frame_alloc();
+    if (packet == NULL || frame == NULL || scaledFrame == NULL) {
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+        goto out;
+    }
+
+    while (!isFrameDecoded) {
+        if (!isInputFinished) {
+            ret = av_read_frame(formatContext, packet);
+            if (ret < 0) {
+                isInputFinished = true;
+                avcodec_send_packet(decoderContext, NULL);
+            } else {
+                ret = 0;
+                if (packet->stream_index == streamIndex && (packet->flags & AV_PKT_FLAG_KEY)) {
+                    ret = avcodec_send_packet(decoderContext, packet);
+                }
+                av_packet_unref(packet);
+                if (ret < 0 && ret != AVERROR(EAGAIN)) {
+                    USER_LOG_WARN("decode %s error: %s.", filePath, av_err2str(ret));
+                }
+            }
+        }
+
+        ret = avcodec_receive_frame(decoderContext, frame);
+        if (ret == 0) {
+            isFrameDecoded = true;
+        } else if (ret != AVERROR(EAGAIN) || isInputFinished) {
+            break;
+        }
+    }
+    if (!isFrameDecoded || frame->width <= 0 || frame->height <= 0) {
+        USER_LOG_ERROR("decode picture of %s error.", filePath);
+        goto out;
+    }
+
+    height = (int) ((int64_t) frame->height * width / frame->width) & ~1;
+    height = USER_UTIL_MAX(height, 2);
+    swsContext = sws_getContext(frame->width, frame->height, (enum AVPixelFormat) frame->format, (int) width,
+                                height, AV_PIX_FMT_YUVJ420P, SWS_BILINEAR, NULL, NULL, NULL);
+    scaledFrame->format = AV_PIX_FMT_YUVJ420P;
+    scaledFrame->width = (int) width;
+    scaledFrame->height = height;
+    if (swsContext == NULL || av_frame_get_buffer(scaledFrame, 0) < 0) {
+        USER_LOG_ERROR("create scaler of %s error.", filePath);
+        goto out;
+    }
+    sws_scale(swsContext, (const uint8_t *const *) frame->data, frame->linesize, 0, frame->height,
+              scaledFrame->data, scaledFrame->linesize);
+
+    encoder = avcodec_find_encoder(AV_CODEC_ID_MJPEG);
+    encoderContext = avcodec_alloc_context3(encoder);
+    if (encoder == NULL || encoderContext == NULL) {
+        USER_LOG_ERROR("create jpeg encoder error.");
+        goto out;
+    }
+    encoderContext->width = scaledFrame->width;
+    encoderContext->height = scaledFrame->height;
+    encoderContext->pix_fmt = AV_PIX_FMT_YUVJ420P;
+    encoderContext->time_base = (AVRational) {1, 25};
+    encoderContext->flags |= AV_CODEC_FLAG_QSCALE;
+    encoderContext->global_quality = FF_QP2LAMBDA * PSDK_MEDIA_FILE_PREVIEW_JPEG_QSCALE;
+    scaledFrame->quality = encoderContext->global_quality;
+    scaledFrame->pts = 0;
+    ret = avcodec_open2(encoderContext, encoder, NULL);
+    if (ret < 0) {
+        USER_LOG_ERROR("open jpeg encoder error: %s.", av_err2str(ret));
+        goto out;
+    }
+
+    ret = avcodec_send_frame(encoderContext, scaledFrame);
+    if (ret >= 0) {
+        avcodec_send_frame(encoderContext, NULL);
+        ret = avcodec_receive_packet(encoderContext, packet);
+    }
+    if (ret < 0) {
+        USER_LOG_ERROR("encode preview of %s error: %s.", filePath, av_err2str(ret));
+        goto out;
+    }
+
+    outFile = fopen(outPath, "wb");
+    if (outFile == NULL) {
+        USER_LOG_ERROR("create preview %s error: %d.", outPath, errno);
+        av_packet_unref(packet);
+        goto out;
+    }
+    if (fwrite(packet->data, 1, packet->size, outFile) == (size_t) packet->size) {
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+    if (fclose(outFile) != 0) {
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+    av_packet_unref(packet);
+
+out:
+    sws_freeContext(swsContext);
+    avcodec_free_context(&encoderContext);
+    avcodec_free_context(&decoderContext);
+    av_frame_free(&scaledFrame);
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+    avformat_close_input(&formatContext);
+
+    return returnCode;
+}
+
+#else
+
+static T_DjiReturnCode DjiMediaFilePreview_Encode(const char *filePath, uint32_t width, const char *outPath)
+{
+    char ffmpegCmd[FFMPEG_CMD_BUF_SIZE];
+    int cmdRet;
+
+    snprintf(ffmpegCmd, sizeof(ffmpegCmd),
+             "ffmpeg -i \"%s\" -vf scale=%u:-2 -frames:v 1 -f mjpeg -y \"%s\" 1>/dev/null 2>&1",
+             filePath, width, outPath);
+
+    cmdRet = system(ffmpegCmd);
+    if (cmdRet != 0) {
+        USER_LOG_ERROR("Preview ffmpeg cmd call error, ret = %d\n", cmdRet);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+#endif
+
+static void DjiMediaFilePreview_WarmFile(const char *filePath)
+{
+    char cachePath[PSDK_MEDIA_FILE_PATH_LEN_MAX];
+    int type;
+
+    for (type = 0; type < PSDK_MEDIA_FILE_PREVIEW_TYPE_NUM && !s_previewWarmStopRequest; type++) {
+        DjiMediaFilePreview_Prepare(filePath, (E_DjiMediaFilePreviewType) type, cachePath, sizeof(cachePath));
+    }
+}
+
+static void DjiMediaFilePreview_WarmPath(const char *path)
+{
+    char filePath[PSDK_MEDIA_FILE_PATH_LEN_MAX];
+    struct stat fileStat;
+    struct dirent *entry;
+    DIR *dir;
+    int ret;
+
+    if (stat(path, &fileStat) != 0) {
+        return;
+    }
+
+    if (!S_ISDIR(fileStat.st_mode)) {
+        if (S_ISREG(fileStat.st_mode) && DjiMediaFile_IsSupported(path)) {
+            DjiMediaFilePreview_WarmFile(path);
+        }
+        return;
+    }
+
+    dir = opendir(path);
+    if (dir == NULL) {
+        USER_LOG_WARN("open media directory %s error: %d.", path, errno);
+        return;
+    }
+
+    while ((entry = readdir(dir)) != NULL && !s_previewWarmStopRequest) {
+        //skip hidden entries, including the preview and remux caches
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+
+        ret = snprintf(filePath, sizeof(filePath), "%s/%s", path, entry->d_name);
+        if (ret < 0 || (uint32_t) ret >= sizeof(filePath)) {
+            continue;
+        }
+        if (stat(filePath, &fileStat) == 0 && S_ISREG(fileStat.st_mode) && DjiMediaFile_IsSupported(filePath)) {
+            DjiMediaFilePreview_WarmFile(filePath);
+        }
+    }
+
+    closedir(dir);
+}
+
+static void *DjiMediaFilePreview_WarmTask(void *arg)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    char *path;
+
+    USER_UTIL_UNUSED(arg);
+
+    while (!s_previewWarmStopRequest) {
+        osalHandler->SemaphoreWait(s_previewWarmSema);
+
+        osalHandler->MutexLock(s_previewMutex);
+        path = NULL;
+        if (s_previewWarmQueueCount > 0 && !s_previewWarmStopRequest) {
+            path = s_previewWarmQueue[s_previewWarmQueueHead];
+            s_previewWarmQueueHead = (s_previewWarmQueueHead + 1) % PSDK_MEDIA_FILE_PREVIEW_WARM_QUEUE_SIZE;
+            s_previewWarmQueueCount--;
+        }
+        osalHandler->MutexUnlock(s_previewMutex);
+
+        if (path != NULL) {
+            DjiMediaFilePreview_WarmPath(path);
+            osalHandler->Free(path);
+        }
+    }
+
+    osalHandler->SemaphorePost(s_previewWarmExitSema);
+
+    return NULL;
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,78 @@
+/**
+ ********************************************************************
+ * @file    dji_media_file_preview.h
+ * @brief   This is the header file for "dji_media_file_preview.c", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef PSDK_MEDIA_FILE_PREVIEW_H
+#define PSDK_MEDIA_FILE_PREVIEW_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <dji_typedef.h>
+#include "dji_media_file_core.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define PSDK_MEDIA_FILE_PREVIEW_CACHE_DIR_NAME      ".preview_cache"
+#define PSDK_MEDIA_FILE_PREVIEW_THM_WIDTH           100
+#define PSDK_MEDIA_FILE_PREVIEW_SCR_WIDTH           600
+#define PSDK_MEDIA_FILE_PREVIEW_WARM_QUEUE_SIZE     32
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum {
+    PSDK_MEDIA_FILE_PREVIEW_TYPE_THM = 0,
+    PSDK_MEDIA_FILE_PREVIEW_TYPE_SCR,
+    PSDK_MEDIA_FILE_PREVIEW_TYPE_NUM,
+} E_DjiMediaFilePreviewType;
+
+typedef struct {
+    uint32_t hitCount;
+    uint32_t generateCount;
+    uint32_t generateFailCount;
+    uint32_t warmCount;
+    uint32_t warmDropCount;
+    uint64_t generateTimeUs;
+    uint32_t generateTimeMaxUs;
+} T_DjiMediaFilePreviewStatistics;
+
+/* Exported functions --------------------------------------------------------*/
+T_DjiReturnCode DjiMediaFilePreview_Init(void);
+T_DjiReturnCode DjiMediaFilePreview_DeInit(void);
+T_DjiReturnCode DjiMediaFilePreview_GetCachePath(const char *filePath, E_DjiMediaFilePreviewType type,
+                                                 char *cachePath, uint32_t cachePathSize);
+T_DjiReturnCode DjiMediaFilePreview_Open(const char *filePath, E_DjiMediaFilePreviewType type, FILE **file);
+T_DjiReturnCode DjiMediaFilePreview_Warm(const char *path);
+T_DjiReturnCode DjiMediaFilePreview_Remove(const char *filePath);
+void DjiMediaFilePreview_GetStatistics(T_DjiMediaFilePreviewStatistics *statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSDK_MEDIA_FILE_PREVIEW_H
+
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
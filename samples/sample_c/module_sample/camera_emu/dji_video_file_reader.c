@@ -0,0 +1,135 @@
+/**
+ ********************************************************************
+ * @file    dji_video_file_reader.c
+ * @brief   The file defines the playback file reader of the camera emulator. The file is mapped once
+ * and frames are handed out as pointers into the mapping.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_video_file_reader.h"
+
+#ifdef SYSTEM_ARCH_LINUX
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "dji_logger.h"
+
+/* Private constants ---------------------------------------------------------*/
+
+/* Private types -------------------------------------------------------------*/
+
+/* Private functions declaration ---------------------------------------------*/
+static void DjiVideoFileReader_Advise(T_DjiVideoFileReader *reader, uint64_t position, uint32_t size);
+
+/* Private variables ---------------------------------------------------------*/
+
+/* Exported functions definition ---------------------------------------------*/
+T_DjiReturnCode DjiVideoFileReader_Open(T_DjiVideoFileReader *reader, const char *filePath)
+{
+    struct stat fileStat;
+    void *mapping;
+
+    memset(reader, 0, sizeof(T_DjiVideoFileReader));
+    reader->fd = open(filePath, O_RDONLY | O_CLOEXEC);
+    if (reader->fd < 0) {
+        USER_LOG_ERROR("open video file:\"%s\" fail:%d.", filePath, errno);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+    }
+
+    if (fstat(reader->fd, &fileStat) != 0 || fileStat.st_size == 0) {
+        USER_LOG_ERROR("video file:\"%s\" is empty.", filePath);
+        close(reader->fd);
+        reader->fd = -1;
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    mapping = mmap(NULL, (size_t) fileStat.st_size, PROT_READ, MAP_SHARED, reader->fd, 0);
+    if (mapping == MAP_FAILED) {
+        USER_LOG_ERROR("map video file:\"%s\" fail:%d.", filePath, errno);
+        close(reader->fd);
+        reader->fd = -1;
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    reader->data = mapping;
+    reader->size = (uint64_t) fileStat.st_size;
+    madvise(mapping, (size_t) reader->size, MADV_SEQUENTIAL);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Get a frame as a pointer into the mapped file, valid until the reader is closed.
+ */
+T_DjiReturnCode DjiVideoFileReader_GetFrame(T_DjiVideoFileReader *reader, uint64_t position, uint32_t size,
+                                            const uint8_t **frame)
+{
+    if (reader->data == NULL || position > reader->size || size > reader->size - position) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
+    }
+
+    if (position < reader->adviseStart || position + size > reader->adviseEnd) {
+        DjiVideoFileReader_Advise(reader, position, size);
+    }
+    *frame = reader->data + position;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+void DjiVideoFileReader_Close(T_DjiVideoFileReader *reader)
+{
+    if (reader->data != NULL) {
+        munmap((void *) reader->data, (size_t) reader->size);
+    }
+    if (reader->fd >= 0) {
+        close(reader->fd);
+    }
+    memset(reader, 0, sizeof(T_DjiVideoFileReader));
+    reader->fd = -1;
+}
+
+/* Private functions definition-----------------------------------------------*/
+/**
+ * @brief Ask the kernel to read in the window following position, so page faults on the send path are rare
+ * after a seek as well as during sequential playback.
+ */
+static void DjiVideoFileReader_Advise(T_DjiVideoFileReader *reader, uint64_t position, uint32_t size)
+{
+    uint64_t pageSize = (uint64_t) sysconf(_SC_PAGESIZE);
+    uint64_t start = position - position % pageSize;
+    uint64_t end = position + size + DJI_VIDEO_FILE_READER_READAHEAD_SIZE;
+
+    if (end > reader->size) {
+        end = reader->size;
+    }
+
+    madvise((void *) (reader->data + start), (size_t) (end - start), MADV_WILLNEED);
+    reader->adviseStart = start;
+    reader->adviseEnd = end;
+}
+
+#endif
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
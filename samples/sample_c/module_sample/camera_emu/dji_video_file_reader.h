@@ -0,0 +1,65 @@
+/**
+ ********************************************************************
+ * @file    dji_video_file_reader.h
+ * @brief   This is the header file for "dji_video_file_reader.c", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef DJI_VIDEO_FILE_READER_H
+#define DJI_VIDEO_FILE_READER_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_typedef.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef SYSTEM_ARCH_LINUX
+
+/* Exported constants --------------------------------------------------------*/
+/* Size of the window ahead of the current frame the kernel is asked to read in. */
+#define DJI_VIDEO_FILE_READER_READAHEAD_SIZE        (2 * 1024 * 1024)
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+    int fd;
+    const uint8_t *data;
+    uint64_t size;
+    uint64_t adviseStart;
+    uint64_t adviseEnd;
+} T_DjiVideoFileReader;
+
+/* Exported functions --------------------------------------------------------*/
+T_DjiReturnCode DjiVideoFileReader_Open(T_DjiVideoFileReader *reader, const char *filePath);
+T_DjiReturnCode DjiVideoFileReader_GetFrame(T_DjiVideoFileReader *reader, uint64_t position, uint32_t size,
+                                            const uint8_t **frame);
+void DjiVideoFileReader_Close(T_DjiVideoFileReader *reader);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DJI_VIDEO_FILE_READER_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
@@ -0,0 +1,512 @@
+/**
+ ********************************************************************
+ * @file    dji_video_remuxer.c
+ * @brief   The file defines the in-process remuxer used by the camera emulator playback. Video files
+ * are converted to H.264 Annex-B packet by packet and the output is cached for repeat playback.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_video_remuxer.h"
+
+#ifdef SYSTEM_ARCH_LINUX
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "dji_logger.h"
+#include "dji_platform.h"
+#include "utils/util_misc.h"
+#include "utils/util_async_writer.h"
+
+#ifdef FFMPEG_INSTALLED
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#if LIBAVCODEC_VERSION_MAJOR >= 59
+#include <libavcodec/bsf.h>
+#endif
+#endif
+
+/* Private constants ---------------------------------------------------------*/
+#define DJI_VIDEO_REMUXER_CACHE_DIR_NAME            ".remux_cache"
+#define DJI_VIDEO_REMUXER_INDEX_SUFFIX              ".idx"
+#define DJI_VIDEO_REMUXER_TEMP_SUFFIX               ".part"
+#define DJI_VIDEO_REMUXER_SUFFIX_LEN_MAX            16
+#define DJI_VIDEO_REMUXER_INDEX_MAGIC               0x58524A44 // "DJRX"
+#define DJI_VIDEO_REMUXER_INDEX_VERSION             1
+#define DJI_VIDEO_REMUXER_INDEX_INIT_CAPACITY       1024
+#define DJI_VIDEO_REMUXER_DEFAULT_FRAME_RATE        30.0f
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    float frameRate;
+    uint32_t frameCount;
+} T_DjiVideoRemuxerIndexHeader;
+
+#ifdef FFMPEG_INSTALLED
+typedef struct {
+    AVFormatContext *formatContext;
+    AVBSFContext *bsfContext;
+    AVPacket *inPacket;
+    AVPacket *outPacket;
+    int streamIndex;
+    AVRational timeBase;
+    float frameRate;
+    bool isInputFinished;
+    bool isReachEnd;
+    bool isCacheValid;
+    T_UtilAsyncWriterHandle cacheWriter;
+    char cachePath[DJI_VIDEO_REMUXER_PATH_LEN_MAX];
+    uint64_t cacheOffset;
+    T_DjiVideoRemuxerFrameInfo *frameIndex;
+    uint32_t frameIndexCount;
+    uint32_t frameIndexCapacity;
+} T_DjiVideoRemuxer;
+#endif
+
+/* Private functions declaration ---------------------------------------------*/
+#ifdef FFMPEG_INSTALLED
+static T_DjiReturnCode DjiVideoRemuxer_AppendCache(T_DjiVideoRemuxer *remuxer, const uint8_t *data, uint32_t len,
+                                                   const T_DjiVideoRemuxerFrameInfo *frameInfo);
+static T_DjiReturnCode DjiVideoRemuxer_CommitCache(T_DjiVideoRemuxer *remuxer);
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+
+/* Exported functions definition ---------------------------------------------*/
+/**
+ * @brief Get the cache path of the remuxed file, the cache is keyed by the source file name, size and modify time,
+ * so a replaced source file is remuxed again.
+ */
+T_DjiReturnCode DjiVideoRemuxer_GetCachePath(const char *inPath, char *cachePath, uint32_t cachePathSize)
+{
+    struct stat fileStat;
+    const char *fileName;
+    int dirLen;
+    int ret;
+
+    if (stat(inPath, &fileStat) != 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+    }
+
+    fileName = strrchr(inPath, '/');
+    fileName = fileName == NULL ? inPath : fileName + 1;
+    dirLen = (int) (fileName - inPath);
+
+    ret = snprintf(cachePath, cachePathSize, "%.*s%s", dirLen, inPath, DJI_VIDEO_REMUXER_CACHE_DIR_NAME);
+    if (ret < 0 || (uint32_t) ret >= cachePathSize) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
+    }
+    if (mkdir(cachePath, 0755) != 0 && errno != EEXIST) {
+        USER_LOG_ERROR("create remux cache directory %s error: %d.", cachePath, errno);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    ret = snprintf(cachePath, cachePathSize, "%.*s%s/%s_%llx_%llx.h264", dirLen, inPath,
+                   DJI_VIDEO_REMUXER_CACHE_DIR_NAME, fileName, (unsigned long long) fileStat.st_size,
+                   (unsigned long long) fileStat.st_mtime);
+    if (ret < 0 || (uint32_t) ret >= cachePathSize) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Load the frame index written next to a completed cache file.
+ * @return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND if the file has not been remuxed completely before.
+ */
+T_DjiReturnCode DjiVideoRemuxer_LoadCacheIndex(const char *cachePath, float *frameRate,
+                                               T_DjiVideoRemuxerFrameInfo *frameInfo,
+                                               uint32_t frameInfoBufferCount, uint32_t *frameCount)
+{
+    char indexPath[DJI_VIDEO_REMUXER_PATH_LEN_MAX + DJI_VIDEO_REMUXER_SUFFIX_LEN_MAX];
+    T_DjiVideoRemuxerIndexHeader header;
+    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    FILE *indexFile;
+
+    snprintf(indexPath, sizeof(indexPath), "%s%s", cachePath, DJI_VIDEO_REMUXER_INDEX_SUFFIX);
+    if (access(cachePath, R_OK) != 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+    }
+
+    indexFile = fopen(indexPath, "rb");
+    if (indexFile == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+    }
+
+    if (fread(&header, sizeof(header), 1, indexFile) != 1 || header.magic != DJI_VIDEO_REMUXER_INDEX_MAGIC ||
+        header.version != DJI_VIDEO_REMUXER_INDEX_VERSION || header.frameCount == 0) {
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+        goto out;
+    }
+    if (header.frameCount > frameInfoBufferCount) {
+        USER_LOG_ERROR("frame buffer is full.");
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
+        goto out;
+    }
+    if (fread(frameInfo, sizeof(T_DjiVideoRemuxerFrameInfo), header.frameCount, indexFile) != header.frameCount) {
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+        goto out;
+    }
+
+    *frameRate = header.frameRate;
+    *frameCount = header.frameCount;
+
+out:
+    fclose(indexFile);
+
+    return returnCode;
+}
+
+#ifdef FFMPEG_INSTALLED
+
+T_DjiReturnCode DjiVideoRemuxer_Open(const char *inPath, const char *cachePath,
+                                     T_DjiVideoRemuxerHandle *remuxerHandle)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_UtilAsyncWriterConfig writerConfig;
+    const AVBitStreamFilter *bsf;
+    T_DjiVideoRemuxer *remuxer;
+    AVStream *stream;
+    char tempPath[DJI_VIDEO_REMUXER_PATH_LEN_MAX + DJI_VIDEO_REMUXER_SUFFIX_LEN_MAX];
+    int ret;
+
+    remuxer = osalHandler->Malloc(sizeof(T_DjiVideoRemuxer));
+    if (remuxer == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+    memset(remuxer, 0, sizeof(T_DjiVideoRemuxer));
+
+    ret = avformat_open_input(&remuxer->formatContext, inPath, NULL, NULL);
+    if (ret < 0) {
+        USER_LOG_ERROR("open video file:\"%s\" error: %s.", inPath, av_err2str(ret));
+        goto error;
+    }
+    ret = avformat_find_stream_info(remuxer->formatContext, NULL);
+    if (ret < 0) {
+        USER_LOG_ERROR("find stream info of \"%s\" error: %s.", inPath, av_err2str(ret));
+        goto error;
+    }
+
+    remuxer->streamIndex = av_find_best_stream(remuxer->formatContext, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
+    if (remuxer->streamIndex < 0 ||
+        remuxer->formatContext->streams[remuxer->streamIndex]->codecpar->codec_id != AV_CODEC_ID_H264) {
+        USER_LOG_ERROR("no h264 video stream in \"%s\".", inPath);
+        goto error;
+    }
+    stream = remuxer->formatContext->streams[remuxer->streamIndex];
+    remuxer->timeBase = stream->time_base;
+
+    if (stream->avg_frame_rate.num > 0 && stream->avg_frame_rate.den > 0) {
+        remuxer->frameRate = (float) av_q2d(stream->avg_frame_rate);
+    } else if (stream->r_frame_rate.num > 0 && stream->r_frame_rate.den > 0) {
+        remuxer->frameRate = (float) av_q2d(stream->r_frame_rate);
+    } else {
+        remuxer->frameRate = DJI_VIDEO_REMUXER_DEFAULT_FRAME_RATE;
+    }
+
+    // mp4 stores length prefixed nal units with parameter sets in extradata, annex-b input is passed through
+    bsf = av_bsf_get_by_name("h264_mp4toannexb");
+    if (bsf == NULL || av_bsf_alloc(bsf, &remuxer->bsfContext) < 0) {
+        USER_LOG_ERROR("h264_mp4toannexb bitstream filter is not available.");
+        goto error;
+    }
+    ret = avcodec_parameters_copy(remuxer->bsfContext->par_in, stream->codecpar);
+    if (ret < 0) {
+        USER_LOG_ERROR("copy codec parameters error: %s.", av_err2str(ret));
+        goto error;
+    }
+    remuxer->bsfContext->time_base_in = stream->time_base;
+    ret = av_bsf_init(remuxer->bsfContext);
+    if (ret < 0) {
+        USER_LOG_ERROR("init bitstream filter error: %s.", av_err2str(ret));
+        goto error;
+    }
+
+    remuxer->inPacket = av_packet_alloc();
+    remuxer->outPacket = av_packet_alloc();
+    remuxer->frameIndexCapacity = DJI_VIDEO_REMUXER_INDEX_INIT_CAPACITY;
+    remuxer->frameIndex = malloc(remuxer->frameIndexCapacity * sizeof(T_DjiVideoRemuxerFrameInfo));
+    if (remuxer->inPacket == NULL || remuxer->outPacket == NULL || remuxer->frameIndex == NULL) {
+        goto error;
+    }
+
+    // the cache is written next to the send loop by the async writer and only published when complete
+    snprintf(remuxer->cachePath, sizeof(remuxer->cachePath), "%s", cachePath);
+    snprintf(tempPath, sizeof(tempPath), "%s%s", cachePath, DJI_VIDEO_REMUXER_TEMP_SUFFIX);
+    UtilAsyncWriter_GetDefaultConfig(&writerConfig);
+    writerConfig.fsyncIntervalMs = 0;
+    remuxer->isCacheValid = UtilAsyncWriter_Open(tempPath, &writerConfig, &remuxer->cacheWriter) ==
+                            DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    if (!remuxer->isCacheValid) {
+        USER_LOG_WARN("create remux cache %s failed, the file is remuxed on every playback.", tempPath);
+    }
+
+    *remuxerHandle = remuxer;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+
+error:
+    av_packet_free(&remuxer->inPacket);
+    av_packet_free(&remuxer->outPacket);
+    av_bsf_free(&remuxer->bsfContext);
+    avformat_close_input(&remuxer->formatContext);
+    free(remuxer->frameIndex);
+    osalHandler->Free(remuxer);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+}
+
+T_DjiReturnCode DjiVideoRemuxer_GetFrameRate(T_DjiVideoRemuxerHandle remuxerHandle, float *frameRate)
+{
+    T_DjiVideoRemuxer *remuxer = remuxerHandle;
+
+    *frameRate = remuxer->frameRate;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Get the next Annex-B frame of the video stream, the data is valid until the next call.
+ * @return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND at the end of the file.
+ */
+T_DjiReturnCode DjiVideoRemuxer_ReadFrame(T_DjiVideoRemuxerHandle remuxerHandle, const uint8_t **data,
+                                          uint32_t *len, T_DjiVideoRemuxerFrameInfo *frameInfo)
+{
+    T_DjiVideoRemuxer *remuxer = remuxerHandle;
+    T_DjiVideoRemuxerFrameInfo info;
+    int ret;
+
+    av_packet_unref(remuxer->outPacket);
+
+    while (1) {
+        ret = av_bsf_receive_packet(remuxer->bsfContext, remuxer->outPacket);
+        if (ret == 0) {
+            break;
+        }
+        if (ret == AVERROR_EOF) {
+            remuxer->isReachEnd = true;
+            return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+        }
+        if (ret != AVERROR(EAGAIN) || remuxer->isInputFinished) {
+            USER_LOG_ERROR("bitstream filter error: %s.", av_err2str(ret));
+            return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        }
+
+        while (1) {
+            ret = av_read_frame(remuxer->formatContext, remuxer->inPacket);
+            if (ret < 0) {
+                if (ret != AVERROR_EOF) {
+                    USER_LOG_ERROR("read video file error: %s.", av_err2str(ret));
+                    remuxer->isCacheValid = false;
+                }
+                remuxer->isInputFinished = true;
+                av_bsf_send_packet(remuxer->bsfContext, NULL);
+                break;
+            }
+            if (remuxer->inPacket->stream_index == remuxer->streamIndex) {
+                av_bsf_send_packet(remuxer->bsfContext, remuxer->inPacket);
+                av_packet_unref(remuxer->inPacket);
+                break;
+            }
+            av_packet_unref(remuxer->inPacket);
+        }
+    }
+
+    if (remuxer->outPacket->duration > 0) {
+        info.durationS = (float) (remuxer->outPacket->duration * av_q2d(remuxer->timeBase));
+    } else {
+        info.durationS = 1.0f / remuxer->frameRate;
+    }
+    info.positionInFile = (uint32_t) remuxer->cacheOffset;
+    info.size = (uint32_t) remuxer->outPacket->size;
+
+    if (remuxer->isCacheValid) {
+        DjiVideoRemuxer_AppendCache(remuxer, remuxer->outPacket->data, info.size, &info);
+    }
+
+    *data = remuxer->outPacket->data;
+    *len = info.size;
+    if (frameInfo != NULL) {
+        *frameInfo = info;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Close the remuxer. The cache and its frame index are published only if the whole file was remuxed.
+ */
+T_DjiReturnCode DjiVideoRemuxer_Close(T_DjiVideoRemuxerHandle remuxerHandle)
+{
+    T_DjiVideoRemuxer *remuxer = remuxerHandle;
+    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    char tempPath[DJI_VIDEO_REMUXER_PATH_LEN_MAX + DJI_VIDEO_REMUXER_SUFFIX_LEN_MAX];
+
+    if (remuxer->cacheWriter != NULL) {
+        if (UtilAsyncWriter_Close(remuxer->cacheWriter) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            remuxer->isCacheValid = false;
+        }
+        snprintf(tempPath, sizeof(tempPath), "%s%s", remuxer->cachePath, DJI_VIDEO_REMUXER_TEMP_SUFFIX);
+        if (remuxer->isCacheValid && remuxer->isReachEnd && remuxer->frameIndexCount > 0) {
+            returnCode = DjiVideoRemuxer_CommitCache(remuxer);
+        }
+        remove(tempPath);
+    }
+
+    av_packet_free(&remuxer->inPacket);
+    av_packet_free(&remuxer->outPacket);
+    av_bsf_free(&remuxer->bsfContext);
+    avformat_close_input(&remuxer->formatContext);
+    free(remuxer->frameIndex);
+    DjiPlatform_GetOsalHandler()->Free(remuxer);
+
+    return returnCode;
+}
+
+#else
+
+T_DjiReturnCode DjiVideoRemuxer_Open(const char *inPath, const char *cachePath,
+                                     T_DjiVideoRemuxerHandle *remuxerHandle)
+{
+    USER_UTIL_UNUSED(inPath);
+    USER_UTIL_UNUSED(cachePath);
+    USER_UTIL_UNUSED(remuxerHandle);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
+}
+
+T_DjiReturnCode DjiVideoRemuxer_GetFrameRate(T_DjiVideoRemuxerHandle remuxerHandle, float *frameRate)
+{
+    USER_UTIL_UNUSED(remuxerHandle);
+    USER_UTIL_UNUSED(frameRate);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
+}
+
+T_DjiReturnCode DjiVideoRemuxer_ReadFrame(T_DjiVideoRemuxerHandle remuxerHandle, const uint8_t **data,
+                                          uint32_t *len, T_DjiVideoRemuxerFrameInfo *frameInfo)
+{
+    USER_UTIL_UNUSED(remuxerHandle);
+    USER_UTIL_UNUSED(data);
+    USER_UTIL_UNUSED(len);
+    USER_UTIL_UNUSED(frameInfo);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
+}
+
+T_DjiReturnCode DjiVideoRemuxer_Close(T_DjiVideoRemuxerHandle remuxerHandle)
+{
+    USER_UTIL_UNUSED(remuxerHandle);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
+}
+
+#endif
+
+/* Private functions definition-----------------------------------------------*/
+#ifdef FFMPEG_INSTALLED
+static T_DjiReturnCode DjiVideoRemuxer_AppendCache(T_DjiVideoRemuxer *remuxer, const uint8_t *data, uint32_t len,
+                                                   const T_DjiVideoRemuxerFrameInfo *frameInfo)
+{
+    T_DjiVideoRemuxerFrameInfo *frameIndex;
+
+    // frame positions of the playback index are 32 bit
+    if (remuxer->cacheOffset + len > UINT32_MAX) {
+        remuxer->isCacheValid = false;
+        return DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
+    }
+
+    if (remuxer->frameIndexCount == remuxer->frameIndexCapacity) {
+        frameIndex = realloc(remuxer->frameIndex, remuxer->frameIndexCapacity * 2 * sizeof(T_DjiVideoRemuxerFrameInfo));
+        if (frameIndex == NULL) {
+            remuxer->isCacheValid = false;
+            return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+        }
+        remuxer->frameIndex = frameIndex;
+        remuxer->frameIndexCapacity *= 2;
+    }
+
+    if (UtilAsyncWriter_Write(remuxer->cacheWriter, data, len) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        remuxer->isCacheValid = false;
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    remuxer->frameIndex[remuxer->frameIndexCount++] = *frameInfo;
+    remuxer->cacheOffset += len;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+static T_DjiReturnCode DjiVideoRemuxer_CommitCache(T_DjiVideoRemuxer *remuxer)
+{
+    char tempPath[DJI_VIDEO_REMUXER_PATH_LEN_MAX + DJI_VIDEO_REMUXER_SUFFIX_LEN_MAX];
+    char indexPath[DJI_VIDEO_REMUXER_PATH_LEN_MAX + DJI_VIDEO_REMUXER_SUFFIX_LEN_MAX];
+    T_DjiVideoRemuxerIndexHeader header;
+    FILE *indexFile;
+    bool isWriteOk;
+
+    snprintf(tempPath, sizeof(tempPath), "%s%s", remuxer->cachePath, DJI_VIDEO_REMUXER_TEMP_SUFFIX);
+    if (rename(tempPath, remuxer->cachePath) != 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    // the index is published last, its presence marks the cache as complete
+    snprintf(indexPath, sizeof(indexPath), "%s%s%s", remuxer->cachePath, DJI_VIDEO_REMUXER_INDEX_SUFFIX,
+             DJI_VIDEO_REMUXER_TEMP_SUFFIX);
+    indexFile = fopen(indexPath, "wb");
+    if (indexFile == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    header.magic = DJI_VIDEO_REMUXER_INDEX_MAGIC;
+    header.version = DJI_VIDEO_REMUXER_INDEX_VERSION;
+    header.frameRate = remuxer->frameRate;
+    header.frameCount = remuxer->frameIndexCount;
+    isWriteOk = fwrite(&header, sizeof(header), 1, indexFile) == 1 &&
+                fwrite(remuxer->frameIndex, sizeof(T_DjiVideoRemuxerFrameInfo), remuxer->frameIndexCount,
+                       indexFile) == remuxer->frameIndexCount;
+    isWriteOk = fclose(indexFile) == 0 && isWriteOk;
+    if (!isWriteOk) {
+        remove(indexPath);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    snprintf(tempPath, sizeof(tempPath), "%s%s", remuxer->cachePath, DJI_VIDEO_REMUXER_INDEX_SUFFIX);
+    if (rename(indexPath, tempPath) != 0) {
+        remove(indexPath);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    USER_LOG_INFO("remux cache saved: %s, %u frames.", remuxer->cachePath, remuxer->frameIndexCount);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+#endif
+
+#endif
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
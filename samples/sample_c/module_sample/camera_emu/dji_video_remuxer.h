@@ -0,0 +1,70 @@
+/**
+ ********************************************************************
+ * @file    dji_video_remuxer.h
+ * @brief   This is the header file for "dji_video_remuxer.c", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef DJI_VIDEO_REMUXER_H
+#define DJI_VIDEO_REMUXER_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_typedef.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef SYSTEM_ARCH_LINUX
+
+/* Exported constants --------------------------------------------------------*/
+#define DJI_VIDEO_REMUXER_PATH_LEN_MAX          256
+
+/* Exported types ------------------------------------------------------------*/
+typedef void *T_DjiVideoRemuxerHandle;
+
+typedef struct {
+    float durationS;
+    uint32_t positionInFile;
+    uint32_t size;
+} T_DjiVideoRemuxerFrameInfo;
+
+/* Exported functions --------------------------------------------------------*/
+T_DjiReturnCode DjiVideoRemuxer_GetCachePath(const char *inPath, char *cachePath, uint32_t cachePathSize);
+T_DjiReturnCode DjiVideoRemuxer_LoadCacheIndex(const char *cachePath, float *frameRate,
+                                               T_DjiVideoRemuxerFrameInfo *frameInfo,
+                                               uint32_t frameInfoBufferCount, uint32_t *frameCount);
+T_DjiReturnCode DjiVideoRemuxer_Open(const char *inPath, const char *cachePath,
+                                     T_DjiVideoRemuxerHandle *remuxerHandle);
+T_DjiReturnCode DjiVideoRemuxer_GetFrameRate(T_DjiVideoRemuxerHandle remuxerHandle, float *frameRate);
+T_DjiReturnCode DjiVideoRemuxer_ReadFrame(T_DjiVideoRemuxerHandle remuxerHandle, const uint8_t **data,
+                                          uint32_t *len, T_DjiVideoRemuxerFrameInfo *frameInfo);
+T_DjiReturnCode DjiVideoRemuxer_Close(T_DjiVideoRemuxerHandle remuxerHandle);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DJI_VIDEO_REMUXER_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
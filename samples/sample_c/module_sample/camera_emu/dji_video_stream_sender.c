@@ -0,0 +1,193 @@
+/**
+ ********************************************************************
+ * @file    dji_video_stream_sender.c
+ * @brief   The file defines the video stream send stage used by the camera samples. Frames are described
+ *          as a list of slices, fragments inside one slice are sent without an intermediate copy.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "dji_video_stream_sender.h"
+#include "utils/util_misc.h"
+
+/* Private constants ---------------------------------------------------------*/
+/* Number of successful sends after which a shrunk fragment size is doubled again. */
+#define DJI_VIDEO_STREAM_SENDER_GROW_THRESHOLD      64
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    uint32_t index;
+    uint32_t offset;
+} T_DjiVideoStreamSliceCursor;
+
+/* Private functions declaration ---------------------------------------------*/
+static const uint8_t *DjiVideoStreamSender_GetFragment(T_DjiVideoStreamSender *sender,
+                                                       const T_DjiVideoStreamSlice *slices, uint32_t sliceCount,
+                                                       T_DjiVideoStreamSliceCursor *cursor, uint32_t len);
+static bool DjiVideoStreamSender_IsSizeError(T_DjiReturnCode returnCode);
+
+/* Private variables ---------------------------------------------------------*/
+
+/* Exported functions definition ---------------------------------------------*/
+/**
+ * @brief Video stream sender initialization.
+ * @param sender Pointer to sender structure.
+ * @param sendFunc Function sending one fragment, usually DjiPayloadCamera_SendVideoStream.
+ * @param arena Memory for fragments spanning several slices, fragments are never larger than the arena.
+ * @param arenaSize Size of the arena, DJI_VIDEO_STREAM_SENDER_ARENA_SIZE allows fragments of the maximum size.
+ * @return None.
+ */
+void DjiVideoStreamSender_Init(T_DjiVideoStreamSender *sender, DjiVideoStreamSendFunc sendFunc,
+                               uint8_t *arena, uint32_t arenaSize)
+{
+    memset(sender, 0, sizeof(T_DjiVideoStreamSender));
+    sender->sendFunc = sendFunc;
+    sender->arena = arena;
+    sender->arenaSize = arenaSize;
+    sender->maxFragmentSize = USER_UTIL_MIN(arenaSize, DJI_VIDEO_STREAM_SENDER_MAX_FRAGMENT_SIZE);
+    sender->fragmentSize = sender->maxFragmentSize;
+    sender->statistics.fragmentSize = sender->fragmentSize;
+}
+
+/**
+ * @brief Send one frame given as a list of slices, e.g. parameter set header, NAL unit and AUD.
+ * @note The frame is cut into the fewest fragments of at most the current fragment size, all of about the same
+ * length, so the trailing slices always travel together with the end of the NAL unit instead of in a send call of
+ * their own. A fragment inside one slice is sent from the caller's memory, only fragments crossing a slice
+ * boundary are gathered into the arena.
+ * @note A fragment rejected as too large is retried at half the size, down to
+ * DJI_VIDEO_STREAM_SENDER_MIN_FRAGMENT_SIZE, and the size grows back after a run of successful sends. Any other
+ * send error drops the rest of the frame.
+ * @param sender Pointer to sender structure.
+ * @param slices Slices of the frame, in stream order.
+ * @param sliceCount Number of slices.
+ * @return Execution result.
+ */
+T_DjiReturnCode DjiVideoStreamSender_SendSlices(T_DjiVideoStreamSender *sender,
+                                                const T_DjiVideoStreamSlice *slices, uint32_t sliceCount)
+{
+    T_DjiReturnCode returnCode;
+    T_DjiVideoStreamSliceCursor cursor = {0};
+    T_DjiVideoStreamSliceCursor nextCursor;
+    const uint8_t *fragment;
+    uint32_t frameLen = 0;
+    uint32_t sentLen = 0;
+    uint32_t fragmentCount;
+    uint32_t fragmentLen;
+    uint32_t i;
+
+    for (i = 0; i < sliceCount; i++) {
+        frameLen += slices[i].len;
+    }
+
+    while (sentLen < frameLen) {
+        fragmentCount = (frameLen - sentLen + sender->fragmentSize - 1) / sender->fragmentSize;
+        fragmentLen = (frameLen - sentLen + fragmentCount - 1) / fragmentCount;
+
+        nextCursor = cursor;
+        fragment = DjiVideoStreamSender_GetFragment(sender, slices, sliceCount, &nextCursor, fragmentLen);
+        returnCode = sender->sendFunc(fragment, fragmentLen);
+        sender->statistics.sendCount++;
+
+        if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            cursor = nextCursor;
+            sentLen += fragmentLen;
+            sender->statistics.sentBytes += fragmentLen;
+            if (sender->fragmentSize < sender->maxFragmentSize &&
+                ++sender->successCount >= DJI_VIDEO_STREAM_SENDER_GROW_THRESHOLD) {
+                sender->fragmentSize = USER_UTIL_MIN(sender->fragmentSize * 2, sender->maxFragmentSize);
+                sender->successCount = 0;
+            }
+            continue;
+        }
+
+        sender->statistics.sendFailCount++;
+        sender->successCount = 0;
+        if (DjiVideoStreamSender_IsSizeError(returnCode) &&
+            fragmentLen > DJI_VIDEO_STREAM_SENDER_MIN_FRAGMENT_SIZE) {
+            sender->fragmentSize = USER_UTIL_MAX(fragmentLen / 2, DJI_VIDEO_STREAM_SENDER_MIN_FRAGMENT_SIZE);
+            sender->statistics.fragmentSize = sender->fragmentSize;
+            continue;
+        }
+
+        sender->statistics.droppedBytes += frameLen - sentLen;
+        sender->statistics.fragmentSize = sender->fragmentSize;
+        return returnCode;
+    }
+
+    sender->statistics.fragmentSize = sender->fragmentSize;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/* Private functions definition-----------------------------------------------*/
+/**
+ * @brief Get the next fragment of a frame and move the cursor behind it.
+ * @return Pointer into the slice when the fragment lies in one slice, otherwise the arena holding the gathered
+ * fragment.
+ */
+static const uint8_t *DjiVideoStreamSender_GetFragment(T_DjiVideoStreamSender *sender,
+                                                       const T_DjiVideoStreamSlice *slices, uint32_t sliceCount,
+                                                       T_DjiVideoStreamSliceCursor *cursor, uint32_t len)
+{
+    const uint8_t *fragment;
+    uint32_t gatheredLen = 0;
+    uint32_t copyLen;
+
+    while (cursor->index < sliceCount && cursor->offset == slices[cursor->index].len) {
+        cursor->index++;
+        cursor->offset = 0;
+    }
+
+    if (slices[cursor->index].len - cursor->offset >= len) {
+        fragment = slices[cursor->index].data + cursor->offset;
+        cursor->offset += len;
+        return fragment;
+    }
+
+    while (gatheredLen < len) {
+        if (cursor->offset == slices[cursor->index].len) {
+            cursor->index++;
+            cursor->offset = 0;
+            continue;
+        }
+
+        copyLen = USER_UTIL_MIN(slices[cursor->index].len - cursor->offset, len - gatheredLen);
+        memcpy(sender->arena + gatheredLen, slices[cursor->index].data + cursor->offset, copyLen);
+        cursor->offset += copyLen;
+        gatheredLen += copyLen;
+    }
+    sender->statistics.gatheredBytes += gatheredLen;
+
+    return sender->arena;
+}
+
+/**
+ * @brief Errors for which a smaller fragment may succeed, e.g. when the link accepts less than the documented
+ * 65000 bytes. Busy or disconnected links fail the same way with any size.
+ */
+static bool DjiVideoStreamSender_IsSizeError(T_DjiReturnCode returnCode)
+{
+    return returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER ||
+           returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,82 @@
+/**
+ ********************************************************************
+ * @file    dji_video_stream_sender.h
+ * @brief   This is the header file for "dji_video_stream_sender.c", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef DJI_VIDEO_STREAM_SENDER_H
+#define DJI_VIDEO_STREAM_SENDER_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_typedef.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+/* Upper limit of one DjiPayloadCamera_SendVideoStream call, see dji_payload_camera.h. */
+#define DJI_VIDEO_STREAM_SENDER_MAX_FRAGMENT_SIZE       65000
+#define DJI_VIDEO_STREAM_SENDER_MIN_FRAGMENT_SIZE       4000
+/* Arena size allowing gathered fragments of the maximum size. */
+#define DJI_VIDEO_STREAM_SENDER_ARENA_SIZE              DJI_VIDEO_STREAM_SENDER_MAX_FRAGMENT_SIZE
+
+/* Exported types ------------------------------------------------------------*/
+typedef T_DjiReturnCode (*DjiVideoStreamSendFunc)(const uint8_t *data, uint32_t len);
+
+typedef struct {
+    const uint8_t *data;
+    uint32_t len;
+} T_DjiVideoStreamSlice;
+
+typedef struct {
+    uint32_t sendCount;
+    uint32_t sendFailCount;
+    uint64_t sentBytes;
+    uint64_t gatheredBytes;
+    uint32_t droppedBytes;
+    uint32_t fragmentSize;
+} T_DjiVideoStreamSenderStatistics;
+
+typedef struct {
+    DjiVideoStreamSendFunc sendFunc;
+    uint8_t *arena;
+    uint32_t arenaSize;
+    uint32_t maxFragmentSize;
+    uint32_t fragmentSize;
+    uint32_t successCount;
+    T_DjiVideoStreamSenderStatistics statistics;
+} T_DjiVideoStreamSender;
+
+/* Exported functions --------------------------------------------------------*/
+void DjiVideoStreamSender_Init(T_DjiVideoStreamSender *sender, DjiVideoStreamSendFunc sendFunc,
+                               uint8_t *arena, uint32_t arenaSize);
+T_DjiReturnCode DjiVideoStreamSender_SendSlices(T_DjiVideoStreamSender *sender,
+                                                const T_DjiVideoStreamSlice *slices, uint32_t sliceCount);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DJI_VIDEO_STREAM_SENDER_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
@@ -34,16 +34,22 @@
 #include "test_payload_cam_emu_media.h"
 #include "test_payload_cam_emu_base.h"
 #include "camera_emu/dji_media_file_manage/dji_media_file_core.h"
+#include "camera_emu/dji_media_file_manage/dji_media_file_cache.h"
+#include "camera_emu/dji_media_file_manage/dji_media_file_preview.h"
 #include "dji_high_speed_data_channel.h"
 #include "dji_aircraft_info.h"
 #include "test_raspberry_pi_camera.h"
+#include "dji_video_file_reader.h"
+#include "dji_video_remuxer.h"
+#include "dji_video_stream_sender.h"
 
 /* Private constants ---------------------------------------------------------*/
 #define FFMPEG_CMD_BUF_SIZE                 (256 + 256)
 #define SEND_VIDEO_TASK_FREQ                 120
 #define VIDEO_FRAME_MAX_COUNT                18000 // max video duration 10 minutes
 #define VIDEO_FRAME_AUD_LEN                  6
-#define DATA_SEND_FROM_VIDEO_STREAM_MAX_LEN  60000
+#define VIDEO_SEND_STATISTICS_FRAME_COUNT    300
+#define VIDEO_DEFAULT_FRAME_RATE             30.0f
 
 /* Private types -------------------------------------------------------------*/
 typedef enum {
@@ -67,11 +73,17 @@ typedef struct {
     char path[DJI_FILE_PATH_SIZE_MAX];
 } T_TestPayloadCameraPlaybackCommand;
 
+typedef T_DjiVideoRemuxerFrameInfo T_TestPayloadCameraVideoFrameInfo;
+
 typedef struct {
-    float durationS;
-    uint32_t positionInFile;
-    uint32_t size;
-} T_TestPayloadCameraVideoFrameInfo;
+    T_DjiVideoFileReader fileReader;
+    T_DjiVideoRemuxerHandle remuxer;
+    char filePath[DJI_FILE_PATH_SIZE_MAX];
+    T_TestPayloadCameraVideoFrameInfo *frameInfo;
+    uint32_t frameCount;
+    uint32_t frameNumber;
+    float frameRate;
+} T_TestPayloadCameraVideoSource;
 
 /* Private functions declaration ---------------------------------------------*/
 static T_DjiReturnCode DjiPlayback_StopPlay(T_DjiPlaybackInfo *playbackInfo);
@@ -94,6 +106,12 @@ static T_DjiReturnCode DjiPlayback_GetFrameRateOfVideoFile(const char *path, flo
 static T_DjiReturnCode
 DjiPlayback_GetFrameNumberByTime(T_TestPayloadCameraVideoFrameInfo *frameInfo, uint32_t frameCount,
                                  uint32_t *frameNumber, uint32_t timeMs);
+static T_DjiReturnCode DjiPlayback_OpenVideoSource(T_TestPayloadCameraVideoSource *source, const char *videoFilePath,
+                                                   uint32_t startTimeMs);
+static T_DjiReturnCode DjiPlayback_OpenMappedVideoSource(T_TestPayloadCameraVideoSource *source, uint32_t startTimeMs);
+static T_DjiReturnCode DjiPlayback_ReadVideoSourceFrame(T_TestPayloadCameraVideoSource *source, const uint8_t **data,
+                                                       uint32_t *len, bool *isReachTail);
+static void DjiPlayback_CloseVideoSource(T_TestPayloadCameraVideoSource *source);
 static T_DjiReturnCode GetMediaFileDir(char *dirPath);
 static T_DjiReturnCode GetMediaFileOriginData(const char *filePath, uint32_t offset, uint32_t length,
                                               uint8_t *data);
@@ -127,8 +145,8 @@ _Noreturn static void *UserCameraMedia_SendVideoTask(void *arg);
 static T_DjiCameraMediaDownloadPlaybackHandler s_psdkCameraMedia = {0};
 static T_DjiPlaybackInfo s_playbackInfo = {0};
 static T_DjiTaskHandle s_userSendVideoThread;
-static T_UtilBuffer s_mediaPlayCommandBufferHandler = {0};
-static T_DjiMutexHandle s_mediaPlayCommandBufferMutex = {0};
+/* Commands are put by the playback callbacks and taken by the video send task, the buffer needs no lock. */
+static T_UtilMpscBuffer s_mediaPlayCommandBufferHandler = {0};
 static T_DjiSemaHandle s_mediaPlayWorkSem = NULL;
 static uint8_t s_mediaPlayCommandBuffer[sizeof(T_TestPayloadCameraPlaybackCommand) * 32] = {0};
 static const char *s_frameKeyChar = "[PACKET]";
@@ -138,6 +156,8 @@ static const char *s_frameSizeKeyChar = "size";
 static T_DjiMediaFileHandle s_mediaFileThumbNailHandle;
 static T_DjiMediaFileHandle s_mediaFileScreenNailHandle;
 static const uint8_t s_frameAudInfo[VIDEO_FRAME_AUD_LEN] = {0x00, 0x00, 0x00, 0x01, 0x09, 0x10};
+static T_DjiVideoStreamSender s_videoStreamSender;
+static uint8_t s_videoStreamSenderArena[DJI_VIDEO_STREAM_SENDER_ARENA_SIZE];
 static char s_mediaFileDirPath[DJI_FILE_PATH_SIZE_MAX] = {0};
 static bool s_isMediaFileDirPathConfigured = false;
 
@@ -149,12 +169,25 @@ T_DjiReturnCode DjiTest_CameraEmuMediaStartService(void)
     const T_DjiDataChannelBandwidthProportionOfHighspeedChannel bandwidthProportionOfHighspeedChannel =
         {10, 60, 30};
     T_DjiAircraftInfoBaseInfo aircraftInfoBaseInfo = {0};
+    char mediaFileDirPath[DJI_FILE_PATH_SIZE_MAX];
 
     if (DjiAircraftInfo_GetBaseInfo(&aircraftInfoBaseInfo) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
         USER_LOG_ERROR("get aircraft information error.");
         return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
     }
 
+    returnCode = DjiMediaFileCache_Init();
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("media file cache init error: 0x%08llX.", returnCode);
+        return returnCode;
+    }
+
+    returnCode = DjiMediaFilePreview_Init();
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("media file preview init error: 0x%08llX.", returnCode);
+        return returnCode;
+    }
+
     s_psdkCameraMedia.GetMediaFileDir = GetMediaFileDir;
     s_psdkCameraMedia.GetMediaFileOriginInfo = DjiTest_CameraMediaGetFileInfo;
     s_psdkCameraMedia.GetMediaFileOriginData = GetMediaFileOriginData;
@@ -187,12 +220,7 @@ T_DjiReturnCode DjiTest_CameraEmuMediaStartService(void)
         return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
     }
 
-    if (osalHandler->MutexCreate(&s_mediaPlayCommandBufferMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex create error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-    }
-
-    UtilBuffer_Init(&s_mediaPlayCommandBufferHandler, s_mediaPlayCommandBuffer, sizeof(s_mediaPlayCommandBuffer));
+    UtilBuffer_MpscInit(&s_mediaPlayCommandBufferHandler, s_mediaPlayCommandBuffer, sizeof(s_mediaPlayCommandBuffer));
 
     if (aircraftInfoBaseInfo.aircraftType == DJI_AIRCRAFT_TYPE_M300_RTK ||
         aircraftInfoBaseInfo.aircraftType == DJI_AIRCRAFT_TYPE_M350_RTK ||
@@ -202,6 +230,11 @@ T_DjiReturnCode DjiTest_CameraEmuMediaStartService(void)
             USER_LOG_ERROR("psdk camera media function init error.");
             return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
         }
+
+        //generate previews of the existing media files in the background before the media list is browsed
+        if (GetMediaFileDir(mediaFileDirPath) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            DjiMediaFilePreview_Warm(mediaFileDirPath);
+        }
     }
 
     returnCode = DjiHighSpeedDataChannel_SetBandwidthProportion(bandwidthProportionOfHighspeedChannel);
@@ -303,23 +336,11 @@ static T_DjiReturnCode DjiPlayback_PausePlay(T_DjiPlaybackInfo *playbackInfo)
     if (playbackInfo->isInPlayProcess) {
         playbackCommand.command = TEST_PAYLOAD_CAMERA_MEDIA_PLAY_COMMAND_PAUSE;
 
-        if (osalHandler->MutexLock(s_mediaPlayCommandBufferMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-            USER_LOG_ERROR("mutex lock error");
-            return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-        }
-
-        if (UtilBuffer_GetUnusedSize(&s_mediaPlayCommandBufferHandler) >= sizeof(T_TestPayloadCameraPlaybackCommand)) {
-            UtilBuffer_Put(&s_mediaPlayCommandBufferHandler, (const uint8_t *) &playbackCommand,
-                           sizeof(T_TestPayloadCameraPlaybackCommand));
-        } else {
+        if (UtilBuffer_MpscPut(&s_mediaPlayCommandBufferHandler, (const uint8_t *) &playbackCommand,
+                               sizeof(T_TestPayloadCameraPlaybackCommand)) == 0) {
             USER_LOG_ERROR("Media playback command buffer is full.");
             returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
         }
-
-        if (osalHandler->MutexUnlock(s_mediaPlayCommandBufferMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-            USER_LOG_ERROR("mutex unlock error");
-            return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-        }
         osalHandler->SemaphorePost(s_mediaPlayWorkSem);
     }
 
@@ -486,23 +507,11 @@ static T_DjiReturnCode DjiPlayback_StartPlayProcess(const char *filePath, uint32
     }
     memcpy(mediaPlayCommand.path, filePath, strlen(filePath));
 
-    if (osalHandler->MutexLock(s_mediaPlayCommandBufferMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex lock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-    }
-
-    if (UtilBuffer_GetUnusedSize(&s_mediaPlayCommandBufferHandler) >= sizeof(T_TestPayloadCameraPlaybackCommand)) {
-        UtilBuffer_Put(&s_mediaPlayCommandBufferHandler, (const uint8_t *) &mediaPlayCommand,
-                       sizeof(T_TestPayloadCameraPlaybackCommand));
-    } else {
+    if (UtilBuffer_MpscPut(&s_mediaPlayCommandBufferHandler, (const uint8_t *) &mediaPlayCommand,
+                           sizeof(T_TestPayloadCameraPlaybackCommand)) == 0) {
         USER_LOG_ERROR("Media playback command buffer is full.");
         returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
     }
-
-    if (osalHandler->MutexUnlock(s_mediaPlayCommandBufferMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex unlock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-    }
     osalHandler->SemaphorePost(s_mediaPlayWorkSem);
     return returnCode;
 }
@@ -515,23 +524,11 @@ static T_DjiReturnCode DjiPlayback_StopPlayProcess(void)
 
     playbackCommand.command = TEST_PAYLOAD_CAMERA_MEDIA_PLAY_COMMAND_STOP;
 
-    if (osalHandler->MutexLock(s_mediaPlayCommandBufferMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex lock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-    }
-
-    if (UtilBuffer_GetUnusedSize(&s_mediaPlayCommandBufferHandler) >= sizeof(T_TestPayloadCameraPlaybackCommand)) {
-        UtilBuffer_Put(&s_mediaPlayCommandBufferHandler, (const uint8_t *) &playbackCommand,
-                       sizeof(T_TestPayloadCameraPlaybackCommand));
-    } else {
+    if (UtilBuffer_MpscPut(&s_mediaPlayCommandBufferHandler, (const uint8_t *) &playbackCommand,
+                           sizeof(T_TestPayloadCameraPlaybackCommand)) == 0) {
         USER_LOG_ERROR("Media playback command buffer is full.");
         returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
     }
-
-    if (osalHandler->MutexUnlock(s_mediaPlayCommandBufferMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex unlock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-    }
     osalHandler->SemaphorePost(s_mediaPlayWorkSem);
     return returnCode;
 }
@@ -768,6 +765,150 @@ static T_DjiReturnCode DjiPlayback_GetFrameNumberByTime(T_TestPayloadCameraVideo
     return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
 }
 
+/**
+ * @brief Open a video file for sending. A file remuxed before is sent from its cache, otherwise it is remuxed
+ * in process while being sent, and the ffmpeg command line is only used when libav is not available.
+ */
+static T_DjiReturnCode DjiPlayback_OpenVideoSource(T_TestPayloadCameraVideoSource *source, const char *videoFilePath,
+                                                   uint32_t startTimeMs)
+{
+    T_DjiReturnCode returnCode;
+    T_TestPayloadCameraVideoFrameInfo frameInfo;
+    const uint8_t *frameData;
+    uint32_t frameLen;
+    double startTimeS = (double) startTimeMs / 1000.0;
+    double cumulativeTimeS = 0;
+
+    DjiPlayback_CloseVideoSource(source);
+
+    returnCode = DjiVideoRemuxer_GetCachePath(videoFilePath, source->filePath, DJI_FILE_PATH_SIZE_MAX);
+    if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        returnCode = DjiVideoRemuxer_LoadCacheIndex(source->filePath, &source->frameRate, source->frameInfo,
+                                                    VIDEO_FRAME_MAX_COUNT, &source->frameCount);
+        if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            return DjiPlayback_OpenMappedVideoSource(source, startTimeMs);
+        }
+
+        returnCode = DjiVideoRemuxer_Open(videoFilePath, source->filePath, &source->remuxer);
+    }
+
+    if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        DjiVideoRemuxer_GetFrameRate(source->remuxer, &source->frameRate);
+        source->frameCount = 0;
+
+        // frames before the start position are only remuxed into the cache, not sent
+        while (cumulativeTimeS < startTimeS) {
+            returnCode = DjiVideoRemuxer_ReadFrame(source->remuxer, &frameData, &frameLen, &frameInfo);
+            if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+                break;
+            }
+            cumulativeTimeS += frameInfo.durationS;
+        }
+
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    returnCode = DjiPlayback_VideoFileTranscode(videoFilePath, "h264", source->filePath, DJI_FILE_PATH_SIZE_MAX);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("transcode video file error: 0x%08llX.", returnCode);
+        return returnCode;
+    }
+
+    returnCode = DjiPlayback_GetFrameRateOfVideoFile(source->filePath, &source->frameRate);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("get frame rate of video error: 0x%08llX.", returnCode);
+        return returnCode;
+    }
+
+    returnCode = DjiPlayback_GetFrameInfoOfVideoFile(source->filePath, source->frameInfo, VIDEO_FRAME_MAX_COUNT,
+                                                     &source->frameCount);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("get frame info of video error: 0x%08llX.", returnCode);
+        return returnCode;
+    }
+
+    return DjiPlayback_OpenMappedVideoSource(source, startTimeMs);
+}
+
+static T_DjiReturnCode DjiPlayback_OpenMappedVideoSource(T_TestPayloadCameraVideoSource *source, uint32_t startTimeMs)
+{
+    T_DjiReturnCode returnCode;
+
+    returnCode = DjiPlayback_GetFrameNumberByTime(source->frameInfo, source->frameCount, &source->frameNumber,
+                                                  startTimeMs);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("get start frame number error: 0x%08llX.", returnCode);
+        return returnCode;
+    }
+
+    return DjiVideoFileReader_Open(&source->fileReader, source->filePath);
+}
+
+/**
+ * @brief Get the next frame to send, the data stays valid until the next call.
+ * @note While the file is being remuxed the frame comes from the remuxer. At its tail the cache is complete and
+ * the following loops are sent from the mapped cache file.
+ */
+static T_DjiReturnCode DjiPlayback_ReadVideoSourceFrame(T_TestPayloadCameraVideoSource *source, const uint8_t **data,
+                                                       uint32_t *len, bool *isReachTail)
+{
+    T_DjiReturnCode returnCode;
+    T_TestPayloadCameraVideoFrameInfo *frameInfo;
+
+    *len = 0;
+    *isReachTail = false;
+
+    if (source->remuxer != NULL) {
+        returnCode = DjiVideoRemuxer_ReadFrame(source->remuxer, data, len, NULL);
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND) {
+            return returnCode;
+        }
+
+        USER_LOG_DEBUG("reach file tail.");
+        *isReachTail = true;
+        DjiVideoRemuxer_Close(source->remuxer);
+        source->remuxer = NULL;
+
+        returnCode = DjiVideoRemuxer_LoadCacheIndex(source->filePath, &source->frameRate, source->frameInfo,
+                                                    VIDEO_FRAME_MAX_COUNT, &source->frameCount);
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            USER_LOG_ERROR("load remux cache error: 0x%08llX.", returnCode);
+            return returnCode;
+        }
+
+        return DjiPlayback_OpenMappedVideoSource(source, 0);
+    }
+
+    if (source->fileReader.data == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+    }
+
+    frameInfo = &source->frameInfo[source->frameNumber];
+    returnCode = DjiVideoFileReader_GetFrame(&source->fileReader, frameInfo->positionInFile, frameInfo->size, data);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        source->frameNumber = 0;
+        return returnCode;
+    }
+    *len = frameInfo->size;
+
+    if (++source->frameNumber >= source->frameCount) {
+        USER_LOG_DEBUG("reach file tail.");
+        source->frameNumber = 0;
+        *isReachTail = true;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+static void DjiPlayback_CloseVideoSource(T_TestPayloadCameraVideoSource *source)
+{
+    if (source->remuxer != NULL) {
+        DjiVideoRemuxer_Close(source->remuxer);
+        source->remuxer = NULL;
+    }
+    DjiVideoFileReader_Close(&source->fileReader);
+}
+
 static T_DjiReturnCode GetMediaFileDir(char *dirPath)
 {
     T_DjiReturnCode returnCode;
@@ -789,26 +930,14 @@ static T_DjiReturnCode GetMediaFileOriginData(const char *filePath, uint32_t off
 {
     T_DjiReturnCode returnCode;
     uint32_t realLen = 0;
-    T_DjiMediaFileHandle mediaFileHandle;
-
-    returnCode = DjiMediaFile_CreateHandle(filePath, &mediaFileHandle);
-    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("Media file create handle error stat:0x%08llX", returnCode);
-        return returnCode;
-    }
 
-    returnCode = DjiMediaFile_GetDataOrg(mediaFileHandle, offset, length, data, &realLen);
+    // the file stays open in the cache between the chunks of a download
+    returnCode = DjiMediaFileCache_GetDataOrg(filePath, offset, length, data, &realLen);
     if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
         USER_LOG_ERROR("Media file get data error stat:0x%08llX", returnCode);
         return returnCode;
     }
 
-    returnCode = DjiMediaFile_DestroyHandle(mediaFileHandle);
-    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("Media file destroy handle error stat:0x%08llX", returnCode);
-        return returnCode;
-    }
-
     return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
 }
 
@@ -1014,6 +1143,8 @@ static T_DjiReturnCode DeleteMediaFile(char *filePath)
     T_DjiReturnCode returnCode;
 
     USER_LOG_INFO("delete media file:%s", filePath);
+    DjiMediaFileCache_Invalidate(filePath);
+    DjiMediaFilePreview_Remove(filePath);
     returnCode = DjiFile_Delete(filePath);
     if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
         USER_LOG_ERROR("Media file delete error stat:0x%08llX", returnCode);
@@ -1169,35 +1300,34 @@ static T_DjiReturnCode StopDownloadNotification(void)
 
 static void *UserCameraMedia_SendVideoTask(void *arg)
 {
-    int ret;
     T_DjiReturnCode returnCode;
-    static uint32_t sendVideoStep = 0;
-    FILE *fpFile = NULL;
-    unsigned long dataLength = 0;
-    uint16_t lengthOfDataToBeSent = 0;
-    int lengthOfDataHaveBeenSent = 0;
-    char *dataBuffer = NULL;
     T_TestPayloadCameraPlaybackCommand playbackCommand = {0};
-    uint16_t bufferReadSize = 0;
+    uint32_t bufferReadSize = 0;
     char *videoFilePath = NULL;
-    char *transcodedFilePath = NULL;
-    float frameRate = 1.0f;
-    uint32_t waitDuration = 1000 / SEND_VIDEO_TASK_FREQ;
-    uint32_t rightNow = 0;
-    uint32_t sendExpect = 0;
-    T_TestPayloadCameraVideoFrameInfo *frameInfo = NULL;
-    uint32_t frameNumber = 0;
-    uint32_t frameCount = 0;
+    T_TestPayloadCameraVideoSource *videoSource = NULL;
     uint32_t startTimeMs = 0;
     bool sendVideoFlag = true;
     bool sendOneTimeFlag = false;
     T_DjiDataChannelState videoStreamState = {0};
     E_DjiCameraMode mode = DJI_CAMERA_MODE_SHOOT_PHOTO;
     T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
-    uint32_t frameBufSize = 0;
     E_DjiCameraVideoStreamType videoStreamType;
     char curFileDirPath[DJI_FILE_PATH_SIZE_MAX];
     char tempPath[DJI_FILE_PATH_SIZE_MAX];
+    T_DjiVideoStreamSlice frameSlices[2];
+    uint32_t frameSliceCount;
+    const uint8_t *frameData = NULL;
+    uint32_t frameLen = 0;
+    bool isReachTail = false;
+    uint32_t openTimeMs = 0;
+    uint32_t firstFrameTimeMs = 0;
+    bool isFirstFrameSent = false;
+    T_DjiUtilTimePacer framePacer = {0};
+    uint64_t statCpuTimeUs = 0;
+    uint32_t statFrameCount = 0;
+    uint64_t timeToDeadlineUs;
+    bool isCommandWakeup;
+    float frameRate;
 
     USER_UTIL_UNUSED(arg);
 
@@ -1218,18 +1348,23 @@ static void *UserCameraMedia_SendVideoTask(void *arg)
         exit(1);
     }
 
-    transcodedFilePath = osalHandler->Malloc(DJI_FILE_PATH_SIZE_MAX);
-    if (transcodedFilePath == NULL) {
-        USER_LOG_ERROR("malloc memory for transcoded file path fail.");
+    videoSource = osalHandler->Malloc(sizeof(T_TestPayloadCameraVideoSource));
+    if (videoSource == NULL) {
+        USER_LOG_ERROR("malloc memory for video source fail.");
         exit(1);
     }
+    memset(videoSource, 0, sizeof(T_TestPayloadCameraVideoSource));
+    videoSource->fileReader.fd = -1;
 
-    frameInfo = osalHandler->Malloc(VIDEO_FRAME_MAX_COUNT * sizeof(T_TestPayloadCameraVideoFrameInfo));
-    if (frameInfo == NULL) {
+    videoSource->frameInfo = osalHandler->Malloc(VIDEO_FRAME_MAX_COUNT * sizeof(T_TestPayloadCameraVideoFrameInfo));
+    if (videoSource->frameInfo == NULL) {
         USER_LOG_ERROR("malloc memory for frame info fail.");
         exit(1);
     }
-    memset(frameInfo, 0, VIDEO_FRAME_MAX_COUNT * sizeof(T_TestPayloadCameraVideoFrameInfo));
+    memset(videoSource->frameInfo, 0, VIDEO_FRAME_MAX_COUNT * sizeof(T_TestPayloadCameraVideoFrameInfo));
+
+    DjiVideoStreamSender_Init(&s_videoStreamSender, DjiPayloadCamera_SendVideoStream,
+                              s_videoStreamSenderArena, sizeof(s_videoStreamSenderArena));
 
     returnCode = DjiPlayback_StopPlayProcess();
     if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
@@ -1237,33 +1372,32 @@ static void *UserCameraMedia_SendVideoTask(void *arg)
         exit(1);
     }
 
-    (void)osalHandler->GetTimeMs(&rightNow);
-    sendExpect = rightNow + waitDuration;
     while (1) {
-        (void)osalHandler->GetTimeMs(&rightNow);
-        if (sendExpect > rightNow) {
-            waitDuration = sendExpect - rightNow;
+        isCommandWakeup = false;
+        if (sendVideoFlag == true && (videoSource->fileReader.data != NULL || videoSource->remuxer != NULL)) {
+            // frames are paced on absolute deadlines, a playback command wakes the task before the deadline
+            timeToDeadlineUs = DjiUtilTime_PacerGetTimeToDeadlineUs(&framePacer);
+            if (timeToDeadlineUs >= 1000 &&
+                osalHandler->SemaphoreTimedWait(s_mediaPlayWorkSem, (uint32_t) (timeToDeadlineUs / 1000)) ==
+                DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+                isCommandWakeup = true;
+            } else {
+                DjiUtilTime_PacerWait(&framePacer);
+            }
         } else {
-            waitDuration = 1000 / SEND_VIDEO_TASK_FREQ;
+            (void)osalHandler->SemaphoreTimedWait(s_mediaPlayWorkSem, 1000 / SEND_VIDEO_TASK_FREQ);
         }
-        (void)osalHandler->SemaphoreTimedWait(s_mediaPlayWorkSem, waitDuration);
 
         // response playback command
-        if (osalHandler->MutexLock(s_mediaPlayCommandBufferMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-            USER_LOG_ERROR("mutex lock error");
-            continue;
-        }
-
-        bufferReadSize = UtilBuffer_Get(&s_mediaPlayCommandBufferHandler, (uint8_t *) &playbackCommand,
-                                        sizeof(T_TestPayloadCameraPlaybackCommand));
-
-        if (osalHandler->MutexUnlock(s_mediaPlayCommandBufferMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-            USER_LOG_ERROR("mutex unlock error");
-            continue;
-        }
+        bufferReadSize = UtilBuffer_MpscGet(&s_mediaPlayCommandBufferHandler, (uint8_t *) &playbackCommand,
+                                            sizeof(T_TestPayloadCameraPlaybackCommand));
 
-        if (bufferReadSize != sizeof(T_TestPayloadCameraPlaybackCommand))
+        if (bufferReadSize != sizeof(T_TestPayloadCameraPlaybackCommand)) {
+            // the next frame is not due before its deadline
+            if (isCommandWakeup)
+                continue;
             goto send;
+        }
 
         switch (playbackCommand.command) {
             case TEST_PAYLOAD_CAMERA_MEDIA_PLAY_COMMAND_STOP:
@@ -1288,44 +1422,25 @@ static void *UserCameraMedia_SendVideoTask(void *arg)
         }
 
         // video send preprocess
-        returnCode = DjiPlayback_VideoFileTranscode(videoFilePath, "h264", transcodedFilePath,
-                                                    DJI_FILE_PATH_SIZE_MAX);
-        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-            USER_LOG_ERROR("transcode video file error: 0x%08llX.", returnCode);
-            continue;
-        }
-
-        returnCode = DjiPlayback_GetFrameRateOfVideoFile(transcodedFilePath, &frameRate);
-        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-            USER_LOG_ERROR("get frame rate of video error: 0x%08llX.", returnCode);
-            continue;
-        }
-
-        returnCode = DjiPlayback_GetFrameInfoOfVideoFile(transcodedFilePath, frameInfo, VIDEO_FRAME_MAX_COUNT,
-                                                         &frameCount);
-        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-            USER_LOG_ERROR("get frame info of video error: 0x%08llX.", returnCode);
-            continue;
-        }
-
-        returnCode = DjiPlayback_GetFrameNumberByTime(frameInfo, frameCount, &frameNumber,
-                                                      startTimeMs);
+        (void)osalHandler->GetTimeMs(&openTimeMs);
+        isFirstFrameSent = false;
+        returnCode = DjiPlayback_OpenVideoSource(videoSource, videoFilePath, startTimeMs);
         if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-            USER_LOG_ERROR("get start frame number error: 0x%08llX.", returnCode);
+            USER_LOG_ERROR("open video source error: 0x%08llX.", returnCode);
             continue;
         }
 
-        if (fpFile != NULL)
-            fclose(fpFile);
-
-        fpFile = fopen(transcodedFilePath, "rb+");
-        if (fpFile == NULL) {
-            USER_LOG_ERROR("open video file:\"%s\" fail:%d.", transcodedFilePath, errno);
-            continue;
+        frameRate = videoSource->frameRate;
+        if (!(frameRate > 0.0f)) {
+            USER_LOG_WARN("invalid frame rate %f of %s, use %f.", frameRate, videoFilePath, VIDEO_DEFAULT_FRAME_RATE);
+            frameRate = VIDEO_DEFAULT_FRAME_RATE;
         }
+        DjiUtilTime_PacerInit(&framePacer, (uint64_t) (1000000000.0f / frameRate));
+        statCpuTimeUs = DjiUtilTime_GetThreadCpuTimeUs();
+        statFrameCount = 0;
 
         send:
-            if (fpFile == NULL) {
+            if (videoSource->fileReader.data == NULL && videoSource->remuxer == NULL) {
                 USER_LOG_ERROR("open video file fail.");
                 continue;
             }
@@ -1347,56 +1462,47 @@ static void *UserCameraMedia_SendVideoTask(void *arg)
                 continue;
             }
 
-            frameBufSize = frameInfo[frameNumber].size;
-            if (videoStreamType == DJI_CAMERA_VIDEO_STREAM_TYPE_H264_DJI_FORMAT) {
-                frameBufSize = frameBufSize + VIDEO_FRAME_AUD_LEN;
-            }
-
-            dataBuffer = calloc(frameBufSize, 1);
-            if (dataBuffer == NULL) {
-                USER_LOG_ERROR("malloc fail.");
-                goto free;
-            }
-
-            ret = fseek(fpFile, frameInfo[frameNumber].positionInFile, SEEK_SET);
-            if (ret != 0) {
-                USER_LOG_ERROR("fseek fail.");
-                goto free;
-            }
-
-            dataLength = fread(dataBuffer, 1, frameInfo[frameNumber].size, fpFile);
-            if (dataLength != frameInfo[frameNumber].size) {
+            // the frame is sent straight from the remuxer or the file mapping, the aud is a constant tail slice
+            returnCode = DjiPlayback_ReadVideoSourceFrame(videoSource, &frameData, &frameLen, &isReachTail);
+            if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
                 USER_LOG_ERROR("read data from video file error.");
-            } else {
-                USER_LOG_DEBUG("read data from video file success, len = %d B\r\n", dataLength);
+                continue;
             }
 
-            if (videoStreamType == DJI_CAMERA_VIDEO_STREAM_TYPE_H264_DJI_FORMAT) {
-                memcpy(&dataBuffer[frameInfo[frameNumber].size], s_frameAudInfo, VIDEO_FRAME_AUD_LEN);
-                dataLength = dataLength + VIDEO_FRAME_AUD_LEN;
-            }
+            if (frameLen > 0) {
+                frameSlices[0].data = frameData;
+                frameSlices[0].len = frameLen;
+                frameSliceCount = 1;
+                if (videoStreamType == DJI_CAMERA_VIDEO_STREAM_TYPE_H264_DJI_FORMAT) {
+                    frameSlices[1].data = s_frameAudInfo;
+                    frameSlices[1].len = VIDEO_FRAME_AUD_LEN;
+                    frameSliceCount = 2;
+                }
 
-            lengthOfDataHaveBeenSent = 0;
-            while (dataLength - lengthOfDataHaveBeenSent) {
-                lengthOfDataToBeSent = USER_UTIL_MIN(DATA_SEND_FROM_VIDEO_STREAM_MAX_LEN,
-                                                    dataLength - lengthOfDataHaveBeenSent);
-                returnCode = DjiPayloadCamera_SendVideoStream((const uint8_t *) dataBuffer + lengthOfDataHaveBeenSent,
-                                                            lengthOfDataToBeSent);
+                returnCode = DjiVideoStreamSender_SendSlices(&s_videoStreamSender, frameSlices, frameSliceCount);
                 if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
                     USER_LOG_ERROR("send video stream error: 0x%08llX.", returnCode);
                 }
-                lengthOfDataHaveBeenSent += lengthOfDataToBeSent;
-            }
 
-            (void)osalHandler->GetTimeMs(&sendExpect);
-            sendExpect += (1000 / frameRate);
+                if (!isFirstFrameSent) {
+                    (void)osalHandler->GetTimeMs(&firstFrameTimeMs);
+                    USER_LOG_INFO("first video frame sent %u ms after open.", firstFrameTimeMs - openTimeMs);
+                    isFirstFrameSent = true;
+                }
+            }
 
-            if ((frameNumber++) >= frameCount) {
-                USER_LOG_DEBUG("reach file tail.");
-                frameNumber = 0;
+            if (++statFrameCount >= VIDEO_SEND_STATISTICS_FRAME_COUNT) {
+                USER_LOG_DEBUG("video send: cpu %llu us/frame, pacing lateness avg %llu us max %llu us, resync %u.",
+                               (unsigned long long) ((DjiUtilTime_GetThreadCpuTimeUs() - statCpuTimeUs) /
+                                                     statFrameCount),
+                               (unsigned long long) (framePacer.totalLatenessUs / USER_UTIL_MAX(framePacer.waitCount, 1)),
+                               (unsigned long long) framePacer.maxLatenessUs, framePacer.resyncCount);
+                statCpuTimeUs = DjiUtilTime_GetThreadCpuTimeUs();
+                statFrameCount = 0;
+            }
 
-                if (sendOneTimeFlag == true)
-                    sendVideoFlag = false;
+            if (isReachTail && sendOneTimeFlag == true) {
+                sendVideoFlag = false;
             }
 
             returnCode = DjiPayloadCamera_GetVideoStreamState(&videoStreamState);
@@ -1409,9 +1515,6 @@ static void *UserCameraMedia_SendVideoTask(void *arg)
             } else {
                 USER_LOG_ERROR("get video stream state error.");
             }
-
-        free:
-            free(dataBuffer);
     }
 }
 
@@ -38,6 +38,11 @@
 #include "utils/util_time.h"
 #include "utils/util_file.h"
 #include "utils/util_buffer.h"
+#include "utils/util_nal_splitter.h"
+#include "utils/util_async_writer.h"
+#include "dji_video_stream_sender.h"
+#include "dji_camera_capture/dji_camera_capture_core.h"
+#include "dji_media_file_manage/dji_media_file_preview.h"
 #include "dji_platform.h"
 #include "time.h"
 #include <sys/stat.h>
@@ -46,19 +51,21 @@
 #define VIDEO_FRAME_AUD_LENGTH                  6
 #define RSP_MEDIA_FILE_STORE_PATH __FILE__
 #define VIDEO_BUFFER_SIZE                       1024 * 4
-#define START_VIDEO_STREAM_CMD                  "libcamera-vid -t 0 --width 1280 --height 720 --framerate 25 --codec h264 --inline --output -  --denoise auto --profile high --bitrate 2000000"
+#define VIDEO_NAL_SPLITTER_BUFFER_SIZE          (1024 * 1024 * 2)
+#define VIDEO_STREAM_READ_TIMEOUT_MS            100
+#define VIDEO_PARAMETER_SET_LENGTH_MAX          128
+#define VIDEO_H264_NAL_TYPE_IDR                 5
+#define VIDEO_H264_NAL_TYPE_SPS                 7
+#define VIDEO_H264_NAL_TYPE_PPS                 8
 /* Private types -------------------------------------------------------------*/
 
 /* Private functions declaration ---------------------------------------------*/
 static void DjiTest_ProcessRawH264WithAUD(uint8_t* data, size_t length);
 static void * DjiTest_H264StreamControlTask(void* arg);
-static void DjiTest_PauseStreaming(void);
-static void DjiTest_ResumeStreaming(void);
 static void *DjiTest_RaspberryPiCameraTask(void *arg);
 static T_DjiReturnCode DjiTest_CameraTakePhotoImpl(const char *filename);
-static void DjiTest_ProcessSingleNALUnit(uint8_t* nal_data, size_t nal_length);
-static size_t DjiTest_ProcessCompleteNALUnits(uint8_t* data, size_t length);
-static void DjiTest_ProcessRawH264WithBuffer(uint8_t* data, size_t length);
+static void DjiTest_ProcessSingleNALUnit(const uint8_t* nal_data, uint32_t nal_length, void *userData);
+static uint32_t DjiTest_GetVideoHeader(const uint8_t* nal_data, uint32_t nal_length);
 /* Private variables -------------------------------------------------------------*/
 static int s_photoCount = 0;
 static bool s_recordingFlag = false;
@@ -66,35 +73,69 @@ static const uint8_t s_frameAudData[VIDEO_FRAME_AUD_LENGTH] = {0x00, 0x00, 0x00,
 static T_DjiMutexHandle s_cameraMutex;
 static bool camera_init_flag = false;
 static T_DjiTaskHandle s_camerLiveviewThread;
+static T_DjiMutexHandle s_recordWriterMutex;
 static bool s_recording = false;
-static bool s_streaming_paused = false;
-static FILE *s_output_file = NULL;
-static FILE *s_camera_stream = NULL;
+static T_UtilAsyncWriterHandle s_recordWriter = NULL;
+static T_DjiCameraCaptureHandle s_cameraCapture = NULL;
 static bool s_cameraTaskRunningFlag = false;
 static uint8_t *s_nal_buffer = NULL;
-static size_t s_nal_buffer_size = 0;
-static size_t s_nal_buffer_capacity = 0;
+static T_UtilNalSplitter s_nalSplitter;
+static T_DjiVideoStreamSender s_videoStreamSender;
+static uint8_t s_videoStreamSenderArena[DJI_VIDEO_STREAM_SENDER_ARENA_SIZE];
+static uint8_t s_spsData[VIDEO_PARAMETER_SET_LENGTH_MAX];
+static uint32_t s_spsLength = 0;
+static uint8_t s_ppsData[VIDEO_PARAMETER_SET_LENGTH_MAX];
+static uint32_t s_ppsLength = 0;
+static uint8_t s_videoHeader[VIDEO_PARAMETER_SET_LENGTH_MAX * 2];
+static uint8_t s_lastNalType = 0;
 
 /* Exported functions definition ---------------------------------------------*/
 T_DjiReturnCode DjiTest_RaspberryPiCameraInit() {
     T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
     T_DjiReturnCode returnCode;
+    T_DjiCameraCaptureConfig captureConfig;
     s_photoCount = 0;
     s_recordingFlag = false;
 
-    s_nal_buffer_capacity = VIDEO_BUFFER_SIZE;
-    s_nal_buffer = malloc(s_nal_buffer_capacity);
+    s_nal_buffer = malloc(VIDEO_NAL_SPLITTER_BUFFER_SIZE);
     if (!s_nal_buffer) {
         USER_LOG_ERROR("malloc nal buffer error");
         return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
     }
-    s_nal_buffer_size = 0;
+    UtilNalSplitter_Init(&s_nalSplitter, s_nal_buffer, VIDEO_NAL_SPLITTER_BUFFER_SIZE,
+                         DjiTest_ProcessSingleNALUnit, NULL);
+    DjiVideoStreamSender_Init(&s_videoStreamSender, DjiPayloadCamera_SendVideoStream,
+                              s_videoStreamSenderArena, sizeof(s_videoStreamSenderArena));
 
     if(osalHandler->MutexCreate(&s_cameraMutex)!= DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
         USER_LOG_ERROR("Create mutex error");
         return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
     }
 
+    // separate from s_cameraMutex, so camera commands never wait for a recording write to disk
+    if(osalHandler->MutexCreate(&s_recordWriterMutex)!= DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Create record writer mutex error");
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    DjiCameraCapture_GetDefaultConfig(&captureConfig);
+    if (strlen(RASPBERRY_PI_CAMERA_REPLAY_FILE_PATH) > 0) {
+        strncpy(captureConfig.replayFilePath, RASPBERRY_PI_CAMERA_REPLAY_FILE_PATH,
+                sizeof(captureConfig.replayFilePath) - 1);
+        returnCode = DjiCameraCapture_Open(DJI_CAMERA_CAPTURE_TYPE_FILE, &captureConfig, &s_cameraCapture);
+    } else {
+        // hardware capture and encode keeps the stream running while taking photos, libcamera is the fallback
+        returnCode = DjiCameraCapture_Open(DJI_CAMERA_CAPTURE_TYPE_V4L2, &captureConfig, &s_cameraCapture);
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            USER_LOG_WARN("V4L2 capture not available, fall back to libcamera pipe");
+            returnCode = DjiCameraCapture_Open(DJI_CAMERA_CAPTURE_TYPE_PIPE, &captureConfig, &s_cameraCapture);
+        }
+    }
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Open camera capture error: 0x%08llX", returnCode);
+        return returnCode;
+    }
+
     s_cameraTaskRunningFlag = true;
 
     returnCode = osalHandler->TaskCreate("user_camera_media_task", DjiTest_RaspberryPiCameraTask, 2048,
@@ -144,6 +185,11 @@ void DjiTest_raspberryPiCameraDeinit(void) {
         s_cameraMutex = NULL;
     }
 
+    if (s_recordWriterMutex) {
+        DjiPlatform_GetOsalHandler()->MutexDestroy(s_recordWriterMutex);
+        s_recordWriterMutex = NULL;
+    }
+
     USER_LOG_INFO("Raspberry Pi Camera deinitialized");
 }
 /* Private functions definition-----------------------------------------------*/
@@ -172,48 +218,65 @@ static void *DjiTest_RaspberryPiCameraTask(void *arg) {
         osalHandler->MutexUnlock(s_cameraMutex);
 
         if(local_photo_flag) {
-            USER_LOG_INFO("raspberry pi camera pause streaming");
-            DjiTest_PauseStreaming();
-
             char full_path[256];
             time_t now = time(NULL);
             snprintf(full_path, sizeof(full_path), "%s/photo_%ld.jpg", RSP_MEDIA_FILE_STORE_PATH, now);
             USER_LOG_INFO("raspberry pi camera take photo ......");
             if (DjiTest_CameraTakePhotoImpl(full_path) == 0) {
                 USER_LOG_INFO("photo saved as: %s\n", full_path);
+                DjiMediaFilePreview_Warm(full_path);
             } else {
                 USER_LOG_ERROR("failed to take photo\n");
             }
 
-            DjiTest_ResumeStreaming();
             osalHandler->MutexLock(s_cameraMutex);
             if (s_photoCount > 0) {
                 s_photoCount--;
             }
             osalHandler->MutexUnlock(s_cameraMutex);
-            USER_LOG_INFO("raspberry pi camera resume streaming");
         }
 
        if(last_recording_flag != local_recording_flag) {
             if(local_recording_flag) {
-                s_recording = true;
+                T_UtilAsyncWriterConfig writerConfig;
+                T_UtilAsyncWriterHandle writerHandle = NULL;
                 time_t now = time(NULL);
+
                 snprintf(current_h264_path, sizeof(current_h264_path), "%s/video_%ld.h264", RSP_MEDIA_FILE_STORE_PATH, now);
-                s_output_file = fopen(current_h264_path, "wb");
-                if (!s_output_file) {
-                    perror("fopen");
-                    s_recording = false;
+                UtilAsyncWriter_GetDefaultConfig(&writerConfig);
+                if (UtilAsyncWriter_Open(current_h264_path, &writerConfig, &writerHandle) !=
+                    DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
                     USER_LOG_ERROR("create recording file failed");
                 } else {
+                    osalHandler->MutexLock(s_recordWriterMutex);
+                    s_recordWriter = writerHandle;
+                    s_recording = true;
+                    osalHandler->MutexUnlock(s_recordWriterMutex);
                     USER_LOG_INFO("raspberry pi camera start recording: %s", current_h264_path);
                 }
 
             } else {
+                T_UtilAsyncWriterHandle writerHandle;
+
                 USER_LOG_INFO("raspberry pi camera stop recording");
+                // waits for a write in progress, the stream task never uses the writer after this
+                osalHandler->MutexLock(s_recordWriterMutex);
+                writerHandle = s_recordWriter;
+                s_recordWriter = NULL;
                 s_recording = false;
-                if (s_output_file) {
-                    fclose(s_output_file);
-                    s_output_file = NULL;
+                osalHandler->MutexUnlock(s_recordWriterMutex);
+                if (writerHandle) {
+                    T_UtilAsyncWriterStatistics writerStatistics;
+
+                    UtilAsyncWriter_Flush(writerHandle);
+                    UtilAsyncWriter_GetStatistics(writerHandle, &writerStatistics);
+                    if (UtilAsyncWriter_Close(writerHandle) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+                        USER_LOG_ERROR("write recording file failed");
+                    }
+                    USER_LOG_INFO("recording writer: %llu bytes, %u writes, %u fsync, max wait %llu us",
+                                  (unsigned long long) writerStatistics.bytesWritten, writerStatistics.writeCount,
+                                  writerStatistics.fsyncCount,
+                                  (unsigned long long) writerStatistics.producerWaitMaxUs);
 
                     if (strlen(current_h264_path) > 0) {
                         char mp4_path[256];
@@ -230,6 +293,7 @@ static void *DjiTest_RaspberryPiCameraTask(void *arg) {
 
                             if (result == 0) {
                                 USER_LOG_INFO("Video converted successfully: %s", mp4_path);
+                                DjiMediaFilePreview_Warm(mp4_path);
                                 if (remove(current_h264_path) == 0) {
                                     USER_LOG_INFO("Deleted temporary file: %s", current_h264_path);
                                 } else {
@@ -249,252 +313,142 @@ static void *DjiTest_RaspberryPiCameraTask(void *arg) {
     }
 
     USER_LOG_INFO("raspberry pi camera shut down");
-    if (s_output_file) {
-        fclose(s_output_file);
+    DjiPlatform_GetOsalHandler()->MutexLock(s_recordWriterMutex);
+    if (s_recordWriter) {
+        UtilAsyncWriter_Close(s_recordWriter);
+        s_recordWriter = NULL;
+        s_recording = false;
     }
-
-    if (s_camera_stream) {
-        pclose(s_camera_stream);
-        s_camera_stream = NULL;
-    }
-
-    if (s_camera_stream) pclose(s_camera_stream);
+    DjiPlatform_GetOsalHandler()->MutexUnlock(s_recordWriterMutex);
 
     if (streamControllerHandler) {
         DjiPlatform_GetOsalHandler()->TaskDestroy(streamControllerHandler);
     }
 
-    return NULL;
-}
-
-static void DjiTest_PauseStreaming() {
-    s_streaming_paused = true;
-    if (s_camera_stream) {
-        pclose(s_camera_stream);
-        s_camera_stream = NULL;
-    }
-    DjiPlatform_GetOsalHandler()->TaskSleepMs(100);
-    USER_LOG_INFO("Streaming paused");
-}
-
-static void DjiTest_ResumeStreaming() {
-
-    s_camera_stream = popen(START_VIDEO_STREAM_CMD, "r");
-    if (!s_camera_stream) {
-        perror("popen libcamera-vid");
-        return;
+    if (s_cameraCapture) {
+        DjiCameraCapture_Close(s_cameraCapture);
+        s_cameraCapture = NULL;
     }
 
-    s_streaming_paused = false;
-    USER_LOG_INFO("Streaming resumed");
+    return NULL;
 }
 
 static void * DjiTest_H264StreamControlTask(void* arg)
 {
-    unsigned char buffer[VIDEO_BUFFER_SIZE];
-    size_t bytes_read;
-
-    s_camera_stream = popen(START_VIDEO_STREAM_CMD, "r");
-    if (!s_camera_stream) {
-        perror("popen libcamera-vid");
-        exit(EXIT_FAILURE);
-    }
-
-    USER_LOG_INFO("H.264 stream control task started");
-
-    while (1) {
-        if (s_streaming_paused) {
+    T_DjiReturnCode returnCode;
+    uint8_t *span;
+    uint32_t span_length;
+    uint32_t bytes_read;
+    uint32_t dropped_bytes = 0;
+    uint32_t stream_generation = s_cameraCapture->streamGeneration;
+
+    USER_LOG_INFO("H.264 stream control task started, capture: %s", s_cameraCapture->captureOptItem.name);
+
+    while (s_cameraTaskRunningFlag) {
+        // read straight into the splitter, the backend returns as soon as encoded data is available
+        span_length = UtilNalSplitter_GetWritableSpan(&s_nalSplitter, &span);
+        returnCode = DjiCameraCapture_ReadStream(s_cameraCapture, span, span_length, &bytes_read,
+                                                 VIDEO_STREAM_READ_TIMEOUT_MS);
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
             DjiPlatform_GetOsalHandler()->TaskSleepMs(10);
             continue;
         }
 
-        if (s_camera_stream && !feof(s_camera_stream)) {
-
-            bytes_read = fread(buffer, 1, sizeof(buffer), s_camera_stream);
-            if (bytes_read > 0) {
-                DjiTest_ProcessRawH264WithBuffer(buffer, bytes_read);
-            }
-        } else {
-            DjiPlatform_GetOsalHandler()->TaskSleepMs(10);
+        if (s_cameraCapture->streamGeneration != stream_generation) {
+            // the restarted stream begins with a new start code, pending data belongs to the old one
+            UtilNalSplitter_Reset(&s_nalSplitter);
+            stream_generation = s_cameraCapture->streamGeneration;
         }
 
-        if (!s_cameraTaskRunningFlag) {
-            break;
+        if (bytes_read > 0) {
+            UtilNalSplitter_CommitWrite(&s_nalSplitter, bytes_read);
         }
-    }
 
-    if (s_camera_stream) {
-        pclose(s_camera_stream);
-        s_camera_stream = NULL;
+        if (s_nalSplitter.droppedBytes != dropped_bytes) {
+            USER_LOG_WARN("nal unit larger than splitter buffer, dropped %u bytes",
+                          s_nalSplitter.droppedBytes - dropped_bytes);
+            dropped_bytes = s_nalSplitter.droppedBytes;
+        }
     }
 
     USER_LOG_INFO("H.264 stream control task terminated");
     return NULL;
 }
 
-static size_t DjiTest_ProcessCompleteNALUnits(uint8_t* data, size_t length)
+static void DjiTest_ProcessSingleNALUnit(const uint8_t* nal_data, uint32_t nal_length, void *userData)
 {
-    if (!data || length < 4) return 0;
-
-    uint8_t* current_pos = data;
-    size_t remaining = length;
-    size_t processed_bytes = 0;
-
-    while (remaining >= 4) {
-        // find nal start
-        if (current_pos[0] == 0x00 && current_pos[1] == 0x00 &&
-            current_pos[2] == 0x00 && current_pos[3] == 0x01) {
-
-            uint8_t* nal_start = current_pos;
-            uint8_t* next_start = NULL;
-
-            // find the next nal start
-            for (size_t i = 4; i < remaining - 3; i++) {
-                if (current_pos[i] == 0x00 && current_pos[i+1] == 0x00 &&
-                    current_pos[i+2] == 0x00 && current_pos[i+3] == 0x01) {
-                    next_start = current_pos + i;
-                    break;
-                }
-            }
-
-            if (next_start) {
-                size_t nal_size = next_start - nal_start;
-                DjiTest_ProcessSingleNALUnit(nal_start, nal_size);
-                processed_bytes = next_start - data;
-                current_pos = next_start;
-                remaining = length - processed_bytes;
-            } else {
-                break;
-            }
-        } else {
-            current_pos++;
-            remaining--;
-            processed_bytes++;
-        }
-    }
-
-    return processed_bytes;
-}
+    T_DjiReturnCode returnCode;
+    T_DjiVideoStreamSlice frameSlices[3];
 
-static void DjiTest_ProcessSingleNALUnit(uint8_t* nal_data, size_t nal_length)
-{
-    bool local_recording = false;
+    USER_UTIL_UNUSED(userData);
     if (!nal_data || nal_length == 0) return;
-    // add aud
-    size_t total_frame_size = nal_length + VIDEO_FRAME_AUD_LENGTH;
-    uint8_t* frame_with_aud = malloc(total_frame_size);
-
-    if (!frame_with_aud) {
-        USER_LOG_ERROR("Failed to allocate frame buffer");
-        return;
-    }
 
-    memcpy(frame_with_aud, nal_data, nal_length);
-    memcpy(frame_with_aud + nal_length, s_frameAudData, VIDEO_FRAME_AUD_LENGTH);
-
-    DjiPlatform_GetOsalHandler()->MutexLock(s_cameraMutex);
-    local_recording = s_recording;
-    DjiPlatform_GetOsalHandler()->MutexUnlock(s_cameraMutex);
-
-    if (local_recording && s_output_file && total_frame_size > 0) {
-        size_t total_fwritten = 0;
-        while (total_fwritten < total_frame_size) {
-            size_t fw = fwrite(frame_with_aud + total_fwritten, 1, total_frame_size - total_fwritten, s_output_file);
-            if (fw > 0) {
-                total_fwritten += fw;
-                continue;
-            }
-            if (ferror(s_output_file)) {
-                perror("fwrite error");
-                clearerr(s_output_file);
-                break;
-            }
+    // header, nal unit and aud go out as one frame, only fragments crossing a slice boundary are copied
+    frameSlices[0].data = s_videoHeader;
+    frameSlices[0].len = DjiTest_GetVideoHeader(nal_data, nal_length);
+    frameSlices[1].data = nal_data;
+    frameSlices[1].len = nal_length;
+    frameSlices[2].data = s_frameAudData;
+    frameSlices[2].len = VIDEO_FRAME_AUD_LENGTH;
+
+    DjiPlatform_GetOsalHandler()->MutexLock(s_recordWriterMutex);
+    if (s_recording && s_recordWriter) {
+        if (UtilAsyncWriter_Write(s_recordWriter, nal_data, nal_length) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS ||
+            UtilAsyncWriter_Write(s_recordWriter, s_frameAudData, VIDEO_FRAME_AUD_LENGTH) !=
+            DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            USER_LOG_ERROR("write recording data failed");
         }
-        fflush(s_output_file);
     }
+    DjiPlatform_GetOsalHandler()->MutexUnlock(s_recordWriterMutex);
 
-    if (total_frame_size > 60000) {
-        size_t offset = 0;
-        while (offset < total_frame_size) {
-            size_t send_length = (total_frame_size - offset > 6000) ? 6000 : (total_frame_size - offset);
-
-            T_DjiReturnCode returnCode = DjiPayloadCamera_SendVideoStream(
-                frame_with_aud + offset,
-                send_length
-            );
-
-            if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-                USER_LOG_ERROR("send fragmented video stream failed: 0x%08llX", returnCode);
-            }
-
-            offset += send_length;
-        }
-    } else {
-        T_DjiReturnCode returnCode = DjiPayloadCamera_SendVideoStream(
-            frame_with_aud,
-            total_frame_size
-        );
-
-        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-            USER_LOG_ERROR("send video stream failed: 0x%08llX", returnCode);
-        }
+    returnCode = DjiVideoStreamSender_SendSlices(&s_videoStreamSender, frameSlices, UTIL_ARRAY_SIZE(frameSlices));
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("send video stream failed: 0x%08llX", returnCode);
     }
-
-    free(frame_with_aud);
 }
 
-static void DjiTest_ProcessRawH264WithBuffer(uint8_t* data, size_t length)
+/**
+ * @brief Remember the latest SPS and PPS, and put them in front of an IDR slice the stream does not precede with
+ * them, so the receiver can start decoding at every IDR frame, e.g. after a stream restart.
+ * @return Length of the header in s_videoHeader to send before the NAL unit, 0 for no header.
+ */
+static uint32_t DjiTest_GetVideoHeader(const uint8_t* nal_data, uint32_t nal_length)
 {
-    if (!data || length == 0) return;
-
-    size_t required_capacity = s_nal_buffer_size + length;
-    if (s_nal_buffer_capacity < required_capacity) {
-        size_t new_capacity = required_capacity * 2;
-        uint8_t *new_buffer = realloc(s_nal_buffer, new_capacity);
-        if (!new_buffer) {
-            USER_LOG_ERROR("realloc failed");
-            return;
-        }
-        s_nal_buffer = new_buffer;
-        s_nal_buffer_capacity = new_capacity;
-    }
-
-    memcpy(s_nal_buffer + s_nal_buffer_size, data, length);
-    s_nal_buffer_size += length;
+    uint32_t code_length = nal_data[2] == 0x01 ? 3 : 4;
+    uint32_t header_length = 0;
+    uint8_t nal_type;
 
-    size_t processed_bytes = DjiTest_ProcessCompleteNALUnits(s_nal_buffer, s_nal_buffer_size);
+    if (nal_length <= code_length) {
+        return 0;
+    }
 
-    if (processed_bytes < s_nal_buffer_size) {
-        memmove(s_nal_buffer, s_nal_buffer + processed_bytes, s_nal_buffer_size - processed_bytes);
-        s_nal_buffer_size -= processed_bytes;
-    } else {
-        s_nal_buffer_size = 0;
+    nal_type = nal_data[code_length] & 0x1F;
+    if (nal_type == VIDEO_H264_NAL_TYPE_SPS && nal_length <= VIDEO_PARAMETER_SET_LENGTH_MAX) {
+        memcpy(s_spsData, nal_data, nal_length);
+        s_spsLength = nal_length;
+    } else if (nal_type == VIDEO_H264_NAL_TYPE_PPS && nal_length <= VIDEO_PARAMETER_SET_LENGTH_MAX) {
+        memcpy(s_ppsData, nal_data, nal_length);
+        s_ppsLength = nal_length;
+    } else if (nal_type == VIDEO_H264_NAL_TYPE_IDR && s_lastNalType != VIDEO_H264_NAL_TYPE_PPS &&
+               s_lastNalType != VIDEO_H264_NAL_TYPE_IDR && s_spsLength > 0 && s_ppsLength > 0) {
+        memcpy(s_videoHeader, s_spsData, s_spsLength);
+        memcpy(s_videoHeader + s_spsLength, s_ppsData, s_ppsLength);
+        header_length = s_spsLength + s_ppsLength;
     }
+    s_lastNalType = nal_type;
+
+    return header_length;
 }
 
 static T_DjiReturnCode DjiTest_CameraTakePhotoImpl(const char *filename) {
     if (!filename) {
         USER_LOG_ERROR("Invalid filename");
-        return -1;
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
     }
 
-    char cmd[256];
-    snprintf(cmd, sizeof(cmd),
-            "libcamera-still -o %s --width 1280 --height 720 --quality 90 --timeout 100 --framerate 25 --verbose 0 2>/dev/null",
-            filename);
-
     USER_LOG_INFO("Taking photo: %s", filename);
-    int result = system(cmd);
 
-    FILE *test = fopen(filename, "rb");
-    if (test) {
-        fclose(test);
-        USER_LOG_INFO("Photo captured successfully: %s", filename);
-        return 0;
-    } else {
-        USER_LOG_ERROR("Failed to capture photo: %s", filename);
-        return -1;
-    }
+    return DjiCameraCapture_TakePhoto(s_cameraCapture, filename);
 }
 
 //#endif
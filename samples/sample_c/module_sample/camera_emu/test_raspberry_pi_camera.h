@@ -37,6 +37,8 @@ extern "C" {
 
 /* Exported constants --------------------------------------------------------*/
 #define USE_RASPBERRY_PI_CAMERA 0
+/* Replay this Annex-B H.264 file instead of the camera when not empty, e.g. a recording of this sample. */
+#define RASPBERRY_PI_CAMERA_REPLAY_FILE_PATH    ""
 /* Exported types ------------------------------------------------------------*/
 
 /* Exported functions --------------------------------------------------------*/
@@ -27,25 +27,29 @@
 #include <utils/util_misc.h>
 #include <time.h>
 #include "test_camera_manager.h"
+#include "test_camera_manager_download_scheduler.h"
+#include "test_camera_manager_download_sim.h"
+#include "test_camera_manager_point_cloud.h"
 #include "dji_camera_manager.h"
 #include "dji_platform.h"
 #include "dji_logger.h"
 #include "dji_mop_channel.h"
 
 /* Private constants ---------------------------------------------------------*/
-#define TEST_CAMERA_MANAGER_MEDIA_FILE_NAME_MAX_SIZE             256
 #define TEST_CAMERA_MANAGER_MEDIA_DOWNLOAD_FILE_NUM              5
+#define TEST_CAMERA_MANAGER_DOWNLOAD_WAIT_TIME_MS                1000
+#define TEST_CAMERA_MANAGER_DOWNLOAD_SIM_LATENCY_MS              20
+#define TEST_CAMERA_MANAGER_DOWNLOAD_SIM_BYTES_PER_SECOND        (8 * 1024 * 1024)
 #define CAMERA_MANAGER_SUBSCRIPTION_FREQ                         5
 
 #define TEST_CAMERA_MAX_INFRARED_ZOOM_FACTOR          8
 #define TEST_CAMERA_MIN_INFRARED_ZOOM_FACTOR          2
 #define TEST_CAMERA_MOP_CHANNEL_SUBSCRIBE_POINT_CLOUD_CHANNEL_ID         49154
 #define TEST_CAMERA_MOP_CHANNEL_SUBSCRIBE_POINT_CLOUD_RECV_BUFFER        (512 * 1024)
-#define TEST_CAMERA_MOP_CHANNEL_COLOR_POINTS_BUFFER                      (512 * 1024)
 #define TEST_CAMERA_MOP_CHANNEL_WAIT_TIME_MS                             (3 * 1000)
 #define TEST_CAMERA_MOP_CHANNEL_MAX_RECV_COUNT                           30
+#define TEST_CAMERA_MOP_CHANNEL_RECV_RETRY_WAIT_MS                       100
 #define TEST_CAMEAR_POINT_CLOUD_FILE_PATH_STR_MAX_SIZE                   256
-#define TEST_CAMEAR_MEDIA_SUB_FILE_NOT_FOUND                             -1
 
 /* Private types -------------------------------------------------------------*/
 typedef struct {
@@ -83,13 +87,12 @@ static const T_DjiTestCameraTypeStr s_cameraTypeStrList[] = {
 };
 
 #ifndef SYSTEM_ARCH_RTOS
-static FILE *s_downloadMediaFile = NULL;
-static T_DjiCameraManagerFileList s_meidaFileList;
-static uint32_t downloadStartMs = 0;
-static uint32_t downloadEndMs = 0;
-static char downloadFileName[TEST_CAMERA_MANAGER_MEDIA_FILE_NAME_MAX_SIZE] = {0};
-static uint32_t s_nextDownloadFileIndex = 0;
 static T_DjiMopChannelHandle s_mopChannelHandle;
+#if USE_CAMERA_MANAGER_DOWNLOAD_SIM
+static const uint32_t s_downloadSimFileSizes[] = {
+    3 * 1024 * 1024, 5 * 1024 * 1024, 4 * 1024 * 1024, 64 * 1024 * 1024, 3 * 1024 * 1024, 16 * 1024 * 1024,
+};
+#endif
 static char s_pointCloudFilePath[TEST_CAMEAR_POINT_CLOUD_FILE_PATH_STR_MAX_SIZE];
 #endif
 
@@ -98,8 +101,7 @@ static uint8_t DjiTest_CameraManagerGetCameraTypeIndex(E_DjiCameraType cameraTyp
 #ifdef SYSTEM_ARCH_LINUX
 static T_DjiReturnCode DjiTest_CameraManagerMediaDownloadAndDeleteMediaFile(E_DjiMountPosition position);
 static T_DjiReturnCode DjiTest_CameraManagerMediaDownloadFileListBySlices(E_DjiMountPosition position);
-static T_DjiReturnCode DjiTest_CameraManagerDownloadFileDataCallback(T_DjiDownloadFilePacketInfo packetInfo,
-                                                                     const uint8_t *data, uint16_t len);
+static T_DjiReturnCode DjiTest_CameraManagerRunDownloadRequest(const T_DjiTestDownloadRequest *request);
 #endif
 static T_DjiReturnCode DjiTest_CameraManagerGetAreaThermometryData(E_DjiMountPosition position);
 static T_DjiReturnCode DjiTest_CameraManagerGetPointThermometryData(E_DjiMountPosition position);
@@ -2161,332 +2163,82 @@ static uint8_t DjiTest_CameraManagerGetCameraTypeIndex(E_DjiCameraType cameraTyp
 #ifdef SYSTEM_ARCH_LINUX
 static T_DjiReturnCode DjiTest_CameraManagerMediaDownloadAndDeleteMediaFile(E_DjiMountPosition position)
 {
-    T_DjiReturnCode returnCode;
-    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
-    uint16_t downloadCount = 0;
-    uint16_t subFileDownloadCount = 0;
-    int i = 0, j= 0;
-
-    s_nextDownloadFileIndex = 0;
-    returnCode = DjiCameraManager_RegDownloadFileDataCallback(position, DjiTest_CameraManagerDownloadFileDataCallback);
-    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("Register download file data callback failed, error code: 0x%08X.", returnCode);
-        return returnCode;
-    }
+    T_DjiTestDownloadRequest request = {0};
 
-    USER_LOG_INFO("obtain downloader rights of pos %d", position);
-    returnCode = DjiCameraManager_ObtainDownloaderRights(position);
-    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("Obtain downloader rights failed, error code: 0x%08X.", returnCode);
-        return returnCode;
-    }
+    request.position = position;
+    request.countPerSlice = DJI_CAMERA_MANAGER_FILE_LIST_COUNT_60_PER_SLICE;
+    request.downloadCount = 0;
+    request.deleteCount = 1;
+    request.printFileList = true;
 
-    returnCode = DjiCameraManager_DownloadFileList(position, &s_meidaFileList);
-    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("Download file list failed, error code: 0x%08X.", returnCode);
-        return returnCode;
-    }
-
-    if (s_meidaFileList.totalCount > 0) {
-        downloadCount = s_meidaFileList.totalCount;
-        subFileDownloadCount = s_meidaFileList.fileListInfo->subFileListTotalNum;
-        printf(
-            "\033[1;33;40m -> Download file list finished, total media file count is %d "
-                   "the following %d is list details: \033[0m\r\n",
-            s_meidaFileList.totalCount, downloadCount);
-
-        for (i = 0; i < downloadCount; ++i) {
-                printf(
-                    "\033[1;32;40m ### Media file_%03d name: %s, index: %d, time:%04d-%02d-%02d_%02d:%02d:%02d, size: %.2f KB, type: %d \033[0m\r\n",
-                    i, s_meidaFileList.fileListInfo[i].fileName,
-                    s_meidaFileList.fileListInfo[i].fileIndex,
-                    s_meidaFileList.fileListInfo[i].createTime.year,
-                    s_meidaFileList.fileListInfo[i].createTime.month,
-                    s_meidaFileList.fileListInfo[i].createTime.day,
-                    s_meidaFileList.fileListInfo[i].createTime.hour,
-                    s_meidaFileList.fileListInfo[i].createTime.minute,
-                    s_meidaFileList.fileListInfo[i].createTime.second,
-                    (dji_f32_t) s_meidaFileList.fileListInfo[i].fileSize / (1024),
-                    s_meidaFileList.fileListInfo[i].type);
-            if (s_meidaFileList.fileListInfo[i].type == DJI_CAMERA_FILE_TYPE_LDRT) {
-                for (j = 0; j < s_meidaFileList.fileListInfo[i].subFileListTotalNum; j++) {
-                    printf(
-                        "\033[1;32;40m ### Media file_%03d, sub_file_%03d,  name: %s, index: %d, time:%04d-%02d-%02d_%02d:%02d:%02d, size: %.2f KB, sub type: %d\033[0m\r\n",
-                        i, j, s_meidaFileList.fileListInfo[i].subFileListInfo[j].fileName,
-                        s_meidaFileList.fileListInfo[i].subFileListInfo[j].fileIndex,
-                        s_meidaFileList.fileListInfo[i].subFileListInfo[j].createTime.year,
-                        s_meidaFileList.fileListInfo[i].subFileListInfo[j].createTime.month,
-                        s_meidaFileList.fileListInfo[i].subFileListInfo[j].createTime.day,
-                        s_meidaFileList.fileListInfo[i].subFileListInfo[j].createTime.hour,
-                        s_meidaFileList.fileListInfo[i].subFileListInfo[j].createTime.minute,
-                        s_meidaFileList.fileListInfo[i].subFileListInfo[j].createTime.second,
-                        (dji_f32_t) s_meidaFileList.fileListInfo[i].subFileListInfo[j].fileSize / (1024),
-                        s_meidaFileList.fileListInfo[i].subFileListInfo[j].type);
-                }
-            }
-        }
-        printf("\r\n");
-
-        osalHandler->TaskSleepMs(1000);
-
-        downloadCount =  s_meidaFileList.totalCount;
-
-        for (i = 0; i < downloadCount; ++i) {
-            redownload:
-            if (i != s_nextDownloadFileIndex) {
-                i = s_nextDownloadFileIndex;
-            }
-            returnCode = DjiCameraManager_DownloadFileByIndex(position, s_meidaFileList.fileListInfo[i].fileIndex);
-            if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-                USER_LOG_ERROR("Download media file by index failed, error code: 0x%08X.", returnCode);
-                if(s_nextDownloadFileIndex > 0)s_nextDownloadFileIndex--;
-                goto redownload;
-            }
-            if (s_meidaFileList.fileListInfo[i].type == DJI_CAMERA_FILE_TYPE_LDRT) {
-                for (j = 0; j < s_meidaFileList.fileListInfo[i].subFileListTotalNum; j++) {
-                    subFileRedownload:
-                    returnCode = DjiCameraManager_DownloadSubFileByIndexAndSubType(position,
-                                                                                s_meidaFileList.fileListInfo[i].fileIndex,
-                                                                                s_meidaFileList.fileListInfo[i].subFileListInfo[j].type);
-
-                    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-                        USER_LOG_ERROR("Download sub media file by index and type failed, error code: 0x%08X.", returnCode);
-                        goto subFileRedownload;
-                    }
-                }
-            }
-        }
-
-        if (s_meidaFileList.fileListInfo[0].type == DJI_CAMERA_FILE_TYPE_JPEG ||
-            s_meidaFileList.fileListInfo[0].type == DJI_CAMERA_FILE_TYPE_MP4) {
-            USER_LOG_INFO("delete camera file of index %d", s_meidaFileList.fileListInfo[0].fileIndex);
-            returnCode = DjiCameraManager_DeleteFileByIndex(position, s_meidaFileList.fileListInfo[0].fileIndex);
-            if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-                USER_LOG_ERROR("Delete media file by index failed, error code: 0x%08X.", returnCode);
-            }
-        }
+    return DjiTest_CameraManagerRunDownloadRequest(&request);
+}
 
-        osalHandler->TaskSleepMs(1000);
-    } else {
-        USER_LOG_WARN("Media file is not existed in sdcard.\r\n");
-    }
+static T_DjiReturnCode DjiTest_CameraManagerMediaDownloadFileListBySlices(E_DjiMountPosition position)
+{
+    T_DjiTestDownloadRequest request = {0};
 
-ReleaseDownloaderRights:
-    returnCode = DjiCameraManager_ReleaseDownloaderRights(position);
-    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("Release downloader rights failed, error code: 0x%08X.", returnCode);
-    }
+    request.position = position;
+    request.countPerSlice = DJI_CAMERA_MANAGER_FILE_LIST_COUNT_ALL_PER_SLICE;
+    request.downloadCount = 1;
+    request.deleteCount = 0;
+    request.printFileList = true;
 
-    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    return DjiTest_CameraManagerRunDownloadRequest(&request);
 }
 
-static T_DjiReturnCode DjiTest_CameraManagerMediaDownloadFileListBySlices(E_DjiMountPosition position)
+static T_DjiReturnCode DjiTest_CameraManagerRunDownloadRequest(const T_DjiTestDownloadRequest *request)
 {
+    const T_DjiTestDownloadBackend *backend = NULL;
+    T_DjiTestDownloadResult result = {0};
     T_DjiReturnCode returnCode;
-    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
-    uint16_t downloadCount = 0;
-    T_DjiCameraManagerSliceConfig sliceConfig = {0};
 
-    s_nextDownloadFileIndex = 0;
-    returnCode = DjiCameraManager_RegDownloadFileDataCallback(position, DjiTest_CameraManagerDownloadFileDataCallback);
-    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("Register download file data callback failed, error code: 0x%08X.", returnCode);
-        return returnCode;
-    }
+#if USE_CAMERA_MANAGER_DOWNLOAD_SIM
+    T_DjiTestDownloadSimConfig simConfig = {0};
 
-    returnCode = DjiCameraManager_ObtainDownloaderRights(position);
+    simConfig.fileSizes = s_downloadSimFileSizes;
+    simConfig.fileCount = sizeof(s_downloadSimFileSizes) / sizeof(s_downloadSimFileSizes[0]);
+    simConfig.commandLatencyMs = TEST_CAMERA_MANAGER_DOWNLOAD_SIM_LATENCY_MS;
+    simConfig.bytesPerSecond = TEST_CAMERA_MANAGER_DOWNLOAD_SIM_BYTES_PER_SECOND;
+    returnCode = DjiTest_DownloadSimInit(&simConfig);
     if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("Obtain downloader rights failed, error code: 0x%08X.", returnCode);
-    }
-
-    sliceConfig.countPerSlice = DJI_CAMERA_MANAGER_FILE_LIST_COUNT_ALL_PER_SLICE;
-    sliceConfig.sliceStartIndex = 0;
-
-    returnCode = DjiCameraManager_DownloadFileListBySlices(position, sliceConfig, &s_meidaFileList);
-    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("Download file list failed, error code: 0x%08X.", returnCode);
+        USER_LOG_ERROR("Init download simulation failed, error code: 0x%08X.", returnCode);
         return returnCode;
     }
+    backend = DjiTest_DownloadSimGetBackend();
+#endif
 
-    if (s_meidaFileList.totalCount > 0) {
-        downloadCount = s_meidaFileList.totalCount;
-        printf(
-            "\033[1;33;40m -> Download file list finished, total file count is %d, the following %d is list details: \033[0m\r\n",
-            s_meidaFileList.totalCount, downloadCount);
-        for (int i = 0; i < downloadCount; ++i) {
-            if (s_meidaFileList.fileListInfo[i].fileSize < 1 * 1024 * 1024) {
-                printf(
-                    "\033[1;32;40m ### Media file_%03d name: %s, index: %d, time:%04d-%02d-%02d_%02d:%02d:%02d, size: %.2f KB, type: %d \033[0m\r\n",
-                    i, s_meidaFileList.fileListInfo[i].fileName,
-                    s_meidaFileList.fileListInfo[i].fileIndex,
-                    s_meidaFileList.fileListInfo[i].createTime.year,
-                    s_meidaFileList.fileListInfo[i].createTime.month,
-                    s_meidaFileList.fileListInfo[i].createTime.day,
-                    s_meidaFileList.fileListInfo[i].createTime.hour,
-                    s_meidaFileList.fileListInfo[i].createTime.minute,
-                    s_meidaFileList.fileListInfo[i].createTime.second,
-                    (dji_f32_t) s_meidaFileList.fileListInfo[i].fileSize / 1024,
-                    s_meidaFileList.fileListInfo[i].type);
-            } else {
-                printf(
-                    "\033[1;32;40m ### Media file_%03d name: %s, index: %d, time:%04d-%02d-%02d_%02d:%02d:%02d, size: %.2f MB, type: %d \033[0m\r\n",
-                    i, s_meidaFileList.fileListInfo[i].fileName,
-                    s_meidaFileList.fileListInfo[i].fileIndex,
-                    s_meidaFileList.fileListInfo[i].createTime.year,
-                    s_meidaFileList.fileListInfo[i].createTime.month,
-                    s_meidaFileList.fileListInfo[i].createTime.day,
-                    s_meidaFileList.fileListInfo[i].createTime.hour,
-                    s_meidaFileList.fileListInfo[i].createTime.minute,
-                    s_meidaFileList.fileListInfo[i].createTime.second,
-                    (dji_f32_t) s_meidaFileList.fileListInfo[i].fileSize / (1024 * 1024),
-                    s_meidaFileList.fileListInfo[i].type);
-            }
-        }
-        printf("\r\n");
-
-        returnCode = DjiCameraManager_DownloadFileByIndex(position, s_meidaFileList.fileListInfo[0].fileIndex);
-        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-            USER_LOG_ERROR("Download media file by index failed, error code: 0x%08X.", returnCode);
-        }
-
-    } else {
-        USER_LOG_WARN("Media file is not existed in sdcard.\r\n");
+    returnCode = DjiTest_DownloadSchedulerInit(backend, 1);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Init download scheduler failed, error code: 0x%08X.", returnCode);
+        goto out;
     }
 
-    returnCode = DjiCameraManager_ReleaseDownloaderRights(position);
+    returnCode = DjiTest_DownloadSchedulerSubmit(request);
     if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("Release downloader rights failed, error code: 0x%08X.", returnCode);
+        USER_LOG_ERROR("Submit download request failed, error code: 0x%08X.", returnCode);
+        DjiTest_DownloadSchedulerDeInit();
+        goto out;
     }
 
-    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
-}
-
-static T_DjiReturnCode DjiTest_CameraManagerDownloadFileDataCallback(T_DjiDownloadFilePacketInfo packetInfo,
-                                                                     const uint8_t *data, uint16_t len)
-{
-    int32_t i =0, j = 0;
-    float downloadSpeed = 0.0f;
-    int32_t mediaFileIndex = 0, mediaSubFileIndex = -1;
-    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
-
-    if (packetInfo.downloadFileEvent == DJI_DOWNLOAD_FILE_EVENT_START) {
-        memset(downloadFileName, 0, sizeof(downloadFileName));
-        if (packetInfo.fileType == DJI_DOWNLOAD_FILE_ORG) {
-            for (i = 0; i < s_meidaFileList.totalCount; ++i) {
-                if (s_meidaFileList.fileListInfo[i].fileIndex == packetInfo.fileIndex) {
-                    snprintf(downloadFileName, sizeof(downloadFileName), "%s", s_meidaFileList.fileListInfo[i].fileName);
-                    mediaFileIndex = i;
-                    s_nextDownloadFileIndex = i + 1;
-                    break;
-                }
-            }
-        } else {
-            for (i = 0; i < s_meidaFileList.totalCount; ++i) {
-                for (j = 0; j < s_meidaFileList.fileListInfo[i].subFileListTotalNum; ++j) {
-                    if (s_meidaFileList.fileListInfo[i].subFileListInfo[j].fileIndex == packetInfo.fileIndex &&
-                        s_meidaFileList.fileListInfo[i].subFileListInfo[j].type == packetInfo.fileType) {
-                        snprintf(downloadFileName, sizeof(downloadFileName), "%s",
-                                 s_meidaFileList.fileListInfo[i].subFileListInfo[j].fileName);
-                        mediaFileIndex = i;
-                        mediaSubFileIndex = j;
-                        break;
-                    }
-                }
-            }
-        }
-
-        osalHandler->GetTimeMs(&downloadStartMs);
-
-        if (mediaSubFileIndex != TEST_CAMEAR_MEDIA_SUB_FILE_NOT_FOUND) {
-            USER_LOG_INFO("Start download media sub file, index : %d, media file, index: %d", mediaSubFileIndex, mediaFileIndex);
-        } else {
-            USER_LOG_INFO("Start download media file, index : %d", mediaFileIndex);
-        }
-
-        s_downloadMediaFile = fopen(downloadFileName, "wb+");
-        if (s_downloadMediaFile == NULL) {
-            return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
-        }
-        fwrite(data, 1, len, s_downloadMediaFile);
-    } else if (packetInfo.downloadFileEvent == DJI_DOWNLOAD_FILE_EVENT_TRANSFER) {
-        if (s_downloadMediaFile != NULL) {
-            fwrite(data, 1, len, s_downloadMediaFile);
-        }
-        printf("\033[1;32;40m ### [Complete rate : %0.1f%%] (%s), size: %u, fileIndex: %d\033[0m\r\n",
-               packetInfo.progressInPercent, downloadFileName, packetInfo.fileSize, packetInfo.fileIndex);
-        printf("\033[1A");
-        USER_LOG_DEBUG("Transfer download media file data, len: %d, percent: %.1f", len, packetInfo.progressInPercent);
-    } else if (packetInfo.downloadFileEvent == DJI_DOWNLOAD_FILE_EVENT_END) {
-        if (s_downloadMediaFile == NULL) {
-            return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
-        }
-
-        fwrite(data, 1, len, s_downloadMediaFile);
-
-        osalHandler->GetTimeMs(&downloadEndMs);
-
-        downloadSpeed = (float) packetInfo.fileSize / (float) (downloadEndMs - downloadStartMs);
-        printf("\033[1;32;40m ### [Complete rate : %0.1f%%] (%s), size: %u, fileIndex: %d\033[0m\r\n",
-               packetInfo.progressInPercent, downloadFileName, packetInfo.fileSize, packetInfo.fileIndex);
-        printf("\033[1A");
-        printf("\r\n");
-        USER_LOG_INFO("End download media file, Download Speed %.2f KB/S\r\n\r\n", downloadSpeed);
-        fclose(s_downloadMediaFile);
-        s_downloadMediaFile = NULL;
-    } else if (packetInfo.downloadFileEvent == DJI_DOWNLOAD_FILE_EVENT_START_TRANSFER_END) {
-
-        memset(downloadFileName, 0, sizeof(downloadFileName));
-        if (packetInfo.fileType == DJI_DOWNLOAD_FILE_ORG) {
-            for (i = 0; i < s_meidaFileList.totalCount; ++i) {
-                if (s_meidaFileList.fileListInfo[i].fileIndex == packetInfo.fileIndex) {
-                    snprintf(downloadFileName, sizeof(downloadFileName), "%s", s_meidaFileList.fileListInfo[i].fileName);
-                    mediaFileIndex = i;
-                    s_nextDownloadFileIndex = i + 1;
-                    break;
-                }
-            }
-        } else {
-            for (i = 0; i < s_meidaFileList.totalCount; ++i) {
-                for (j = 0; j < s_meidaFileList.fileListInfo[i].subFileListTotalNum; ++j) {
-                    if (s_meidaFileList.fileListInfo[i].subFileListInfo[j].fileIndex == packetInfo.fileIndex &&
-                        s_meidaFileList.fileListInfo[i].subFileListInfo[j].type == packetInfo.fileType) {
-                        snprintf(downloadFileName, sizeof(downloadFileName), "%s",
-                                 s_meidaFileList.fileListInfo[i].subFileListInfo[j].fileName);
-                        mediaFileIndex = i;
-                        mediaSubFileIndex = j;
-                        break;
-                    }
-                }
-            }
-        }
+    do {
+        returnCode = DjiTest_DownloadSchedulerWait(request->position, TEST_CAMERA_MANAGER_DOWNLOAD_WAIT_TIME_MS,
+                                                   &result);
+    } while (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_TIMEOUT);
 
-        if (mediaSubFileIndex != TEST_CAMEAR_MEDIA_SUB_FILE_NOT_FOUND) {
-            USER_LOG_INFO("Start download media sub file, index : %d, media file, index: %d", mediaSubFileIndex, mediaFileIndex);
-        } else {
-            USER_LOG_INFO("Start download media file, index : %d", mediaFileIndex);
-        }
-
-        s_downloadMediaFile = fopen(downloadFileName, "wb+");
-        if (s_downloadMediaFile == NULL) {
-            return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
-        }
-        fwrite(data, 1, len, s_downloadMediaFile);
+    USER_LOG_INFO("Download of pos %d finished, listed %u, downloaded %u, failed %u, deleted %u, retried %u, "
+                  "%.2f MB in %u ms.", request->position, result.listedCount, result.downloadedCount,
+                  result.failedCount, result.deletedCount, result.retryCount,
+                  (dji_f32_t) result.downloadedBytes / (1024 * 1024), result.elapsedMs);
 
-        printf("\033[1;32;40m ### [Complete rate : %0.1f%%] (%s), size: %u, mediaFileIndex: %d\033[0m\r\n",
-               packetInfo.progressInPercent, downloadFileName, packetInfo.fileSize, packetInfo.fileIndex);
-        printf("\033[1A");
+    DjiTest_DownloadSchedulerDeInit();
 
-        downloadSpeed = (float) packetInfo.fileSize / 1.0F;
-        printf("\033[1;32;40m ### [Complete rate : %0.1f%%] (%s), size: %u, mediaFileIndex: %d\033[0m\r\n",
-               packetInfo.progressInPercent, downloadFileName, packetInfo.fileSize, packetInfo.fileIndex);
-        printf("\033[1A");
-        printf("\r\n");
-        USER_LOG_INFO("End download media file, Download Speed %.2f KB/S\r\n\r\n", downloadSpeed);
-        fclose(s_downloadMediaFile);
-        s_downloadMediaFile = NULL;
-    }
+out:
+#if USE_CAMERA_MANAGER_DOWNLOAD_SIM
+    DjiTest_DownloadSimDeInit();
+#endif
 
-    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    return returnCode;
 }
 #endif
 
@@ -2609,17 +2361,16 @@ T_DjiReturnCode DjiTest_CameraManagerSubscribePointCloud(E_DjiMountPosition posi
 {
     T_DjiReturnCode returnCode;
     T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
-    uint8_t recvBuf[TEST_CAMERA_MOP_CHANNEL_SUBSCRIBE_POINT_CLOUD_RECV_BUFFER] = {0};
-    uint8_t colorPointsBuf[TEST_CAMERA_MOP_CHANNEL_COLOR_POINTS_BUFFER] = {0};
+    uint8_t recvBuf[TEST_CAMERA_MOP_CHANNEL_SUBSCRIBE_POINT_CLOUD_RECV_BUFFER];
+    char exportFilePath[TEST_CAMEAR_POINT_CLOUD_FILE_PATH_STR_MAX_SIZE];
     uint32_t realLen;
     uint32_t recvDataCount = 0;
     struct tm *localTime = NULL;
     time_t currentTime = time(NULL);
-    FILE *fp = NULL;
-    size_t size;
+    T_DjiTestPointCloudRecorderHandle recorder = NULL;
+    T_DjiTestPointCloudRecorderStatistics recorderStatistics;
+    T_DjiTestPointCloudReaderStatistics readerStatistics;
     T_DjiCameraManagerColorPointCloud *colorPointCloud;
-    uint32_t colorPointCloudDataByte = 0;
-    uint32_t colorPointsNum = 0;
     static bool isMopInit = false;
     E_DjiChannelAddress mopChannelAddress = 0;
 
@@ -2630,20 +2381,20 @@ T_DjiReturnCode DjiTest_CameraManagerSubscribePointCloud(E_DjiMountPosition posi
     }
 
     localTime = localtime(&currentTime);
-    sprintf(s_pointCloudFilePath, "payload%d_point_cloud_%04d%02d%02d_%02d-%02d-%02d.ldrt",
+    sprintf(s_pointCloudFilePath, "payload%d_point_cloud_%04d%02d%02d_%02d-%02d-%02d.pcr",
             position, localTime->tm_year + 1900, localTime->tm_mon + 1, localTime->tm_mday,
             localTime->tm_hour, localTime->tm_min, localTime->tm_sec);
 
-    fp = fopen(s_pointCloudFilePath, "ab+");
-    if (fp == NULL) {
-        USER_LOG_ERROR("fopen point cloud file failed!\n");
+    returnCode = DjiTest_PointCloudRecorderOpen(s_pointCloudFilePath, position, &recorder);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Open point cloud record failed, stat:0x%08llX.", returnCode);
         return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
     }
 
     if (isMopInit == false) {
         returnCode = DjiMopChannel_Init();
         if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-            fclose(fp);
+            DjiTest_PointCloudRecorderClose(recorder);
             USER_LOG_ERROR("Mop channel init error, stat:0x%08llX.", returnCode);
             return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
         } else {
@@ -2653,7 +2404,7 @@ T_DjiReturnCode DjiTest_CameraManagerSubscribePointCloud(E_DjiMountPosition posi
 
     returnCode = DjiMopChannel_Create(&s_mopChannelHandle, DJI_MOP_CHANNEL_TRANS_UNRELIABLE);
     if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        fclose(fp);
+        DjiTest_PointCloudRecorderClose(recorder);
         USER_LOG_ERROR("Mop channel create send handle error, stat:0x%08llX.", returnCode);
         return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
     }
@@ -2676,8 +2427,6 @@ RECONNECT:
             break;
         }
 
-        memset(recvBuf, 0, TEST_CAMERA_MOP_CHANNEL_SUBSCRIBE_POINT_CLOUD_RECV_BUFFER);
-
         returnCode = DjiMopChannel_RecvData(s_mopChannelHandle, recvBuf,
                                             TEST_CAMERA_MOP_CHANNEL_SUBSCRIBE_POINT_CLOUD_RECV_BUFFER, &realLen);
         if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
@@ -2686,26 +2435,54 @@ RECONNECT:
                 osalHandler->TaskSleepMs(TEST_CAMERA_MOP_CHANNEL_WAIT_TIME_MS);
                 goto RECONNECT;
             }
+            //failed receives use up the count as well, otherwise a broken channel would spin here forever
+            USER_LOG_WARN("Mop channel recv data error, stat:0x%08llX.", returnCode);
+            recvDataCount++;
+            osalHandler->TaskSleepMs(TEST_CAMERA_MOP_CHANNEL_RECV_RETRY_WAIT_MS);
+            continue;
         }
 
-        colorPointCloud = (T_DjiCameraManagerColorPointCloud *) recvBuf;
-        colorPointCloudDataByte = (colorPointCloud->pointCloudHeader).dataByte;
-        colorPointsNum = colorPointCloudDataByte / sizeof(T_DjiCameraManagerPointXYZRGBInfo);
-        memcpy(colorPointsBuf, (uint8_t *)(colorPointCloud->points), colorPointCloudDataByte);
-        USER_LOG_INFO("Mop channel recv data from channel length:%d, count:%d, points num = %d, points byte = %d",
-                      realLen, recvDataCount++, colorPointsNum, colorPointCloudDataByte);
-
-        size = fwrite(colorPointsBuf, 1, colorPointCloudDataByte, fp);
-        if (size != colorPointCloudDataByte) {
-            USER_LOG_ERROR("fwrite point cloud file failed!\n");
-            fclose(fp);
+        //packets of the unreliable channel may be lost or reordered, the recorder frames and checks each of them
+        returnCode = DjiTest_PointCloudRecorderWrite(recorder, recvBuf, realLen);
+        if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER) {
+            USER_LOG_WARN("Drop invalid point cloud packet, length:%d", realLen);
+            recvDataCount++;
+            continue;
+        } else if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            DjiTest_PointCloudRecorderClose(recorder);
             return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
         }
 
-        fflush(fp);
+        colorPointCloud = (T_DjiCameraManagerColorPointCloud *) recvBuf;
+        USER_LOG_DEBUG("Mop channel recv data from channel length:%d, count:%d, seq:%d, points byte = %d",
+                       realLen, recvDataCount, colorPointCloud->pointCloudHeader.seqNum,
+                       colorPointCloud->pointCloudHeader.dataByte);
+        recvDataCount++;
     }
 
-    fclose(fp);
+    DjiTest_PointCloudRecorderGetStatistics(recorder, &recorderStatistics);
+    USER_LOG_INFO("Point cloud record frames:%d, points:%llu, lost:%d in %d gaps, reordered:%d, duplicate:%d, "
+                  "invalid:%d, writer wait:%d",
+                  recorderStatistics.frameCount, recorderStatistics.pointCount, recorderStatistics.lostFrameCount,
+                  recorderStatistics.gapCount, recorderStatistics.reorderedFrameCount,
+                  recorderStatistics.duplicateFrameCount, recorderStatistics.invalidFrameCount,
+                  recorderStatistics.writerWaitCount);
+
+    returnCode = DjiTest_PointCloudRecorderClose(recorder);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Close point cloud record error, stat:0x%08llX.", returnCode);
+    } else {
+        snprintf(exportFilePath, sizeof(exportFilePath), "%.*s.pcd",
+                 (int) (strlen(s_pointCloudFilePath) - strlen(".pcr")), s_pointCloudFilePath);
+        returnCode = DjiTest_PointCloudRecordExport(s_pointCloudFilePath, exportFilePath,
+                                                    DJI_TEST_POINT_CLOUD_EXPORT_FORMAT_PCD, &readerStatistics);
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            USER_LOG_ERROR("Export point cloud record error, stat:0x%08llX.", returnCode);
+        } else {
+            USER_LOG_INFO("Export %llu points of %d frames to %s", readerStatistics.pointCount,
+                          readerStatistics.frameCount, exportFilePath);
+        }
+    }
 
     returnCode = DjiMopChannel_Close(s_mopChannelHandle);
     if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
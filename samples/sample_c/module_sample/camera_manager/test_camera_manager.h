@@ -36,6 +36,8 @@ extern "C" {
 #endif
 
 /* Exported constants --------------------------------------------------------*/
+/* Run the media download samples against the simulated camera of test_camera_manager_download_sim.c. */
+#define USE_CAMERA_MANAGER_DOWNLOAD_SIM 0
 
 /* Exported types ------------------------------------------------------------*/
 typedef enum {
@@ -0,0 +1,574 @@
+/**
+ ********************************************************************
+ * @file    test_camera_manager_download.c
+ * @brief   The file defines the download sink of the camera manager sample. Packets of the media file being
+ *          downloaded are handed to a double-buffered writer task and the file list is looked up by a
+ *          hash map built once per listing, so the download callback does not wait for the disk. Every
+ *          mount position has its own sink, so downloads from several cameras can run in parallel.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#ifdef SYSTEM_ARCH_LINUX
+
+#include "test_camera_manager_download.h"
+#include <stdio.h>
+#include <string.h>
+#include "dji_platform.h"
+#include "dji_logger.h"
+#include "utils/util_async_writer.h"
+#include "utils/util_misc.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define DJI_TEST_DOWNLOAD_SINK_BUFFER_SIZE              (4 * 1024 * 1024)
+#define DJI_TEST_DOWNLOAD_SINK_PROGRESS_INTERVAL_MS     500
+#define DJI_TEST_DOWNLOAD_SINK_FILE_NAME_MAX_SIZE       256
+#define DJI_TEST_DOWNLOAD_SINK_MAP_MIN_CAPACITY         16
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    bool used;
+    uint8_t fileType;
+    uint32_t fileIndex;
+    T_DjiTestDownloadSinkFileLocation location;
+} T_DjiTestDownloadSinkMapSlot;
+
+typedef struct {
+    T_DjiCameraManagerFileList fileList;
+    T_DjiTestDownloadSinkMapSlot *map;
+    uint32_t mapCapacity;
+    T_UtilAsyncWriterHandle writer;
+    char fileName[DJI_TEST_DOWNLOAD_SINK_FILE_NAME_MAX_SIZE];
+    T_DjiTestDownloadSinkFileLocation location;
+    T_DjiReturnCode fileResult;
+    uint32_t startTimeMs;
+    uint32_t lastProgressTimeMs;
+    T_DjiSemaHandle completeSema;
+    T_DjiTestDownloadSinkStatistics statistics;
+} T_DjiTestDownloadSinkContext;
+
+/* Private functions declaration ---------------------------------------------*/
+static T_DjiTestDownloadSinkContext *DjiTest_DownloadSinkGetContext(E_DjiMountPosition position);
+static uint32_t DjiTest_DownloadSinkHash(uint32_t fileIndex, uint8_t fileType);
+static void DjiTest_DownloadSinkMapInsert(T_DjiTestDownloadSinkContext *context, uint32_t fileIndex,
+                                          uint8_t fileType, int32_t mediaFileIndex, int32_t subFileIndex);
+static const T_DjiTestDownloadSinkMapSlot *DjiTest_DownloadSinkMapFind(const T_DjiTestDownloadSinkContext *context,
+                                                                       uint32_t fileIndex, uint8_t fileType);
+static T_DjiReturnCode DjiTest_DownloadSinkOpenFile(T_DjiTestDownloadSinkContext *context,
+                                                    const T_DjiDownloadFilePacketInfo *packetInfo);
+static T_DjiReturnCode DjiTest_DownloadSinkWriteData(T_DjiTestDownloadSinkContext *context,
+                                                     const uint8_t *data, uint16_t len);
+static void DjiTest_DownloadSinkCloseFile(T_DjiTestDownloadSinkContext *context,
+                                          const T_DjiDownloadFilePacketInfo *packetInfo);
+static void DjiTest_DownloadSinkAbortFile(T_DjiTestDownloadSinkContext *context);
+static void DjiTest_DownloadSinkReportProgress(T_DjiTestDownloadSinkContext *context,
+                                               const T_DjiDownloadFilePacketInfo *packetInfo, bool force);
+
+#define DJI_TEST_DOWNLOAD_SINK_CALLBACK_DEFINE(position)                                                    \
+static T_DjiReturnCode DjiTest_DownloadSinkCallback##position(T_DjiDownloadFilePacketInfo packetInfo,       \
+                                                              const uint8_t *data, uint16_t len)            \
+{                                                                                                           \
+    return DjiTest_DownloadSinkHandlePacket((E_DjiMountPosition) position, &packetInfo, data, len);         \
+}
+
+DJI_TEST_DOWNLOAD_SINK_CALLBACK_DEFINE(1)
+DJI_TEST_DOWNLOAD_SINK_CALLBACK_DEFINE(2)
+DJI_TEST_DOWNLOAD_SINK_CALLBACK_DEFINE(3)
+DJI_TEST_DOWNLOAD_SINK_CALLBACK_DEFINE(4)
+DJI_TEST_DOWNLOAD_SINK_CALLBACK_DEFINE(5)
+DJI_TEST_DOWNLOAD_SINK_CALLBACK_DEFINE(6)
+DJI_TEST_DOWNLOAD_SINK_CALLBACK_DEFINE(7)
+DJI_TEST_DOWNLOAD_SINK_CALLBACK_DEFINE(8)
+DJI_TEST_DOWNLOAD_SINK_CALLBACK_DEFINE(9)
+
+/* Private values ------------------------------------------------------------*/
+static const DjiCameraManagerDownloadFileDataCallback s_downloadSinkCallbacks[DJI_TEST_DOWNLOAD_SINK_POSITION_NUM] = {
+    NULL,
+    DjiTest_DownloadSinkCallback1,
+    DjiTest_DownloadSinkCallback2,
+    DjiTest_DownloadSinkCallback3,
+    DjiTest_DownloadSinkCallback4,
+    DjiTest_DownloadSinkCallback5,
+    DjiTest_DownloadSinkCallback6,
+    DjiTest_DownloadSinkCallback7,
+    DjiTest_DownloadSinkCallback8,
+    DjiTest_DownloadSinkCallback9,
+};
+static T_DjiTestDownloadSinkContext s_downloadSinkContexts[DJI_TEST_DOWNLOAD_SINK_POSITION_NUM] = {0};
+static bool s_downloadSinkInited = false;
+
+/* Exported functions definition ---------------------------------------------*/
+T_DjiReturnCode DjiTest_DownloadSinkInit(void)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiReturnCode returnCode;
+    int i;
+
+    if (s_downloadSinkInited) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    memset(s_downloadSinkContexts, 0, sizeof(s_downloadSinkContexts));
+    for (i = 0; i < DJI_TEST_DOWNLOAD_SINK_POSITION_NUM; i++) {
+        s_downloadSinkContexts[i].location.mediaFileIndex = DJI_TEST_DOWNLOAD_SINK_FILE_NOT_FOUND;
+        s_downloadSinkContexts[i].location.subFileIndex = DJI_TEST_DOWNLOAD_SINK_FILE_NOT_FOUND;
+        returnCode = osalHandler->SemaphoreCreate(0, &s_downloadSinkContexts[i].completeSema);
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            USER_LOG_ERROR("Create download sink semaphore failed, error code: 0x%08llX.", returnCode);
+            s_downloadSinkInited = true;
+            DjiTest_DownloadSinkDeInit();
+            return returnCode;
+        }
+    }
+    s_downloadSinkInited = true;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Close the files left open by aborted downloads and release the file index maps.
+ */
+T_DjiReturnCode DjiTest_DownloadSinkDeInit(void)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestDownloadSinkContext *context;
+    int i;
+
+    if (!s_downloadSinkInited) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    for (i = 0; i < DJI_TEST_DOWNLOAD_SINK_POSITION_NUM; i++) {
+        context = &s_downloadSinkContexts[i];
+        DjiTest_DownloadSinkAbortFile(context);
+        if (context->map != NULL) {
+            osalHandler->Free(context->map);
+            context->map = NULL;
+        }
+        if (context->completeSema != NULL) {
+            osalHandler->SemaphoreDestroy(context->completeSema);
+            context->completeSema = NULL;
+        }
+    }
+    s_downloadSinkInited = false;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+DjiCameraManagerDownloadFileDataCallback DjiTest_DownloadSinkGetCallback(E_DjiMountPosition position)
+{
+    if (DjiTest_DownloadSinkGetContext(position) == NULL) {
+        return NULL;
+    }
+
+    return s_downloadSinkCallbacks[position];
+}
+
+/**
+ * @brief Build the file index map of a file list. Call it after every listing and before downloading, the
+ * list must stay valid while its files are downloaded.
+ */
+T_DjiReturnCode DjiTest_DownloadSinkSetFileList(E_DjiMountPosition position,
+                                                const T_DjiCameraManagerFileList *fileList)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestDownloadSinkContext *context = DjiTest_DownloadSinkGetContext(position);
+    const T_DjiCameraManagerFileListInfo *fileInfo;
+    uint32_t entryCount = 0;
+    uint32_t capacity = DJI_TEST_DOWNLOAD_SINK_MAP_MIN_CAPACITY;
+    int32_t i;
+    int32_t j;
+
+    if (context == NULL || fileList == NULL || (fileList->totalCount > 0 && fileList->fileListInfo == NULL)) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    for (i = 0; i < fileList->totalCount; i++) {
+        entryCount += 1 + fileList->fileListInfo[i].subFileListTotalNum;
+    }
+    while (capacity < entryCount * 2) {
+        capacity *= 2;
+    }
+
+    if (capacity != context->mapCapacity) {
+        if (context->map != NULL) {
+            osalHandler->Free(context->map);
+        }
+        context->mapCapacity = 0;
+        context->map = osalHandler->Malloc(capacity * sizeof(T_DjiTestDownloadSinkMapSlot));
+        if (context->map == NULL) {
+            return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+        }
+        context->mapCapacity = capacity;
+    }
+    memset(context->map, 0, capacity * sizeof(T_DjiTestDownloadSinkMapSlot));
+    context->fileList = *fileList;
+
+    for (i = 0; i < fileList->totalCount; i++) {
+        fileInfo = &fileList->fileListInfo[i];
+        DjiTest_DownloadSinkMapInsert(context, fileInfo->fileIndex, DJI_DOWNLOAD_FILE_ORG, i,
+                                      DJI_TEST_DOWNLOAD_SINK_FILE_NOT_FOUND);
+        for (j = 0; j < fileInfo->subFileListTotalNum && fileInfo->subFileListInfo != NULL; j++) {
+            DjiTest_DownloadSinkMapInsert(context, fileInfo->subFileListInfo[j].fileIndex,
+                                          (uint8_t) fileInfo->subFileListInfo[j].type, i, j);
+        }
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Handle one packet of the download file data callback of a mount position. The end of a file is
+ * signaled to DjiTest_DownloadSinkWaitFile.
+ */
+T_DjiReturnCode DjiTest_DownloadSinkHandlePacket(E_DjiMountPosition position,
+                                                 const T_DjiDownloadFilePacketInfo *packetInfo,
+                                                 const uint8_t *data, uint16_t len)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestDownloadSinkContext *context = DjiTest_DownloadSinkGetContext(position);
+    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    uint64_t startTimeUs = 0;
+    uint64_t endTimeUs = 0;
+
+    if (context == NULL || packetInfo == NULL || (data == NULL && len > 0)) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    osalHandler->GetTimeUs(&startTimeUs);
+
+    switch (packetInfo->downloadFileEvent) {
+        case DJI_DOWNLOAD_FILE_EVENT_START:
+            returnCode = DjiTest_DownloadSinkOpenFile(context, packetInfo);
+            if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+                returnCode = DjiTest_DownloadSinkWriteData(context, data, len);
+            }
+            break;
+        case DJI_DOWNLOAD_FILE_EVENT_TRANSFER:
+            returnCode = DjiTest_DownloadSinkWriteData(context, data, len);
+            DjiTest_DownloadSinkReportProgress(context, packetInfo, false);
+            break;
+        case DJI_DOWNLOAD_FILE_EVENT_END:
+            returnCode = DjiTest_DownloadSinkWriteData(context, data, len);
+            DjiTest_DownloadSinkCloseFile(context, packetInfo);
+            break;
+        case DJI_DOWNLOAD_FILE_EVENT_START_TRANSFER_END:
+            returnCode = DjiTest_DownloadSinkOpenFile(context, packetInfo);
+            if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+                returnCode = DjiTest_DownloadSinkWriteData(context, data, len);
+            }
+            DjiTest_DownloadSinkCloseFile(context, packetInfo);
+            break;
+        default:
+            returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+            break;
+    }
+
+    osalHandler->GetTimeUs(&endTimeUs);
+    //read by DjiTest_DownloadSinkWaitFile on the requesting thread to tell an idle download from a slow one
+    __atomic_add_fetch(&context->statistics.packetCount, 1, __ATOMIC_RELAXED);
+    context->statistics.receivedBytes += len;
+    context->statistics.callbackTimeTotalUs += endTimeUs - startTimeUs;
+    context->statistics.callbackTimeMaxUs = USER_UTIL_MAX(context->statistics.callbackTimeMaxUs,
+                                                          endTimeUs - startTimeUs);
+
+    return returnCode;
+}
+
+/**
+ * @brief Close a file left open by an aborted download and drop a completion of a file nobody waited for.
+ * Call it before requesting the next file of the position.
+ */
+void DjiTest_DownloadSinkResetFile(E_DjiMountPosition position)
+{
+    T_DjiTestDownloadSinkContext *context = DjiTest_DownloadSinkGetContext(position);
+
+    if (context == NULL) {
+        return;
+    }
+
+    DjiTest_DownloadSinkAbortFile(context);
+    while (DjiPlatform_GetOsalHandler()->SemaphoreTimedWait(context->completeSema, 0) ==
+           DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+    }
+}
+
+/**
+ * @brief Wait until the file being downloaded on a position has ended. The wait only times out when no
+ * packet arrived for idleTimeoutMs, so large files do not need a size based timeout.
+ */
+T_DjiReturnCode DjiTest_DownloadSinkWaitFile(E_DjiMountPosition position, uint32_t idleTimeoutMs,
+                                             T_DjiTestDownloadSinkFileLocation *location)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestDownloadSinkContext *context = DjiTest_DownloadSinkGetContext(position);
+    uint32_t packetCount;
+    uint32_t receivedCount;
+
+    if (context == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    packetCount = __atomic_load_n(&context->statistics.packetCount, __ATOMIC_RELAXED);
+    while (osalHandler->SemaphoreTimedWait(context->completeSema, idleTimeoutMs) !=
+           DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        receivedCount = __atomic_load_n(&context->statistics.packetCount, __ATOMIC_RELAXED);
+        if (receivedCount == packetCount) {
+            return DJI_ERROR_SYSTEM_MODULE_CODE_TIMEOUT;
+        }
+        packetCount = receivedCount;
+    }
+
+    if (location != NULL) {
+        *location = context->location;
+    }
+
+    return context->fileResult;
+}
+
+void DjiTest_DownloadSinkGetStatistics(E_DjiMountPosition position, T_DjiTestDownloadSinkStatistics *statistics)
+{
+    T_DjiTestDownloadSinkContext *context = DjiTest_DownloadSinkGetContext(position);
+
+    if (context == NULL || statistics == NULL) {
+        return;
+    }
+
+    *statistics = context->statistics;
+}
+
+/* Private functions definition-----------------------------------------------*/
+static T_DjiTestDownloadSinkContext *DjiTest_DownloadSinkGetContext(E_DjiMountPosition position)
+{
+    if (!s_downloadSinkInited || position <= DJI_MOUNT_POSITION_UNKNOWN ||
+        position >= DJI_TEST_DOWNLOAD_SINK_POSITION_NUM) {
+        return NULL;
+    }
+
+    return &s_downloadSinkContexts[position];
+}
+
+static uint32_t DjiTest_DownloadSinkHash(uint32_t fileIndex, uint8_t fileType)
+{
+    uint32_t hash = (fileIndex ^ ((uint32_t) fileType << 24)) * 2654435761U;
+
+    return hash ^ (hash >> 16);
+}
+
+/**
+ * @brief Insert a file into the map, the first entry of a key wins just like a linear search would.
+ */
+static void DjiTest_DownloadSinkMapInsert(T_DjiTestDownloadSinkContext *context, uint32_t fileIndex,
+                                          uint8_t fileType, int32_t mediaFileIndex, int32_t subFileIndex)
+{
+    uint32_t mask = context->mapCapacity - 1;
+    uint32_t slotIndex = DjiTest_DownloadSinkHash(fileIndex, fileType) & mask;
+    T_DjiTestDownloadSinkMapSlot *slot;
+
+    while (context->map[slotIndex].used) {
+        slot = &context->map[slotIndex];
+        if (slot->fileIndex == fileIndex && slot->fileType == fileType) {
+            return;
+        }
+        slotIndex = (slotIndex + 1) & mask;
+    }
+
+    slot = &context->map[slotIndex];
+    slot->used = true;
+    slot->fileIndex = fileIndex;
+    slot->fileType = fileType;
+    slot->location.mediaFileIndex = mediaFileIndex;
+    slot->location.subFileIndex = subFileIndex;
+}
+
+static const T_DjiTestDownloadSinkMapSlot *DjiTest_DownloadSinkMapFind(const T_DjiTestDownloadSinkContext *context,
+                                                                       uint32_t fileIndex, uint8_t fileType)
+{
+    uint32_t mask = context->mapCapacity - 1;
+    uint32_t slotIndex;
+
+    if (context->map == NULL) {
+        return NULL;
+    }
+
+    slotIndex = DjiTest_DownloadSinkHash(fileIndex, fileType) & mask;
+    while (context->map[slotIndex].used) {
+        if (context->map[slotIndex].fileIndex == fileIndex && context->map[slotIndex].fileType == fileType) {
+            return &context->map[slotIndex];
+        }
+        slotIndex = (slotIndex + 1) & mask;
+    }
+
+    return NULL;
+}
+
+static T_DjiReturnCode DjiTest_DownloadSinkOpenFile(T_DjiTestDownloadSinkContext *context,
+                                                    const T_DjiDownloadFilePacketInfo *packetInfo)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    const T_DjiTestDownloadSinkMapSlot *slot;
+    const T_DjiCameraManagerFileListInfo *fileInfo;
+    T_UtilAsyncWriterConfig writerConfig;
+    T_DjiReturnCode returnCode;
+
+    DjiTest_DownloadSinkAbortFile(context);
+    context->fileResult = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    context->location.mediaFileIndex = DJI_TEST_DOWNLOAD_SINK_FILE_NOT_FOUND;
+    context->location.subFileIndex = DJI_TEST_DOWNLOAD_SINK_FILE_NOT_FOUND;
+
+    slot = DjiTest_DownloadSinkMapFind(context, packetInfo->fileIndex, packetInfo->fileType);
+    if (slot == NULL) {
+        USER_LOG_ERROR("File of index %u and type %d is not in the file list.", packetInfo->fileIndex,
+                       packetInfo->fileType);
+        context->fileResult = DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+        return context->fileResult;
+    }
+
+    context->location = slot->location;
+    fileInfo = &context->fileList.fileListInfo[slot->location.mediaFileIndex];
+    if (slot->location.subFileIndex != DJI_TEST_DOWNLOAD_SINK_FILE_NOT_FOUND) {
+        snprintf(context->fileName, sizeof(context->fileName), "%s",
+                 fileInfo->subFileListInfo[slot->location.subFileIndex].fileName);
+        USER_LOG_INFO("Start download media sub file, index : %d, media file, index: %d",
+                      slot->location.subFileIndex, slot->location.mediaFileIndex);
+    } else {
+        snprintf(context->fileName, sizeof(context->fileName), "%s", fileInfo->fileName);
+        USER_LOG_INFO("Start download media file, index : %d", slot->location.mediaFileIndex);
+    }
+
+    //the size is known from the packet, so the file is allocated once instead of growing with every write
+    UtilAsyncWriter_GetDefaultConfig(&writerConfig);
+    writerConfig.bufferSize = DJI_TEST_DOWNLOAD_SINK_BUFFER_SIZE;
+    writerConfig.fsyncIntervalMs = 0;
+    writerConfig.preallocateSize = packetInfo->fileSize;
+
+    returnCode = UtilAsyncWriter_Open(context->fileName, &writerConfig, &context->writer);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Open download file %s failed, error code: 0x%08llX.", context->fileName, returnCode);
+        context->writer = NULL;
+        context->fileResult = returnCode;
+        return returnCode;
+    }
+
+    osalHandler->GetTimeMs(&context->startTimeMs);
+    context->lastProgressTimeMs = context->startTimeMs;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+static T_DjiReturnCode DjiTest_DownloadSinkWriteData(T_DjiTestDownloadSinkContext *context,
+                                                     const uint8_t *data, uint16_t len)
+{
+    T_DjiReturnCode returnCode;
+
+    if (context->writer == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    returnCode = UtilAsyncWriter_Write(context->writer, data, len);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Write download file %s failed, error code: 0x%08llX.", context->fileName, returnCode);
+        UtilAsyncWriter_Close(context->writer);
+        context->writer = NULL;
+        context->fileResult = returnCode;
+    }
+
+    return returnCode;
+}
+
+/**
+ * @brief Finish the current file and wake up the waiter, also when the file failed on the way.
+ */
+static void DjiTest_DownloadSinkCloseFile(T_DjiTestDownloadSinkContext *context,
+                                          const T_DjiDownloadFilePacketInfo *packetInfo)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_UtilAsyncWriterStatistics writerStatistics = {0};
+    T_DjiReturnCode returnCode;
+    uint32_t endTimeMs = 0;
+    dji_f32_t downloadSpeed;
+
+    if (context->writer != NULL) {
+        UtilAsyncWriter_GetStatistics(context->writer, &writerStatistics);
+        returnCode = UtilAsyncWriter_Close(context->writer);
+        context->writer = NULL;
+        context->statistics.writerWaitCount += writerStatistics.producerWaitCount;
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            USER_LOG_ERROR("Close download file %s failed, error code: 0x%08llX.", context->fileName, returnCode);
+            context->fileResult = returnCode;
+        }
+    } else if (context->fileResult == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        context->fileResult = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    if (context->fileResult == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        context->statistics.fileCount++;
+
+        osalHandler->GetTimeMs(&endTimeMs);
+        downloadSpeed = (dji_f32_t) packetInfo->fileSize /
+                        (dji_f32_t) USER_UTIL_MAX(endTimeMs - context->startTimeMs, 1);
+
+        DjiTest_DownloadSinkReportProgress(context, packetInfo, true);
+        printf("\r\n");
+        USER_LOG_INFO("End download media file, Download Speed %.2f KB/S, writer wait count %u, "
+                      "callback max time %llu us\r\n\r\n", downloadSpeed, writerStatistics.producerWaitCount,
+                      context->statistics.callbackTimeMaxUs);
+    } else {
+        context->statistics.fileFailCount++;
+    }
+
+    osalHandler->SemaphorePost(context->completeSema);
+}
+
+static void DjiTest_DownloadSinkAbortFile(T_DjiTestDownloadSinkContext *context)
+{
+    if (context->writer == NULL) {
+        return;
+    }
+
+    USER_LOG_WARN("Download of %s is not finished, close it.", context->fileName);
+    UtilAsyncWriter_Close(context->writer);
+    context->writer = NULL;
+    context->statistics.fileFailCount++;
+}
+
+/**
+ * @brief Print the progress line at most once per DJI_TEST_DOWNLOAD_SINK_PROGRESS_INTERVAL_MS, a terminal
+ * write per packet costs more than the packet itself.
+ */
+static void DjiTest_DownloadSinkReportProgress(T_DjiTestDownloadSinkContext *context,
+                                               const T_DjiDownloadFilePacketInfo *packetInfo, bool force)
+{
+    uint32_t currentTimeMs = 0;
+
+    DjiPlatform_GetOsalHandler()->GetTimeMs(&currentTimeMs);
+    if (!force && currentTimeMs - context->lastProgressTimeMs < DJI_TEST_DOWNLOAD_SINK_PROGRESS_INTERVAL_MS) {
+        return;
+    }
+    context->lastProgressTimeMs = currentTimeMs;
+
+    printf("\033[1;32;40m ### [Complete rate : %0.1f%%] (%s), size: %u, fileIndex: %d\033[0m\r\n",
+           packetInfo->progressInPercent, context->fileName, packetInfo->fileSize, packetInfo->fileIndex);
+    printf("\033[1A");
+}
+
+#endif
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
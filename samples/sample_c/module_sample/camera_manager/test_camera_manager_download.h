@@ -0,0 +1,83 @@
+/**
+ ********************************************************************
+ * @file    test_camera_manager_download.h
+ * @brief   This is the header file for "test_camera_manager_download.c", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef TEST_CAMERA_MANAGER_DOWNLOAD_H
+#define TEST_CAMERA_MANAGER_DOWNLOAD_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_typedef.h"
+#include "dji_camera_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef SYSTEM_ARCH_LINUX
+
+/* Exported constants --------------------------------------------------------*/
+#define DJI_TEST_DOWNLOAD_SINK_FILE_NOT_FOUND           (-1)
+#define DJI_TEST_DOWNLOAD_SINK_POSITION_NUM             (DJI_MOUNT_POSITION_EXTENSION_LITE_PORT + 1)
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+    /*! Index of the media file in the file list, DJI_TEST_DOWNLOAD_SINK_FILE_NOT_FOUND if unknown. */
+    int32_t mediaFileIndex;
+    /*! Index of the sub file in the media file, DJI_TEST_DOWNLOAD_SINK_FILE_NOT_FOUND for origin files. */
+    int32_t subFileIndex;
+} T_DjiTestDownloadSinkFileLocation;
+
+typedef struct {
+    uint32_t fileCount;
+    uint32_t fileFailCount;
+    uint32_t packetCount;
+    uint64_t receivedBytes;
+    uint32_t writerWaitCount;
+    uint64_t callbackTimeTotalUs;
+    uint64_t callbackTimeMaxUs;
+} T_DjiTestDownloadSinkStatistics;
+
+/* Exported functions --------------------------------------------------------*/
+T_DjiReturnCode DjiTest_DownloadSinkInit(void);
+T_DjiReturnCode DjiTest_DownloadSinkDeInit(void);
+DjiCameraManagerDownloadFileDataCallback DjiTest_DownloadSinkGetCallback(E_DjiMountPosition position);
+T_DjiReturnCode DjiTest_DownloadSinkSetFileList(E_DjiMountPosition position,
+                                                const T_DjiCameraManagerFileList *fileList);
+T_DjiReturnCode DjiTest_DownloadSinkHandlePacket(E_DjiMountPosition position,
+                                                 const T_DjiDownloadFilePacketInfo *packetInfo,
+                                                 const uint8_t *data, uint16_t len);
+void DjiTest_DownloadSinkResetFile(E_DjiMountPosition position);
+T_DjiReturnCode DjiTest_DownloadSinkWaitFile(E_DjiMountPosition position, uint32_t idleTimeoutMs,
+                                             T_DjiTestDownloadSinkFileLocation *location);
+void DjiTest_DownloadSinkGetStatistics(E_DjiMountPosition position, T_DjiTestDownloadSinkStatistics *statistics);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TEST_CAMERA_MANAGER_DOWNLOAD_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
@@ -0,0 +1,740 @@
+/**
+ ********************************************************************
+ * @file    test_camera_manager_download_scheduler.c
+ * @brief   The file defines the download scheduler of the camera manager sample. Download requests of
+ *          several mount positions are run by a bounded set of workers, the next slice of a file list
+ *          is fetched while the current one is downloaded, and every download waits for the end of its
+ *          file signaled by the download sink instead of sleeping.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#ifdef SYSTEM_ARCH_LINUX
+
+#include "test_camera_manager_download_scheduler.h"
+#include <stdio.h>
+#include <string.h>
+#include "test_camera_manager_download.h"
+#include "dji_platform.h"
+#include "dji_logger.h"
+#include "utils/util_misc.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define DJI_TEST_DOWNLOAD_SCHEDULER_TASK_STACK_SIZE     2048
+/* Slices in flight per worker, one being downloaded and one prefetched. */
+#define DJI_TEST_DOWNLOAD_SCHEDULER_SLICE_NUM           2
+#define DJI_TEST_DOWNLOAD_SCHEDULER_RETRY_MAX           3
+/* A download is given up when no packet arrived for this long. */
+#define DJI_TEST_DOWNLOAD_SCHEDULER_IDLE_TIMEOUT_MS     10000
+
+/* Private types -------------------------------------------------------------*/
+typedef enum {
+    DJI_TEST_DOWNLOAD_JOB_STATE_IDLE = 0,
+    DJI_TEST_DOWNLOAD_JOB_STATE_QUEUED,
+    DJI_TEST_DOWNLOAD_JOB_STATE_RUNNING,
+    DJI_TEST_DOWNLOAD_JOB_STATE_DONE,
+} E_DjiTestDownloadJobState;
+
+typedef struct {
+    E_DjiTestDownloadJobState state;
+    T_DjiTestDownloadRequest request;
+    T_DjiTestDownloadResult result;
+    T_DjiSemaHandle doneSema;
+    /*! Number of files of deleteFileIndexes, only downloaded JPEG and MP4 files are deleted. */
+    uint16_t deleteFileCount;
+} T_DjiTestDownloadJob;
+
+typedef struct {
+    /*! Deep copy of a slice, the camera manager reuses its list buffer for the next fetch. */
+    T_DjiCameraManagerFileList fileList;
+    T_DjiReturnCode returnCode;
+    bool last;
+} T_DjiTestDownloadSlice;
+
+typedef struct {
+    T_DjiTaskHandle workerTask;
+    T_DjiTaskHandle fetchTask;
+    T_DjiSemaHandle fetchStartSema;
+    T_DjiSemaHandle sliceFreeSema;
+    T_DjiSemaHandle sliceFullSema;
+    T_DjiTestDownloadSlice slices[DJI_TEST_DOWNLOAD_SCHEDULER_SLICE_NUM];
+    uint8_t sliceReadIndex;
+    uint8_t sliceWriteIndex;
+    E_DjiMountPosition fetchPosition;
+    E_DjiCameraManagerFileListCountPerSlice fetchCountPerSlice;
+    volatile bool fetchCancel;
+} T_DjiTestDownloadWorker;
+
+/* Private functions declaration ---------------------------------------------*/
+static void *DjiTest_DownloadSchedulerWorkerTask(void *arg);
+static void *DjiTest_DownloadSchedulerFetchTask(void *arg);
+static void DjiTest_DownloadSchedulerRunJob(T_DjiTestDownloadWorker *worker, T_DjiTestDownloadJob *job);
+static void DjiTest_DownloadSchedulerDownloadSlice(T_DjiTestDownloadJob *job, const T_DjiTestDownloadSlice *slice,
+                                                   uint32_t *deleteFileIndexes);
+static T_DjiReturnCode DjiTest_DownloadSchedulerDownloadFile(T_DjiTestDownloadJob *job, uint32_t fileIndex,
+                                                             uint8_t fileType);
+static T_DjiReturnCode DjiTest_DownloadSchedulerCopyFileList(const T_DjiCameraManagerFileList *fileList,
+                                                             T_DjiCameraManagerFileList *copy);
+static void DjiTest_DownloadSchedulerPrintFileList(const T_DjiCameraManagerFileList *fileList,
+                                                   uint32_t startIndex);
+static void DjiTest_DownloadSchedulerDestroyWorker(T_DjiTestDownloadWorker *worker);
+
+/* Private values ------------------------------------------------------------*/
+static const T_DjiTestDownloadBackend s_cameraManagerBackend = {
+    .ObtainDownloaderRights = DjiCameraManager_ObtainDownloaderRights,
+    .ReleaseDownloaderRights = DjiCameraManager_ReleaseDownloaderRights,
+    .RegDownloadFileDataCallback = DjiCameraManager_RegDownloadFileDataCallback,
+    .DownloadFileListBySlices = DjiCameraManager_DownloadFileListBySlices,
+    .DownloadFileByIndex = DjiCameraManager_DownloadFileByIndex,
+    .DownloadSubFileByIndexAndSubType = DjiCameraManager_DownloadSubFileByIndexAndSubType,
+    .DeleteFileByIndex = DjiCameraManager_DeleteFileByIndex,
+};
+
+static T_DjiTestDownloadBackend s_downloadBackend;
+static T_DjiTestDownloadWorker s_downloadWorkers[DJI_TEST_DOWNLOAD_SCHEDULER_PARALLEL_MAX];
+static uint8_t s_downloadWorkerCount = 0;
+static T_DjiTestDownloadJob s_downloadJobs[DJI_TEST_DOWNLOAD_SINK_POSITION_NUM];
+static E_DjiMountPosition s_downloadQueue[DJI_TEST_DOWNLOAD_SINK_POSITION_NUM];
+static uint8_t s_downloadQueueHead = 0;
+static uint8_t s_downloadQueueCount = 0;
+static T_DjiMutexHandle s_downloadQueueMutex = NULL;
+static T_DjiSemaHandle s_downloadQueueSema = NULL;
+static T_DjiSemaHandle s_downloadExitSema = NULL;
+static volatile bool s_downloadSchedulerStop = false;
+static bool s_downloadSchedulerInited = false;
+
+/* Exported functions definition ---------------------------------------------*/
+/**
+ * @brief Start parallelCount workers, each one runs the requests of one mount position at a time.
+ */
+T_DjiReturnCode DjiTest_DownloadSchedulerInit(const T_DjiTestDownloadBackend *backend, uint8_t parallelCount)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestDownloadWorker *worker;
+    T_DjiReturnCode returnCode;
+    int i;
+
+    if (s_downloadSchedulerInited) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    if (parallelCount == 0 || parallelCount > DJI_TEST_DOWNLOAD_SCHEDULER_PARALLEL_MAX) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    returnCode = DjiTest_DownloadSinkInit();
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return returnCode;
+    }
+
+    s_downloadBackend = backend != NULL ? *backend : s_cameraManagerBackend;
+    s_downloadSchedulerStop = false;
+    s_downloadQueueHead = 0;
+    s_downloadQueueCount = 0;
+    s_downloadWorkerCount = 0;
+    memset(s_downloadJobs, 0, sizeof(s_downloadJobs));
+    memset(s_downloadWorkers, 0, sizeof(s_downloadWorkers));
+    s_downloadSchedulerInited = true;
+
+    if (osalHandler->MutexCreate(&s_downloadQueueMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS ||
+        osalHandler->SemaphoreCreate(0, &s_downloadQueueSema) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS ||
+        osalHandler->SemaphoreCreate(0, &s_downloadExitSema) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Create download scheduler lock failed.");
+        DjiTest_DownloadSchedulerDeInit();
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    for (i = 0; i < DJI_TEST_DOWNLOAD_SINK_POSITION_NUM; i++) {
+        if (osalHandler->SemaphoreCreate(0, &s_downloadJobs[i].doneSema) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            USER_LOG_ERROR("Create download job semaphore failed.");
+            DjiTest_DownloadSchedulerDeInit();
+            return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        }
+    }
+
+    for (i = 0; i < parallelCount; i++) {
+        worker = &s_downloadWorkers[i];
+        if (osalHandler->SemaphoreCreate(0, &worker->fetchStartSema) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS ||
+            osalHandler->SemaphoreCreate(DJI_TEST_DOWNLOAD_SCHEDULER_SLICE_NUM, &worker->sliceFreeSema) !=
+            DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS ||
+            osalHandler->SemaphoreCreate(0, &worker->sliceFullSema) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            USER_LOG_ERROR("Create download worker semaphore failed.");
+            s_downloadWorkerCount = (uint8_t) (i + 1);
+            DjiTest_DownloadSchedulerDeInit();
+            return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        }
+
+        s_downloadWorkerCount = (uint8_t) (i + 1);
+        returnCode = osalHandler->TaskCreate("download_fetch", DjiTest_DownloadSchedulerFetchTask,
+                                             DJI_TEST_DOWNLOAD_SCHEDULER_TASK_STACK_SIZE, worker, &worker->fetchTask);
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            worker->fetchTask = NULL;
+            USER_LOG_ERROR("Create download fetch task failed, error code: 0x%08llX.", returnCode);
+            DjiTest_DownloadSchedulerDeInit();
+            return returnCode;
+        }
+
+        returnCode = osalHandler->TaskCreate("download_worker", DjiTest_DownloadSchedulerWorkerTask,
+                                             DJI_TEST_DOWNLOAD_SCHEDULER_TASK_STACK_SIZE, worker, &worker->workerTask);
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            worker->workerTask = NULL;
+            USER_LOG_ERROR("Create download worker task failed, error code: 0x%08llX.", returnCode);
+            DjiTest_DownloadSchedulerDeInit();
+            return returnCode;
+        }
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Stop the workers. Requests being run are finished first, queued requests are dropped.
+ */
+T_DjiReturnCode DjiTest_DownloadSchedulerDeInit(void)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    int exitCount = 0;
+    int i;
+
+    if (!s_downloadSchedulerInited) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    //workers take any wake up of the queue, so all of them are stopped before their fetch tasks
+    s_downloadSchedulerStop = true;
+    for (i = 0; i < s_downloadWorkerCount; i++) {
+        if (s_downloadWorkers[i].workerTask != NULL) {
+            osalHandler->SemaphorePost(s_downloadQueueSema);
+            exitCount++;
+        }
+    }
+    for (i = 0; i < exitCount; i++) {
+        osalHandler->SemaphoreWait(s_downloadExitSema);
+    }
+    for (i = 0; i < s_downloadWorkerCount; i++) {
+        DjiTest_DownloadSchedulerDestroyWorker(&s_downloadWorkers[i]);
+    }
+    s_downloadWorkerCount = 0;
+
+    for (i = 0; i < DJI_TEST_DOWNLOAD_SINK_POSITION_NUM; i++) {
+        if (s_downloadJobs[i].doneSema != NULL) {
+            osalHandler->SemaphoreDestroy(s_downloadJobs[i].doneSema);
+            s_downloadJobs[i].doneSema = NULL;
+        }
+    }
+    if (s_downloadExitSema != NULL) {
+        osalHandler->SemaphoreDestroy(s_downloadExitSema);
+        s_downloadExitSema = NULL;
+    }
+    if (s_downloadQueueSema != NULL) {
+        osalHandler->SemaphoreDestroy(s_downloadQueueSema);
+        s_downloadQueueSema = NULL;
+    }
+    if (s_downloadQueueMutex != NULL) {
+        osalHandler->MutexDestroy(s_downloadQueueMutex);
+        s_downloadQueueMutex = NULL;
+    }
+
+    s_downloadSchedulerInited = false;
+
+    return DjiTest_DownloadSinkDeInit();
+}
+
+/**
+ * @brief Queue a request. A mount position runs one request at a time, a position with a request that is
+ * queued or running is busy.
+ */
+T_DjiReturnCode DjiTest_DownloadSchedulerSubmit(const T_DjiTestDownloadRequest *request)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestDownloadJob *job;
+
+    if (!s_downloadSchedulerInited || request == NULL || request->position <= DJI_MOUNT_POSITION_UNKNOWN ||
+        request->position >= DJI_TEST_DOWNLOAD_SINK_POSITION_NUM || request->countPerSlice == 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    job = &s_downloadJobs[request->position];
+
+    osalHandler->MutexLock(s_downloadQueueMutex);
+    if (job->state == DJI_TEST_DOWNLOAD_JOB_STATE_QUEUED || job->state == DJI_TEST_DOWNLOAD_JOB_STATE_RUNNING) {
+        osalHandler->MutexUnlock(s_downloadQueueMutex);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+    }
+
+    //drop the completion of a previous request nobody waited for
+    while (osalHandler->SemaphoreTimedWait(job->doneSema, 0) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+    }
+
+    job->request = *request;
+    memset(&job->result, 0, sizeof(job->result));
+    job->state = DJI_TEST_DOWNLOAD_JOB_STATE_QUEUED;
+    s_downloadQueue[(s_downloadQueueHead + s_downloadQueueCount) % DJI_TEST_DOWNLOAD_SINK_POSITION_NUM] =
+        request->position;
+    s_downloadQueueCount++;
+    osalHandler->MutexUnlock(s_downloadQueueMutex);
+
+    osalHandler->SemaphorePost(s_downloadQueueSema);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Wait for the request of a mount position to finish.
+ */
+T_DjiReturnCode DjiTest_DownloadSchedulerWait(E_DjiMountPosition position, uint32_t timeoutMs,
+                                              T_DjiTestDownloadResult *result)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestDownloadJob *job;
+    T_DjiReturnCode returnCode;
+
+    if (!s_downloadSchedulerInited || position <= DJI_MOUNT_POSITION_UNKNOWN ||
+        position >= DJI_TEST_DOWNLOAD_SINK_POSITION_NUM) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    job = &s_downloadJobs[position];
+    if (job->state == DJI_TEST_DOWNLOAD_JOB_STATE_IDLE) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+    }
+
+    returnCode = osalHandler->SemaphoreTimedWait(job->doneSema, timeoutMs);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_TIMEOUT;
+    }
+
+    osalHandler->MutexLock(s_downloadQueueMutex);
+    if (result != NULL) {
+        *result = job->result;
+    }
+    job->state = DJI_TEST_DOWNLOAD_JOB_STATE_IDLE;
+    osalHandler->MutexUnlock(s_downloadQueueMutex);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/* Private functions definition-----------------------------------------------*/
+static void *DjiTest_DownloadSchedulerWorkerTask(void *arg)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestDownloadWorker *worker = (T_DjiTestDownloadWorker *) arg;
+    T_DjiTestDownloadJob *job;
+    E_DjiMountPosition position;
+
+    while (true) {
+        osalHandler->SemaphoreWait(s_downloadQueueSema);
+        if (s_downloadSchedulerStop) {
+            break;
+        }
+
+        osalHandler->MutexLock(s_downloadQueueMutex);
+        if (s_downloadQueueCount == 0) {
+            osalHandler->MutexUnlock(s_downloadQueueMutex);
+            continue;
+        }
+        position = s_downloadQueue[s_downloadQueueHead];
+        s_downloadQueueHead = (uint8_t) ((s_downloadQueueHead + 1) % DJI_TEST_DOWNLOAD_SINK_POSITION_NUM);
+        s_downloadQueueCount--;
+        job = &s_downloadJobs[position];
+        job->state = DJI_TEST_DOWNLOAD_JOB_STATE_RUNNING;
+        osalHandler->MutexUnlock(s_downloadQueueMutex);
+
+        DjiTest_DownloadSchedulerRunJob(worker, job);
+
+        osalHandler->MutexLock(s_downloadQueueMutex);
+        job->state = DJI_TEST_DOWNLOAD_JOB_STATE_DONE;
+        osalHandler->MutexUnlock(s_downloadQueueMutex);
+        osalHandler->SemaphorePost(job->doneSema);
+    }
+
+    osalHandler->SemaphorePost(s_downloadExitSema);
+
+    return NULL;
+}
+
+/**
+ * @brief Fetch the slices of the file list of the running request ahead of the worker. The fetch blocks
+ * when DJI_TEST_DOWNLOAD_SCHEDULER_SLICE_NUM slices are waiting, and ends with a slice marked as last.
+ */
+static void *DjiTest_DownloadSchedulerFetchTask(void *arg)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestDownloadWorker *worker = (T_DjiTestDownloadWorker *) arg;
+    T_DjiCameraManagerSliceConfig sliceConfig;
+    T_DjiCameraManagerFileList fileList;
+    T_DjiTestDownloadSlice *slice;
+    T_DjiReturnCode returnCode;
+    int retry;
+
+    while (true) {
+        osalHandler->SemaphoreWait(worker->fetchStartSema);
+        if (s_downloadSchedulerStop) {
+            break;
+        }
+
+        sliceConfig.sliceStartIndex = 0;
+        sliceConfig.countPerSlice = worker->fetchCountPerSlice;
+        do {
+            osalHandler->SemaphoreWait(worker->sliceFreeSema);
+            slice = &worker->slices[worker->sliceWriteIndex];
+            memset(slice, 0, sizeof(T_DjiTestDownloadSlice));
+            slice->last = true;
+
+            if (!worker->fetchCancel) {
+                returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+                for (retry = 0; retry <= DJI_TEST_DOWNLOAD_SCHEDULER_RETRY_MAX; retry++) {
+                    memset(&fileList, 0, sizeof(fileList));
+                    returnCode = s_downloadBackend.DownloadFileListBySlices(worker->fetchPosition, sliceConfig,
+                                                                            &fileList);
+                    if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+                        break;
+                    }
+                    USER_LOG_WARN("Download file list of slice %d failed, error code: 0x%08llX.",
+                                  sliceConfig.sliceStartIndex, returnCode);
+                }
+
+                if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+                    returnCode = DjiTest_DownloadSchedulerCopyFileList(&fileList, &slice->fileList);
+                }
+                slice->returnCode = returnCode;
+                if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS &&
+                    sliceConfig.countPerSlice != DJI_CAMERA_MANAGER_FILE_LIST_COUNT_ALL_PER_SLICE &&
+                    fileList.totalCount >= sliceConfig.countPerSlice) {
+                    slice->last = false;
+                    sliceConfig.sliceStartIndex += fileList.totalCount;
+                }
+            }
+
+            worker->sliceWriteIndex = (uint8_t) ((worker->sliceWriteIndex + 1) % DJI_TEST_DOWNLOAD_SCHEDULER_SLICE_NUM);
+            osalHandler->SemaphorePost(worker->sliceFullSema);
+        } while (!slice->last);
+    }
+
+    osalHandler->SemaphorePost(s_downloadExitSema);
+
+    return NULL;
+}
+
+static void DjiTest_DownloadSchedulerRunJob(T_DjiTestDownloadWorker *worker, T_DjiTestDownloadJob *job)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    const T_DjiTestDownloadRequest *request = &job->request;
+    T_DjiTestDownloadResult *result = &job->result;
+    T_DjiTestDownloadSlice *slice;
+    T_DjiReturnCode returnCode;
+    uint32_t *deleteFileIndexes = NULL;
+    uint32_t listStartIndex = 0;
+    uint32_t startTimeMs = 0;
+    uint32_t endTimeMs = 0;
+    uint32_t i;
+    bool last = false;
+
+    osalHandler->GetTimeMs(&startTimeMs);
+    job->deleteFileCount = 0;
+
+    returnCode = s_downloadBackend.RegDownloadFileDataCallback(request->position,
+                                                               DjiTest_DownloadSinkGetCallback(request->position));
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Register download file data callback failed, error code: 0x%08llX.", returnCode);
+        result->returnCode = returnCode;
+        return;
+    }
+
+    USER_LOG_INFO("obtain downloader rights of pos %d", request->position);
+    returnCode = s_downloadBackend.ObtainDownloaderRights(request->position);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Obtain downloader rights failed, error code: 0x%08llX.", returnCode);
+        result->returnCode = returnCode;
+        return;
+    }
+
+    if (request->deleteCount > 0) {
+        deleteFileIndexes = osalHandler->Malloc(request->deleteCount * sizeof(uint32_t));
+        if (deleteFileIndexes == NULL) {
+            result->returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+            goto ReleaseDownloaderRights;
+        }
+    }
+
+    worker->fetchPosition = request->position;
+    worker->fetchCountPerSlice = request->countPerSlice;
+    worker->fetchCancel = false;
+    osalHandler->SemaphorePost(worker->fetchStartSema);
+
+    while (!last) {
+        osalHandler->SemaphoreWait(worker->sliceFullSema);
+        slice = &worker->slices[worker->sliceReadIndex];
+        last = slice->last;
+
+        if (slice->returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            USER_LOG_ERROR("Download file list failed, error code: 0x%08llX.", slice->returnCode);
+            result->returnCode = slice->returnCode;
+        } else if (slice->fileList.totalCount > 0) {
+            if (request->printFileList) {
+                DjiTest_DownloadSchedulerPrintFileList(&slice->fileList, listStartIndex);
+            }
+            listStartIndex += slice->fileList.totalCount;
+            result->listedCount += slice->fileList.totalCount;
+            DjiTest_DownloadSchedulerDownloadSlice(job, slice, deleteFileIndexes);
+            if (request->downloadCount > 0 && result->downloadedCount + result->failedCount >= request->downloadCount) {
+                worker->fetchCancel = true;
+            }
+        }
+
+        if (slice->fileList.fileListInfo != NULL) {
+            osalHandler->Free(slice->fileList.fileListInfo);
+            slice->fileList.fileListInfo = NULL;
+        }
+        worker->sliceReadIndex = (uint8_t) ((worker->sliceReadIndex + 1) % DJI_TEST_DOWNLOAD_SCHEDULER_SLICE_NUM);
+        osalHandler->SemaphorePost(worker->sliceFreeSema);
+    }
+
+    if (result->listedCount == 0 && result->returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_WARN("Media file is not existed in sdcard.\r\n");
+    }
+
+    //deleting shifts the list, so it is only done once no more slices are fetched
+    for (i = 0; i < job->deleteFileCount; i++) {
+        USER_LOG_INFO("delete camera file of index %d", deleteFileIndexes[i]);
+        returnCode = s_downloadBackend.DeleteFileByIndex(request->position, deleteFileIndexes[i]);
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            USER_LOG_ERROR("Delete media file by index failed, error code: 0x%08llX.", returnCode);
+            continue;
+        }
+        result->deletedCount++;
+    }
+
+ReleaseDownloaderRights:
+    if (deleteFileIndexes != NULL) {
+        osalHandler->Free(deleteFileIndexes);
+    }
+
+    returnCode = s_downloadBackend.ReleaseDownloaderRights(request->position);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Release downloader rights failed, error code: 0x%08llX.", returnCode);
+    }
+    DjiTest_DownloadSinkResetFile(request->position);
+
+    osalHandler->GetTimeMs(&endTimeMs);
+    result->elapsedMs = endTimeMs - startTimeMs;
+    if (result->returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS && result->failedCount > 0) {
+        result->returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+}
+
+/**
+ * @brief Download the files of a slice, with the sub files of LDRT files.
+ */
+static void DjiTest_DownloadSchedulerDownloadSlice(T_DjiTestDownloadJob *job, const T_DjiTestDownloadSlice *slice,
+                                                   uint32_t *deleteFileIndexes)
+{
+    const T_DjiTestDownloadRequest *request = &job->request;
+    T_DjiTestDownloadResult *result = &job->result;
+    const T_DjiCameraManagerFileListInfo *fileInfo;
+    T_DjiReturnCode returnCode;
+    uint32_t i;
+    uint32_t j;
+
+    returnCode = DjiTest_DownloadSinkSetFileList(request->position, &slice->fileList);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        result->returnCode = returnCode;
+        return;
+    }
+
+    for (i = 0; i < slice->fileList.totalCount; i++) {
+        if (request->downloadCount > 0 && result->downloadedCount + result->failedCount >= request->downloadCount) {
+            break;
+        }
+
+        fileInfo = &slice->fileList.fileListInfo[i];
+        returnCode = DjiTest_DownloadSchedulerDownloadFile(job, fileInfo->fileIndex, DJI_DOWNLOAD_FILE_ORG);
+        if (fileInfo->type == DJI_CAMERA_FILE_TYPE_LDRT) {
+            for (j = 0; j < fileInfo->subFileListTotalNum && returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+                 j++) {
+                returnCode = DjiTest_DownloadSchedulerDownloadFile(job, fileInfo->fileIndex,
+                                                                   (uint8_t) fileInfo->subFileListInfo[j].type);
+            }
+        }
+
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            result->failedCount++;
+            continue;
+        }
+
+        if ((fileInfo->type == DJI_CAMERA_FILE_TYPE_JPEG || fileInfo->type == DJI_CAMERA_FILE_TYPE_MP4) &&
+            job->deleteFileCount < request->deleteCount) {
+            deleteFileIndexes[job->deleteFileCount++] = fileInfo->fileIndex;
+        }
+        result->downloadedCount++;
+        result->downloadedBytes += fileInfo->fileSize;
+    }
+}
+
+/**
+ * @brief Request a file or a sub file and wait for its end, retrying a bounded number of times.
+ */
+static T_DjiReturnCode DjiTest_DownloadSchedulerDownloadFile(T_DjiTestDownloadJob *job, uint32_t fileIndex,
+                                                             uint8_t fileType)
+{
+    E_DjiMountPosition position = job->request.position;
+    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    int retry;
+
+    for (retry = 0; retry <= DJI_TEST_DOWNLOAD_SCHEDULER_RETRY_MAX; retry++) {
+        if (retry > 0) {
+            job->result.retryCount++;
+        }
+
+        DjiTest_DownloadSinkResetFile(position);
+        if (fileType == DJI_DOWNLOAD_FILE_ORG) {
+            returnCode = s_downloadBackend.DownloadFileByIndex(position, fileIndex);
+        } else {
+            returnCode = s_downloadBackend.DownloadSubFileByIndexAndSubType(position, fileIndex,
+                                                                            (E_DjiCameraMediaFileSubType) fileType);
+        }
+
+        if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            returnCode = DjiTest_DownloadSinkWaitFile(position, DJI_TEST_DOWNLOAD_SCHEDULER_IDLE_TIMEOUT_MS, NULL);
+        }
+        if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            break;
+        }
+
+        USER_LOG_ERROR("Download media file of index %u and type %d failed, error code: 0x%08llX.", fileIndex,
+                       fileType, returnCode);
+    }
+
+    return returnCode;
+}
+
+/**
+ * @brief Copy a file list and its sub file lists into a single allocation.
+ */
+static T_DjiReturnCode DjiTest_DownloadSchedulerCopyFileList(const T_DjiCameraManagerFileList *fileList,
+                                                             T_DjiCameraManagerFileList *copy)
+{
+    T_DjiCameraManagerSubFileListInfo *subFileInfo;
+    uint32_t subFileCount = 0;
+    uint32_t i;
+
+    memset(copy, 0, sizeof(T_DjiCameraManagerFileList));
+    if (fileList->totalCount == 0 || fileList->fileListInfo == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    for (i = 0; i < fileList->totalCount; i++) {
+        if (fileList->fileListInfo[i].subFileListInfo != NULL) {
+            subFileCount += fileList->fileListInfo[i].subFileListTotalNum;
+        }
+    }
+
+    copy->fileListInfo = DjiPlatform_GetOsalHandler()->Malloc(
+        fileList->totalCount * sizeof(T_DjiCameraManagerFileListInfo) +
+        subFileCount * sizeof(T_DjiCameraManagerSubFileListInfo));
+    if (copy->fileListInfo == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+    copy->totalCount = fileList->totalCount;
+    memcpy(copy->fileListInfo, fileList->fileListInfo, fileList->totalCount * sizeof(T_DjiCameraManagerFileListInfo));
+
+    subFileInfo = (T_DjiCameraManagerSubFileListInfo *) (copy->fileListInfo + fileList->totalCount);
+    for (i = 0; i < fileList->totalCount; i++) {
+        if (fileList->fileListInfo[i].subFileListInfo == NULL) {
+            copy->fileListInfo[i].subFileListTotalNum = 0;
+            continue;
+        }
+        memcpy(subFileInfo, fileList->fileListInfo[i].subFileListInfo,
+               fileList->fileListInfo[i].subFileListTotalNum * sizeof(T_DjiCameraManagerSubFileListInfo));
+        copy->fileListInfo[i].subFileListInfo = subFileInfo;
+        subFileInfo += fileList->fileListInfo[i].subFileListTotalNum;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+static void DjiTest_DownloadSchedulerPrintFileList(const T_DjiCameraManagerFileList *fileList,
+                                                   uint32_t startIndex)
+{
+    const T_DjiCameraManagerFileListInfo *fileInfo;
+    const T_DjiCameraManagerSubFileListInfo *subFileInfo;
+    uint32_t i;
+    uint32_t j;
+
+    printf("\033[1;33;40m -> Download file list finished, file count of the slice is %d, "
+           "the following is list details: \033[0m\r\n", fileList->totalCount);
+
+    for (i = 0; i < fileList->totalCount; i++) {
+        fileInfo = &fileList->fileListInfo[i];
+        printf("\033[1;32;40m ### Media file_%03d name: %s, index: %d, time:%04d-%02d-%02d_%02d:%02d:%02d, "
+               "size: %.2f KB, type: %d \033[0m\r\n",
+               startIndex + i, fileInfo->fileName, fileInfo->fileIndex,
+               fileInfo->createTime.year, fileInfo->createTime.month, fileInfo->createTime.day,
+               fileInfo->createTime.hour, fileInfo->createTime.minute, fileInfo->createTime.second,
+               (dji_f32_t) fileInfo->fileSize / 1024, fileInfo->type);
+
+        for (j = 0; j < fileInfo->subFileListTotalNum; j++) {
+            subFileInfo = &fileInfo->subFileListInfo[j];
+            printf("\033[1;32;40m ### Media file_%03d, sub_file_%03d,  name: %s, index: %d, "
+                   "time:%04d-%02d-%02d_%02d:%02d:%02d, size: %.2f KB, sub type: %d\033[0m\r\n",
+                   startIndex + i, j, subFileInfo->fileName, subFileInfo->fileIndex,
+                   subFileInfo->createTime.year, subFileInfo->createTime.month, subFileInfo->createTime.day,
+                   subFileInfo->createTime.hour, subFileInfo->createTime.minute, subFileInfo->createTime.second,
+                   (dji_f32_t) subFileInfo->fileSize / 1024, subFileInfo->type);
+        }
+    }
+    printf("\r\n");
+}
+
+/**
+ * @brief Stop the fetch task of a worker whose worker task is already out and release the worker.
+ */
+static void DjiTest_DownloadSchedulerDestroyWorker(T_DjiTestDownloadWorker *worker)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    if (worker->workerTask != NULL) {
+        osalHandler->TaskDestroy(worker->workerTask);
+        worker->workerTask = NULL;
+    }
+    if (worker->fetchTask != NULL) {
+        osalHandler->SemaphorePost(worker->fetchStartSema);
+        osalHandler->SemaphoreWait(s_downloadExitSema);
+        osalHandler->TaskDestroy(worker->fetchTask);
+        worker->fetchTask = NULL;
+    }
+
+    if (worker->sliceFullSema != NULL) {
+        osalHandler->SemaphoreDestroy(worker->sliceFullSema);
+        worker->sliceFullSema = NULL;
+    }
+    if (worker->sliceFreeSema != NULL) {
+        osalHandler->SemaphoreDestroy(worker->sliceFreeSema);
+        worker->sliceFreeSema = NULL;
+    }
+    if (worker->fetchStartSema != NULL) {
+        osalHandler->SemaphoreDestroy(worker->fetchStartSema);
+        worker->fetchStartSema = NULL;
+    }
+}
+
+#endif
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
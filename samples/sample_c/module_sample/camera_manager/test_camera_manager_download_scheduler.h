@@ -0,0 +1,98 @@
+/**
+ ********************************************************************
+ * @file    test_camera_manager_download_scheduler.h
+ * @brief   This is the header file for "test_camera_manager_download_scheduler.c", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef TEST_CAMERA_MANAGER_DOWNLOAD_SCHEDULER_H
+#define TEST_CAMERA_MANAGER_DOWNLOAD_SCHEDULER_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_typedef.h"
+#include "dji_camera_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef SYSTEM_ARCH_LINUX
+
+/* Exported constants --------------------------------------------------------*/
+#define DJI_TEST_DOWNLOAD_SCHEDULER_PARALLEL_MAX        3
+
+/* Exported types ------------------------------------------------------------*/
+/**
+ * @brief Camera manager calls used by the scheduler, see dji_camera_manager.h. Passing NULL to
+ * DjiTest_DownloadSchedulerInit selects the camera manager itself.
+ */
+typedef struct {
+    T_DjiReturnCode (*ObtainDownloaderRights)(E_DjiMountPosition position);
+    T_DjiReturnCode (*ReleaseDownloaderRights)(E_DjiMountPosition position);
+    T_DjiReturnCode (*RegDownloadFileDataCallback)(E_DjiMountPosition position,
+                                                   DjiCameraManagerDownloadFileDataCallback callback);
+    T_DjiReturnCode (*DownloadFileListBySlices)(E_DjiMountPosition position,
+                                                T_DjiCameraManagerSliceConfig sliceConfig,
+                                                T_DjiCameraManagerFileList *fileList);
+    T_DjiReturnCode (*DownloadFileByIndex)(E_DjiMountPosition position, uint32_t fileIndex);
+    T_DjiReturnCode (*DownloadSubFileByIndexAndSubType)(E_DjiMountPosition position, uint32_t index,
+                                                        E_DjiCameraMediaFileSubType fileType);
+    T_DjiReturnCode (*DeleteFileByIndex)(E_DjiMountPosition position, uint32_t fileIndex);
+} T_DjiTestDownloadBackend;
+
+typedef struct {
+    E_DjiMountPosition position;
+    /*! The next slice of the file list is fetched while the files of the current one are downloaded. */
+    E_DjiCameraManagerFileListCountPerSlice countPerSlice;
+    /*! Number of files downloaded from the start of the list, 0 to download all files. */
+    uint16_t downloadCount;
+    /*! Number of downloaded JPEG and MP4 files deleted from the camera once all downloads of the request finished. */
+    uint16_t deleteCount;
+    bool printFileList;
+} T_DjiTestDownloadRequest;
+
+typedef struct {
+    T_DjiReturnCode returnCode;
+    uint32_t listedCount;
+    uint32_t downloadedCount;
+    uint32_t failedCount;
+    uint32_t deletedCount;
+    uint32_t retryCount;
+    uint64_t downloadedBytes;
+    uint32_t elapsedMs;
+} T_DjiTestDownloadResult;
+
+/* Exported functions --------------------------------------------------------*/
+T_DjiReturnCode DjiTest_DownloadSchedulerInit(const T_DjiTestDownloadBackend *backend, uint8_t parallelCount);
+T_DjiReturnCode DjiTest_DownloadSchedulerDeInit(void);
+T_DjiReturnCode DjiTest_DownloadSchedulerSubmit(const T_DjiTestDownloadRequest *request);
+T_DjiReturnCode DjiTest_DownloadSchedulerWait(E_DjiMountPosition position, uint32_t timeoutMs,
+                                              T_DjiTestDownloadResult *result);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TEST_CAMERA_MANAGER_DOWNLOAD_SCHEDULER_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
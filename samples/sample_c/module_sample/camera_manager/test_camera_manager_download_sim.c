@@ -0,0 +1,383 @@
+/**
+ ********************************************************************
+ * @file    test_camera_manager_download_sim.c
+ * @brief   The file defines a simulated camera manager backend for the download scheduler. It lists and
+ *          sends generated files with a configurable command latency and throughput, so downloads can
+ *          be exercised and timed without a camera.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#ifdef SYSTEM_ARCH_LINUX
+
+#include "test_camera_manager_download_sim.h"
+#include <stdio.h>
+#include <string.h>
+#include "test_camera_manager_download.h"
+#include "dji_platform.h"
+#include "dji_logger.h"
+#include "utils/util_misc.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define DJI_TEST_DOWNLOAD_SIM_PACKET_SIZE               (32 * 1024)
+#define DJI_TEST_DOWNLOAD_SIM_FILE_INDEX_BASE           1
+/* Files from this size on are listed as videos. */
+#define DJI_TEST_DOWNLOAD_SIM_VIDEO_SIZE_MIN            (8 * 1024 * 1024)
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    DjiCameraManagerDownloadFileDataCallback callback;
+    bool rightsObtained;
+    bool *deleted;
+    /*! Returned by the list calls and reused by the next one, like the camera manager does. */
+    T_DjiCameraManagerFileListInfo *listBuffer;
+} T_DjiTestDownloadSimPosition;
+
+/* Private functions declaration ---------------------------------------------*/
+static T_DjiTestDownloadSimPosition *DjiTest_DownloadSimGetPosition(E_DjiMountPosition position);
+static void DjiTest_DownloadSimWaitCommand(void);
+static T_DjiReturnCode DjiTest_DownloadSimObtainDownloaderRights(E_DjiMountPosition position);
+static T_DjiReturnCode DjiTest_DownloadSimReleaseDownloaderRights(E_DjiMountPosition position);
+static T_DjiReturnCode DjiTest_DownloadSimRegDownloadFileDataCallback(E_DjiMountPosition position,
+                                                                      DjiCameraManagerDownloadFileDataCallback callback);
+static T_DjiReturnCode DjiTest_DownloadSimDownloadFileListBySlices(E_DjiMountPosition position,
+                                                                   T_DjiCameraManagerSliceConfig sliceConfig,
+                                                                   T_DjiCameraManagerFileList *fileList);
+static T_DjiReturnCode DjiTest_DownloadSimDownloadFileByIndex(E_DjiMountPosition position, uint32_t fileIndex);
+static T_DjiReturnCode DjiTest_DownloadSimDownloadSubFileByIndexAndSubType(E_DjiMountPosition position,
+                                                                           uint32_t index,
+                                                                           E_DjiCameraMediaFileSubType fileType);
+static T_DjiReturnCode DjiTest_DownloadSimDeleteFileByIndex(E_DjiMountPosition position, uint32_t fileIndex);
+
+/* Private values ------------------------------------------------------------*/
+static const T_DjiTestDownloadBackend s_downloadSimBackend = {
+    .ObtainDownloaderRights = DjiTest_DownloadSimObtainDownloaderRights,
+    .ReleaseDownloaderRights = DjiTest_DownloadSimReleaseDownloaderRights,
+    .RegDownloadFileDataCallback = DjiTest_DownloadSimRegDownloadFileDataCallback,
+    .DownloadFileListBySlices = DjiTest_DownloadSimDownloadFileListBySlices,
+    .DownloadFileByIndex = DjiTest_DownloadSimDownloadFileByIndex,
+    .DownloadSubFileByIndexAndSubType = DjiTest_DownloadSimDownloadSubFileByIndexAndSubType,
+    .DeleteFileByIndex = DjiTest_DownloadSimDeleteFileByIndex,
+};
+
+static T_DjiTestDownloadSimConfig s_downloadSimConfig;
+static T_DjiCameraManagerFileListInfo *s_downloadSimFiles = NULL;
+static T_DjiTestDownloadSimPosition s_downloadSimPositions[DJI_TEST_DOWNLOAD_SINK_POSITION_NUM];
+static uint8_t s_downloadSimPacket[DJI_TEST_DOWNLOAD_SIM_PACKET_SIZE];
+static bool s_downloadSimInited = false;
+
+/* Exported functions definition ---------------------------------------------*/
+T_DjiReturnCode DjiTest_DownloadSimInit(const T_DjiTestDownloadSimConfig *config)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiCameraManagerFileListInfo *fileInfo;
+    T_DjiTestDownloadSimPosition *simPosition;
+    uint32_t i;
+
+    if (config == NULL || (config->fileCount > 0 && config->fileSizes == NULL)) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    if (s_downloadSimInited) {
+        DjiTest_DownloadSimDeInit();
+    }
+
+    s_downloadSimConfig = *config;
+    s_downloadSimConfig.fileSizes = NULL;
+    memset(s_downloadSimPositions, 0, sizeof(s_downloadSimPositions));
+    s_downloadSimInited = true;
+
+    s_downloadSimFiles = osalHandler->Malloc(USER_UTIL_MAX(config->fileCount, 1) *
+                                             sizeof(T_DjiCameraManagerFileListInfo));
+    if (s_downloadSimFiles == NULL) {
+        DjiTest_DownloadSimDeInit();
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+    memset(s_downloadSimFiles, 0, USER_UTIL_MAX(config->fileCount, 1) * sizeof(T_DjiCameraManagerFileListInfo));
+
+    for (i = 0; i < config->fileCount; i++) {
+        fileInfo = &s_downloadSimFiles[i];
+        fileInfo->fileIndex = DJI_TEST_DOWNLOAD_SIM_FILE_INDEX_BASE + i;
+        fileInfo->fileSize = config->fileSizes[i];
+        fileInfo->type = config->fileSizes[i] >= DJI_TEST_DOWNLOAD_SIM_VIDEO_SIZE_MIN ?
+                         DJI_CAMERA_FILE_TYPE_MP4 : DJI_CAMERA_FILE_TYPE_JPEG;
+        fileInfo->createTime.year = 2021;
+        fileInfo->createTime.month = 1;
+        fileInfo->createTime.day = 1;
+        fileInfo->createTime.hour = (uint8_t) (i / 3600 % 24);
+        fileInfo->createTime.minute = (uint8_t) (i / 60 % 60);
+        fileInfo->createTime.second = (uint8_t) (i % 60);
+    }
+
+    for (i = 0; i < DJI_TEST_DOWNLOAD_SINK_POSITION_NUM; i++) {
+        simPosition = &s_downloadSimPositions[i];
+        simPosition->deleted = osalHandler->Malloc(USER_UTIL_MAX(config->fileCount, 1) * sizeof(bool));
+        simPosition->listBuffer = osalHandler->Malloc(USER_UTIL_MAX(config->fileCount, 1) *
+                                                      sizeof(T_DjiCameraManagerFileListInfo));
+        if (simPosition->deleted == NULL || simPosition->listBuffer == NULL) {
+            DjiTest_DownloadSimDeInit();
+            return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+        }
+        memset(simPosition->deleted, 0, USER_UTIL_MAX(config->fileCount, 1) * sizeof(bool));
+    }
+
+    for (i = 0; i < sizeof(s_downloadSimPacket); i++) {
+        s_downloadSimPacket[i] = (uint8_t) i;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiTest_DownloadSimDeInit(void)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    int i;
+
+    if (!s_downloadSimInited) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    for (i = 0; i < DJI_TEST_DOWNLOAD_SINK_POSITION_NUM; i++) {
+        if (s_downloadSimPositions[i].deleted != NULL) {
+            osalHandler->Free(s_downloadSimPositions[i].deleted);
+        }
+        if (s_downloadSimPositions[i].listBuffer != NULL) {
+            osalHandler->Free(s_downloadSimPositions[i].listBuffer);
+        }
+    }
+    memset(s_downloadSimPositions, 0, sizeof(s_downloadSimPositions));
+
+    if (s_downloadSimFiles != NULL) {
+        osalHandler->Free(s_downloadSimFiles);
+        s_downloadSimFiles = NULL;
+    }
+    s_downloadSimInited = false;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+const T_DjiTestDownloadBackend *DjiTest_DownloadSimGetBackend(void)
+{
+    return &s_downloadSimBackend;
+}
+
+/* Private functions definition-----------------------------------------------*/
+static T_DjiTestDownloadSimPosition *DjiTest_DownloadSimGetPosition(E_DjiMountPosition position)
+{
+    if (!s_downloadSimInited || position <= DJI_MOUNT_POSITION_UNKNOWN ||
+        position >= DJI_TEST_DOWNLOAD_SINK_POSITION_NUM) {
+        return NULL;
+    }
+
+    return &s_downloadSimPositions[position];
+}
+
+static void DjiTest_DownloadSimWaitCommand(void)
+{
+    if (s_downloadSimConfig.commandLatencyMs > 0) {
+        DjiPlatform_GetOsalHandler()->TaskSleepMs(s_downloadSimConfig.commandLatencyMs);
+    }
+}
+
+static T_DjiReturnCode DjiTest_DownloadSimObtainDownloaderRights(E_DjiMountPosition position)
+{
+    T_DjiTestDownloadSimPosition *simPosition = DjiTest_DownloadSimGetPosition(position);
+
+    if (simPosition == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    DjiTest_DownloadSimWaitCommand();
+    simPosition->rightsObtained = true;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+static T_DjiReturnCode DjiTest_DownloadSimReleaseDownloaderRights(E_DjiMountPosition position)
+{
+    T_DjiTestDownloadSimPosition *simPosition = DjiTest_DownloadSimGetPosition(position);
+
+    if (simPosition == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    DjiTest_DownloadSimWaitCommand();
+    simPosition->rightsObtained = false;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+static T_DjiReturnCode DjiTest_DownloadSimRegDownloadFileDataCallback(E_DjiMountPosition position,
+                                                                      DjiCameraManagerDownloadFileDataCallback callback)
+{
+    T_DjiTestDownloadSimPosition *simPosition = DjiTest_DownloadSimGetPosition(position);
+
+    if (simPosition == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    simPosition->callback = callback;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+static T_DjiReturnCode DjiTest_DownloadSimDownloadFileListBySlices(E_DjiMountPosition position,
+                                                                   T_DjiCameraManagerSliceConfig sliceConfig,
+                                                                   T_DjiCameraManagerFileList *fileList)
+{
+    T_DjiTestDownloadSimPosition *simPosition = DjiTest_DownloadSimGetPosition(position);
+    T_DjiCameraManagerFileListInfo *fileInfo;
+    uint32_t listIndex = 0;
+    uint32_t count = 0;
+    uint32_t i;
+
+    if (simPosition == NULL || fileList == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    if (!simPosition->rightsObtained) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    DjiTest_DownloadSimWaitCommand();
+
+    for (i = 0; i < s_downloadSimConfig.fileCount && count < sliceConfig.countPerSlice; i++) {
+        if (simPosition->deleted[i]) {
+            continue;
+        }
+        if (listIndex++ < sliceConfig.sliceStartIndex) {
+            continue;
+        }
+        //the names differ by position, so downloads of several positions do not write the same local file
+        fileInfo = &simPosition->listBuffer[count++];
+        *fileInfo = s_downloadSimFiles[i];
+        snprintf(fileInfo->fileName, sizeof(fileInfo->fileName), "DJI_SIM_%d_%04u.%s", position,
+                 fileInfo->fileIndex, fileInfo->type == DJI_CAMERA_FILE_TYPE_MP4 ? "MP4" : "JPG");
+    }
+
+    fileList->totalCount = (uint16_t) count;
+    fileList->fileListInfo = simPosition->listBuffer;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Send the file to the download callback in the calling task, paced to the configured throughput.
+ */
+static T_DjiReturnCode DjiTest_DownloadSimDownloadFileByIndex(E_DjiMountPosition position, uint32_t fileIndex)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestDownloadSimPosition *simPosition = DjiTest_DownloadSimGetPosition(position);
+    T_DjiDownloadFilePacketInfo packetInfo = {0};
+    uint32_t fileOffset = fileIndex - DJI_TEST_DOWNLOAD_SIM_FILE_INDEX_BASE;
+    uint64_t startTimeUs = 0;
+    uint64_t currentTimeUs = 0;
+    uint64_t sendTimeUs;
+    uint32_t sentLen = 0;
+    uint32_t len;
+
+    if (simPosition == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    if (!simPosition->rightsObtained || simPosition->callback == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    if (fileIndex < DJI_TEST_DOWNLOAD_SIM_FILE_INDEX_BASE || fileOffset >= s_downloadSimConfig.fileCount ||
+        simPosition->deleted[fileOffset]) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+    }
+
+    DjiTest_DownloadSimWaitCommand();
+
+    packetInfo.fileType = DJI_DOWNLOAD_FILE_ORG;
+    packetInfo.fileIndex = fileIndex;
+    packetInfo.fileSize = s_downloadSimFiles[fileOffset].fileSize;
+
+    if (packetInfo.fileSize <= DJI_TEST_DOWNLOAD_SIM_PACKET_SIZE) {
+        packetInfo.downloadFileEvent = DJI_DOWNLOAD_FILE_EVENT_START_TRANSFER_END;
+        packetInfo.progressInPercent = 100.0f;
+        simPosition->callback(packetInfo, s_downloadSimPacket, (uint16_t) packetInfo.fileSize);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    osalHandler->GetTimeUs(&startTimeUs);
+    while (sentLen < packetInfo.fileSize) {
+        len = USER_UTIL_MIN(packetInfo.fileSize - sentLen, DJI_TEST_DOWNLOAD_SIM_PACKET_SIZE);
+        if (sentLen == 0) {
+            packetInfo.downloadFileEvent = DJI_DOWNLOAD_FILE_EVENT_START;
+        } else if (sentLen + len == packetInfo.fileSize) {
+            packetInfo.downloadFileEvent = DJI_DOWNLOAD_FILE_EVENT_END;
+        } else {
+            packetInfo.downloadFileEvent = DJI_DOWNLOAD_FILE_EVENT_TRANSFER;
+        }
+        packetInfo.progressInPercent = (dji_f32_t) (sentLen + len) * 100.0f / (dji_f32_t) packetInfo.fileSize;
+
+        if (s_downloadSimConfig.bytesPerSecond > 0) {
+            sendTimeUs = startTimeUs + (uint64_t) sentLen * 1000000 / s_downloadSimConfig.bytesPerSecond;
+            osalHandler->GetTimeUs(&currentTimeUs);
+            if (sendTimeUs >= currentTimeUs + 1000) {
+                osalHandler->TaskSleepMs((uint32_t) ((sendTimeUs - currentTimeUs) / 1000));
+            }
+        }
+
+        simPosition->callback(packetInfo, s_downloadSimPacket, (uint16_t) len);
+        sentLen += len;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+static T_DjiReturnCode DjiTest_DownloadSimDownloadSubFileByIndexAndSubType(E_DjiMountPosition position,
+                                                                           uint32_t index,
+                                                                           E_DjiCameraMediaFileSubType fileType)
+{
+    USER_UTIL_UNUSED(position);
+    USER_UTIL_UNUSED(index);
+    USER_UTIL_UNUSED(fileType);
+
+    //the simulated files have no sub files
+    return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
+}
+
+static T_DjiReturnCode DjiTest_DownloadSimDeleteFileByIndex(E_DjiMountPosition position, uint32_t fileIndex)
+{
+    T_DjiTestDownloadSimPosition *simPosition = DjiTest_DownloadSimGetPosition(position);
+    uint32_t fileOffset = fileIndex - DJI_TEST_DOWNLOAD_SIM_FILE_INDEX_BASE;
+
+    if (simPosition == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    if (fileIndex < DJI_TEST_DOWNLOAD_SIM_FILE_INDEX_BASE || fileOffset >= s_downloadSimConfig.fileCount ||
+        simPosition->deleted[fileOffset]) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+    }
+
+    DjiTest_DownloadSimWaitCommand();
+    simPosition->deleted[fileOffset] = true;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+#endif
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,65 @@
+/**
+ ********************************************************************
+ * @file    test_camera_manager_download_sim.h
+ * @brief   This is the header file for "test_camera_manager_download_sim.c", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef TEST_CAMERA_MANAGER_DOWNLOAD_SIM_H
+#define TEST_CAMERA_MANAGER_DOWNLOAD_SIM_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_typedef.h"
+#include "test_camera_manager_download_scheduler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef SYSTEM_ARCH_LINUX
+
+/* Exported constants --------------------------------------------------------*/
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+    /*! Sizes of the files on the simulated sdcard, every mount position has the same files. */
+    const uint32_t *fileSizes;
+    uint16_t fileCount;
+    /*! Round trip time of every command sent to the simulated camera. */
+    uint32_t commandLatencyMs;
+    /*! Throughput of the file data of each mount position, 0 for no limit. */
+    uint32_t bytesPerSecond;
+} T_DjiTestDownloadSimConfig;
+
+/* Exported functions --------------------------------------------------------*/
+T_DjiReturnCode DjiTest_DownloadSimInit(const T_DjiTestDownloadSimConfig *config);
+T_DjiReturnCode DjiTest_DownloadSimDeInit(void);
+const T_DjiTestDownloadBackend *DjiTest_DownloadSimGetBackend(void);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TEST_CAMERA_MANAGER_DOWNLOAD_SIM_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
@@ -0,0 +1,266 @@
+/**
+ ********************************************************************
+ * @file    test_camera_manager_point_cloud.c
+ * @brief   The file defines the point cloud recorder used by the camera manager sample. Received point
+ *          cloud packets are framed with a length, timestamps and CRC-32 and written through an async writer.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#ifdef SYSTEM_ARCH_LINUX
+
+#include "test_camera_manager_point_cloud.h"
+#include <stddef.h>
+#include <string.h>
+#include "dji_platform.h"
+#include "dji_logger.h"
+#include "utils/util_async_writer.h"
+#include "utils/util_crc.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define DJI_TEST_POINT_CLOUD_RECORDER_BUFFER_SIZE       (1024 * 1024)
+#define DJI_TEST_POINT_CLOUD_RECORDER_SEQ_WINDOW        64
+/* A sequence jump larger than this is treated as a restart of the stream rather than as lost frames. */
+#define DJI_TEST_POINT_CLOUD_RECORDER_SEQ_RESTART       0x10000
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    T_UtilAsyncWriterHandle writer;
+    bool seqStarted;
+    uint32_t maxSeqNum;
+    /*! Bit n is set when the frame with sequence number maxSeqNum - n was received. */
+    uint64_t seqWindow;
+    T_DjiTestPointCloudRecorderStatistics statistics;
+} T_DjiTestPointCloudRecorder;
+
+/* Private functions declaration ---------------------------------------------*/
+static bool DjiTest_PointCloudRecorderTrackSeq(T_DjiTestPointCloudRecorder *recorder, uint32_t seqNum,
+                                               uint32_t *flags);
+
+/* Private values -------------------------------------------------------------*/
+
+/* Exported functions definition ---------------------------------------------*/
+T_DjiReturnCode DjiTest_PointCloudRecorderOpen(const char *filePath, E_DjiMountPosition position,
+                                               T_DjiTestPointCloudRecorderHandle *recorderHandle)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestPointCloudRecorder *recorder;
+    T_DjiTestPointCloudRecordHeader recordHeader = {0};
+    T_UtilAsyncWriterConfig writerConfig;
+    uint64_t startTimeUs = 0;
+    T_DjiReturnCode returnCode;
+
+    if (filePath == NULL || recorderHandle == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    recorder = osalHandler->Malloc(sizeof(T_DjiTestPointCloudRecorder));
+    if (recorder == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+    memset(recorder, 0, sizeof(T_DjiTestPointCloudRecorder));
+
+    UtilAsyncWriter_GetDefaultConfig(&writerConfig);
+    writerConfig.bufferSize = DJI_TEST_POINT_CLOUD_RECORDER_BUFFER_SIZE;
+    returnCode = UtilAsyncWriter_Open(filePath, &writerConfig, &recorder->writer);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Open point cloud record %s failed, error code: 0x%08llX.", filePath, returnCode);
+        osalHandler->Free(recorder);
+        return returnCode;
+    }
+
+    memcpy(recordHeader.magic, DJI_TEST_POINT_CLOUD_RECORD_MAGIC, DJI_TEST_POINT_CLOUD_RECORD_MAGIC_SIZE);
+    recordHeader.version = DJI_TEST_POINT_CLOUD_RECORD_VERSION;
+    recordHeader.headerSize = sizeof(T_DjiTestPointCloudRecordHeader);
+    recordHeader.frameHeaderSize = sizeof(T_DjiTestPointCloudFrameHeader);
+    recordHeader.pointSize = sizeof(T_DjiCameraManagerPointXYZRGBInfo);
+    recordHeader.mountPosition = position;
+    osalHandler->GetTimeUs(&startTimeUs);
+    recordHeader.startTimeUs = startTimeUs;
+
+    returnCode = UtilAsyncWriter_Write(recorder->writer, (const uint8_t *) &recordHeader, sizeof(recordHeader));
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        UtilAsyncWriter_Close(recorder->writer);
+        osalHandler->Free(recorder);
+        return returnCode;
+    }
+    recorder->statistics.writtenBytes = sizeof(recordHeader);
+
+    *recorderHandle = recorder;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Record one packet received from the point cloud channel.
+ * @note The packet is checked against its point cloud header, duplicates are dropped and frames arriving
+ * after a higher sequence number are kept and flagged as reordered. The points are written as received, only
+ * the frame header is built here, so a packet costs one CRC pass and two buffered copies.
+ */
+T_DjiReturnCode DjiTest_PointCloudRecorderWrite(T_DjiTestPointCloudRecorderHandle recorderHandle,
+                                                const uint8_t *data, uint32_t len)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestPointCloudRecorder *recorder = recorderHandle;
+    const T_DjiCameraManagerColorPointCloud *pointCloud = (const T_DjiCameraManagerColorPointCloud *) data;
+    const uint32_t pointsOffset = offsetof(T_DjiCameraManagerColorPointCloud, points);
+    T_DjiTestPointCloudFrameHeader frameHeader = {0};
+    uint32_t flags = 0;
+    uint64_t recvTimeUs = 0;
+    T_DjiReturnCode returnCode;
+
+    if (recorder == NULL || data == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    if (len < pointsOffset || pointCloud->pointCloudHeader.flag != 0xFFFFFFFF ||
+        pointCloud->pointCloudHeader.dataByte > len - pointsOffset ||
+        pointCloud->pointCloudHeader.dataByte > DJI_TEST_POINT_CLOUD_FRAME_DATA_MAX ||
+        pointCloud->pointCloudHeader.dataByte % sizeof(T_DjiCameraManagerPointXYZRGBInfo) != 0) {
+        recorder->statistics.invalidFrameCount++;
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    if (!DjiTest_PointCloudRecorderTrackSeq(recorder, pointCloud->pointCloudHeader.seqNum, &flags)) {
+        recorder->statistics.duplicateFrameCount++;
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    frameHeader.magic = DJI_TEST_POINT_CLOUD_FRAME_MAGIC;
+    frameHeader.dataByte = pointCloud->pointCloudHeader.dataByte;
+    frameHeader.seqNum = pointCloud->pointCloudHeader.seqNum;
+    frameHeader.flags = flags;
+    frameHeader.timestamp = pointCloud->pointCloudHeader.timestamp;
+    osalHandler->GetTimeUs(&recvTimeUs);
+    frameHeader.recvTimeUs = recvTimeUs;
+    frameHeader.dataCrc = UtilCrc_Crc32(0, data + pointsOffset, frameHeader.dataByte);
+    frameHeader.headerCrc = UtilCrc_Crc32(0, &frameHeader, offsetof(T_DjiTestPointCloudFrameHeader, headerCrc));
+
+    returnCode = UtilAsyncWriter_Write(recorder->writer, (const uint8_t *) &frameHeader, sizeof(frameHeader));
+    if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        returnCode = UtilAsyncWriter_Write(recorder->writer, data + pointsOffset, frameHeader.dataByte);
+    }
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Write point cloud frame %u failed, error code: 0x%08llX.", frameHeader.seqNum, returnCode);
+        return returnCode;
+    }
+
+    recorder->statistics.frameCount++;
+    recorder->statistics.pointCount += frameHeader.dataByte / sizeof(T_DjiCameraManagerPointXYZRGBInfo);
+    recorder->statistics.writtenBytes += sizeof(frameHeader) + frameHeader.dataByte;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiTest_PointCloudRecorderClose(T_DjiTestPointCloudRecorderHandle recorderHandle)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestPointCloudRecorder *recorder = recorderHandle;
+    T_DjiReturnCode returnCode;
+
+    if (recorder == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    returnCode = UtilAsyncWriter_Close(recorder->writer);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Close point cloud record failed, error code: 0x%08llX.", returnCode);
+    }
+    osalHandler->Free(recorder);
+
+    return returnCode;
+}
+
+void DjiTest_PointCloudRecorderGetStatistics(T_DjiTestPointCloudRecorderHandle recorderHandle,
+                                             T_DjiTestPointCloudRecorderStatistics *statistics)
+{
+    T_DjiTestPointCloudRecorder *recorder = recorderHandle;
+    T_UtilAsyncWriterStatistics writerStatistics;
+
+    if (recorder == NULL || statistics == NULL) {
+        return;
+    }
+
+    UtilAsyncWriter_GetStatistics(recorder->writer, &writerStatistics);
+    recorder->statistics.writerWaitCount = writerStatistics.producerWaitCount;
+    *statistics = recorder->statistics;
+}
+
+/* Private functions definition-----------------------------------------------*/
+/**
+ * @brief Track the sequence number of a received frame in a sliding window.
+ * @return false if the frame was already received and should be dropped.
+ */
+static bool DjiTest_PointCloudRecorderTrackSeq(T_DjiTestPointCloudRecorder *recorder, uint32_t seqNum,
+                                               uint32_t *flags)
+{
+    int32_t distance;
+    uint32_t behind;
+
+    if (!recorder->seqStarted) {
+        recorder->seqStarted = true;
+        recorder->maxSeqNum = seqNum;
+        recorder->seqWindow = 1;
+        return true;
+    }
+
+    //signed distance handles wraparound of the 32-bit sequence number
+    distance = (int32_t) (seqNum - recorder->maxSeqNum);
+    if (distance > DJI_TEST_POINT_CLOUD_RECORDER_SEQ_RESTART || distance < -DJI_TEST_POINT_CLOUD_RECORDER_SEQ_RESTART) {
+        USER_LOG_WARN("Point cloud sequence restarted from %u to %u.", recorder->maxSeqNum, seqNum);
+        recorder->statistics.gapCount++;
+        recorder->maxSeqNum = seqNum;
+        recorder->seqWindow = 1;
+        return true;
+    }
+
+    if (distance > 0) {
+        if (distance > 1) {
+            recorder->statistics.gapCount++;
+            recorder->statistics.lostFrameCount += distance - 1;
+        }
+        recorder->seqWindow = distance >= DJI_TEST_POINT_CLOUD_RECORDER_SEQ_WINDOW ? 0 :
+                              recorder->seqWindow << distance;
+        recorder->seqWindow |= 1;
+        recorder->maxSeqNum = seqNum;
+        return true;
+    }
+
+    behind = (uint32_t) -distance;
+    if (behind < DJI_TEST_POINT_CLOUD_RECORDER_SEQ_WINDOW) {
+        if (recorder->seqWindow & (1ULL << behind)) {
+            return false;
+        }
+        recorder->seqWindow |= 1ULL << behind;
+    }
+
+    //frames older than the window are kept, a duplicate of such a frame cannot be detected anymore
+    *flags |= DJI_TEST_POINT_CLOUD_FRAME_FLAG_REORDERED;
+    recorder->statistics.reorderedFrameCount++;
+    if (recorder->statistics.lostFrameCount > 0) {
+        recorder->statistics.lostFrameCount--;
+    }
+
+    return true;
+}
+
+#endif
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,128 @@
+/**
+ ********************************************************************
+ * @file    test_camera_manager_point_cloud.h
+ * @brief   This is the header file for "test_camera_manager_point_cloud.c" and
+ * "test_camera_manager_point_cloud_reader.c", defining the structure and (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef TEST_CAMERA_MANAGER_POINT_CLOUD_H
+#define TEST_CAMERA_MANAGER_POINT_CLOUD_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_typedef.h"
+#include "dji_camera_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef SYSTEM_ARCH_LINUX
+
+/* Exported constants --------------------------------------------------------*/
+#define DJI_TEST_POINT_CLOUD_RECORD_MAGIC               "DJIPCREC"
+#define DJI_TEST_POINT_CLOUD_RECORD_MAGIC_SIZE          8
+#define DJI_TEST_POINT_CLOUD_RECORD_VERSION             1
+/* "PFRM" in file byte order, the reader looks for it to resynchronize after a damaged frame. */
+#define DJI_TEST_POINT_CLOUD_FRAME_MAGIC                0x4D524650U
+#define DJI_TEST_POINT_CLOUD_FRAME_DATA_MAX             (1024 * 1024)
+/* The frame arrived after a frame with a higher sequence number. */
+#define DJI_TEST_POINT_CLOUD_FRAME_FLAG_REORDERED       0x00000001U
+
+/* Exported types ------------------------------------------------------------*/
+typedef void *T_DjiTestPointCloudRecorderHandle;
+
+/**
+ * @brief File layout: one record header followed by frames, every frame is a frame header followed by
+ * dataByte bytes of T_DjiCameraManagerPointXYZRGBInfo points. All fields are little endian.
+ */
+typedef struct {
+    char magic[DJI_TEST_POINT_CLOUD_RECORD_MAGIC_SIZE];
+    uint16_t version;
+    uint16_t headerSize;
+    uint16_t frameHeaderSize;
+    uint16_t pointSize;
+    uint32_t mountPosition;
+    uint64_t startTimeUs;
+} __attribute__((packed)) T_DjiTestPointCloudRecordHeader;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t dataByte;
+    uint32_t seqNum;
+    uint32_t flags;
+    /*! Timestamp of the point cloud header sent by the camera. */
+    uint64_t timestamp;
+    /*! Local time the frame was received, in microseconds. */
+    uint64_t recvTimeUs;
+    uint32_t dataCrc;
+    /*! CRC-32 of the fields above. */
+    uint32_t headerCrc;
+} __attribute__((packed)) T_DjiTestPointCloudFrameHeader;
+
+typedef struct {
+    uint32_t frameCount;
+    uint64_t pointCount;
+    uint64_t writtenBytes;
+    uint32_t invalidFrameCount;
+    uint32_t duplicateFrameCount;
+    uint32_t reorderedFrameCount;
+    uint32_t gapCount;
+    uint32_t lostFrameCount;
+    uint32_t writerWaitCount;
+} T_DjiTestPointCloudRecorderStatistics;
+
+typedef enum {
+    DJI_TEST_POINT_CLOUD_EXPORT_FORMAT_PCD = 0,
+    DJI_TEST_POINT_CLOUD_EXPORT_FORMAT_PLY,
+} E_DjiTestPointCloudExportFormat;
+
+typedef struct {
+    uint32_t frameCount;
+    uint64_t pointCount;
+    uint32_t corruptFrameCount;
+    uint64_t skippedBytes;
+    uint32_t reorderedFrameCount;
+    uint32_t gapCount;
+    uint32_t lostFrameCount;
+} T_DjiTestPointCloudReaderStatistics;
+
+/* Exported functions --------------------------------------------------------*/
+T_DjiReturnCode DjiTest_PointCloudRecorderOpen(const char *filePath, E_DjiMountPosition position,
+                                               T_DjiTestPointCloudRecorderHandle *recorderHandle);
+T_DjiReturnCode DjiTest_PointCloudRecorderWrite(T_DjiTestPointCloudRecorderHandle recorderHandle,
+                                                const uint8_t *data, uint32_t len);
+T_DjiReturnCode DjiTest_PointCloudRecorderClose(T_DjiTestPointCloudRecorderHandle recorderHandle);
+void DjiTest_PointCloudRecorderGetStatistics(T_DjiTestPointCloudRecorderHandle recorderHandle,
+                                             T_DjiTestPointCloudRecorderStatistics *statistics);
+
+T_DjiReturnCode DjiTest_PointCloudRecordExport(const char *recordPath, const char *exportPath,
+                                               E_DjiTestPointCloudExportFormat format,
+                                               T_DjiTestPointCloudReaderStatistics *statistics);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TEST_CAMERA_MANAGER_POINT_CLOUD_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
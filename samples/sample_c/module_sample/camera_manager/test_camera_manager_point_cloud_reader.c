@@ -0,0 +1,303 @@
+/**
+ ********************************************************************
+ * @file    test_camera_manager_point_cloud_reader.c
+ * @brief   The file defines the offline reader of point cloud records written by
+ *          "test_camera_manager_point_cloud.c". It only depends on libc and util_crc, so it is also built into
+ *          tools/point_cloud_convert.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#ifdef SYSTEM_ARCH_LINUX
+
+#include "test_camera_manager_point_cloud.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils/util_crc.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define DJI_TEST_POINT_CLOUD_PCD_POINT_SIZE     20
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    FILE *file;
+    long offset;
+    bool synced;
+    bool seqStarted;
+    uint32_t maxSeqNum;
+    uint8_t *data;
+} T_DjiTestPointCloudReader;
+
+/* Private functions declaration ---------------------------------------------*/
+static bool DjiTest_PointCloudReaderNextFrame(T_DjiTestPointCloudReader *reader,
+                                              T_DjiTestPointCloudFrameHeader *frameHeader,
+                                              T_DjiTestPointCloudReaderStatistics *statistics);
+static void DjiTest_PointCloudReaderTrackSeq(T_DjiTestPointCloudReader *reader,
+                                             const T_DjiTestPointCloudFrameHeader *frameHeader,
+                                             T_DjiTestPointCloudReaderStatistics *statistics);
+static int DjiTest_PointCloudReaderWriteHeader(FILE *file, E_DjiTestPointCloudExportFormat format,
+                                               uint64_t pointCount);
+static size_t DjiTest_PointCloudReaderWritePoints(FILE *file, E_DjiTestPointCloudExportFormat format,
+                                                  const uint8_t *data, uint32_t dataByte, uint8_t *convertBuffer);
+
+/* Private values -------------------------------------------------------------*/
+
+/* Exported functions definition ---------------------------------------------*/
+/**
+ * @brief Convert a point cloud record to a PCD or PLY file.
+ * @note The record is read twice, the first pass counts the valid points needed by the output header and
+ * the second pass writes them. A frame with a damaged header is skipped by searching for the next frame
+ * magic, a frame with a damaged payload is skipped as a whole. Points are written in little endian order.
+ */
+T_DjiReturnCode DjiTest_PointCloudRecordExport(const char *recordPath, const char *exportPath,
+                                               E_DjiTestPointCloudExportFormat format,
+                                               T_DjiTestPointCloudReaderStatistics *statistics)
+{
+    T_DjiTestPointCloudReader reader = {0};
+    T_DjiTestPointCloudRecordHeader recordHeader;
+    T_DjiTestPointCloudFrameHeader frameHeader;
+    T_DjiTestPointCloudReaderStatistics readerStatistics = {0};
+    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    FILE *exportFile = NULL;
+    uint8_t *convertBuffer = NULL;
+
+    if (recordPath == NULL || exportPath == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    reader.file = fopen(recordPath, "rb");
+    if (reader.file == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+    }
+
+    if (fread(&recordHeader, 1, sizeof(recordHeader), reader.file) != sizeof(recordHeader) ||
+        memcmp(recordHeader.magic, DJI_TEST_POINT_CLOUD_RECORD_MAGIC, DJI_TEST_POINT_CLOUD_RECORD_MAGIC_SIZE) != 0 ||
+        recordHeader.version != DJI_TEST_POINT_CLOUD_RECORD_VERSION ||
+        recordHeader.headerSize < sizeof(recordHeader) ||
+        recordHeader.frameHeaderSize != sizeof(T_DjiTestPointCloudFrameHeader) ||
+        recordHeader.pointSize != sizeof(T_DjiCameraManagerPointXYZRGBInfo)) {
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+        goto out;
+    }
+
+    reader.data = malloc(DJI_TEST_POINT_CLOUD_FRAME_DATA_MAX);
+    convertBuffer = malloc(DJI_TEST_POINT_CLOUD_FRAME_DATA_MAX / sizeof(T_DjiCameraManagerPointXYZRGBInfo) *
+                           DJI_TEST_POINT_CLOUD_PCD_POINT_SIZE);
+    if (reader.data == NULL || convertBuffer == NULL) {
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+        goto out;
+    }
+
+    reader.offset = recordHeader.headerSize;
+    reader.synced = true;
+    while (DjiTest_PointCloudReaderNextFrame(&reader, &frameHeader, &readerStatistics)) {
+        readerStatistics.frameCount++;
+        readerStatistics.pointCount += frameHeader.dataByte / sizeof(T_DjiCameraManagerPointXYZRGBInfo);
+        DjiTest_PointCloudReaderTrackSeq(&reader, &frameHeader, &readerStatistics);
+    }
+
+    exportFile = fopen(exportPath, "wb");
+    if (exportFile == NULL) {
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        goto out;
+    }
+
+    if (DjiTest_PointCloudReaderWriteHeader(exportFile, format, readerStatistics.pointCount) < 0) {
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        goto out;
+    }
+
+    reader.offset = recordHeader.headerSize;
+    reader.synced = true;
+    while (DjiTest_PointCloudReaderNextFrame(&reader, &frameHeader, NULL)) {
+        if (DjiTest_PointCloudReaderWritePoints(exportFile, format, reader.data, frameHeader.dataByte,
+                                                convertBuffer) == 0) {
+            returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+            goto out;
+        }
+    }
+
+out:
+    if (exportFile != NULL && fclose(exportFile) != 0 && returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+    fclose(reader.file);
+    free(reader.data);
+    free(convertBuffer);
+
+    if (statistics != NULL) {
+        *statistics = readerStatistics;
+    }
+
+    return returnCode;
+}
+
+/* Private functions definition-----------------------------------------------*/
+/**
+ * @brief Read the next valid frame at or after the current offset, the points are left in reader->data.
+ * @return false at the end of the record or at a truncated frame.
+ */
+static bool DjiTest_PointCloudReaderNextFrame(T_DjiTestPointCloudReader *reader,
+                                              T_DjiTestPointCloudFrameHeader *frameHeader,
+                                              T_DjiTestPointCloudReaderStatistics *statistics)
+{
+    bool headerValid;
+
+    while (true) {
+        if (fseek(reader->file, reader->offset, SEEK_SET) != 0 ||
+            fread(frameHeader, 1, sizeof(T_DjiTestPointCloudFrameHeader), reader->file) !=
+            sizeof(T_DjiTestPointCloudFrameHeader)) {
+            return false;
+        }
+
+        headerValid = frameHeader->magic == DJI_TEST_POINT_CLOUD_FRAME_MAGIC &&
+                      frameHeader->dataByte <= DJI_TEST_POINT_CLOUD_FRAME_DATA_MAX &&
+                      frameHeader->dataByte % sizeof(T_DjiCameraManagerPointXYZRGBInfo) == 0 &&
+                      frameHeader->headerCrc ==
+                      UtilCrc_Crc32(0, frameHeader, offsetof(T_DjiTestPointCloudFrameHeader, headerCrc));
+        if (!headerValid) {
+            //search the next frame magic one byte further, a damaged region counts as one corrupt frame
+            if (reader->synced && statistics != NULL) {
+                statistics->corruptFrameCount++;
+            }
+            if (statistics != NULL) {
+                statistics->skippedBytes++;
+            }
+            reader->synced = false;
+            reader->offset++;
+            continue;
+        }
+
+        if (fread(reader->data, 1, frameHeader->dataByte, reader->file) != frameHeader->dataByte) {
+            return false;
+        }
+
+        reader->synced = true;
+        reader->offset += sizeof(T_DjiTestPointCloudFrameHeader) + frameHeader->dataByte;
+        if (frameHeader->dataCrc != UtilCrc_Crc32(0, reader->data, frameHeader->dataByte)) {
+            if (statistics != NULL) {
+                statistics->corruptFrameCount++;
+                statistics->skippedBytes += sizeof(T_DjiTestPointCloudFrameHeader) + frameHeader->dataByte;
+            }
+            continue;
+        }
+
+        return true;
+    }
+}
+
+static void DjiTest_PointCloudReaderTrackSeq(T_DjiTestPointCloudReader *reader,
+                                             const T_DjiTestPointCloudFrameHeader *frameHeader,
+                                             T_DjiTestPointCloudReaderStatistics *statistics)
+{
+    int32_t distance;
+
+    if (frameHeader->flags & DJI_TEST_POINT_CLOUD_FRAME_FLAG_REORDERED) {
+        statistics->reorderedFrameCount++;
+        if (statistics->lostFrameCount > 0) {
+            statistics->lostFrameCount--;
+        }
+        return;
+    }
+
+    distance = (int32_t) (frameHeader->seqNum - reader->maxSeqNum);
+    if (reader->seqStarted && distance > 1) {
+        statistics->gapCount++;
+        statistics->lostFrameCount += distance - 1;
+    }
+    reader->seqStarted = true;
+    reader->maxSeqNum = frameHeader->seqNum;
+}
+
+static int DjiTest_PointCloudReaderWriteHeader(FILE *file, E_DjiTestPointCloudExportFormat format,
+                                               uint64_t pointCount)
+{
+    if (format == DJI_TEST_POINT_CLOUD_EXPORT_FORMAT_PLY) {
+        return fprintf(file,
+                       "ply\n"
+                       "format binary_little_endian 1.0\n"
+                       "comment DJI point cloud record\n"
+                       "element vertex %llu\n"
+                       "property float x\n"
+                       "property float y\n"
+                       "property float z\n"
+                       "property uchar intensity\n"
+                       "property uchar red\n"
+                       "property uchar green\n"
+                       "property uchar blue\n"
+                       "end_header\n",
+                       (unsigned long long) pointCount);
+    }
+
+    return fprintf(file,
+                   "# .PCD v0.7 - Point Cloud Data file format\n"
+                   "VERSION 0.7\n"
+                   "FIELDS x y z intensity rgb\n"
+                   "SIZE 4 4 4 4 4\n"
+                   "TYPE F F F F U\n"
+                   "COUNT 1 1 1 1 1\n"
+                   "WIDTH %llu\n"
+                   "HEIGHT 1\n"
+                   "VIEWPOINT 0 0 0 1 0 0 0\n"
+                   "POINTS %llu\n"
+                   "DATA binary\n",
+                   (unsigned long long) pointCount, (unsigned long long) pointCount);
+}
+
+/**
+ * @brief Write the points of one frame. The PLY vertex layout matches the recorded points, so they are
+ * written as is, PCD needs the intensity as float and the color packed into one 32-bit field.
+ * @return Number of points written, 0 on error.
+ */
+static size_t DjiTest_PointCloudReaderWritePoints(FILE *file, E_DjiTestPointCloudExportFormat format,
+                                                  const uint8_t *data, uint32_t dataByte, uint8_t *convertBuffer)
+{
+    const T_DjiCameraManagerPointXYZRGBInfo *points = (const T_DjiCameraManagerPointXYZRGBInfo *) data;
+    uint32_t pointCount = dataByte / sizeof(T_DjiCameraManagerPointXYZRGBInfo);
+    uint8_t *out = convertBuffer;
+    dji_f32_t intensity;
+    uint32_t rgb;
+    uint32_t i;
+
+    if (pointCount == 0) {
+        return 1;
+    }
+
+    if (format == DJI_TEST_POINT_CLOUD_EXPORT_FORMAT_PLY) {
+        return fwrite(data, dataByte, 1, file) == 1 ? pointCount : 0;
+    }
+
+    for (i = 0; i < pointCount; i++) {
+        intensity = points[i].intensity;
+        rgb = ((uint32_t) points[i].r << 16) | ((uint32_t) points[i].g << 8) | points[i].b;
+        memcpy(out, &points[i], sizeof(dji_f32_t) * 3);
+        memcpy(out + 12, &intensity, sizeof(intensity));
+        memcpy(out + 16, &rgb, sizeof(rgb));
+        out += DJI_TEST_POINT_CLOUD_PCD_POINT_SIZE;
+    }
+
+    return fwrite(convertBuffer, DJI_TEST_POINT_CLOUD_PCD_POINT_SIZE, pointCount, file) == pointCount ? pointCount : 0;
+}
+
+#endif
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
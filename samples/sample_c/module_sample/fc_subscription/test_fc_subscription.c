@@ -24,8 +24,10 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include <utils/util_misc.h>
+#include <utils/util_attitude.h>
 #include <math.h>
 #include "test_fc_subscription.h"
+#include "test_fc_subscription_cache.h"
 #include "dji_logger.h"
 #include "dji_platform.h"
 #include "widget_interaction_test/test_widget_interaction.h"
@@ -33,6 +35,7 @@
 /* Private constants ---------------------------------------------------------*/
 #define FC_SUBSCRIPTION_TASK_FREQ         (1)
 #define FC_SUBSCRIPTION_TASK_STACK_SIZE   (2048)
+#define FC_SUBSCRIPTION_VELOCITY_HISTORY  (64)
 
 /* Private types -------------------------------------------------------------*/
 
@@ -114,6 +117,17 @@ T_DjiReturnCode DjiTest_FcSubscriptionRunSample(void)
     T_DjiDataTimestamp timestamp = {0};
     T_DjiFcSubscriptionGpsPosition gpsPosition = {0};
     T_DjiFcSubscriptionSingleBatteryInfo singleBatteryInfo = {0};
+    T_DjiTestFcSubscriptionCacheTopicConfig velocityCacheConfig = {
+        .topic = DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY,
+        .frequency = DJI_DATA_SUBSCRIPTION_TOPIC_50_HZ,
+        .dataSize = sizeof(T_DjiFcSubscriptionVelocity),
+        .depth = FC_SUBSCRIPTION_VELOCITY_HISTORY * 2,
+        .interpolate = DjiTest_FcSubscriptionCacheInterpolateVector3f,
+    };
+    T_DjiTestFcSubscriptionCacheStatistics velocityCacheStatistics = {0};
+    T_DjiFcSubscriptionVelocity velocityHistory[FC_SUBSCRIPTION_VELOCITY_HISTORY];
+    uint32_t velocityHistoryCount = 0;
+    uint64_t velocityTimestampUs = 0;
 
     USER_LOG_INFO("Fc subscription sample start");
     s_userFcSubscriptionDataShow = true;
@@ -133,8 +147,8 @@ T_DjiReturnCode DjiTest_FcSubscriptionRunSample(void)
         return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
     }
 
-    djiStat = DjiFcSubscription_SubscribeTopic(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY, DJI_DATA_SUBSCRIPTION_TOPIC_1_HZ,
-                                               NULL);
+    //velocity is kept with its history, so the sample can read all updates of the last second
+    djiStat = DjiTest_FcSubscriptionCacheInit(&velocityCacheConfig, 1);
     if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
         USER_LOG_ERROR("Subscribe topic velocity error.");
         return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
@@ -151,16 +165,27 @@ T_DjiReturnCode DjiTest_FcSubscriptionRunSample(void)
 
     for (int i = 0; i < 10; ++i) {
         osalHandler->TaskSleepMs(1000 / FC_SUBSCRIPTION_TASK_FREQ);
-        djiStat = DjiFcSubscription_GetLatestValueOfTopic(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY,
-                                                          (uint8_t *) &velocity,
-                                                          sizeof(T_DjiFcSubscriptionVelocity),
-                                                          &timestamp);
+        djiStat = DjiTest_FcSubscriptionCacheGetLatest(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY, (uint8_t *) &velocity,
+                                                       sizeof(T_DjiFcSubscriptionVelocity), &velocityTimestampUs,
+                                                       NULL);
         if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
             USER_LOG_ERROR("get value of topic velocity error.");
         } else {
-            USER_LOG_INFO("velocity: x = %f y = %f z = %f healthFlag = %d, timestamp ms = %d us = %d.", velocity.data.x,
+            USER_LOG_INFO("velocity: x = %f y = %f z = %f healthFlag = %d, timestamp us = %llu.", velocity.data.x,
                           velocity.data.y,
-                          velocity.data.z, velocity.health, timestamp.millisecond, timestamp.microsecond);
+                          velocity.data.z, velocity.health, velocityTimestampUs);
+
+            djiStat = DjiTest_FcSubscriptionCacheGetRange(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY,
+                                                          velocityTimestampUs > 1000000 ?
+                                                          velocityTimestampUs - 1000000 : 0,
+                                                          velocityTimestampUs, (uint8_t *) velocityHistory,
+                                                          sizeof(T_DjiFcSubscriptionVelocity), NULL,
+                                                          FC_SUBSCRIPTION_VELOCITY_HISTORY, &velocityHistoryCount);
+            DjiTest_FcSubscriptionCacheGetStatistics(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY, &velocityCacheStatistics);
+            if (djiStat == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+                USER_LOG_INFO("velocity updates in the last second: %d, late updates: %d.", velocityHistoryCount,
+                              velocityCacheStatistics.lateUpdateCount);
+            }
         }
 
         djiStat = DjiFcSubscription_GetLatestValueOfTopic(DJI_FC_SUBSCRIPTION_TOPIC_GPS_POSITION,
@@ -211,7 +236,7 @@ T_DjiReturnCode DjiTest_FcSubscriptionRunSample(void)
         return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
     }
 
-    djiStat = DjiFcSubscription_UnSubscribeTopic(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY);
+    djiStat = DjiTest_FcSubscriptionCacheDeInit();
     if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
         USER_LOG_ERROR("UnSubscribe topic quaternion error.");
         return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
@@ -325,16 +350,16 @@ static T_DjiReturnCode DjiTest_FcSubscriptionReceiveQuaternionCallback(const uin
                                                                        const T_DjiDataTimestamp *timestamp)
 {
     T_DjiFcSubscriptionQuaternion *quaternion = (T_DjiFcSubscriptionQuaternion *) data;
+    T_UtilAttitudeQuaternion attitudeQuaternion = {quaternion->q0, quaternion->q1, quaternion->q2, quaternion->q3};
+    T_UtilAttitudeEuler euler;
     dji_f64_t pitch, yaw, roll;
 
     USER_UTIL_UNUSED(dataSize);
 
-    pitch = (dji_f64_t) asinf(-2 * quaternion->q1 * quaternion->q3 + 2 * quaternion->q0 * quaternion->q2) * 57.3;
-    roll = (dji_f64_t) atan2f(2 * quaternion->q2 * quaternion->q3 + 2 * quaternion->q0 * quaternion->q1,
-                             -2 * quaternion->q1 * quaternion->q1 - 2 * quaternion->q2 * quaternion->q2 + 1) * 57.3;
-    yaw = (dji_f64_t) atan2f(2 * quaternion->q1 * quaternion->q2 + 2 * quaternion->q0 * quaternion->q3,
-                             -2 * quaternion->q2 * quaternion->q2 - 2 * quaternion->q3 * quaternion->q3 + 1) *
-          57.3;
+    euler = UtilAttitude_QuaternionToEuler(attitudeQuaternion);
+    pitch = (dji_f64_t) euler.pitch * UTIL_ATTITUDE_RAD_TO_DEG;
+    roll = (dji_f64_t) euler.roll * UTIL_ATTITUDE_RAD_TO_DEG;
+    yaw = (dji_f64_t) euler.yaw * UTIL_ATTITUDE_RAD_TO_DEG;
 
     if (s_userFcSubscriptionDataShow == true) {
         if (s_userFcSubscriptionDataCnt++ % DJI_DATA_SUBSCRIPTION_TOPIC_50_HZ == 0) {
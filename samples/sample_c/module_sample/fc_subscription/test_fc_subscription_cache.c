@@ -0,0 +1,508 @@
+/**
+ ********************************************************************
+ * @file    test_fc_subscription_cache.c
+ * @brief   The file defines a history cache of flight controller topics. Every topic is received by a
+ *          subscription callback into a ring of timestamped samples protected by per-sample sequence counters,
+ *          so readers never block the callback and never see a partially written sample.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "test_fc_subscription_cache.h"
+#include "test_fc_subscription_dispatcher.h"
+#include "dji_platform.h"
+#include "dji_logger.h"
+#include "utils/util_misc.h"
+#include "utils/util_seqlock.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define DJI_TEST_FC_SUBSCRIPTION_CACHE_READ_RETRY_MAX           8
+/* Upper limit of the data size of topics using interpolation, the two samples are blended on the stack. */
+#define DJI_TEST_FC_SUBSCRIPTION_CACHE_INTERPOLATE_SIZE_MAX     64
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    /*! Seqlock of the slot, twice the number of samples written to it, odd while a sample is being written. */
+    uint32_t sequence;
+    uint32_t reserved;
+    uint64_t timestampUs;
+} T_DjiTestFcSubscriptionCacheEntryHeader;
+
+typedef struct {
+    bool used;
+    E_DjiFcSubscriptionTopic topic;
+    T_DjiTestFcSubscriptionConsumerHandle consumer;
+    uint16_t dataSize;
+    uint32_t depthMask;
+    uint32_t depthShift;
+    uint32_t entrySize;
+    uint32_t periodUs;
+    DjiTestFcSubscriptionCacheInterpolateFunc interpolate;
+    uint8_t *entries;
+    /*! Number of published samples, only written by the subscription callback. */
+    uint32_t writeCount;
+    uint64_t lastTimestampUs;
+    T_DjiTestFcSubscriptionCacheStatistics statistics;
+} T_DjiTestFcSubscriptionCacheTopic;
+
+/* Private functions declaration ---------------------------------------------*/
+static T_DjiTestFcSubscriptionCacheTopic *DjiTest_FcSubscriptionCacheFindTopic(E_DjiFcSubscriptionTopic topic);
+static void DjiTest_FcSubscriptionCacheUpdate(const uint8_t *data, uint16_t dataSize,
+                                              const T_DjiDataTimestamp *timestamp, void *userData);
+static bool DjiTest_FcSubscriptionCacheRead(T_DjiTestFcSubscriptionCacheTopic *cacheTopic, uint32_t index,
+                                            uint64_t *timestampUs, uint8_t *data);
+static uint32_t DjiTest_FcSubscriptionCacheSearch(T_DjiTestFcSubscriptionCacheTopic *cacheTopic, uint64_t timeUs,
+                                                  uint32_t *first, uint32_t *window);
+
+/* Private values -------------------------------------------------------------*/
+static T_DjiTestFcSubscriptionCacheTopic s_cacheTopics[DJI_TEST_FC_SUBSCRIPTION_CACHE_TOPIC_MAX] = {0};
+static bool s_cacheInited = false;
+
+/* Exported functions definition ---------------------------------------------*/
+/**
+ * @brief Allocate the sample rings and register the configured topics with the subscription dispatcher.
+ * @note Queries are safe from any number of threads between init and deinit, and never block the subscription
+ * callback.
+ */
+T_DjiReturnCode DjiTest_FcSubscriptionCacheInit(const T_DjiTestFcSubscriptionCacheTopicConfig *configs,
+                                                uint32_t configCount)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestFcSubscriptionCacheTopic *cacheTopic;
+    T_DjiReturnCode returnCode;
+    uint32_t depth;
+    uint32_t i;
+
+    if (s_cacheInited) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+    }
+
+    if (configs == NULL || configCount == 0 || configCount > DJI_TEST_FC_SUBSCRIPTION_CACHE_TOPIC_MAX) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    for (i = 0; i < configCount; i++) {
+        if (configs[i].dataSize == 0 || configs[i].frequency == 0 ||
+            (configs[i].interpolate != NULL &&
+             configs[i].dataSize > DJI_TEST_FC_SUBSCRIPTION_CACHE_INTERPOLATE_SIZE_MAX)) {
+            return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+        }
+    }
+
+    memset(s_cacheTopics, 0, sizeof(s_cacheTopics));
+    s_cacheInited = true;
+
+    for (i = 0; i < configCount; i++) {
+        cacheTopic = &s_cacheTopics[i];
+        depth = 2;
+        cacheTopic->depthShift = 1;
+        while (depth < (configs[i].depth != 0 ? configs[i].depth : DJI_TEST_FC_SUBSCRIPTION_CACHE_DEFAULT_DEPTH)) {
+            depth <<= 1;
+            cacheTopic->depthShift++;
+        }
+
+        cacheTopic->topic = configs[i].topic;
+        cacheTopic->dataSize = configs[i].dataSize;
+        cacheTopic->depthMask = depth - 1;
+        cacheTopic->entrySize = (sizeof(T_DjiTestFcSubscriptionCacheEntryHeader) + configs[i].dataSize + 7) & ~7U;
+        cacheTopic->periodUs = 1000000 / configs[i].frequency;
+        cacheTopic->interpolate = configs[i].interpolate;
+        cacheTopic->entries = osalHandler->Malloc(depth * cacheTopic->entrySize);
+        if (cacheTopic->entries == NULL) {
+            returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+            goto err;
+        }
+        memset(cacheTopic->entries, 0, depth * cacheTopic->entrySize);
+
+        returnCode = DjiTest_FcSubscriptionDispatcherRegister(configs[i].topic, configs[i].frequency,
+                                                              DjiTest_FcSubscriptionCacheUpdate, cacheTopic,
+                                                              &cacheTopic->consumer);
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            USER_LOG_ERROR("Subscribe topic %d to cache error, stat:0x%08llX.", configs[i].topic, returnCode);
+            goto err;
+        }
+        cacheTopic->used = true;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+
+err:
+    osalHandler->Free(s_cacheTopics[i].entries);
+    s_cacheTopics[i].entries = NULL;
+    DjiTest_FcSubscriptionCacheDeInit();
+    return returnCode;
+}
+
+T_DjiReturnCode DjiTest_FcSubscriptionCacheDeInit(void)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiReturnCode returnCode;
+    uint32_t i;
+
+    if (!s_cacheInited) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    for (i = 0; i < DJI_TEST_FC_SUBSCRIPTION_CACHE_TOPIC_MAX; i++) {
+        if (!s_cacheTopics[i].used) {
+            continue;
+        }
+
+        returnCode = DjiTest_FcSubscriptionDispatcherUnregister(s_cacheTopics[i].consumer);
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            USER_LOG_ERROR("Unsubscribe topic %d of cache error, stat:0x%08llX.", s_cacheTopics[i].topic, returnCode);
+        }
+        osalHandler->Free(s_cacheTopics[i].entries);
+    }
+
+    memset(s_cacheTopics, 0, sizeof(s_cacheTopics));
+    s_cacheInited = false;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Get the latest sample of a topic.
+ * @param sequence: optional, number of samples received before this one. A difference larger than one between
+ * two reads means samples were skipped by the reader.
+ */
+T_DjiReturnCode DjiTest_FcSubscriptionCacheGetLatest(E_DjiFcSubscriptionTopic topic, uint8_t *data,
+                                                     uint16_t dataSize, uint64_t *timestampUs, uint32_t *sequence)
+{
+    T_DjiTestFcSubscriptionCacheTopic *cacheTopic = DjiTest_FcSubscriptionCacheFindTopic(topic);
+    uint64_t sampleTimestampUs;
+    uint32_t writeCount;
+    uint32_t retry;
+
+    if (cacheTopic == NULL || data == NULL || dataSize != cacheTopic->dataSize) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    for (retry = 0; retry < DJI_TEST_FC_SUBSCRIPTION_CACHE_READ_RETRY_MAX; retry++) {
+        writeCount = __atomic_load_n(&cacheTopic->writeCount, __ATOMIC_ACQUIRE);
+        if (writeCount == 0) {
+            return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+        }
+
+        if (DjiTest_FcSubscriptionCacheRead(cacheTopic, writeCount - 1, &sampleTimestampUs, data)) {
+            if (timestampUs != NULL) {
+                *timestampUs = sampleTimestampUs;
+            }
+            if (sequence != NULL) {
+                *sequence = writeCount - 1;
+            }
+            return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+        }
+        __atomic_fetch_add(&cacheTopic->statistics.readRetryCount, 1, __ATOMIC_RELAXED);
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+}
+
+/**
+ * @brief Get the value of a topic at a given time, blended from the samples around it with the interpolate
+ * function of the topic. Times after the latest sample return the latest sample, times before the oldest
+ * sample kept are out of range.
+ * @param timestampUs: time of the returned value, the requested time if the value was interpolated.
+ */
+T_DjiReturnCode DjiTest_FcSubscriptionCacheGetAtTime(E_DjiFcSubscriptionTopic topic, uint64_t timeUs,
+                                                     uint8_t *data, uint16_t dataSize, uint64_t *timestampUs)
+{
+    T_DjiTestFcSubscriptionCacheTopic *cacheTopic = DjiTest_FcSubscriptionCacheFindTopic(topic);
+    uint8_t before[DJI_TEST_FC_SUBSCRIPTION_CACHE_INTERPOLATE_SIZE_MAX];
+    uint8_t after[DJI_TEST_FC_SUBSCRIPTION_CACHE_INTERPOLATE_SIZE_MAX];
+    uint64_t beforeTimestampUs;
+    uint64_t afterTimestampUs;
+    uint32_t first;
+    uint32_t window;
+    uint32_t count;
+    uint32_t retry;
+
+    if (cacheTopic == NULL || data == NULL || dataSize != cacheTopic->dataSize) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    for (retry = 0; retry < DJI_TEST_FC_SUBSCRIPTION_CACHE_READ_RETRY_MAX; retry++) {
+        count = DjiTest_FcSubscriptionCacheSearch(cacheTopic, timeUs, &first, &window);
+        if (window == 0) {
+            return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+        }
+        if (count == 0) {
+            return DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
+        }
+
+        if (cacheTopic->interpolate == NULL || count == window) {
+            if (DjiTest_FcSubscriptionCacheRead(cacheTopic, first + count - 1, &beforeTimestampUs, data)) {
+                if (timestampUs != NULL) {
+                    *timestampUs = beforeTimestampUs;
+                }
+                return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+            }
+        } else if (DjiTest_FcSubscriptionCacheRead(cacheTopic, first + count - 1, &beforeTimestampUs, before) &&
+                   DjiTest_FcSubscriptionCacheRead(cacheTopic, first + count, &afterTimestampUs, after)) {
+            if (afterTimestampUs > beforeTimestampUs) {
+                cacheTopic->interpolate(before, after,
+                                        (dji_f32_t) (timeUs - beforeTimestampUs) /
+                                        (dji_f32_t) (afterTimestampUs - beforeTimestampUs),
+                                        dataSize, data);
+            } else {
+                memcpy(data, before, dataSize);
+            }
+            if (timestampUs != NULL) {
+                *timestampUs = timeUs;
+            }
+            return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+        }
+        __atomic_fetch_add(&cacheTopic->statistics.readRetryCount, 1, __ATOMIC_RELAXED);
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+}
+
+/**
+ * @brief Copy the samples of a topic with startTimeUs <= timestamp <= endTimeUs, oldest first.
+ * @param data: buffer of maxCount * dataSize bytes.
+ * @param timestampsUs: optional, buffer of maxCount timestamps.
+ */
+T_DjiReturnCode DjiTest_FcSubscriptionCacheGetRange(E_DjiFcSubscriptionTopic topic, uint64_t startTimeUs,
+                                                    uint64_t endTimeUs, uint8_t *data, uint16_t dataSize,
+                                                    uint64_t *timestampsUs, uint32_t maxCount, uint32_t *count)
+{
+    T_DjiTestFcSubscriptionCacheTopic *cacheTopic = DjiTest_FcSubscriptionCacheFindTopic(topic);
+    uint64_t sampleTimestampUs;
+    uint32_t first;
+    uint32_t window;
+    uint32_t offset;
+    uint32_t copied = 0;
+
+    if (cacheTopic == NULL || data == NULL || count == NULL || dataSize != cacheTopic->dataSize ||
+        startTimeUs > endTimeUs) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    //skip the samples before startTimeUs, for 0 the wrapped search time is replaced below
+    offset = DjiTest_FcSubscriptionCacheSearch(cacheTopic, startTimeUs - 1, &first, &window);
+    if (startTimeUs == 0) {
+        offset = 0;
+    }
+
+    for (; offset < window && copied < maxCount; offset++) {
+        //samples overwritten since the search are older than the range start and skipped
+        if (!DjiTest_FcSubscriptionCacheRead(cacheTopic, first + offset, &sampleTimestampUs,
+                                             data + copied * dataSize)) {
+            __atomic_fetch_add(&cacheTopic->statistics.readRetryCount, 1, __ATOMIC_RELAXED);
+            continue;
+        }
+        if (sampleTimestampUs > endTimeUs) {
+            break;
+        }
+        if (timestampsUs != NULL) {
+            timestampsUs[copied] = sampleTimestampUs;
+        }
+        copied++;
+    }
+
+    *count = copied;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiTest_FcSubscriptionCacheGetStatistics(E_DjiFcSubscriptionTopic topic,
+                                                         T_DjiTestFcSubscriptionCacheStatistics *statistics)
+{
+    T_DjiTestFcSubscriptionCacheTopic *cacheTopic = DjiTest_FcSubscriptionCacheFindTopic(topic);
+
+    if (cacheTopic == NULL || statistics == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    *statistics = cacheTopic->statistics;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+uint64_t DjiTest_FcSubscriptionCacheTimestampToUs(const T_DjiDataTimestamp *timestamp)
+{
+    //the microsecond field wraps every 71 minutes, only its sub-millisecond part is used
+    return (uint64_t) timestamp->millisecond * 1000 + timestamp->microsecond % 1000;
+}
+
+/**
+ * @brief Linear interpolation of a topic starting with a T_DjiVector3f, e.g. velocity or gimbal angles. The
+ * remaining fields are taken from the nearer sample.
+ */
+void DjiTest_FcSubscriptionCacheInterpolateVector3f(const uint8_t *before, const uint8_t *after, dji_f32_t ratio,
+                                                    uint16_t dataSize, uint8_t *out)
+{
+    T_DjiVector3f vectorBefore;
+    T_DjiVector3f vectorAfter;
+    T_DjiVector3f vector;
+
+    memcpy(&vectorBefore, before, sizeof(T_DjiVector3f));
+    memcpy(&vectorAfter, after, sizeof(T_DjiVector3f));
+    vector.x = vectorBefore.x + (vectorAfter.x - vectorBefore.x) * ratio;
+    vector.y = vectorBefore.y + (vectorAfter.y - vectorBefore.y) * ratio;
+    vector.z = vectorBefore.z + (vectorAfter.z - vectorBefore.z) * ratio;
+
+    memcpy(out, ratio < 0.5f ? before : after, dataSize);
+    memcpy(out, &vector, sizeof(T_DjiVector3f));
+}
+
+/**
+ * @brief Normalized linear interpolation of T_DjiFcSubscriptionQuaternion along the shorter arc, close to
+ * slerp for the small rotations between two samples.
+ */
+void DjiTest_FcSubscriptionCacheInterpolateQuaternion(const uint8_t *before, const uint8_t *after, dji_f32_t ratio,
+                                                      uint16_t dataSize, uint8_t *out)
+{
+    T_DjiFcSubscriptionQuaternion q0;
+    T_DjiFcSubscriptionQuaternion q1;
+    T_DjiFcSubscriptionQuaternion q;
+    dji_f32_t sign;
+    dji_f32_t normSquare;
+    dji_f32_t invNorm;
+
+    memcpy(&q0, before, sizeof(q0));
+    memcpy(&q1, after, sizeof(q1));
+    sign = q0.q0 * q1.q0 + q0.q1 * q1.q1 + q0.q2 * q1.q2 + q0.q3 * q1.q3 < 0 ? -1.0f : 1.0f;
+
+    q.q0 = q0.q0 + (sign * q1.q0 - q0.q0) * ratio;
+    q.q1 = q0.q1 + (sign * q1.q1 - q0.q1) * ratio;
+    q.q2 = q0.q2 + (sign * q1.q2 - q0.q2) * ratio;
+    q.q3 = q0.q3 + (sign * q1.q3 - q0.q3) * ratio;
+
+    normSquare = q.q0 * q.q0 + q.q1 * q.q1 + q.q2 * q.q2 + q.q3 * q.q3;
+    if (normSquare > 0) {
+        //one Newton step of the inverse square root is enough as the norm is close to one
+        invNorm = 1.5f - 0.5f * normSquare;
+        q.q0 *= invNorm;
+        q.q1 *= invNorm;
+        q.q2 *= invNorm;
+        q.q3 *= invNorm;
+    }
+
+    USER_UTIL_UNUSED(dataSize);
+    memcpy(out, &q, sizeof(q));
+}
+
+/* Private functions definition-----------------------------------------------*/
+static T_DjiTestFcSubscriptionCacheTopic *DjiTest_FcSubscriptionCacheFindTopic(E_DjiFcSubscriptionTopic topic)
+{
+    uint32_t i;
+
+    for (i = 0; i < DJI_TEST_FC_SUBSCRIPTION_CACHE_TOPIC_MAX; i++) {
+        if (s_cacheTopics[i].used && s_cacheTopics[i].topic == topic) {
+            return &s_cacheTopics[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void DjiTest_FcSubscriptionCacheUpdate(const uint8_t *data, uint16_t dataSize,
+                                              const T_DjiDataTimestamp *timestamp, void *userData)
+{
+    T_DjiTestFcSubscriptionCacheTopic *cacheTopic = (T_DjiTestFcSubscriptionCacheTopic *) userData;
+    T_DjiTestFcSubscriptionCacheEntryHeader *entry;
+    uint32_t index = cacheTopic->writeCount;
+    uint64_t timestampUs = DjiTest_FcSubscriptionCacheTimestampToUs(timestamp);
+
+    if (dataSize != cacheTopic->dataSize) {
+        cacheTopic->statistics.sizeMismatchCount++;
+        return;
+    }
+
+    if (cacheTopic->lastTimestampUs != 0 &&
+        timestampUs - cacheTopic->lastTimestampUs > cacheTopic->periodUs + cacheTopic->periodUs / 2) {
+        cacheTopic->statistics.lateUpdateCount++;
+    }
+    cacheTopic->lastTimestampUs = timestampUs;
+
+    entry = (T_DjiTestFcSubscriptionCacheEntryHeader *)
+        (cacheTopic->entries + (index & cacheTopic->depthMask) * cacheTopic->entrySize);
+    UtilSeqlock_WriteBegin(&entry->sequence);
+    entry->timestampUs = timestampUs;
+    memcpy((uint8_t *) entry + sizeof(T_DjiTestFcSubscriptionCacheEntryHeader), data, dataSize);
+    UtilSeqlock_WriteEnd(&entry->sequence);
+    __atomic_store_n(&cacheTopic->writeCount, index + 1, __ATOMIC_RELEASE);
+
+    cacheTopic->statistics.updateCount++;
+}
+
+/**
+ * @brief Copy sample index, data may be NULL to read the timestamp only.
+ * @return false if the sample was overwritten before or while it was copied.
+ */
+static bool DjiTest_FcSubscriptionCacheRead(T_DjiTestFcSubscriptionCacheTopic *cacheTopic, uint32_t index,
+                                            uint64_t *timestampUs, uint8_t *data)
+{
+    const T_DjiTestFcSubscriptionCacheEntryHeader *entry = (const T_DjiTestFcSubscriptionCacheEntryHeader *)
+        (cacheTopic->entries + (index & cacheTopic->depthMask) * cacheTopic->entrySize);
+    //a slot holds sample index once it was written index / depth + 1 times
+    uint32_t sequence = 2 * ((index >> cacheTopic->depthShift) + 1);
+
+    if (UtilSeqlock_ReadBegin(&entry->sequence) != sequence) {
+        return false;
+    }
+
+    *timestampUs = entry->timestampUs;
+    if (data != NULL) {
+        memcpy(data, (const uint8_t *) entry + sizeof(T_DjiTestFcSubscriptionCacheEntryHeader), cacheTopic->dataSize);
+    }
+
+    return UtilSeqlock_ReadEnd(&entry->sequence, sequence);
+}
+
+/**
+ * @brief Binary search of the samples kept, which are ordered by timestamp.
+ * @param first: index of the oldest sample searched. The oldest slot of the ring is left out as the next
+ * update reuses it.
+ * @param window: number of samples searched.
+ * @return Number of samples in the window with a timestamp not after timeUs.
+ */
+static uint32_t DjiTest_FcSubscriptionCacheSearch(T_DjiTestFcSubscriptionCacheTopic *cacheTopic, uint64_t timeUs,
+                                                  uint32_t *first, uint32_t *window)
+{
+    uint32_t writeCount = __atomic_load_n(&cacheTopic->writeCount, __ATOMIC_ACQUIRE);
+    uint64_t sampleTimestampUs;
+    uint32_t low = 0;
+    uint32_t high;
+    uint32_t middle;
+
+    *window = writeCount < cacheTopic->depthMask ? writeCount : cacheTopic->depthMask;
+    *first = writeCount - *window;
+    high = *window;
+
+    //find the first sample after timeUs, samples overwritten meanwhile count as old
+    while (low < high) {
+        middle = low + (high - low) / 2;
+        if (!DjiTest_FcSubscriptionCacheRead(cacheTopic, *first + middle, &sampleTimestampUs, NULL) ||
+            sampleTimestampUs <= timeUs) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
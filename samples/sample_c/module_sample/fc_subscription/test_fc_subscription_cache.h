@@ -0,0 +1,95 @@
+/**
+ ********************************************************************
+ * @file    test_fc_subscription_cache.h
+ * @brief   This is the header file for "test_fc_subscription_cache.c", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef TEST_FC_SUBSCRIPTION_CACHE_H
+#define TEST_FC_SUBSCRIPTION_CACHE_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_typedef.h"
+#include "dji_fc_subscription.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+#define DJI_TEST_FC_SUBSCRIPTION_CACHE_TOPIC_MAX            8
+#define DJI_TEST_FC_SUBSCRIPTION_CACHE_DEFAULT_DEPTH        256
+
+/* Exported types ------------------------------------------------------------*/
+/**
+ * @brief Prototype of the function blending two samples of a topic, ratio 0 gives before and 1 gives after.
+ */
+typedef void (*DjiTestFcSubscriptionCacheInterpolateFunc)(const uint8_t *before, const uint8_t *after,
+                                                          dji_f32_t ratio, uint16_t dataSize, uint8_t *out);
+
+typedef struct {
+    E_DjiFcSubscriptionTopic topic;
+    E_DjiDataSubscriptionTopicFreq frequency;
+    /*! Size of the topic data structure, e.g. sizeof(T_DjiFcSubscriptionQuaternion). */
+    uint16_t dataSize;
+    /*! Number of samples kept, rounded up to a power of two, 0 selects the default depth. */
+    uint32_t depth;
+    /*! Used by DjiTest_FcSubscriptionCacheGetAtTime, NULL returns the last sample before the requested time. */
+    DjiTestFcSubscriptionCacheInterpolateFunc interpolate;
+} T_DjiTestFcSubscriptionCacheTopicConfig;
+
+typedef struct {
+    uint32_t updateCount;
+    /*! Updates arriving more than 1.5 periods of the subscription frequency after the previous one. */
+    uint32_t lateUpdateCount;
+    uint32_t sizeMismatchCount;
+    /*! Reads repeated because the sample was overwritten while it was copied. */
+    uint32_t readRetryCount;
+} T_DjiTestFcSubscriptionCacheStatistics;
+
+/* Exported functions --------------------------------------------------------*/
+T_DjiReturnCode DjiTest_FcSubscriptionCacheInit(const T_DjiTestFcSubscriptionCacheTopicConfig *configs,
+                                                uint32_t configCount);
+T_DjiReturnCode DjiTest_FcSubscriptionCacheDeInit(void);
+
+T_DjiReturnCode DjiTest_FcSubscriptionCacheGetLatest(E_DjiFcSubscriptionTopic topic, uint8_t *data,
+                                                     uint16_t dataSize, uint64_t *timestampUs, uint32_t *sequence);
+T_DjiReturnCode DjiTest_FcSubscriptionCacheGetAtTime(E_DjiFcSubscriptionTopic topic, uint64_t timeUs,
+                                                     uint8_t *data, uint16_t dataSize, uint64_t *timestampUs);
+T_DjiReturnCode DjiTest_FcSubscriptionCacheGetRange(E_DjiFcSubscriptionTopic topic, uint64_t startTimeUs,
+                                                    uint64_t endTimeUs, uint8_t *data, uint16_t dataSize,
+                                                    uint64_t *timestampsUs, uint32_t maxCount, uint32_t *count);
+T_DjiReturnCode DjiTest_FcSubscriptionCacheGetStatistics(E_DjiFcSubscriptionTopic topic,
+                                                         T_DjiTestFcSubscriptionCacheStatistics *statistics);
+uint64_t DjiTest_FcSubscriptionCacheTimestampToUs(const T_DjiDataTimestamp *timestamp);
+
+void DjiTest_FcSubscriptionCacheInterpolateVector3f(const uint8_t *before, const uint8_t *after, dji_f32_t ratio,
+                                                    uint16_t dataSize, uint8_t *out);
+void DjiTest_FcSubscriptionCacheInterpolateQuaternion(const uint8_t *before, const uint8_t *after, dji_f32_t ratio,
+                                                      uint16_t dataSize, uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TEST_FC_SUBSCRIPTION_CACHE_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
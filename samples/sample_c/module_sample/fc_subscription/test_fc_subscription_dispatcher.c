@@ -0,0 +1,330 @@
+/**
+ ********************************************************************
+ * @file    test_fc_subscription_dispatcher.c
+ * @brief   The file shares one subscription of a flight controller topic between several consumers, e.g. the
+ *          cache, the snapshot and the recorder receiving the same topic.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "test_fc_subscription_dispatcher.h"
+#include "dji_platform.h"
+#include "dji_logger.h"
+
+/* Private constants ---------------------------------------------------------*/
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    bool used;
+    uint32_t topicIndex;
+    DjiTestFcSubscriptionConsumerCallback callback;
+    void *userData;
+} T_DjiTestFcSubscriptionConsumer;
+
+typedef struct {
+    bool used;
+    E_DjiFcSubscriptionTopic topic;
+    E_DjiDataSubscriptionTopicFreq frequency;
+    /*! Held while the consumers are called, created with the first use of the slot and never destroyed. */
+    T_DjiMutexHandle mutex;
+    uint32_t consumerCount;
+    T_DjiTestFcSubscriptionConsumer consumers[DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CONSUMER_MAX];
+} T_DjiTestFcSubscriptionDispatcherTopic;
+
+/* Private functions declaration ---------------------------------------------*/
+static T_DjiReturnCode DjiTest_FcSubscriptionDispatcherGetMutex(T_DjiMutexHandle *mutex);
+static T_DjiReturnCode DjiTest_FcSubscriptionDispatcherSubscribe(uint32_t topicIndex,
+                                                                 E_DjiDataSubscriptionTopicFreq frequency);
+static void DjiTest_FcSubscriptionDispatcherRemoveConsumer(T_DjiTestFcSubscriptionConsumer *consumer);
+static void DjiTest_FcSubscriptionDispatcherDispatch(uint32_t topicIndex, const uint8_t *data, uint16_t dataSize,
+                                                     const T_DjiDataTimestamp *timestamp);
+
+/* The subscription callback does not carry the topic, so every topic slot gets its own entry. */
+#define DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_DEFINE(group, n)                                      \
+static T_DjiReturnCode DjiTest_FcSubscriptionDispatcherCallback##group##n(const uint8_t *data,             \
+                                                                         uint16_t dataSize,                \
+                                                                         const T_DjiDataTimestamp *timestamp) \
+{                                                                                                        \
+    DjiTest_FcSubscriptionDispatcherDispatch((group) * 8 + (n), data, dataSize, timestamp);              \
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;                                                         \
+}
+
+#define DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_GROUP_DEFINE(group)                                   \
+    DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_DEFINE(group, 0)                                        \
+    DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_DEFINE(group, 1)                                        \
+    DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_DEFINE(group, 2)                                        \
+    DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_DEFINE(group, 3)                                        \
+    DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_DEFINE(group, 4)                                        \
+    DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_DEFINE(group, 5)                                        \
+    DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_DEFINE(group, 6)                                        \
+    DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_DEFINE(group, 7)
+
+#define DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_GROUP(group)                                          \
+    DjiTest_FcSubscriptionDispatcherCallback##group##0, DjiTest_FcSubscriptionDispatcherCallback##group##1, \
+    DjiTest_FcSubscriptionDispatcherCallback##group##2, DjiTest_FcSubscriptionDispatcherCallback##group##3, \
+    DjiTest_FcSubscriptionDispatcherCallback##group##4, DjiTest_FcSubscriptionDispatcherCallback##group##5, \
+    DjiTest_FcSubscriptionDispatcherCallback##group##6, DjiTest_FcSubscriptionDispatcherCallback##group##7
+
+DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_GROUP_DEFINE(0)
+DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_GROUP_DEFINE(1)
+DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_GROUP_DEFINE(2)
+DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_GROUP_DEFINE(3)
+DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_GROUP_DEFINE(4)
+DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_GROUP_DEFINE(5)
+DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_GROUP_DEFINE(6)
+DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_GROUP_DEFINE(7)
+
+/* Private values -------------------------------------------------------------*/
+static const DjiReceiveDataOfTopicCallback s_dispatcherCallbacks[DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_TOPIC_MAX] = {
+    DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_GROUP(0),
+    DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_GROUP(1),
+    DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_GROUP(2),
+    DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_GROUP(3),
+    DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_GROUP(4),
+    DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_GROUP(5),
+    DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_GROUP(6),
+    DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CALLBACK_GROUP(7),
+};
+static T_DjiTestFcSubscriptionDispatcherTopic s_dispatcherTopics[DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_TOPIC_MAX];
+/* Serializes registration, created by the first registration as consumers have no common init. */
+static T_DjiMutexHandle s_dispatcherMutex = NULL;
+
+/* Exported functions definition ---------------------------------------------*/
+/**
+ * @brief Register a consumer of a topic. The first consumer subscribes the topic, a consumer asking for a
+ * higher frequency subscribes it again at that frequency, so consumers may receive the topic more often than
+ * they asked for.
+ * @note Topics subscribed directly with DjiFcSubscription_SubscribeTopic cannot be registered. The callbacks of
+ * one topic are called one after another from the subscription callback and must not block.
+ */
+T_DjiReturnCode DjiTest_FcSubscriptionDispatcherRegister(E_DjiFcSubscriptionTopic topic,
+                                                         E_DjiDataSubscriptionTopicFreq frequency,
+                                                         DjiTestFcSubscriptionConsumerCallback callback,
+                                                         void *userData,
+                                                         T_DjiTestFcSubscriptionConsumerHandle *consumerHandle)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestFcSubscriptionDispatcherTopic *dispatcherTopic = NULL;
+    T_DjiTestFcSubscriptionConsumer *consumer = NULL;
+    T_DjiMutexHandle mutex;
+    T_DjiReturnCode returnCode;
+    uint32_t topicIndex = DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_TOPIC_MAX;
+    uint32_t i;
+
+    if (frequency == 0 || callback == NULL || consumerHandle == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    returnCode = DjiTest_FcSubscriptionDispatcherGetMutex(&mutex);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return returnCode;
+    }
+
+    osalHandler->MutexLock(mutex);
+    for (i = 0; i < DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_TOPIC_MAX; i++) {
+        if (s_dispatcherTopics[i].used && s_dispatcherTopics[i].topic == topic) {
+            topicIndex = i;
+            break;
+        }
+        if (!s_dispatcherTopics[i].used && topicIndex == DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_TOPIC_MAX) {
+            topicIndex = i;
+        }
+    }
+    if (topicIndex == DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_TOPIC_MAX) {
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
+        goto out;
+    }
+
+    dispatcherTopic = &s_dispatcherTopics[topicIndex];
+    if (dispatcherTopic->mutex == NULL) {
+        returnCode = osalHandler->MutexCreate(&dispatcherTopic->mutex);
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            dispatcherTopic->mutex = NULL;
+            goto out;
+        }
+    }
+
+    for (i = 0; i < DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CONSUMER_MAX; i++) {
+        if (!dispatcherTopic->consumers[i].used) {
+            consumer = &dispatcherTopic->consumers[i];
+            break;
+        }
+    }
+    if (consumer == NULL) {
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
+        goto out;
+    }
+
+    //the consumer is added first, so it does not miss samples arriving right after the subscription
+    osalHandler->MutexLock(dispatcherTopic->mutex);
+    consumer->topicIndex = topicIndex;
+    consumer->callback = callback;
+    consumer->userData = userData;
+    consumer->used = true;
+    dispatcherTopic->consumerCount++;
+    osalHandler->MutexUnlock(dispatcherTopic->mutex);
+
+    if (!dispatcherTopic->used) {
+        dispatcherTopic->topic = topic;
+        returnCode = DjiTest_FcSubscriptionDispatcherSubscribe(topicIndex, frequency);
+        dispatcherTopic->used = returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    } else if (frequency > dispatcherTopic->frequency) {
+        returnCode = DjiFcSubscription_UnSubscribeTopic(topic);
+        if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            returnCode = DjiTest_FcSubscriptionDispatcherSubscribe(topicIndex, frequency);
+            if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS &&
+                DjiTest_FcSubscriptionDispatcherSubscribe(topicIndex, dispatcherTopic->frequency) !=
+                DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+                USER_LOG_ERROR("Restore subscription of topic %d failed.", topic);
+            }
+        }
+    }
+
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        DjiTest_FcSubscriptionDispatcherRemoveConsumer(consumer);
+        goto out;
+    }
+
+    *consumerHandle = consumer;
+
+out:
+    osalHandler->MutexUnlock(mutex);
+    return returnCode;
+}
+
+/**
+ * @brief Remove a consumer, the last consumer of a topic unsubscribes it.
+ * @note Once this returns the callback of the consumer is not running and is not called again, so the consumer
+ * may free the data behind userData. It must not be called from a consumer callback.
+ */
+T_DjiReturnCode DjiTest_FcSubscriptionDispatcherUnregister(T_DjiTestFcSubscriptionConsumerHandle consumerHandle)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestFcSubscriptionConsumer *consumer = consumerHandle;
+    T_DjiTestFcSubscriptionDispatcherTopic *dispatcherTopic;
+    T_DjiMutexHandle mutex = __atomic_load_n(&s_dispatcherMutex, __ATOMIC_ACQUIRE);
+    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+
+    if (consumer == NULL || mutex == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    osalHandler->MutexLock(mutex);
+    if (!consumer->used) {
+        osalHandler->MutexUnlock(mutex);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    dispatcherTopic = &s_dispatcherTopics[consumer->topicIndex];
+    DjiTest_FcSubscriptionDispatcherRemoveConsumer(consumer);
+    if (dispatcherTopic->consumerCount == 0) {
+        returnCode = DjiFcSubscription_UnSubscribeTopic(dispatcherTopic->topic);
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            USER_LOG_ERROR("Unsubscribe topic %d error, stat:0x%08llX.", dispatcherTopic->topic, returnCode);
+        }
+        dispatcherTopic->used = false;
+    }
+    osalHandler->MutexUnlock(mutex);
+
+    return returnCode;
+}
+
+/* Private functions definition-----------------------------------------------*/
+static T_DjiReturnCode DjiTest_FcSubscriptionDispatcherGetMutex(T_DjiMutexHandle *mutex)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiMutexHandle expected = NULL;
+    T_DjiMutexHandle created = NULL;
+    T_DjiReturnCode returnCode;
+
+    *mutex = __atomic_load_n(&s_dispatcherMutex, __ATOMIC_ACQUIRE);
+    if (*mutex != NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    returnCode = osalHandler->MutexCreate(&created);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return returnCode;
+    }
+
+    //two first registrations may race, the one losing keeps the mutex of the other
+    if (__atomic_compare_exchange_n(&s_dispatcherMutex, &expected, created, false, __ATOMIC_ACQ_REL,
+                                    __ATOMIC_ACQUIRE)) {
+        *mutex = created;
+    } else {
+        osalHandler->MutexDestroy(created);
+        *mutex = expected;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+static T_DjiReturnCode DjiTest_FcSubscriptionDispatcherSubscribe(uint32_t topicIndex,
+                                                                 E_DjiDataSubscriptionTopicFreq frequency)
+{
+    T_DjiTestFcSubscriptionDispatcherTopic *dispatcherTopic = &s_dispatcherTopics[topicIndex];
+    T_DjiReturnCode returnCode;
+
+    returnCode = DjiFcSubscription_SubscribeTopic(dispatcherTopic->topic, frequency,
+                                                  s_dispatcherCallbacks[topicIndex]);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Subscribe topic %d at %d Hz error, stat:0x%08llX.", dispatcherTopic->topic, frequency,
+                       returnCode);
+        return returnCode;
+    }
+    dispatcherTopic->frequency = frequency;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+static void DjiTest_FcSubscriptionDispatcherRemoveConsumer(T_DjiTestFcSubscriptionConsumer *consumer)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestFcSubscriptionDispatcherTopic *dispatcherTopic = &s_dispatcherTopics[consumer->topicIndex];
+
+    //waits for a callback of the topic in progress
+    osalHandler->MutexLock(dispatcherTopic->mutex);
+    memset(consumer, 0, sizeof(T_DjiTestFcSubscriptionConsumer));
+    dispatcherTopic->consumerCount--;
+    osalHandler->MutexUnlock(dispatcherTopic->mutex);
+}
+
+static void DjiTest_FcSubscriptionDispatcherDispatch(uint32_t topicIndex, const uint8_t *data, uint16_t dataSize,
+                                                     const T_DjiDataTimestamp *timestamp)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestFcSubscriptionDispatcherTopic *dispatcherTopic = &s_dispatcherTopics[topicIndex];
+    uint32_t i;
+
+    if (dispatcherTopic->mutex == NULL) {
+        return;
+    }
+
+    osalHandler->MutexLock(dispatcherTopic->mutex);
+    for (i = 0; i < DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CONSUMER_MAX; i++) {
+        if (dispatcherTopic->consumers[i].used) {
+            dispatcherTopic->consumers[i].callback(data, dataSize, timestamp, dispatcherTopic->consumers[i].userData);
+        }
+    }
+    osalHandler->MutexUnlock(dispatcherTopic->mutex);
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,64 @@
+/**
+ ********************************************************************
+ * @file    test_fc_subscription_dispatcher.h
+ * @brief   This is the header file for "test_fc_subscription_dispatcher.c", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef TEST_FC_SUBSCRIPTION_DISPATCHER_H
+#define TEST_FC_SUBSCRIPTION_DISPATCHER_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_typedef.h"
+#include "dji_fc_subscription.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+#define DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_TOPIC_MAX           64
+#define DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CONSUMER_MAX        4
+
+/* Exported types ------------------------------------------------------------*/
+typedef void *T_DjiTestFcSubscriptionConsumerHandle;
+
+/**
+ * @brief Prototype of the function receiving a topic, userData is the pointer given at registration.
+ */
+typedef void (*DjiTestFcSubscriptionConsumerCallback)(const uint8_t *data, uint16_t dataSize,
+                                                      const T_DjiDataTimestamp *timestamp, void *userData);
+
+/* Exported functions --------------------------------------------------------*/
+T_DjiReturnCode DjiTest_FcSubscriptionDispatcherRegister(E_DjiFcSubscriptionTopic topic,
+                                                         E_DjiDataSubscriptionTopicFreq frequency,
+                                                         DjiTestFcSubscriptionConsumerCallback callback,
+                                                         void *userData,
+                                                         T_DjiTestFcSubscriptionConsumerHandle *consumerHandle);
+T_DjiReturnCode DjiTest_FcSubscriptionDispatcherUnregister(T_DjiTestFcSubscriptionConsumerHandle consumerHandle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TEST_FC_SUBSCRIPTION_DISPATCHER_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
@@ -0,0 +1,998 @@
+/**
+ ********************************************************************
+ * @file    test_fc_subscription_record_reader.c
+ * @brief   The file defines the offline reader of flight data records written by
+ *          "test_fc_subscription_recorder.c" and their export to CSV and column files. It only depends on libc
+ *          and util_crc, so it is also built into tools/fc_record_convert and tools/fc_record_replay.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#ifdef SYSTEM_ARCH_LINUX
+
+#include "test_fc_subscription_recorder.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "utils/util_crc.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define DJI_TEST_FC_RECORD_SCHEMA_SIZE_MAX          (DJI_TEST_FC_RECORD_TOPIC_MAX * \
+                                                     (sizeof(T_DjiTestFcRecordSchemaEntry) + \
+                                                      DJI_TEST_FC_RECORD_LAYOUT_MAX))
+#define DJI_TEST_FC_RECORD_BLOCK_SIZE_MAX           (16 * 1024 * 1024)
+#define DJI_TEST_FC_RECORD_FIELD_MAX                64
+#define DJI_TEST_FC_RECORD_FIELD_NAME_MAX           48
+#define DJI_TEST_FC_RECORD_EXPORT_PATH_LEN_MAX      512
+#define DJI_TEST_FC_RECORD_COLUMN_MAGIC             "DJICOLF1"
+#define DJI_TEST_FC_RECORD_COLUMN_VERSION           1
+#define DJI_TEST_FC_RECORD_COLUMN_GROUP_ROWS        4096
+/* recv_time_us, timestamp_ms and timestamp_us come before the fields of the topic. */
+#define DJI_TEST_FC_RECORD_TIME_COLUMN_NUM          3
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    uint16_t lastDataSize;
+    uint32_t lastMillisecond;
+    uint32_t lastMicrosecond;
+    uint8_t lastData[DJI_TEST_FC_RECORD_DATA_MAX];
+} T_DjiTestFcRecordDecodeState;
+
+typedef struct {
+    FILE *file;
+    T_DjiTestFcRecordHeader header;
+    T_DjiTestFcRecordTopicInfo *topics;
+    T_DjiTestFcRecordDecodeState *states;
+    long dataOffset;
+    long endOffset;
+    T_DjiTestFcRecordIndexEntry *index;
+    uint32_t indexCount;
+
+    long nextBlockOffset;
+    uint64_t skipBeforeUs;
+    uint8_t *block;
+    uint32_t blockCapacity;
+    uint32_t blockLen;
+    uint32_t blockPos;
+    uint32_t blockSamplesLeft;
+    uint64_t lastTimeUs;
+    bool pending;
+    T_DjiTestFcRecordSample pendingSample;
+    uint8_t sampleData[DJI_TEST_FC_RECORD_DATA_MAX];
+
+    T_DjiTestFcRecordReaderStatistics statistics;
+} T_DjiTestFcRecordReader;
+
+typedef struct {
+    char name[DJI_TEST_FC_RECORD_FIELD_NAME_MAX];
+    char type;
+    /*! Width in bytes, 0 for a raw field taking the rest of the sample. */
+    uint16_t width;
+} T_DjiTestFcRecordField;
+
+typedef struct {
+    char name[DJI_TEST_FC_RECORD_FIELD_NAME_MAX];
+    T_DjiTestFcRecordField fields[DJI_TEST_FC_RECORD_FIELD_MAX];
+    uint32_t fieldCount;
+    FILE *file;
+    /* Column export only. */
+    uint8_t *columns[DJI_TEST_FC_RECORD_TIME_COLUMN_NUM + DJI_TEST_FC_RECORD_FIELD_MAX];
+    uint32_t rowCount;
+    uint64_t totalRowCount;
+    uint64_t *groupOffsets;
+    uint32_t groupCount;
+} T_DjiTestFcRecordExportTopic;
+
+/* Private functions declaration ---------------------------------------------*/
+static T_DjiReturnCode DjiTest_FcRecordReaderReadSchema(T_DjiTestFcRecordReader *reader);
+static void DjiTest_FcRecordReaderReadIndex(T_DjiTestFcRecordReader *reader);
+static T_DjiReturnCode DjiTest_FcRecordReaderLoadBlock(T_DjiTestFcRecordReader *reader);
+static bool DjiTest_FcRecordReaderResync(T_DjiTestFcRecordReader *reader, long fromOffset);
+static T_DjiReturnCode DjiTest_FcRecordReaderDecode(T_DjiTestFcRecordReader *reader,
+                                                    T_DjiTestFcRecordSample *sample);
+static bool DjiTest_FcRecordReaderGetVarint(T_DjiTestFcRecordReader *reader, uint64_t *value);
+static int64_t DjiTest_FcRecordReaderUnzigzag(uint64_t value);
+static bool DjiTest_FcRecordParseLayout(const char *layout, T_DjiTestFcRecordExportTopic *topic);
+static uint16_t DjiTest_FcRecordTypeWidth(char type);
+static T_DjiReturnCode DjiTest_FcRecordExportOpen(T_DjiTestFcRecordExportTopic *topic, const char *exportDirPath,
+                                                  E_DjiTestFcRecordExportFormat format,
+                                                  const T_DjiTestFcRecordSample *sample);
+static void DjiTest_FcRecordExportCsvRow(T_DjiTestFcRecordExportTopic *topic, const T_DjiTestFcRecordSample *sample);
+static void DjiTest_FcRecordExportColumnRow(T_DjiTestFcRecordExportTopic *topic,
+                                            const T_DjiTestFcRecordSample *sample);
+static void DjiTest_FcRecordExportColumnFlush(T_DjiTestFcRecordExportTopic *topic);
+static void DjiTest_FcRecordExportClose(T_DjiTestFcRecordExportTopic *topic, E_DjiTestFcRecordExportFormat format);
+
+/* Private values -------------------------------------------------------------*/
+
+/* Exported functions definition ---------------------------------------------*/
+/**
+ * @brief Open one segment of a flight data record.
+ * @note The index written when the segment was closed is used when it is intact, otherwise the blocks are
+ * scanned. Damaged blocks are skipped by searching for the next block magic.
+ */
+T_DjiReturnCode DjiTest_FcRecordReaderOpen(const char *recordPath, T_DjiTestFcRecordReaderHandle *readerHandle)
+{
+    T_DjiTestFcRecordReader *reader;
+    T_DjiReturnCode returnCode;
+
+    if (recordPath == NULL || readerHandle == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    reader = calloc(1, sizeof(T_DjiTestFcRecordReader));
+    if (reader == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+
+    reader->file = fopen(recordPath, "rb");
+    if (reader->file == NULL) {
+        free(reader);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+    }
+
+    if (fread(&reader->header, sizeof(reader->header), 1, reader->file) != 1 ||
+        memcmp(reader->header.magic, DJI_TEST_FC_RECORD_MAGIC, DJI_TEST_FC_RECORD_MAGIC_SIZE) != 0 ||
+        reader->header.headerCrc != UtilCrc_Crc32(0, (const uint8_t *) &reader->header,
+                                                  sizeof(reader->header) - sizeof(reader->header.headerCrc)) ||
+        reader->header.version != DJI_TEST_FC_RECORD_VERSION ||
+        reader->header.headerSize != sizeof(T_DjiTestFcRecordHeader) ||
+        reader->header.blockHeaderSize != sizeof(T_DjiTestFcRecordBlockHeader) ||
+        reader->header.topicCount == 0 || reader->header.topicCount > DJI_TEST_FC_RECORD_TOPIC_MAX ||
+        reader->header.schemaSize > DJI_TEST_FC_RECORD_SCHEMA_SIZE_MAX) {
+        DjiTest_FcRecordReaderClose(reader);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    returnCode = DjiTest_FcRecordReaderReadSchema(reader);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        DjiTest_FcRecordReaderClose(reader);
+        return returnCode;
+    }
+
+    reader->dataOffset = sizeof(T_DjiTestFcRecordHeader) + reader->header.schemaSize;
+    fseek(reader->file, 0, SEEK_END);
+    reader->endOffset = ftell(reader->file);
+    DjiTest_FcRecordReaderReadIndex(reader);
+    reader->nextBlockOffset = reader->dataOffset;
+
+    *readerHandle = reader;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiTest_FcRecordReaderClose(T_DjiTestFcRecordReaderHandle readerHandle)
+{
+    T_DjiTestFcRecordReader *reader = readerHandle;
+
+    if (reader == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    if (reader->file != NULL) {
+        fclose(reader->file);
+    }
+    free(reader->topics);
+    free(reader->states);
+    free(reader->index);
+    free(reader->block);
+    free(reader);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+uint16_t DjiTest_FcRecordReaderGetTopicCount(T_DjiTestFcRecordReaderHandle readerHandle)
+{
+    T_DjiTestFcRecordReader *reader = readerHandle;
+
+    return reader != NULL ? reader->header.topicCount : 0;
+}
+
+T_DjiReturnCode DjiTest_FcRecordReaderGetTopicInfo(T_DjiTestFcRecordReaderHandle readerHandle, uint16_t topicIndex,
+                                                   T_DjiTestFcRecordTopicInfo *topicInfo)
+{
+    T_DjiTestFcRecordReader *reader = readerHandle;
+
+    if (reader == NULL || topicInfo == NULL || topicIndex >= reader->header.topicCount) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    *topicInfo = reader->topics[topicIndex];
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Read the next sample in recording order.
+ * @return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND at the end of the record.
+ */
+T_DjiReturnCode DjiTest_FcRecordReaderNext(T_DjiTestFcRecordReaderHandle readerHandle,
+                                           T_DjiTestFcRecordSample *sample)
+{
+    T_DjiTestFcRecordReader *reader = readerHandle;
+    T_DjiReturnCode returnCode;
+
+    if (reader == NULL || sample == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    if (reader->pending) {
+        reader->pending = false;
+        *sample = reader->pendingSample;
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    while (reader->blockSamplesLeft == 0) {
+        returnCode = DjiTest_FcRecordReaderLoadBlock(reader);
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            return returnCode;
+        }
+    }
+
+    returnCode = DjiTest_FcRecordReaderDecode(reader, sample);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        //a block passing its CRC but failing to decode was written by an incompatible recorder, drop the rest
+        reader->statistics.corruptBlockCount++;
+        reader->blockSamplesLeft = 0;
+        return DjiTest_FcRecordReaderNext(readerHandle, sample);
+    }
+    reader->statistics.sampleCount++;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Position the reader so that the next sample is the first one received at or after timeUs.
+ * @note Blocks ending before timeUs are skipped by their headers without being decoded.
+ */
+T_DjiReturnCode DjiTest_FcRecordReaderSeek(T_DjiTestFcRecordReaderHandle readerHandle, uint64_t timeUs)
+{
+    T_DjiTestFcRecordReader *reader = readerHandle;
+    T_DjiTestFcRecordSample sample;
+    T_DjiReturnCode returnCode;
+    uint32_t i;
+
+    if (reader == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    reader->pending = false;
+    reader->blockSamplesLeft = 0;
+    reader->nextBlockOffset = reader->dataOffset;
+    for (i = 0; i < reader->indexCount; i++) {
+        if (reader->index[i].lastTimeUs >= timeUs) {
+            reader->nextBlockOffset = (long) reader->index[i].offset;
+            break;
+        }
+    }
+    if (reader->indexCount > 0 && i == reader->indexCount) {
+        reader->nextBlockOffset = reader->endOffset;
+    }
+
+    reader->skipBeforeUs = timeUs;
+    do {
+        returnCode = DjiTest_FcRecordReaderNext(reader, &sample);
+    } while (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS && sample.recvTimeUs < timeUs);
+    reader->skipBeforeUs = 0;
+
+    if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        reader->pendingSample = sample;
+        reader->pending = true;
+    }
+
+    return returnCode;
+}
+
+void DjiTest_FcRecordReaderGetStatistics(T_DjiTestFcRecordReaderHandle readerHandle,
+                                         T_DjiTestFcRecordReaderStatistics *statistics)
+{
+    T_DjiTestFcRecordReader *reader = readerHandle;
+
+    if (reader == NULL || statistics == NULL) {
+        return;
+    }
+
+    *statistics = reader->statistics;
+}
+
+/**
+ * @brief Export the segments of a record, in recording order, to one file per topic in exportDirPath.
+ * @note A topic gets "<topic name>.csv" or "<topic name>.col" once its first sample is read. All segments must
+ * come from the same recorder. Values are decoded in the byte order of the host, which matches the little
+ * endian aircraft side on all supported platforms.
+ */
+T_DjiReturnCode DjiTest_FcRecordExport(const char *const *recordPaths, uint32_t recordCount,
+                                       const char *exportDirPath, E_DjiTestFcRecordExportFormat format,
+                                       T_DjiTestFcRecordReaderStatistics *statistics)
+{
+    T_DjiTestFcRecordExportTopic *topics = NULL;
+    T_DjiTestFcRecordReaderHandle readerHandle = NULL;
+    T_DjiTestFcRecordReader *reader;
+    T_DjiTestFcRecordReaderStatistics readerStatistics;
+    T_DjiTestFcRecordSample sample;
+    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    uint32_t schemaCrc = 0;
+    uint16_t topicCount = 0;
+    uint32_t i;
+    uint16_t j;
+
+    if (recordPaths == NULL || recordCount == 0 || exportDirPath == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    if (mkdir(exportDirPath, 0755) != 0 && errno != EEXIST) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    if (statistics != NULL) {
+        memset(statistics, 0, sizeof(T_DjiTestFcRecordReaderStatistics));
+        statistics->indexed = true;
+    }
+
+    for (i = 0; i < recordCount && returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS; i++) {
+        returnCode = DjiTest_FcRecordReaderOpen(recordPaths[i], &readerHandle);
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            break;
+        }
+        reader = readerHandle;
+
+        if (topics == NULL) {
+            topicCount = reader->header.topicCount;
+            schemaCrc = reader->header.schemaCrc;
+            topics = calloc(topicCount, sizeof(T_DjiTestFcRecordExportTopic));
+            if (topics == NULL) {
+                DjiTest_FcRecordReaderClose(readerHandle);
+                return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+            }
+            for (j = 0; j < topicCount; j++) {
+                if (!DjiTest_FcRecordParseLayout(reader->topics[j].layout, &topics[j])) {
+                    returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+                }
+            }
+        } else if (reader->header.topicCount != topicCount || reader->header.schemaCrc != schemaCrc) {
+            returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+        }
+
+        while (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS &&
+               DjiTest_FcRecordReaderNext(readerHandle, &sample) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            if (topics[sample.topicIndex].file == NULL) {
+                returnCode = DjiTest_FcRecordExportOpen(&topics[sample.topicIndex], exportDirPath, format,
+                                                        &sample);
+                if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+                    break;
+                }
+            }
+
+            if (format == DJI_TEST_FC_RECORD_EXPORT_FORMAT_CSV) {
+                DjiTest_FcRecordExportCsvRow(&topics[sample.topicIndex], &sample);
+            } else {
+                DjiTest_FcRecordExportColumnRow(&topics[sample.topicIndex], &sample);
+            }
+        }
+
+        DjiTest_FcRecordReaderGetStatistics(readerHandle, &readerStatistics);
+        if (statistics != NULL) {
+            statistics->sampleCount += readerStatistics.sampleCount;
+            statistics->blockCount += readerStatistics.blockCount;
+            statistics->corruptBlockCount += readerStatistics.corruptBlockCount;
+            statistics->skippedBytes += readerStatistics.skippedBytes;
+            statistics->indexed = statistics->indexed && readerStatistics.indexed;
+        }
+        DjiTest_FcRecordReaderClose(readerHandle);
+    }
+
+    for (j = 0; topics != NULL && j < topicCount; j++) {
+        DjiTest_FcRecordExportClose(&topics[j], format);
+    }
+    free(topics);
+
+    return returnCode;
+}
+
+/* Private functions definition-----------------------------------------------*/
+static T_DjiReturnCode DjiTest_FcRecordReaderReadSchema(T_DjiTestFcRecordReader *reader)
+{
+    T_DjiTestFcRecordSchemaEntry schemaEntry;
+    uint8_t *schema;
+    uint32_t offset = 0;
+    uint16_t i;
+
+    schema = malloc(reader->header.schemaSize);
+    reader->topics = calloc(reader->header.topicCount, sizeof(T_DjiTestFcRecordTopicInfo));
+    reader->states = calloc(reader->header.topicCount, sizeof(T_DjiTestFcRecordDecodeState));
+    if (schema == NULL || reader->topics == NULL || reader->states == NULL) {
+        free(schema);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+
+    if (fread(schema, 1, reader->header.schemaSize, reader->file) != reader->header.schemaSize ||
+        UtilCrc_Crc32(0, schema, reader->header.schemaSize) != reader->header.schemaCrc) {
+        free(schema);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    for (i = 0; i < reader->header.topicCount; i++) {
+        if (offset + sizeof(schemaEntry) > reader->header.schemaSize) {
+            break;
+        }
+        memcpy(&schemaEntry, schema + offset, sizeof(schemaEntry));
+        offset += sizeof(schemaEntry);
+        if (schemaEntry.layoutLength >= DJI_TEST_FC_RECORD_LAYOUT_MAX ||
+            offset + schemaEntry.layoutLength > reader->header.schemaSize) {
+            break;
+        }
+
+        reader->topics[i].topic = (E_DjiFcSubscriptionTopic) schemaEntry.topic;
+        reader->topics[i].frequency = (E_DjiDataSubscriptionTopicFreq) schemaEntry.frequency;
+        reader->topics[i].dataSize = schemaEntry.dataSize;
+        memcpy(reader->topics[i].layout, schema + offset, schemaEntry.layoutLength);
+        reader->topics[i].layout[schemaEntry.layoutLength] = '\0';
+        offset += schemaEntry.layoutLength;
+    }
+    free(schema);
+
+    return i == reader->header.topicCount ? DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS :
+           DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+}
+
+static void DjiTest_FcRecordReaderReadIndex(T_DjiTestFcRecordReader *reader)
+{
+    T_DjiTestFcRecordFooter footer;
+    long indexSize;
+
+    if (reader->endOffset < reader->dataOffset + (long) sizeof(footer) ||
+        fseek(reader->file, reader->endOffset - (long) sizeof(footer), SEEK_SET) != 0 ||
+        fread(&footer, sizeof(footer), 1, reader->file) != 1 ||
+        footer.magic != DJI_TEST_FC_RECORD_INDEX_MAGIC ||
+        footer.footerCrc != UtilCrc_Crc32(0, (const uint8_t *) &footer, sizeof(footer) - sizeof(footer.footerCrc))) {
+        return;
+    }
+
+    indexSize = (long) footer.blockCount * (long) sizeof(T_DjiTestFcRecordIndexEntry);
+    if ((long) footer.indexOffset < reader->dataOffset ||
+        (long) footer.indexOffset + indexSize + (long) sizeof(footer) != reader->endOffset) {
+        return;
+    }
+
+    reader->index = malloc(indexSize > 0 ? indexSize : 1);
+    if (reader->index == NULL || fseek(reader->file, (long) footer.indexOffset, SEEK_SET) != 0 ||
+        fread(reader->index, 1, indexSize, reader->file) != (size_t) indexSize ||
+        UtilCrc_Crc32(0, (const uint8_t *) reader->index, indexSize) != footer.indexCrc) {
+        free(reader->index);
+        reader->index = NULL;
+        return;
+    }
+
+    reader->indexCount = footer.blockCount;
+    reader->endOffset = (long) footer.indexOffset;
+    reader->statistics.indexed = true;
+}
+
+/**
+ * @brief Load the next intact block, blocks ending before skipBeforeUs are passed over.
+ */
+static T_DjiReturnCode DjiTest_FcRecordReaderLoadBlock(T_DjiTestFcRecordReader *reader)
+{
+    T_DjiTestFcRecordBlockHeader blockHeader;
+    uint8_t *block;
+    long offset;
+    uint16_t i;
+
+    while (true) {
+        offset = reader->nextBlockOffset;
+        if (offset + (long) sizeof(blockHeader) > reader->endOffset) {
+            return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+        }
+
+        if (fseek(reader->file, offset, SEEK_SET) != 0 ||
+            fread(&blockHeader, sizeof(blockHeader), 1, reader->file) != 1 ||
+            blockHeader.magic != DJI_TEST_FC_RECORD_BLOCK_MAGIC ||
+            blockHeader.headerCrc != UtilCrc_Crc32(0, (const uint8_t *) &blockHeader,
+                                                   sizeof(blockHeader) - sizeof(blockHeader.headerCrc)) ||
+            blockHeader.encodedSize > DJI_TEST_FC_RECORD_BLOCK_SIZE_MAX ||
+            offset + (long) sizeof(blockHeader) + (long) blockHeader.encodedSize > reader->endOffset) {
+            if (!DjiTest_FcRecordReaderResync(reader, offset + 1)) {
+                return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+            }
+            continue;
+        }
+
+        reader->nextBlockOffset = offset + (long) sizeof(blockHeader) + (long) blockHeader.encodedSize;
+        if (blockHeader.lastTimeUs < reader->skipBeforeUs) {
+            continue;
+        }
+
+        if (blockHeader.encodedSize > reader->blockCapacity) {
+            block = realloc(reader->block, blockHeader.encodedSize);
+            if (block == NULL) {
+                return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+            }
+            reader->block = block;
+            reader->blockCapacity = blockHeader.encodedSize;
+        }
+
+        if (fread(reader->block, 1, blockHeader.encodedSize, reader->file) != blockHeader.encodedSize ||
+            UtilCrc_Crc32(0, reader->block, blockHeader.encodedSize) != blockHeader.dataCrc) {
+            if (!DjiTest_FcRecordReaderResync(reader, offset + 1)) {
+                return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+            }
+            continue;
+        }
+
+        reader->blockLen = blockHeader.encodedSize;
+        break;
+    }
+
+    for (i = 0; i < reader->header.topicCount; i++) {
+        reader->states[i].lastDataSize = 0;
+        reader->states[i].lastMillisecond = 0;
+        reader->states[i].lastMicrosecond = 0;
+    }
+    reader->blockPos = 0;
+    reader->blockSamplesLeft = blockHeader.sampleCount;
+    reader->lastTimeUs = blockHeader.firstTimeUs;
+    reader->statistics.blockCount++;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Search the next block magic at or after fromOffset, the bytes passed over are counted as skipped.
+ */
+static bool DjiTest_FcRecordReaderResync(T_DjiTestFcRecordReader *reader, long fromOffset)
+{
+    const uint32_t magic = DJI_TEST_FC_RECORD_BLOCK_MAGIC;
+    uint8_t buffer[4096];
+    size_t readLen;
+    size_t i;
+    long offset = fromOffset;
+
+    reader->statistics.corruptBlockCount++;
+    while (offset + (long) sizeof(magic) <= reader->endOffset) {
+        if (fseek(reader->file, offset, SEEK_SET) != 0) {
+            break;
+        }
+        readLen = fread(buffer, 1, sizeof(buffer), reader->file);
+        if (readLen < sizeof(magic)) {
+            break;
+        }
+
+        for (i = 0; i + sizeof(magic) <= readLen; i++) {
+            if (memcmp(buffer + i, &magic, sizeof(magic)) == 0) {
+                reader->statistics.skippedBytes += offset + (long) i - (fromOffset - 1);
+                reader->nextBlockOffset = offset + (long) i;
+                return true;
+            }
+        }
+        offset += (long) (readLen - sizeof(magic) + 1);
+    }
+
+    reader->statistics.skippedBytes += reader->endOffset - (fromOffset - 1);
+    reader->nextBlockOffset = reader->endOffset;
+
+    return false;
+}
+
+static T_DjiReturnCode DjiTest_FcRecordReaderDecode(T_DjiTestFcRecordReader *reader,
+                                                    T_DjiTestFcRecordSample *sample)
+{
+    T_DjiTestFcRecordDecodeState *state;
+    uint64_t timeDelta;
+    uint64_t millisecondDelta;
+    uint64_t microsecondDelta;
+    uint64_t dataSize;
+    uint32_t outLen = 0;
+    uint8_t control;
+    uint32_t runLen;
+    uint8_t topicIndex;
+    uint32_t i;
+
+    if (reader->blockPos >= reader->blockLen) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
+    }
+
+    topicIndex = reader->block[reader->blockPos++];
+    if (topicIndex >= reader->header.topicCount ||
+        !DjiTest_FcRecordReaderGetVarint(reader, &timeDelta) ||
+        !DjiTest_FcRecordReaderGetVarint(reader, &millisecondDelta) ||
+        !DjiTest_FcRecordReaderGetVarint(reader, &microsecondDelta) ||
+        !DjiTest_FcRecordReaderGetVarint(reader, &dataSize) || dataSize > DJI_TEST_FC_RECORD_DATA_MAX) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
+    }
+
+    while (outLen < dataSize) {
+        if (reader->blockPos >= reader->blockLen) {
+            return DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
+        }
+        control = reader->block[reader->blockPos++];
+        if (control < 0x80) {
+            runLen = control + 1;
+            if (outLen + runLen > dataSize || reader->blockPos + runLen > reader->blockLen) {
+                return DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
+            }
+            memcpy(reader->sampleData + outLen, reader->block + reader->blockPos, runLen);
+            reader->blockPos += runLen;
+        } else {
+            runLen = control - 0x7F;
+            if (outLen + runLen > dataSize) {
+                return DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
+            }
+            memset(reader->sampleData + outLen, 0, runLen);
+        }
+        outLen += runLen;
+    }
+
+    state = &reader->states[topicIndex];
+    if (state->lastDataSize == dataSize) {
+        for (i = 0; i < dataSize; i++) {
+            reader->sampleData[i] ^= state->lastData[i];
+        }
+    }
+
+    reader->lastTimeUs += (uint64_t) DjiTest_FcRecordReaderUnzigzag(timeDelta);
+    state->lastMillisecond += (uint32_t) DjiTest_FcRecordReaderUnzigzag(millisecondDelta);
+    state->lastMicrosecond += (uint32_t) DjiTest_FcRecordReaderUnzigzag(microsecondDelta);
+    state->lastDataSize = (uint16_t) dataSize;
+    memcpy(state->lastData, reader->sampleData, dataSize);
+    reader->blockSamplesLeft--;
+
+    sample->topicIndex = topicIndex;
+    sample->topic = reader->topics[topicIndex].topic;
+    sample->recvTimeUs = reader->lastTimeUs;
+    sample->timestamp.millisecond = state->lastMillisecond;
+    sample->timestamp.microsecond = state->lastMicrosecond;
+    sample->dataSize = (uint16_t) dataSize;
+    sample->data = reader->sampleData;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+static bool DjiTest_FcRecordReaderGetVarint(T_DjiTestFcRecordReader *reader, uint64_t *value)
+{
+    uint32_t shift = 0;
+    uint8_t byte;
+
+    *value = 0;
+    do {
+        if (reader->blockPos >= reader->blockLen || shift > 63) {
+            return false;
+        }
+        byte = reader->block[reader->blockPos++];
+        *value |= (uint64_t) (byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+
+    return true;
+}
+
+static int64_t DjiTest_FcRecordReaderUnzigzag(uint64_t value)
+{
+    return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+}
+
+static bool DjiTest_FcRecordParseLayout(const char *layout, T_DjiTestFcRecordExportTopic *topic)
+{
+    const char *field;
+    const char *separator;
+    const char *end;
+    T_DjiTestFcRecordField *out;
+    size_t nameLen;
+
+    separator = strchr(layout, ';');
+    if (separator == NULL || separator == layout ||
+        separator - layout >= DJI_TEST_FC_RECORD_FIELD_NAME_MAX) {
+        return false;
+    }
+    memcpy(topic->name, layout, separator - layout);
+    topic->name[separator - layout] = '\0';
+
+    field = separator + 1;
+    while (*field != '\0') {
+        end = strchr(field, ',');
+        if (end == NULL) {
+            end = field + strlen(field);
+        }
+        separator = memchr(field, ':', end - field);
+        if (separator == NULL || topic->fieldCount >= DJI_TEST_FC_RECORD_FIELD_MAX || separator + 1 >= end) {
+            return false;
+        }
+
+        out = &topic->fields[topic->fieldCount++];
+        nameLen = separator - field;
+        if (nameLen == 0 || nameLen >= DJI_TEST_FC_RECORD_FIELD_NAME_MAX) {
+            return false;
+        }
+        memcpy(out->name, field, nameLen);
+        out->name[nameLen] = '\0';
+        out->type = separator[1];
+        if (out->type == 'x') {
+            out->width = (uint16_t) strtoul(separator + 2, NULL, 10);
+        } else {
+            out->width = DjiTest_FcRecordTypeWidth(out->type);
+            if (out->width == 0 || separator + 2 != end) {
+                return false;
+            }
+        }
+
+        field = *end == ',' ? end + 1 : end;
+    }
+
+    return topic->fieldCount > 0;
+}
+
+static uint16_t DjiTest_FcRecordTypeWidth(char type)
+{
+    switch (type) {
+        case 'b':
+        case 'B':
+            return 1;
+        case 'h':
+        case 'H':
+            return 2;
+        case 'i':
+        case 'I':
+        case 'f':
+            return 4;
+        case 'q':
+        case 'Q':
+        case 'd':
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Create the export file of a topic, raw fields without width take the size of the first sample.
+ */
+static T_DjiReturnCode DjiTest_FcRecordExportOpen(T_DjiTestFcRecordExportTopic *topic, const char *exportDirPath,
+                                                  E_DjiTestFcRecordExportFormat format,
+                                                  const T_DjiTestFcRecordSample *sample)
+{
+    static const T_DjiTestFcRecordField timeFields[DJI_TEST_FC_RECORD_TIME_COLUMN_NUM] = {
+        {"recv_time_us", 'Q', 8},
+        {"timestamp_ms", 'I', 4},
+        {"timestamp_us", 'I', 4},
+    };
+    char filePath[DJI_TEST_FC_RECORD_EXPORT_PATH_LEN_MAX];
+    const T_DjiTestFcRecordField *field;
+    uint16_t columnCount;
+    uint16_t width;
+    uint8_t nameLen;
+    uint32_t offset = 0;
+    uint32_t i;
+
+    for (i = 0; i < topic->fieldCount; i++) {
+        if (topic->fields[i].type == 'x' && topic->fields[i].width == 0) {
+            topic->fields[i].width = sample->dataSize > offset ? sample->dataSize - offset : 1;
+        }
+        offset += topic->fields[i].width;
+    }
+
+    snprintf(filePath, sizeof(filePath), "%s/%s.%s", exportDirPath, topic->name,
+             format == DJI_TEST_FC_RECORD_EXPORT_FORMAT_CSV ? "csv" : "col");
+    topic->file = fopen(filePath, "wb");
+    if (topic->file == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    if (format == DJI_TEST_FC_RECORD_EXPORT_FORMAT_CSV) {
+        fprintf(topic->file, "%s,%s,%s", timeFields[0].name, timeFields[1].name, timeFields[2].name);
+        for (i = 0; i < topic->fieldCount; i++) {
+            fprintf(topic->file, ",%s", topic->fields[i].name);
+        }
+        fprintf(topic->file, "\n");
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    columnCount = DJI_TEST_FC_RECORD_TIME_COLUMN_NUM + topic->fieldCount;
+    fwrite(DJI_TEST_FC_RECORD_COLUMN_MAGIC, 1, strlen(DJI_TEST_FC_RECORD_COLUMN_MAGIC), topic->file);
+    width = DJI_TEST_FC_RECORD_COLUMN_VERSION;
+    fwrite(&width, sizeof(width), 1, topic->file);
+    fwrite(&columnCount, sizeof(columnCount), 1, topic->file);
+    for (i = 0; i < columnCount; i++) {
+        field = i < DJI_TEST_FC_RECORD_TIME_COLUMN_NUM ? &timeFields[i] :
+                &topic->fields[i - DJI_TEST_FC_RECORD_TIME_COLUMN_NUM];
+        nameLen = (uint8_t) strlen(field->name);
+        fputc(field->type, topic->file);
+        fwrite(&field->width, sizeof(field->width), 1, topic->file);
+        fputc(nameLen, topic->file);
+        fwrite(field->name, 1, nameLen, topic->file);
+
+        topic->columns[i] = malloc((size_t) field->width * DJI_TEST_FC_RECORD_COLUMN_GROUP_ROWS);
+        if (topic->columns[i] == NULL) {
+            return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+        }
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+static void DjiTest_FcRecordExportCsvRow(T_DjiTestFcRecordExportTopic *topic, const T_DjiTestFcRecordSample *sample)
+{
+    const T_DjiTestFcRecordField *field;
+    const uint8_t *value;
+    uint32_t offset = 0;
+    uint32_t i;
+    uint32_t k;
+    union {
+        int8_t b;
+        uint8_t B;
+        int16_t h;
+        uint16_t H;
+        int32_t i;
+        uint32_t I;
+        int64_t q;
+        uint64_t Q;
+        float f;
+        double d;
+    } number;
+
+    fprintf(topic->file, "%" PRIu64 ",%u,%u", sample->recvTimeUs, sample->timestamp.millisecond,
+            sample->timestamp.microsecond);
+
+    for (i = 0; i < topic->fieldCount; i++) {
+        field = &topic->fields[i];
+        fputc(',', topic->file);
+        if (offset + field->width > sample->dataSize) {
+            offset += field->width;
+            continue;
+        }
+
+        value = sample->data + offset;
+        offset += field->width;
+        if (field->type == 'x') {
+            for (k = 0; k < field->width; k++) {
+                fprintf(topic->file, "%02x", value[k]);
+            }
+            continue;
+        }
+
+        memcpy(&number, value, field->width);
+        switch (field->type) {
+            case 'b':
+                fprintf(topic->file, "%d", number.b);
+                break;
+            case 'B':
+                fprintf(topic->file, "%u", number.B);
+                break;
+            case 'h':
+                fprintf(topic->file, "%d", number.h);
+                break;
+            case 'H':
+                fprintf(topic->file, "%u", number.H);
+                break;
+            case 'i':
+                fprintf(topic->file, "%" PRId32, number.i);
+                break;
+            case 'I':
+                fprintf(topic->file, "%" PRIu32, number.I);
+                break;
+            case 'q':
+                fprintf(topic->file, "%" PRId64, number.q);
+                break;
+            case 'Q':
+                fprintf(topic->file, "%" PRIu64, number.Q);
+                break;
+            case 'f':
+                fprintf(topic->file, "%.9g", number.f);
+                break;
+            case 'd':
+                fprintf(topic->file, "%.17g", number.d);
+                break;
+            default:
+                break;
+        }
+    }
+    fputc('\n', topic->file);
+}
+
+static void DjiTest_FcRecordExportColumnRow(T_DjiTestFcRecordExportTopic *topic,
+                                            const T_DjiTestFcRecordSample *sample)
+{
+    const T_DjiTestFcRecordField *field;
+    uint32_t row = topic->rowCount;
+    uint32_t offset = 0;
+    uint32_t copyLen;
+    uint32_t i;
+
+    memcpy(topic->columns[0] + row * 8, &sample->recvTimeUs, 8);
+    memcpy(topic->columns[1] + row * 4, &sample->timestamp.millisecond, 4);
+    memcpy(topic->columns[2] + row * 4, &sample->timestamp.microsecond, 4);
+
+    for (i = 0; i < topic->fieldCount; i++) {
+        field = &topic->fields[i];
+        copyLen = offset < sample->dataSize ? sample->dataSize - offset : 0;
+        copyLen = copyLen < field->width ? copyLen : field->width;
+        memcpy(topic->columns[DJI_TEST_FC_RECORD_TIME_COLUMN_NUM + i] + row * field->width, sample->data + offset,
+               copyLen);
+        memset(topic->columns[DJI_TEST_FC_RECORD_TIME_COLUMN_NUM + i] + row * field->width + copyLen, 0,
+               field->width - copyLen);
+        offset += field->width;
+    }
+
+    topic->rowCount++;
+    if (topic->rowCount == DJI_TEST_FC_RECORD_COLUMN_GROUP_ROWS) {
+        DjiTest_FcRecordExportColumnFlush(topic);
+    }
+}
+
+/**
+ * @brief Write the buffered rows as one row group, every column is stored contiguously.
+ */
+static void DjiTest_FcRecordExportColumnFlush(T_DjiTestFcRecordExportTopic *topic)
+{
+    static const uint16_t timeWidths[DJI_TEST_FC_RECORD_TIME_COLUMN_NUM] = {8, 4, 4};
+    uint64_t *groupOffsets;
+    uint16_t width;
+    uint32_t i;
+
+    if (topic->rowCount == 0) {
+        return;
+    }
+
+    groupOffsets = realloc(topic->groupOffsets, (topic->groupCount + 1) * sizeof(uint64_t));
+    if (groupOffsets == NULL) {
+        return;
+    }
+    topic->groupOffsets = groupOffsets;
+    topic->groupOffsets[topic->groupCount++] = (uint64_t) ftell(topic->file);
+
+    fwrite(&topic->rowCount, sizeof(topic->rowCount), 1, topic->file);
+    for (i = 0; i < DJI_TEST_FC_RECORD_TIME_COLUMN_NUM + topic->fieldCount; i++) {
+        width = i < DJI_TEST_FC_RECORD_TIME_COLUMN_NUM ? timeWidths[i] :
+                topic->fields[i - DJI_TEST_FC_RECORD_TIME_COLUMN_NUM].width;
+        fwrite(topic->columns[i], width, topic->rowCount, topic->file);
+    }
+
+    topic->totalRowCount += topic->rowCount;
+    topic->rowCount = 0;
+}
+
+static void DjiTest_FcRecordExportClose(T_DjiTestFcRecordExportTopic *topic, E_DjiTestFcRecordExportFormat format)
+{
+    uint32_t i;
+
+    if (topic->file != NULL && format == DJI_TEST_FC_RECORD_EXPORT_FORMAT_COLUMNAR) {
+        DjiTest_FcRecordExportColumnFlush(topic);
+        fwrite(topic->groupOffsets, sizeof(uint64_t), topic->groupCount, topic->file);
+        fwrite(&topic->groupCount, sizeof(topic->groupCount), 1, topic->file);
+        fwrite(&topic->totalRowCount, sizeof(topic->totalRowCount), 1, topic->file);
+        fwrite(DJI_TEST_FC_RECORD_COLUMN_MAGIC, 1, strlen(DJI_TEST_FC_RECORD_COLUMN_MAGIC), topic->file);
+    }
+
+    if (topic->file != NULL) {
+        fclose(topic->file);
+        topic->file = NULL;
+    }
+    for (i = 0; i < DJI_TEST_FC_RECORD_TIME_COLUMN_NUM + DJI_TEST_FC_RECORD_FIELD_MAX; i++) {
+        free(topic->columns[i]);
+        topic->columns[i] = NULL;
+    }
+    free(topic->groupOffsets);
+    topic->groupOffsets = NULL;
+}
+
+#endif
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
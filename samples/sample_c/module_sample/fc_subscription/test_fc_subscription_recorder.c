@@ -0,0 +1,927 @@
+/**
+ ********************************************************************
+ * @file    test_fc_subscription_recorder.c
+ * @brief   The file defines a black-box recorder of flight controller topics. Samples are taken from the
+ *          subscription callbacks at the subscribed rates, delta encoded into self-contained blocks and written
+ *          to preallocated, append-only segment files through the asynchronous writer.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#ifdef SYSTEM_ARCH_LINUX
+
+#include "test_fc_subscription_recorder.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "dji_platform.h"
+#include "dji_logger.h"
+#include "test_fc_subscription_dispatcher.h"
+#include "utils/util_async_writer.h"
+#include "utils/util_crc.h"
+#include "utils/util_misc.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define DJI_TEST_FC_RECORDER_PATH_LEN_MAX           256
+/* The segment index is printed with at least four digits but may grow to the full width of a uint32_t. */
+#define DJI_TEST_FC_RECORDER_SEGMENT_SUFFIX_MAX     sizeof("_4294967295" DJI_TEST_FC_RECORD_FILE_EXTENSION)
+#define DJI_TEST_FC_RECORDER_FILE_PATH_LEN_MAX      \
+    (DJI_TEST_FC_RECORDER_PATH_LEN_MAX + DJI_TEST_FC_RECORDER_SEGMENT_SUFFIX_MAX)
+#define DJI_TEST_FC_RECORDER_WRITER_BUFFER_SIZE     (256 * 1024)
+#define DJI_TEST_FC_RECORDER_INDEX_INIT_CAPACITY    256
+/* Upper bound of one encoded sample: topic index, three 64-bit varints, the size varint and the runs. */
+#define DJI_TEST_FC_RECORDER_SAMPLE_ENCODED_MAX     \
+    (1 + 3 * 10 + 3 + DJI_TEST_FC_RECORD_DATA_MAX + DJI_TEST_FC_RECORD_DATA_MAX / 128 + 1)
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    E_DjiFcSubscriptionTopic topic;
+    uint16_t dataSize;
+    const char *layout;
+} T_DjiTestFcRecordTopicLayout;
+
+typedef struct tagT_DjiTestFcRecorderTopic {
+    struct tagT_DjiTestFcRecorder *recorder;
+    uint32_t index;
+    E_DjiFcSubscriptionTopic topic;
+    E_DjiDataSubscriptionTopicFreq frequency;
+    T_DjiTestFcSubscriptionConsumerHandle consumer;
+    /*! Previous sample of the current block, 0 when the topic has no sample in the block yet. */
+    uint16_t lastDataSize;
+    uint32_t lastMillisecond;
+    uint32_t lastMicrosecond;
+    uint8_t lastData[DJI_TEST_FC_RECORD_DATA_MAX];
+} T_DjiTestFcRecorderTopic;
+
+typedef struct tagT_DjiTestFcRecorder {
+    char pathPrefix[DJI_TEST_FC_RECORDER_PATH_LEN_MAX];
+    T_DjiTestFcRecorderConfig config;
+    T_DjiTestFcRecorderTopic topics[DJI_TEST_FC_RECORD_TOPIC_MAX];
+    uint32_t topicCount;
+    T_DjiMutexHandle mutex;
+    uint64_t startTimeUs;
+    uint8_t *schema;
+    uint32_t schemaSize;
+
+    T_UtilAsyncWriterHandle writer;
+    uint32_t segmentIndex;
+    /*! Next segment, opened ahead by the rotate task once the current one is half full. */
+    T_UtilAsyncWriterHandle nextWriter;
+    uint32_t nextSegmentIndex;
+    char nextFilePath[DJI_TEST_FC_RECORDER_FILE_PATH_LEN_MAX];
+    bool isNextWriterRequested;
+    /*! Finished segment waiting for the rotate task to close it. */
+    T_UtilAsyncWriterHandle retiredWriter;
+    pthread_t rotateTask;
+    bool isRotateTaskCreated;
+    bool rotateStopRequest;
+    T_DjiSemaHandle rotateSema;
+    uint64_t segmentBytes;
+    T_DjiTestFcRecordIndexEntry *index;
+    uint32_t indexCount;
+    uint32_t indexCapacity;
+
+    uint8_t *block;
+    uint32_t blockLen;
+    uint32_t blockSampleCount;
+    uint64_t blockFirstTimeUs;
+    uint64_t blockLastTimeUs;
+
+    T_DjiTestFcRecorderStatistics statistics;
+} T_DjiTestFcRecorder;
+
+/* Private functions declaration ---------------------------------------------*/
+static void DjiTest_FcRecorderUpdate(const uint8_t *data, uint16_t dataSize, const T_DjiDataTimestamp *timestamp,
+                                     void *userData);
+static T_DjiReturnCode DjiTest_FcRecorderBuildSchema(T_DjiTestFcRecorder *recorder);
+static T_DjiReturnCode DjiTest_FcRecorderOpenWriter(T_DjiTestFcRecorder *recorder, uint32_t *segmentIndex,
+                                                    char *filePath, T_UtilAsyncWriterHandle *writer);
+static T_DjiReturnCode DjiTest_FcRecorderCloseWriter(T_DjiTestFcRecorder *recorder, T_UtilAsyncWriterHandle writer);
+static T_DjiReturnCode DjiTest_FcRecorderBeginSegment(T_DjiTestFcRecorder *recorder);
+static void DjiTest_FcRecorderEndSegment(T_DjiTestFcRecorder *recorder);
+static T_DjiReturnCode DjiTest_FcRecorderSwitchSegment(T_DjiTestFcRecorder *recorder);
+static void *DjiTest_FcRecorderRotateTask(void *arg);
+static void DjiTest_FcRecorderStopRotateTask(T_DjiTestFcRecorder *recorder);
+static T_DjiReturnCode DjiTest_FcRecorderFlushBlock(T_DjiTestFcRecorder *recorder);
+static T_DjiReturnCode DjiTest_FcRecorderWrite(T_DjiTestFcRecorder *recorder, const void *data, uint32_t len);
+static void DjiTest_FcRecorderFree(T_DjiTestFcRecorder *recorder);
+static uint32_t DjiTest_FcRecorderPutVarint(uint8_t *out, uint64_t value);
+static uint32_t DjiTest_FcRecorderPutRuns(uint8_t *out, const uint8_t *data, const uint8_t *previous, uint16_t len);
+static uint64_t DjiTest_FcRecorderZigzag(int64_t value);
+
+/* Private values -------------------------------------------------------------*/
+/* DJI_FC_SUBSCRIPTION_TOPIC_IMU_ATTI_NAVI_DATA_WITH_TIMESTAMP shares its value with the gimbal angles on
+ * position NO.1, so that topic is recorded as raw bytes. */
+static const T_DjiTestFcRecordTopicLayout s_topicLayouts[] = {
+    {DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION,           sizeof(T_DjiFcSubscriptionQuaternion),
+        "quaternion;q0:f,q1:f,q2:f,q3:f"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_ACCELERATION_GROUND,  sizeof(T_DjiFcSubscriptionAccelerationGround),
+        "acceleration_ground;x:f,y:f,z:f"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_ACCELERATION_BODY,    sizeof(T_DjiFcSubscriptionAccelerationBody),
+        "acceleration_body;x:f,y:f,z:f"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_ACCELERATION_RAW,     sizeof(T_DjiFcSubscriptionAccelerationRaw),
+        "acceleration_raw;x:f,y:f,z:f"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY,             sizeof(T_DjiFcSubscriptionVelocity),
+        "velocity;x:f,y:f,z:f,health:B"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_ANGULAR_RATE_FUSIONED, sizeof(T_DjiFcSubscriptionAngularRateFusioned),
+        "angular_rate_fusioned;x:f,y:f,z:f"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_ANGULAR_RATE_RAW,     sizeof(T_DjiFcSubscriptionAngularRateRaw),
+        "angular_rate_raw;x:f,y:f,z:f"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_ALTITUDE_FUSED,       sizeof(T_DjiFcSubscriptionAltitudeFused),
+        "altitude_fused;altitude:f"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_ALTITUDE_BAROMETER,   sizeof(T_DjiFcSubscriptionAltitudeBarometer),
+        "altitude_barometer;altitude:f"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_ALTITUDE_OF_HOMEPOINT, sizeof(T_DjiFcSubscriptionAltitudeOfHomePoint),
+        "altitude_of_homepoint;altitude:f"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_HEIGHT_FUSION,        sizeof(T_DjiFcSubscriptionHeightFusion),
+        "height_fusion;height:f"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_HEIGHT_RELATIVE,      sizeof(T_DjiFcSubscriptionHeightRelative),
+        "height_relative;height:f"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_POSITION_FUSED,       sizeof(T_DjiFcSubscriptionPositionFused),
+        "position_fused;longitude:d,latitude:d,altitude:f,visibleSatelliteNumber:H"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_GPS_DATE,             sizeof(T_DjiFcSubscriptionGpsDate),
+        "gps_date;date:I"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_GPS_TIME,             sizeof(T_DjiFcSubscriptionGpsTime),
+        "gps_time;time:I"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_GPS_POSITION,         sizeof(T_DjiFcSubscriptionGpsPosition),
+        "gps_position;x:i,y:i,z:i"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_GPS_VELOCITY,         sizeof(T_DjiFcSubscriptionGpsVelocity),
+        "gps_velocity;x:f,y:f,z:f"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_GPS_DETAILS,          sizeof(T_DjiFcSubscriptionGpsDetails),
+        "gps_details;hdop:f,pdop:f,fixState:f,vacc:f,hacc:f,sacc:f,gpsSatelliteNumberUsed:I,"
+        "glonassSatelliteNumberUsed:I,totalSatelliteNumberUsed:H,gpsCounter:H"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_GPS_SIGNAL_LEVEL,     sizeof(T_DjiFcSubscriptionGpsSignalLevel),
+        "gps_signal_level;level:B"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_RTK_POSITION,         sizeof(T_DjiFcSubscriptionRtkPosition),
+        "rtk_position;longitude:d,latitude:d,hfsl:f"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_RTK_VELOCITY,         sizeof(T_DjiFcSubscriptionRtkVelocity),
+        "rtk_velocity;x:f,y:f,z:f"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_RTK_YAW,              sizeof(T_DjiFcSubscriptionRtkYaw),
+        "rtk_yaw;yaw:h"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_RTK_POSITION_INFO,    sizeof(T_DjiFcSubscriptionRtkPositionInfo),
+        "rtk_position_info;info:B"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_RTK_YAW_INFO,         sizeof(T_DjiFcSubscriptionRtkYawInfo),
+        "rtk_yaw_info;info:B"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_COMPASS,              sizeof(T_DjiFcSubscriptionCompass),
+        "compass;x:h,y:h,z:h"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_RC,                   sizeof(T_DjiFcSubscriptionRC),
+        "rc;roll:h,pitch:h,yaw:h,throttle:h,mode:h,gear:h"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_GIMBAL_ANGLES,        sizeof(T_DjiFcSubscriptionGimbalAngles),
+        "gimbal_angles;pitch:f,roll:f,yaw:f"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_GIMBAL_STATUS,        sizeof(T_DjiFcSubscriptionGimbalStatus),
+        "gimbal_status;status:I"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_STATUS_FLIGHT,        sizeof(T_DjiFcSubscriptionFlightStatus),
+        "status_flight;status:B"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_STATUS_DISPLAYMODE,   sizeof(T_DjiFcSubscriptionDisplaymode),
+        "status_displaymode;mode:B"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_STATUS_LANDINGGEAR,   sizeof(T_DjiFcSubscriptionLandinggear),
+        "status_landinggear;status:B"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_STATUS_MOTOR_START_ERROR, sizeof(T_DjiFcSubscriptionMotorStartError),
+        "status_motor_start_error;error:H"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_BATTERY_INFO,         sizeof(T_DjiFcSubscriptionWholeBatteryInfo),
+        "battery_info;capacity:I,voltage:i,current:i,percentage:B"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_CONTROL_DEVICE,       sizeof(T_DjiFcSubscriptionControlDevice),
+        "control_device;controlMode:B,status:B"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_HARD_SYNC,            sizeof(T_DjiFcSubscriptionHardSync),
+        "hard_sync;time2p5ms:I,time1ns:I,resetTime2p5ms:I,index:H,flag:B,q0:f,q1:f,q2:f,q3:f,"
+        "ax:f,ay:f,az:f,wx:f,wy:f,wz:f"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_GPS_CONTROL_LEVEL,    sizeof(T_DjiFcSubscriptionGpsControlLevel),
+        "gps_control_level;level:B"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_RC_WITH_FLAG_DATA,    sizeof(T_DjiFcSubscriptionRCWithFlagData),
+        "rc_with_flag_data;pitch:f,roll:f,yaw:f,throttle:f,flag:B"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_ESC_DATA,             sizeof(T_DjiFcSubscriptionEscData),
+        "esc_data;current0:h,speed0:h,voltage0:H,temperature0:h,status0:H,"
+        "current1:h,speed1:h,voltage1:H,temperature1:h,status1:H,"
+        "current2:h,speed2:h,voltage2:H,temperature2:h,status2:H,"
+        "current3:h,speed3:h,voltage3:H,temperature3:h,status3:H,"
+        "current4:h,speed4:h,voltage4:H,temperature4:h,status4:H,"
+        "current5:h,speed5:h,voltage5:H,temperature5:h,status5:H,"
+        "current6:h,speed6:h,voltage6:H,temperature6:h,status6:H,"
+        "current7:h,speed7:h,voltage7:H,temperature7:h,status7:H"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_RTK_CONNECT_STATUS,   sizeof(T_DjiFcSubscriptionRTKConnectStatus),
+        "rtk_connect_status;status:H"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_GIMBAL_CONTROL_MODE,  sizeof(T_DjiFcSubscriptionGimbalControlMode),
+        "gimbal_control_mode;mode:B"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_FLIGHT_ANOMALY,       sizeof(T_DjiFcSubscriptionFlightAnomaly),
+        "flight_anomaly;flags:I"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_POSITION_VO,          sizeof(T_DjiFcSubscriptionPositionVO),
+        "position_vo;x:f,y:f,z:f,health:B"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_AVOID_DATA,           sizeof(T_DjiFcSubscriptionAvoidData),
+        "avoid_data;down:f,front:f,right:f,back:f,left:f,up:f,health:B"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_HOME_POINT_SET_STATUS, sizeof(T_DjiFcSubscriptionHomePointSetStatus),
+        "home_point_set_status;status:B"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_HOME_POINT_INFO,      sizeof(T_DjiFcSubscriptionHomePointInfo),
+        "home_point_info;latitude:d,longitude:d"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_THREE_GIMBAL_DATA,    sizeof(T_DjiFcSubscriptionThreeGimbalData),
+        "three_gimbal_data;roll0:f,pitch0:f,yaw0:f,roll1:f,pitch1:f,yaw1:f,roll2:f,pitch2:f,yaw2:f"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_BATTERY_SINGLE_INFO_INDEX1, sizeof(T_DjiFcSubscriptionSingleBatteryInfo),
+        "battery_single_info_index1;reserve:B,batteryIndex:B,currentVoltage:i,currentElectric:i,fullCapacity:I,"
+        "remainedCapacity:I,batteryTemperature:h,cellCount:B,batteryCapacityPercent:B,batteryState:x8,"
+        "reserve1:B,reserve2:B,SOP:B"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_BATTERY_SINGLE_INFO_INDEX2, sizeof(T_DjiFcSubscriptionSingleBatteryInfo),
+        "battery_single_info_index2;reserve:B,batteryIndex:B,currentVoltage:i,currentElectric:i,fullCapacity:I,"
+        "remainedCapacity:I,batteryTemperature:h,cellCount:B,batteryCapacityPercent:B,batteryState:x8,"
+        "reserve1:B,reserve2:B,SOP:B"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_GIMBAL_ANGLES_ON_POS_NO2, sizeof(T_DjiFcSubscriptionGimbalAngles),
+        "gimbal_angles_on_pos_no2;pitch:f,roll:f,yaw:f"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_GIMBAL_ANGLES_ON_POS_NO3, sizeof(T_DjiFcSubscriptionGimbalAngles),
+        "gimbal_angles_on_pos_no3;pitch:f,roll:f,yaw:f"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_GIMBAL_ANGLES_ON_POS_NO4, sizeof(T_DjiFcSubscriptionGimbalAngles),
+        "gimbal_angles_on_pos_no4;pitch:f,roll:f,yaw:f"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_GIMBAL_ANGLES_ON_POS_NO5, sizeof(T_DjiFcSubscriptionGimbalAngles),
+        "gimbal_angles_on_pos_no5;pitch:f,roll:f,yaw:f"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_GIMBAL_ANGLES_ON_POS_NO6, sizeof(T_DjiFcSubscriptionGimbalAngles),
+        "gimbal_angles_on_pos_no6;pitch:f,roll:f,yaw:f"},
+    {DJI_FC_SUBSCRIPTION_TOPIC_GIMBAL_ANGLES_ON_POS_NO7, sizeof(T_DjiFcSubscriptionGimbalAngles),
+        "gimbal_angles_on_pos_no7;pitch:f,roll:f,yaw:f"},
+};
+
+/* Exported functions definition ---------------------------------------------*/
+void DjiTest_FcRecorderGetDefaultConfig(T_DjiTestFcRecorderConfig *config)
+{
+    config->blockSize = DJI_TEST_FC_RECORDER_DEFAULT_BLOCK_SIZE;
+    config->blockIntervalMs = DJI_TEST_FC_RECORDER_DEFAULT_BLOCK_INTERVAL_MS;
+    config->segmentSize = DJI_TEST_FC_RECORDER_DEFAULT_SEGMENT_SIZE;
+}
+
+/**
+ * @brief Register the topics with the subscription dispatcher and record them to "<pathPrefix>_0000.fcr",
+ * "<pathPrefix>_0001.fcr", ... Existing segments are kept, numbering continues at the first index without a file.
+ * @note Recorders with different path prefixes may run at the same time. config may be NULL to use the default
+ * config.
+ */
+T_DjiReturnCode DjiTest_FcRecorderStart(const char *pathPrefix, const T_DjiTestFcRecorderTopicConfig *topics,
+                                        uint32_t topicCount, const T_DjiTestFcRecorderConfig *config,
+                                        T_DjiTestFcRecorderHandle *recorderHandle)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestFcRecorder *recorder;
+    char filePath[DJI_TEST_FC_RECORDER_FILE_PATH_LEN_MAX];
+    T_DjiReturnCode returnCode;
+    uint32_t i;
+
+    if (pathPrefix == NULL || topics == NULL || topicCount == 0 || topicCount > DJI_TEST_FC_RECORD_TOPIC_MAX ||
+        strlen(pathPrefix) + sizeof("_0000" DJI_TEST_FC_RECORD_FILE_EXTENSION) > DJI_TEST_FC_RECORDER_PATH_LEN_MAX ||
+        recorderHandle == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    recorder = osalHandler->Malloc(sizeof(T_DjiTestFcRecorder));
+    if (recorder == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+    memset(recorder, 0, sizeof(T_DjiTestFcRecorder));
+
+    strcpy(recorder->pathPrefix, pathPrefix);
+    if (config != NULL) {
+        recorder->config = *config;
+    } else {
+        DjiTest_FcRecorderGetDefaultConfig(&recorder->config);
+    }
+    recorder->topicCount = topicCount;
+    for (i = 0; i < topicCount; i++) {
+        recorder->topics[i].recorder = recorder;
+        recorder->topics[i].index = i;
+        recorder->topics[i].topic = topics[i].topic;
+        recorder->topics[i].frequency = topics[i].frequency;
+    }
+    osalHandler->GetTimeUs(&recorder->startTimeUs);
+
+    recorder->block = osalHandler->Malloc(recorder->config.blockSize + DJI_TEST_FC_RECORDER_SAMPLE_ENCODED_MAX);
+    recorder->index = osalHandler->Malloc(DJI_TEST_FC_RECORDER_INDEX_INIT_CAPACITY *
+                                          sizeof(T_DjiTestFcRecordIndexEntry));
+    recorder->indexCapacity = DJI_TEST_FC_RECORDER_INDEX_INIT_CAPACITY;
+    if (recorder->block == NULL || recorder->index == NULL) {
+        DjiTest_FcRecorderFree(recorder);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+
+    returnCode = DjiTest_FcRecorderBuildSchema(recorder);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        DjiTest_FcRecorderFree(recorder);
+        return returnCode;
+    }
+
+    returnCode = osalHandler->MutexCreate(&recorder->mutex);
+    if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        returnCode = osalHandler->SemaphoreCreate(0, &recorder->rotateSema);
+    }
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        DjiTest_FcRecorderFree(recorder);
+        return returnCode;
+    }
+
+    returnCode = DjiTest_FcRecorderOpenWriter(recorder, &recorder->segmentIndex, filePath, &recorder->writer);
+    if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        returnCode = DjiTest_FcRecorderBeginSegment(recorder);
+    }
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        DjiTest_FcRecorderFree(recorder);
+        return returnCode;
+    }
+
+    //a joinable thread, so stopping waits until the last segment handed over is closed
+    if (pthread_create(&recorder->rotateTask, NULL, DjiTest_FcRecorderRotateTask, recorder) != 0) {
+        DjiTest_FcRecorderFree(recorder);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+    recorder->isRotateTaskCreated = true;
+    pthread_setname_np(recorder->rotateTask, "fc_rec_rotate");
+
+    for (i = 0; i < topicCount; i++) {
+        returnCode = DjiTest_FcSubscriptionDispatcherRegister(recorder->topics[i].topic,
+                                                              recorder->topics[i].frequency,
+                                                              DjiTest_FcRecorderUpdate, &recorder->topics[i],
+                                                              &recorder->topics[i].consumer);
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            USER_LOG_ERROR("Subscribe topic 0x%08X for recording failed, error code: 0x%08llX.",
+                           recorder->topics[i].topic, returnCode);
+            DjiTest_FcRecorderStop(recorder);
+            return returnCode;
+        }
+    }
+
+    *recorderHandle = recorder;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Unregister the topics, write the pending block and close the current segment with its index.
+ */
+T_DjiReturnCode DjiTest_FcRecorderStop(T_DjiTestFcRecorderHandle recorderHandle)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestFcRecorder *recorder = recorderHandle;
+    T_DjiReturnCode returnCode;
+    uint32_t i;
+
+    if (recorder == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    //unregistering waits for a callback in progress, no sample touches the recorder after this loop
+    for (i = 0; i < recorder->topicCount; i++) {
+        if (recorder->topics[i].consumer != NULL &&
+            DjiTest_FcSubscriptionDispatcherUnregister(recorder->topics[i].consumer) !=
+            DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            USER_LOG_WARN("Unsubscribe topic 0x%08X failed.", recorder->topics[i].topic);
+        }
+        recorder->topics[i].consumer = NULL;
+    }
+
+    osalHandler->MutexLock(recorder->mutex);
+    returnCode = DjiTest_FcRecorderFlushBlock(recorder);
+    DjiTest_FcRecorderEndSegment(recorder);
+    osalHandler->MutexUnlock(recorder->mutex);
+
+    DjiTest_FcRecorderStopRotateTask(recorder);
+    if (DjiTest_FcRecorderCloseWriter(recorder, recorder->writer) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+    recorder->writer = NULL;
+
+    USER_LOG_INFO("Flight data recorder stopped, samples: %llu, raw bytes: %llu, encoded bytes: %llu, "
+                  "segments: %u.", recorder->statistics.sampleCount, recorder->statistics.rawBytes,
+                  recorder->statistics.encodedBytes, recorder->statistics.segmentCount);
+    DjiTest_FcRecorderFree(recorder);
+
+    return returnCode;
+}
+
+void DjiTest_FcRecorderGetStatistics(T_DjiTestFcRecorderHandle recorderHandle,
+                                     T_DjiTestFcRecorderStatistics *statistics)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestFcRecorder *recorder = recorderHandle;
+
+    if (recorder == NULL || statistics == NULL) {
+        return;
+    }
+
+    osalHandler->MutexLock(recorder->mutex);
+    *statistics = recorder->statistics;
+    osalHandler->MutexUnlock(recorder->mutex);
+}
+
+/**
+ * @brief Get the layout text and data size of a topic, NULL for topics without a known layout.
+ */
+const char *DjiTest_FcRecordGetTopicLayout(E_DjiFcSubscriptionTopic topic, uint16_t *dataSize)
+{
+    uint32_t i;
+
+    for (i = 0; i < UTIL_ARRAY_SIZE(s_topicLayouts); i++) {
+        if (s_topicLayouts[i].topic == topic) {
+            if (dataSize != NULL) {
+                *dataSize = s_topicLayouts[i].dataSize;
+            }
+            return s_topicLayouts[i].layout;
+        }
+    }
+
+    return NULL;
+}
+
+/* Private functions definition-----------------------------------------------*/
+/**
+ * @brief Encode one sample into the current block, the block is written once it is full or old enough.
+ */
+static void DjiTest_FcRecorderUpdate(const uint8_t *data, uint16_t dataSize, const T_DjiDataTimestamp *timestamp,
+                                     void *userData)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestFcRecorderTopic *topic = (T_DjiTestFcRecorderTopic *) userData;
+    T_DjiTestFcRecorder *recorder = topic->recorder;
+    T_DjiDataTimestamp sampleTimestamp = {0};
+    uint64_t recvTimeUs = 0;
+    uint8_t *out;
+    uint32_t i;
+
+    osalHandler->GetTimeUs(&recvTimeUs);
+    if (timestamp != NULL) {
+        sampleTimestamp = *timestamp;
+    }
+
+    osalHandler->MutexLock(recorder->mutex);
+    if (data == NULL || dataSize > DJI_TEST_FC_RECORD_DATA_MAX) {
+        recorder->statistics.invalidSampleCount++;
+        osalHandler->MutexUnlock(recorder->mutex);
+        return;
+    }
+
+    if (recorder->blockSampleCount == 0) {
+        for (i = 0; i < recorder->topicCount; i++) {
+            recorder->topics[i].lastDataSize = 0;
+            recorder->topics[i].lastMillisecond = 0;
+            recorder->topics[i].lastMicrosecond = 0;
+        }
+        recorder->blockFirstTimeUs = recvTimeUs;
+        recorder->blockLastTimeUs = recvTimeUs;
+    }
+
+    out = recorder->block + recorder->blockLen;
+    *out++ = (uint8_t) topic->index;
+    out += DjiTest_FcRecorderPutVarint(out, DjiTest_FcRecorderZigzag(
+        (int64_t) (recvTimeUs - recorder->blockLastTimeUs)));
+    out += DjiTest_FcRecorderPutVarint(out, DjiTest_FcRecorderZigzag(
+        (int64_t) sampleTimestamp.millisecond - (int64_t) topic->lastMillisecond));
+    out += DjiTest_FcRecorderPutVarint(out, DjiTest_FcRecorderZigzag(
+        (int64_t) sampleTimestamp.microsecond - (int64_t) topic->lastMicrosecond));
+    out += DjiTest_FcRecorderPutVarint(out, dataSize);
+    out += DjiTest_FcRecorderPutRuns(out, data, topic->lastDataSize == dataSize ? topic->lastData : NULL, dataSize);
+    recorder->blockLen = out - recorder->block;
+
+    memcpy(topic->lastData, data, dataSize);
+    topic->lastDataSize = dataSize;
+    topic->lastMillisecond = sampleTimestamp.millisecond;
+    topic->lastMicrosecond = sampleTimestamp.microsecond;
+    recorder->blockLastTimeUs = recvTimeUs;
+    recorder->blockSampleCount++;
+    recorder->statistics.sampleCount++;
+    recorder->statistics.rawBytes += dataSize + sizeof(recvTimeUs) + sizeof(T_DjiDataTimestamp);
+
+    if (recorder->blockLen >= recorder->config.blockSize ||
+        recvTimeUs - recorder->blockFirstTimeUs >= (uint64_t) recorder->config.blockIntervalMs * 1000) {
+        DjiTest_FcRecorderFlushBlock(recorder);
+    }
+    osalHandler->MutexUnlock(recorder->mutex);
+}
+
+static T_DjiReturnCode DjiTest_FcRecorderBuildSchema(T_DjiTestFcRecorder *recorder)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestFcRecordSchemaEntry schemaEntry;
+    char rawLayout[32];
+    const char *layout;
+    uint16_t dataSize;
+    uint32_t offset = 0;
+    uint32_t i;
+
+    recorder->schema = osalHandler->Malloc(recorder->topicCount *
+                                           (sizeof(T_DjiTestFcRecordSchemaEntry) + DJI_TEST_FC_RECORD_LAYOUT_MAX));
+    if (recorder->schema == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+
+    for (i = 0; i < recorder->topicCount; i++) {
+        dataSize = 0;
+        layout = DjiTest_FcRecordGetTopicLayout(recorder->topics[i].topic, &dataSize);
+        if (layout == NULL) {
+            snprintf(rawLayout, sizeof(rawLayout), "topic_%u;data:x",
+                     DJI_DATA_SUBSCRIPTION_TOPIC_GET_CODE(recorder->topics[i].topic));
+            layout = rawLayout;
+        }
+
+        schemaEntry.topic = recorder->topics[i].topic;
+        schemaEntry.frequency = recorder->topics[i].frequency;
+        schemaEntry.dataSize = dataSize;
+        schemaEntry.layoutLength = strlen(layout);
+        memcpy(recorder->schema + offset, &schemaEntry, sizeof(schemaEntry));
+        offset += sizeof(schemaEntry);
+        memcpy(recorder->schema + offset, layout, schemaEntry.layoutLength);
+        offset += schemaEntry.layoutLength;
+    }
+    recorder->schemaSize = offset;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Open a segment file at the first free index from *segmentIndex on, it is preallocated to the segment
+ * size. filePath receives the path and must hold DJI_TEST_FC_RECORDER_FILE_PATH_LEN_MAX bytes.
+ */
+static T_DjiReturnCode DjiTest_FcRecorderOpenWriter(T_DjiTestFcRecorder *recorder, uint32_t *segmentIndex,
+                                                    char *filePath, T_UtilAsyncWriterHandle *writer)
+{
+    T_UtilAsyncWriterConfig writerConfig;
+    T_DjiReturnCode returnCode;
+    int pathLen;
+
+    //segments of an earlier recording with the same prefix are skipped rather than appended to or overwritten
+    while (1) {
+        pathLen = snprintf(filePath, DJI_TEST_FC_RECORDER_FILE_PATH_LEN_MAX,
+                           "%s_%04u" DJI_TEST_FC_RECORD_FILE_EXTENSION, recorder->pathPrefix, *segmentIndex);
+        if (pathLen < 0 || pathLen >= (int) DJI_TEST_FC_RECORDER_FILE_PATH_LEN_MAX) {
+            USER_LOG_ERROR("Flight data record path of segment %u is too long.", *segmentIndex);
+            return DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
+        }
+        if (access(filePath, F_OK) != 0) {
+            break;
+        }
+        (*segmentIndex)++;
+    }
+
+    UtilAsyncWriter_GetDefaultConfig(&writerConfig);
+    writerConfig.bufferSize = DJI_TEST_FC_RECORDER_WRITER_BUFFER_SIZE;
+    writerConfig.preallocateSize = recorder->config.segmentSize;
+    returnCode = UtilAsyncWriter_Open(filePath, &writerConfig, writer);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Open flight data record %s failed, error code: 0x%08llX.", filePath, returnCode);
+        *writer = NULL;
+    }
+
+    return returnCode;
+}
+
+/**
+ * @brief Close a segment file, the recorder mutex must not be held as this waits for the data to be synced.
+ */
+static T_DjiReturnCode DjiTest_FcRecorderCloseWriter(T_DjiTestFcRecorder *recorder, T_UtilAsyncWriterHandle writer)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_UtilAsyncWriterStatistics writerStatistics;
+    T_DjiReturnCode returnCode;
+
+    if (writer == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    UtilAsyncWriter_GetStatistics(writer, &writerStatistics);
+    returnCode = UtilAsyncWriter_Close(writer);
+
+    osalHandler->MutexLock(recorder->mutex);
+    recorder->statistics.writerWaitCount += writerStatistics.producerWaitCount;
+    osalHandler->MutexUnlock(recorder->mutex);
+
+    return returnCode;
+}
+
+/**
+ * @brief Write the record header and schema at the start of the current segment.
+ */
+static T_DjiReturnCode DjiTest_FcRecorderBeginSegment(T_DjiTestFcRecorder *recorder)
+{
+    T_DjiTestFcRecordHeader recordHeader = {0};
+    T_DjiReturnCode returnCode;
+
+    memcpy(recordHeader.magic, DJI_TEST_FC_RECORD_MAGIC, DJI_TEST_FC_RECORD_MAGIC_SIZE);
+    recordHeader.version = DJI_TEST_FC_RECORD_VERSION;
+    recordHeader.headerSize = sizeof(T_DjiTestFcRecordHeader);
+    recordHeader.blockHeaderSize = sizeof(T_DjiTestFcRecordBlockHeader);
+    recordHeader.topicCount = recorder->topicCount;
+    recordHeader.segmentIndex = recorder->segmentIndex;
+    recordHeader.schemaSize = recorder->schemaSize;
+    recordHeader.startTimeUs = recorder->startTimeUs;
+    recordHeader.schemaCrc = UtilCrc_Crc32(0, recorder->schema, recorder->schemaSize);
+    recordHeader.headerCrc = UtilCrc_Crc32(0, (const uint8_t *) &recordHeader,
+                                           sizeof(recordHeader) - sizeof(recordHeader.headerCrc));
+
+    recorder->segmentBytes = 0;
+    recorder->indexCount = 0;
+    recorder->statistics.segmentCount++;
+    returnCode = DjiTest_FcRecorderWrite(recorder, &recordHeader, sizeof(recordHeader));
+    if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        returnCode = DjiTest_FcRecorderWrite(recorder, recorder->schema, recorder->schemaSize);
+    }
+
+    return returnCode;
+}
+
+/**
+ * @brief Write the block index and footer at the end of the current segment, the file is left open.
+ */
+static void DjiTest_FcRecorderEndSegment(T_DjiTestFcRecorder *recorder)
+{
+    T_DjiTestFcRecordFooter footer = {0};
+
+    if (recorder->writer == NULL) {
+        return;
+    }
+
+    footer.magic = DJI_TEST_FC_RECORD_INDEX_MAGIC;
+    footer.blockCount = recorder->indexCount;
+    footer.indexOffset = recorder->segmentBytes;
+    footer.indexCrc = UtilCrc_Crc32(0, (const uint8_t *) recorder->index,
+                                    recorder->indexCount * sizeof(T_DjiTestFcRecordIndexEntry));
+    footer.footerCrc = UtilCrc_Crc32(0, (const uint8_t *) &footer, sizeof(footer) - sizeof(footer.footerCrc));
+
+    DjiTest_FcRecorderWrite(recorder, recorder->index, recorder->indexCount * sizeof(T_DjiTestFcRecordIndexEntry));
+    DjiTest_FcRecorderWrite(recorder, &footer, sizeof(footer));
+}
+
+/**
+ * @brief Continue in the segment opened ahead and hand the finished one to the rotate task for closing.
+ */
+static T_DjiReturnCode DjiTest_FcRecorderSwitchSegment(T_DjiTestFcRecorder *recorder)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    DjiTest_FcRecorderEndSegment(recorder);
+    //the rotate task closes the retired segment before it opens the next one, so the slot is always free here
+    recorder->retiredWriter = recorder->writer;
+    recorder->writer = recorder->nextWriter;
+    recorder->segmentIndex = recorder->nextSegmentIndex;
+    recorder->nextWriter = NULL;
+    osalHandler->SemaphorePost(recorder->rotateSema);
+
+    return DjiTest_FcRecorderBeginSegment(recorder);
+}
+
+/**
+ * @brief Open and close segment files away from the subscription callbacks, file creation, preallocation and
+ * the final sync can take many milliseconds.
+ */
+static void *DjiTest_FcRecorderRotateTask(void *arg)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestFcRecorder *recorder = (T_DjiTestFcRecorder *) arg;
+    T_UtilAsyncWriterHandle retiredWriter;
+    T_UtilAsyncWriterHandle nextWriter;
+    char filePath[DJI_TEST_FC_RECORDER_FILE_PATH_LEN_MAX];
+    uint32_t segmentIndex;
+    bool isNextWriterRequested;
+    bool stopRequest = false;
+
+    while (!stopRequest) {
+        osalHandler->SemaphoreWait(recorder->rotateSema);
+
+        osalHandler->MutexLock(recorder->mutex);
+        retiredWriter = recorder->retiredWriter;
+        recorder->retiredWriter = NULL;
+        isNextWriterRequested = recorder->isNextWriterRequested && recorder->nextWriter == NULL;
+        segmentIndex = recorder->segmentIndex + 1;
+        stopRequest = recorder->rotateStopRequest;
+        osalHandler->MutexUnlock(recorder->mutex);
+
+        if (DjiTest_FcRecorderCloseWriter(recorder, retiredWriter) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            USER_LOG_ERROR("Close flight data record segment failed.");
+        }
+        if (stopRequest || !isNextWriterRequested) {
+            continue;
+        }
+
+        //on failure the request is dropped, the current segment grows and the open is retried at the next block
+        nextWriter = NULL;
+        DjiTest_FcRecorderOpenWriter(recorder, &segmentIndex, filePath, &nextWriter);
+        osalHandler->MutexLock(recorder->mutex);
+        recorder->nextWriter = nextWriter;
+        recorder->nextSegmentIndex = segmentIndex;
+        strcpy(recorder->nextFilePath, filePath);
+        recorder->isNextWriterRequested = false;
+        osalHandler->MutexUnlock(recorder->mutex);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Wait for the rotate task to close the retired segment and remove the segment opened ahead but unused.
+ */
+static void DjiTest_FcRecorderStopRotateTask(T_DjiTestFcRecorder *recorder)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    if (!recorder->isRotateTaskCreated) {
+        return;
+    }
+
+    osalHandler->MutexLock(recorder->mutex);
+    recorder->rotateStopRequest = true;
+    osalHandler->MutexUnlock(recorder->mutex);
+    osalHandler->SemaphorePost(recorder->rotateSema);
+    pthread_join(recorder->rotateTask, NULL);
+    recorder->isRotateTaskCreated = false;
+
+    if (recorder->nextWriter != NULL) {
+        UtilAsyncWriter_Close(recorder->nextWriter);
+        recorder->nextWriter = NULL;
+        remove(recorder->nextFilePath);
+    }
+}
+
+/**
+ * @brief Write the current block and index it, a new segment is started once the segment is full.
+ */
+static T_DjiReturnCode DjiTest_FcRecorderFlushBlock(T_DjiTestFcRecorder *recorder)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestFcRecordBlockHeader blockHeader = {0};
+    T_DjiTestFcRecordIndexEntry *index;
+    T_DjiReturnCode returnCode;
+
+    if (recorder->blockSampleCount == 0 || recorder->writer == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    if (recorder->indexCount == recorder->indexCapacity) {
+        index = osalHandler->Malloc(recorder->indexCapacity * 2 * sizeof(T_DjiTestFcRecordIndexEntry));
+        if (index != NULL) {
+            memcpy(index, recorder->index, recorder->indexCount * sizeof(T_DjiTestFcRecordIndexEntry));
+            osalHandler->Free(recorder->index);
+            recorder->index = index;
+            recorder->indexCapacity *= 2;
+        }
+    }
+
+    if (recorder->indexCount < recorder->indexCapacity) {
+        index = &recorder->index[recorder->indexCount++];
+        index->offset = recorder->segmentBytes;
+        index->firstTimeUs = recorder->blockFirstTimeUs;
+        index->lastTimeUs = recorder->blockLastTimeUs;
+        index->sampleCount = recorder->blockSampleCount;
+        index->reserved = 0;
+    }
+
+    blockHeader.magic = DJI_TEST_FC_RECORD_BLOCK_MAGIC;
+    blockHeader.encodedSize = recorder->blockLen;
+    blockHeader.sampleCount = recorder->blockSampleCount;
+    blockHeader.firstTimeUs = recorder->blockFirstTimeUs;
+    blockHeader.lastTimeUs = recorder->blockLastTimeUs;
+    blockHeader.dataCrc = UtilCrc_Crc32(0, recorder->block, recorder->blockLen);
+    blockHeader.headerCrc = UtilCrc_Crc32(0, (const uint8_t *) &blockHeader,
+                                          sizeof(blockHeader) - sizeof(blockHeader.headerCrc));
+
+    returnCode = DjiTest_FcRecorderWrite(recorder, &blockHeader, sizeof(blockHeader));
+    if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        returnCode = DjiTest_FcRecorderWrite(recorder, recorder->block, recorder->blockLen);
+    }
+    recorder->statistics.blockCount++;
+    recorder->blockLen = 0;
+    recorder->blockSampleCount = 0;
+
+    if (recorder->nextWriter == NULL && !recorder->isNextWriterRequested &&
+        recorder->segmentBytes >= recorder->config.segmentSize / 2) {
+        recorder->isNextWriterRequested = true;
+        osalHandler->SemaphorePost(recorder->rotateSema);
+    }
+    //without a segment opened ahead yet the current one grows past the segment size instead of blocking here
+    if (recorder->segmentBytes >= recorder->config.segmentSize && recorder->nextWriter != NULL) {
+        returnCode = DjiTest_FcRecorderSwitchSegment(recorder);
+    }
+
+    return returnCode;
+}
+
+static T_DjiReturnCode DjiTest_FcRecorderWrite(T_DjiTestFcRecorder *recorder, const void *data, uint32_t len)
+{
+    T_DjiReturnCode returnCode;
+
+    if (len == 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    returnCode = UtilAsyncWriter_Write(recorder->writer, data, len);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        recorder->statistics.writeFailCount++;
+        return returnCode;
+    }
+    recorder->segmentBytes += len;
+    recorder->statistics.encodedBytes += len;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+static void DjiTest_FcRecorderFree(T_DjiTestFcRecorder *recorder)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    DjiTest_FcRecorderStopRotateTask(recorder);
+    if (recorder->writer != NULL) {
+        UtilAsyncWriter_Close(recorder->writer);
+    }
+    if (recorder->rotateSema != NULL) {
+        osalHandler->SemaphoreDestroy(recorder->rotateSema);
+    }
+    if (recorder->mutex != NULL) {
+        osalHandler->MutexDestroy(recorder->mutex);
+    }
+    if (recorder->schema != NULL) {
+        osalHandler->Free(recorder->schema);
+    }
+    if (recorder->index != NULL) {
+        osalHandler->Free(recorder->index);
+    }
+    if (recorder->block != NULL) {
+        osalHandler->Free(recorder->block);
+    }
+    osalHandler->Free(recorder);
+}
+
+static uint32_t DjiTest_FcRecorderPutVarint(uint8_t *out, uint64_t value)
+{
+    uint32_t len = 0;
+
+    while (value >= 0x80) {
+        out[len++] = (uint8_t) (value | 0x80);
+        value >>= 7;
+    }
+    out[len++] = (uint8_t) value;
+
+    return len;
+}
+
+/**
+ * @brief Write data XORed with the previous sample as literal and zero runs, previous may be NULL.
+ */
+static uint32_t DjiTest_FcRecorderPutRuns(uint8_t *out, const uint8_t *data, const uint8_t *previous, uint16_t len)
+{
+    uint8_t delta[DJI_TEST_FC_RECORD_DATA_MAX];
+    uint32_t outLen = 0;
+    uint32_t literalStart = 0;
+    uint32_t run;
+    uint32_t i;
+
+    for (i = 0; i < len; i++) {
+        delta[i] = previous != NULL ? data[i] ^ previous[i] : data[i];
+    }
+
+    i = 0;
+    while (i <= len) {
+        for (run = 0; i + run < len && delta[i + run] == 0 && run < 0x80; run++) {
+        }
+
+        //a single zero byte stays in the literal run, it is cheaper there than as a run of its own
+        if (i < len && run < 2 && i + 1 - literalStart < 0x80) {
+            i++;
+            continue;
+        }
+
+        if (i < len && run < 2) {
+            i++;
+        }
+        if (i > literalStart) {
+            out[outLen++] = (uint8_t) (i - literalStart - 1);
+            memcpy(out + outLen, delta + literalStart, i - literalStart);
+            outLen += i - literalStart;
+        }
+
+        if (i == len) {
+            break;
+        }
+        if (run >= 2) {
+            out[outLen++] = (uint8_t) (0x7F + run);
+            i += run;
+        }
+        literalStart = i;
+    }
+
+    return outLen;
+}
+
+static uint64_t DjiTest_FcRecorderZigzag(int64_t value)
+{
+    return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+}
+
+#endif
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,219 @@
+/**
+ ********************************************************************
+ * @file    test_fc_subscription_recorder.h
+ * @brief   This is the header file for "test_fc_subscription_recorder.c", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef TEST_FC_SUBSCRIPTION_RECORDER_H
+#define TEST_FC_SUBSCRIPTION_RECORDER_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_typedef.h"
+#include "dji_fc_subscription.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef SYSTEM_ARCH_LINUX
+
+/* Exported constants --------------------------------------------------------*/
+#define DJI_TEST_FC_RECORD_MAGIC                        "DJIFCREC"
+#define DJI_TEST_FC_RECORD_MAGIC_SIZE                   8
+#define DJI_TEST_FC_RECORD_VERSION                      1
+#define DJI_TEST_FC_RECORD_FILE_EXTENSION               ".fcr"
+/* "FBLK" and "FIDX" in file byte order. */
+#define DJI_TEST_FC_RECORD_BLOCK_MAGIC                  0x4B4C4246U
+#define DJI_TEST_FC_RECORD_INDEX_MAGIC                  0x58444946U
+#define DJI_TEST_FC_RECORD_TOPIC_MAX                    56
+/* Samples larger than this are counted as invalid and not recorded. */
+#define DJI_TEST_FC_RECORD_DATA_MAX                     256
+#define DJI_TEST_FC_RECORD_LAYOUT_MAX                   512
+
+#define DJI_TEST_FC_RECORDER_DEFAULT_BLOCK_SIZE         (16 * 1024)
+#define DJI_TEST_FC_RECORDER_DEFAULT_BLOCK_INTERVAL_MS  1000
+#define DJI_TEST_FC_RECORDER_DEFAULT_SEGMENT_SIZE       (64 * 1024 * 1024)
+
+/* Exported types ------------------------------------------------------------*/
+typedef void *T_DjiTestFcRecorderHandle;
+typedef void *T_DjiTestFcRecordReaderHandle;
+
+/**
+ * @brief File layout of one segment, all fields are little endian:
+ * - T_DjiTestFcRecordHeader followed by schemaSize bytes of schema. The schema holds topicCount
+ *   T_DjiTestFcRecordSchemaEntry, each followed by layoutLength characters of layout text.
+ * - Blocks, each a T_DjiTestFcRecordBlockHeader followed by encodedSize bytes of encoded samples.
+ * - When the segment is closed, blockCount T_DjiTestFcRecordIndexEntry and a T_DjiTestFcRecordFooter.
+ *   A segment without footer, e.g. after a power loss, is read by scanning the blocks.
+ *
+ * The layout text is "<topic name>;<field>:<type>,<field>:<type>,...", the type being one of b/B (int8/uint8),
+ * h/H (int16/uint16), i/I (int32/uint32), q/Q (int64/uint64), f (float32), d (float64) or xN (N raw bytes).
+ *
+ * A sample is encoded as the topic index, the zigzag varint deltas of the receive time, the millisecond and
+ * the microsecond of the flight controller timestamp, the varint data size, and the data XORed with the
+ * previous sample of the same topic in zero run length form: a control byte n < 0x80 is followed by n + 1
+ * literal bytes, a control byte n >= 0x80 stands for n - 0x7F zero bytes. The previous values are reset at the
+ * start of every block, so each block decodes on its own.
+ */
+typedef struct {
+    char magic[DJI_TEST_FC_RECORD_MAGIC_SIZE];
+    uint16_t version;
+    uint16_t headerSize;
+    uint16_t blockHeaderSize;
+    uint16_t topicCount;
+    uint32_t segmentIndex;
+    uint32_t schemaSize;
+    /*! Local time the recorder was opened, in microseconds. */
+    uint64_t startTimeUs;
+    uint32_t schemaCrc;
+    /*! CRC-32 of the fields above. */
+    uint32_t headerCrc;
+} __attribute__((packed)) T_DjiTestFcRecordHeader;
+
+typedef struct {
+    uint32_t topic;
+    uint16_t frequency;
+    uint16_t dataSize;
+    uint16_t layoutLength;
+} __attribute__((packed)) T_DjiTestFcRecordSchemaEntry;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t encodedSize;
+    uint32_t sampleCount;
+    uint32_t reserved;
+    uint64_t firstTimeUs;
+    uint64_t lastTimeUs;
+    uint32_t dataCrc;
+    /*! CRC-32 of the fields above. */
+    uint32_t headerCrc;
+} __attribute__((packed)) T_DjiTestFcRecordBlockHeader;
+
+typedef struct {
+    uint64_t offset;
+    uint64_t firstTimeUs;
+    uint64_t lastTimeUs;
+    uint32_t sampleCount;
+    uint32_t reserved;
+} __attribute__((packed)) T_DjiTestFcRecordIndexEntry;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t blockCount;
+    uint64_t indexOffset;
+    uint32_t indexCrc;
+    /*! CRC-32 of the fields above. */
+    uint32_t footerCrc;
+} __attribute__((packed)) T_DjiTestFcRecordFooter;
+
+typedef struct {
+    E_DjiFcSubscriptionTopic topic;
+    E_DjiDataSubscriptionTopicFreq frequency;
+} T_DjiTestFcRecorderTopicConfig;
+
+typedef struct {
+    /*! A block is written once its encoded samples reach this size. */
+    uint32_t blockSize;
+    /*! A block is also written once it is this old, it bounds the data lost on a power loss. */
+    uint32_t blockIntervalMs;
+    /*! Size at which the next segment file, opened ahead in the background, is started. Also preallocated. */
+    uint64_t segmentSize;
+} T_DjiTestFcRecorderConfig;
+
+typedef struct {
+    uint64_t sampleCount;
+    uint64_t rawBytes;
+    uint64_t encodedBytes;
+    uint32_t blockCount;
+    uint32_t segmentCount;
+    uint32_t invalidSampleCount;
+    uint32_t writeFailCount;
+    uint32_t writerWaitCount;
+} T_DjiTestFcRecorderStatistics;
+
+typedef struct {
+    E_DjiFcSubscriptionTopic topic;
+    E_DjiDataSubscriptionTopicFreq frequency;
+    uint16_t dataSize;
+    /*! Layout text as described above, NUL terminated. */
+    char layout[DJI_TEST_FC_RECORD_LAYOUT_MAX];
+} T_DjiTestFcRecordTopicInfo;
+
+typedef struct {
+    uint16_t topicIndex;
+    E_DjiFcSubscriptionTopic topic;
+    uint64_t recvTimeUs;
+    T_DjiDataTimestamp timestamp;
+    uint16_t dataSize;
+    /*! Valid until the next call of DjiTest_FcRecordReaderNext. */
+    const uint8_t *data;
+} T_DjiTestFcRecordSample;
+
+typedef struct {
+    uint64_t sampleCount;
+    uint32_t blockCount;
+    uint32_t corruptBlockCount;
+    uint64_t skippedBytes;
+    /*! Whether the segment was closed properly and its index was used. */
+    bool indexed;
+} T_DjiTestFcRecordReaderStatistics;
+
+typedef enum {
+    DJI_TEST_FC_RECORD_EXPORT_FORMAT_CSV = 0,
+    /*! One column file per topic, see tools/fc_record_convert/README.md. */
+    DJI_TEST_FC_RECORD_EXPORT_FORMAT_COLUMNAR,
+} E_DjiTestFcRecordExportFormat;
+
+/* Exported functions --------------------------------------------------------*/
+void DjiTest_FcRecorderGetDefaultConfig(T_DjiTestFcRecorderConfig *config);
+T_DjiReturnCode DjiTest_FcRecorderStart(const char *pathPrefix, const T_DjiTestFcRecorderTopicConfig *topics,
+                                        uint32_t topicCount, const T_DjiTestFcRecorderConfig *config,
+                                        T_DjiTestFcRecorderHandle *recorderHandle);
+T_DjiReturnCode DjiTest_FcRecorderStop(T_DjiTestFcRecorderHandle recorderHandle);
+void DjiTest_FcRecorderGetStatistics(T_DjiTestFcRecorderHandle recorderHandle,
+                                     T_DjiTestFcRecorderStatistics *statistics);
+const char *DjiTest_FcRecordGetTopicLayout(E_DjiFcSubscriptionTopic topic, uint16_t *dataSize);
+
+T_DjiReturnCode DjiTest_FcRecordReaderOpen(const char *recordPath, T_DjiTestFcRecordReaderHandle *readerHandle);
+T_DjiReturnCode DjiTest_FcRecordReaderClose(T_DjiTestFcRecordReaderHandle readerHandle);
+uint16_t DjiTest_FcRecordReaderGetTopicCount(T_DjiTestFcRecordReaderHandle readerHandle);
+T_DjiReturnCode DjiTest_FcRecordReaderGetTopicInfo(T_DjiTestFcRecordReaderHandle readerHandle, uint16_t topicIndex,
+                                                   T_DjiTestFcRecordTopicInfo *topicInfo);
+T_DjiReturnCode DjiTest_FcRecordReaderNext(T_DjiTestFcRecordReaderHandle readerHandle,
+                                           T_DjiTestFcRecordSample *sample);
+T_DjiReturnCode DjiTest_FcRecordReaderSeek(T_DjiTestFcRecordReaderHandle readerHandle, uint64_t timeUs);
+void DjiTest_FcRecordReaderGetStatistics(T_DjiTestFcRecordReaderHandle readerHandle,
+                                         T_DjiTestFcRecordReaderStatistics *statistics);
+
+T_DjiReturnCode DjiTest_FcRecordExport(const char *const *recordPaths, uint32_t recordCount,
+                                       const char *exportDirPath, E_DjiTestFcRecordExportFormat format,
+                                       T_DjiTestFcRecordReaderStatistics *statistics);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TEST_FC_SUBSCRIPTION_RECORDER_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
@@ -0,0 +1,247 @@
+/**
+ ********************************************************************
+ * @file    test_fc_subscription_snapshot.c
+ * @brief   The file defines a snapshot of several flight controller topics. The subscription callbacks
+ *          merge every topic into one structure guarded by a sequence counter, so a consumer reads all topics
+ *          with a single copy, consistent with each other and without a lock.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "test_fc_subscription_snapshot.h"
+#include "test_fc_subscription_cache.h"
+#include "test_fc_subscription_dispatcher.h"
+#include "dji_platform.h"
+#include "dji_logger.h"
+#include "utils/util_seqlock.h"
+
+/* Private constants ---------------------------------------------------------*/
+/* With the backoff of the seqlock reads this gives up after about 80 ms of writes in progress. */
+#define DJI_TEST_FC_SUBSCRIPTION_SNAPSHOT_READ_RETRY_MAX        16
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    E_DjiFcSubscriptionTopic topic;
+    T_DjiTestFcSubscriptionConsumerHandle consumer;
+    uint16_t dataSize;
+    uint16_t offset;
+} T_DjiTestFcSubscriptionSnapshotTopic;
+
+typedef struct {
+    bool inited;
+    T_DjiTestFcSubscriptionSnapshotTopic topics[DJI_TEST_FC_SUBSCRIPTION_SNAPSHOT_TOPIC_MAX];
+    uint32_t topicCount;
+    uint32_t registeredCount;
+    uint16_t size;
+    T_DjiMutexHandle writeMutex;
+    /*! Seqlock of the fields below. */
+    uint32_t sequence;
+    uint8_t *data;
+    uint64_t receiveTimeUs[DJI_TEST_FC_SUBSCRIPTION_SNAPSHOT_TOPIC_MAX];
+    uint64_t timestampUs[DJI_TEST_FC_SUBSCRIPTION_SNAPSHOT_TOPIC_MAX];
+    uint32_t updateCount;
+} T_DjiTestFcSubscriptionSnapshot;
+
+/* Private functions declaration ---------------------------------------------*/
+static void DjiTest_FcSubscriptionSnapshotUpdate(const uint8_t *data, uint16_t dataSize,
+                                                 const T_DjiDataTimestamp *timestamp, void *userData);
+
+/* Private values -------------------------------------------------------------*/
+static T_DjiTestFcSubscriptionSnapshot s_snapshot = {0};
+
+/* Exported functions definition ---------------------------------------------*/
+/**
+ * @brief Register the configured topics with the subscription dispatcher and merge them into a snapshot
+ * structure of snapshotSize bytes.
+ * @note Topics not received yet read as zero.
+ */
+T_DjiReturnCode DjiTest_FcSubscriptionSnapshotInit(const T_DjiTestFcSubscriptionSnapshotTopicConfig *configs,
+                                                   uint32_t configCount, uint16_t snapshotSize)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiReturnCode returnCode;
+    uint32_t i;
+
+    if (s_snapshot.inited) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+    }
+
+    if (configs == NULL || configCount == 0 || configCount > DJI_TEST_FC_SUBSCRIPTION_SNAPSHOT_TOPIC_MAX ||
+        snapshotSize == 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    for (i = 0; i < configCount; i++) {
+        if (configs[i].dataSize == 0 || (uint32_t) configs[i].offset + configs[i].dataSize > snapshotSize) {
+            return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+        }
+    }
+
+    memset(&s_snapshot, 0, sizeof(s_snapshot));
+    s_snapshot.data = osalHandler->Malloc(snapshotSize);
+    if (s_snapshot.data == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+    memset(s_snapshot.data, 0, snapshotSize);
+    s_snapshot.size = snapshotSize;
+
+    returnCode = osalHandler->MutexCreate(&s_snapshot.writeMutex);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        osalHandler->Free(s_snapshot.data);
+        s_snapshot.data = NULL;
+        return returnCode;
+    }
+
+    for (i = 0; i < configCount; i++) {
+        s_snapshot.topics[i].topic = configs[i].topic;
+        s_snapshot.topics[i].dataSize = configs[i].dataSize;
+        s_snapshot.topics[i].offset = configs[i].offset;
+    }
+    s_snapshot.topicCount = configCount;
+    s_snapshot.inited = true;
+
+    for (i = 0; i < configCount; i++) {
+        returnCode = DjiTest_FcSubscriptionDispatcherRegister(configs[i].topic, configs[i].frequency,
+                                                              DjiTest_FcSubscriptionSnapshotUpdate,
+                                                              &s_snapshot.topics[i], &s_snapshot.topics[i].consumer);
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            USER_LOG_ERROR("Subscribe topic %d to snapshot error, stat:0x%08llX.", configs[i].topic, returnCode);
+            DjiTest_FcSubscriptionSnapshotDeInit();
+            return returnCode;
+        }
+        s_snapshot.registeredCount++;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiTest_FcSubscriptionSnapshotDeInit(void)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiReturnCode returnCode;
+    uint32_t i;
+
+    if (!s_snapshot.inited) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    for (i = 0; i < s_snapshot.registeredCount; i++) {
+        returnCode = DjiTest_FcSubscriptionDispatcherUnregister(s_snapshot.topics[i].consumer);
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            USER_LOG_ERROR("Unsubscribe topic %d of snapshot error, stat:0x%08llX.", s_snapshot.topics[i].topic,
+                           returnCode);
+        }
+    }
+
+    osalHandler->MutexDestroy(s_snapshot.writeMutex);
+    osalHandler->Free(s_snapshot.data);
+    memset(&s_snapshot, 0, sizeof(s_snapshot));
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Copy all topics into the snapshot structure of the consumer.
+ * @note The copy is repeated if a topic was merged meanwhile, with a growing delay between the later tries.
+ * Should the callbacks keep the snapshot busy for all retries, BUSY is returned and the consumer may keep its
+ * previous snapshot.
+ */
+T_DjiReturnCode DjiTest_FcSubscriptionSnapshotGet(void *snapshot, uint16_t snapshotSize,
+                                                  T_DjiTestFcSubscriptionSnapshotInfo *info)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    uint64_t receiveTimeUs[DJI_TEST_FC_SUBSCRIPTION_SNAPSHOT_TOPIC_MAX];
+    uint64_t nowUs = 0;
+    uint32_t sequence;
+    uint32_t retry;
+    uint32_t i;
+
+    if (!s_snapshot.inited || snapshot == NULL || snapshotSize != s_snapshot.size) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    for (retry = 0; retry < DJI_TEST_FC_SUBSCRIPTION_SNAPSHOT_READ_RETRY_MAX; retry++) {
+        UtilSeqlock_ReadBackoff(retry);
+        sequence = UtilSeqlock_ReadBegin(&s_snapshot.sequence);
+        if (sequence & 1) {
+            continue;
+        }
+
+        memcpy(snapshot, s_snapshot.data, snapshotSize);
+        if (info != NULL) {
+            memcpy(receiveTimeUs, s_snapshot.receiveTimeUs, sizeof(uint64_t) * s_snapshot.topicCount);
+            memcpy(info->timestampUs, s_snapshot.timestampUs, sizeof(uint64_t) * s_snapshot.topicCount);
+            info->updateCount = s_snapshot.updateCount;
+        }
+
+        if (UtilSeqlock_ReadEnd(&s_snapshot.sequence, sequence)) {
+            break;
+        }
+    }
+
+    if (retry == DJI_TEST_FC_SUBSCRIPTION_SNAPSHOT_READ_RETRY_MAX) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+    }
+
+    if (info != NULL) {
+        osalHandler->GetTimeUs(&nowUs);
+        info->snapshotTimeUs = nowUs;
+        for (i = 0; i < s_snapshot.topicCount; i++) {
+            if (receiveTimeUs[i] == 0) {
+                info->ageMs[i] = DJI_TEST_FC_SUBSCRIPTION_SNAPSHOT_AGE_INVALID;
+            } else {
+                info->ageMs[i] = nowUs > receiveTimeUs[i] ? (uint32_t) ((nowUs - receiveTimeUs[i]) / 1000) : 0;
+            }
+        }
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/* Private functions definition-----------------------------------------------*/
+static void DjiTest_FcSubscriptionSnapshotUpdate(const uint8_t *data, uint16_t dataSize,
+                                                 const T_DjiDataTimestamp *timestamp, void *userData)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    const T_DjiTestFcSubscriptionSnapshotTopic *topic = (const T_DjiTestFcSubscriptionSnapshotTopic *) userData;
+    uint32_t index = topic - s_snapshot.topics;
+    uint64_t receiveTimeUs = 0;
+
+    if (dataSize != topic->dataSize) {
+        return;
+    }
+
+    osalHandler->GetTimeUs(&receiveTimeUs);
+
+    //the callbacks of different topics may run in different threads, only one merges at a time
+    osalHandler->MutexLock(s_snapshot.writeMutex);
+    UtilSeqlock_WriteBegin(&s_snapshot.sequence);
+
+    memcpy(s_snapshot.data + topic->offset, data, dataSize);
+    s_snapshot.receiveTimeUs[index] = receiveTimeUs;
+    s_snapshot.timestampUs[index] = DjiTest_FcSubscriptionCacheTimestampToUs(timestamp);
+    s_snapshot.updateCount++;
+
+    UtilSeqlock_WriteEnd(&s_snapshot.sequence);
+    osalHandler->MutexUnlock(s_snapshot.writeMutex);
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,76 @@
+/**
+ ********************************************************************
+ * @file    test_fc_subscription_snapshot.h
+ * @brief   This is the header file for "test_fc_subscription_snapshot.c", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef TEST_FC_SUBSCRIPTION_SNAPSHOT_H
+#define TEST_FC_SUBSCRIPTION_SNAPSHOT_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_typedef.h"
+#include "dji_fc_subscription.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+#define DJI_TEST_FC_SUBSCRIPTION_SNAPSHOT_TOPIC_MAX         16
+/* Age reported for a topic that has not been received yet. */
+#define DJI_TEST_FC_SUBSCRIPTION_SNAPSHOT_AGE_INVALID       0xFFFFFFFF
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+    E_DjiFcSubscriptionTopic topic;
+    E_DjiDataSubscriptionTopicFreq frequency;
+    /*! Size of the topic data structure, e.g. sizeof(T_DjiFcSubscriptionQuaternion). */
+    uint16_t dataSize;
+    /*! Offset of the topic in the snapshot structure of the consumer, e.g. offsetof(T_MySnapshot, quaternion). */
+    uint16_t offset;
+} T_DjiTestFcSubscriptionSnapshotTopicConfig;
+
+typedef struct {
+    /*! Local time of the snapshot in microseconds. */
+    uint64_t snapshotTimeUs;
+    /*! Per topic in the order of the configs, time since the topic was last received in milliseconds. */
+    uint32_t ageMs[DJI_TEST_FC_SUBSCRIPTION_SNAPSHOT_TOPIC_MAX];
+    /*! Per topic in the order of the configs, timestamp delivered with the topic converted to microseconds. */
+    uint64_t timestampUs[DJI_TEST_FC_SUBSCRIPTION_SNAPSHOT_TOPIC_MAX];
+    /*! Number of topic updates merged into the snapshot so far. */
+    uint32_t updateCount;
+} T_DjiTestFcSubscriptionSnapshotInfo;
+
+/* Exported functions --------------------------------------------------------*/
+T_DjiReturnCode DjiTest_FcSubscriptionSnapshotInit(const T_DjiTestFcSubscriptionSnapshotTopicConfig *configs,
+                                                   uint32_t configCount, uint16_t snapshotSize);
+T_DjiReturnCode DjiTest_FcSubscriptionSnapshotDeInit(void);
+T_DjiReturnCode DjiTest_FcSubscriptionSnapshotGet(void *snapshot, uint16_t snapshotSize,
+                                                  T_DjiTestFcSubscriptionSnapshotInfo *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TEST_FC_SUBSCRIPTION_SNAPSHOT_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
@@ -32,6 +32,7 @@
 #include <widget_interaction_test/test_widget_interaction.h>
 #include <dji_aircraft_info.h>
 #include "dji_fts.h"
+#include "utils/util_attitude.h"
 /* Private constants ---------------------------------------------------------*/
 
 /* Private types -------------------------------------------------------------*/
@@ -1610,17 +1611,12 @@ bool DjiTest_FlightControlGoHomeAndConfirmLanding(void)
 T_DjiTestFlightControlVector3f DjiTest_FlightControlQuaternionToEulerAngle(const T_DjiFcSubscriptionQuaternion quat)
 {
     T_DjiTestFlightControlVector3f eulerAngle;
-    double q2sqr = quat.q2 * quat.q2;
-    double t0 = -2.0 * (q2sqr + quat.q3 * quat.q3) + 1.0;
-    double t1 = (dji_f64_t) 2.0 * (quat.q1 * quat.q2 + quat.q0 * quat.q3);
-    double t2 = -2.0 * (quat.q1 * quat.q3 - quat.q0 * quat.q2);
-    double t3 = (dji_f64_t) 2.0 * (quat.q2 * quat.q3 + quat.q0 * quat.q1);
-    double t4 = -2.0 * (quat.q1 * quat.q1 + q2sqr) + 1.0;
-    t2 = (t2 > 1.0) ? 1.0 : t2;
-    t2 = (t2 < -1.0) ? -1.0 : t2;
-    eulerAngle.x = asin(t2);
-    eulerAngle.y = atan2(t3, t4);
-    eulerAngle.z = atan2(t1, t0);
+    T_UtilAttitudeQuaternion attitudeQuaternion = {quat.q0, quat.q1, quat.q2, quat.q3};
+    T_UtilAttitudeEuler euler = UtilAttitude_QuaternionToEuler(attitudeQuaternion);
+
+    eulerAngle.x = euler.pitch;
+    eulerAngle.y = euler.roll;
+    eulerAngle.z = euler.yaw;
     return eulerAngle;
 }
 
@@ -29,7 +29,10 @@
 #include "dji_fc_subscription.h"
 #include "dji_logger.h"
 #include "dji_platform.h"
+#include "utils/util_attitude.h"
 #include "utils/util_misc.h"
+#include "utils/util_seqlock.h"
+#include "utils/util_time.h"
 #include "widget_interaction_test/test_widget_interaction.h"
 
 /* Private constants ---------------------------------------------------------*/
@@ -37,6 +40,10 @@
 #define PAYLOAD_GIMBAL_TASK_FREQ            1000
 #define PAYLOAD_GIMBAL_CALIBRATION_TIME_MS  2000
 #define PAYLOAD_GIMBAL_MIN_ACTION_TIME      5
+#define PAYLOAD_GIMBAL_SMOOTH_FACTOR_MAX    30
+#define PAYLOAD_GIMBAL_COMMAND_QUEUE_SIZE   16
+#define PAYLOAD_GIMBAL_SNAPSHOT_READ_RETRY_MAX  16
+#define PAYLOAD_GIMBAL_STATISTICS_FREQ      0.1f
 
 /* Private types -------------------------------------------------------------*/
 typedef enum {
@@ -45,6 +52,55 @@ typedef enum {
     TEST_GIMBAL_CONTROL_TYPE_ANGLE = 2,
 } E_TestGimbalControlType;
 
+typedef enum {
+    TEST_GIMBAL_COMMAND_ROTATE = 0,
+    TEST_GIMBAL_COMMAND_RESET,
+    TEST_GIMBAL_COMMAND_FINE_TUNE_ANGLE,
+    TEST_GIMBAL_COMMAND_SET_MODE,
+    TEST_GIMBAL_COMMAND_SET_SMOOTH_FACTOR,
+    TEST_GIMBAL_COMMAND_SET_PITCH_RANGE_EXTENSION,
+    TEST_GIMBAL_COMMAND_SET_MAX_SPEED_PERCENTAGE,
+    TEST_GIMBAL_COMMAND_RESTORE_FACTORY_SETTINGS,
+    TEST_GIMBAL_COMMAND_START_CALIBRATION,
+} E_TestGimbalCommandType;
+
+/* Rotation resolved by the callback, angle control moves to targetAttitude at speed, speed control only sets speed. */
+typedef struct {
+    E_TestGimbalControlType controlType;
+    T_DjiAttitude3d targetAttitude;
+    T_DjiAttitude3d speed;
+} T_TestGimbalRotationCommand;
+
+typedef struct {
+    uint8_t value;
+    E_DjiGimbalAxis axis;
+} T_TestGimbalAxisSettingCommand;
+
+/* Requests of the SDK callbacks, applied by the gimbal task which owns the gimbal state. */
+typedef struct {
+    E_TestGimbalCommandType type;
+    union {
+        T_TestGimbalRotationCommand rotation;
+        E_DjiGimbalResetMode resetMode;
+        T_DjiAttitude3d fineTuneAngle;
+        E_DjiGimbalMode gimbalMode;
+        T_TestGimbalAxisSettingCommand axisSetting;
+        bool enabledFlag;
+        uint32_t calibrationStartTime;
+    } data;
+} T_TestGimbalCommand;
+
+/* State published by the gimbal task every period, read by the SDK callbacks. */
+typedef struct {
+    T_DjiGimbalSystemState systemState;
+    T_DjiGimbalAttitudeInformation attitudeInformation;
+    T_DjiGimbalCalibrationState calibrationState;
+    T_DjiAttitude3d speed;
+    T_DjiAttitude3d aircraftAttitude;
+    bool rotatingFlag;
+    E_TestGimbalControlType controlType;
+} T_TestGimbalSnapshot;
+
 /* Private functions declaration ---------------------------------------------*/
 static void *UserGimbal_Task(void *arg);
 static T_DjiReturnCode GetSystemState(T_DjiGimbalSystemState *systemState);
@@ -61,6 +117,7 @@ static T_DjiReturnCode SetMode(E_DjiGimbalMode mode);
 static T_DjiReturnCode Reset(E_DjiGimbalResetMode mode);
 static T_DjiReturnCode FineTuneAngle(T_DjiAttitude3d fineTuneAngle);
 static T_DjiReturnCode DjiTest_GimbalAngleLegalization(T_DjiAttitude3f *attitude, T_DjiAttitude3d aircraftAttitude,
+                                                       bool pitchRangeExtensionEnabled,
                                                        T_DjiGimbalReachLimitFlag *reachLimitFlag);
 static T_DjiReturnCode
 DjiTest_GimbalCalculateSpeed(T_DjiAttitude3d originalAttitude, T_DjiAttitude3d targetAttitude, uint16_t actionTime,
@@ -68,13 +125,24 @@ DjiTest_GimbalCalculateSpeed(T_DjiAttitude3d originalAttitude, T_DjiAttitude3d t
 static void DjiTest_GimbalSpeedLegalization(T_DjiAttitude3d *speed);
 static T_DjiReturnCode DjiTest_GimbalCalculateGroundAttitudeBaseQuaternion(T_DjiFcSubscriptionQuaternion quaternion,
                                                                            T_DjiAttitude3d *attitude);
+static T_DjiReturnCode DjiTest_GimbalResolveRotation(E_DjiGimbalRotationMode rotationMode,
+                                                     T_DjiGimbalRotationProperty rotationProperty,
+                                                     T_DjiAttitude3d rotationValue,
+                                                     const T_TestGimbalSnapshot *snapshot,
+                                                     T_TestGimbalRotationCommand *rotation);
+static T_DjiReturnCode DjiTest_GimbalPushCommand(const T_TestGimbalCommand *command);
+static void DjiTest_GimbalApplyCommands(void);
+static void DjiTest_GimbalApplyRotation(const T_TestGimbalRotationCommand *rotation);
+static void DjiTest_GimbalApplyReset(E_DjiGimbalResetMode mode);
+static void DjiTest_GimbalApplyFineTuneAngle(T_DjiAttitude3d fineTuneAngle);
+static void DjiTest_GimbalPublishSnapshot(void);
+static T_DjiReturnCode DjiTest_GimbalReadSnapshot(T_TestGimbalSnapshot *snapshot);
 
 /* Private variables ---------------------------------------------------------*/
 static T_DjiTaskHandle s_userGimbalThread;
 static T_DjiGimbalCommonHandler s_commonHandler = {0};
 static T_DjiGimbalSystemState s_systemState = {0};
 static bool s_rotatingFlag = false;
-static T_DjiMutexHandle s_commonMutex = {0};
 
 static T_DjiGimbalAttitudeInformation s_attitudeInformation = {0}; // unit: 0.1 degree, ground coordination
 static T_DjiAttitude3f s_attitudeHighPrecision = {0}; // unit: 0.1 degree, ground coordination
@@ -92,13 +160,24 @@ static const int32_t s_pitchEulerAngleExtensionMin = -1200; // unit: 0.1 degree
 static const int32_t s_pitchEulerAngleExtensionMax = 300; // unit: 0.1 degree
 static const T_DjiAttitude3d s_speedLimit = {1800, 1800, 1800}; // unit: 0.1 degree/s
 static uint32_t s_calibrationStartTime = 0; // unit: ms
-static T_DjiMutexHandle s_attitudeMutex = NULL;
-static T_DjiMutexHandle s_calibrationMutex = NULL;
+static T_DjiMutexHandle s_commandMutex = NULL;
+static T_TestGimbalCommand s_commandQueue[PAYLOAD_GIMBAL_COMMAND_QUEUE_SIZE];
+static uint32_t s_commandHead = 0; // advanced by the callbacks under s_commandMutex
+static uint32_t s_commandTail = 0; // advanced by the gimbal task
+static T_TestGimbalSnapshot s_snapshot = {0};
+static uint32_t s_snapshotSequence = 0;
+#ifdef SYSTEM_ARCH_LINUX
+static T_DjiUtilTimePacer s_gimbalPacer = {0};
+#endif
 
 /* Exported functions definition ---------------------------------------------*/
 /**
  * @brief
  * @note Gimbal sample rely on aircraft quaternion.
+ * @note The gimbal task is the only one changing the gimbal state. The SDK callbacks queue their requests for it and
+ * read the state it publishes every period behind a sequence counter, so the 1000 Hz loop never waits for a callback.
+ * A callback checks its request against that state before queueing it and returns any error to the SDK itself. The
+ * getters return the state as of the last period, at most 1 ms old, and a request shows in them from the next one.
  * @return
  */
 T_DjiReturnCode DjiTest_GimbalStartService(void)
@@ -135,20 +214,14 @@ T_DjiReturnCode DjiTest_GimbalStartService(void)
         return djiStat;
     }
 
-    if (osalHandler->MutexCreate(&s_commonMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+    if (osalHandler->MutexCreate(&s_commandMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
         USER_LOG_ERROR("mutex create error");
         return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
     }
 
-    if (osalHandler->MutexCreate(&s_attitudeMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex create error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-    }
-
-    if (osalHandler->MutexCreate(&s_calibrationMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex create error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-    }
+    s_commandHead = 0;
+    s_commandTail = 0;
+    DjiTest_GimbalPublishSnapshot();
 
     djiStat = DjiGimbal_Init();
     if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
@@ -183,23 +256,23 @@ T_DjiReturnCode DjiTest_GimbalDeInit(void)
         return djiStat;
     }
 
+#ifdef SYSTEM_ARCH_LINUX
+    USER_LOG_INFO("gimbal loop: %u periods, %u overruns, %u resyncs, lateness p50 %llu us, p99 %llu us, "
+                  "p99.9 %llu us, max %llu us.", s_gimbalPacer.waitCount, s_gimbalPacer.overrunCount,
+                  s_gimbalPacer.resyncCount,
+                  (unsigned long long) DjiUtilTime_PacerGetLatenessPercentileUs(&s_gimbalPacer, 50),
+                  (unsigned long long) DjiUtilTime_PacerGetLatenessPercentileUs(&s_gimbalPacer, 99),
+                  (unsigned long long) DjiUtilTime_PacerGetLatenessPercentileUs(&s_gimbalPacer, 99.9f),
+                  (unsigned long long) s_gimbalPacer.maxLatenessUs);
+#endif
+
     djiStat = DjiGimbal_DeInit();
     if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
         USER_LOG_ERROR("Deinit gimbal module error: 0x%08llX.", djiStat);
         return djiStat;
     }
 
-    if (osalHandler->MutexDestroy(s_calibrationMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex destroy error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-    }
-
-    if (osalHandler->MutexDestroy(s_attitudeMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex destroy error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-    }
-
-    if (osalHandler->MutexDestroy(s_commonMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+    if (osalHandler->MutexDestroy(s_commandMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
         USER_LOG_ERROR("mutex destroy error");
         return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
     }
@@ -212,28 +285,14 @@ T_DjiReturnCode DjiTest_GimbalRotate(E_DjiGimbalRotationMode rotationMode,
                                      T_DjiAttitude3d rotationValue)
 {
     T_DjiReturnCode djiStat;
-    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
-    T_DjiAttitude3d targetAttitudeDTemp = {0};
-    T_DjiAttitude3f targetAttitudeFTemp = {0};
-    T_DjiAttitude3d speedTemp = {0};
-    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_TestGimbalSnapshot snapshot;
+    T_TestGimbalCommand command = {0};
 
     USER_LOG_DEBUG("gimbal rotation value invalid flag: pitch %d, roll %d, yaw %d.",
                    rotationProperty.rotationValueInvalidFlag.pitch,
                    rotationProperty.rotationValueInvalidFlag.roll,
                    rotationProperty.rotationValueInvalidFlag.yaw);
 
-    if (osalHandler->MutexLock(s_attitudeMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex lock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-    }
-
-    if (osalHandler->MutexLock(s_commonMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex lock error");
-        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-        goto out2;
-    }
-
     switch (rotationMode) {
         case DJI_GIMBAL_ROTATION_MODE_RELATIVE_ANGLE:
             USER_LOG_INFO("gimbal relative rotate angle: pitch %d, roll %d, yaw %d.", rotationValue.pitch,
@@ -242,42 +301,6 @@ T_DjiReturnCode DjiTest_GimbalRotate(E_DjiGimbalRotationMode rotationMode,
                           rotationValue.roll, rotationValue.yaw);
             USER_LOG_DEBUG("gimbal relative rotate action time: %d.",
                            rotationProperty.relativeAngleRotation.actionTime);
-
-            if (s_rotatingFlag == true) {
-                USER_LOG_WARN("gimbal is rotating.");
-                goto out1;
-            }
-
-            targetAttitudeDTemp.pitch =
-                rotationProperty.rotationValueInvalidFlag.pitch == true ? s_attitudeInformation.attitude.pitch : (
-                    s_attitudeInformation.attitude.pitch + rotationValue.pitch);
-            targetAttitudeDTemp.roll =
-                rotationProperty.rotationValueInvalidFlag.roll == true ? s_attitudeInformation.attitude.roll : (
-                    s_attitudeInformation.attitude.roll + rotationValue.roll);
-            targetAttitudeDTemp.yaw =
-                rotationProperty.rotationValueInvalidFlag.yaw == true ? s_attitudeInformation.attitude.yaw : (
-                    s_attitudeInformation.attitude.yaw + rotationValue.yaw);
-
-            targetAttitudeFTemp.pitch = targetAttitudeDTemp.pitch;
-            targetAttitudeFTemp.roll = targetAttitudeDTemp.roll;
-            targetAttitudeFTemp.yaw = targetAttitudeDTemp.yaw;
-            DjiTest_GimbalAngleLegalization(&targetAttitudeFTemp, s_aircraftAttitude, NULL);
-            targetAttitudeDTemp.pitch = targetAttitudeFTemp.pitch;
-            targetAttitudeDTemp.roll = targetAttitudeFTemp.roll;
-            targetAttitudeDTemp.yaw = targetAttitudeFTemp.yaw;
-
-            s_targetAttitude = targetAttitudeDTemp;
-            s_rotatingFlag = true;
-            s_controlType = TEST_GIMBAL_CONTROL_TYPE_ANGLE;
-
-            djiStat = DjiTest_GimbalCalculateSpeed(s_attitudeInformation.attitude, s_targetAttitude,
-                                                   rotationProperty.relativeAngleRotation.actionTime, &s_speed);
-            if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-                USER_LOG_ERROR("calculate gimbal rotation speed error: 0x%08llX.", djiStat);
-                returnCode = djiStat;
-                goto out1;
-            }
-
             break;
         case DJI_GIMBAL_ROTATION_MODE_ABSOLUTE_ANGLE:
             DjiTest_WidgetLogAppend("abs mode (%d  %d %d)", rotationValue.pitch, rotationValue.roll, rotationValue.yaw);
@@ -291,85 +314,39 @@ T_DjiReturnCode DjiTest_GimbalRotate(E_DjiGimbalRotationMode rotationMode,
                                rotationProperty.absoluteAngleRotation.jointAngle.roll,
                                rotationProperty.absoluteAngleRotation.jointAngle.yaw);
             }
-
-            if (s_rotatingFlag == true) {
-                USER_LOG_WARN("gimbal is rotating.");
-                goto out1;
-            }
-
-            targetAttitudeDTemp.pitch =
-                rotationProperty.rotationValueInvalidFlag.pitch == true ? s_attitudeInformation.attitude.pitch
-                                                                        : rotationValue.pitch;
-            targetAttitudeDTemp.roll =
-                rotationProperty.rotationValueInvalidFlag.roll == true ? s_attitudeInformation.attitude.roll
-                                                                       : rotationValue.roll;
-            targetAttitudeDTemp.yaw =
-                rotationProperty.rotationValueInvalidFlag.yaw == true ? s_attitudeInformation.attitude.yaw
-                                                                      : rotationValue.yaw;
-
-            targetAttitudeFTemp.pitch = targetAttitudeDTemp.pitch;
-            targetAttitudeFTemp.roll = targetAttitudeDTemp.roll;
-            targetAttitudeFTemp.yaw = targetAttitudeDTemp.yaw;
-            DjiTest_GimbalAngleLegalization(&targetAttitudeFTemp, s_aircraftAttitude, NULL);
-            targetAttitudeDTemp.pitch = targetAttitudeFTemp.pitch;
-            targetAttitudeDTemp.roll = targetAttitudeFTemp.roll;
-            targetAttitudeDTemp.yaw = targetAttitudeFTemp.yaw;
-
-            s_targetAttitude = targetAttitudeDTemp;
-            s_rotatingFlag = true;
-            s_controlType = TEST_GIMBAL_CONTROL_TYPE_ANGLE;
-
-            djiStat = DjiTest_GimbalCalculateSpeed(s_attitudeInformation.attitude, s_targetAttitude,
-                                                   rotationProperty.absoluteAngleRotation.actionTime, &s_speed);
-            if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-                USER_LOG_ERROR("calculate gimbal rotation speed error: 0x%08llX.", djiStat);
-                returnCode = djiStat;
-                goto out1;
-            }
-
             break;
         case DJI_GIMBAL_ROTATION_MODE_SPEED:
             DjiTest_WidgetLogAppend("speed mode (%d  %d %d)", rotationValue.pitch, rotationValue.roll, rotationValue.yaw);
             USER_LOG_INFO("gimbal rotate speed: pitch %d, roll %d, yaw %d.", rotationValue.pitch,
                           rotationValue.roll, rotationValue.yaw);
-
-            if (s_rotatingFlag == true && s_controlType == TEST_GIMBAL_CONTROL_TYPE_ANGLE) {
-                USER_LOG_WARN("gimbal is rotating.");
-                goto out1;
-            }
-
-            memcpy(&speedTemp, &rotationValue, sizeof(T_DjiAttitude3d));
-            DjiTest_GimbalSpeedLegalization(&speedTemp);
-            s_speed = speedTemp;
-
-            if (rotationValue.pitch != 0 || rotationValue.roll != 0 || rotationValue.yaw != 0) {
-                s_rotatingFlag = true;
-                s_controlType = TEST_GIMBAL_CONTROL_TYPE_SPEED;
-            } else {
-                s_rotatingFlag = false;
-            }
-
             break;
         default:
             USER_LOG_ERROR("gimbal rotation mode invalid: %d.", rotationMode);
-            returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
-            goto out1;
+            return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
     }
 
-out1:
-    if (osalHandler->MutexUnlock(s_commonMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex unlock error");
-        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-        goto out2;
+    djiStat = DjiTest_GimbalReadSnapshot(&snapshot);
+    if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return djiStat;
     }
 
-out2:
-    if (osalHandler->MutexUnlock(s_attitudeMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex unlock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+    // an angle rotation runs to its end, so is not interrupted by another rotation
+    if (snapshot.rotatingFlag == true && (rotationMode != DJI_GIMBAL_ROTATION_MODE_SPEED ||
+                                          snapshot.controlType == TEST_GIMBAL_CONTROL_TYPE_ANGLE)) {
+        USER_LOG_WARN("gimbal is rotating.");
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
     }
 
-    return returnCode;
+    djiStat = DjiTest_GimbalResolveRotation(rotationMode, rotationProperty, rotationValue, &snapshot,
+                                            &command.data.rotation);
+    if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("resolve gimbal rotation error: 0x%08llX.", djiStat);
+        return djiStat;
+    }
+
+    command.type = TEST_GIMBAL_COMMAND_ROTATE;
+
+    return DjiTest_GimbalPushCommand(&command);
 }
 
 /* Private functions definition-----------------------------------------------*/
@@ -405,19 +382,20 @@ static void *UserGimbal_Task(void *arg)
         USER_LOG_DEBUG("Subscribe topic quaternion success.");
     }
 
+#ifdef SYSTEM_ARCH_LINUX
+    // absolute deadlines, the time spent in one period does not shift the following ones
+    DjiUtilTime_PacerInit(&s_gimbalPacer, 1000000000ULL / PAYLOAD_GIMBAL_TASK_FREQ);
+#endif
+
     while (1) {
+#ifdef SYSTEM_ARCH_LINUX
+        DjiUtilTime_PacerWait(&s_gimbalPacer);
+#else
         osalHandler->TaskSleepMs(1000 / PAYLOAD_GIMBAL_TASK_FREQ);
+#endif
         step++;
 
-        if (osalHandler->MutexLock(s_attitudeMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-            USER_LOG_ERROR("mutex lock error");
-            continue;
-        }
-
-        if (osalHandler->MutexLock(s_commonMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-            USER_LOG_ERROR("mutex lock error");
-            goto out2;
-        }
+        DjiTest_GimbalApplyCommands();
 
         if (USER_UTIL_IS_WORK_TURN(step, 1, PAYLOAD_GIMBAL_TASK_FREQ)) {
             USER_LOG_DEBUG("gimbal attitude: pitch %d, roll %d, yaw %d.", s_attitudeInformation.attitude.pitch,
@@ -427,6 +405,15 @@ static void *UserGimbal_Task(void *arg)
                            s_systemState.fineTuneAngle.roll, s_systemState.fineTuneAngle.yaw);
         }
 
+#ifdef SYSTEM_ARCH_LINUX
+        if (USER_UTIL_IS_WORK_TURN(step, PAYLOAD_GIMBAL_STATISTICS_FREQ, PAYLOAD_GIMBAL_TASK_FREQ)) {
+            USER_LOG_DEBUG("gimbal loop lateness: p50 %llu us, p99 %llu us, max %llu us, overrun %u.",
+                           (unsigned long long) DjiUtilTime_PacerGetLatenessPercentileUs(&s_gimbalPacer, 50),
+                           (unsigned long long) DjiUtilTime_PacerGetLatenessPercentileUs(&s_gimbalPacer, 99),
+                           (unsigned long long) s_gimbalPacer.maxLatenessUs, s_gimbalPacer.overrunCount);
+        }
+#endif
+
         // update aircraft attitude
         if (USER_UTIL_IS_WORK_TURN(step, 50, PAYLOAD_GIMBAL_TASK_FREQ)) {
             djiStat = DjiFcSubscription_GetLatestValueOfTopic(DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION,
@@ -476,24 +463,28 @@ static void *UserGimbal_Task(void *arg)
         attitudeFTemp.pitch = s_attitudeInformation.attitude.pitch;
         attitudeFTemp.roll = s_attitudeInformation.attitude.roll;
         attitudeFTemp.yaw = s_attitudeInformation.attitude.yaw;
-        DjiTest_GimbalAngleLegalization(&attitudeFTemp, s_aircraftAttitude, &s_attitudeInformation.reachLimitFlag);
+        DjiTest_GimbalAngleLegalization(&attitudeFTemp, s_aircraftAttitude,
+                                        s_systemState.pitchRangeExtensionEnabledFlag,
+                                        &s_attitudeInformation.reachLimitFlag);
         s_attitudeInformation.attitude.pitch = attitudeFTemp.pitch;
         s_attitudeInformation.attitude.roll = attitudeFTemp.roll;
         s_attitudeInformation.attitude.yaw = attitudeFTemp.yaw;
 
-        DjiTest_GimbalAngleLegalization(&s_attitudeHighPrecision, s_aircraftAttitude, NULL);
+        DjiTest_GimbalAngleLegalization(&s_attitudeHighPrecision, s_aircraftAttitude,
+                                        s_systemState.pitchRangeExtensionEnabledFlag, NULL);
 
         attitudeFTemp.pitch = s_targetAttitude.pitch;
         attitudeFTemp.roll = s_targetAttitude.roll;
         attitudeFTemp.yaw = s_targetAttitude.yaw;
-        DjiTest_GimbalAngleLegalization(&attitudeFTemp, s_aircraftAttitude, NULL);
+        DjiTest_GimbalAngleLegalization(&attitudeFTemp, s_aircraftAttitude,
+                                        s_systemState.pitchRangeExtensionEnabledFlag, NULL);
         s_targetAttitude.pitch = attitudeFTemp.pitch;
         s_targetAttitude.roll = attitudeFTemp.roll;
         s_targetAttitude.yaw = attitudeFTemp.yaw;
 
         // rotation
         if (s_rotatingFlag != true)
-            goto out1;
+            goto calibration;
 
         nextAttitude.pitch =
             (float) s_attitudeHighPrecision.pitch + (float) s_speed.pitch / (float) PAYLOAD_GIMBAL_TASK_FREQ;
@@ -511,7 +502,9 @@ static void *UserGimbal_Task(void *arg)
                 (nextAttitude.yaw - s_targetAttitude.yaw) * s_speed.yaw >= 0 ? s_targetAttitude.yaw : nextAttitude.yaw;
         }
 
-        DjiTest_GimbalAngleLegalization(&nextAttitude, s_aircraftAttitude, &s_attitudeInformation.reachLimitFlag);
+        DjiTest_GimbalAngleLegalization(&nextAttitude, s_aircraftAttitude,
+                                        s_systemState.pitchRangeExtensionEnabledFlag,
+                                        &s_attitudeInformation.reachLimitFlag);
         s_attitudeInformation.attitude.pitch = nextAttitude.pitch;
         s_attitudeInformation.attitude.roll = nextAttitude.roll;
         s_attitudeInformation.attitude.yaw = nextAttitude.yaw;
@@ -532,45 +525,23 @@ static void *UserGimbal_Task(void *arg)
             }
         }
 
-out1:
-        if (osalHandler->MutexUnlock(s_commonMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-            USER_LOG_ERROR("mutex unlock error");
-            goto out2;
-        }
-
-out2:
-        if (osalHandler->MutexUnlock(s_attitudeMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-            USER_LOG_ERROR("mutex unlock error");
-            continue;
-        }
-
-        djiStat = osalHandler->GetTimeMs(&currentTime);
-        if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-            USER_LOG_ERROR("get current time error: 0x%08llX.", djiStat);
-            continue;
-        }
-
-        if (osalHandler->MutexLock(s_calibrationMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-            USER_LOG_ERROR("mutex lock error");
-            continue;
-        }
-
+calibration:
         // calibration
-        if (s_calibrationState.calibratingFlag != true)
-            goto unlockCalibrationMutex;
-
-        progressTemp = (currentTime - s_calibrationStartTime) * 100 / PAYLOAD_GIMBAL_CALIBRATION_TIME_MS;
-        if (progressTemp >= 100) {
-            s_calibrationState.calibratingFlag = false;
-            s_calibrationState.currentCalibrationProgress = 100;
-            s_calibrationState.currentCalibrationStage = DJI_GIMBAL_CALIBRATION_STAGE_COMPLETE;
+        if (s_calibrationState.calibratingFlag == true) {
+            djiStat = osalHandler->GetTimeMs(&currentTime);
+            if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+                USER_LOG_ERROR("get current time error: 0x%08llX.", djiStat);
+            } else {
+                progressTemp = (currentTime - s_calibrationStartTime) * 100 / PAYLOAD_GIMBAL_CALIBRATION_TIME_MS;
+                if (progressTemp >= 100) {
+                    s_calibrationState.calibratingFlag = false;
+                    s_calibrationState.currentCalibrationProgress = 100;
+                    s_calibrationState.currentCalibrationStage = DJI_GIMBAL_CALIBRATION_STAGE_COMPLETE;
+                }
+            }
         }
 
-unlockCalibrationMutex:
-        if (osalHandler->MutexUnlock(s_calibrationMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-            USER_LOG_ERROR("mutex unlock error");
-            continue;
-        }
+        DjiTest_GimbalPublishSnapshot();
     }
 }
 
@@ -580,97 +551,77 @@ unlockCalibrationMutex:
 
 static T_DjiReturnCode GetSystemState(T_DjiGimbalSystemState *systemState)
 {
-    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_TestGimbalSnapshot snapshot;
+    T_DjiReturnCode djiStat;
 
-    if (osalHandler->MutexLock(s_commonMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex lock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+    djiStat = DjiTest_GimbalReadSnapshot(&snapshot);
+    if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return djiStat;
     }
 
-    *systemState = s_systemState;
-
-    if (osalHandler->MutexUnlock(s_commonMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex unlock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-    }
+    *systemState = snapshot.systemState;
 
     return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
 }
 
 static T_DjiReturnCode GetAttitudeInformation(T_DjiGimbalAttitudeInformation *attitudeInformation)
 {
-    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_TestGimbalSnapshot snapshot;
+    T_DjiReturnCode djiStat;
 
-    if (osalHandler->MutexLock(s_attitudeMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex lock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+    djiStat = DjiTest_GimbalReadSnapshot(&snapshot);
+    if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return djiStat;
     }
 
-    *attitudeInformation = s_attitudeInformation;
-
-    if (osalHandler->MutexUnlock(s_attitudeMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex unlock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-    }
+    *attitudeInformation = snapshot.attitudeInformation;
 
     return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
 }
 
 static T_DjiReturnCode GetCalibrationState(T_DjiGimbalCalibrationState *calibrationState)
 {
-    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_TestGimbalSnapshot snapshot;
+    T_DjiReturnCode djiStat;
 
-    if (osalHandler->MutexLock(s_calibrationMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex lock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+    djiStat = DjiTest_GimbalReadSnapshot(&snapshot);
+    if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return djiStat;
     }
 
-    *calibrationState = s_calibrationState;
-
-    if (osalHandler->MutexUnlock(s_calibrationMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex unlock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-    }
+    *calibrationState = snapshot.calibrationState;
 
     return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
 }
 
 static T_DjiReturnCode GetRotationSpeed(T_DjiAttitude3d *rotationSpeed)
 {
-    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_TestGimbalSnapshot snapshot;
+    T_DjiReturnCode djiStat;
 
-    if (osalHandler->MutexLock(s_attitudeMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex lock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+    djiStat = DjiTest_GimbalReadSnapshot(&snapshot);
+    if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return djiStat;
     }
 
-    *rotationSpeed = s_speed;
-
-    if (osalHandler->MutexUnlock(s_attitudeMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex unlock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-    }
+    *rotationSpeed = snapshot.speed;
 
     return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
 }
 
 static T_DjiReturnCode GetJointAngle(T_DjiAttitude3d *jointAngle)
 {
-    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_TestGimbalSnapshot snapshot;
+    T_DjiReturnCode djiStat;
 
-    if (osalHandler->MutexLock(s_attitudeMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex lock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+    djiStat = DjiTest_GimbalReadSnapshot(&snapshot);
+    if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return djiStat;
     }
 
-    jointAngle->pitch = s_attitudeInformation.attitude.pitch - s_aircraftAttitude.pitch;
-    jointAngle->roll = s_attitudeInformation.attitude.roll - s_aircraftAttitude.roll;
-    jointAngle->yaw = s_attitudeInformation.attitude.yaw - s_aircraftAttitude.yaw;
-
-    if (osalHandler->MutexUnlock(s_attitudeMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex unlock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-    }
+    jointAngle->pitch = snapshot.attitudeInformation.attitude.pitch - snapshot.aircraftAttitude.pitch;
+    jointAngle->roll = snapshot.attitudeInformation.attitude.roll - snapshot.aircraftAttitude.roll;
+    jointAngle->yaw = snapshot.attitudeInformation.attitude.yaw - snapshot.aircraftAttitude.yaw;
 
     return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
 }
@@ -678,27 +629,21 @@ static T_DjiReturnCode GetJointAngle(T_DjiAttitude3d *jointAngle)
 static T_DjiReturnCode StartCalibrate(void)
 {
     T_DjiReturnCode djiStat;
+    T_TestGimbalCommand command = {0};
     T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
 
     USER_LOG_INFO("start calibrate gimbal.");
 
-    djiStat = osalHandler->GetTimeMs(&s_calibrationStartTime);
+    djiStat = osalHandler->GetTimeMs(&command.data.calibrationStartTime);
     if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
         USER_LOG_ERROR("get start time error: 0x%08llX.", djiStat);
+        return djiStat;
     }
 
-    if (osalHandler->MutexLock(s_calibrationMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex lock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-    }
-
-    s_calibrationState.calibratingFlag = true;
-    s_calibrationState.currentCalibrationProgress = 0;
-    s_calibrationState.currentCalibrationStage = DJI_GIMBAL_CALIBRATION_STAGE_PROCRESSING;
-
-    if (osalHandler->MutexUnlock(s_calibrationMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex unlock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+    command.type = TEST_GIMBAL_COMMAND_START_CALIBRATION;
+    djiStat = DjiTest_GimbalPushCommand(&command);
+    if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return djiStat;
     }
 
     DjiTest_WidgetLogAppend("calibrate gimbal.");
@@ -708,23 +653,25 @@ static T_DjiReturnCode StartCalibrate(void)
 static T_DjiReturnCode SetControllerSmoothFactor(uint8_t smoothingFactor, E_DjiGimbalAxis axis)
 {
     USER_LOG_INFO("set gimbal controller smooth factor: factor %d, axis %d.", smoothingFactor, axis);
-    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_TestGimbalCommand command = {0};
+    T_DjiReturnCode djiStat;
 
-    if (osalHandler->MutexLock(s_commonMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex lock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+    if (axis != DJI_GIMBAL_AXIS_PITCH && axis != DJI_GIMBAL_AXIS_YAW) {
+        USER_LOG_ERROR("axis is not supported.");
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
     }
 
-    if (axis == DJI_GIMBAL_AXIS_PITCH)
-        s_systemState.smoothFactor.pitch = smoothingFactor;
-    else if (axis == DJI_GIMBAL_AXIS_YAW)
-        s_systemState.smoothFactor.yaw = smoothingFactor;
-    else
-        USER_LOG_ERROR("axis is not supported.");
+    if (smoothingFactor > PAYLOAD_GIMBAL_SMOOTH_FACTOR_MAX) {
+        USER_LOG_ERROR("smooth factor is out of range: %d.", smoothingFactor);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
 
-    if (osalHandler->MutexUnlock(s_commonMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex unlock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+    command.type = TEST_GIMBAL_COMMAND_SET_SMOOTH_FACTOR;
+    command.data.axisSetting.value = smoothingFactor;
+    command.data.axisSetting.axis = axis;
+    djiStat = DjiTest_GimbalPushCommand(&command);
+    if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return djiStat;
     }
 
     DjiTest_WidgetLogAppend("set smooth factor: factor %d, axis %d.", smoothingFactor, axis);
@@ -734,18 +681,14 @@ static T_DjiReturnCode SetControllerSmoothFactor(uint8_t smoothingFactor, E_DjiG
 static T_DjiReturnCode SetPitchRangeExtensionEnabled(bool enabledFlag)
 {
     USER_LOG_INFO("set gimbal pitch range extension enable flag: %d.", enabledFlag);
-    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
-
-    if (osalHandler->MutexLock(s_commonMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex lock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-    }
-
-    s_systemState.pitchRangeExtensionEnabledFlag = enabledFlag;
+    T_TestGimbalCommand command = {0};
+    T_DjiReturnCode djiStat;
 
-    if (osalHandler->MutexUnlock(s_commonMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex unlock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+    command.type = TEST_GIMBAL_COMMAND_SET_PITCH_RANGE_EXTENSION;
+    command.data.enabledFlag = enabledFlag;
+    djiStat = DjiTest_GimbalPushCommand(&command);
+    if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return djiStat;
     }
 
     DjiTest_WidgetLogAppend("set gimbal pitch range extension enable: %d.", enabledFlag);
@@ -754,25 +697,27 @@ static T_DjiReturnCode SetPitchRangeExtensionEnabled(bool enabledFlag)
 
 static T_DjiReturnCode SetControllerMaxSpeedPercentage(uint8_t maxSpeedPercentage, E_DjiGimbalAxis axis)
 {
-    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_TestGimbalCommand command = {0};
+    T_DjiReturnCode djiStat;
 
     USER_LOG_INFO("set gimbal controller max speed: max speed %d, axis %d.", maxSpeedPercentage, axis);
 
-    if (osalHandler->MutexLock(s_commonMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex lock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+    if (axis != DJI_GIMBAL_AXIS_PITCH && axis != DJI_GIMBAL_AXIS_YAW) {
+        USER_LOG_ERROR("axis is not supported.");
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
     }
 
-    if (axis == DJI_GIMBAL_AXIS_PITCH)
-        s_systemState.maxSpeedPercentage.pitch = maxSpeedPercentage;
-    else if (axis == DJI_GIMBAL_AXIS_YAW)
-        s_systemState.maxSpeedPercentage.yaw = maxSpeedPercentage;
-    else
-        USER_LOG_ERROR("axis is not supported.");
+    if (maxSpeedPercentage < 1 || maxSpeedPercentage > 100) {
+        USER_LOG_ERROR("max speed percentage is out of range: %d.", maxSpeedPercentage);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
 
-    if (osalHandler->MutexUnlock(s_commonMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex unlock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+    command.type = TEST_GIMBAL_COMMAND_SET_MAX_SPEED_PERCENTAGE;
+    command.data.axisSetting.value = maxSpeedPercentage;
+    command.data.axisSetting.axis = axis;
+    djiStat = DjiTest_GimbalPushCommand(&command);
+    if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return djiStat;
     }
 
     DjiTest_WidgetLogAppend("set gimbal max speed: %d, axis %d.", maxSpeedPercentage, axis);
@@ -781,25 +726,15 @@ static T_DjiReturnCode SetControllerMaxSpeedPercentage(uint8_t maxSpeedPercentag
 
 static T_DjiReturnCode RestoreFactorySettings(void)
 {
-    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_TestGimbalCommand command = {0};
+    T_DjiReturnCode djiStat;
 
     USER_LOG_INFO("restore gimbal factory settings.");
 
-    if (osalHandler->MutexLock(s_commonMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex lock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-    }
-
-    s_systemState.pitchRangeExtensionEnabledFlag = false;
-    s_systemState.gimbalMode = DJI_GIMBAL_MODE_FREE;
-    memset(&s_systemState.fineTuneAngle, 0, sizeof(s_systemState.fineTuneAngle));
-    memset(&s_systemState.smoothFactor, 0, sizeof(s_systemState.smoothFactor));
-    s_systemState.maxSpeedPercentage.pitch = 1;
-    s_systemState.maxSpeedPercentage.yaw = 1;
-
-    if (osalHandler->MutexUnlock(s_commonMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex unlock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+    command.type = TEST_GIMBAL_COMMAND_RESTORE_FACTORY_SETTINGS;
+    djiStat = DjiTest_GimbalPushCommand(&command);
+    if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return djiStat;
     }
 
     DjiTest_WidgetLogAppend("restore gimbal factory settings.");
@@ -809,20 +744,26 @@ static T_DjiReturnCode RestoreFactorySettings(void)
 
 static T_DjiReturnCode SetMode(E_DjiGimbalMode mode)
 {
-    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_TestGimbalCommand command = {0};
+    T_DjiReturnCode djiStat;
 
     USER_LOG_INFO("set gimbal mode: %d.", mode);
 
-    if (osalHandler->MutexLock(s_commonMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex lock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+    switch (mode) {
+        case DJI_GIMBAL_MODE_FREE:
+        case DJI_GIMBAL_MODE_FPV:
+        case DJI_GIMBAL_MODE_YAW_FOLLOW:
+            break;
+        default:
+            USER_LOG_ERROR("gimbal mode is invalid: %d.", mode);
+            return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
     }
 
-    s_systemState.gimbalMode = mode;
-
-    if (osalHandler->MutexUnlock(s_commonMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex unlock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+    command.type = TEST_GIMBAL_COMMAND_SET_MODE;
+    command.data.gimbalMode = mode;
+    djiStat = DjiTest_GimbalPushCommand(&command);
+    if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return djiStat;
     }
 
     DjiTest_WidgetLogAppend("set gimbal mode: %d.", mode);
@@ -832,147 +773,74 @@ static T_DjiReturnCode SetMode(E_DjiGimbalMode mode)
 
 static T_DjiReturnCode Reset(E_DjiGimbalResetMode mode)
 {
-    T_DjiReturnCode djiReturnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
-    T_DjiAttitude3f attitudeFTemp = {0};
-    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_TestGimbalCommand command = {0};
+    T_DjiReturnCode djiStat;
 
     USER_LOG_INFO("reset gimbal: %d.", mode);
 
-    if (osalHandler->MutexLock(s_attitudeMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex lock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-    }
-
-    if (osalHandler->MutexLock(s_commonMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex lock error");
-        djiReturnCode = DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-        goto unlock2;
-    }
-
     switch (mode) {
         case DJI_GIMBAL_RESET_MODE_YAW:
-            s_attitudeInformation.attitude.yaw = s_aircraftAttitude.yaw + s_systemState.fineTuneAngle.yaw;
-
-            s_attitudeHighPrecision.yaw = s_aircraftAttitude.yaw + s_systemState.fineTuneAngle.yaw;
-            break;
         case DJI_GIMBAL_RESET_MODE_PITCH_AND_YAW:
-            s_attitudeInformation.attitude.pitch = s_systemState.fineTuneAngle.pitch;
-            s_attitudeInformation.attitude.yaw = s_aircraftAttitude.yaw + s_systemState.fineTuneAngle.yaw;
-
-            s_attitudeHighPrecision.pitch = s_systemState.fineTuneAngle.pitch;
-            s_attitudeHighPrecision.yaw = s_aircraftAttitude.yaw + s_systemState.fineTuneAngle.yaw;
-            break;
         case DJI_GIMBAL_RESET_MODE_PITCH_DOWNWARD_UPWARD_AND_YAW:
-            s_attitudeInformation.attitude.pitch =
-                s_systemState.fineTuneAngle.pitch + (s_systemState.mountedUpward ? 900 : -900);
-            s_attitudeInformation.attitude.yaw = s_aircraftAttitude.yaw + s_systemState.fineTuneAngle.yaw;
-
-            s_attitudeHighPrecision.pitch =
-                s_systemState.fineTuneAngle.pitch + (s_systemState.mountedUpward ? 900 : -900);
-            s_attitudeHighPrecision.yaw = s_aircraftAttitude.yaw + s_systemState.fineTuneAngle.yaw;
-            break;
         case DJI_GIMBAL_RESET_MODE_PITCH_DOWNWARD_UPWARD:
-            s_attitudeInformation.attitude.pitch =
-                s_systemState.fineTuneAngle.pitch + (s_systemState.mountedUpward ? 900 : -900);
-
-            s_attitudeHighPrecision.pitch =
-                s_systemState.fineTuneAngle.pitch + (s_systemState.mountedUpward ? 900 : -900);
             break;
         default:
             USER_LOG_ERROR("reset mode is invalid: %d.", mode);
-            djiReturnCode = DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
-            goto unlock1;
+            return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
     }
 
-    attitudeFTemp.pitch = s_attitudeInformation.attitude.pitch;
-    attitudeFTemp.roll = s_attitudeInformation.attitude.roll;
-    attitudeFTemp.yaw = s_attitudeInformation.attitude.yaw;
-    DjiTest_GimbalAngleLegalization(&attitudeFTemp, s_aircraftAttitude, &s_attitudeInformation.reachLimitFlag);
-    s_attitudeInformation.attitude.pitch = attitudeFTemp.pitch;
-    s_attitudeInformation.attitude.roll = attitudeFTemp.roll;
-    s_attitudeInformation.attitude.yaw = attitudeFTemp.yaw;
-    DjiTest_GimbalAngleLegalization(&s_attitudeHighPrecision, s_aircraftAttitude, NULL);
-
-    s_rotatingFlag = false;
-
-unlock1:
-    if (osalHandler->MutexUnlock(s_commonMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex unlock error");
-        djiReturnCode = DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-        goto unlock2;
-    }
-
-unlock2:
-    if (osalHandler->MutexUnlock(s_attitudeMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex unlock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+    command.type = TEST_GIMBAL_COMMAND_RESET;
+    command.data.resetMode = mode;
+    djiStat = DjiTest_GimbalPushCommand(&command);
+    if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return djiStat;
     }
 
     DjiTest_WidgetLogAppend("reset gimbal: %d.", mode);
 
-    return djiReturnCode;
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
 }
 
+/**
+ * @note The limits are checked here on the published state to answer the SDK right away, the gimbal task applies the
+ * same fine tune on its own state within one period.
+ */
 static T_DjiReturnCode FineTuneAngle(T_DjiAttitude3d fineTuneAngle)
 {
-    T_DjiReturnCode djiReturnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    T_DjiReturnCode djiStat;
     T_DjiGimbalReachLimitFlag attitudeReachLimitFlag = {0};
     T_DjiGimbalReachLimitFlag fineTuneAngleReachLimitFlag = {0};
     T_DjiAttitude3d aircraftAttitudeResetted = {0};
     T_DjiAttitude3f attitudeFTemp = {0};
-    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_TestGimbalSnapshot snapshot;
+    T_TestGimbalCommand command = {0};
 
     USER_LOG_INFO("gimbal fine tune angle: pitch %d, roll %d, yaw %d.", fineTuneAngle.pitch,
                   fineTuneAngle.roll, fineTuneAngle.yaw);
 
-    if (osalHandler->MutexLock(s_attitudeMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex lock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-    }
-
-    s_attitudeInformation.attitude.pitch += fineTuneAngle.pitch;
-    s_attitudeInformation.attitude.roll += fineTuneAngle.roll;
-    s_attitudeInformation.attitude.yaw += fineTuneAngle.yaw;
-    attitudeFTemp.pitch = s_attitudeInformation.attitude.pitch;
-    attitudeFTemp.roll = s_attitudeInformation.attitude.roll;
-    attitudeFTemp.yaw = s_attitudeInformation.attitude.yaw;
-    DjiTest_GimbalAngleLegalization(&attitudeFTemp, s_aircraftAttitude, &attitudeReachLimitFlag);
-    s_attitudeInformation.attitude.pitch = attitudeFTemp.pitch;
-    s_attitudeInformation.attitude.roll = attitudeFTemp.roll;
-    s_attitudeInformation.attitude.yaw = attitudeFTemp.yaw;
-
-    s_attitudeHighPrecision.pitch += fineTuneAngle.pitch;
-    s_attitudeHighPrecision.roll += fineTuneAngle.roll;
-    s_attitudeHighPrecision.yaw += fineTuneAngle.yaw;
-    DjiTest_GimbalAngleLegalization(&s_attitudeHighPrecision, s_aircraftAttitude, NULL);
-
-    if (osalHandler->MutexLock(s_commonMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex lock error");
-        djiReturnCode = DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-        goto unlock;
-    }
-
-    s_systemState.fineTuneAngle.pitch += fineTuneAngle.pitch;
-    s_systemState.fineTuneAngle.roll += fineTuneAngle.roll;
-    s_systemState.fineTuneAngle.yaw += fineTuneAngle.yaw;
-    attitudeFTemp.pitch = s_systemState.fineTuneAngle.pitch;
-    attitudeFTemp.roll = s_systemState.fineTuneAngle.roll;
-    attitudeFTemp.yaw = s_systemState.fineTuneAngle.yaw;
-    DjiTest_GimbalAngleLegalization(&attitudeFTemp, aircraftAttitudeResetted, &fineTuneAngleReachLimitFlag);
-    s_systemState.fineTuneAngle.pitch = attitudeFTemp.pitch;
-    s_systemState.fineTuneAngle.roll = attitudeFTemp.roll;
-    s_systemState.fineTuneAngle.yaw = attitudeFTemp.yaw;
-
-    if (osalHandler->MutexUnlock(s_commonMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex unlock error");
-        djiReturnCode = DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-        goto unlock;
+    djiStat = DjiTest_GimbalReadSnapshot(&snapshot);
+    if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return djiStat;
     }
 
-unlock:
-    if (osalHandler->MutexUnlock(s_attitudeMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("mutex unlock error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+    attitudeFTemp.pitch = snapshot.attitudeInformation.attitude.pitch + fineTuneAngle.pitch;
+    attitudeFTemp.roll = snapshot.attitudeInformation.attitude.roll + fineTuneAngle.roll;
+    attitudeFTemp.yaw = snapshot.attitudeInformation.attitude.yaw + fineTuneAngle.yaw;
+    DjiTest_GimbalAngleLegalization(&attitudeFTemp, snapshot.aircraftAttitude,
+                                    snapshot.systemState.pitchRangeExtensionEnabledFlag, &attitudeReachLimitFlag);
+
+    attitudeFTemp.pitch = snapshot.systemState.fineTuneAngle.pitch + fineTuneAngle.pitch;
+    attitudeFTemp.roll = snapshot.systemState.fineTuneAngle.roll + fineTuneAngle.roll;
+    attitudeFTemp.yaw = snapshot.systemState.fineTuneAngle.yaw + fineTuneAngle.yaw;
+    DjiTest_GimbalAngleLegalization(&attitudeFTemp, aircraftAttitudeResetted,
+                                    snapshot.systemState.pitchRangeExtensionEnabledFlag,
+                                    &fineTuneAngleReachLimitFlag);
+
+    command.type = TEST_GIMBAL_COMMAND_FINE_TUNE_ANGLE;
+    command.data.fineTuneAngle = fineTuneAngle;
+    djiStat = DjiTest_GimbalPushCommand(&command);
+    if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return djiStat;
     }
 
     if (((attitudeReachLimitFlag.pitch == true || fineTuneAngleReachLimitFlag.pitch == true) &&
@@ -985,17 +853,19 @@ unlock:
 
     DjiTest_WidgetLogAppend("gimbal fine tune angle: pitch %d, roll %d, yaw %d.", fineTuneAngle.pitch,
                   fineTuneAngle.roll, fineTuneAngle.yaw);
-    return djiReturnCode;
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
 }
 
 /**
  * @brief
  * @param attitude: in ground coordinate
  * @param aircraftAttitude: in ground coordinate
+ * @param pitchRangeExtensionEnabled
  * @param reachLimitFlag
  * @return
  */
 static T_DjiReturnCode DjiTest_GimbalAngleLegalization(T_DjiAttitude3f *attitude, T_DjiAttitude3d aircraftAttitude,
+                                                       bool pitchRangeExtensionEnabled,
                                                        T_DjiGimbalReachLimitFlag *reachLimitFlag)
 {
     T_DjiAttitude3d eulerAngleLimitMin;
@@ -1014,7 +884,7 @@ static T_DjiReturnCode DjiTest_GimbalAngleLegalization(T_DjiAttitude3f *attitude
     // calculate euler angle limit
     eulerAngleLimitMin = s_eulerAngleLimitMin;
     eulerAngleLimitMax = s_eulerAngleLimitMax;
-    if (s_systemState.pitchRangeExtensionEnabledFlag == true) {
+    if (pitchRangeExtensionEnabled == true) {
         eulerAngleLimitMin.pitch = s_pitchEulerAngleExtensionMin;
         eulerAngleLimitMax.pitch = s_pitchEulerAngleExtensionMax;
     }
@@ -1047,18 +917,15 @@ static T_DjiReturnCode DjiTest_GimbalAngleLegalization(T_DjiAttitude3f *attitude
     attitudeInBodyCoordinate.yaw = attitude->yaw - (float) aircraftAttitude.yaw;
 
     // modify attitude based on final angle limit
-    attitudeInBodyCoordinate.pitch = USER_UTIL_MIN(attitudeInBodyCoordinate.pitch,
-                                                   (float) finalAngleLimitInBodyCoordinateMax.pitch);
-    attitudeInBodyCoordinate.pitch = USER_UTIL_MAX(attitudeInBodyCoordinate.pitch,
-                                                   (float) finalAngleLimitInBodyCoordinateMin.pitch);
-    attitudeInBodyCoordinate.roll = USER_UTIL_MIN(attitudeInBodyCoordinate.roll,
-                                                  (float) finalAngleLimitInBodyCoordinateMax.roll);
-    attitudeInBodyCoordinate.roll = USER_UTIL_MAX(attitudeInBodyCoordinate.roll,
-                                                  (float) finalAngleLimitInBodyCoordinateMin.roll);
-    attitudeInBodyCoordinate.yaw = USER_UTIL_MIN(attitudeInBodyCoordinate.yaw,
-                                                 (float) finalAngleLimitInBodyCoordinateMax.yaw);
-    attitudeInBodyCoordinate.yaw = USER_UTIL_MAX(attitudeInBodyCoordinate.yaw,
-                                                 (float) finalAngleLimitInBodyCoordinateMin.yaw);
+    attitudeInBodyCoordinate.pitch = UtilAttitude_Clampf(attitudeInBodyCoordinate.pitch,
+                                                         (float) finalAngleLimitInBodyCoordinateMin.pitch,
+                                                         (float) finalAngleLimitInBodyCoordinateMax.pitch);
+    attitudeInBodyCoordinate.roll = UtilAttitude_Clampf(attitudeInBodyCoordinate.roll,
+                                                        (float) finalAngleLimitInBodyCoordinateMin.roll,
+                                                        (float) finalAngleLimitInBodyCoordinateMax.roll);
+    attitudeInBodyCoordinate.yaw = UtilAttitude_Clampf(attitudeInBodyCoordinate.yaw,
+                                                       (float) finalAngleLimitInBodyCoordinateMin.yaw,
+                                                       (float) finalAngleLimitInBodyCoordinateMax.yaw);
 
     // calculate gimbal attitude in ground coordinate
     attitude->pitch = attitudeInBodyCoordinate.pitch + (float) aircraftAttitude.pitch;
@@ -1137,29 +1004,311 @@ static void DjiTest_GimbalSpeedLegalization(T_DjiAttitude3d *speed)
 static T_DjiReturnCode DjiTest_GimbalCalculateGroundAttitudeBaseQuaternion(T_DjiFcSubscriptionQuaternion quaternion,
                                                                            T_DjiAttitude3d *attitude)
 {
-    double aircraftPitchInRad;
-    double aircraftRollInRad;
-    double aircraftYawInRad;
+    T_UtilAttitudeQuaternion aircraftQuaternion = {quaternion.q0, quaternion.q1, quaternion.q2, quaternion.q3};
+    T_UtilAttitudeEuler aircraftEuler;
 
     if (attitude == NULL) {
         USER_LOG_ERROR("Input argument is null.");
         return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
     }
 
-    aircraftPitchInRad = asin(2 * ((double) quaternion.q0 * quaternion.q2 - (double) quaternion.q3 * quaternion.q1));
-    attitude->pitch = aircraftPitchInRad * 180 / DJI_PI * 10;
+    aircraftEuler = UtilAttitude_QuaternionToEuler(aircraftQuaternion);
 
-    aircraftRollInRad = atan2(2 * ((double) quaternion.q0 * quaternion.q1 + (double) quaternion.q2 * quaternion.q3),
-                              (double) 1 -
-                              2 * ((double) quaternion.q1 * quaternion.q1 + (double) quaternion.q2 * quaternion.q2));
-    attitude->roll = aircraftRollInRad * 180 / DJI_PI * 10;
-
-    aircraftYawInRad = atan2(2 * ((double) quaternion.q0 * quaternion.q3 + (double) quaternion.q1 * quaternion.q2),
-                             (double) 1 -
-                             2 * ((double) quaternion.q2 * quaternion.q2 + (double) quaternion.q3 * quaternion.q3));
-    attitude->yaw = aircraftYawInRad * 180 / DJI_PI * 10;
+    attitude->pitch = aircraftEuler.pitch * UTIL_ATTITUDE_RAD_TO_DEG * 10;
+    attitude->roll = aircraftEuler.roll * UTIL_ATTITUDE_RAD_TO_DEG * 10;
+    attitude->yaw = aircraftEuler.yaw * UTIL_ATTITUDE_RAD_TO_DEG * 10;
 
     return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
 }
 
+static T_DjiReturnCode DjiTest_GimbalPushCommand(const T_TestGimbalCommand *command)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    uint32_t head;
+
+    // only the callbacks take this mutex, the gimbal task consumes the queue without it
+    if (osalHandler->MutexLock(s_commandMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("mutex lock error");
+        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+    }
+
+    head = s_commandHead;
+    if (head - __atomic_load_n(&s_commandTail, __ATOMIC_ACQUIRE) >= PAYLOAD_GIMBAL_COMMAND_QUEUE_SIZE) {
+        USER_LOG_WARN("gimbal command queue is full.");
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+    } else {
+        s_commandQueue[head % PAYLOAD_GIMBAL_COMMAND_QUEUE_SIZE] = *command;
+        __atomic_store_n(&s_commandHead, head + 1, __ATOMIC_RELEASE);
+    }
+
+    if (osalHandler->MutexUnlock(s_commandMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("mutex unlock error");
+        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+    }
+
+    return returnCode;
+}
+
+static void DjiTest_GimbalApplyCommands(void)
+{
+    uint32_t head = __atomic_load_n(&s_commandHead, __ATOMIC_ACQUIRE);
+    uint32_t tail = s_commandTail;
+    const T_TestGimbalCommand *command;
+
+    for (; tail != head; tail++) {
+        command = &s_commandQueue[tail % PAYLOAD_GIMBAL_COMMAND_QUEUE_SIZE];
+
+        switch (command->type) {
+            case TEST_GIMBAL_COMMAND_ROTATE:
+                DjiTest_GimbalApplyRotation(&command->data.rotation);
+                break;
+            case TEST_GIMBAL_COMMAND_RESET:
+                DjiTest_GimbalApplyReset(command->data.resetMode);
+                break;
+            case TEST_GIMBAL_COMMAND_FINE_TUNE_ANGLE:
+                DjiTest_GimbalApplyFineTuneAngle(command->data.fineTuneAngle);
+                break;
+            case TEST_GIMBAL_COMMAND_SET_MODE:
+                s_systemState.gimbalMode = command->data.gimbalMode;
+                break;
+            case TEST_GIMBAL_COMMAND_SET_SMOOTH_FACTOR:
+                if (command->data.axisSetting.axis == DJI_GIMBAL_AXIS_PITCH)
+                    s_systemState.smoothFactor.pitch = command->data.axisSetting.value;
+                else
+                    s_systemState.smoothFactor.yaw = command->data.axisSetting.value;
+                break;
+            case TEST_GIMBAL_COMMAND_SET_PITCH_RANGE_EXTENSION:
+                s_systemState.pitchRangeExtensionEnabledFlag = command->data.enabledFlag;
+                break;
+            case TEST_GIMBAL_COMMAND_SET_MAX_SPEED_PERCENTAGE:
+                if (command->data.axisSetting.axis == DJI_GIMBAL_AXIS_PITCH)
+                    s_systemState.maxSpeedPercentage.pitch = command->data.axisSetting.value;
+                else
+                    s_systemState.maxSpeedPercentage.yaw = command->data.axisSetting.value;
+                break;
+            case TEST_GIMBAL_COMMAND_RESTORE_FACTORY_SETTINGS:
+                s_systemState.pitchRangeExtensionEnabledFlag = false;
+                s_systemState.gimbalMode = DJI_GIMBAL_MODE_FREE;
+                memset(&s_systemState.fineTuneAngle, 0, sizeof(s_systemState.fineTuneAngle));
+                memset(&s_systemState.smoothFactor, 0, sizeof(s_systemState.smoothFactor));
+                s_systemState.maxSpeedPercentage.pitch = 1;
+                s_systemState.maxSpeedPercentage.yaw = 1;
+                break;
+            case TEST_GIMBAL_COMMAND_START_CALIBRATION:
+                s_calibrationStartTime = command->data.calibrationStartTime;
+                s_calibrationState.calibratingFlag = true;
+                s_calibrationState.currentCalibrationProgress = 0;
+                s_calibrationState.currentCalibrationStage = DJI_GIMBAL_CALIBRATION_STAGE_PROCRESSING;
+                break;
+            default:
+                USER_LOG_ERROR("gimbal command invalid: %d.", command->type);
+        }
+    }
+
+    __atomic_store_n(&s_commandTail, tail, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Resolve a rotation request against the published state: the target and speed of an angle rotation, or the
+ * legal speed of a speed rotation, so errors are returned to the SDK before the request is queued.
+ * @note A relative target is taken from the state of the last period, which the gimbal does not change by itself
+ * while it is not rotating.
+ */
+static T_DjiReturnCode DjiTest_GimbalResolveRotation(E_DjiGimbalRotationMode rotationMode,
+                                                     T_DjiGimbalRotationProperty rotationProperty,
+                                                     T_DjiAttitude3d rotationValue,
+                                                     const T_TestGimbalSnapshot *snapshot,
+                                                     T_TestGimbalRotationCommand *rotation)
+{
+    const T_DjiAttitude3d *attitude = &snapshot->attitudeInformation.attitude;
+    T_DjiAttitude3f targetAttitudeFTemp = {0};
+    uint16_t actionTime;
+
+    switch (rotationMode) {
+        case DJI_GIMBAL_ROTATION_MODE_RELATIVE_ANGLE:
+            rotation->targetAttitude.pitch = rotationProperty.rotationValueInvalidFlag.pitch == true ?
+                                             attitude->pitch : (attitude->pitch + rotationValue.pitch);
+            rotation->targetAttitude.roll = rotationProperty.rotationValueInvalidFlag.roll == true ?
+                                            attitude->roll : (attitude->roll + rotationValue.roll);
+            rotation->targetAttitude.yaw = rotationProperty.rotationValueInvalidFlag.yaw == true ?
+                                           attitude->yaw : (attitude->yaw + rotationValue.yaw);
+            actionTime = rotationProperty.relativeAngleRotation.actionTime;
+            break;
+        case DJI_GIMBAL_ROTATION_MODE_ABSOLUTE_ANGLE:
+            rotation->targetAttitude.pitch = rotationProperty.rotationValueInvalidFlag.pitch == true ?
+                                             attitude->pitch : rotationValue.pitch;
+            rotation->targetAttitude.roll = rotationProperty.rotationValueInvalidFlag.roll == true ?
+                                            attitude->roll : rotationValue.roll;
+            rotation->targetAttitude.yaw = rotationProperty.rotationValueInvalidFlag.yaw == true ?
+                                           attitude->yaw : rotationValue.yaw;
+            actionTime = rotationProperty.absoluteAngleRotation.actionTime;
+            break;
+        case DJI_GIMBAL_ROTATION_MODE_SPEED:
+            rotation->controlType = TEST_GIMBAL_CONTROL_TYPE_SPEED;
+            rotation->speed = rotationValue;
+            DjiTest_GimbalSpeedLegalization(&rotation->speed);
+            return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+        default:
+            return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
+    }
+
+    targetAttitudeFTemp.pitch = rotation->targetAttitude.pitch;
+    targetAttitudeFTemp.roll = rotation->targetAttitude.roll;
+    targetAttitudeFTemp.yaw = rotation->targetAttitude.yaw;
+    DjiTest_GimbalAngleLegalization(&targetAttitudeFTemp, snapshot->aircraftAttitude,
+                                    snapshot->systemState.pitchRangeExtensionEnabledFlag, NULL);
+    rotation->targetAttitude.pitch = targetAttitudeFTemp.pitch;
+    rotation->targetAttitude.roll = targetAttitudeFTemp.roll;
+    rotation->targetAttitude.yaw = targetAttitudeFTemp.yaw;
+    rotation->controlType = TEST_GIMBAL_CONTROL_TYPE_ANGLE;
+
+    return DjiTest_GimbalCalculateSpeed(*attitude, rotation->targetAttitude, actionTime, &rotation->speed);
+}
+
+/* The callback checked the rotating state one period ago, a rotation queued in the same period may have started. */
+static void DjiTest_GimbalApplyRotation(const T_TestGimbalRotationCommand *rotation)
+{
+    if (s_rotatingFlag == true && (rotation->controlType == TEST_GIMBAL_CONTROL_TYPE_ANGLE ||
+                                   s_controlType == TEST_GIMBAL_CONTROL_TYPE_ANGLE)) {
+        USER_LOG_WARN("gimbal is rotating.");
+        return;
+    }
+
+    s_speed = rotation->speed;
+    s_controlType = rotation->controlType;
+    if (rotation->controlType == TEST_GIMBAL_CONTROL_TYPE_ANGLE) {
+        s_targetAttitude = rotation->targetAttitude;
+        s_rotatingFlag = true;
+    } else {
+        s_rotatingFlag = rotation->speed.pitch != 0 || rotation->speed.roll != 0 || rotation->speed.yaw != 0;
+    }
+}
+
+static void DjiTest_GimbalApplyReset(E_DjiGimbalResetMode mode)
+{
+    T_DjiAttitude3f attitudeFTemp = {0};
+
+    switch (mode) {
+        case DJI_GIMBAL_RESET_MODE_YAW:
+            s_attitudeInformation.attitude.yaw = s_aircraftAttitude.yaw + s_systemState.fineTuneAngle.yaw;
+
+            s_attitudeHighPrecision.yaw = s_aircraftAttitude.yaw + s_systemState.fineTuneAngle.yaw;
+            break;
+        case DJI_GIMBAL_RESET_MODE_PITCH_AND_YAW:
+            s_attitudeInformation.attitude.pitch = s_systemState.fineTuneAngle.pitch;
+            s_attitudeInformation.attitude.yaw = s_aircraftAttitude.yaw + s_systemState.fineTuneAngle.yaw;
+
+            s_attitudeHighPrecision.pitch = s_systemState.fineTuneAngle.pitch;
+            s_attitudeHighPrecision.yaw = s_aircraftAttitude.yaw + s_systemState.fineTuneAngle.yaw;
+            break;
+        case DJI_GIMBAL_RESET_MODE_PITCH_DOWNWARD_UPWARD_AND_YAW:
+            s_attitudeInformation.attitude.pitch =
+                s_systemState.fineTuneAngle.pitch + (s_systemState.mountedUpward ? 900 : -900);
+            s_attitudeInformation.attitude.yaw = s_aircraftAttitude.yaw + s_systemState.fineTuneAngle.yaw;
+
+            s_attitudeHighPrecision.pitch =
+                s_systemState.fineTuneAngle.pitch + (s_systemState.mountedUpward ? 900 : -900);
+            s_attitudeHighPrecision.yaw = s_aircraftAttitude.yaw + s_systemState.fineTuneAngle.yaw;
+            break;
+        case DJI_GIMBAL_RESET_MODE_PITCH_DOWNWARD_UPWARD:
+            s_attitudeInformation.attitude.pitch =
+                s_systemState.fineTuneAngle.pitch + (s_systemState.mountedUpward ? 900 : -900);
+
+            s_attitudeHighPrecision.pitch =
+                s_systemState.fineTuneAngle.pitch + (s_systemState.mountedUpward ? 900 : -900);
+            break;
+        default:
+            return;
+    }
+
+    attitudeFTemp.pitch = s_attitudeInformation.attitude.pitch;
+    attitudeFTemp.roll = s_attitudeInformation.attitude.roll;
+    attitudeFTemp.yaw = s_attitudeInformation.attitude.yaw;
+    DjiTest_GimbalAngleLegalization(&attitudeFTemp, s_aircraftAttitude, s_systemState.pitchRangeExtensionEnabledFlag,
+                                    &s_attitudeInformation.reachLimitFlag);
+    s_attitudeInformation.attitude.pitch = attitudeFTemp.pitch;
+    s_attitudeInformation.attitude.roll = attitudeFTemp.roll;
+    s_attitudeInformation.attitude.yaw = attitudeFTemp.yaw;
+    DjiTest_GimbalAngleLegalization(&s_attitudeHighPrecision, s_aircraftAttitude,
+                                    s_systemState.pitchRangeExtensionEnabledFlag, NULL);
+
+    s_rotatingFlag = false;
+}
+
+static void DjiTest_GimbalApplyFineTuneAngle(T_DjiAttitude3d fineTuneAngle)
+{
+    T_DjiAttitude3d aircraftAttitudeResetted = {0};
+    T_DjiAttitude3f attitudeFTemp = {0};
+
+    s_attitudeInformation.attitude.pitch += fineTuneAngle.pitch;
+    s_attitudeInformation.attitude.roll += fineTuneAngle.roll;
+    s_attitudeInformation.attitude.yaw += fineTuneAngle.yaw;
+    attitudeFTemp.pitch = s_attitudeInformation.attitude.pitch;
+    attitudeFTemp.roll = s_attitudeInformation.attitude.roll;
+    attitudeFTemp.yaw = s_attitudeInformation.attitude.yaw;
+    DjiTest_GimbalAngleLegalization(&attitudeFTemp, s_aircraftAttitude, s_systemState.pitchRangeExtensionEnabledFlag,
+                                    NULL);
+    s_attitudeInformation.attitude.pitch = attitudeFTemp.pitch;
+    s_attitudeInformation.attitude.roll = attitudeFTemp.roll;
+    s_attitudeInformation.attitude.yaw = attitudeFTemp.yaw;
+
+    s_attitudeHighPrecision.pitch += fineTuneAngle.pitch;
+    s_attitudeHighPrecision.roll += fineTuneAngle.roll;
+    s_attitudeHighPrecision.yaw += fineTuneAngle.yaw;
+    DjiTest_GimbalAngleLegalization(&s_attitudeHighPrecision, s_aircraftAttitude,
+                                    s_systemState.pitchRangeExtensionEnabledFlag, NULL);
+
+    s_systemState.fineTuneAngle.pitch += fineTuneAngle.pitch;
+    s_systemState.fineTuneAngle.roll += fineTuneAngle.roll;
+    s_systemState.fineTuneAngle.yaw += fineTuneAngle.yaw;
+    attitudeFTemp.pitch = s_systemState.fineTuneAngle.pitch;
+    attitudeFTemp.roll = s_systemState.fineTuneAngle.roll;
+    attitudeFTemp.yaw = s_systemState.fineTuneAngle.yaw;
+    DjiTest_GimbalAngleLegalization(&attitudeFTemp, aircraftAttitudeResetted,
+                                    s_systemState.pitchRangeExtensionEnabledFlag, NULL);
+    s_systemState.fineTuneAngle.pitch = attitudeFTemp.pitch;
+    s_systemState.fineTuneAngle.roll = attitudeFTemp.roll;
+    s_systemState.fineTuneAngle.yaw = attitudeFTemp.yaw;
+}
+
+/* Only the gimbal task (or the start before it runs) publishes, so no lock is needed on the writer side. */
+static void DjiTest_GimbalPublishSnapshot(void)
+{
+    UtilSeqlock_WriteBegin(&s_snapshotSequence);
+
+    s_snapshot.systemState = s_systemState;
+    s_snapshot.attitudeInformation = s_attitudeInformation;
+    s_snapshot.calibrationState = s_calibrationState;
+    s_snapshot.speed = s_speed;
+    s_snapshot.aircraftAttitude = s_aircraftAttitude;
+    s_snapshot.rotatingFlag = s_rotatingFlag;
+    s_snapshot.controlType = s_controlType;
+
+    UtilSeqlock_WriteEnd(&s_snapshotSequence);
+}
+
+static T_DjiReturnCode DjiTest_GimbalReadSnapshot(T_TestGimbalSnapshot *snapshot)
+{
+    uint32_t sequence;
+    uint32_t retry;
+
+    for (retry = 0; retry < PAYLOAD_GIMBAL_SNAPSHOT_READ_RETRY_MAX; retry++) {
+        UtilSeqlock_ReadBackoff(retry);
+        sequence = UtilSeqlock_ReadBegin(&s_snapshotSequence);
+        if (sequence & 1) {
+            continue;
+        }
+
+        memcpy(snapshot, &s_snapshot, sizeof(T_TestGimbalSnapshot));
+
+        if (UtilSeqlock_ReadEnd(&s_snapshotSequence, sequence)) {
+            return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+        }
+    }
+
+    USER_LOG_WARN("read gimbal state busy.");
+    return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+}
+
 /****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
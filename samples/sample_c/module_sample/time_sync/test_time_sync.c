@@ -26,6 +26,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include <fc_subscription/test_fc_subscription.h>
 #include "test_time_sync.h"
+#include "test_time_sync_mapper.h"
 #include "dji_time_sync.h"
 #include "dji_logger.h"
 #include "utils/util_misc.h"
@@ -72,6 +73,7 @@ T_DjiReturnCode DjiTest_TimeSyncStartService(void)
 {
     T_DjiReturnCode djiStat;
     T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestTimeSyncMapperConfig mapperConfig;
 
     djiStat = DjiTimeSync_Init();
     if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
@@ -79,37 +81,52 @@ T_DjiReturnCode DjiTest_TimeSyncStartService(void)
         return djiStat;
     }
 
+    DjiTest_TimeSyncMapperGetDefaultConfig(&mapperConfig);
+    djiStat = DjiTest_TimeSyncMapperInit(&mapperConfig);
+    if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("time sync mapper init error.");
+        return djiStat;
+    }
+
     if (s_timeSyncHandler.PpsSignalResponseInit == NULL) {
         USER_LOG_ERROR("time sync handler PpsSignalResponseInit interface is NULL error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+        djiStat = DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+        goto err;
     }
 
     if (s_timeSyncHandler.GetNewestPpsTriggerLocalTimeUs == NULL) {
         USER_LOG_ERROR("time sync handler GetNewestPpsTriggerLocalTimeUs interface is NULL error");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+        djiStat = DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+        goto err;
     }
 
     // users must register getNewestPpsTriggerTime callback function
     djiStat = DjiTimeSync_RegGetNewestPpsTriggerTimeCallback(s_timeSyncHandler.GetNewestPpsTriggerLocalTimeUs);
     if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
         USER_LOG_ERROR("register GetNewestPpsTriggerLocalTimeUsCallback error.");
-        return djiStat;
+        goto err;
+    }
+
+    // the pps pin is set up before the task starts, so no task feeds the mapper when it has to be deinitialized
+    djiStat = s_timeSyncHandler.PpsSignalResponseInit();
+    if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("pps signal response init error");
+        goto err;
     }
 
     if (osalHandler->TaskCreate("user_time_sync_task", DjiTest_TimeSyncTask,
                                 DJI_TEST_TIME_SYNC_TASK_STACK_SIZE, NULL, &s_timeSyncThread) !=
         DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
         USER_LOG_ERROR("user time sync task create error.");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
-    }
-
-    djiStat = s_timeSyncHandler.PpsSignalResponseInit();
-    if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-        USER_LOG_ERROR("pps signal response init error");
-        return djiStat;
+        djiStat = DJI_ERROR_SYSTEM_MODULE_CODE_UNKNOWN;
+        goto err;
     }
 
     return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+
+err:
+    DjiTest_TimeSyncMapperDeInit();
+    return djiStat;
 }
 
 T_DjiReturnCode DjiTest_TimeSyncGetNewestPpsTriggerLocalTimeUs(uint64_t *localTimeUs)
@@ -132,8 +149,11 @@ T_DjiReturnCode DjiTest_TimeSyncGetNewestPpsTriggerLocalTimeUs(uint64_t *localTi
 static void *DjiTest_TimeSyncTask(void *arg)
 {
     T_DjiReturnCode djiStat;
-    uint32_t currentTimeMs = 0;
+    uint64_t currentTimeUs = 0;
+    uint64_t aircraftTimeUs = 0;
+    uint32_t errorBoundUs = 0;
     T_DjiTimeSyncAircraftTime aircraftTime = {0};
+    T_DjiTestTimeSyncMapperModel model = {0};
     T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
     uint8_t totalSatelliteNumber = 0;
 
@@ -148,26 +168,37 @@ static void *DjiTest_TimeSyncTask(void *arg)
             continue;
         }
 
-        djiStat = osalHandler->GetTimeMs(&currentTimeMs);
+        // one SDK conversion per period keeps the mapper model up to date, other modules convert through the model
+        djiStat = DjiTest_TimeSyncMapperSampleSdk();
+        if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            USER_LOG_ERROR("transfer to aircraft time error: 0x%08llX.", djiStat);
+            continue;
+        }
+
+        djiStat = osalHandler->GetTimeUs(&currentTimeUs);
         if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
             USER_LOG_ERROR("get current time error: 0x%08llX.", djiStat);
             continue;
         }
 
-        djiStat = DjiTimeSync_TransferToAircraftTime(currentTimeMs * 1000, &aircraftTime);
+        djiStat = DjiTest_TimeSyncMapperLocalToAircraftUs(currentTimeUs, &aircraftTimeUs, &errorBoundUs);
         if (djiStat != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
-            USER_LOG_ERROR("transfer to aircraft time error: 0x%08llX.", djiStat);
+            USER_LOG_ERROR("map to aircraft time error: 0x%08llX.", djiStat);
             continue;
         }
+        DjiTest_TimeSyncMapperUsToAircraftTime(aircraftTimeUs, &aircraftTime);
 
         if ((aircraftTime.second % 30) == 0) {
-            USER_LOG_INFO("current aircraft time is %04d-%02d-%02d %02d:%02d:%02d %d.",
-                        aircraftTime.year, aircraftTime.month, aircraftTime.day,
-                        aircraftTime.hour, aircraftTime.minute, aircraftTime.second, aircraftTime.microsecond);
+            DjiTest_TimeSyncMapperGetModel(&model);
+            USER_LOG_INFO("current aircraft time is %04d-%02d-%02d %02d:%02d:%02d %d, error bound %u us, "
+                          "drift %.3f ppm.", aircraftTime.year, aircraftTime.month, aircraftTime.day,
+                          aircraftTime.hour, aircraftTime.minute, aircraftTime.second, aircraftTime.microsecond,
+                          errorBoundUs, model.driftPpm);
         } else {
-            USER_LOG_DEBUG("current aircraft time is %04d-%02d-%02d %02d:%02d:%02d %d.",
+            USER_LOG_DEBUG("current aircraft time is %04d-%02d-%02d %02d:%02d:%02d %d, error bound %u us.",
                         aircraftTime.year, aircraftTime.month, aircraftTime.day,
-                        aircraftTime.hour, aircraftTime.minute, aircraftTime.second, aircraftTime.microsecond);
+                        aircraftTime.hour, aircraftTime.minute, aircraftTime.second, aircraftTime.microsecond,
+                        errorBoundUs);
         }
 
     }
@@ -0,0 +1,444 @@
+/**
+ ********************************************************************
+ * @file    test_time_sync_mapper.c
+ * @brief   The file defines a mapping from local time to aircraft time. Samples of the SDK conversion are
+ *          filtered by a two state Kalman filter (offset and drift) and the model is published behind a
+ *          sequence counter, so timestamps are converted in bulk without a lock or a call into the SDK.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include <string.h>
+#include "test_time_sync_mapper.h"
+#include "dji_logger.h"
+#include "dji_platform.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define DJI_TEST_TIME_SYNC_MAPPER_READ_RETRY_MAX            16
+/* Uncertainty of the drift before the second sample, covers any crystal. */
+#define DJI_TEST_TIME_SYNC_MAPPER_INITIAL_DRIFT_STD_PPM     100.0
+#define DJI_TEST_TIME_SYNC_MAPPER_US_PER_DAY                86400000000LL
+/* Days from 0000-03-01 to 1970-01-01 in the proleptic Gregorian calendar. */
+#define DJI_TEST_TIME_SYNC_MAPPER_EPOCH_DAYS                719468
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    bool valid;
+    uint64_t refLocalUs;
+    uint64_t refAircraftUs;
+    /*! Part of the offset below one microsecond, kept so rounding does not add up in the conversion. */
+    double refFractionUs;
+    /*! Drift as a ratio, aircraft time advances by (1 + rate) per local microsecond. */
+    double rate;
+    /*! Covariance of offset (us) and drift (ppm) at refLocalUs. */
+    double p00;
+    double p01;
+    double p11;
+    double frequencyVariance;
+    double boundSigma;
+} T_DjiTestTimeSyncMapperPublished;
+
+typedef struct {
+    bool inited;
+    bool started;
+    T_DjiTestTimeSyncMapperConfig config;
+    T_DjiMutexHandle writeMutex;
+    uint64_t refLocalUs;
+    /*! Whole microseconds of the offset, the filter state is kept relative to it to stay small in a double. */
+    int64_t baseOffsetUs;
+    double offsetUs;
+    double driftPpm;
+    double p00;
+    double p01;
+    double p11;
+    uint32_t outlierRunNum;
+    uint32_t sampleCount;
+    uint32_t rejectCount;
+    uint32_t resetCount;
+    uint32_t sequence;
+    T_DjiTestTimeSyncMapperPublished published;
+} T_DjiTestTimeSyncMapper;
+
+/* Private functions declaration ---------------------------------------------*/
+static void DjiTest_TimeSyncMapperRestart(uint64_t localTimeUs, int64_t offsetUs);
+static void DjiTest_TimeSyncMapperPublish(void);
+static T_DjiReturnCode DjiTest_TimeSyncMapperRead(T_DjiTestTimeSyncMapperPublished *published);
+static uint32_t DjiTest_TimeSyncMapperErrorBound(const T_DjiTestTimeSyncMapperPublished *published, int64_t dtUs);
+static int64_t DjiTest_TimeSyncMapperDaysFromCivil(int64_t year, uint32_t month, uint32_t day);
+
+/* Private variables ---------------------------------------------------------*/
+static T_DjiTestTimeSyncMapper s_timeSyncMapper;
+
+/* Exported functions definition ---------------------------------------------*/
+void DjiTest_TimeSyncMapperGetDefaultConfig(T_DjiTestTimeSyncMapperConfig *config)
+{
+    config->measurementNoiseUs = DJI_TEST_TIME_SYNC_MAPPER_DEFAULT_MEASUREMENT_NOISE_US;
+    config->frequencyNoisePpm = DJI_TEST_TIME_SYNC_MAPPER_DEFAULT_FREQUENCY_NOISE_PPM;
+    config->outlierSigma = DJI_TEST_TIME_SYNC_MAPPER_DEFAULT_OUTLIER_SIGMA;
+    config->resetOutlierNum = DJI_TEST_TIME_SYNC_MAPPER_DEFAULT_RESET_OUTLIER_NUM;
+    config->errorBoundSigma = DJI_TEST_TIME_SYNC_MAPPER_DEFAULT_ERROR_BOUND_SIGMA;
+}
+
+T_DjiReturnCode DjiTest_TimeSyncMapperInit(const T_DjiTestTimeSyncMapperConfig *config)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiReturnCode returnCode;
+
+    if (config == NULL || config->measurementNoiseUs <= 0 || config->frequencyNoisePpm < 0 ||
+        config->outlierSigma <= 0 || config->resetOutlierNum == 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    if (s_timeSyncMapper.inited) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+    }
+
+    memset(&s_timeSyncMapper, 0, sizeof(T_DjiTestTimeSyncMapper));
+    s_timeSyncMapper.config = *config;
+
+    returnCode = osalHandler->MutexCreate(&s_timeSyncMapper.writeMutex);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("create time sync mapper mutex error: 0x%08llX.", returnCode);
+        return returnCode;
+    }
+
+    s_timeSyncMapper.inited = true;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiTest_TimeSyncMapperDeInit(void)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    if (!s_timeSyncMapper.inited) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    s_timeSyncMapper.inited = false;
+    __atomic_store_n(&s_timeSyncMapper.published.valid, false, __ATOMIC_RELEASE);
+    osalHandler->MutexDestroy(s_timeSyncMapper.writeMutex);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Feed one pair of local and aircraft time into the model.
+ * @note The state is the offset (aircraft minus local time) and the drift of the local clock. Between samples the
+ * offset is predicted with the drift while its uncertainty grows with the frequency random walk, then the sample
+ * corrects both. A sample further than outlierSigma from the prediction is dropped; resetOutlierNum of them in a row
+ * mean the aircraft time really jumped and the model restarts from the newest sample.
+ */
+T_DjiReturnCode DjiTest_TimeSyncMapperAddSample(uint64_t localTimeUs, uint64_t aircraftTimeUs)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestTimeSyncMapper *mapper = &s_timeSyncMapper;
+    double measurementVariance = mapper->config.measurementNoiseUs * mapper->config.measurementNoiseUs;
+    double frequencyVariance = mapper->config.frequencyNoisePpm * mapper->config.frequencyNoisePpm;
+    int64_t offsetUs = (int64_t) (aircraftTimeUs - localTimeUs);
+    double dt;
+    double innovationUs;
+    double innovationVariance;
+    double gain0;
+    double gain1;
+    double p01;
+
+    if (!mapper->inited) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    osalHandler->MutexLock(mapper->writeMutex);
+
+    if (!mapper->started) {
+        mapper->driftPpm = 0;
+        mapper->p11 = DJI_TEST_TIME_SYNC_MAPPER_INITIAL_DRIFT_STD_PPM * DJI_TEST_TIME_SYNC_MAPPER_INITIAL_DRIFT_STD_PPM;
+        DjiTest_TimeSyncMapperRestart(localTimeUs, offsetUs);
+        DjiTest_TimeSyncMapperPublish();
+        osalHandler->MutexUnlock(mapper->writeMutex);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    if (localTimeUs <= mapper->refLocalUs) {
+        osalHandler->MutexUnlock(mapper->writeMutex);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    //predict, offset in us and drift in ppm make the drift move the offset by one us per second
+    dt = (double) (localTimeUs - mapper->refLocalUs) / 1000000.0;
+    innovationUs = (double) (offsetUs - mapper->baseOffsetUs) - (mapper->offsetUs + mapper->driftPpm * dt);
+    innovationVariance = mapper->p00 + 2 * dt * mapper->p01 + dt * dt * mapper->p11 +
+                         frequencyVariance * dt * dt * dt / 3 + measurementVariance;
+
+    if (innovationUs * innovationUs > mapper->config.outlierSigma * mapper->config.outlierSigma * innovationVariance) {
+        mapper->rejectCount++;
+        if (++mapper->outlierRunNum >= mapper->config.resetOutlierNum) {
+            USER_LOG_WARN("aircraft time moved %.0f us from the model, restart it.", innovationUs);
+            DjiTest_TimeSyncMapperRestart(localTimeUs, offsetUs);
+            mapper->resetCount++;
+            DjiTest_TimeSyncMapperPublish();
+        }
+        osalHandler->MutexUnlock(mapper->writeMutex);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    mapper->offsetUs += mapper->driftPpm * dt;
+    mapper->p00 += 2 * dt * mapper->p01 + dt * dt * mapper->p11 + frequencyVariance * dt * dt * dt / 3;
+    mapper->p01 += dt * mapper->p11 + frequencyVariance * dt * dt / 2;
+    mapper->p11 += frequencyVariance * dt;
+
+    //correct
+    gain0 = mapper->p00 / innovationVariance;
+    gain1 = mapper->p01 / innovationVariance;
+    mapper->offsetUs += gain0 * innovationUs;
+    mapper->driftPpm += gain1 * innovationUs;
+    p01 = mapper->p01;
+    mapper->p00 -= gain0 * mapper->p00;
+    mapper->p01 -= gain0 * p01;
+    mapper->p11 -= gain1 * p01;
+
+    //move whole microseconds of the offset into the base so the state keeps its fraction precise
+    mapper->baseOffsetUs += (int64_t) mapper->offsetUs;
+    mapper->offsetUs -= (double) (int64_t) mapper->offsetUs;
+
+    mapper->refLocalUs = localTimeUs;
+    mapper->outlierRunNum = 0;
+    mapper->sampleCount++;
+    DjiTest_TimeSyncMapperPublish();
+
+    osalHandler->MutexUnlock(mapper->writeMutex);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Take one sample of the SDK conversion at the current local time and feed it into the model.
+ */
+T_DjiReturnCode DjiTest_TimeSyncMapperSampleSdk(void)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTimeSyncAircraftTime aircraftTime = {0};
+    T_DjiReturnCode returnCode;
+    uint64_t localTimeUs = 0;
+
+    returnCode = osalHandler->GetTimeUs(&localTimeUs);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return returnCode;
+    }
+
+    returnCode = DjiTimeSync_TransferToAircraftTime(localTimeUs, &aircraftTime);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return returnCode;
+    }
+
+    return DjiTest_TimeSyncMapperAddSample(localTimeUs, DjiTest_TimeSyncMapperAircraftTimeToUs(&aircraftTime));
+}
+
+T_DjiReturnCode DjiTest_TimeSyncMapperLocalToAircraftUs(uint64_t localTimeUs, uint64_t *aircraftTimeUs,
+                                                        uint32_t *errorBoundUs)
+{
+    return DjiTest_TimeSyncMapperLocalToAircraftUsBatch(&localTimeUs, aircraftTimeUs, 1, errorBoundUs);
+}
+
+/**
+ * @brief Convert local timestamps to aircraft time in microseconds since 1970-01-01, e.g. all points of a frame.
+ * @note The model is copied once for the whole batch without taking a lock, so this may be called from any thread
+ * and at any rate. The error bound is the largest over the batch and grows with the distance from the newest sample.
+ * BUSY is returned before the first sample.
+ */
+T_DjiReturnCode DjiTest_TimeSyncMapperLocalToAircraftUsBatch(const uint64_t *localTimeUs, uint64_t *aircraftTimeUs,
+                                                             uint32_t count, uint32_t *errorBoundUs)
+{
+    T_DjiTestTimeSyncMapperPublished published;
+    T_DjiReturnCode returnCode;
+    int64_t dtUs;
+    int64_t minDtUs = INT64_MAX;
+    int64_t maxDtUs = INT64_MIN;
+    double correctionUs;
+    uint32_t boundUs;
+    uint32_t i;
+
+    if (localTimeUs == NULL || aircraftTimeUs == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    returnCode = DjiTest_TimeSyncMapperRead(&published);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return returnCode;
+    }
+
+    for (i = 0; i < count; i++) {
+        dtUs = (int64_t) (localTimeUs[i] - published.refLocalUs);
+        correctionUs = published.refFractionUs + (double) dtUs * published.rate;
+        aircraftTimeUs[i] = published.refAircraftUs + dtUs + (int64_t) floor(correctionUs + 0.5);
+        minDtUs = dtUs < minDtUs ? dtUs : minDtUs;
+        maxDtUs = dtUs > maxDtUs ? dtUs : maxDtUs;
+    }
+
+    if (errorBoundUs != NULL && count > 0) {
+        *errorBoundUs = DjiTest_TimeSyncMapperErrorBound(&published, minDtUs);
+        boundUs = DjiTest_TimeSyncMapperErrorBound(&published, maxDtUs);
+        *errorBoundUs = boundUs > *errorBoundUs ? boundUs : *errorBoundUs;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiTest_TimeSyncMapperGetModel(T_DjiTestTimeSyncMapperModel *model)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestTimeSyncMapper *mapper = &s_timeSyncMapper;
+
+    if (!mapper->inited || model == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    osalHandler->MutexLock(mapper->writeMutex);
+    model->offsetUs = mapper->baseOffsetUs + (int64_t) floor(mapper->offsetUs + 0.5);
+    model->driftPpm = mapper->driftPpm;
+    model->offsetStdUs = sqrt(mapper->p00);
+    model->driftStdPpm = sqrt(mapper->p11);
+    model->newestSampleLocalTimeUs = mapper->refLocalUs;
+    model->sampleCount = mapper->sampleCount;
+    model->rejectCount = mapper->rejectCount;
+    model->resetCount = mapper->resetCount;
+    osalHandler->MutexUnlock(mapper->writeMutex);
+
+    return mapper->started ? DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS : DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+}
+
+uint64_t DjiTest_TimeSyncMapperAircraftTimeToUs(const T_DjiTimeSyncAircraftTime *aircraftTime)
+{
+    int64_t days = DjiTest_TimeSyncMapperDaysFromCivil(aircraftTime->year, aircraftTime->month, aircraftTime->day);
+    uint64_t seconds = (uint64_t) aircraftTime->hour * 3600 + aircraftTime->minute * 60 + aircraftTime->second;
+
+    return (uint64_t) days * DJI_TEST_TIME_SYNC_MAPPER_US_PER_DAY + seconds * 1000000 + aircraftTime->microsecond;
+}
+
+void DjiTest_TimeSyncMapperUsToAircraftTime(uint64_t aircraftTimeUs, T_DjiTimeSyncAircraftTime *aircraftTime)
+{
+    int64_t days = (int64_t) (aircraftTimeUs / DJI_TEST_TIME_SYNC_MAPPER_US_PER_DAY) +
+                   DJI_TEST_TIME_SYNC_MAPPER_EPOCH_DAYS;
+    uint64_t dayUs = aircraftTimeUs % DJI_TEST_TIME_SYNC_MAPPER_US_PER_DAY;
+    uint32_t daySecond = (uint32_t) (dayUs / 1000000);
+    int64_t era = days / 146097;
+    uint32_t dayOfEra = (uint32_t) (days - era * 146097);
+    uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    uint32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    uint32_t monthIndex = (5 * dayOfYear + 2) / 153;
+
+    aircraftTime->day = (uint8_t) (dayOfYear - (153 * monthIndex + 2) / 5 + 1);
+    aircraftTime->month = (uint8_t) (monthIndex < 10 ? monthIndex + 3 : monthIndex - 9);
+    aircraftTime->year = (uint16_t) (yearOfEra + era * 400 + (aircraftTime->month <= 2));
+    aircraftTime->hour = (uint8_t) (daySecond / 3600);
+    aircraftTime->minute = (uint8_t) (daySecond / 60 % 60);
+    aircraftTime->second = (uint8_t) (daySecond % 60);
+    aircraftTime->microsecond = (uint32_t) (dayUs % 1000000);
+}
+
+/* Private functions definition-----------------------------------------------*/
+/* A jump of the aircraft time does not change the rate of the local clock, only the offset restarts. */
+static void DjiTest_TimeSyncMapperRestart(uint64_t localTimeUs, int64_t offsetUs)
+{
+    T_DjiTestTimeSyncMapper *mapper = &s_timeSyncMapper;
+
+    mapper->started = true;
+    mapper->refLocalUs = localTimeUs;
+    mapper->baseOffsetUs = offsetUs;
+    mapper->offsetUs = 0;
+    mapper->p00 = mapper->config.measurementNoiseUs * mapper->config.measurementNoiseUs;
+    mapper->p01 = 0;
+    mapper->outlierRunNum = 0;
+    mapper->sampleCount++;
+}
+
+/* Called with the write mutex held, readers retry while the sequence is odd or has changed. */
+static void DjiTest_TimeSyncMapperPublish(void)
+{
+    T_DjiTestTimeSyncMapper *mapper = &s_timeSyncMapper;
+    T_DjiTestTimeSyncMapperPublished *published = &mapper->published;
+    uint32_t sequence = mapper->sequence;
+
+    __atomic_store_n(&mapper->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    published->refLocalUs = mapper->refLocalUs;
+    published->refAircraftUs = mapper->refLocalUs + mapper->baseOffsetUs;
+    published->refFractionUs = mapper->offsetUs;
+    published->rate = mapper->driftPpm / 1000000.0;
+    published->p00 = mapper->p00;
+    published->p01 = mapper->p01;
+    published->p11 = mapper->p11;
+    published->frequencyVariance = mapper->config.frequencyNoisePpm * mapper->config.frequencyNoisePpm;
+    published->boundSigma = mapper->config.errorBoundSigma;
+    published->valid = true;
+
+    __atomic_store_n(&mapper->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+static T_DjiReturnCode DjiTest_TimeSyncMapperRead(T_DjiTestTimeSyncMapperPublished *published)
+{
+    uint32_t sequence;
+    uint32_t retry;
+
+    for (retry = 0; retry < DJI_TEST_TIME_SYNC_MAPPER_READ_RETRY_MAX; retry++) {
+        sequence = __atomic_load_n(&s_timeSyncMapper.sequence, __ATOMIC_ACQUIRE);
+        if (sequence & 1) {
+            continue;
+        }
+
+        memcpy(published, &s_timeSyncMapper.published, sizeof(T_DjiTestTimeSyncMapperPublished));
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&s_timeSyncMapper.sequence, __ATOMIC_RELAXED) == sequence) {
+            return published->valid ? DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS : DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+        }
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+}
+
+/* Offset uncertainty extrapolated dtUs away from the newest sample, in boundSigma standard deviations. */
+static uint32_t DjiTest_TimeSyncMapperErrorBound(const T_DjiTestTimeSyncMapperPublished *published, int64_t dtUs)
+{
+    double dt = (double) dtUs / 1000000.0;
+    double variance = published->p00 + 2 * dt * published->p01 + dt * dt * published->p11 +
+                      published->frequencyVariance * fabs(dt * dt * dt) / 3;
+
+    return (uint32_t) ceil(published->boundSigma * sqrt(variance > 0 ? variance : 0));
+}
+
+static int64_t DjiTest_TimeSyncMapperDaysFromCivil(int64_t year, uint32_t month, uint32_t day)
+{
+    int64_t era;
+    uint32_t yearOfEra;
+    uint32_t dayOfYear;
+    uint32_t dayOfEra;
+
+    year -= month <= 2;
+    era = (year >= 0 ? year : year - 399) / 400;
+    yearOfEra = (uint32_t) (year - era * 400);
+    dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+    return era * 146097 + dayOfEra - DJI_TEST_TIME_SYNC_MAPPER_EPOCH_DAYS;
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,92 @@
+/**
+ ********************************************************************
+ * @file    test_time_sync_mapper.h
+ * @brief   This is the header file for "test_time_sync_mapper.c", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef TEST_TIME_SYNC_MAPPER_H
+#define TEST_TIME_SYNC_MAPPER_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_typedef.h"
+#include "dji_time_sync.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+#define DJI_TEST_TIME_SYNC_MAPPER_DEFAULT_MEASUREMENT_NOISE_US      5.0
+#define DJI_TEST_TIME_SYNC_MAPPER_DEFAULT_FREQUENCY_NOISE_PPM       0.03
+#define DJI_TEST_TIME_SYNC_MAPPER_DEFAULT_OUTLIER_SIGMA             5.0
+#define DJI_TEST_TIME_SYNC_MAPPER_DEFAULT_RESET_OUTLIER_NUM         3
+#define DJI_TEST_TIME_SYNC_MAPPER_DEFAULT_ERROR_BOUND_SIGMA         3.0
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+    /*! Standard deviation of one sample of the SDK conversion, i.e. its resolution and PPS jitter. */
+    double measurementNoiseUs;
+    /*! Random walk of the local clock frequency, in ppm per square root of a second. */
+    double frequencyNoisePpm;
+    /*! Samples further than this many standard deviations from the prediction are rejected. */
+    double outlierSigma;
+    /*! Number of rejected samples in a row after which the model restarts, e.g. after the aircraft time jumped. */
+    uint32_t resetOutlierNum;
+    /*! Width of the reported error bound in standard deviations. */
+    double errorBoundSigma;
+} T_DjiTestTimeSyncMapperConfig;
+
+typedef struct {
+    /*! Aircraft time minus local time at the newest sample. */
+    int64_t offsetUs;
+    /*! Frequency error of the local clock, positive when the aircraft clock runs faster. */
+    double driftPpm;
+    double offsetStdUs;
+    double driftStdPpm;
+    uint64_t newestSampleLocalTimeUs;
+    uint32_t sampleCount;
+    uint32_t rejectCount;
+    uint32_t resetCount;
+} T_DjiTestTimeSyncMapperModel;
+
+/* Exported functions --------------------------------------------------------*/
+void DjiTest_TimeSyncMapperGetDefaultConfig(T_DjiTestTimeSyncMapperConfig *config);
+T_DjiReturnCode DjiTest_TimeSyncMapperInit(const T_DjiTestTimeSyncMapperConfig *config);
+T_DjiReturnCode DjiTest_TimeSyncMapperDeInit(void);
+T_DjiReturnCode DjiTest_TimeSyncMapperAddSample(uint64_t localTimeUs, uint64_t aircraftTimeUs);
+T_DjiReturnCode DjiTest_TimeSyncMapperSampleSdk(void);
+T_DjiReturnCode DjiTest_TimeSyncMapperLocalToAircraftUs(uint64_t localTimeUs, uint64_t *aircraftTimeUs,
+                                                        uint32_t *errorBoundUs);
+T_DjiReturnCode DjiTest_TimeSyncMapperLocalToAircraftUsBatch(const uint64_t *localTimeUs, uint64_t *aircraftTimeUs,
+                                                             uint32_t count, uint32_t *errorBoundUs);
+T_DjiReturnCode DjiTest_TimeSyncMapperGetModel(T_DjiTestTimeSyncMapperModel *model);
+
+uint64_t DjiTest_TimeSyncMapperAircraftTimeToUs(const T_DjiTimeSyncAircraftTime *aircraftTime);
+void DjiTest_TimeSyncMapperUsToAircraftTime(uint64_t aircraftTimeUs, T_DjiTimeSyncAircraftTime *aircraftTime);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TEST_TIME_SYNC_MAPPER_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
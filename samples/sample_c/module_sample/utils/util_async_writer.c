@@ -0,0 +1,367 @@
+/**
+ ********************************************************************
+ * @file    util_async_writer.c
+ * @brief   The file defines a double-buffered file writer which moves write() and fdatasync() calls
+ *          from the producer thread to a dedicated writer task.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#ifdef SYSTEM_ARCH_LINUX
+
+#include "util_async_writer.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "dji_platform.h"
+#include "util_misc.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define UTIL_ASYNC_WRITER_BUFFER_NUM            2
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    uint8_t *data;
+    uint32_t len;
+    bool syncRequest;
+    bool stopRequest;
+} T_UtilAsyncWriterBuffer;
+
+typedef struct {
+    int fd;
+    T_UtilAsyncWriterConfig config;
+    T_UtilAsyncWriterBuffer buffers[UTIL_ASYNC_WRITER_BUFFER_NUM];
+    uint8_t fillIndex;
+    uint8_t writeIndex;
+    int writeErrno;
+    uint32_t lastSyncTimeMs;
+    T_DjiMutexHandle producerMutex;
+    T_DjiSemaHandle fullSema;
+    T_DjiSemaHandle emptySema;
+    T_DjiSemaHandle syncSema;
+    pthread_t writerTask;
+    bool isWriterTaskCreated;
+    T_UtilAsyncWriterStatistics statistics;
+} T_UtilAsyncWriter;
+
+/* Private functions declaration ---------------------------------------------*/
+static void *UtilAsyncWriter_WriterTask(void *arg);
+static T_DjiReturnCode UtilAsyncWriter_SubmitBuffer(T_UtilAsyncWriter *writer, bool syncRequest, bool stopRequest);
+static void UtilAsyncWriter_Free(T_UtilAsyncWriter *writer);
+
+/* Private values ------------------------------------------------------------*/
+
+/* Exported functions definition ---------------------------------------------*/
+void UtilAsyncWriter_GetDefaultConfig(T_UtilAsyncWriterConfig *config)
+{
+    config->bufferSize = UTIL_ASYNC_WRITER_DEFAULT_BUFFER_SIZE;
+    config->fsyncIntervalMs = UTIL_ASYNC_WRITER_DEFAULT_FSYNC_INTERVAL_MS;
+    config->preallocateSize = 0;
+    config->append = false;
+}
+
+T_DjiReturnCode UtilAsyncWriter_Open(const char *filePath, const T_UtilAsyncWriterConfig *config,
+                                     T_UtilAsyncWriterHandle *writerHandle)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_UtilAsyncWriter *writer;
+    int i;
+
+    if (filePath == NULL || config == NULL || writerHandle == NULL || config->bufferSize == 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    writer = calloc(1, sizeof(T_UtilAsyncWriter));
+    if (writer == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+    writer->fd = -1;
+    writer->config = *config;
+    writer->config.bufferSize = (config->bufferSize + UTIL_ASYNC_WRITER_BUFFER_ALIGNMENT - 1) /
+                                UTIL_ASYNC_WRITER_BUFFER_ALIGNMENT * UTIL_ASYNC_WRITER_BUFFER_ALIGNMENT;
+
+    for (i = 0; i < UTIL_ASYNC_WRITER_BUFFER_NUM; i++) {
+        if (posix_memalign((void **) &writer->buffers[i].data, UTIL_ASYNC_WRITER_BUFFER_ALIGNMENT,
+                           writer->config.bufferSize) != 0) {
+            writer->buffers[i].data = NULL;
+            UtilAsyncWriter_Free(writer);
+            return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+        }
+    }
+
+    if (osalHandler->MutexCreate(&writer->producerMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS ||
+        osalHandler->SemaphoreCreate(0, &writer->fullSema) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS ||
+        osalHandler->SemaphoreCreate(UTIL_ASYNC_WRITER_BUFFER_NUM - 1, &writer->emptySema) !=
+        DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS ||
+        osalHandler->SemaphoreCreate(0, &writer->syncSema) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        UtilAsyncWriter_Free(writer);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    writer->fd = open(filePath, O_WRONLY | O_CREAT | O_CLOEXEC | (config->append ? O_APPEND : O_TRUNC), 0644);
+    if (writer->fd < 0) {
+        UtilAsyncWriter_Free(writer);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    //reserve the blocks up front so the writer task does not extend the file on every write, failure is harmless
+    if (config->preallocateSize > 0 &&
+        fallocate(writer->fd, FALLOC_FL_KEEP_SIZE, 0, (off_t) config->preallocateSize) != 0) {
+        writer->statistics.preallocateFailCount++;
+    }
+
+    osalHandler->GetTimeMs(&writer->lastSyncTimeMs);
+    //a joinable thread instead of an osal task, the osal only cancels tasks and would leak one thread per file
+    if (pthread_create(&writer->writerTask, NULL, UtilAsyncWriter_WriterTask, writer) != 0) {
+        UtilAsyncWriter_Free(writer);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+    writer->isWriterTaskCreated = true;
+    pthread_setname_np(writer->writerTask, "async_writer");
+
+    *writerHandle = writer;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Copy data into the fill buffer. The caller only blocks when both buffers are waiting for the disk.
+ */
+T_DjiReturnCode UtilAsyncWriter_Write(T_UtilAsyncWriterHandle writerHandle, const uint8_t *data, uint32_t len)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_UtilAsyncWriter *writer = (T_UtilAsyncWriter *) writerHandle;
+    T_UtilAsyncWriterBuffer *buffer;
+    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    uint32_t copyLen;
+
+    if (writer == NULL || (data == NULL && len > 0)) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    if (writer->writeErrno != 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    osalHandler->MutexLock(writer->producerMutex);
+    while (len > 0) {
+        buffer = &writer->buffers[writer->fillIndex];
+        copyLen = USER_UTIL_MIN(len, writer->config.bufferSize - buffer->len);
+        memcpy(buffer->data + buffer->len, data, copyLen);
+        buffer->len += copyLen;
+        data += copyLen;
+        len -= copyLen;
+
+        if (buffer->len == writer->config.bufferSize) {
+            returnCode = UtilAsyncWriter_SubmitBuffer(writer, false, false);
+            if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+                break;
+            }
+        }
+    }
+    osalHandler->MutexUnlock(writer->producerMutex);
+
+    return returnCode;
+}
+
+/**
+ * @brief Hand the buffered data to the writer task and wait until it is written and synced to disk.
+ */
+T_DjiReturnCode UtilAsyncWriter_Flush(T_UtilAsyncWriterHandle writerHandle)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_UtilAsyncWriter *writer = (T_UtilAsyncWriter *) writerHandle;
+    T_DjiReturnCode returnCode;
+
+    if (writer == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    osalHandler->MutexLock(writer->producerMutex);
+    returnCode = UtilAsyncWriter_SubmitBuffer(writer, true, false);
+    if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        osalHandler->SemaphoreWait(writer->syncSema);
+    }
+    osalHandler->MutexUnlock(writer->producerMutex);
+
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return returnCode;
+    }
+
+    return writer->writeErrno == 0 ? DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS : DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+}
+
+T_DjiReturnCode UtilAsyncWriter_Close(T_UtilAsyncWriterHandle writerHandle)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_UtilAsyncWriter *writer = (T_UtilAsyncWriter *) writerHandle;
+    T_DjiReturnCode returnCode;
+
+    if (writer == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    osalHandler->MutexLock(writer->producerMutex);
+    returnCode = UtilAsyncWriter_SubmitBuffer(writer, true, true);
+    if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        osalHandler->SemaphoreWait(writer->syncSema);
+    }
+    osalHandler->MutexUnlock(writer->producerMutex);
+
+    if (writer->writeErrno != 0) {
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+    UtilAsyncWriter_Free(writer);
+
+    return returnCode;
+}
+
+void UtilAsyncWriter_GetStatistics(T_UtilAsyncWriterHandle writerHandle, T_UtilAsyncWriterStatistics *statistics)
+{
+    T_UtilAsyncWriter *writer = (T_UtilAsyncWriter *) writerHandle;
+
+    if (writer == NULL || statistics == NULL) {
+        return;
+    }
+
+    DjiPlatform_GetOsalHandler()->MutexLock(writer->producerMutex);
+    *statistics = writer->statistics;
+    DjiPlatform_GetOsalHandler()->MutexUnlock(writer->producerMutex);
+}
+
+/* Private functions definition-----------------------------------------------*/
+static T_DjiReturnCode UtilAsyncWriter_SubmitBuffer(T_UtilAsyncWriter *writer, bool syncRequest, bool stopRequest)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    uint64_t waitStartUs = 0;
+    uint64_t waitEndUs = 0;
+
+    writer->buffers[writer->fillIndex].syncRequest = syncRequest;
+    writer->buffers[writer->fillIndex].stopRequest = stopRequest;
+    osalHandler->SemaphorePost(writer->fullSema);
+
+    if (stopRequest) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    if (osalHandler->SemaphoreTimedWait(writer->emptySema, 0) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        writer->statistics.producerWaitCount++;
+        osalHandler->GetTimeUs(&waitStartUs);
+        osalHandler->SemaphoreWait(writer->emptySema);
+        osalHandler->GetTimeUs(&waitEndUs);
+        writer->statistics.producerWaitMaxUs = USER_UTIL_MAX(writer->statistics.producerWaitMaxUs,
+                                                             waitEndUs - waitStartUs);
+    }
+    writer->fillIndex = (uint8_t) ((writer->fillIndex + 1) % UTIL_ASYNC_WRITER_BUFFER_NUM);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+static void *UtilAsyncWriter_WriterTask(void *arg)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_UtilAsyncWriter *writer = (T_UtilAsyncWriter *) arg;
+    T_UtilAsyncWriterBuffer *buffer;
+    uint32_t writtenLen;
+    uint32_t currentTimeMs;
+    ssize_t result;
+    bool stopRequest = false;
+    bool syncRequest;
+
+    while (!stopRequest) {
+        osalHandler->SemaphoreWait(writer->fullSema);
+        buffer = &writer->buffers[writer->writeIndex];
+
+        writtenLen = 0;
+        while (writtenLen < buffer->len && writer->writeErrno == 0) {
+            result = write(writer->fd, buffer->data + writtenLen, buffer->len - writtenLen);
+            if (result < 0) {
+                if (errno != EINTR) {
+                    writer->writeErrno = errno;
+                }
+                continue;
+            }
+            writtenLen += (uint32_t) result;
+            writer->statistics.writeCount++;
+        }
+        writer->statistics.bytesWritten += writtenLen;
+
+        osalHandler->GetTimeMs(&currentTimeMs);
+        if (buffer->syncRequest ||
+            (writer->config.fsyncIntervalMs > 0 &&
+             currentTimeMs - writer->lastSyncTimeMs >= writer->config.fsyncIntervalMs)) {
+            fdatasync(writer->fd);
+            writer->statistics.fsyncCount++;
+            writer->lastSyncTimeMs = currentTimeMs;
+        }
+
+        stopRequest = buffer->stopRequest;
+        syncRequest = buffer->syncRequest;
+        buffer->len = 0;
+        buffer->syncRequest = false;
+        buffer->stopRequest = false;
+        writer->writeIndex = (uint8_t) ((writer->writeIndex + 1) % UTIL_ASYNC_WRITER_BUFFER_NUM);
+        osalHandler->SemaphorePost(writer->emptySema);
+
+        //post last, the producer may free the writer as soon as a stop request is acknowledged
+        if (syncRequest) {
+            osalHandler->SemaphorePost(writer->syncSema);
+        }
+    }
+
+    return NULL;
+}
+
+static void UtilAsyncWriter_Free(T_UtilAsyncWriter *writer)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    int i;
+
+    //the task leaves its loop on the acknowledged stop request, so joining here does not block
+    if (writer->isWriterTaskCreated) {
+        pthread_join(writer->writerTask, NULL);
+    }
+    if (writer->fd >= 0) {
+        close(writer->fd);
+    }
+    if (writer->syncSema != NULL) {
+        osalHandler->SemaphoreDestroy(writer->syncSema);
+    }
+    if (writer->emptySema != NULL) {
+        osalHandler->SemaphoreDestroy(writer->emptySema);
+    }
+    if (writer->fullSema != NULL) {
+        osalHandler->SemaphoreDestroy(writer->fullSema);
+    }
+    if (writer->producerMutex != NULL) {
+        osalHandler->MutexDestroy(writer->producerMutex);
+    }
+    for (i = 0; i < UTIL_ASYNC_WRITER_BUFFER_NUM; i++) {
+        free(writer->buffers[i].data);
+    }
+    free(writer);
+}
+
+#endif
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
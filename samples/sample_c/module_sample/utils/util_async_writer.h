@@ -0,0 +1,84 @@
+/**
+ ********************************************************************
+ * @file    util_async_writer.h
+ * @brief   This is the header file for "util_async_writer.c", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef UTIL_ASYNC_WRITER_H
+#define UTIL_ASYNC_WRITER_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_typedef.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef SYSTEM_ARCH_LINUX
+
+/* Exported constants --------------------------------------------------------*/
+#define UTIL_ASYNC_WRITER_DEFAULT_BUFFER_SIZE          (1024 * 1024)
+#define UTIL_ASYNC_WRITER_DEFAULT_FSYNC_INTERVAL_MS    1000
+/* Buffers are page aligned and rounded up to a whole number of pages, so full buffers are written at aligned offsets. */
+#define UTIL_ASYNC_WRITER_BUFFER_ALIGNMENT             4096
+
+/* Exported types ------------------------------------------------------------*/
+typedef void *T_UtilAsyncWriterHandle;
+
+typedef struct {
+    /*! Size of each of the two buffers, data is handed to the writer task when one is full. */
+    uint32_t bufferSize;
+    /*! Interval of fdatasync() done by the writer task, 0 means only sync on flush and close. */
+    uint32_t fsyncIntervalMs;
+    /*! Expected file size reserved with fallocate() on open, 0 to disable. The file size is not changed. */
+    uint64_t preallocateSize;
+    /*! Open with O_APPEND and keep existing content instead of truncating the file. */
+    bool append;
+} T_UtilAsyncWriterConfig;
+
+typedef struct {
+    uint64_t bytesWritten;
+    uint32_t writeCount;
+    uint32_t fsyncCount;
+    uint32_t producerWaitCount;
+    uint64_t producerWaitMaxUs;
+    uint32_t preallocateFailCount;
+} T_UtilAsyncWriterStatistics;
+
+/* Exported functions --------------------------------------------------------*/
+void UtilAsyncWriter_GetDefaultConfig(T_UtilAsyncWriterConfig *config);
+T_DjiReturnCode UtilAsyncWriter_Open(const char *filePath, const T_UtilAsyncWriterConfig *config,
+                                     T_UtilAsyncWriterHandle *writerHandle);
+T_DjiReturnCode UtilAsyncWriter_Write(T_UtilAsyncWriterHandle writerHandle, const uint8_t *data, uint32_t len);
+T_DjiReturnCode UtilAsyncWriter_Flush(T_UtilAsyncWriterHandle writerHandle);
+T_DjiReturnCode UtilAsyncWriter_Close(T_UtilAsyncWriterHandle writerHandle);
+void UtilAsyncWriter_GetStatistics(T_UtilAsyncWriterHandle writerHandle, T_UtilAsyncWriterStatistics *statistics);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UTIL_ASYNC_WRITER_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
@@ -0,0 +1,406 @@
+/**
+ ********************************************************************
+ * @file    util_attitude.h
+ * @brief   Header-only attitude math shared by the gimbal and flight samples: quaternion, Euler angle
+ * and rotation matrix conversions with batch variants, fast atan2/asin with bounded error and SLERP.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef UTIL_ATTITUDE_H
+#define UTIL_ATTITUDE_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include "dji_typedef.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+#define UTIL_ATTITUDE_PI                        3.14159265358979f
+#define UTIL_ATTITUDE_HALF_PI                   1.57079632679490f
+#define UTIL_ATTITUDE_RAD_TO_DEG                (180.0f / UTIL_ATTITUDE_PI)
+#define UTIL_ATTITUDE_DEG_TO_RAD                (UTIL_ATTITUDE_PI / 180.0f)
+/* Max absolute error of UtilAttitude_FastAtan2f() and UtilAttitude_FastAsinf() in radian, about 0.00015 degree. */
+#define UTIL_ATTITUDE_FAST_TRIG_MAX_ERROR       2.5e-6f
+/* Above this cosine of the angle between the two quaternions SLERP falls back to normalized linear interpolation. */
+#define UTIL_ATTITUDE_SLERP_LINEAR_THRESHOLD    0.9995f
+
+#if defined(__CC_ARM)
+#define UTIL_ATTITUDE_INLINE                    static __inline
+#else
+#define UTIL_ATTITUDE_INLINE                    static inline
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define UTIL_ATTITUDE_RESTRICT                  __restrict__
+#else
+#define UTIL_ATTITUDE_RESTRICT
+#endif
+
+/* Exported types ------------------------------------------------------------*/
+/*! Unit quaternion rotating body frame to ground frame, same layout as T_DjiFcSubscriptionQuaternion. */
+typedef struct {
+    dji_f32_t q0; /*!< w */
+    dji_f32_t q1; /*!< x */
+    dji_f32_t q2; /*!< y */
+    dji_f32_t q3; /*!< z */
+} T_UtilAttitudeQuaternion;
+
+/*! Z-Y-X (yaw, pitch, roll) Euler angles, unit: radian. */
+typedef struct {
+    dji_f32_t roll;
+    dji_f32_t pitch;
+    dji_f32_t yaw;
+} T_UtilAttitudeEuler;
+
+/*! Row-major rotation matrix from body frame to ground frame. */
+typedef struct {
+    dji_f32_t m[9];
+} T_UtilAttitudeMatrix;
+
+/* Exported functions --------------------------------------------------------*/
+UTIL_ATTITUDE_INLINE dji_f32_t UtilAttitude_Clampf(dji_f32_t value, dji_f32_t min, dji_f32_t max)
+{
+    value = value > max ? max : value;
+    return value < min ? min : value;
+}
+
+/**
+ * @brief Polynomial atan2 without branches so that batch loops vectorize.
+ * @note Max absolute error is UTIL_ATTITUDE_FAST_TRIG_MAX_ERROR, atan2(0, 0) returns 0.
+ */
+UTIL_ATTITUDE_INLINE dji_f32_t UtilAttitude_FastAtan2f(dji_f32_t y, dji_f32_t x)
+{
+    dji_f32_t absX = fabsf(x);
+    dji_f32_t absY = fabsf(y);
+    dji_f32_t maxXY = absX > absY ? absX : absY;
+    dji_f32_t minXY = absX > absY ? absY : absX;
+    dji_f32_t z = minXY / (maxXY + FLT_MIN);
+    dji_f32_t z2 = z * z;
+    dji_f32_t result;
+
+    // odd minimax polynomial of atan(z) on [0, 1]
+    result = (((((-0.01172120f * z2 + 0.05265332f) * z2 - 0.11643287f) * z2 + 0.19354346f) * z2 - 0.33262347f) * z2
+              + 0.99997726f) * z;
+    // quadrant fix up selects constants only, a select of computed values would be a branch for the vectorizer
+    result = (absY > absX ? UTIL_ATTITUDE_HALF_PI : 0.0f) + (absY > absX ? -1.0f : 1.0f) * result;
+    result = (x < 0.0f ? UTIL_ATTITUDE_PI : 0.0f) + (x < 0.0f ? -1.0f : 1.0f) * result;
+
+    return copysignf(result, y);
+}
+
+/**
+ * @brief Square root of a non-negative value from the inverse square root estimate refined by three Newton steps.
+ * @note Unlike sqrtf() it never sets errno, which otherwise keeps the compiler from vectorizing the batch loops
+ * unless -fno-math-errno is given. Relative error is within a few float ulps.
+ */
+UTIL_ATTITUDE_INLINE dji_f32_t UtilAttitude_FastSqrtf(dji_f32_t x)
+{
+    uint32_t bits;
+    dji_f32_t y;
+
+    memcpy(&bits, &x, sizeof(bits));
+    bits = 0x5F3759DFu - (bits >> 1);
+    memcpy(&y, &bits, sizeof(y));
+
+    y = y * (1.5f - 0.5f * x * y * y);
+    y = y * (1.5f - 0.5f * x * y * y);
+    y = y * (1.5f - 0.5f * x * y * y);
+
+    return x * y;
+}
+
+/**
+ * @brief asin evaluated as atan2(x, sqrt(1 - x * x)), input out of [-1, 1] is clamped.
+ */
+UTIL_ATTITUDE_INLINE dji_f32_t UtilAttitude_FastAsinf(dji_f32_t x)
+{
+    dji_f32_t cosSquare = (1.0f - x) * (1.0f + x);
+
+    // max(cosSquare, 0) without a compare, which the compiler would turn into a branch around the square root
+    cosSquare = 0.5f * (cosSquare + fabsf(cosSquare));
+
+    return UtilAttitude_FastAtan2f(x, UtilAttitude_FastSqrtf(cosSquare));
+}
+
+UTIL_ATTITUDE_INLINE T_UtilAttitudeQuaternion UtilAttitude_QuaternionNormalize(T_UtilAttitudeQuaternion q)
+{
+    dji_f32_t norm = sqrtf(q.q0 * q.q0 + q.q1 * q.q1 + q.q2 * q.q2 + q.q3 * q.q3);
+    dji_f32_t scale = norm > 0.0f ? 1.0f / norm : 0.0f;
+    T_UtilAttitudeQuaternion result;
+
+    result.q0 = norm > 0.0f ? q.q0 * scale : 1.0f;
+    result.q1 = q.q1 * scale;
+    result.q2 = q.q2 * scale;
+    result.q3 = q.q3 * scale;
+
+    return result;
+}
+
+/**
+ * @brief Hamilton product, the result rotates by b first and then by a.
+ */
+UTIL_ATTITUDE_INLINE T_UtilAttitudeQuaternion UtilAttitude_QuaternionMultiply(T_UtilAttitudeQuaternion a,
+                                                                              T_UtilAttitudeQuaternion b)
+{
+    T_UtilAttitudeQuaternion result;
+
+    result.q0 = a.q0 * b.q0 - a.q1 * b.q1 - a.q2 * b.q2 - a.q3 * b.q3;
+    result.q1 = a.q0 * b.q1 + a.q1 * b.q0 + a.q2 * b.q3 - a.q3 * b.q2;
+    result.q2 = a.q0 * b.q2 - a.q1 * b.q3 + a.q2 * b.q0 + a.q3 * b.q1;
+    result.q3 = a.q0 * b.q3 + a.q1 * b.q2 - a.q2 * b.q1 + a.q3 * b.q0;
+
+    return result;
+}
+
+UTIL_ATTITUDE_INLINE T_UtilAttitudeEuler UtilAttitude_QuaternionToEuler(T_UtilAttitudeQuaternion q)
+{
+    T_UtilAttitudeEuler euler;
+
+    euler.roll = UtilAttitude_FastAtan2f(2.0f * (q.q0 * q.q1 + q.q2 * q.q3),
+                                         1.0f - 2.0f * (q.q1 * q.q1 + q.q2 * q.q2));
+    euler.pitch = UtilAttitude_FastAsinf(2.0f * (q.q0 * q.q2 - q.q1 * q.q3));
+    euler.yaw = UtilAttitude_FastAtan2f(2.0f * (q.q0 * q.q3 + q.q1 * q.q2),
+                                        1.0f - 2.0f * (q.q2 * q.q2 + q.q3 * q.q3));
+
+    return euler;
+}
+
+UTIL_ATTITUDE_INLINE T_UtilAttitudeQuaternion UtilAttitude_EulerToQuaternion(T_UtilAttitudeEuler euler)
+{
+    dji_f32_t cosRoll = cosf(euler.roll * 0.5f);
+    dji_f32_t sinRoll = sinf(euler.roll * 0.5f);
+    dji_f32_t cosPitch = cosf(euler.pitch * 0.5f);
+    dji_f32_t sinPitch = sinf(euler.pitch * 0.5f);
+    dji_f32_t cosYaw = cosf(euler.yaw * 0.5f);
+    dji_f32_t sinYaw = sinf(euler.yaw * 0.5f);
+    T_UtilAttitudeQuaternion q;
+
+    q.q0 = cosRoll * cosPitch * cosYaw + sinRoll * sinPitch * sinYaw;
+    q.q1 = sinRoll * cosPitch * cosYaw - cosRoll * sinPitch * sinYaw;
+    q.q2 = cosRoll * sinPitch * cosYaw + sinRoll * cosPitch * sinYaw;
+    q.q3 = cosRoll * cosPitch * sinYaw - sinRoll * sinPitch * cosYaw;
+
+    return q;
+}
+
+UTIL_ATTITUDE_INLINE T_UtilAttitudeMatrix UtilAttitude_QuaternionToMatrix(T_UtilAttitudeQuaternion q)
+{
+    T_UtilAttitudeMatrix matrix;
+
+    matrix.m[0] = 1.0f - 2.0f * (q.q2 * q.q2 + q.q3 * q.q3);
+    matrix.m[1] = 2.0f * (q.q1 * q.q2 - q.q0 * q.q3);
+    matrix.m[2] = 2.0f * (q.q1 * q.q3 + q.q0 * q.q2);
+    matrix.m[3] = 2.0f * (q.q1 * q.q2 + q.q0 * q.q3);
+    matrix.m[4] = 1.0f - 2.0f * (q.q1 * q.q1 + q.q3 * q.q3);
+    matrix.m[5] = 2.0f * (q.q2 * q.q3 - q.q0 * q.q1);
+    matrix.m[6] = 2.0f * (q.q1 * q.q3 - q.q0 * q.q2);
+    matrix.m[7] = 2.0f * (q.q2 * q.q3 + q.q0 * q.q1);
+    matrix.m[8] = 1.0f - 2.0f * (q.q1 * q.q1 + q.q2 * q.q2);
+
+    return matrix;
+}
+
+/**
+ * @brief Shepperd's method, picks the largest of w, x, y, z to divide by. The result has q0 >= 0.
+ */
+UTIL_ATTITUDE_INLINE T_UtilAttitudeQuaternion UtilAttitude_MatrixToQuaternion(const T_UtilAttitudeMatrix *matrix)
+{
+    const dji_f32_t *m = matrix->m;
+    dji_f32_t trace = m[0] + m[4] + m[8];
+    dji_f32_t s;
+    T_UtilAttitudeQuaternion q;
+
+    if (trace > 0.0f) {
+        s = 2.0f * sqrtf(1.0f + trace);
+        q.q0 = 0.25f * s;
+        q.q1 = (m[7] - m[5]) / s;
+        q.q2 = (m[2] - m[6]) / s;
+        q.q3 = (m[3] - m[1]) / s;
+    } else if (m[0] > m[4] && m[0] > m[8]) {
+        s = 2.0f * sqrtf(1.0f + m[0] - m[4] - m[8]);
+        q.q0 = (m[7] - m[5]) / s;
+        q.q1 = 0.25f * s;
+        q.q2 = (m[1] + m[3]) / s;
+        q.q3 = (m[2] + m[6]) / s;
+    } else if (m[4] > m[8]) {
+        s = 2.0f * sqrtf(1.0f + m[4] - m[0] - m[8]);
+        q.q0 = (m[2] - m[6]) / s;
+        q.q1 = (m[1] + m[3]) / s;
+        q.q2 = 0.25f * s;
+        q.q3 = (m[5] + m[7]) / s;
+    } else {
+        s = 2.0f * sqrtf(1.0f + m[8] - m[0] - m[4]);
+        q.q0 = (m[3] - m[1]) / s;
+        q.q1 = (m[2] + m[6]) / s;
+        q.q2 = (m[5] + m[7]) / s;
+        q.q3 = 0.25f * s;
+    }
+
+    if (q.q0 < 0.0f) {
+        q.q0 = -q.q0;
+        q.q1 = -q.q1;
+        q.q2 = -q.q2;
+        q.q3 = -q.q3;
+    }
+
+    return UtilAttitude_QuaternionNormalize(q);
+}
+
+UTIL_ATTITUDE_INLINE T_UtilAttitudeEuler UtilAttitude_MatrixToEuler(const T_UtilAttitudeMatrix *matrix)
+{
+    T_UtilAttitudeEuler euler;
+
+    euler.roll = UtilAttitude_FastAtan2f(matrix->m[7], matrix->m[8]);
+    euler.pitch = UtilAttitude_FastAsinf(-matrix->m[6]);
+    euler.yaw = UtilAttitude_FastAtan2f(matrix->m[3], matrix->m[0]);
+
+    return euler;
+}
+
+UTIL_ATTITUDE_INLINE T_UtilAttitudeMatrix UtilAttitude_EulerToMatrix(T_UtilAttitudeEuler euler)
+{
+    dji_f32_t cosRoll = cosf(euler.roll);
+    dji_f32_t sinRoll = sinf(euler.roll);
+    dji_f32_t cosPitch = cosf(euler.pitch);
+    dji_f32_t sinPitch = sinf(euler.pitch);
+    dji_f32_t cosYaw = cosf(euler.yaw);
+    dji_f32_t sinYaw = sinf(euler.yaw);
+    T_UtilAttitudeMatrix matrix;
+
+    matrix.m[0] = cosYaw * cosPitch;
+    matrix.m[1] = cosYaw * sinPitch * sinRoll - sinYaw * cosRoll;
+    matrix.m[2] = cosYaw * sinPitch * cosRoll + sinYaw * sinRoll;
+    matrix.m[3] = sinYaw * cosPitch;
+    matrix.m[4] = sinYaw * sinPitch * sinRoll + cosYaw * cosRoll;
+    matrix.m[5] = sinYaw * sinPitch * cosRoll - cosYaw * sinRoll;
+    matrix.m[6] = -sinPitch;
+    matrix.m[7] = cosPitch * sinRoll;
+    matrix.m[8] = cosPitch * cosRoll;
+
+    return matrix;
+}
+
+/**
+ * @brief Spherical linear interpolation along the shorter arc, t = 0 gives a and t = 1 gives b.
+ */
+UTIL_ATTITUDE_INLINE T_UtilAttitudeQuaternion UtilAttitude_QuaternionSlerp(T_UtilAttitudeQuaternion a,
+                                                                           T_UtilAttitudeQuaternion b, dji_f32_t t)
+{
+    dji_f32_t dot = a.q0 * b.q0 + a.q1 * b.q1 + a.q2 * b.q2 + a.q3 * b.q3;
+    dji_f32_t theta;
+    dji_f32_t sinTheta;
+    dji_f32_t scaleA;
+    dji_f32_t scaleB;
+    T_UtilAttitudeQuaternion result;
+
+    if (dot < 0.0f) {
+        dot = -dot;
+        b.q0 = -b.q0;
+        b.q1 = -b.q1;
+        b.q2 = -b.q2;
+        b.q3 = -b.q3;
+    }
+
+    if (dot > UTIL_ATTITUDE_SLERP_LINEAR_THRESHOLD) {
+        scaleA = 1.0f - t;
+        scaleB = t;
+    } else {
+        theta = acosf(dot);
+        sinTheta = sinf(theta);
+        scaleA = sinf((1.0f - t) * theta) / sinTheta;
+        scaleB = sinf(t * theta) / sinTheta;
+    }
+
+    result.q0 = scaleA * a.q0 + scaleB * b.q0;
+    result.q1 = scaleA * a.q1 + scaleB * b.q1;
+    result.q2 = scaleA * a.q2 + scaleB * b.q2;
+    result.q3 = scaleA * a.q3 + scaleB * b.q3;
+
+    return UtilAttitude_QuaternionNormalize(result);
+}
+
+/**
+ * @brief Same result as UtilAttitude_QuaternionToEuler() for each element.
+ * @note Done in two passes, gcc does not vectorize the loop storing all three angles of the interleaved output but
+ * does vectorize each pass with SSE/NEON at -O3.
+ */
+UTIL_ATTITUDE_INLINE void UtilAttitude_QuaternionToEulerBatch(const T_UtilAttitudeQuaternion *UTIL_ATTITUDE_RESTRICT q,
+                                                              T_UtilAttitudeEuler *UTIL_ATTITUDE_RESTRICT euler,
+                                                              uint32_t count)
+{
+    uint32_t i;
+
+    for (i = 0; i < count; i++) {
+        euler[i].roll = UtilAttitude_FastAtan2f(2.0f * (q[i].q0 * q[i].q1 + q[i].q2 * q[i].q3),
+                                                1.0f - 2.0f * (q[i].q1 * q[i].q1 + q[i].q2 * q[i].q2));
+        euler[i].yaw = UtilAttitude_FastAtan2f(2.0f * (q[i].q0 * q[i].q3 + q[i].q1 * q[i].q2),
+                                               1.0f - 2.0f * (q[i].q2 * q[i].q2 + q[i].q3 * q[i].q3));
+    }
+
+    for (i = 0; i < count; i++) {
+        euler[i].pitch = UtilAttitude_FastAsinf(2.0f * (q[i].q0 * q[i].q2 - q[i].q1 * q[i].q3));
+    }
+}
+
+UTIL_ATTITUDE_INLINE void UtilAttitude_EulerToQuaternionBatch(const T_UtilAttitudeEuler *UTIL_ATTITUDE_RESTRICT euler,
+                                                              T_UtilAttitudeQuaternion *UTIL_ATTITUDE_RESTRICT q,
+                                                              uint32_t count)
+{
+    uint32_t i;
+
+    for (i = 0; i < count; i++) {
+        q[i] = UtilAttitude_EulerToQuaternion(euler[i]);
+    }
+}
+
+UTIL_ATTITUDE_INLINE void UtilAttitude_QuaternionToMatrixBatch(const T_UtilAttitudeQuaternion *UTIL_ATTITUDE_RESTRICT q,
+                                                               T_UtilAttitudeMatrix *UTIL_ATTITUDE_RESTRICT matrix,
+                                                               uint32_t count)
+{
+    uint32_t i;
+
+    for (i = 0; i < count; i++) {
+        matrix[i] = UtilAttitude_QuaternionToMatrix(q[i]);
+    }
+}
+
+UTIL_ATTITUDE_INLINE void UtilAttitude_MatrixToEulerBatch(const T_UtilAttitudeMatrix *UTIL_ATTITUDE_RESTRICT matrix,
+                                                          T_UtilAttitudeEuler *UTIL_ATTITUDE_RESTRICT euler,
+                                                          uint32_t count)
+{
+    uint32_t i;
+
+    for (i = 0; i < count; i++) {
+        euler[i] = UtilAttitude_MatrixToEuler(&matrix[i]);
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UTIL_ATTITUDE_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
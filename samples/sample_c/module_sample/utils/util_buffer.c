@@ -28,6 +28,10 @@
 #include <string.h>
 #include "util_misc.h"
 
+#if !defined(__CC_ARM) && defined(SYSTEM_ARCH_LINUX)
+#include <sched.h>
+#endif
+
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
 /* Private macro -------------------------------------------------------------*/
@@ -49,6 +53,97 @@ static uint16_t UtilBuffer_CutBufSizeToPowOfTwo(uint16_t bufSize)
     return (uint16_t) (1 << (--i));
 }
 
+#ifndef __CC_ARM
+
+/**
+ * @brief Cut 32-bit buffer size to power of 2, the result is at most 2^31 so free running indexes never overflow
+ * the used size.
+ * @param bufSize Original buffer size.
+ * @return Buffer size after handling.
+ */
+static uint32_t UtilBuffer_CutBufSizeToPowOfTwo32(uint32_t bufSize)
+{
+    uint32_t size = 1;
+
+    if (bufSize == 0) {
+        return 0;
+    }
+
+    while (size <= bufSize / 2) {
+        size <<= 1;
+    }
+
+    return size;
+}
+
+/**
+ * @brief Copy data into the ring at a free running index, wrapping at the end of the buffer.
+ */
+static void UtilBuffer_CopyIn(uint8_t *bufferPtr, uint32_t bufferSize, uint32_t index, const uint8_t *pData,
+                              uint32_t dataLen)
+{
+    uint32_t offset = index & (bufferSize - 1);
+    uint32_t writeUpLen = USER_UTIL_MIN(dataLen, bufferSize - offset);
+
+    memcpy(bufferPtr + offset, pData, writeUpLen);
+    memcpy(bufferPtr, pData + writeUpLen, dataLen - writeUpLen);
+}
+
+/**
+ * @brief Copy data out of the ring at a free running index, wrapping at the end of the buffer.
+ */
+static void UtilBuffer_CopyOut(const uint8_t *bufferPtr, uint32_t bufferSize, uint32_t index, uint8_t *pData,
+                               uint32_t dataLen)
+{
+    uint32_t offset = index & (bufferSize - 1);
+    uint32_t readUpLen = USER_UTIL_MIN(dataLen, bufferSize - offset);
+
+    memcpy(pData, bufferPtr + offset, readUpLen);
+    memcpy(pData + readUpLen, bufferPtr, dataLen - readUpLen);
+}
+
+/**
+ * @brief Unused size seen by the producer, the consumer index is only loaded again when the cached one shows less
+ * than the wanted size.
+ */
+static uint32_t UtilBuffer_SpscGetProducerUnusedSize(T_UtilSpscBuffer *pthis, uint32_t writeIndex, uint32_t wantLen)
+{
+    if (pthis->bufferSize - (writeIndex - pthis->readIndexCache) < wantLen) {
+        pthis->readIndexCache = __atomic_load_n(&pthis->readIndex, __ATOMIC_ACQUIRE);
+    }
+
+    return pthis->bufferSize - (writeIndex - pthis->readIndexCache);
+}
+
+/**
+ * @brief Used size seen by the consumer, the producer index is only loaded again when the cached one shows less
+ * than the wanted size.
+ */
+static uint32_t UtilBuffer_SpscGetConsumerUsedSize(T_UtilSpscBuffer *pthis, uint32_t readIndex, uint32_t wantLen)
+{
+    if (pthis->writeIndexCache - readIndex < wantLen) {
+        pthis->writeIndexCache = __atomic_load_n(&pthis->writeIndex, __ATOMIC_ACQUIRE);
+    }
+
+    return pthis->writeIndexCache - readIndex;
+}
+
+/**
+ * @brief Back off while an earlier producer has not committed yet.
+ * @note On Linux the waiting thread yields, so a preempted producer gets the cpu back even on a single core.
+ * On RTOS the producers of one buffer should run at the same priority.
+ */
+static void UtilBuffer_WaitForEarlierProducer(void)
+{
+#ifdef SYSTEM_ARCH_LINUX
+    sched_yield();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+#endif
+
 /* Exported functions --------------------------------------------------------*/
 
 /**
@@ -125,3 +220,231 @@ uint16_t UtilBuffer_GetUnusedSize(T_UtilBuffer *pthis)
 {
     return (uint16_t) (pthis->bufferSize - pthis->writeIndex + pthis->readIndex);
 }
+
+#ifndef __CC_ARM
+
+/**
+ * @brief Single producer / single consumer buffer initialization.
+ * @param pthis Pointer to buffer structure.
+ * @param pBuf Pointer to data buffer.
+ * @param bufSize Size of data buffer, cut to power of 2.
+ * @return None.
+ */
+void UtilBuffer_SpscInit(T_UtilSpscBuffer *pthis, uint8_t *pBuf, uint32_t bufSize)
+{
+    pthis->bufferPtr = pBuf;
+    pthis->bufferSize = UtilBuffer_CutBufSizeToPowOfTwo32(bufSize);
+    pthis->writeIndex = 0;
+    pthis->readIndexCache = 0;
+    pthis->readIndex = 0;
+    pthis->writeIndexCache = 0;
+}
+
+/**
+ * @brief Put a block of data into buffer, only called by the producer.
+ * @param pthis Pointer to buffer structure.
+ * @param pData Pointer to data to be stored.
+ * @param dataLen Length of data to be stored.
+ * @return Length of data stored, less than dataLen when the buffer is full.
+ */
+uint32_t UtilBuffer_SpscPut(T_UtilSpscBuffer *pthis, const uint8_t *pData, uint32_t dataLen)
+{
+    uint32_t writeIndex = __atomic_load_n(&pthis->writeIndex, __ATOMIC_RELAXED);
+    uint32_t unusedSize = UtilBuffer_SpscGetProducerUnusedSize(pthis, writeIndex, dataLen);
+
+    // sizes are taken once, USER_UTIL_MIN() evaluates its arguments twice and the other side keeps moving
+    dataLen = USER_UTIL_MIN(dataLen, unusedSize);
+    UtilBuffer_CopyIn(pthis->bufferPtr, pthis->bufferSize, writeIndex, pData, dataLen);
+    __atomic_store_n(&pthis->writeIndex, writeIndex + dataLen, __ATOMIC_RELEASE);
+
+    return dataLen;
+}
+
+/**
+ * @brief Get a block of data from buffer, only called by the consumer.
+ * @param pthis Pointer to buffer structure.
+ * @param pData Pointer to data to be read.
+ * @param dataLen Length of data to be read.
+ * @return Length of data read.
+ */
+uint32_t UtilBuffer_SpscGet(T_UtilSpscBuffer *pthis, uint8_t *pData, uint32_t dataLen)
+{
+    uint32_t readIndex = __atomic_load_n(&pthis->readIndex, __ATOMIC_RELAXED);
+    uint32_t usedSize = UtilBuffer_SpscGetConsumerUsedSize(pthis, readIndex, dataLen);
+
+    dataLen = USER_UTIL_MIN(dataLen, usedSize);
+    UtilBuffer_CopyOut(pthis->bufferPtr, pthis->bufferSize, readIndex, pData, dataLen);
+    __atomic_store_n(&pthis->readIndex, readIndex + dataLen, __ATOMIC_RELEASE);
+
+    return dataLen;
+}
+
+/**
+ * @brief Get the contiguous free space at the write position, so the producer can fill it in place.
+ * @param pthis Pointer to buffer structure.
+ * @param span Returns the start of the free space.
+ * @return Length of the contiguous free space, the rest of the free space follows from the buffer start.
+ */
+uint32_t UtilBuffer_SpscGetWriteSpan(T_UtilSpscBuffer *pthis, uint8_t **span)
+{
+    uint32_t writeIndex = __atomic_load_n(&pthis->writeIndex, __ATOMIC_RELAXED);
+    uint32_t offset = writeIndex & (pthis->bufferSize - 1);
+    uint32_t unusedSize = UtilBuffer_SpscGetProducerUnusedSize(pthis, writeIndex, pthis->bufferSize - offset);
+
+    *span = pthis->bufferPtr + offset;
+
+    return USER_UTIL_MIN(unusedSize, pthis->bufferSize - offset);
+}
+
+/**
+ * @brief Publish data written in place to the consumer.
+ * @param pthis Pointer to buffer structure.
+ * @param dataLen Length of data written, at most the length returned by UtilBuffer_SpscGetWriteSpan().
+ * @return None.
+ */
+void UtilBuffer_SpscCommitWrite(T_UtilSpscBuffer *pthis, uint32_t dataLen)
+{
+    __atomic_store_n(&pthis->writeIndex, __atomic_load_n(&pthis->writeIndex, __ATOMIC_RELAXED) + dataLen,
+                     __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Get the contiguous data at the read position, so the consumer can use it without a copy.
+ * @param pthis Pointer to buffer structure.
+ * @param span Returns the start of the data.
+ * @return Length of the contiguous data, the rest of the data follows from the buffer start.
+ */
+uint32_t UtilBuffer_SpscGetReadSpan(T_UtilSpscBuffer *pthis, const uint8_t **span)
+{
+    uint32_t readIndex = __atomic_load_n(&pthis->readIndex, __ATOMIC_RELAXED);
+    uint32_t offset = readIndex & (pthis->bufferSize - 1);
+    uint32_t usedSize = UtilBuffer_SpscGetConsumerUsedSize(pthis, readIndex, pthis->bufferSize - offset);
+
+    *span = pthis->bufferPtr + offset;
+
+    return USER_UTIL_MIN(usedSize, pthis->bufferSize - offset);
+}
+
+/**
+ * @brief Release data used in place back to the producer.
+ * @param pthis Pointer to buffer structure.
+ * @param dataLen Length of data used, at most the length returned by UtilBuffer_SpscGetReadSpan().
+ * @return None.
+ */
+void UtilBuffer_SpscCommitRead(T_UtilSpscBuffer *pthis, uint32_t dataLen)
+{
+    __atomic_store_n(&pthis->readIndex, __atomic_load_n(&pthis->readIndex, __ATOMIC_RELAXED) + dataLen,
+                     __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Get used size of buffer, only called by the consumer.
+ * @param pthis Pointer to buffer structure.
+ * @return Used size of buffer.
+ */
+uint32_t UtilBuffer_SpscGetUsedSize(T_UtilSpscBuffer *pthis)
+{
+    return UtilBuffer_SpscGetConsumerUsedSize(pthis, __atomic_load_n(&pthis->readIndex, __ATOMIC_RELAXED),
+                                              pthis->bufferSize);
+}
+
+/**
+ * @brief Get unused size of buffer, only called by the producer.
+ * @param pthis Pointer to buffer structure.
+ * @return Unused size of buffer.
+ */
+uint32_t UtilBuffer_SpscGetUnusedSize(T_UtilSpscBuffer *pthis)
+{
+    return UtilBuffer_SpscGetProducerUnusedSize(pthis, __atomic_load_n(&pthis->writeIndex, __ATOMIC_RELAXED),
+                                                pthis->bufferSize);
+}
+
+/**
+ * @brief Multi-producer / single consumer buffer initialization.
+ * @param pthis Pointer to buffer structure.
+ * @param pBuf Pointer to data buffer.
+ * @param bufSize Size of data buffer, cut to power of 2.
+ * @return None.
+ */
+void UtilBuffer_MpscInit(T_UtilMpscBuffer *pthis, uint8_t *pBuf, uint32_t bufSize)
+{
+    UtilBuffer_SpscInit(&pthis->ring, pBuf, bufSize);
+    pthis->reserveIndex = 0;
+}
+
+/**
+ * @brief Put a block of data into buffer, may be called by any number of producers at the same time.
+ * @note The block is stored as a whole or not at all, so blocks of different producers never interleave.
+ * @param pthis Pointer to buffer structure.
+ * @param pData Pointer to data to be stored.
+ * @param dataLen Length of data to be stored.
+ * @return dataLen when stored, 0 when the buffer has not enough unused space.
+ */
+uint32_t UtilBuffer_MpscPut(T_UtilMpscBuffer *pthis, const uint8_t *pData, uint32_t dataLen)
+{
+    uint32_t reserveIndex = __atomic_load_n(&pthis->reserveIndex, __ATOMIC_RELAXED);
+    uint32_t readIndex;
+
+    if (dataLen == 0) {
+        return 0;
+    }
+
+    do {
+        readIndex = __atomic_load_n(&pthis->ring.readIndex, __ATOMIC_ACQUIRE);
+        if (pthis->ring.bufferSize - (reserveIndex - readIndex) < dataLen) {
+            return 0;
+        }
+    } while (!__atomic_compare_exchange_n(&pthis->reserveIndex, &reserveIndex, reserveIndex + dataLen, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    UtilBuffer_CopyIn(pthis->ring.bufferPtr, pthis->ring.bufferSize, reserveIndex, pData, dataLen);
+
+    // the consumer reads up to the commit index, so earlier reservations have to be committed first
+    while (__atomic_load_n(&pthis->ring.writeIndex, __ATOMIC_ACQUIRE) != reserveIndex) {
+        UtilBuffer_WaitForEarlierProducer();
+    }
+    __atomic_store_n(&pthis->ring.writeIndex, reserveIndex + dataLen, __ATOMIC_RELEASE);
+
+    return dataLen;
+}
+
+/**
+ * @brief Get a block of data from buffer, only called by the consumer.
+ * @param pthis Pointer to buffer structure.
+ * @param pData Pointer to data to be read.
+ * @param dataLen Length of data to be read.
+ * @return Length of data read.
+ */
+uint32_t UtilBuffer_MpscGet(T_UtilMpscBuffer *pthis, uint8_t *pData, uint32_t dataLen)
+{
+    return UtilBuffer_SpscGet(&pthis->ring, pData, dataLen);
+}
+
+/**
+ * @brief Get the contiguous committed data at the read position, see UtilBuffer_SpscGetReadSpan().
+ */
+uint32_t UtilBuffer_MpscGetReadSpan(T_UtilMpscBuffer *pthis, const uint8_t **span)
+{
+    return UtilBuffer_SpscGetReadSpan(&pthis->ring, span);
+}
+
+/**
+ * @brief Release data used in place back to the producers, see UtilBuffer_SpscCommitRead().
+ */
+void UtilBuffer_MpscCommitRead(T_UtilMpscBuffer *pthis, uint32_t dataLen)
+{
+    UtilBuffer_SpscCommitRead(&pthis->ring, dataLen);
+}
+
+/**
+ * @brief Get unused size of buffer, only a hint while other producers are putting.
+ * @param pthis Pointer to buffer structure.
+ * @return Unused size of buffer.
+ */
+uint32_t UtilBuffer_MpscGetUnusedSize(T_UtilMpscBuffer *pthis)
+{
+    return pthis->ring.bufferSize - (__atomic_load_n(&pthis->reserveIndex, __ATOMIC_RELAXED) -
+                                     __atomic_load_n(&pthis->ring.readIndex, __ATOMIC_ACQUIRE));
+}
+
+#endif
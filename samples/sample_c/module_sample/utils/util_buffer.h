@@ -30,6 +30,8 @@
 #include <stdint.h>
 
 /* Exported constants --------------------------------------------------------*/
+#define UTIL_BUFFER_CACHE_LINE_SIZE     64
+
 /* Exported macros -----------------------------------------------------------*/
 /* Exported types ------------------------------------------------------------*/
 
@@ -42,6 +44,31 @@ typedef struct {
     uint16_t writeIndex;
 } T_UtilBuffer;
 
+#ifndef __CC_ARM
+
+//Note: lock free for one producer / one consumer, indexes are published with acquire / release atomics
+//the producer and consumer fields live on separate cache lines, keep the structure statically allocated
+typedef struct {
+    uint8_t *bufferPtr;
+    uint32_t bufferSize;
+    //written by the producer only, readIndexCache avoids loading the consumer cache line on every put
+    uint32_t writeIndex __attribute__((aligned(UTIL_BUFFER_CACHE_LINE_SIZE)));
+    uint32_t readIndexCache;
+    //written by the consumer only
+    uint32_t readIndex __attribute__((aligned(UTIL_BUFFER_CACHE_LINE_SIZE)));
+    uint32_t writeIndexCache;
+} T_UtilSpscBuffer;
+
+//Note: lock free for multi-producer / one consumer, a producer reserves its space with a compare and swap,
+//copies without any lock and then commits in reservation order, the consumer sees whole puts only
+typedef struct {
+    //ring.writeIndex is the commit index read by the consumer
+    T_UtilSpscBuffer ring;
+    uint32_t reserveIndex __attribute__((aligned(UTIL_BUFFER_CACHE_LINE_SIZE)));
+} T_UtilMpscBuffer;
+
+#endif
+
 /* Exported variables --------------------------------------------------------*/
 /* Exported functions --------------------------------------------------------*/
 
@@ -50,6 +77,27 @@ uint16_t UtilBuffer_Put(T_UtilBuffer *pthis, const uint8_t *pData, uint16_t data
 uint16_t UtilBuffer_Get(T_UtilBuffer *pthis, uint8_t *pData, uint16_t dataLen);
 uint16_t UtilBuffer_GetUnusedSize(T_UtilBuffer *pthis);
 
+#ifndef __CC_ARM
+
+void UtilBuffer_SpscInit(T_UtilSpscBuffer *pthis, uint8_t *pBuf, uint32_t bufSize);
+uint32_t UtilBuffer_SpscPut(T_UtilSpscBuffer *pthis, const uint8_t *pData, uint32_t dataLen);
+uint32_t UtilBuffer_SpscGet(T_UtilSpscBuffer *pthis, uint8_t *pData, uint32_t dataLen);
+uint32_t UtilBuffer_SpscGetWriteSpan(T_UtilSpscBuffer *pthis, uint8_t **span);
+void UtilBuffer_SpscCommitWrite(T_UtilSpscBuffer *pthis, uint32_t dataLen);
+uint32_t UtilBuffer_SpscGetReadSpan(T_UtilSpscBuffer *pthis, const uint8_t **span);
+void UtilBuffer_SpscCommitRead(T_UtilSpscBuffer *pthis, uint32_t dataLen);
+uint32_t UtilBuffer_SpscGetUsedSize(T_UtilSpscBuffer *pthis);
+uint32_t UtilBuffer_SpscGetUnusedSize(T_UtilSpscBuffer *pthis);
+
+void UtilBuffer_MpscInit(T_UtilMpscBuffer *pthis, uint8_t *pBuf, uint32_t bufSize);
+uint32_t UtilBuffer_MpscPut(T_UtilMpscBuffer *pthis, const uint8_t *pData, uint32_t dataLen);
+uint32_t UtilBuffer_MpscGet(T_UtilMpscBuffer *pthis, uint8_t *pData, uint32_t dataLen);
+uint32_t UtilBuffer_MpscGetReadSpan(T_UtilMpscBuffer *pthis, const uint8_t **span);
+void UtilBuffer_MpscCommitRead(T_UtilMpscBuffer *pthis, uint32_t dataLen);
+uint32_t UtilBuffer_MpscGetUnusedSize(T_UtilMpscBuffer *pthis);
+
+#endif
+
 /* Private constants ---------------------------------------------------------*/
 /* Private macros ------------------------------------------------------------*/
 /* Private types -------------------------------------------------------------*/
@@ -30,9 +30,11 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <errno.h>
 
 /* Private constants ---------------------------------------------------------*/
-
+/* Number of buffers passed to one preadv call. */
+#define UTIL_FILE_READ_VEC_BATCH        16
 
 /* Private types -------------------------------------------------------------*/
 
@@ -200,6 +202,57 @@ out:
     return psdkStat;
 }
 
+/**
+ * @brief Read data at offset of an open file into a list of buffers with preadv, short reads are continued until
+ * the buffers are full or the end of file is reached.
+ */
+T_DjiReturnCode UtilFile_GetFileDataVec(int fd, uint32_t offset, const struct iovec *iov, uint32_t iovCount,
+                                        uint32_t *realLen)
+{
+    struct iovec batch[UTIL_FILE_READ_VEC_BATCH];
+    uint32_t readLen = 0;
+    uint32_t index = 0;
+    size_t headOffset = 0;
+    uint32_t batchCount;
+    ssize_t ret;
+
+    if (fd < 0 || (iov == NULL && iovCount > 0) || realLen == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    while (index < iovCount) {
+        for (batchCount = 0; batchCount < UTIL_FILE_READ_VEC_BATCH && index + batchCount < iovCount; batchCount++) {
+            batch[batchCount] = iov[index + batchCount];
+        }
+        batch[0].iov_base = (uint8_t *) batch[0].iov_base + headOffset;
+        batch[0].iov_len -= headOffset;
+
+        ret = preadv(fd, batch, (int) batchCount, (off_t) offset + readLen);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            break;
+        }
+        readLen += (uint32_t) ret;
+
+        //skip the buffers filled by this call, a partly filled one is continued by the next call
+        ret += (ssize_t) headOffset;
+        while (index < iovCount && (size_t) ret >= iov[index].iov_len) {
+            ret -= (ssize_t) iov[index].iov_len;
+            index++;
+        }
+        headOffset = (size_t) ret;
+    }
+
+    if (readLen == 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+    *realLen = readLen;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
 /* Private functions definition-----------------------------------------------*/
 
 #endif
@@ -36,6 +36,7 @@ extern "C" {
 /* Includes ------------------------------------------------------------------*/
 #include <dji_typedef.h>
 #include <stdio.h>
+#include <sys/uio.h>
 
 /* Exported constants --------------------------------------------------------*/
 
@@ -58,6 +59,8 @@ T_DjiReturnCode DjiFile_Delete(const char *filePath);
 
 T_DjiReturnCode UtilFile_GetFileSize(FILE *file, uint32_t *fileSize);
 T_DjiReturnCode UtilFile_GetFileData(FILE *file, uint32_t offset, uint16_t len, uint8_t *data, uint16_t *realLen);
+T_DjiReturnCode UtilFile_GetFileDataVec(int fd, uint32_t offset, const struct iovec *iov, uint32_t iovCount,
+                                        uint32_t *realLen);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,294 @@
+/**
+ ******************************************************************************
+ * @file    util_nal_splitter.c
+ * @brief   The file defines an Annex-B H.264/H.265 NAL unit splitter, including initialize, fill data,
+ *          accelerated start code scanning and NAL unit dispatching.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "util_nal_splitter.h"
+#include <string.h>
+#include "util_misc.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+#define UTIL_NAL_SPLITTER_START_CODE_LEN        3
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Exported variables --------------------------------------------------------*/
+/* Private function prototypes -----------------------------------------------*/
+static void UtilNalSplitter_Process(T_UtilNalSplitter *pthis);
+static void UtilNalSplitter_SwapBuffer(T_UtilNalSplitter *pthis);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+ * @brief NAL splitter initialization.
+ * @param pthis Pointer to splitter structure.
+ * @param pBuf Pointer to data buffer, split into two halves used alternately.
+ * @param bufSize Size of data buffer, each half must be able to hold the largest NAL unit.
+ * @param callback Function called for every complete NAL unit.
+ * @param userData User data passed to the callback.
+ * @return None.
+ */
+void UtilNalSplitter_Init(T_UtilNalSplitter *pthis, uint8_t *pBuf, uint32_t bufSize,
+                          UtilNalSplitterCallback callback, void *userData)
+{
+    pthis->bufferSize = bufSize / 2;
+    pthis->bufferPtr[0] = pBuf;
+    pthis->bufferPtr[1] = pBuf + pthis->bufferSize;
+    pthis->callback = callback;
+    pthis->userData = userData;
+    pthis->droppedBytes = 0;
+    UtilNalSplitter_Reset(pthis);
+}
+
+/**
+ * @brief Drop all pending data, used when the source stream is restarted.
+ * @param pthis Pointer to splitter structure.
+ * @return None.
+ */
+void UtilNalSplitter_Reset(T_UtilNalSplitter *pthis)
+{
+    pthis->activeIndex = 0;
+    pthis->dataLen = 0;
+    pthis->nalStart = UTIL_NAL_SPLITTER_NO_NAL;
+    pthis->scanOffset = 0;
+}
+
+/**
+ * @brief Get the free space at the end of the active buffer, so the data source can read into it directly.
+ * @note When the free space is too small, the pending part of the unfinished NAL unit is moved to the
+ * other half. If a single NAL unit fills the whole half it is dropped and counted in droppedBytes.
+ * @param pthis Pointer to splitter structure.
+ * @param pSpan Pointer to the start of the writable span.
+ * @return Length of the writable span.
+ */
+uint32_t UtilNalSplitter_GetWritableSpan(T_UtilNalSplitter *pthis, uint8_t **pSpan)
+{
+    if (pthis->bufferSize - pthis->dataLen < UTIL_NAL_SPLITTER_MIN_WRITE_SPAN) {
+        UtilNalSplitter_SwapBuffer(pthis);
+    }
+
+    *pSpan = pthis->bufferPtr[pthis->activeIndex] + pthis->dataLen;
+
+    return pthis->bufferSize - pthis->dataLen;
+}
+
+/**
+ * @brief Commit data written into the span returned by UtilNalSplitter_GetWritableSpan and dispatch
+ * all NAL units completed by it.
+ * @param pthis Pointer to splitter structure.
+ * @param dataLen Length of data written.
+ * @return None.
+ */
+void UtilNalSplitter_CommitWrite(T_UtilNalSplitter *pthis, uint32_t dataLen)
+{
+    if (dataLen == 0) {
+        return;
+    }
+
+    pthis->dataLen += USER_UTIL_MIN(dataLen, pthis->bufferSize - pthis->dataLen);
+    UtilNalSplitter_Process(pthis);
+}
+
+/**
+ * @brief Copy a block of data into the splitter and dispatch all completed NAL units.
+ * @param pthis Pointer to splitter structure.
+ * @param pData Pointer to data to be stored.
+ * @param dataLen Length of data to be stored.
+ * @return Length of data stored.
+ */
+uint32_t UtilNalSplitter_Put(T_UtilNalSplitter *pthis, const uint8_t *pData, uint32_t dataLen)
+{
+    uint32_t putLen = 0;
+    uint32_t spanLen;
+    uint8_t *span;
+
+    while (putLen < dataLen) {
+        spanLen = UtilNalSplitter_GetWritableSpan(pthis, &span);
+        spanLen = USER_UTIL_MIN(spanLen, dataLen - putLen);
+        memcpy(span, pData + putLen, spanLen);
+        UtilNalSplitter_CommitWrite(pthis, spanLen);
+        putLen += spanLen;
+    }
+
+    return putLen;
+}
+
+/**
+ * @brief Dispatch the last pending NAL unit, used at the end of a stream.
+ * @param pthis Pointer to splitter structure.
+ * @return None.
+ */
+void UtilNalSplitter_Flush(T_UtilNalSplitter *pthis)
+{
+    if (pthis->nalStart != UTIL_NAL_SPLITTER_NO_NAL && pthis->dataLen > pthis->nalStart) {
+        pthis->callback(pthis->bufferPtr[pthis->activeIndex] + pthis->nalStart,
+                        pthis->dataLen - pthis->nalStart, pthis->userData);
+    }
+
+    UtilNalSplitter_Reset(pthis);
+}
+
+/**
+ * @brief Find the first "00 00 01" sequence in a block of data.
+ * @param pData Pointer to the first byte to be checked.
+ * @param pEnd Pointer to the end of the data.
+ * @return Pointer to the first zero byte of the sequence, NULL if not found.
+ */
+const uint8_t *UtilNalSplitter_FindStartCode(const uint8_t *pData, const uint8_t *pEnd)
+{
+    const uint8_t *p = pData;
+
+    if (pEnd - pData < UTIL_NAL_SPLITTER_START_CODE_LEN) {
+        return NULL;
+    }
+
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+
+    while (pEnd - p >= 16 + UTIL_NAL_SPLITTER_START_CODE_LEN - 1) {
+        __m128i b0 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) p), zero);
+        __m128i b1 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (p + 1)), zero);
+        __m128i b2 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (p + 2)), one);
+        int mask = _mm_movemask_epi8(_mm_and_si128(_mm_and_si128(b0, b1), b2));
+
+        if (mask != 0) {
+            return p + __builtin_ctz((unsigned int) mask);
+        }
+        p += 16;
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const uint8x16_t one = vdupq_n_u8(1);
+
+    while (pEnd - p >= 16 + UTIL_NAL_SPLITTER_START_CODE_LEN - 1) {
+        uint8x16_t b0 = vceqq_u8(vld1q_u8(p), zero);
+        uint8x16_t b1 = vceqq_u8(vld1q_u8(p + 1), zero);
+        uint8x16_t b2 = vceqq_u8(vld1q_u8(p + 2), one);
+        uint8x16_t match = vandq_u8(vandq_u8(b0, b1), b2);
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(match), 4)), 0);
+
+        if (mask != 0) {
+            return p + (__builtin_ctzll(mask) >> 2);
+        }
+        p += 16;
+    }
+#endif
+
+    //scalar tail: look for the 0x01 byte and check the two bytes before it
+    p += UTIL_NAL_SPLITTER_START_CODE_LEN - 1;
+    while (p < pEnd) {
+        p = memchr(p, 0x01, pEnd - p);
+        if (p == NULL) {
+            return NULL;
+        }
+        if (p[-1] == 0x00 && p[-2] == 0x00) {
+            return p - 2;
+        }
+        p++;
+    }
+
+    return NULL;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief Scan the data appended since the last call and dispatch every NAL unit terminated by a new start code.
+ * @note Bytes before scanOffset have been searched already and are never scanned again.
+ * @param pthis Pointer to splitter structure.
+ * @return None.
+ */
+static void UtilNalSplitter_Process(T_UtilNalSplitter *pthis)
+{
+    const uint8_t *buf = pthis->bufferPtr[pthis->activeIndex];
+    const uint8_t *end = buf + pthis->dataLen;
+    const uint8_t *found;
+    uint32_t codePos;
+    uint32_t codeStart;
+
+    while ((found = UtilNalSplitter_FindStartCode(buf + pthis->scanOffset, end)) != NULL) {
+        codePos = (uint32_t) (found - buf);
+        //a zero byte in front of "00 00 01" makes it a 4-byte start code
+        codeStart = (codePos > 0 && buf[codePos - 1] == 0x00 &&
+                     (pthis->nalStart == UTIL_NAL_SPLITTER_NO_NAL || codePos - 1 > pthis->nalStart)) ?
+                    codePos - 1 : codePos;
+
+        if (pthis->nalStart != UTIL_NAL_SPLITTER_NO_NAL) {
+            pthis->callback(buf + pthis->nalStart, codeStart - pthis->nalStart, pthis->userData);
+        }
+
+        pthis->nalStart = codeStart;
+        pthis->scanOffset = codePos + UTIL_NAL_SPLITTER_START_CODE_LEN;
+    }
+
+    if (pthis->dataLen >= UTIL_NAL_SPLITTER_START_CODE_LEN - 1 &&
+        pthis->scanOffset < pthis->dataLen - (UTIL_NAL_SPLITTER_START_CODE_LEN - 1)) {
+        pthis->scanOffset = pthis->dataLen - (UTIL_NAL_SPLITTER_START_CODE_LEN - 1);
+    }
+}
+
+/**
+ * @brief Move the unfinished tail of the active buffer to the start of the other half and switch to it.
+ * @param pthis Pointer to splitter structure.
+ * @return None.
+ */
+static void UtilNalSplitter_SwapBuffer(T_UtilNalSplitter *pthis)
+{
+    uint32_t keepFrom;
+    uint32_t keepLen;
+    uint8_t nextIndex = (uint8_t) (pthis->activeIndex ^ 1);
+
+    if (pthis->nalStart != UTIL_NAL_SPLITTER_NO_NAL) {
+        keepFrom = pthis->nalStart;
+    } else {
+        //keep one byte in front of the scan offset to detect 4-byte start codes
+        keepFrom = pthis->scanOffset > 0 ? pthis->scanOffset - 1 : 0;
+    }
+    keepLen = pthis->dataLen - keepFrom;
+
+    if (keepLen + UTIL_NAL_SPLITTER_MIN_WRITE_SPAN > pthis->bufferSize) {
+        //the pending NAL unit does not fit into one half, drop it and resync at the next start code
+        pthis->droppedBytes += keepLen;
+        UtilNalSplitter_Reset(pthis);
+        return;
+    }
+
+    memcpy(pthis->bufferPtr[nextIndex], pthis->bufferPtr[pthis->activeIndex] + keepFrom, keepLen);
+    pthis->activeIndex = nextIndex;
+    pthis->dataLen = keepLen;
+    pthis->scanOffset -= USER_UTIL_MIN(pthis->scanOffset, keepFrom);
+    if (pthis->nalStart != UTIL_NAL_SPLITTER_NO_NAL) {
+        pthis->nalStart -= keepFrom;
+    }
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
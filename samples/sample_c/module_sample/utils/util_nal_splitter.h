@@ -0,0 +1,76 @@
+/**
+ ******************************************************************************
+ * @file    util_nal_splitter.h
+ * @brief   This is the header file for "util_nal_splitter.c".
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ ******************************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef _DJI_UTIL_NAL_SPLITTER_H_
+#define _DJI_UTIL_NAL_SPLITTER_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+#define UTIL_NAL_SPLITTER_NO_NAL               0xFFFFFFFFU
+#define UTIL_NAL_SPLITTER_MIN_WRITE_SPAN       4096
+
+/* Exported macros -----------------------------------------------------------*/
+/* Exported types ------------------------------------------------------------*/
+typedef void (*UtilNalSplitterCallback)(const uint8_t *nalData, uint32_t nalLen, void *userData);
+
+//Note: the splitter owns no memory, the caller provides one block which is used as two halves.
+//Each complete NAL unit (including its 3 or 4 byte start code) is passed to the callback as a
+//contiguous slice of the active half, which stays valid until the callback returns.
+typedef struct {
+    uint8_t *bufferPtr[2];
+    uint32_t bufferSize;
+    uint8_t activeIndex;
+    uint32_t dataLen;
+    uint32_t nalStart;
+    uint32_t scanOffset;
+    uint32_t droppedBytes;
+    UtilNalSplitterCallback callback;
+    void *userData;
+} T_UtilNalSplitter;
+
+/* Exported variables --------------------------------------------------------*/
+/* Exported functions --------------------------------------------------------*/
+void UtilNalSplitter_Init(T_UtilNalSplitter *pthis, uint8_t *pBuf, uint32_t bufSize,
+                          UtilNalSplitterCallback callback, void *userData);
+void UtilNalSplitter_Reset(T_UtilNalSplitter *pthis);
+uint32_t UtilNalSplitter_GetWritableSpan(T_UtilNalSplitter *pthis, uint8_t **pSpan);
+void UtilNalSplitter_CommitWrite(T_UtilNalSplitter *pthis, uint32_t dataLen);
+uint32_t UtilNalSplitter_Put(T_UtilNalSplitter *pthis, const uint8_t *pData, uint32_t dataLen);
+void UtilNalSplitter_Flush(T_UtilNalSplitter *pthis);
+const uint8_t *UtilNalSplitter_FindStartCode(const uint8_t *pData, const uint8_t *pEnd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
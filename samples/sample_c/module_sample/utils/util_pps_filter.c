@@ -0,0 +1,291 @@
+/**
+ ********************************************************************
+ * @file    util_pps_filter.c
+ * @brief   The file defines a filter for PPS edge timestamps, including outlier rejection, missed pulse
+ *          detection and a least squares fit of the local clock period, i.e. its drift.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "util_pps_filter.h"
+#include <math.h>
+#include <string.h>
+
+/* Private constants ---------------------------------------------------------*/
+/* Until the fit has this many edges the period is not trusted and the outlier gate is widened by the drift bound. */
+#define UTIL_PPS_FILTER_TRUSTED_EDGE_NUM    3
+
+/* Private types -------------------------------------------------------------*/
+
+/* Private functions declaration ---------------------------------------------*/
+static void UtilPpsFilter_Restart(T_UtilPpsFilter *filter, uint64_t edgeTimeUs);
+static void UtilPpsFilter_PushEdge(T_UtilPpsFilter *filter, uint32_t pulse, double offsetUs);
+static void UtilPpsFilter_Fit(T_UtilPpsFilter *filter);
+static void UtilPpsFilter_CountMissedPulse(T_UtilPpsFilter *filter, uint32_t pulse);
+
+/* Private values ------------------------------------------------------------*/
+
+/* Exported functions definition ---------------------------------------------*/
+void UtilPpsFilter_GetDefaultConfig(T_UtilPpsFilterConfig *config)
+{
+    config->nominalPeriodUs = UTIL_PPS_FILTER_DEFAULT_PERIOD_US;
+    config->windowSize = UTIL_PPS_FILTER_DEFAULT_WINDOW_SIZE;
+    config->outlierThresholdUs = UTIL_PPS_FILTER_DEFAULT_OUTLIER_US;
+    config->maxDriftPpm = UTIL_PPS_FILTER_DEFAULT_MAX_DRIFT_PPM;
+    config->resetOutlierNum = UTIL_PPS_FILTER_DEFAULT_RESET_OUTLIER_NUM;
+}
+
+T_DjiReturnCode UtilPpsFilter_Init(T_UtilPpsFilter *filter, const T_UtilPpsFilterConfig *config)
+{
+    if (filter == NULL || config == NULL || config->nominalPeriodUs == 0 || config->windowSize < 2 ||
+        config->windowSize > UTIL_PPS_FILTER_WINDOW_MAX || config->resetOutlierNum == 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    memset(filter, 0, sizeof(T_UtilPpsFilter));
+    filter->config = *config;
+    filter->periodUs = config->nominalPeriodUs;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Add the local time of one captured edge.
+ * @note Edges are numbered by rounding their distance from the fitted line to whole periods, so a missed pulse only
+ * skips a number and a second edge within the same period is dropped. An edge is accepted into the window when it is
+ * within outlierThresholdUs of the line, otherwise the line's time for that pulse is reported in its place, which
+ * keeps a single late edge (interrupt latency, scheduling) from reaching the time sync.
+ */
+T_DjiReturnCode UtilPpsFilter_AddEdge(T_UtilPpsFilter *filter, uint64_t edgeTimeUs, E_UtilPpsFilterEdgeState *state)
+{
+    double offsetUs;
+    double pulseFloat;
+    double residualUs;
+    double toleranceUs;
+    uint32_t pulse;
+
+    if (filter == NULL || state == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    filter->statistics.edgeCount++;
+    if (!filter->started) {
+        UtilPpsFilter_Restart(filter, edgeTimeUs);
+        filter->statistics.acceptedCount++;
+        *state = UTIL_PPS_FILTER_EDGE_ACCEPTED;
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    offsetUs = (double) (int64_t) (edgeTimeUs - filter->originUs);
+    pulseFloat = (offsetUs - filter->interceptUs) / filter->periodUs;
+
+    if (pulseFloat < (double) filter->acceptedPulse + 0.5) {
+        //same period as the newest accepted edge, or the local clock stepped backwards
+        if (pulseFloat > (double) filter->acceptedPulse - 0.5 ||
+            ++filter->outlierRunNum < filter->config.resetOutlierNum) {
+            filter->statistics.ignoredCount++;
+            *state = UTIL_PPS_FILTER_EDGE_IGNORED;
+            return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+        }
+        UtilPpsFilter_Restart(filter, edgeTimeUs);
+        filter->statistics.resetCount++;
+        *state = UTIL_PPS_FILTER_EDGE_RESET;
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    pulse = (uint32_t) llround(pulseFloat);
+    UtilPpsFilter_CountMissedPulse(filter, pulse);
+
+    if (pulse - filter->acceptedPulse > filter->config.windowSize) {
+        //the fit is older than the window, its extrapolation can not be trusted any more
+        UtilPpsFilter_Restart(filter, edgeTimeUs);
+        filter->statistics.resetCount++;
+        *state = UTIL_PPS_FILTER_EDGE_RESET;
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    residualUs = offsetUs - (filter->interceptUs + filter->periodUs * pulse);
+    toleranceUs = filter->config.outlierThresholdUs;
+    if (filter->edgeNum < UTIL_PPS_FILTER_TRUSTED_EDGE_NUM) {
+        toleranceUs += (double) filter->config.maxDriftPpm * 1e-6 * filter->config.nominalPeriodUs *
+                       (pulse - filter->acceptedPulse);
+    }
+
+    if (fabs(residualUs) > toleranceUs) {
+        filter->statistics.outlierCount++;
+        if (filter->outlierRunNum == 0 || pulse != filter->lastOutlierPulse) {
+            filter->outlierRunNum++;
+        }
+        filter->lastOutlierPulse = pulse;
+
+        if (filter->outlierRunNum >= filter->config.resetOutlierNum) {
+            UtilPpsFilter_Restart(filter, edgeTimeUs);
+            filter->statistics.resetCount++;
+            *state = UTIL_PPS_FILTER_EDGE_RESET;
+            return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+        }
+
+        filter->outputPulse = pulse > filter->outputPulse ? pulse : filter->outputPulse;
+        *state = UTIL_PPS_FILTER_EDGE_OUTLIER;
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    UtilPpsFilter_PushEdge(filter, pulse, offsetUs);
+    UtilPpsFilter_Fit(filter);
+
+    if (filter->edgeNum >= UTIL_PPS_FILTER_TRUSTED_EDGE_NUM &&
+        fabs(filter->periodUs - filter->config.nominalPeriodUs) * 1e6 >
+        (double) filter->config.maxDriftPpm * filter->config.nominalPeriodUs) {
+        UtilPpsFilter_Restart(filter, edgeTimeUs);
+        filter->statistics.resetCount++;
+        *state = UTIL_PPS_FILTER_EDGE_RESET;
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    filter->outlierRunNum = 0;
+    filter->acceptedPulse = pulse;
+    filter->outputPulse = pulse;
+    filter->statistics.acceptedCount++;
+    *state = UTIL_PPS_FILTER_EDGE_ACCEPTED;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode UtilPpsFilter_GetEstimate(const T_UtilPpsFilter *filter, T_UtilPpsFilterEstimate *estimate)
+{
+    double edgeOffsetUs;
+
+    if (filter == NULL || estimate == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    if (!filter->started) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+    }
+
+    edgeOffsetUs = filter->interceptUs + filter->periodUs * filter->outputPulse;
+    estimate->edgeTimeUs = filter->originUs + (uint64_t) llround(edgeOffsetUs);
+    estimate->periodUs = filter->periodUs;
+    estimate->driftPpm = (filter->periodUs - filter->config.nominalPeriodUs) * 1e6 / filter->config.nominalPeriodUs;
+    estimate->residualRmsUs = filter->residualRmsUs;
+    estimate->fitEdgeNum = filter->edgeNum;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+void UtilPpsFilter_GetStatistics(const T_UtilPpsFilter *filter, T_UtilPpsFilterStatistics *statistics)
+{
+    *statistics = filter->statistics;
+}
+
+/* Private functions definition-----------------------------------------------*/
+static void UtilPpsFilter_Restart(T_UtilPpsFilter *filter, uint64_t edgeTimeUs)
+{
+    filter->started = true;
+    filter->originUs = edgeTimeUs;
+    filter->edgeHead = 0;
+    filter->edgeNum = 0;
+    filter->acceptedPulse = 0;
+    filter->outputPulse = 0;
+    filter->lastOutlierPulse = 0;
+    filter->outlierRunNum = 0;
+    filter->interceptUs = 0;
+    filter->periodUs = filter->config.nominalPeriodUs;
+    filter->residualRmsUs = 0;
+
+    UtilPpsFilter_PushEdge(filter, 0, 0);
+}
+
+static void UtilPpsFilter_PushEdge(T_UtilPpsFilter *filter, uint32_t pulse, double offsetUs)
+{
+    uint32_t index;
+
+    if (filter->edgeNum < filter->config.windowSize) {
+        index = (filter->edgeHead + filter->edgeNum) % filter->config.windowSize;
+        filter->edgeNum++;
+    } else {
+        index = filter->edgeHead;
+        filter->edgeHead = (filter->edgeHead + 1) % filter->config.windowSize;
+    }
+
+    filter->edgePulse[index] = pulse;
+    filter->edgeOffsetUs[index] = offsetUs;
+}
+
+/**
+ * @brief Least squares fit of offset = intercept + period * pulse over the window.
+ * @note With a single edge the previous period is kept. Sums are taken around the means, the offsets grow with the
+ * run time and the plain sums of squares would lose the sub-microsecond part.
+ */
+static void UtilPpsFilter_Fit(T_UtilPpsFilter *filter)
+{
+    double meanPulse = 0;
+    double meanOffsetUs = 0;
+    double sumPulsePulse = 0;
+    double sumPulseOffset = 0;
+    double sumResidual = 0;
+    double pulse;
+    double residualUs;
+    uint32_t index;
+    uint32_t i;
+
+    for (i = 0; i < filter->edgeNum; i++) {
+        index = (filter->edgeHead + i) % filter->config.windowSize;
+        meanPulse += filter->edgePulse[index];
+        meanOffsetUs += filter->edgeOffsetUs[index];
+    }
+    meanPulse /= filter->edgeNum;
+    meanOffsetUs /= filter->edgeNum;
+
+    for (i = 0; i < filter->edgeNum; i++) {
+        index = (filter->edgeHead + i) % filter->config.windowSize;
+        pulse = filter->edgePulse[index] - meanPulse;
+        sumPulsePulse += pulse * pulse;
+        sumPulseOffset += pulse * (filter->edgeOffsetUs[index] - meanOffsetUs);
+    }
+
+    if (sumPulsePulse > 0) {
+        filter->periodUs = sumPulseOffset / sumPulsePulse;
+    }
+    filter->interceptUs = meanOffsetUs - filter->periodUs * meanPulse;
+
+    if (filter->edgeNum <= 2) {
+        filter->residualRmsUs = 0;
+        return;
+    }
+
+    for (i = 0; i < filter->edgeNum; i++) {
+        index = (filter->edgeHead + i) % filter->config.windowSize;
+        residualUs = filter->edgeOffsetUs[index] - (filter->interceptUs + filter->periodUs * filter->edgePulse[index]);
+        sumResidual += residualUs * residualUs;
+    }
+    filter->residualRmsUs = sqrt(sumResidual / (filter->edgeNum - 2));
+}
+
+static void UtilPpsFilter_CountMissedPulse(T_UtilPpsFilter *filter, uint32_t pulse)
+{
+    uint32_t newestPulse = filter->acceptedPulse > filter->outputPulse ? filter->acceptedPulse : filter->outputPulse;
+
+    if (pulse > newestPulse + 1) {
+        filter->statistics.missedPulseCount += pulse - newestPulse - 1;
+    }
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,122 @@
+/**
+ ********************************************************************
+ * @file    util_pps_filter.h
+ * @brief   This is the header file for "util_pps_filter.c", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef UTIL_PPS_FILTER_H
+#define UTIL_PPS_FILTER_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_typedef.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+#define UTIL_PPS_FILTER_WINDOW_MAX                 64
+#define UTIL_PPS_FILTER_DEFAULT_PERIOD_US          1000000
+#define UTIL_PPS_FILTER_DEFAULT_WINDOW_SIZE        16
+#define UTIL_PPS_FILTER_DEFAULT_OUTLIER_US         200
+#define UTIL_PPS_FILTER_DEFAULT_MAX_DRIFT_PPM      500
+#define UTIL_PPS_FILTER_DEFAULT_RESET_OUTLIER_NUM  3
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum {
+    /*! The edge was used in the fit. */
+    UTIL_PPS_FILTER_EDGE_ACCEPTED = 0,
+    /*! The edge was too far from the fitted line, the predicted time of its pulse is reported instead. */
+    UTIL_PPS_FILTER_EDGE_OUTLIER,
+    /*! A second edge within the same pulse (contact bounce, noise), it is dropped. */
+    UTIL_PPS_FILTER_EDGE_IGNORED,
+    /*! Too many outliers in a row, or the fit drifted out of range: the filter restarted from this edge. */
+    UTIL_PPS_FILTER_EDGE_RESET,
+} E_UtilPpsFilterEdgeState;
+
+typedef struct {
+    /*! Nominal pulse period on the local clock. */
+    uint32_t nominalPeriodUs;
+    /*! Number of the newest accepted edges the line is fitted over, at most UTIL_PPS_FILTER_WINDOW_MAX. */
+    uint32_t windowSize;
+    /*! Edges further than this from the fitted line are rejected. */
+    uint32_t outlierThresholdUs;
+    /*! Largest frequency error of the local clock against the pulses that is accepted. */
+    uint32_t maxDriftPpm;
+    /*! Number of outliers in a row after which the filter restarts, e.g. after a step of the local clock. */
+    uint32_t resetOutlierNum;
+} T_UtilPpsFilterConfig;
+
+typedef struct {
+    /*! Filtered local time of the newest pulse. */
+    uint64_t edgeTimeUs;
+    /*! Fitted length of one pulse period on the local clock. */
+    double periodUs;
+    /*! Frequency error of the local clock against the pulses, positive when the local clock runs fast. */
+    double driftPpm;
+    /*! Root mean square distance of the fitted edges from the line, i.e. the capture jitter. */
+    double residualRmsUs;
+    uint32_t fitEdgeNum;
+} T_UtilPpsFilterEstimate;
+
+typedef struct {
+    uint32_t edgeCount;
+    uint32_t acceptedCount;
+    uint32_t outlierCount;
+    uint32_t ignoredCount;
+    uint32_t missedPulseCount;
+    uint32_t resetCount;
+} T_UtilPpsFilterStatistics;
+
+typedef struct {
+    T_UtilPpsFilterConfig config;
+    bool started;
+    /*! Raw time of pulse 0, the window below is kept relative to it. */
+    uint64_t originUs;
+    uint32_t edgePulse[UTIL_PPS_FILTER_WINDOW_MAX];
+    double edgeOffsetUs[UTIL_PPS_FILTER_WINDOW_MAX];
+    uint32_t edgeHead;
+    uint32_t edgeNum;
+    uint32_t acceptedPulse;
+    uint32_t outputPulse;
+    uint32_t lastOutlierPulse;
+    uint32_t outlierRunNum;
+    double interceptUs;
+    double periodUs;
+    double residualRmsUs;
+    T_UtilPpsFilterStatistics statistics;
+} T_UtilPpsFilter;
+
+/* Exported functions --------------------------------------------------------*/
+void UtilPpsFilter_GetDefaultConfig(T_UtilPpsFilterConfig *config);
+T_DjiReturnCode UtilPpsFilter_Init(T_UtilPpsFilter *filter, const T_UtilPpsFilterConfig *config);
+T_DjiReturnCode UtilPpsFilter_AddEdge(T_UtilPpsFilter *filter, uint64_t edgeTimeUs, E_UtilPpsFilterEdgeState *state);
+T_DjiReturnCode UtilPpsFilter_GetEstimate(const T_UtilPpsFilter *filter, T_UtilPpsFilterEstimate *estimate);
+void UtilPpsFilter_GetStatistics(const T_UtilPpsFilter *filter, T_UtilPpsFilterStatistics *statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UTIL_PPS_FILTER_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
@@ -0,0 +1,99 @@
+/**
+ ********************************************************************
+ * @file    util_seqlock.c
+ * @brief   The file defines a sequence counter publishing data from one writer to readers which never block it.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "util_seqlock.h"
+#include "dji_platform.h"
+
+/* Private constants ---------------------------------------------------------*/
+/* Retries spent spinning before a reader sleeps, a writer which is not preempted finishes within a few. */
+#define UTIL_SEQLOCK_SPIN_RETRY_MAX         4
+#define UTIL_SEQLOCK_SLEEP_MAX_MS           8
+
+/* Private types -------------------------------------------------------------*/
+
+/* Private functions declaration ---------------------------------------------*/
+
+/* Private values ------------------------------------------------------------*/
+
+/* Exported functions definition ---------------------------------------------*/
+/**
+ * @brief Mark the data as being written, the sequence becomes odd. Writers must be serialized by the caller.
+ */
+void UtilSeqlock_WriteBegin(uint32_t *sequence)
+{
+    __atomic_store_n(sequence, *sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Publish the data written since UtilSeqlock_WriteBegin, the sequence becomes even again.
+ */
+void UtilSeqlock_WriteEnd(uint32_t *sequence)
+{
+    __atomic_store_n(sequence, *sequence + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Start a read, the data is copied after this call.
+ * @return Sequence to pass to UtilSeqlock_ReadEnd, odd while a write is in progress.
+ */
+uint32_t UtilSeqlock_ReadBegin(const uint32_t *sequence)
+{
+    return __atomic_load_n(sequence, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Check the data copied since UtilSeqlock_ReadBegin.
+ * @return true if no write started or was in progress during the copy, otherwise the copy must be discarded.
+ */
+bool UtilSeqlock_ReadEnd(const uint32_t *sequence, uint32_t startSequence)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return (startSequence & 1) == 0 && __atomic_load_n(sequence, __ATOMIC_RELAXED) == startSequence;
+}
+
+/**
+ * @brief Wait before the next read after retry failed reads. The first retries follow at once, later ones sleep
+ * with a growing delay so a writer preempted in the middle of a write gets the CPU to finish it.
+ */
+void UtilSeqlock_ReadBackoff(uint32_t retry)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    uint32_t sleepMs = 1;
+    uint32_t i;
+
+    if (retry < UTIL_SEQLOCK_SPIN_RETRY_MAX) {
+        return;
+    }
+
+    for (i = UTIL_SEQLOCK_SPIN_RETRY_MAX; i < retry && sleepMs < UTIL_SEQLOCK_SLEEP_MAX_MS; i++) {
+        sleepMs <<= 1;
+    }
+    osalHandler->TaskSleepMs(sleepMs);
+}
+
+/* Private functions definition-----------------------------------------------*/
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
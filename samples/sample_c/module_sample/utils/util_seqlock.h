@@ -0,0 +1,54 @@
+/**
+ ********************************************************************
+ * @file    util_seqlock.h
+ * @brief   This is the header file for "util_seqlock.c", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef UTIL_SEQLOCK_H
+#define UTIL_SEQLOCK_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+
+/* Exported types ------------------------------------------------------------*/
+
+/* Exported functions --------------------------------------------------------*/
+void UtilSeqlock_WriteBegin(uint32_t *sequence);
+void UtilSeqlock_WriteEnd(uint32_t *sequence);
+uint32_t UtilSeqlock_ReadBegin(const uint32_t *sequence);
+bool UtilSeqlock_ReadEnd(const uint32_t *sequence, uint32_t startSequence);
+void UtilSeqlock_ReadBackoff(uint32_t retry);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UTIL_SEQLOCK_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
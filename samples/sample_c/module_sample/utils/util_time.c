@@ -26,10 +26,14 @@
 #ifdef SYSTEM_ARCH_LINUX
 
 #include "util_time.h"
+#include "util_misc.h"
+#include <errno.h>
+#include <string.h>
 #include <sys/resource.h>
 #include <time.h>
 
 /* Private constants ---------------------------------------------------------*/
+#define DJI_UTIL_TIME_NSEC_PER_SEC      1000000000ULL
 
 /* Private types -------------------------------------------------------------*/
 
@@ -56,6 +60,105 @@ T_DjiRunTimeStamps DjiUtilTime_GetRunTimeStamps(void)
     return timeStamps;
 }
 
+uint64_t DjiUtilTime_GetMonotonicTimeNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * DJI_UTIL_TIME_NSEC_PER_SEC + (uint64_t) ts.tv_nsec;
+}
+
+uint64_t DjiUtilTime_GetThreadCpuTimeUs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000 + (uint64_t) ts.tv_nsec / 1000;
+}
+
+void DjiUtilTime_PacerInit(T_DjiUtilTimePacer *pacer, uint64_t periodNs)
+{
+    memset(pacer, 0, sizeof(T_DjiUtilTimePacer));
+    pacer->periodNs = periodNs;
+    pacer->deadlineNs = DjiUtilTime_GetMonotonicTimeNs() + periodNs;
+}
+
+/**
+ * @brief Sleep until the next absolute deadline, then advance it by one period.
+ * @note Deadlines are advanced from the previous deadline rather than from the wake up time, so the time spent
+ * between two waits does not accumulate as drift. If the caller falls behind by more than one period the schedule
+ * is restarted from now instead of bursting to catch up.
+ */
+void DjiUtilTime_PacerWait(T_DjiUtilTimePacer *pacer)
+{
+    struct timespec deadline;
+    uint64_t nowNs;
+    uint64_t latenessUs;
+
+    if (DjiUtilTime_GetMonotonicTimeNs() > pacer->deadlineNs) {
+        pacer->overrunCount++;
+    }
+
+    deadline.tv_sec = (time_t) (pacer->deadlineNs / DJI_UTIL_TIME_NSEC_PER_SEC);
+    deadline.tv_nsec = (long) (pacer->deadlineNs % DJI_UTIL_TIME_NSEC_PER_SEC);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+    }
+
+    nowNs = DjiUtilTime_GetMonotonicTimeNs();
+    latenessUs = nowNs > pacer->deadlineNs ? (nowNs - pacer->deadlineNs) / 1000 : 0;
+    pacer->waitCount++;
+    pacer->totalLatenessUs += latenessUs;
+    pacer->maxLatenessUs = USER_UTIL_MAX(pacer->maxLatenessUs, latenessUs);
+    pacer->latenessHistogram[USER_UTIL_MIN(latenessUs / DJI_UTIL_TIME_PACER_HISTOGRAM_STEP_US,
+                                           DJI_UTIL_TIME_PACER_HISTOGRAM_SIZE - 1)]++;
+
+    pacer->deadlineNs += pacer->periodNs;
+    if (pacer->deadlineNs + pacer->periodNs < nowNs) {
+        pacer->deadlineNs = nowNs + pacer->periodNs;
+        pacer->resyncCount++;
+    }
+}
+
+/**
+ * @brief Time left until the next deadline, so callers can wait on an event instead of the pacer until then.
+ * @return Time in microseconds, 0 when the deadline has passed.
+ */
+uint64_t DjiUtilTime_PacerGetTimeToDeadlineUs(const T_DjiUtilTimePacer *pacer)
+{
+    uint64_t nowNs = DjiUtilTime_GetMonotonicTimeNs();
+
+    return nowNs < pacer->deadlineNs ? (pacer->deadlineNs - nowNs) / 1000 : 0;
+}
+
+/**
+ * @brief Wake up lateness below which the given percentage of the waits so far stayed.
+ * @note The result is the upper edge of a histogram bucket, so it is exact to DJI_UTIL_TIME_PACER_HISTOGRAM_STEP_US.
+ * Percentiles falling into the last bucket report the maximum lateness instead.
+ */
+uint64_t DjiUtilTime_PacerGetLatenessPercentileUs(const T_DjiUtilTimePacer *pacer, float percentile)
+{
+    uint64_t rank;
+    uint64_t count = 0;
+    uint32_t i;
+
+    if (pacer->waitCount == 0) {
+        return 0;
+    }
+
+    rank = (uint64_t) ((double) pacer->waitCount * percentile / 100.0 + 0.5);
+    rank = USER_UTIL_MAX(rank, 1);
+    for (i = 0; i < DJI_UTIL_TIME_PACER_HISTOGRAM_SIZE - 1; i++) {
+        count += pacer->latenessHistogram[i];
+        if (count >= rank) {
+            return USER_UTIL_MIN((uint64_t) (i + 1) * DJI_UTIL_TIME_PACER_HISTOGRAM_STEP_US, pacer->maxLatenessUs);
+        }
+    }
+
+    return pacer->maxLatenessUs;
+}
+
 /* Private functions definition-----------------------------------------------*/
 
 #endif
@@ -37,7 +37,9 @@ extern "C" {
 #include <stdint.h>
 
 /* Exported constants --------------------------------------------------------*/
-
+/* Wake up lateness is counted in buckets of this width for percentiles, the last bucket takes everything above. */
+#define DJI_UTIL_TIME_PACER_HISTOGRAM_STEP_US   5
+#define DJI_UTIL_TIME_PACER_HISTOGRAM_SIZE      200
 
 /* Exported types ------------------------------------------------------------*/
 typedef struct {
@@ -46,8 +48,26 @@ typedef struct {
     uint64_t sysUsec;
 } T_DjiRunTimeStamps;
 
+typedef struct {
+    uint64_t periodNs;
+    uint64_t deadlineNs;
+    uint32_t waitCount;
+    uint32_t resyncCount;
+    /*! Waits entered after their deadline had already passed, i.e. the work of one period took too long. */
+    uint32_t overrunCount;
+    uint64_t totalLatenessUs;
+    uint64_t maxLatenessUs;
+    uint32_t latenessHistogram[DJI_UTIL_TIME_PACER_HISTOGRAM_SIZE];
+} T_DjiUtilTimePacer;
+
 /* Exported functions --------------------------------------------------------*/
 T_DjiRunTimeStamps DjiUtilTime_GetRunTimeStamps(void);
+uint64_t DjiUtilTime_GetMonotonicTimeNs(void);
+uint64_t DjiUtilTime_GetThreadCpuTimeUs(void);
+void DjiUtilTime_PacerInit(T_DjiUtilTimePacer *pacer, uint64_t periodNs);
+void DjiUtilTime_PacerWait(T_DjiUtilTimePacer *pacer);
+uint64_t DjiUtilTime_PacerGetTimeToDeadlineUs(const T_DjiUtilTimePacer *pacer);
+uint64_t DjiUtilTime_PacerGetLatenessPercentileUs(const T_DjiUtilTimePacer *pacer, float percentile);
 
 #ifdef __cplusplus
 }
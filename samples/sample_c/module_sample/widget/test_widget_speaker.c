@@ -33,9 +33,9 @@
 #include "utils/util_md5.h"
 #include <dji_aircraft_info.h>
 
-#ifdef OPUS_INSTALLED
+#ifdef SYSTEM_ARCH_LINUX
 
-#include <opus/opus.h>
+#include "test_widget_speaker_stream.h"
 
 #endif
 
@@ -46,18 +46,12 @@
 #define WIDGET_SPEAKER_USB_AUDIO_DEVICE_NAME    "alsa_output.usb-C-Media_Electronics_Inc._USB_Audio_Device-00.analog-stereo"
 
 #define WIDGET_SPEAKER_AUDIO_OPUS_FILE_NAME     "test_audio.opus"
-#define WIDGET_SPEAKER_AUDIO_PCM_FILE_NAME      "test_audio.pcm"
+#define WIDGET_SPEAKER_AUDIO_REPLAY_CHUNK_SIZE  (1024)
 
 #define WIDGET_SPEAKER_TTS_FILE_NAME            "test_tts.txt"
 #define WIDGET_SPEAKER_TTS_OUTPUT_FILE_NAME     "tts_audio.wav"
 #define WIDGET_SPEAKER_TTS_FILE_MAX_SIZE        (3000)
 
-/* The frame size is hardcoded for this sample code but it doesn't have to be */
-#define WIDGET_SPEAKER_AUDIO_OPUS_MAX_PACKET_SIZE          (3 * 1276)
-#define WIDGET_SPEAKER_AUDIO_OPUS_MAX_FRAME_SIZE           (6 * 960)
-#define WIDGET_SPEAKER_AUDIO_OPUS_SAMPLE_RATE              (16000)
-#define WIDGET_SPEAKER_AUDIO_OPUS_CHANNELS                 (1)
-
 #define WIDGET_SPEAKER_AUDIO_OPUS_DECODE_FRAME_SIZE_8KBPS  (40)
 #define WIDGET_SPEAKER_AUDIO_OPUS_DECODE_BITRATE_8KBPS     (8000)
 
@@ -75,10 +69,14 @@ static T_DjiWidgetSpeakerState s_speakerState = {0};
 #ifdef SYSTEM_ARCH_LINUX
 static T_DjiTaskHandle s_widgetSpeakerTestThread;
 static FILE *s_ttsFile = NULL;
+/*! Serializes the file replay pushing into the voice stream against a live voice stream replacing it. */
+static T_DjiMutexHandle s_voiceStreamMutex = NULL;
+static uint32_t s_voiceStreamSession = 0;
+static uint32_t s_liveVoiceStreamSession = 0;
+static uint32_t s_liveVoiceStreamOffset = 0;
 #endif
 
 static FILE *s_audioFile = NULL;
-static bool s_isDecodeFinished = true;
 static uint16_t s_decodeBitrate = 0;
 
 /* Private functions declaration ---------------------------------------------*/
@@ -97,7 +95,8 @@ static T_DjiReturnCode ReceiveAudioData(E_DjiWidgetTransmitDataEvent event,
 static void *DjiTest_WidgetSpeakerTask(void *arg);
 static uint32_t DjiTest_GetVoicePlayProcessId(void);
 static uint32_t DjiTest_KillVoicePlayProcess(uint32_t pid);
-static T_DjiReturnCode DjiTest_DecodeAudioData(void);
+static T_DjiReturnCode DjiTest_StartVoiceStream(void);
+static T_DjiReturnCode DjiTest_ReplayAudioFile(void);
 static T_DjiReturnCode DjiTest_PlayAudioData(void);
 static T_DjiReturnCode DjiTest_PlayTtsData(void);
 static T_DjiReturnCode DjiTest_CheckFileMd5Sum(const char *path, uint8_t *buf, uint16_t size);
@@ -153,6 +152,18 @@ T_DjiReturnCode DjiTest_WidgetSpeakerStartService(void)
     }
 
 #ifdef SYSTEM_ARCH_LINUX
+    returnCode = osalHandler->MutexCreate(&s_voiceStreamMutex);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Create voice stream mutex error: 0x%08llX", returnCode);
+        return returnCode;
+    }
+
+    returnCode = DjiTest_WidgetSpeakerStreamInit();
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Init speaker stream error: 0x%08llX", returnCode);
+        return returnCode;
+    }
+
     if (osalHandler->TaskCreate("user_widget_speaker_task", DjiTest_WidgetSpeakerTask, WIDGET_SPEAKER_TASK_STACK_SIZE,
                                 NULL,
                                 &s_widgetSpeakerTestThread) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
@@ -210,103 +221,94 @@ static uint32_t DjiTest_KillVoicePlayProcess(uint32_t pid)
     return pid;
 }
 
-static T_DjiReturnCode DjiTest_DecodeAudioData(void)
+/* Starts a new voice stream, the caller holds s_voiceStreamMutex. */
+static T_DjiReturnCode DjiTest_StartVoiceStream(void)
 {
-#ifdef OPUS_INSTALLED
-    FILE *fin;
-    FILE *fout;
-    OpusDecoder *decoder;
-    opus_int16 out[WIDGET_SPEAKER_AUDIO_OPUS_MAX_FRAME_SIZE * WIDGET_SPEAKER_AUDIO_OPUS_CHANNELS];
-    uint8_t cbits[WIDGET_SPEAKER_AUDIO_OPUS_MAX_PACKET_SIZE];
-    int32_t nbBytes;
-    int32_t err;
+    T_DjiTestWidgetSpeakerStreamConfig config;
 
-    /*! Attention: you can use "ffmpeg -i xxx.mp3 -ar 16000 -ac 1 out.wav" and use opus-tools to generate opus file for test */
-    fin = fopen(WIDGET_SPEAKER_AUDIO_OPUS_FILE_NAME, "r");
-    if (fin == NULL) {
-        fprintf(stderr, "failed to open input file: %s\n", strerror(errno));
-        return EXIT_FAILURE;
-    }
+    DjiTest_WidgetSpeakerStreamGetDefaultConfig(&config);
+    config.packetSize = s_decodeBitrate / WIDGET_SPEAKER_AUDIO_OPUS_DECODE_BITRATE_8KBPS *
+                        WIDGET_SPEAKER_AUDIO_OPUS_DECODE_FRAME_SIZE_8KBPS;
+    // the voice file is received and replayed faster than it plays, wait for room rather than drop the audio
+    config.blockWhenFull = true;
+
+    s_voiceStreamSession++;
+
+    return DjiTest_WidgetSpeakerStreamStart(&config);
+}
+
+static T_DjiReturnCode DjiTest_ReplayAudioFile(void)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiReturnCode returnCode;
+    uint8_t data[WIDGET_SPEAKER_AUDIO_REPLAY_CHUNK_SIZE];
+    uint32_t session;
+    size_t readLen;
+    FILE *file;
 
-    /* Create a new decoder state. */
-    decoder = opus_decoder_create(WIDGET_SPEAKER_AUDIO_OPUS_SAMPLE_RATE, WIDGET_SPEAKER_AUDIO_OPUS_CHANNELS, &err);
-    if (err < 0) {
-        fprintf(stderr, "failed to create decoder: %s\n", opus_strerror(err));
-        goto close_fin;
+    /*! Attention: you can use "ffmpeg -i xxx.mp3 -ar 16000 -ac 1 out.wav" and use opus-tools to generate opus file for test */
+    file = fopen(WIDGET_SPEAKER_AUDIO_OPUS_FILE_NAME, "rb");
+    if (file == NULL) {
+        USER_LOG_ERROR("Open voice file error: %s.", strerror(errno));
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
     }
 
-    fout = fopen(WIDGET_SPEAKER_AUDIO_PCM_FILE_NAME, "w");
-    if (fout == NULL) {
-        fprintf(stderr, "failed to open output file: %s\n", strerror(errno));
-        goto close_fin;
+    osalHandler->MutexLock(s_voiceStreamMutex);
+    returnCode = DjiTest_StartVoiceStream();
+    session = s_voiceStreamSession;
+    osalHandler->MutexUnlock(s_voiceStreamMutex);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Start voice stream error: 0x%08llX.", returnCode);
+        fclose(file);
+        return returnCode;
     }
 
+    USER_LOG_INFO("Start Playing...");
     while (1) {
-        int i;
-        unsigned char pcm_bytes[WIDGET_SPEAKER_AUDIO_OPUS_MAX_FRAME_SIZE * WIDGET_SPEAKER_AUDIO_OPUS_CHANNELS * 2];
-        int frame_size;
-
-        /* Read a 16 bits/sample audio frame. */
-        nbBytes = fread(cbits, 1, s_decodeBitrate / WIDGET_SPEAKER_AUDIO_OPUS_DECODE_BITRATE_8KBPS *
-                                  WIDGET_SPEAKER_AUDIO_OPUS_DECODE_FRAME_SIZE_8KBPS, fin);
-        if (feof(fin))
-            break;
+        readLen = fread(data, 1, sizeof(data), file);
 
-        /* Decode the data. In this example, frame_size will be constant because
-           the encoder is using a constant frame size. However, that may not
-           be the case for all encoders, so the decoder must always check
-           the frame size returned. */
-        frame_size = opus_decode(decoder, cbits, nbBytes, out, WIDGET_SPEAKER_AUDIO_OPUS_MAX_FRAME_SIZE, 0);
-        if (frame_size < 0) {
-            fprintf(stderr, "decoder failed: %s\n", opus_strerror(frame_size));
-            goto close_fout;
+        osalHandler->MutexLock(s_voiceStreamMutex);
+        if (session != s_voiceStreamSession) {
+            osalHandler->MutexUnlock(s_voiceStreamMutex);
+            break;
         }
-
-        USER_LOG_DEBUG("decode data to file: %d\r\n", frame_size * WIDGET_SPEAKER_AUDIO_OPUS_CHANNELS);
-        /* Convert to little-endian ordering. */
-        for (i = 0; i < WIDGET_SPEAKER_AUDIO_OPUS_CHANNELS * frame_size; i++) {
-            pcm_bytes[2 * i] = out[i] & 0xFF;
-            pcm_bytes[2 * i + 1] = (out[i] >> 8) & 0xFF;
+        if (readLen == 0) {
+            returnCode = DjiTest_WidgetSpeakerStreamFinish();
+            osalHandler->MutexUnlock(s_voiceStreamMutex);
+            break;
+        }
+        returnCode = DjiTest_WidgetSpeakerStreamPushData(data, (uint32_t) readLen);
+        osalHandler->MutexUnlock(s_voiceStreamMutex);
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            break;
         }
-        /* Write the decoded audio to file. */
-        fwrite(pcm_bytes, sizeof(short), frame_size * WIDGET_SPEAKER_AUDIO_OPUS_CHANNELS, fout);
     }
 
-    USER_LOG_INFO("Decode Finished...");
-    s_isDecodeFinished = true;
-
-decode_data_failed:
-    opus_decoder_destroy(decoder);
-create_decoder_failed:
-    fclose(fout);
-open_pcm_audio_failed:
-    fclose(fin);
-#endif
-    return EXIT_SUCCESS;
-
-#ifdef OPUS_INSTALLED
-close_fout:
-    fclose(fout);
-
-close_fin:
-    fclose(fin);
-
-    return EXIT_FAILURE;
-#endif
+    fclose(file);
 
+    return returnCode;
 }
 
 static T_DjiReturnCode DjiTest_PlayAudioData(void)
 {
-    char cmdStr[128];
+    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    T_DjiTestWidgetSpeakerStreamStatistics statistics;
 
-    memset(cmdStr, 0, sizeof(cmdStr));
-    USER_LOG_INFO("Start Playing...");
+    // a live voice is played while it is received, otherwise play the last received voice file
+    if (!DjiTest_WidgetSpeakerStreamIsActive()) {
+        returnCode = DjiTest_ReplayAudioFile();
+    }
+
+    while (DjiTest_WidgetSpeakerStreamIsActive() && s_speakerState.state == DJI_WIDGET_SPEAKER_STATE_PLAYING) {
+        DjiTest_WidgetSpeakerStreamWaitIdle(100);
+    }
 
-    snprintf(cmdStr, sizeof(cmdStr), "ffplay -nodisp -autoexit -ar 16000 -ac 1 -f s16le -i %s 2>/dev/null",
-             WIDGET_SPEAKER_AUDIO_PCM_FILE_NAME);
+    DjiTest_WidgetSpeakerStreamGetStatistics(&statistics);
+    USER_LOG_INFO("Voice played, packets: %u, dropped: %u, underruns: %u, latency avg: %llu us, max: %llu us.",
+                  statistics.receivedPacketCount, statistics.droppedFrameCount, statistics.underrunCount,
+                  (unsigned long long) statistics.latencyAverageUs, (unsigned long long) statistics.latencyMaxUs);
 
-    return DjiUserUtil_RunSystemCmd(cmdStr);
+    return returnCode;
 }
 
 static T_DjiReturnCode DjiTest_PlayTtsData(void)
@@ -527,6 +529,7 @@ static T_DjiReturnCode StartPlay(void)
     T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
 
 #ifdef SYSTEM_ARCH_LINUX
+    DjiTest_WidgetSpeakerStreamStop();
     pid = DjiTest_GetVoicePlayProcessId();
     if (pid != 0) {
         DjiTest_KillVoicePlayProcess(pid);
@@ -558,6 +561,7 @@ static T_DjiReturnCode StopPlay(void)
     s_speakerState.state = DJI_WIDGET_SPEAKER_STATE_IDEL;
 
 #ifdef SYSTEM_ARCH_LINUX
+    DjiTest_WidgetSpeakerStreamStop();
     pid = DjiTest_GetVoicePlayProcessId();
     if (pid != 0) {
         DjiTest_KillVoicePlayProcess(pid);
@@ -682,12 +686,17 @@ static T_DjiReturnCode ReceiveAudioData(E_DjiWidgetTransmitDataEvent event,
 #ifdef SYSTEM_ARCH_LINUX
     uint16_t writeLen;
     T_DjiReturnCode returnCode;
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
 #endif
 
     T_DjiWidgetTransDataContent transDataContent = {0};
 
     if (event == DJI_WIDGET_TRANSMIT_DATA_EVENT_START) {
-        s_isDecodeFinished = false;
+        memcpy(&transDataContent, buf, size);
+        s_decodeBitrate = transDataContent.transDataStartContent.fileDecodeBitrate;
+        USER_LOG_INFO("Create voice file: %s, decoder bitrate: %d.", transDataContent.transDataStartContent.fileName,
+                      transDataContent.transDataStartContent.fileDecodeBitrate);
+
 #ifdef SYSTEM_ARCH_LINUX
         USER_LOG_INFO("Create voice file.");
         s_audioFile = fopen(WIDGET_SPEAKER_AUDIO_OPUS_FILE_NAME, "wb");
@@ -696,13 +705,19 @@ static T_DjiReturnCode ReceiveAudioData(E_DjiWidgetTransmitDataEvent event,
         }
         if (s_speakerState.state != DJI_WIDGET_SPEAKER_STATE_PLAYING) {
             SetSpeakerState(DJI_WIDGET_SPEAKER_STATE_TRANSMITTING);
+        } else {
+            // already playing, decode and play the voice while it is received, a replay in progress is replaced
+            DjiTest_WidgetSpeakerStreamStop();
+            osalHandler->MutexLock(s_voiceStreamMutex);
+            returnCode = DjiTest_StartVoiceStream();
+            s_liveVoiceStreamSession = s_voiceStreamSession;
+            s_liveVoiceStreamOffset = 0;
+            osalHandler->MutexUnlock(s_voiceStreamMutex);
+            if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+                USER_LOG_ERROR("Start live voice stream error: 0x%08llX.", returnCode);
+            }
         }
 #endif
-
-        memcpy(&transDataContent, buf, size);
-        s_decodeBitrate = transDataContent.transDataStartContent.fileDecodeBitrate;
-        USER_LOG_INFO("Create voice file: %s, decoder bitrate: %d.", transDataContent.transDataStartContent.fileName,
-                      transDataContent.transDataStartContent.fileDecodeBitrate);
     } else if (event == DJI_WIDGET_TRANSMIT_DATA_EVENT_TRANSMIT) {
         USER_LOG_INFO("Transmit voice file, offset: %d, size: %d", offset, size);
 #ifdef SYSTEM_ARCH_LINUX
@@ -713,6 +728,14 @@ static T_DjiReturnCode ReceiveAudioData(E_DjiWidgetTransmitDataEvent event,
                 USER_LOG_ERROR("Write tts file error %d", writeLen);
             }
         }
+
+        // only in order data can be decoded, a repeated block is written to the file above but not played twice
+        osalHandler->MutexLock(s_voiceStreamMutex);
+        if (s_liveVoiceStreamSession == s_voiceStreamSession && offset == s_liveVoiceStreamOffset) {
+            DjiTest_WidgetSpeakerStreamPushData(buf, size);
+            s_liveVoiceStreamOffset += size;
+        }
+        osalHandler->MutexUnlock(s_voiceStreamMutex);
 #endif
         if (s_speakerState.state != DJI_WIDGET_SPEAKER_STATE_PLAYING) {
             SetSpeakerState(DJI_WIDGET_SPEAKER_STATE_TRANSMITTING);
@@ -725,6 +748,12 @@ static T_DjiReturnCode ReceiveAudioData(E_DjiWidgetTransmitDataEvent event,
         }
 
 #ifdef SYSTEM_ARCH_LINUX
+        osalHandler->MutexLock(s_voiceStreamMutex);
+        if (s_liveVoiceStreamSession == s_voiceStreamSession) {
+            DjiTest_WidgetSpeakerStreamFinish();
+        }
+        osalHandler->MutexUnlock(s_voiceStreamMutex);
+
         returnCode = DjiTest_CheckFileMd5Sum(WIDGET_SPEAKER_AUDIO_OPUS_FILE_NAME, buf, size);
         if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
             USER_LOG_ERROR("File md5 sum check failed");
@@ -734,9 +763,6 @@ static T_DjiReturnCode ReceiveAudioData(E_DjiWidgetTransmitDataEvent event,
         if (s_speakerState.state != DJI_WIDGET_SPEAKER_STATE_PLAYING) {
             SetSpeakerState(DJI_WIDGET_SPEAKER_STATE_IDEL);
         }
-#ifdef SYSTEM_ARCH_LINUX
-        DjiTest_DecodeAudioData();
-#endif
     }
 
     return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
@@ -762,10 +788,6 @@ static void *DjiTest_WidgetSpeakerTask(void *arg)
         if (s_speakerState.state == DJI_WIDGET_SPEAKER_STATE_PLAYING) {
             if (s_speakerState.playMode == DJI_WIDGET_SPEAKER_PLAY_MODE_LOOP_PLAYBACK) {
                 if (s_speakerState.workMode == DJI_WIDGET_SPEAKER_WORK_MODE_VOICE) {
-                    USER_LOG_DEBUG("Waiting opus decoder finished...");
-                    while (s_isDecodeFinished == false) {
-                        osalHandler->TaskSleepMs(1);
-                    }
                     djiReturnCode = DjiTest_PlayAudioData();
                     if (djiReturnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
                         USER_LOG_ERROR("Play audio data failed, error: 0x%08llX.", djiReturnCode);
@@ -779,10 +801,6 @@ static void *DjiTest_WidgetSpeakerTask(void *arg)
                 osalHandler->TaskSleepMs(1000);
             } else {
                 if (s_speakerState.workMode == DJI_WIDGET_SPEAKER_WORK_MODE_VOICE) {
-                    USER_LOG_DEBUG("Waiting opus decoder finished...");
-                    while (s_isDecodeFinished == false) {
-                        osalHandler->TaskSleepMs(1);
-                    }
                     djiReturnCode = DjiTest_PlayAudioData();
                     if (djiReturnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
                         USER_LOG_ERROR("Play audio data failed, error: 0x%08llX.", djiReturnCode);
@@ -0,0 +1,924 @@
+/**
+ ********************************************************************
+ * @file    test_widget_speaker_stream.c
+ * @brief   Streaming playback of the widget speaker voice: opus packets are decoded as they are received
+ * into a jitter buffer and played through ALSA, ffplay or into a wav file by a playback task.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#ifdef SYSTEM_ARCH_LINUX
+
+#include "test_widget_speaker_stream.h"
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "dji_logger.h"
+#include "dji_platform.h"
+#include "utils/util_misc.h"
+#include "utils/util_time.h"
+
+#ifdef OPUS_INSTALLED
+#include <opus/opus.h>
+#endif
+
+#ifdef ALSA_INSTALLED
+#include <alsa/asoundlib.h>
+#endif
+
+/* Private constants ---------------------------------------------------------*/
+#define WIDGET_SPEAKER_STREAM_TASK_STACK_SIZE       2048
+/* Decoded frames waiting for their first sample to be played, 64 frames of 20 ms exceed any sensible latency bound. */
+#define WIDGET_SPEAKER_STREAM_FRAME_INFO_NUM        64
+/* Sound card buffer in periods, enough to ride out scheduling jitter of the playback task. */
+#define WIDGET_SPEAKER_STREAM_ALSA_BUFFER_PERIODS   3
+#define WIDGET_SPEAKER_STREAM_WAV_HEADER_SIZE       44
+#define WIDGET_SPEAKER_STREAM_FFPLAY_CMD            "ffplay -nodisp -autoexit -ar %u -ac %u -f s16le -i - 2>/dev/null"
+#define WIDGET_SPEAKER_STREAM_FFPLAY_CMD_MAX_LEN    128
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    uint64_t position;
+    uint64_t receiveTimeUs;
+} T_DjiTestWidgetSpeakerStreamFrameInfo;
+
+typedef struct {
+    E_DjiTestWidgetSpeakerStreamSink type;
+#ifdef ALSA_INSTALLED
+    snd_pcm_t *pcm;
+#endif
+    /*! The wav file or the stdin pipe of ffplay. */
+    FILE *file;
+    uint32_t wavDataSize;
+    T_DjiUtilTimePacer pacer;
+} T_DjiTestWidgetSpeakerStreamSink;
+
+typedef struct {
+    T_DjiTestWidgetSpeakerStreamConfig config;
+    bool active;
+    bool taskExited;
+    bool finishRequest;
+    bool stopRequest;
+    bool dataWaiting;
+    bool spaceWaiting;
+#ifdef OPUS_INSTALLED
+    OpusDecoder *decoder;
+#endif
+    uint8_t packet[DJI_TEST_WIDGET_SPEAKER_STREAM_MAX_PACKET_SIZE];
+    uint32_t packetLen;
+    int16_t *decodeBuffer;
+    /*! Interleaved samples, positions below count sample frames since the start of the stream. */
+    int16_t *ring;
+    uint32_t ringFrames;
+    uint32_t maxLatencyFrames;
+    uint64_t writePosition;
+    uint64_t readPosition;
+    T_DjiTestWidgetSpeakerStreamFrameInfo frameInfo[WIDGET_SPEAKER_STREAM_FRAME_INFO_NUM];
+    uint32_t frameInfoHead;
+    uint32_t frameInfoTail;
+    uint64_t latencySumUs;
+    T_DjiTestWidgetSpeakerStreamStatistics statistics;
+    T_DjiMutexHandle controlMutex;
+    T_DjiMutexHandle producerMutex;
+    T_DjiMutexHandle bufferMutex;
+    T_DjiSemaHandle dataSema;
+    T_DjiSemaHandle spaceSema;
+    T_DjiSemaHandle idleSema;
+    T_DjiTaskHandle playbackTask;
+} T_DjiTestWidgetSpeakerStream;
+
+/* Private functions declaration ---------------------------------------------*/
+static T_DjiReturnCode DjiTest_WidgetSpeakerStreamDecodePacket(void);
+static void DjiTest_WidgetSpeakerStreamFreeResources(void);
+#ifdef OPUS_INSTALLED
+static void *DjiTest_WidgetSpeakerStreamPlaybackTask(void *arg);
+static T_DjiReturnCode DjiTest_WidgetSpeakerStreamAppendFrame(const int16_t *pcm, uint32_t frames,
+                                                               uint64_t receiveTimeUs);
+static void DjiTest_WidgetSpeakerStreamDropOldestFrame(void);
+static void DjiTest_WidgetSpeakerStreamReadFrames(int16_t *pcm, uint32_t frames, uint64_t sinkDelayUs);
+static void DjiTest_WidgetSpeakerStreamDrainSemaphore(T_DjiSemaHandle semaphore);
+static uint64_t DjiTest_WidgetSpeakerStreamGetThreadCpuTimeUs(void);
+static T_DjiReturnCode DjiTest_WidgetSpeakerStreamSinkOpen(T_DjiTestWidgetSpeakerStreamSink *sink,
+                                                            const T_DjiTestWidgetSpeakerStreamConfig *config);
+static T_DjiReturnCode DjiTest_WidgetSpeakerStreamSinkWrite(T_DjiTestWidgetSpeakerStreamSink *sink,
+                                                             const int16_t *pcm, uint32_t frames);
+static uint64_t DjiTest_WidgetSpeakerStreamSinkGetDelayUs(T_DjiTestWidgetSpeakerStreamSink *sink);
+static void DjiTest_WidgetSpeakerStreamSinkClose(T_DjiTestWidgetSpeakerStreamSink *sink, bool drain);
+static void DjiTest_WidgetSpeakerStreamWriteWavHeader(FILE *file, uint32_t sampleRate, uint8_t channels,
+                                                      uint32_t dataSize);
+#endif
+
+/* Private values ------------------------------------------------------------*/
+static T_DjiTestWidgetSpeakerStream s_speakerStream = {0};
+
+/* Exported functions definition ---------------------------------------------*/
+T_DjiReturnCode DjiTest_WidgetSpeakerStreamInit(void)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    if (s_speakerStream.bufferMutex != NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    // created once and kept, callers racing a stop never see them destroyed
+    if (osalHandler->MutexCreate(&s_speakerStream.controlMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS ||
+        osalHandler->MutexCreate(&s_speakerStream.producerMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS ||
+        osalHandler->MutexCreate(&s_speakerStream.bufferMutex) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS ||
+        osalHandler->SemaphoreCreate(0, &s_speakerStream.dataSema) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS ||
+        osalHandler->SemaphoreCreate(0, &s_speakerStream.spaceSema) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS ||
+        osalHandler->SemaphoreCreate(0, &s_speakerStream.idleSema) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Create speaker stream mutex or semaphore error.");
+        s_speakerStream.bufferMutex = NULL;
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+void DjiTest_WidgetSpeakerStreamGetDefaultConfig(T_DjiTestWidgetSpeakerStreamConfig *config)
+{
+    memset(config, 0, sizeof(T_DjiTestWidgetSpeakerStreamConfig));
+
+    config->sampleRate = DJI_TEST_WIDGET_SPEAKER_STREAM_DEFAULT_SAMPLE_RATE;
+    config->channels = DJI_TEST_WIDGET_SPEAKER_STREAM_DEFAULT_CHANNELS;
+    // 40 ms packets of the 8 kbps voice
+    config->packetSize = 40;
+    config->jitterBufferMs = DJI_TEST_WIDGET_SPEAKER_STREAM_DEFAULT_JITTER_BUFFER_MS;
+    config->maxLatencyMs = DJI_TEST_WIDGET_SPEAKER_STREAM_DEFAULT_MAX_LATENCY_MS;
+    config->periodMs = DJI_TEST_WIDGET_SPEAKER_STREAM_DEFAULT_PERIOD_MS;
+    config->blockWhenFull = false;
+#ifdef ALSA_INSTALLED
+    config->sink = DJI_TEST_WIDGET_SPEAKER_STREAM_SINK_ALSA;
+#else
+    config->sink = DJI_TEST_WIDGET_SPEAKER_STREAM_SINK_FFPLAY;
+#endif
+    strncpy(config->alsaDevice, DJI_TEST_WIDGET_SPEAKER_STREAM_DEFAULT_ALSA_DEVICE, sizeof(config->alsaDevice) - 1);
+    strncpy(config->wavFilePath, DJI_TEST_WIDGET_SPEAKER_STREAM_DEFAULT_WAV_FILE_NAME,
+            sizeof(config->wavFilePath) - 1);
+}
+
+T_DjiReturnCode DjiTest_WidgetSpeakerStreamStart(const T_DjiTestWidgetSpeakerStreamConfig *config)
+{
+#ifdef OPUS_INSTALLED
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiReturnCode returnCode;
+    int err;
+#endif
+
+    if (config == NULL || config->sampleRate == 0 || config->channels == 0 || config->channels > 2 ||
+        config->packetSize == 0 || config->packetSize > DJI_TEST_WIDGET_SPEAKER_STREAM_MAX_PACKET_SIZE ||
+        config->periodMs == 0 || config->maxLatencyMs < config->jitterBufferMs + config->periodMs) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+#ifndef OPUS_INSTALLED
+    USER_LOG_WARN("Opus is not installed, the speaker voice can not be decoded.");
+    return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
+#else
+#ifndef ALSA_INSTALLED
+    if (config->sink == DJI_TEST_WIDGET_SPEAKER_STREAM_SINK_ALSA) {
+        USER_LOG_WARN("ALSA is not installed, please play the speaker voice through ffplay or into a wav file.");
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
+    }
+#endif
+
+    if (s_speakerStream.bufferMutex == NULL) {
+        USER_LOG_ERROR("Speaker stream is not initialized.");
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE;
+    }
+
+    DjiTest_WidgetSpeakerStreamStop();
+
+    osalHandler->MutexLock(s_speakerStream.controlMutex);
+    osalHandler->MutexLock(s_speakerStream.producerMutex);
+    osalHandler->MutexLock(s_speakerStream.bufferMutex);
+
+    s_speakerStream.config = *config;
+    s_speakerStream.taskExited = false;
+    s_speakerStream.finishRequest = false;
+    s_speakerStream.stopRequest = false;
+    s_speakerStream.dataWaiting = false;
+    s_speakerStream.spaceWaiting = false;
+    s_speakerStream.packetLen = 0;
+    s_speakerStream.writePosition = 0;
+    s_speakerStream.readPosition = 0;
+    s_speakerStream.frameInfoHead = 0;
+    s_speakerStream.frameInfoTail = 0;
+    s_speakerStream.latencySumUs = 0;
+    memset(&s_speakerStream.statistics, 0, sizeof(s_speakerStream.statistics));
+    DjiTest_WidgetSpeakerStreamDrainSemaphore(s_speakerStream.dataSema);
+    DjiTest_WidgetSpeakerStreamDrainSemaphore(s_speakerStream.spaceSema);
+    DjiTest_WidgetSpeakerStreamDrainSemaphore(s_speakerStream.idleSema);
+
+    // room for the latency bound plus one more frame, so a frame always fits once older ones are dropped
+    s_speakerStream.maxLatencyFrames = config->maxLatencyMs * config->sampleRate / 1000;
+    s_speakerStream.ringFrames = s_speakerStream.maxLatencyFrames + DJI_TEST_WIDGET_SPEAKER_STREAM_MAX_FRAME_SIZE;
+    s_speakerStream.ring = malloc((size_t) s_speakerStream.ringFrames * config->channels * sizeof(int16_t));
+    s_speakerStream.decodeBuffer = malloc(DJI_TEST_WIDGET_SPEAKER_STREAM_MAX_FRAME_SIZE * config->channels *
+                                          sizeof(int16_t));
+    if (s_speakerStream.ring == NULL || s_speakerStream.decodeBuffer == NULL) {
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+        goto out;
+    }
+
+    s_speakerStream.decoder = opus_decoder_create((opus_int32) config->sampleRate, config->channels, &err);
+    if (err != OPUS_OK) {
+        USER_LOG_ERROR("Create opus decoder error: %s.", opus_strerror(err));
+        s_speakerStream.decoder = NULL;
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+        goto out;
+    }
+
+    s_speakerStream.active = true;
+    returnCode = osalHandler->TaskCreate("speaker_stream", DjiTest_WidgetSpeakerStreamPlaybackTask,
+                                         WIDGET_SPEAKER_STREAM_TASK_STACK_SIZE, NULL,
+                                         &s_speakerStream.playbackTask);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_ERROR("Create speaker stream task error: 0x%08llX.", returnCode);
+        s_speakerStream.active = false;
+    }
+
+out:
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        DjiTest_WidgetSpeakerStreamFreeResources();
+    }
+    osalHandler->MutexUnlock(s_speakerStream.bufferMutex);
+    osalHandler->MutexUnlock(s_speakerStream.producerMutex);
+    osalHandler->MutexUnlock(s_speakerStream.controlMutex);
+
+    return returnCode;
+#endif
+}
+
+/**
+ * @brief Append received opus stream bytes, every complete packet is decoded into the jitter buffer right away.
+ * @note The bytes may split packets anywhere, the remainder is kept until the next call.
+ */
+T_DjiReturnCode DjiTest_WidgetSpeakerStreamPushData(const uint8_t *data, uint32_t len)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    uint32_t copyLen;
+
+    if (data == NULL && len > 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    osalHandler->MutexLock(s_speakerStream.producerMutex);
+
+    if (!s_speakerStream.active || s_speakerStream.finishRequest) {
+        osalHandler->MutexUnlock(s_speakerStream.producerMutex);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE;
+    }
+
+    while (len > 0) {
+        copyLen = USER_UTIL_MIN(s_speakerStream.config.packetSize - s_speakerStream.packetLen, len);
+        memcpy(s_speakerStream.packet + s_speakerStream.packetLen, data, copyLen);
+        s_speakerStream.packetLen += copyLen;
+        data += copyLen;
+        len -= copyLen;
+
+        if (s_speakerStream.packetLen == s_speakerStream.config.packetSize) {
+            returnCode = DjiTest_WidgetSpeakerStreamDecodePacket();
+            s_speakerStream.packetLen = 0;
+            if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+                break;
+            }
+        }
+    }
+
+    osalHandler->MutexUnlock(s_speakerStream.producerMutex);
+
+    return returnCode;
+}
+
+/**
+ * @brief No more data will be pushed, the playback task plays what is buffered and then exits.
+ */
+T_DjiReturnCode DjiTest_WidgetSpeakerStreamFinish(void)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    osalHandler->MutexLock(s_speakerStream.producerMutex);
+    osalHandler->MutexLock(s_speakerStream.bufferMutex);
+
+    if (!s_speakerStream.active) {
+        osalHandler->MutexUnlock(s_speakerStream.bufferMutex);
+        osalHandler->MutexUnlock(s_speakerStream.producerMutex);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE;
+    }
+
+    s_speakerStream.finishRequest = true;
+    if (s_speakerStream.dataWaiting) {
+        s_speakerStream.dataWaiting = false;
+        osalHandler->SemaphorePost(s_speakerStream.dataSema);
+    }
+
+    osalHandler->MutexUnlock(s_speakerStream.bufferMutex);
+    osalHandler->MutexUnlock(s_speakerStream.producerMutex);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiTest_WidgetSpeakerStreamWaitIdle(uint32_t timeoutMs)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    if (!DjiTest_WidgetSpeakerStreamIsActive()) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    if (osalHandler->SemaphoreTimedWait(s_speakerStream.idleSema, timeoutMs) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_TIMEOUT;
+    }
+
+    // hand the exit notification on to DjiTest_WidgetSpeakerStreamStop()
+    osalHandler->SemaphorePost(s_speakerStream.idleSema);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Stop the playback right away and release the stream, also used to clean up a stream that played out.
+ */
+T_DjiReturnCode DjiTest_WidgetSpeakerStreamStop(void)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    if (s_speakerStream.bufferMutex == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    osalHandler->MutexLock(s_speakerStream.controlMutex);
+    osalHandler->MutexLock(s_speakerStream.bufferMutex);
+
+    if (!s_speakerStream.active) {
+        osalHandler->MutexUnlock(s_speakerStream.bufferMutex);
+        osalHandler->MutexUnlock(s_speakerStream.controlMutex);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    // a producer blocked for room holds the producer mutex, wake it before taking that mutex
+    s_speakerStream.stopRequest = true;
+    if (s_speakerStream.dataWaiting) {
+        s_speakerStream.dataWaiting = false;
+        osalHandler->SemaphorePost(s_speakerStream.dataSema);
+    }
+    if (s_speakerStream.spaceWaiting) {
+        s_speakerStream.spaceWaiting = false;
+        osalHandler->SemaphorePost(s_speakerStream.spaceSema);
+    }
+
+    osalHandler->MutexUnlock(s_speakerStream.bufferMutex);
+
+    osalHandler->SemaphoreWait(s_speakerStream.idleSema);
+    osalHandler->TaskDestroy(s_speakerStream.playbackTask);
+    s_speakerStream.playbackTask = NULL;
+
+    osalHandler->MutexLock(s_speakerStream.producerMutex);
+    osalHandler->MutexLock(s_speakerStream.bufferMutex);
+    DjiTest_WidgetSpeakerStreamFreeResources();
+    s_speakerStream.active = false;
+    osalHandler->MutexUnlock(s_speakerStream.bufferMutex);
+    osalHandler->MutexUnlock(s_speakerStream.producerMutex);
+
+    osalHandler->MutexUnlock(s_speakerStream.controlMutex);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+bool DjiTest_WidgetSpeakerStreamIsActive(void)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    bool isActive;
+
+    if (s_speakerStream.bufferMutex == NULL) {
+        return false;
+    }
+
+    osalHandler->MutexLock(s_speakerStream.bufferMutex);
+    isActive = s_speakerStream.active && !s_speakerStream.taskExited;
+    osalHandler->MutexUnlock(s_speakerStream.bufferMutex);
+
+    return isActive;
+}
+
+void DjiTest_WidgetSpeakerStreamGetStatistics(T_DjiTestWidgetSpeakerStreamStatistics *statistics)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    if (s_speakerStream.bufferMutex == NULL) {
+        memset(statistics, 0, sizeof(T_DjiTestWidgetSpeakerStreamStatistics));
+        return;
+    }
+
+    osalHandler->MutexLock(s_speakerStream.bufferMutex);
+    *statistics = s_speakerStream.statistics;
+    statistics->latencyAverageUs = s_speakerStream.statistics.latencyCount > 0 ?
+                                   s_speakerStream.latencySumUs / s_speakerStream.statistics.latencyCount : 0;
+    osalHandler->MutexUnlock(s_speakerStream.bufferMutex);
+}
+
+/* Private functions definition-----------------------------------------------*/
+/* Called with the producer mutex held. */
+static T_DjiReturnCode DjiTest_WidgetSpeakerStreamDecodePacket(void)
+{
+#ifdef OPUS_INSTALLED
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    uint64_t receiveTimeUs;
+    uint64_t cpuTimeUs;
+    int frames;
+
+    osalHandler->GetTimeUs(&receiveTimeUs);
+    cpuTimeUs = DjiTest_WidgetSpeakerStreamGetThreadCpuTimeUs();
+    frames = opus_decode(s_speakerStream.decoder, s_speakerStream.packet, (opus_int32) s_speakerStream.packetLen,
+                         s_speakerStream.decodeBuffer, DJI_TEST_WIDGET_SPEAKER_STREAM_MAX_FRAME_SIZE, 0);
+    cpuTimeUs = DjiTest_WidgetSpeakerStreamGetThreadCpuTimeUs() - cpuTimeUs;
+
+    osalHandler->MutexLock(s_speakerStream.bufferMutex);
+    s_speakerStream.statistics.receivedPacketCount++;
+    s_speakerStream.statistics.decodeCpuTimeUs += cpuTimeUs;
+    if (frames <= 0) {
+        s_speakerStream.statistics.decodeErrorCount++;
+        osalHandler->MutexUnlock(s_speakerStream.bufferMutex);
+        USER_LOG_DEBUG("Decode speaker voice packet error: %s.", opus_strerror(frames));
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    return DjiTest_WidgetSpeakerStreamAppendFrame(s_speakerStream.decodeBuffer, (uint32_t) frames, receiveTimeUs);
+#else
+    return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
+#endif
+}
+
+/* Called with the producer and buffer mutex held, or before the stream is shared. */
+static void DjiTest_WidgetSpeakerStreamFreeResources(void)
+{
+#ifdef OPUS_INSTALLED
+    if (s_speakerStream.decoder != NULL) {
+        opus_decoder_destroy(s_speakerStream.decoder);
+        s_speakerStream.decoder = NULL;
+    }
+#endif
+    free(s_speakerStream.ring);
+    s_speakerStream.ring = NULL;
+    free(s_speakerStream.decodeBuffer);
+    s_speakerStream.decodeBuffer = NULL;
+}
+
+#ifdef OPUS_INSTALLED
+#ifndef __CC_ARM
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-noreturn"
+#pragma GCC diagnostic ignored "-Wreturn-type"
+#endif
+
+static void *DjiTest_WidgetSpeakerStreamPlaybackTask(void *arg)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    const T_DjiTestWidgetSpeakerStreamConfig *config = &s_speakerStream.config;
+    T_DjiTestWidgetSpeakerStreamSink sink;
+    uint32_t periodFrames = config->periodMs * config->sampleRate / 1000;
+    uint32_t jitterFrames = config->jitterBufferMs * config->sampleRate / 1000;
+    uint32_t bufferedFrames;
+    uint32_t readFrames;
+    uint64_t sinkDelayUs;
+    bool prebuffering = true;
+    bool started = false;
+    int16_t *periodBuffer;
+
+    USER_UTIL_UNUSED(arg);
+
+    periodBuffer = malloc((size_t) periodFrames * config->channels * sizeof(int16_t));
+    if (periodBuffer == NULL) {
+        USER_LOG_ERROR("Malloc speaker stream period buffer error.");
+        goto out;
+    }
+
+    if (DjiTest_WidgetSpeakerStreamSinkOpen(&sink, config) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        goto out;
+    }
+
+    while (1) {
+        sinkDelayUs = started ? DjiTest_WidgetSpeakerStreamSinkGetDelayUs(&sink) : 0;
+
+        osalHandler->MutexLock(s_speakerStream.bufferMutex);
+
+        bufferedFrames = (uint32_t) (s_speakerStream.writePosition - s_speakerStream.readPosition);
+        if (s_speakerStream.stopRequest || (s_speakerStream.finishRequest && bufferedFrames == 0)) {
+            osalHandler->MutexUnlock(s_speakerStream.bufferMutex);
+            break;
+        }
+
+        if (prebuffering && (bufferedFrames >= jitterFrames || s_speakerStream.finishRequest)) {
+            prebuffering = false;
+        }
+
+        // before the first output just wait, after it keep the sound card fed with silence while rebuffering
+        if (prebuffering && !started) {
+            s_speakerStream.dataWaiting = true;
+            osalHandler->MutexUnlock(s_speakerStream.bufferMutex);
+            osalHandler->SemaphoreTimedWait(s_speakerStream.dataSema, config->periodMs);
+            continue;
+        }
+
+        readFrames = prebuffering ? 0 : USER_UTIL_MIN(bufferedFrames, periodFrames);
+        DjiTest_WidgetSpeakerStreamReadFrames(periodBuffer, readFrames, sinkDelayUs);
+
+        if (!prebuffering && readFrames < periodFrames && !s_speakerStream.finishRequest) {
+            s_speakerStream.statistics.underrunCount++;
+            prebuffering = true;
+        }
+
+        if (s_speakerStream.spaceWaiting) {
+            s_speakerStream.spaceWaiting = false;
+            osalHandler->SemaphorePost(s_speakerStream.spaceSema);
+        }
+        s_speakerStream.statistics.playedPeriodCount++;
+        s_speakerStream.statistics.playbackCpuTimeUs = DjiTest_WidgetSpeakerStreamGetThreadCpuTimeUs();
+
+        osalHandler->MutexUnlock(s_speakerStream.bufferMutex);
+
+        memset(periodBuffer + (size_t) readFrames * config->channels, 0,
+               (size_t) (periodFrames - readFrames) * config->channels * sizeof(int16_t));
+        if (DjiTest_WidgetSpeakerStreamSinkWrite(&sink, periodBuffer, periodFrames) !=
+            DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            break;
+        }
+        started = true;
+    }
+
+    DjiTest_WidgetSpeakerStreamSinkClose(&sink, !s_speakerStream.stopRequest);
+
+out:
+    free(periodBuffer);
+
+    osalHandler->MutexLock(s_speakerStream.bufferMutex);
+    s_speakerStream.taskExited = true;
+    s_speakerStream.statistics.playbackCpuTimeUs = DjiTest_WidgetSpeakerStreamGetThreadCpuTimeUs();
+    if (s_speakerStream.spaceWaiting) {
+        s_speakerStream.spaceWaiting = false;
+        osalHandler->SemaphorePost(s_speakerStream.spaceSema);
+    }
+    osalHandler->MutexUnlock(s_speakerStream.bufferMutex);
+
+    osalHandler->SemaphorePost(s_speakerStream.idleSema);
+
+    return NULL;
+}
+
+#ifndef __CC_ARM
+#pragma GCC diagnostic pop
+#endif
+
+/* Called with the buffer mutex held, returns with it released. */
+static T_DjiReturnCode DjiTest_WidgetSpeakerStreamAppendFrame(const int16_t *pcm, uint32_t frames,
+                                                               uint64_t receiveTimeUs)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    uint8_t channels = s_speakerStream.config.channels;
+    uint32_t bufferedFrames;
+    uint32_t ringIndex;
+    uint32_t firstPart;
+
+    while (1) {
+        if (s_speakerStream.stopRequest || s_speakerStream.taskExited) {
+            osalHandler->MutexUnlock(s_speakerStream.bufferMutex);
+            return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE;
+        }
+
+        bufferedFrames = (uint32_t) (s_speakerStream.writePosition - s_speakerStream.readPosition);
+        if (bufferedFrames == 0 ||
+            (bufferedFrames + frames <= s_speakerStream.maxLatencyFrames &&
+             s_speakerStream.frameInfoHead - s_speakerStream.frameInfoTail < WIDGET_SPEAKER_STREAM_FRAME_INFO_NUM)) {
+            break;
+        }
+
+        if (s_speakerStream.config.blockWhenFull) {
+            s_speakerStream.spaceWaiting = true;
+            osalHandler->MutexUnlock(s_speakerStream.bufferMutex);
+            osalHandler->SemaphoreWait(s_speakerStream.spaceSema);
+            osalHandler->MutexLock(s_speakerStream.bufferMutex);
+        } else {
+            DjiTest_WidgetSpeakerStreamDropOldestFrame();
+        }
+    }
+
+    ringIndex = (uint32_t) (s_speakerStream.writePosition % s_speakerStream.ringFrames);
+    firstPart = USER_UTIL_MIN(frames, s_speakerStream.ringFrames - ringIndex);
+    memcpy(s_speakerStream.ring + (size_t) ringIndex * channels, pcm, (size_t) firstPart * channels * sizeof(int16_t));
+    memcpy(s_speakerStream.ring, pcm + (size_t) firstPart * channels,
+           (size_t) (frames - firstPart) * channels * sizeof(int16_t));
+
+    s_speakerStream.frameInfo[s_speakerStream.frameInfoHead % WIDGET_SPEAKER_STREAM_FRAME_INFO_NUM].position =
+        s_speakerStream.writePosition;
+    s_speakerStream.frameInfo[s_speakerStream.frameInfoHead % WIDGET_SPEAKER_STREAM_FRAME_INFO_NUM].receiveTimeUs =
+        receiveTimeUs;
+    s_speakerStream.frameInfoHead++;
+    s_speakerStream.writePosition += frames;
+
+    if (s_speakerStream.dataWaiting) {
+        s_speakerStream.dataWaiting = false;
+        osalHandler->SemaphorePost(s_speakerStream.dataSema);
+    }
+
+    osalHandler->MutexUnlock(s_speakerStream.bufferMutex);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/* Drops the frame being played, or the oldest queued one, called with the buffer mutex held. */
+static void DjiTest_WidgetSpeakerStreamDropOldestFrame(void)
+{
+    if (s_speakerStream.frameInfoTail != s_speakerStream.frameInfoHead &&
+        s_speakerStream.frameInfo[s_speakerStream.frameInfoTail % WIDGET_SPEAKER_STREAM_FRAME_INFO_NUM].position ==
+        s_speakerStream.readPosition) {
+        s_speakerStream.frameInfoTail++;
+    }
+
+    s_speakerStream.readPosition = s_speakerStream.frameInfoTail != s_speakerStream.frameInfoHead ?
+                                   s_speakerStream.frameInfo[s_speakerStream.frameInfoTail %
+                                                             WIDGET_SPEAKER_STREAM_FRAME_INFO_NUM].position :
+                                   s_speakerStream.writePosition;
+    s_speakerStream.statistics.droppedFrameCount++;
+}
+
+/* Copies frames out of the jitter buffer and accounts the latency of frames starting in them, buffer mutex held. */
+static void DjiTest_WidgetSpeakerStreamReadFrames(int16_t *pcm, uint32_t frames, uint64_t sinkDelayUs)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiTestWidgetSpeakerStreamFrameInfo *frameInfo;
+    uint8_t channels = s_speakerStream.config.channels;
+    uint32_t ringIndex;
+    uint32_t firstPart;
+    uint64_t nowUs;
+    uint64_t playTimeUs;
+    uint64_t latencyUs;
+
+    ringIndex = (uint32_t) (s_speakerStream.readPosition % s_speakerStream.ringFrames);
+    firstPart = USER_UTIL_MIN(frames, s_speakerStream.ringFrames - ringIndex);
+    memcpy(pcm, s_speakerStream.ring + (size_t) ringIndex * channels, (size_t) firstPart * channels * sizeof(int16_t));
+    memcpy(pcm + (size_t) firstPart * channels, s_speakerStream.ring,
+           (size_t) (frames - firstPart) * channels * sizeof(int16_t));
+
+    osalHandler->GetTimeUs(&nowUs);
+    while (s_speakerStream.frameInfoTail != s_speakerStream.frameInfoHead) {
+        frameInfo = &s_speakerStream.frameInfo[s_speakerStream.frameInfoTail % WIDGET_SPEAKER_STREAM_FRAME_INFO_NUM];
+        if (frameInfo->position >= s_speakerStream.readPosition + frames) {
+            break;
+        }
+
+        playTimeUs = nowUs + sinkDelayUs +
+                     (frameInfo->position - s_speakerStream.readPosition) * 1000000 /
+                     s_speakerStream.config.sampleRate;
+        latencyUs = playTimeUs > frameInfo->receiveTimeUs ? playTimeUs - frameInfo->receiveTimeUs : 0;
+        s_speakerStream.latencySumUs += latencyUs;
+        s_speakerStream.statistics.latencyCount++;
+        if (latencyUs > s_speakerStream.statistics.latencyMaxUs) {
+            s_speakerStream.statistics.latencyMaxUs = latencyUs;
+        }
+        s_speakerStream.frameInfoTail++;
+    }
+
+    s_speakerStream.readPosition += frames;
+}
+
+static void DjiTest_WidgetSpeakerStreamDrainSemaphore(T_DjiSemaHandle semaphore)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    while (osalHandler->SemaphoreTimedWait(semaphore, 0) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+    }
+}
+
+static uint64_t DjiTest_WidgetSpeakerStreamGetThreadCpuTimeUs(void)
+{
+    struct timespec time;
+
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0) {
+        return 0;
+    }
+
+    return (uint64_t) time.tv_sec * 1000000 + (uint64_t) time.tv_nsec / 1000;
+}
+
+static T_DjiReturnCode DjiTest_WidgetSpeakerStreamSinkOpen(T_DjiTestWidgetSpeakerStreamSink *sink,
+                                                            const T_DjiTestWidgetSpeakerStreamConfig *config)
+{
+    char ffplayCmd[WIDGET_SPEAKER_STREAM_FFPLAY_CMD_MAX_LEN];
+    sigset_t sigSet;
+#ifdef ALSA_INSTALLED
+    int err;
+#endif
+
+    memset(sink, 0, sizeof(T_DjiTestWidgetSpeakerStreamSink));
+    sink->type = config->sink;
+
+    if (sink->type == DJI_TEST_WIDGET_SPEAKER_STREAM_SINK_WAV_FILE) {
+        sink->file = fopen(config->wavFilePath, "wb");
+        if (sink->file == NULL) {
+            USER_LOG_ERROR("Open speaker wav file %s error.", config->wavFilePath);
+            return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        }
+
+        // sizes are filled in on close
+        DjiTest_WidgetSpeakerStreamWriteWavHeader(sink->file, config->sampleRate, config->channels, 0);
+        // the file takes the audio at the pace of a sound card so latency and underruns mean the same
+        DjiUtilTime_PacerInit(&sink->pacer, (uint64_t) config->periodMs * 1000000);
+
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    if (sink->type == DJI_TEST_WIDGET_SPEAKER_STREAM_SINK_FFPLAY) {
+        // an exited ffplay fails the write of this task with EPIPE instead of killing the process with SIGPIPE
+        sigemptyset(&sigSet);
+        sigaddset(&sigSet, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &sigSet, NULL);
+
+        snprintf(ffplayCmd, sizeof(ffplayCmd), WIDGET_SPEAKER_STREAM_FFPLAY_CMD, config->sampleRate,
+                 config->channels);
+        sink->file = popen(ffplayCmd, "w");
+        if (sink->file == NULL) {
+            USER_LOG_ERROR("Start ffplay error: %s.", strerror(errno));
+            return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        }
+
+        // ffplay queues whatever it is given, paced writes keep the audio in the jitter buffer where it is measured
+        DjiUtilTime_PacerInit(&sink->pacer, (uint64_t) config->periodMs * 1000000);
+
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+#ifdef ALSA_INSTALLED
+    err = snd_pcm_open(&sink->pcm, config->alsaDevice, SND_PCM_STREAM_PLAYBACK, 0);
+    if (err < 0) {
+        USER_LOG_ERROR("Open ALSA device %s error: %s.", config->alsaDevice, snd_strerror(err));
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    err = snd_pcm_set_params(sink->pcm, SND_PCM_FORMAT_S16_LE, SND_PCM_ACCESS_RW_INTERLEAVED, config->channels,
+                             config->sampleRate, 1,
+                             config->periodMs * 1000 * WIDGET_SPEAKER_STREAM_ALSA_BUFFER_PERIODS);
+    if (err < 0) {
+        USER_LOG_ERROR("Set ALSA device params error: %s.", snd_strerror(err));
+        snd_pcm_close(sink->pcm);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+#else
+    return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
+#endif
+}
+
+static T_DjiReturnCode DjiTest_WidgetSpeakerStreamSinkWrite(T_DjiTestWidgetSpeakerStreamSink *sink,
+                                                             const int16_t *pcm, uint32_t frames)
+{
+    uint8_t channels = s_speakerStream.config.channels;
+#ifdef ALSA_INSTALLED
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    snd_pcm_sframes_t written;
+#endif
+
+    if (sink->type == DJI_TEST_WIDGET_SPEAKER_STREAM_SINK_WAV_FILE ||
+        sink->type == DJI_TEST_WIDGET_SPEAKER_STREAM_SINK_FFPLAY) {
+        if (fwrite(pcm, sizeof(int16_t) * channels, frames, sink->file) != frames || fflush(sink->file) != 0) {
+            USER_LOG_ERROR("Write speaker %s error.",
+                           sink->type == DJI_TEST_WIDGET_SPEAKER_STREAM_SINK_WAV_FILE ? "wav file" : "ffplay");
+            return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        }
+        sink->wavDataSize += frames * channels * sizeof(int16_t);
+        DjiUtilTime_PacerWait(&sink->pacer);
+
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+#ifdef ALSA_INSTALLED
+    while (frames > 0) {
+        written = snd_pcm_writei(sink->pcm, pcm, frames);
+        if (written < 0) {
+            if (written == -EPIPE) {
+                osalHandler->MutexLock(s_speakerStream.bufferMutex);
+                s_speakerStream.statistics.deviceUnderrunCount++;
+                osalHandler->MutexUnlock(s_speakerStream.bufferMutex);
+            }
+            written = snd_pcm_recover(sink->pcm, (int) written, 1);
+            if (written < 0) {
+                USER_LOG_ERROR("Write ALSA device error: %s.", snd_strerror((int) written));
+                return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+            }
+            continue;
+        }
+        pcm += (size_t) written * channels;
+        frames -= (uint32_t) written;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+#else
+    USER_UTIL_UNUSED(channels);
+    return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;
+#endif
+}
+
+static uint64_t DjiTest_WidgetSpeakerStreamSinkGetDelayUs(T_DjiTestWidgetSpeakerStreamSink *sink)
+{
+#ifdef ALSA_INSTALLED
+    snd_pcm_sframes_t delayFrames;
+
+    if (sink->type == DJI_TEST_WIDGET_SPEAKER_STREAM_SINK_ALSA &&
+        snd_pcm_delay(sink->pcm, &delayFrames) == 0 && delayFrames > 0) {
+        return (uint64_t) delayFrames * 1000000 / s_speakerStream.config.sampleRate;
+    }
+#else
+    USER_UTIL_UNUSED(sink);
+#endif
+
+    return 0;
+}
+
+static void DjiTest_WidgetSpeakerStreamSinkClose(T_DjiTestWidgetSpeakerStreamSink *sink, bool drain)
+{
+    if (sink->type == DJI_TEST_WIDGET_SPEAKER_STREAM_SINK_WAV_FILE) {
+        if (fseek(sink->file, 0, SEEK_SET) == 0) {
+            DjiTest_WidgetSpeakerStreamWriteWavHeader(sink->file, s_speakerStream.config.sampleRate,
+                                                      s_speakerStream.config.channels, sink->wavDataSize);
+        }
+        fclose(sink->file);
+        return;
+    }
+
+    if (sink->type == DJI_TEST_WIDGET_SPEAKER_STREAM_SINK_FFPLAY) {
+        // end of input, ffplay plays out the few periods it holds and exits
+        pclose(sink->file);
+        return;
+    }
+
+#ifdef ALSA_INSTALLED
+    if (drain) {
+        snd_pcm_drain(sink->pcm);
+    } else {
+        snd_pcm_drop(sink->pcm);
+    }
+    snd_pcm_close(sink->pcm);
+#else
+    USER_UTIL_UNUSED(drain);
+#endif
+}
+
+static void DjiTest_WidgetSpeakerStreamWriteWavHeader(FILE *file, uint32_t sampleRate, uint8_t channels,
+                                                      uint32_t dataSize)
+{
+    uint8_t header[WIDGET_SPEAKER_STREAM_WAV_HEADER_SIZE];
+    uint32_t byteRate = sampleRate * channels * sizeof(int16_t);
+    uint32_t fields[] = {36 + dataSize, 16, sampleRate, byteRate, dataSize};
+    uint8_t *field[] = {header + 4, header + 16, header + 24, header + 28, header + 40};
+    uint32_t i;
+
+    memcpy(header, "RIFF\0\0\0\0WAVEfmt ", 16);
+    // PCM, channels, block align and bits per sample
+    header[20] = 1;
+    header[21] = 0;
+    header[22] = channels;
+    header[23] = 0;
+    header[32] = (uint8_t) (channels * sizeof(int16_t));
+    header[33] = 0;
+    header[34] = 16;
+    header[35] = 0;
+    memcpy(header + 36, "data", 4);
+
+    // little endian regardless of the host
+    for (i = 0; i < UTIL_ARRAY_SIZE(fields); i++) {
+        field[i][0] = (uint8_t) fields[i];
+        field[i][1] = (uint8_t) (fields[i] >> 8);
+        field[i][2] = (uint8_t) (fields[i] >> 16);
+        field[i][3] = (uint8_t) (fields[i] >> 24);
+    }
+
+    fwrite(header, 1, sizeof(header), file);
+}
+
+#endif
+#endif
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
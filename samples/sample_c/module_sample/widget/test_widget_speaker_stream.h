@@ -0,0 +1,115 @@
+/**
+ ********************************************************************
+ * @file    test_widget_speaker_stream.h
+ * @brief   This is the header file for "test_widget_speaker_stream.c", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef TEST_WIDGET_SPEAKER_STREAM_H
+#define TEST_WIDGET_SPEAKER_STREAM_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_typedef.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef SYSTEM_ARCH_LINUX
+
+/* Exported constants --------------------------------------------------------*/
+#define DJI_TEST_WIDGET_SPEAKER_STREAM_DEFAULT_SAMPLE_RATE        16000
+#define DJI_TEST_WIDGET_SPEAKER_STREAM_DEFAULT_CHANNELS           1
+#define DJI_TEST_WIDGET_SPEAKER_STREAM_DEFAULT_JITTER_BUFFER_MS   120
+#define DJI_TEST_WIDGET_SPEAKER_STREAM_DEFAULT_MAX_LATENCY_MS     400
+#define DJI_TEST_WIDGET_SPEAKER_STREAM_DEFAULT_PERIOD_MS          20
+#define DJI_TEST_WIDGET_SPEAKER_STREAM_DEFAULT_ALSA_DEVICE        "default"
+#define DJI_TEST_WIDGET_SPEAKER_STREAM_DEFAULT_WAV_FILE_NAME      "test_audio.wav"
+#define DJI_TEST_WIDGET_SPEAKER_STREAM_PATH_MAX                   256
+/* Longest opus packet and frame, 120 ms at 48 kHz. */
+#define DJI_TEST_WIDGET_SPEAKER_STREAM_MAX_PACKET_SIZE            (3 * 1276)
+#define DJI_TEST_WIDGET_SPEAKER_STREAM_MAX_FRAME_SIZE             (6 * 960)
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum {
+    DJI_TEST_WIDGET_SPEAKER_STREAM_SINK_ALSA = 0,
+    /*! Writes the played audio to a wav file in real time, for hosts without a sound card and for tests. */
+    DJI_TEST_WIDGET_SPEAKER_STREAM_SINK_WAV_FILE,
+    /*! Pipes the audio into ffplay as the sample did before, for hosts built without the ALSA development files. */
+    DJI_TEST_WIDGET_SPEAKER_STREAM_SINK_FFPLAY,
+} E_DjiTestWidgetSpeakerStreamSink;
+
+typedef struct {
+    uint32_t sampleRate;
+    uint8_t channels;
+    /*! Size of each opus packet in the received byte stream, the packets of a voice file are of constant size. */
+    uint16_t packetSize;
+    /*! Audio buffered before output starts, and again after an underrun. */
+    uint32_t jitterBufferMs;
+    /*! Upper bound of the buffered audio, the oldest frame is dropped to make room unless blockWhenFull is set. */
+    uint32_t maxLatencyMs;
+    /*! Amount of audio handed to the sink at a time. */
+    uint32_t periodMs;
+    /*! Make DjiTest_WidgetSpeakerStreamPushData() wait for room instead, for audio received faster than it plays. */
+    bool blockWhenFull;
+    E_DjiTestWidgetSpeakerStreamSink sink;
+    char alsaDevice[DJI_TEST_WIDGET_SPEAKER_STREAM_PATH_MAX];
+    char wavFilePath[DJI_TEST_WIDGET_SPEAKER_STREAM_PATH_MAX];
+} T_DjiTestWidgetSpeakerStreamConfig;
+
+typedef struct {
+    uint32_t receivedPacketCount;
+    uint32_t decodeErrorCount;
+    uint32_t droppedFrameCount;
+    /*! Times the jitter buffer ran empty while the stream was still being received. */
+    uint32_t underrunCount;
+    /*! Times the sound card ran out of data, each one is an audible gap. */
+    uint32_t deviceUnderrunCount;
+    uint32_t playedPeriodCount;
+    /*! From receipt of a packet to its first sample leaving the speaker, including the sound card delay. */
+    uint64_t latencyAverageUs;
+    uint64_t latencyMaxUs;
+    uint32_t latencyCount;
+    /*! Thread CPU time spent in opus_decode() and in the playback task. */
+    uint64_t decodeCpuTimeUs;
+    uint64_t playbackCpuTimeUs;
+} T_DjiTestWidgetSpeakerStreamStatistics;
+
+/* Exported functions --------------------------------------------------------*/
+T_DjiReturnCode DjiTest_WidgetSpeakerStreamInit(void);
+void DjiTest_WidgetSpeakerStreamGetDefaultConfig(T_DjiTestWidgetSpeakerStreamConfig *config);
+T_DjiReturnCode DjiTest_WidgetSpeakerStreamStart(const T_DjiTestWidgetSpeakerStreamConfig *config);
+T_DjiReturnCode DjiTest_WidgetSpeakerStreamPushData(const uint8_t *data, uint32_t len);
+T_DjiReturnCode DjiTest_WidgetSpeakerStreamFinish(void);
+T_DjiReturnCode DjiTest_WidgetSpeakerStreamWaitIdle(uint32_t timeoutMs);
+T_DjiReturnCode DjiTest_WidgetSpeakerStreamStop(void);
+bool DjiTest_WidgetSpeakerStreamIsActive(void);
+void DjiTest_WidgetSpeakerStreamGetStatistics(T_DjiTestWidgetSpeakerStreamStatistics *statistics);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TEST_WIDGET_SPEAKER_STREAM_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
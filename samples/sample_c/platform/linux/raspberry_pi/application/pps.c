@@ -31,198 +31,432 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <poll.h>
+#include <sys/ioctl.h>
 #include <sys/time.h>
 #include <time.h>
 #include <signal.h>
 #include <errno.h>
 #include <stdint.h>
-#include <time.h>
+#include <linux/gpio.h>
+#include <linux/pps.h>
 #include <pps.h>
 #include <pthread.h>
 #include "dji_logger.h"
 #include "osal/osal.h"
+#include "utils/util_pps_filter.h"
 
 /* Private constants ---------------------------------------------------------*/
 // GPIO pin 26 connected to PPS signal
 #define PPS_GPIO 26
+// Kernel PPS source, e.g. from "dtoverlay=pps-gpio,gpiopin=26" in config.txt
+#define PPS_KERNEL_DEVICE           "/dev/pps0"
+#define PPS_GPIO_CHIP_DEVICE        "/dev/gpiochip0"
+#define PPS_EDGE_TIMEOUT_MS         1500
+#define PPS_CROSS_TIMESTAMP_TRY_NUM 3
+#define PPS_LOG_INTERVAL_EDGE_NUM   10
 
 /* Private types -------------------------------------------------------------*/
+typedef enum {
+    // timestamped by the kernel in the PPS interrupt handler
+    PPS_CAPTURE_KERNEL_PPS = 0,
+    // timestamped by the kernel in the GPIO interrupt handler
+    PPS_CAPTURE_GPIO_CHARDEV,
+    // timestamped in user space when poll() returns
+    PPS_CAPTURE_GPIO_SYSFS,
+} E_PpsCaptureBackend;
 
 /* Private values -------------------------------------------------------------*/
-static uint32_t pps_newest_trigger_time_ms = 0;
-static uint32_t pps_trigger_time_diff_ms = 0;
-static int gpio_fd = 0;
+static const char *pps_capture_backend_name[] = {"kernel pps", "gpio chardev", "gpio sysfs"};
+static E_PpsCaptureBackend pps_capture_backend;
+static clockid_t pps_capture_clock = CLOCK_MONOTONIC;
+static bool pps_capture_clock_known = false;
+static uint32_t pps_last_sequence = 0;
+static uint64_t pps_newest_trigger_time_us = 0;
+static T_UtilPpsFilter pps_filter;
+static pthread_mutex_t pps_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int gpio_fd = -1;
 static pthread_t pps_thread;
 
 /* Private functions declaration ---------------------------------------------*/
 static void *pps_signal_watcher(void *arg);
-static void handle_pps_event();
-static uint32_t get_pps_trigger_time_diff_ms();
+static void handle_pps_event(uint64_t capture_time_ns);
+static int open_kernel_pps(void);
+static int open_gpio_chardev(void);
+static int open_gpio_sysfs(void);
+static void unexport_gpio_sysfs(void);
+static T_DjiReturnCode wait_pps_edge(uint64_t *capture_time_ns);
+static void detect_capture_clock(uint64_t capture_time_ns);
+static uint64_t capture_time_to_local_time_us(uint64_t capture_time_ns);
+static uint64_t get_clock_time_ns(clockid_t clock);
 
 /* Exported functions definition ---------------------------------------------*/
+/**
+ * @brief Start capturing the PPS edges, with the most accurate timestamping available.
+ * @note The kernel PPS device is read with the PPS_FETCH ioctl that time_pps_fetch() of RFC 2783 wraps, which avoids
+ * a dependency on the pps-tools headers. If it is not configured the GPIO character device is used, whose edge events
+ * carry a kernel timestamp too, and the sysfs interface is kept as the last resort.
+ */
 T_DjiReturnCode DjiTestRsp_PpsSignalResponseInit(void) {
+    T_UtilPpsFilterConfig filter_config;
+
+    UtilPpsFilter_GetDefaultConfig(&filter_config);
+    UtilPpsFilter_Init(&pps_filter, &filter_config);
+
+    pps_capture_backend = PPS_CAPTURE_KERNEL_PPS;
+    gpio_fd = open_kernel_pps();
+    if (gpio_fd < 0) {
+        pps_capture_backend = PPS_CAPTURE_GPIO_CHARDEV;
+        gpio_fd = open_gpio_chardev();
+    }
+    if (gpio_fd < 0) {
+        pps_capture_backend = PPS_CAPTURE_GPIO_SYSFS;
+        gpio_fd = open_gpio_sysfs();
+    }
+    if (gpio_fd < 0) {
+        USER_LOG_ERROR("Failed to open PPS signal on GPIO %d", PPS_GPIO);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    if (pthread_create(&pps_thread, NULL, pps_signal_watcher, NULL) != 0) {
+        USER_LOG_ERROR("Failed to create PPS watcher thread");
+        close(gpio_fd);
+        gpio_fd = -1;
+        if (pps_capture_backend == PPS_CAPTURE_GPIO_SYSFS) {
+            unexport_gpio_sysfs();
+        }
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiTestRsp_GetNewestPpsTriggerLocalTimeUs(uint64_t *localTimeUs) {
+    if (localTimeUs == NULL) {
+        USER_LOG_ERROR("input pointer is null.");
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    pthread_mutex_lock(&pps_mutex);
+    *localTimeUs = pps_newest_trigger_time_us;
+    pthread_mutex_unlock(&pps_mutex);
+
+    if (*localTimeUs == 0) {
+        USER_LOG_WARN("pps have not been triggered.");
+        return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/* Private functions definition-----------------------------------------------*/
+static void handle_pps_event(uint64_t capture_time_ns) {
+    E_UtilPpsFilterEdgeState state;
+    T_UtilPpsFilterEstimate estimate;
+    T_UtilPpsFilterStatistics statistics;
+    uint64_t local_time_us;
+
+    if (!pps_capture_clock_known) {
+        detect_capture_clock(capture_time_ns);
+    }
+
+    local_time_us = capture_time_to_local_time_us(capture_time_ns);
+    UtilPpsFilter_AddEdge(&pps_filter, local_time_us, &state);
+    if (state == UTIL_PPS_FILTER_EDGE_IGNORED ||
+        UtilPpsFilter_GetEstimate(&pps_filter, &estimate) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return;
+    }
+
+    pthread_mutex_lock(&pps_mutex);
+    pps_newest_trigger_time_us = estimate.edgeTimeUs;
+    pthread_mutex_unlock(&pps_mutex);
+
+    UtilPpsFilter_GetStatistics(&pps_filter, &statistics);
+    if (state == UTIL_PPS_FILTER_EDGE_OUTLIER) {
+        USER_LOG_DEBUG("PPS edge rejected, %lld us from the fitted time.",
+                       (long long) (local_time_us - estimate.edgeTimeUs));
+    } else if (state == UTIL_PPS_FILTER_EDGE_RESET) {
+        USER_LOG_WARN("PPS edges lost their fit, restart the filter.");
+    }
+
+    if (statistics.edgeCount % PPS_LOG_INTERVAL_EDGE_NUM == 1) {
+        USER_LOG_INFO("PPS triggered (%s). Time: %llu us | Drift: %.2f ppm | Jitter: %.1f us | "
+                      "Outlier: %u | Missed: %u", pps_capture_backend_name[pps_capture_backend],
+                      (unsigned long long) estimate.edgeTimeUs, estimate.driftPpm, estimate.residualRmsUs,
+                      statistics.outlierCount, statistics.missedPulseCount);
+    }
+}
+
+static int open_kernel_pps(void) {
+    struct pps_kparams params;
+    int mode;
+    int fd;
+
+    fd = open(PPS_KERNEL_DEVICE, O_RDWR);
+    if (fd < 0) {
+        USER_LOG_DEBUG("Kernel PPS device %s is not available: %s", PPS_KERNEL_DEVICE, strerror(errno));
+        return -1;
+    }
+
+    if (ioctl(fd, PPS_GETCAP, &mode) < 0 || !(mode & PPS_CAPTUREASSERT) || !(mode & PPS_CANWAIT)) {
+        USER_LOG_WARN("Kernel PPS device %s can not wait for assert events.", PPS_KERNEL_DEVICE);
+        close(fd);
+        return -1;
+    }
+
+    if (ioctl(fd, PPS_GETPARAMS, &params) == 0) {
+        params.mode |= PPS_CAPTUREASSERT | PPS_TSFMT_TSPEC;
+        if (ioctl(fd, PPS_SETPARAMS, &params) < 0) {
+            USER_LOG_DEBUG("Keep the default kernel PPS parameters: %s", strerror(errno));
+        }
+    }
+
+    // PPS events are stamped with the system time
+    pps_capture_clock = CLOCK_REALTIME;
+    pps_capture_clock_known = true;
+
+    return fd;
+}
+
+static int open_gpio_chardev(void) {
+    struct gpioevent_request request;
+    int chip_fd;
+
+    chip_fd = open(PPS_GPIO_CHIP_DEVICE, O_RDONLY);
+    if (chip_fd < 0) {
+        USER_LOG_DEBUG("GPIO chip %s is not available: %s", PPS_GPIO_CHIP_DEVICE, strerror(errno));
+        return -1;
+    }
+
+    memset(&request, 0, sizeof(request));
+    request.lineoffset = PPS_GPIO;
+    request.handleflags = GPIOHANDLE_REQUEST_INPUT;
+    request.eventflags = GPIOEVENT_REQUEST_RISING_EDGE;
+    strncpy(request.consumer_label, "psdk_pps", sizeof(request.consumer_label) - 1);
+
+    if (ioctl(chip_fd, GPIO_GET_LINEEVENT_IOCTL, &request) < 0) {
+        USER_LOG_WARN("Failed to request edge events of GPIO %d: %s", PPS_GPIO, strerror(errno));
+        close(chip_fd);
+        return -1;
+    }
+    close(chip_fd);
+
+    // the event clock changed from CLOCK_REALTIME to CLOCK_MONOTONIC in Linux 5.7, it is told by the first edge
+    pps_capture_clock_known = false;
+
+    return request.fd;
+}
+
+static int open_gpio_sysfs(void) {
     char buf[128];
     int fd, len;
     int gpio = PPS_GPIO;
 
-    fd = open("/sys/class/gpio/unexport", O_WRONLY);
-    if (fd >= 0) {
-        len = snprintf(buf, sizeof(buf), "%d", gpio);
-        write(fd, buf, len);
-        close(fd);
-    }
+    unexport_gpio_sysfs();
 
     if ((fd = open("/sys/class/gpio/export", O_WRONLY)) < 0) {
         USER_LOG_ERROR("Failed to open export");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        return -1;
     }
 
     len = snprintf(buf, sizeof(buf), "%d", gpio);
     if (write(fd, buf, len) != len) {
         USER_LOG_ERROR("Failed to export GPIO");
         close(fd);
-        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        return -1;
     }
     close(fd);
 
     snprintf(buf, sizeof(buf), "/sys/class/gpio/gpio%d/direction", gpio);
     if ((fd = open(buf, O_WRONLY)) < 0) {
         USER_LOG_ERROR("Failed to open direction");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        return -1;
     }
 
     if (write(fd, "in", 2) != 2) {
         USER_LOG_ERROR("Failed to set direction");
         close(fd);
-        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        return -1;
     }
     close(fd);
 
     snprintf(buf, sizeof(buf), "/sys/class/gpio/gpio%d/edge", gpio);
     if ((fd = open(buf, O_WRONLY)) < 0) {
         USER_LOG_ERROR("Failed to open edge");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        return -1;
     }
 
     if (write(fd, "rising", 6) != 6) {
         USER_LOG_ERROR("Failed to set edge");
         close(fd);
-        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        return -1;
     }
     close(fd);
 
     snprintf(buf, sizeof(buf), "/sys/class/gpio/gpio%d/value", gpio);
-    gpio_fd = open(buf, O_RDONLY | O_NONBLOCK);
-    if(gpio_fd < 0) {
+    fd = open(buf, O_RDONLY | O_NONBLOCK);
+    if (fd < 0) {
         USER_LOG_ERROR("Failed to open value");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        return -1;
     }
 
+    lseek(fd, 0, SEEK_SET);
+    read(fd, buf, 1);
 
-    if (pthread_create(&pps_thread, NULL, pps_signal_watcher, NULL) != 0) {
-        USER_LOG_ERROR("Failed to create PPS watcher thread");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
-    }
+    pps_capture_clock = CLOCK_MONOTONIC;
+    pps_capture_clock_known = true;
 
-    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    return fd;
 }
 
-T_DjiReturnCode DjiTestRsp_GetNewestPpsTriggerLocalTimeUs(uint64_t *localTimeUs) {
-    if (localTimeUs == NULL) {
-        USER_LOG_ERROR("input pointer is null.");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
-    }
-
-    if (pps_newest_trigger_time_ms == 0) {
-        USER_LOG_WARN("pps have not been triggered.");
-        return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
-    }
-    *localTimeUs = (uint64_t)pps_newest_trigger_time_ms * 1000ULL;
-
-    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
-}
-
-/* Private functions definition-----------------------------------------------*/
-static void handle_pps_event() {
-    uint32_t timeNowMs;
-    Osal_GetTimeMs(&timeNowMs);
+static void unexport_gpio_sysfs(void) {
+    char buf[16];
+    int fd, len;
 
-    if (pps_newest_trigger_time_ms != 0) {
-        pps_trigger_time_diff_ms = timeNowMs - pps_newest_trigger_time_ms;
+    fd = open("/sys/class/gpio/unexport", O_WRONLY);
+    if (fd >= 0) {
+        len = snprintf(buf, sizeof(buf), "%d", PPS_GPIO);
+        write(fd, buf, len);
+        close(fd);
     }
-
-    pps_newest_trigger_time_ms = timeNowMs;
 }
 
-static uint32_t get_pps_trigger_time_diff_ms() {
-    return pps_trigger_time_diff_ms;
-}
-
-static void *pps_signal_watcher(void * arg) {
+static T_DjiReturnCode wait_pps_edge(uint64_t *capture_time_ns) {
     struct pollfd pfd;
+    struct pps_fdata fdata;
+    struct gpioevent_data event;
     char buf;
+    int ret;
+
+    if (pps_capture_backend == PPS_CAPTURE_KERNEL_PPS) {
+        memset(&fdata, 0, sizeof(fdata));
+        fdata.timeout.sec = PPS_EDGE_TIMEOUT_MS / 1000;
+        fdata.timeout.nsec = (PPS_EDGE_TIMEOUT_MS % 1000) * 1000000;
+        if (ioctl(gpio_fd, PPS_FETCH, &fdata) < 0) {
+            if (errno == EINTR || errno == ETIMEDOUT) {
+                return DJI_ERROR_SYSTEM_MODULE_CODE_TIMEOUT;
+            }
+            return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        }
+        if (fdata.info.assert_sequence == pps_last_sequence) {
+            return DJI_ERROR_SYSTEM_MODULE_CODE_TIMEOUT;
+        }
+        pps_last_sequence = fdata.info.assert_sequence;
+        *capture_time_ns = (uint64_t) fdata.info.assert_tu.sec * 1000000000ULL + fdata.info.assert_tu.nsec;
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
 
     pfd.fd = gpio_fd;
-    pfd.events = POLLPRI | POLLERR;
+    pfd.events = pps_capture_backend == PPS_CAPTURE_GPIO_CHARDEV ? POLLIN : POLLPRI | POLLERR;
+
+    ret = poll(&pfd, 1, PPS_EDGE_TIMEOUT_MS);
+    if (ret < 0) {
+        return errno == EINTR ? DJI_ERROR_SYSTEM_MODULE_CODE_TIMEOUT : DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+    if (ret == 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_TIMEOUT;
+    }
 
+    if (pps_capture_backend == PPS_CAPTURE_GPIO_CHARDEV) {
+        if (read(gpio_fd, &event, sizeof(event)) != sizeof(event)) {
+            return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+        }
+        *capture_time_ns = event.timestamp;
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    if (!(pfd.revents & POLLPRI)) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_TIMEOUT;
+    }
+    *capture_time_ns = get_clock_time_ns(pps_capture_clock);
     lseek(gpio_fd, 0, SEEK_SET);
-    read(gpio_fd, &buf, 1);
+    if (read(gpio_fd, &buf, 1) != 1) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
 
-    USER_LOG_INFO("Monitoring PPS signal on GPIO %d...\n", PPS_GPIO);
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
 
-    while (true) {
-        int ret = poll(&pfd, 1, 1500);
+static void detect_capture_clock(uint64_t capture_time_ns) {
+    uint64_t monotonic_age_ns = get_clock_time_ns(CLOCK_MONOTONIC) - capture_time_ns;
+    uint64_t realtime_age_ns = get_clock_time_ns(CLOCK_REALTIME) - capture_time_ns;
 
-        if (ret < 0) {
-            if (errno == EINTR) continue;
-            perror("poll failed");
-            break;
-        }
+    // the event has just been read, the clock it was stamped with is the one it is the least behind
+    pps_capture_clock = monotonic_age_ns <= realtime_age_ns ? CLOCK_MONOTONIC : CLOCK_REALTIME;
+    pps_capture_clock_known = true;
+    USER_LOG_INFO("PPS edge events are stamped with %s.",
+                  pps_capture_clock == CLOCK_MONOTONIC ? "CLOCK_MONOTONIC" : "CLOCK_REALTIME");
+}
 
-        if (ret == 0) {
-            USER_LOG_ERROR("PPS signal polling timeout");
-            continue;
+/**
+ * @brief Move a capture clock timestamp onto the OSAL time base used by the time sync.
+ * @note The two clocks are read back to back a few times and the closest pair is kept, so the mapping error stays
+ * well below a microsecond. It is redone for every edge, which also follows any slew or step of the system time.
+ */
+static uint64_t capture_time_to_local_time_us(uint64_t capture_time_ns) {
+    uint64_t before_ns, after_ns, gap_ns;
+    uint64_t best_gap_ns = UINT64_MAX;
+    uint64_t best_capture_ns = 0;
+    uint64_t best_local_us = 0;
+    uint64_t local_us;
+    uint64_t age_us;
+    int i;
+
+    for (i = 0; i < PPS_CROSS_TIMESTAMP_TRY_NUM; i++) {
+        before_ns = get_clock_time_ns(pps_capture_clock);
+        Osal_GetTimeUs(&local_us);
+        after_ns = get_clock_time_ns(pps_capture_clock);
+
+        gap_ns = after_ns - before_ns;
+        if (gap_ns < best_gap_ns) {
+            best_gap_ns = gap_ns;
+            best_capture_ns = before_ns + gap_ns / 2;
+            best_local_us = local_us;
         }
+    }
 
-        if (pfd.revents & POLLPRI) {
-            lseek(gpio_fd, 0, SEEK_SET);
-            if (read(gpio_fd, &buf, 1) != 1) {
-                perror("read failed");
-                continue;
-            }
+    age_us = best_capture_ns > capture_time_ns ? (best_capture_ns - capture_time_ns) / 1000 : 0;
 
-            uint32_t timeNowMs;
-            Osal_GetTimeMs(&timeNowMs);
+    return best_local_us > age_us ? best_local_us - age_us : 0;
+}
 
-            if (pps_newest_trigger_time_ms > 0 && (timeNowMs - pps_newest_trigger_time_ms) < 800) {
-                continue;
-            }
+static uint64_t get_clock_time_ns(clockid_t clock) {
+    struct timespec ts;
 
-            handle_pps_event();
+    clock_gettime(clock, &ts);
 
-            uint32_t diff_ms = get_pps_trigger_time_diff_ms();
-            uint64_t time_us;
-            DjiTestRsp_GetNewestPpsTriggerLocalTimeUs (&time_us);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
 
-            if (time_us > 0) {
-                USER_LOG_INFO("PPS triggered. Interval: %u ms | Time: %llu μs\n",
-                       diff_ms, time_us);
-            } else {
-                USER_LOG_INFO("PPS triggered. (First event)\n");
-            }
+static void *pps_signal_watcher(void * arg) {
+    T_DjiReturnCode returnCode;
+    uint64_t capture_time_ns;
+
+    USER_LOG_INFO("Monitoring PPS signal on GPIO %d with %s...", PPS_GPIO,
+                  pps_capture_backend_name[pps_capture_backend]);
+
+    while (true) {
+        returnCode = wait_pps_edge(&capture_time_ns);
+        if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_TIMEOUT) {
+            USER_LOG_ERROR("PPS signal polling timeout");
+            continue;
+        }
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            USER_LOG_ERROR("PPS signal capture failed: %s", strerror(errno));
+            break;
         }
+
+        handle_pps_event(capture_time_ns);
     }
 
     close(gpio_fd);
+    gpio_fd = -1;
 
-    int fd = open("/sys/class/gpio/unexport", O_WRONLY);
-    if (fd >= 0) {
-        char buf[16];
-        int len = snprintf(buf, sizeof(buf), "%d", PPS_GPIO);
-        write(fd, buf, len);
-        close(fd);
+    if (pps_capture_backend == PPS_CAPTURE_GPIO_SYSFS) {
+        unexport_gpio_sysfs();
     }
 
-    printf("\nExiting PPS monitor\n");
+    USER_LOG_INFO("Exiting PPS monitor");
     return 0;
-}
\ No newline at end of file
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,130 @@
+/**
+ ********************************************************************
+ * @file    fc_record_convert.c
+ * @brief   Command line tool exporting flight data records (.fcr) saved by the flight controller
+ *          subscription recorder to CSV or column files.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include "fc_subscription/test_fc_subscription_recorder.h"
+
+/* Private constants ---------------------------------------------------------*/
+
+/* Private types -------------------------------------------------------------*/
+
+/* Private functions declaration ---------------------------------------------*/
+static void FcRecordConvert_PrintUsage(const char *name);
+static int FcRecordConvert_PrintInfo(const char *recordPath);
+
+/* Private values -------------------------------------------------------------*/
+
+/* Exported functions definition ---------------------------------------------*/
+int main(int argc, char *argv[])
+{
+    E_DjiTestFcRecordExportFormat format;
+    T_DjiTestFcRecordReaderStatistics statistics;
+    T_DjiReturnCode returnCode;
+
+    if (argc == 3 && strcmp(argv[1], "info") == 0) {
+        return FcRecordConvert_PrintInfo(argv[2]);
+    }
+
+    if (argc < 4) {
+        FcRecordConvert_PrintUsage(argv[0]);
+        return 1;
+    }
+
+    if (strcmp(argv[1], "csv") == 0) {
+        format = DJI_TEST_FC_RECORD_EXPORT_FORMAT_CSV;
+    } else if (strcmp(argv[1], "col") == 0) {
+        format = DJI_TEST_FC_RECORD_EXPORT_FORMAT_COLUMNAR;
+    } else {
+        FcRecordConvert_PrintUsage(argv[0]);
+        return 1;
+    }
+
+    returnCode = DjiTest_FcRecordExport((const char *const *) &argv[3], (uint32_t) (argc - 3), argv[2], format,
+                                        &statistics);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        fprintf(stderr, "Export failed, error code: 0x%08llX.\n", (unsigned long long) returnCode);
+        return 1;
+    }
+
+    printf("samples: %" PRIu64 ", blocks: %u, indexed: %s\n", statistics.sampleCount, statistics.blockCount,
+           statistics.indexed ? "yes" : "no");
+    printf("corrupt blocks: %u, skipped bytes: %" PRIu64 "\n", statistics.corruptBlockCount,
+           statistics.skippedBytes);
+
+    return 0;
+}
+
+/* Private functions definition-----------------------------------------------*/
+static void FcRecordConvert_PrintUsage(const char *name)
+{
+    fprintf(stderr, "Usage: %s <csv|col> <output dir> <record.fcr>...\n", name);
+    fprintf(stderr, "       %s info <record.fcr>\n", name);
+}
+
+static int FcRecordConvert_PrintInfo(const char *recordPath)
+{
+    T_DjiTestFcRecordReaderHandle readerHandle;
+    T_DjiTestFcRecordReaderStatistics statistics;
+    T_DjiTestFcRecordTopicInfo topicInfo;
+    T_DjiTestFcRecordSample sample;
+    uint64_t sampleCounts[DJI_TEST_FC_RECORD_TOPIC_MAX] = {0};
+    uint64_t firstTimeUs = 0;
+    uint64_t lastTimeUs = 0;
+    uint16_t topicCount;
+    uint16_t i;
+
+    if (DjiTest_FcRecordReaderOpen(recordPath, &readerHandle) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        fprintf(stderr, "Open %s failed.\n", recordPath);
+        return 1;
+    }
+
+    while (DjiTest_FcRecordReaderNext(readerHandle, &sample) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        if (firstTimeUs == 0) {
+            firstTimeUs = sample.recvTimeUs;
+        }
+        lastTimeUs = sample.recvTimeUs;
+        sampleCounts[sample.topicIndex]++;
+    }
+
+    topicCount = DjiTest_FcRecordReaderGetTopicCount(readerHandle);
+    for (i = 0; i < topicCount; i++) {
+        DjiTest_FcRecordReaderGetTopicInfo(readerHandle, i, &topicInfo);
+        printf("0x%08X %3u Hz %3u bytes %10" PRIu64 " samples  %s\n", topicInfo.topic, topicInfo.frequency,
+               topicInfo.dataSize, sampleCounts[i], topicInfo.layout);
+    }
+
+    DjiTest_FcRecordReaderGetStatistics(readerHandle, &statistics);
+    printf("duration: %.3f s, samples: %" PRIu64 ", blocks: %u, corrupt blocks: %u, indexed: %s\n",
+           (double) (lastTimeUs - firstTimeUs) / 1000000.0, statistics.sampleCount, statistics.blockCount,
+           statistics.corruptBlockCount, statistics.indexed ? "yes" : "no");
+    DjiTest_FcRecordReaderClose(readerHandle);
+
+    return 0;
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
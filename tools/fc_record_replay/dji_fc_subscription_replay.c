@@ -0,0 +1,389 @@
+/**
+ ********************************************************************
+ * @file    dji_fc_subscription_replay.c
+ * @brief   Stand-in of the DjiFcSubscription API fed from flight data records. Samples are delivered
+ *          to the subscribed callbacks in recording order on the calling thread, so offline tests replaying the
+ *          same record always see the same sequence.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "dji_fc_subscription_replay.h"
+#include "fc_subscription/test_fc_subscription_recorder.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define DJI_FC_SUBSCRIPTION_REPLAY_TOPIC_MAX        64
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    E_DjiFcSubscriptionTopic topic;
+    E_DjiDataSubscriptionTopicFreq frequency;
+    DjiReceiveDataOfTopicCallback callback;
+    uint64_t nextDueUs;
+    bool hasLatest;
+    uint16_t latestSize;
+    T_DjiDataTimestamp latestTimestamp;
+    uint8_t latest[DJI_TEST_FC_RECORD_DATA_MAX];
+} T_DjiFcSubscriptionReplayTopic;
+
+typedef struct {
+    bool inited;
+    const char *const *recordPaths;
+    uint32_t recordCount;
+    uint32_t recordIndex;
+    T_DjiTestFcRecordReaderHandle reader;
+    bool pending;
+    T_DjiTestFcRecordSample pendingSample;
+    uint64_t timeUs;
+    T_DjiFcSubscriptionReplayTopic topics[DJI_FC_SUBSCRIPTION_REPLAY_TOPIC_MAX];
+    uint32_t topicCount;
+    T_DjiFcSubscriptionReplayStatistics statistics;
+} T_DjiFcSubscriptionReplay;
+
+/* Private functions declaration ---------------------------------------------*/
+static T_DjiFcSubscriptionReplayTopic *DjiFcSubscriptionReplay_FindTopic(E_DjiFcSubscriptionTopic topic);
+static T_DjiReturnCode DjiFcSubscriptionReplay_Peek(T_DjiTestFcRecordSample **sample);
+static void DjiFcSubscriptionReplay_Deliver(const T_DjiTestFcRecordSample *sample);
+
+/* Private values -------------------------------------------------------------*/
+static T_DjiFcSubscriptionReplay s_replay = {0};
+/* Recursive, so callbacks may use the subscription API while a sample is delivered. */
+static pthread_mutex_t s_replayMutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+/* Exported functions definition ---------------------------------------------*/
+T_DjiReturnCode DjiFcSubscription_Init(void)
+{
+    pthread_mutex_lock(&s_replayMutex);
+    s_replay.inited = true;
+    pthread_mutex_unlock(&s_replayMutex);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiFcSubscription_DeInit(void)
+{
+    pthread_mutex_lock(&s_replayMutex);
+    s_replay.inited = false;
+    s_replay.topicCount = 0;
+    pthread_mutex_unlock(&s_replayMutex);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiFcSubscription_SubscribeTopic(E_DjiFcSubscriptionTopic topic,
+                                                 E_DjiDataSubscriptionTopicFreq frequency,
+                                                 DjiReceiveDataOfTopicCallback callback)
+{
+    T_DjiFcSubscriptionReplayTopic *replayTopic;
+    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+
+    pthread_mutex_lock(&s_replayMutex);
+    if (!s_replay.inited) {
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE;
+    } else if (frequency == 0) {
+        returnCode = DJI_ERROR_SUBSCRIPTION_MODULE_CODE_INVALID_TOPIC_FREQ;
+    } else if (DjiFcSubscriptionReplay_FindTopic(topic) != NULL) {
+        returnCode = DJI_ERROR_SUBSCRIPTION_MODULE_CODE_TOPIC_DUPLICATE;
+    } else if (s_replay.topicCount >= DJI_FC_SUBSCRIPTION_REPLAY_TOPIC_MAX) {
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
+    } else {
+        replayTopic = &s_replay.topics[s_replay.topicCount++];
+        memset(replayTopic, 0, sizeof(T_DjiFcSubscriptionReplayTopic));
+        replayTopic->topic = topic;
+        replayTopic->frequency = frequency;
+        replayTopic->callback = callback;
+    }
+    pthread_mutex_unlock(&s_replayMutex);
+
+    return returnCode;
+}
+
+T_DjiReturnCode DjiFcSubscription_UnSubscribeTopic(E_DjiFcSubscriptionTopic topic)
+{
+    T_DjiFcSubscriptionReplayTopic *replayTopic;
+    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+
+    pthread_mutex_lock(&s_replayMutex);
+    replayTopic = DjiFcSubscriptionReplay_FindTopic(topic);
+    if (replayTopic == NULL) {
+        returnCode = DJI_ERROR_SUBSCRIPTION_MODULE_CODE_TOPIC_NOT_SUBSCRIBED;
+    } else {
+        *replayTopic = s_replay.topics[--s_replay.topicCount];
+    }
+    pthread_mutex_unlock(&s_replayMutex);
+
+    return returnCode;
+}
+
+T_DjiReturnCode DjiFcSubscription_GetLatestValueOfTopic(E_DjiFcSubscriptionTopic topic,
+                                                        uint8_t *data, uint16_t dataSizeOfTopic,
+                                                        T_DjiDataTimestamp *timestamp)
+{
+    T_DjiFcSubscriptionReplayTopic *replayTopic;
+    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+
+    pthread_mutex_lock(&s_replayMutex);
+    replayTopic = DjiFcSubscriptionReplay_FindTopic(topic);
+    if (replayTopic == NULL || !replayTopic->hasLatest) {
+        returnCode = DJI_ERROR_SUBSCRIPTION_MODULE_CODE_TOPIC_NOT_SUBSCRIBED;
+    } else if (data == NULL || dataSizeOfTopic != replayTopic->latestSize) {
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    } else {
+        memcpy(data, replayTopic->latest, replayTopic->latestSize);
+        if (timestamp != NULL) {
+            *timestamp = replayTopic->latestTimestamp;
+        }
+    }
+    pthread_mutex_unlock(&s_replayMutex);
+
+    return returnCode;
+}
+
+/**
+ * @brief Replay the segments of a record in order. The paths must stay valid until the replay is closed.
+ */
+T_DjiReturnCode DjiFcSubscriptionReplay_Open(const char *const *recordPaths, uint32_t recordCount)
+{
+    T_DjiTestFcRecordReaderHandle reader;
+    T_DjiReturnCode returnCode;
+
+    if (recordPaths == NULL || recordCount == 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    returnCode = DjiTest_FcRecordReaderOpen(recordPaths[0], &reader);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return returnCode;
+    }
+
+    pthread_mutex_lock(&s_replayMutex);
+    if (s_replay.reader != NULL) {
+        pthread_mutex_unlock(&s_replayMutex);
+        DjiTest_FcRecordReaderClose(reader);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+    }
+
+    s_replay.reader = reader;
+    s_replay.recordPaths = recordPaths;
+    s_replay.recordCount = recordCount;
+    s_replay.recordIndex = 0;
+    s_replay.pending = false;
+    s_replay.timeUs = 0;
+    memset(&s_replay.statistics, 0, sizeof(s_replay.statistics));
+    pthread_mutex_unlock(&s_replayMutex);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiFcSubscriptionReplay_Close(void)
+{
+    pthread_mutex_lock(&s_replayMutex);
+    if (s_replay.reader != NULL) {
+        DjiTest_FcRecordReaderClose(s_replay.reader);
+        s_replay.reader = NULL;
+    }
+    s_replay.pending = false;
+    pthread_mutex_unlock(&s_replayMutex);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Deliver the next recorded sample.
+ * @return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND at the end of the record.
+ */
+T_DjiReturnCode DjiFcSubscriptionReplay_Step(uint64_t *recvTimeUs)
+{
+    T_DjiTestFcRecordSample *sample;
+    T_DjiReturnCode returnCode;
+
+    pthread_mutex_lock(&s_replayMutex);
+    returnCode = DjiFcSubscriptionReplay_Peek(&sample);
+    if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        s_replay.pending = false;
+        s_replay.timeUs = sample->recvTimeUs;
+        DjiFcSubscriptionReplay_Deliver(sample);
+        if (recvTimeUs != NULL) {
+            *recvTimeUs = sample->recvTimeUs;
+        }
+    }
+    pthread_mutex_unlock(&s_replayMutex);
+
+    return returnCode;
+}
+
+/**
+ * @brief Get the receive time of the next sample without delivering it, so a caller can pace the replay.
+ * @return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND at the end of the record.
+ */
+T_DjiReturnCode DjiFcSubscriptionReplay_GetNextTimeUs(uint64_t *recvTimeUs)
+{
+    T_DjiTestFcRecordSample *sample;
+    T_DjiReturnCode returnCode;
+
+    pthread_mutex_lock(&s_replayMutex);
+    returnCode = DjiFcSubscriptionReplay_Peek(&sample);
+    if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        *recvTimeUs = sample->recvTimeUs;
+    }
+    pthread_mutex_unlock(&s_replayMutex);
+
+    return returnCode;
+}
+
+/**
+ * @brief Deliver all samples received up to timeUs, the replay time then stands at timeUs.
+ */
+T_DjiReturnCode DjiFcSubscriptionReplay_RunUntil(uint64_t timeUs)
+{
+    uint64_t nextTimeUs;
+    T_DjiReturnCode returnCode;
+
+    while ((returnCode = DjiFcSubscriptionReplay_GetNextTimeUs(&nextTimeUs)) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS &&
+           nextTimeUs <= timeUs) {
+        DjiFcSubscriptionReplay_Step(NULL);
+    }
+    s_replay.timeUs = timeUs;
+
+    return returnCode;
+}
+
+T_DjiReturnCode DjiFcSubscriptionReplay_Run(void)
+{
+    T_DjiReturnCode returnCode;
+
+    while ((returnCode = DjiFcSubscriptionReplay_Step(NULL)) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+    }
+
+    return returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND ? DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS : returnCode;
+}
+
+/**
+ * @brief Get the replay time, the receive time of the last delivered sample in the recording clock.
+ */
+uint64_t DjiFcSubscriptionReplay_GetTimeUs(void)
+{
+    return s_replay.timeUs;
+}
+
+void DjiFcSubscriptionReplay_GetStatistics(T_DjiFcSubscriptionReplayStatistics *statistics)
+{
+    if (statistics != NULL) {
+        pthread_mutex_lock(&s_replayMutex);
+        *statistics = s_replay.statistics;
+        pthread_mutex_unlock(&s_replayMutex);
+    }
+}
+
+/* Private functions definition-----------------------------------------------*/
+static T_DjiFcSubscriptionReplayTopic *DjiFcSubscriptionReplay_FindTopic(E_DjiFcSubscriptionTopic topic)
+{
+    uint32_t i;
+
+    for (i = 0; i < s_replay.topicCount; i++) {
+        if (s_replay.topics[i].topic == topic) {
+            return &s_replay.topics[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Read the next sample without delivering it, moving on to the next segment at the end of one.
+ */
+static T_DjiReturnCode DjiFcSubscriptionReplay_Peek(T_DjiTestFcRecordSample **sample)
+{
+    T_DjiReturnCode returnCode;
+
+    if (s_replay.reader == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+    }
+
+    while (!s_replay.pending) {
+        returnCode = DjiTest_FcRecordReaderNext(s_replay.reader, &s_replay.pendingSample);
+        if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            s_replay.pending = true;
+            break;
+        }
+
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND ||
+            s_replay.recordIndex + 1 >= s_replay.recordCount) {
+            return returnCode;
+        }
+
+        DjiTest_FcRecordReaderClose(s_replay.reader);
+        s_replay.reader = NULL;
+        s_replay.recordIndex++;
+        returnCode = DjiTest_FcRecordReaderOpen(s_replay.recordPaths[s_replay.recordIndex], &s_replay.reader);
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            s_replay.reader = NULL;
+            return returnCode;
+        }
+    }
+
+    *sample = &s_replay.pendingSample;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Hand a sample to the subscriber of its topic, samples are dropped down to the subscribed frequency.
+ * @note Due times advance by whole periods so the jitter of the recording does not bias the delivered rate,
+ * a sample is accepted up to a quarter period early. After a gap the schedule restarts at the sample.
+ */
+static void DjiFcSubscriptionReplay_Deliver(const T_DjiTestFcRecordSample *sample)
+{
+    T_DjiFcSubscriptionReplayTopic *replayTopic;
+    uint64_t periodUs;
+
+    s_replay.statistics.sampleCount++;
+    replayTopic = DjiFcSubscriptionReplay_FindTopic(sample->topic);
+    if (replayTopic == NULL) {
+        return;
+    }
+
+    periodUs = 1000000 / replayTopic->frequency;
+    if (sample->recvTimeUs + periodUs / 4 < replayTopic->nextDueUs) {
+        s_replay.statistics.decimatedCount++;
+        return;
+    }
+    replayTopic->nextDueUs += periodUs;
+    if (replayTopic->nextDueUs + periodUs / 4 <= sample->recvTimeUs) {
+        replayTopic->nextDueUs = sample->recvTimeUs + periodUs;
+    }
+
+    memcpy(replayTopic->latest, sample->data, sample->dataSize);
+    replayTopic->latestSize = sample->dataSize;
+    replayTopic->latestTimestamp = sample->timestamp;
+    replayTopic->hasLatest = true;
+
+    s_replay.statistics.deliveredCount++;
+    if (replayTopic->callback != NULL &&
+        replayTopic->callback(sample->data, sample->dataSize, &sample->timestamp) !=
+        DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        s_replay.statistics.callbackFailCount++;
+    }
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,64 @@
+/**
+ ********************************************************************
+ * @file    dji_fc_subscription_replay.h
+ * @brief   This is the header file for "dji_fc_subscription_replay.c", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef DJI_FC_SUBSCRIPTION_REPLAY_H
+#define DJI_FC_SUBSCRIPTION_REPLAY_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_typedef.h"
+#include "dji_fc_subscription.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+    uint64_t sampleCount;
+    uint64_t deliveredCount;
+    /*! Samples of subscribed topics not delivered because the subscription frequency is lower. */
+    uint64_t decimatedCount;
+    uint32_t callbackFailCount;
+} T_DjiFcSubscriptionReplayStatistics;
+
+/* Exported functions --------------------------------------------------------*/
+T_DjiReturnCode DjiFcSubscriptionReplay_Open(const char *const *recordPaths, uint32_t recordCount);
+T_DjiReturnCode DjiFcSubscriptionReplay_Close(void);
+T_DjiReturnCode DjiFcSubscriptionReplay_Step(uint64_t *recvTimeUs);
+T_DjiReturnCode DjiFcSubscriptionReplay_GetNextTimeUs(uint64_t *recvTimeUs);
+T_DjiReturnCode DjiFcSubscriptionReplay_RunUntil(uint64_t timeUs);
+T_DjiReturnCode DjiFcSubscriptionReplay_Run(void);
+uint64_t DjiFcSubscriptionReplay_GetTimeUs(void);
+void DjiFcSubscriptionReplay_GetStatistics(T_DjiFcSubscriptionReplayStatistics *statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DJI_FC_SUBSCRIPTION_REPLAY_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
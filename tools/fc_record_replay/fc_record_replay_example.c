@@ -0,0 +1,118 @@
+/**
+ ********************************************************************
+ * @file    fc_record_replay_example.c
+ * @brief   Example of an offline test driven by the replay stand-in of the DjiFcSubscription API. It
+ *          replays a record into attitude and velocity callbacks and prints a digest of what they received, so
+ *          runs over the same record can be compared.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <inttypes.h>
+#include "dji_fc_subscription_replay.h"
+#include "utils/util_crc.h"
+
+/* Private constants ---------------------------------------------------------*/
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    uint32_t count;
+    uint32_t digest;
+} T_FcRecordReplayExampleTopic;
+
+/* Private functions declaration ---------------------------------------------*/
+static T_DjiReturnCode FcRecordReplayExample_QuaternionCallback(const uint8_t *data, uint16_t dataSize,
+                                                                const T_DjiDataTimestamp *timestamp);
+static T_DjiReturnCode FcRecordReplayExample_VelocityCallback(const uint8_t *data, uint16_t dataSize,
+                                                              const T_DjiDataTimestamp *timestamp);
+
+/* Private values -------------------------------------------------------------*/
+static T_FcRecordReplayExampleTopic s_quaternion = {0};
+static T_FcRecordReplayExampleTopic s_velocity = {0};
+
+/* Exported functions definition ---------------------------------------------*/
+int main(int argc, char *argv[])
+{
+    T_DjiFcSubscriptionReplayStatistics statistics;
+    T_DjiFcSubscriptionVelocity velocity;
+    T_DjiDataTimestamp timestamp;
+    T_DjiReturnCode returnCode;
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <record.fcr>...\n", argv[0]);
+        return 1;
+    }
+
+    returnCode = DjiFcSubscriptionReplay_Open((const char *const *) &argv[1], (uint32_t) (argc - 1));
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        fprintf(stderr, "Open record failed, error code: 0x%08llX.\n", (unsigned long long) returnCode);
+        return 1;
+    }
+
+    DjiFcSubscription_Init();
+    DjiFcSubscription_SubscribeTopic(DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION, DJI_DATA_SUBSCRIPTION_TOPIC_50_HZ,
+                                     FcRecordReplayExample_QuaternionCallback);
+    DjiFcSubscription_SubscribeTopic(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY, DJI_DATA_SUBSCRIPTION_TOPIC_10_HZ,
+                                     FcRecordReplayExample_VelocityCallback);
+
+    returnCode = DjiFcSubscriptionReplay_Run();
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        fprintf(stderr, "Replay failed, error code: 0x%08llX.\n", (unsigned long long) returnCode);
+    }
+
+    if (DjiFcSubscription_GetLatestValueOfTopic(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY, (uint8_t *) &velocity,
+                                                sizeof(velocity), &timestamp) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        printf("last velocity: %f %f %f at %u ms\n", velocity.data.x, velocity.data.y, velocity.data.z,
+               timestamp.millisecond);
+    }
+
+    DjiFcSubscriptionReplay_GetStatistics(&statistics);
+    printf("quaternion: %u samples, digest %08X\n", s_quaternion.count, s_quaternion.digest);
+    printf("velocity: %u samples, digest %08X\n", s_velocity.count, s_velocity.digest);
+    printf("replayed: %" PRIu64 ", delivered: %" PRIu64 ", decimated: %" PRIu64 "\n", statistics.sampleCount,
+           statistics.deliveredCount, statistics.decimatedCount);
+
+    DjiFcSubscription_DeInit();
+    DjiFcSubscriptionReplay_Close();
+
+    return returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS ? 0 : 1;
+}
+
+/* Private functions definition-----------------------------------------------*/
+static T_DjiReturnCode FcRecordReplayExample_QuaternionCallback(const uint8_t *data, uint16_t dataSize,
+                                                                const T_DjiDataTimestamp *timestamp)
+{
+    s_quaternion.count++;
+    s_quaternion.digest = UtilCrc_Crc32(s_quaternion.digest, data, dataSize);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+static T_DjiReturnCode FcRecordReplayExample_VelocityCallback(const uint8_t *data, uint16_t dataSize,
+                                                              const T_DjiDataTimestamp *timestamp)
+{
+    s_velocity.count++;
+    s_velocity.digest = UtilCrc_Crc32(s_velocity.digest, data, dataSize);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,133 @@
+/**
+ ********************************************************************
+ * @file    module_test.c
+ * @brief   Checks and timing helpers shared by the module sample tests and benchmarks.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "module_test.h"
+#include <time.h>
+#include "dji_platform.h"
+#include "osal/osal.h"
+
+/* Private constants ---------------------------------------------------------*/
+
+/* Private types -------------------------------------------------------------*/
+
+/* Private values -------------------------------------------------------------*/
+static uint32_t s_failCount = 0;
+
+/* Private functions declaration ---------------------------------------------*/
+
+/* Exported functions definition ---------------------------------------------*/
+/**
+ * @brief Register the Linux OSAL, which is all the module samples need from the PSDK core to run on a host.
+ * @return Execution result.
+ */
+T_DjiReturnCode ModuleTest_Init(void)
+{
+    T_DjiOsalHandler osalHandler = {
+        .TaskCreate = Osal_TaskCreate,
+        .TaskDestroy = Osal_TaskDestroy,
+        .TaskSleepMs = Osal_TaskSleepMs,
+        .MutexCreate = Osal_MutexCreate,
+        .MutexDestroy = Osal_MutexDestroy,
+        .MutexLock = Osal_MutexLock,
+        .MutexUnlock = Osal_MutexUnlock,
+        .SemaphoreCreate = Osal_SemaphoreCreate,
+        .SemaphoreDestroy = Osal_SemaphoreDestroy,
+        .SemaphoreWait = Osal_SemaphoreWait,
+        .SemaphoreTimedWait = Osal_SemaphoreTimedWait,
+        .SemaphorePost = Osal_SemaphorePost,
+        .Malloc = Osal_Malloc,
+        .Free = Osal_Free,
+        .GetRandomNum = Osal_GetRandomNum,
+        .GetTimeMs = Osal_GetTimeMs,
+        .GetTimeUs = Osal_GetTimeUs,
+    };
+
+    return DjiPlatform_RegOsalHandler(&osalHandler);
+}
+
+/**
+ * @brief Print the test result.
+ * @param testName Name of the test.
+ * @return Process exit code, 0 when every check passed.
+ */
+int ModuleTest_Finish(const char *testName)
+{
+    if (s_failCount != 0) {
+        printf("%s: %u check(s) failed\r\n", testName, s_failCount);
+        return 1;
+    }
+
+    printf("%s: passed\r\n", testName);
+    return 0;
+}
+
+void ModuleTest_Fail(const char *file, int line, const char *cond)
+{
+    printf("%s:%d: check failed: %s\r\n", file, line, cond);
+    __atomic_add_fetch(&s_failCount, 1, __ATOMIC_RELAXED);
+}
+
+uint32_t ModuleTest_GetFailCount(void)
+{
+    return __atomic_load_n(&s_failCount, __ATOMIC_RELAXED);
+}
+
+uint64_t ModuleTest_GetTimeUs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000000 + (uint64_t) now.tv_nsec / 1000;
+}
+
+/**
+ * @brief Get the CPU time consumed by the whole process, used for CPU load figures of benchmarks.
+ * @return CPU time in microseconds.
+ */
+uint64_t ModuleTest_GetCpuTimeUs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+
+    return (uint64_t) now.tv_sec * 1000000 + (uint64_t) now.tv_nsec / 1000;
+}
+
+/**
+ * @brief Print one benchmark figure in a fixed format, so results of different runs can be compared with diff.
+ * @param name Name of the figure.
+ * @param value Value of the figure.
+ * @param unit Unit of the figure.
+ * @return None.
+ */
+void ModuleTest_Report(const char *name, double value, const char *unit)
+{
+    printf("  %-40s %12.3f %s\r\n", name, value, unit);
+}
+
+/* Private functions definition-----------------------------------------------*/
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,64 @@
+/**
+ ********************************************************************
+ * @file    module_test.h
+ * @brief   This is the header file for "module_test.c", defining the checks and timing helpers shared by the
+ *          module sample tests and benchmarks.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef MODULE_TEST_H
+#define MODULE_TEST_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdint.h>
+#include "dji_typedef.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+/* Exported macros -----------------------------------------------------------*/
+#define MODULE_TEST_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            ModuleTest_Fail(__FILE__, __LINE__, #cond); \
+        } \
+    } while (0)
+
+/* Exported types ------------------------------------------------------------*/
+
+/* Exported functions --------------------------------------------------------*/
+T_DjiReturnCode ModuleTest_Init(void);
+int ModuleTest_Finish(const char *testName);
+void ModuleTest_Fail(const char *file, int line, const char *cond);
+uint32_t ModuleTest_GetFailCount(void);
+uint64_t ModuleTest_GetTimeUs(void);
+uint64_t ModuleTest_GetCpuTimeUs(void);
+void ModuleTest_Report(const char *name, double value, const char *unit);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODULE_TEST_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
@@ -0,0 +1,59 @@
+/**
+ ********************************************************************
+ * @file    opus.h
+ * @brief   Decoder part of the libopus API, for module tests built on hosts without libopus. The test linking it
+ * defines the functions, see test_widget_speaker_stream.c.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef MODULE_TEST_STUB_OPUS_H
+#define MODULE_TEST_STUB_OPUS_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+#define OPUS_OK                 0
+#define OPUS_BAD_ARG            -1
+#define OPUS_INVALID_PACKET     -4
+
+/* Exported types ------------------------------------------------------------*/
+typedef int32_t opus_int32;
+typedef int16_t opus_int16;
+typedef struct OpusDecoder OpusDecoder;
+
+/* Exported functions --------------------------------------------------------*/
+OpusDecoder *opus_decoder_create(opus_int32 Fs, int channels, int *error);
+int opus_decode(OpusDecoder *st, const unsigned char *data, opus_int32 len, opus_int16 *pcm, int frame_size,
+                int decode_fec);
+void opus_decoder_destroy(OpusDecoder *st);
+const char *opus_strerror(int error);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODULE_TEST_STUB_OPUS_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
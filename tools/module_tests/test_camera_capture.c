@@ -0,0 +1,277 @@
+/**
+ ********************************************************************
+ * @file    test_camera_capture.c
+ * @brief   Test and benchmark of the camera capture file backend, reporting the latency from capture to the
+ *          first byte sent through the Raspberry Pi camera send path.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+#include "module_test.h"
+#include "utils/util_misc.h"
+#include "utils/util_nal_splitter.h"
+#include "camera_emu/dji_video_stream_sender.h"
+#include "camera_emu/dji_camera_capture/dji_camera_capture_core.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define TEST_CAPTURE_REPLAY_FILE                "test_camera_capture.h264"
+#define TEST_CAPTURE_FRAME_RATE                 25
+#define TEST_CAPTURE_FRAME_SIZE                 10000
+#define TEST_CAPTURE_FRAME_COUNT                25
+#define TEST_CAPTURE_RUN_TIME_MS                1500
+#define TEST_CAPTURE_READ_TIMEOUT_MS            100
+#define TEST_CAPTURE_SPLITTER_BUFFER_SIZE       (1024 * 1024)
+#define TEST_CAPTURE_READ_RECORD_MAX            4096
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    uint64_t streamEnd;
+    uint64_t timeUs;
+} T_TestCaptureReadRecord;
+
+/* Private values -------------------------------------------------------------*/
+static T_TestCaptureReadRecord s_readRecord[TEST_CAPTURE_READ_RECORD_MAX];
+static uint32_t s_readRecordCount = 0;
+static uint64_t s_nalStreamOffset = 0;
+static uint64_t s_firstSendTimeUs = 0;
+static uint32_t s_nalCount = 0;
+static uint64_t s_latencySumUs = 0;
+static uint64_t s_latencyMaxUs = 0;
+static uint64_t s_latencyMinUs = UINT64_MAX;
+static T_DjiVideoStreamSender s_sender;
+static uint8_t s_senderArena[DJI_VIDEO_STREAM_SENDER_ARENA_SIZE];
+
+/* Private functions declaration ---------------------------------------------*/
+static bool DjiTest_CaptureMakeFile(const char *path);
+static T_DjiReturnCode DjiTest_CaptureStubSend(const uint8_t *data, uint32_t len);
+static void DjiTest_CaptureSendNal(const uint8_t *nalData, uint32_t nalLen, void *userData);
+static void DjiTest_CaptureTestOpen(void);
+static void DjiTest_CaptureBenchmark(void);
+
+/* Exported functions definition ---------------------------------------------*/
+int main(void)
+{
+    if (ModuleTest_Init() != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        printf("register osal handler failed\r\n");
+        return 1;
+    }
+
+    MODULE_TEST_CHECK(DjiTest_CaptureMakeFile(TEST_CAPTURE_REPLAY_FILE));
+    DjiTest_CaptureTestOpen();
+    DjiTest_CaptureBenchmark();
+    remove(TEST_CAPTURE_REPLAY_FILE);
+
+    return ModuleTest_Finish("test_camera_capture");
+}
+
+/* Private functions definition-----------------------------------------------*/
+/**
+ * @brief Write one second of stream, one NAL unit per frame at the average frame size of the configured bit rate.
+ */
+static bool DjiTest_CaptureMakeFile(const char *path)
+{
+    uint8_t frame[TEST_CAPTURE_FRAME_SIZE];
+    FILE *file;
+    uint32_t i;
+    uint32_t j;
+
+    file = fopen(path, "wb");
+    if (file == NULL) {
+        return false;
+    }
+
+    for (i = 0; i < TEST_CAPTURE_FRAME_COUNT; i++) {
+        frame[0] = 0x00;
+        frame[1] = 0x00;
+        frame[2] = 0x00;
+        frame[3] = 0x01;
+        frame[4] = i == 0 ? 0x65 : 0x41;
+        for (j = 5; j < sizeof(frame); j++) {
+            frame[j] = (uint8_t) (1 + (i * 131 + j * 7) % 255);
+        }
+        if (fwrite(frame, 1, sizeof(frame), file) != sizeof(frame)) {
+            fclose(file);
+            return false;
+        }
+    }
+
+    return fclose(file) == 0;
+}
+
+static T_DjiReturnCode DjiTest_CaptureStubSend(const uint8_t *data, uint32_t len)
+{
+    USER_UTIL_UNUSED(data);
+    USER_UTIL_UNUSED(len);
+
+    if (s_firstSendTimeUs == 0) {
+        s_firstSendTimeUs = ModuleTest_GetTimeUs();
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Send a NAL unit and take the time from the read which returned its first byte to its first send call.
+ */
+static void DjiTest_CaptureSendNal(const uint8_t *nalData, uint32_t nalLen, void *userData)
+{
+    const T_DjiVideoStreamSlice frameSlices[] = {
+        {nalData, nalLen},
+    };
+    uint64_t captureTimeUs = 0;
+    uint64_t latencyUs;
+    uint32_t i;
+
+    USER_UTIL_UNUSED(userData);
+
+    for (i = 0; i < s_readRecordCount; i++) {
+        if (s_readRecord[i].streamEnd > s_nalStreamOffset) {
+            captureTimeUs = s_readRecord[i].timeUs;
+            break;
+        }
+    }
+    s_nalStreamOffset += nalLen;
+
+    s_firstSendTimeUs = 0;
+    MODULE_TEST_CHECK(DjiVideoStreamSender_SendSlices(&s_sender, frameSlices, 1) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    if (captureTimeUs == 0 || s_firstSendTimeUs < captureTimeUs) {
+        return;
+    }
+
+    latencyUs = s_firstSendTimeUs - captureTimeUs;
+    s_latencySumUs += latencyUs;
+    s_latencyMaxUs = USER_UTIL_MAX(s_latencyMaxUs, latencyUs);
+    s_latencyMinUs = USER_UTIL_MIN(s_latencyMinUs, latencyUs);
+    s_nalCount++;
+}
+
+static void DjiTest_CaptureTestOpen(void)
+{
+    T_DjiCameraCaptureConfig config;
+    T_DjiCameraCaptureHandle capture = NULL;
+
+    DjiCameraCapture_GetDefaultConfig(&config);
+    strncpy(config.replayFilePath, "test_camera_capture_missing.h264", sizeof(config.replayFilePath) - 1);
+    MODULE_TEST_CHECK(DjiCameraCapture_Open(DJI_CAMERA_CAPTURE_TYPE_FILE, &config, &capture) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND);
+
+    strncpy(config.replayFilePath, TEST_CAPTURE_REPLAY_FILE, sizeof(config.replayFilePath) - 1);
+    MODULE_TEST_CHECK(DjiCameraCapture_Open(DJI_CAMERA_CAPTURE_TYPE_FILE, &config, &capture) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    if (capture != NULL) {
+        MODULE_TEST_CHECK(DjiCameraCapture_TakePhoto(capture, "test_camera_capture.jpg") ==
+                          DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT);
+        MODULE_TEST_CHECK(DjiCameraCapture_Close(capture) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    }
+}
+
+/**
+ * @brief Run the stream loop of the Raspberry Pi camera sample on the file backend for TEST_CAPTURE_RUN_TIME_MS,
+ * reading straight into the splitter, and check pacing and looping of the replay.
+ */
+static void DjiTest_CaptureBenchmark(void)
+{
+    T_DjiCameraCaptureConfig config;
+    T_DjiCameraCaptureHandle capture = NULL;
+    T_UtilNalSplitter splitter;
+    uint8_t *splitterBuf;
+    uint8_t *span;
+    uint32_t spanLen;
+    uint32_t readLen;
+    uint32_t readCount = 0;
+    uint32_t generation;
+    uint64_t streamLen = 0;
+    uint64_t startUs;
+    uint64_t elapsedUs;
+    uint64_t cpuUs;
+
+    splitterBuf = malloc(TEST_CAPTURE_SPLITTER_BUFFER_SIZE);
+    MODULE_TEST_CHECK(splitterBuf != NULL);
+    if (splitterBuf == NULL) {
+        return;
+    }
+
+    DjiCameraCapture_GetDefaultConfig(&config);
+    strncpy(config.replayFilePath, TEST_CAPTURE_REPLAY_FILE, sizeof(config.replayFilePath) - 1);
+    config.frameRate = TEST_CAPTURE_FRAME_RATE;
+    config.bitRate = TEST_CAPTURE_FRAME_SIZE * 8 * TEST_CAPTURE_FRAME_RATE;
+    MODULE_TEST_CHECK(DjiCameraCapture_Open(DJI_CAMERA_CAPTURE_TYPE_FILE, &config, &capture) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    if (capture == NULL) {
+        free(splitterBuf);
+        return;
+    }
+
+    UtilNalSplitter_Init(&splitter, splitterBuf, TEST_CAPTURE_SPLITTER_BUFFER_SIZE, DjiTest_CaptureSendNal, NULL);
+    DjiVideoStreamSender_Init(&s_sender, DjiTest_CaptureStubSend, s_senderArena, sizeof(s_senderArena));
+    generation = capture->streamGeneration;
+
+    startUs = ModuleTest_GetTimeUs();
+    cpuUs = ModuleTest_GetCpuTimeUs();
+    while (ModuleTest_GetTimeUs() - startUs < TEST_CAPTURE_RUN_TIME_MS * 1000ULL) {
+        spanLen = UtilNalSplitter_GetWritableSpan(&splitter, &span);
+        MODULE_TEST_CHECK(DjiCameraCapture_ReadStream(capture, span, spanLen, &readLen,
+                                                      TEST_CAPTURE_READ_TIMEOUT_MS) ==
+                          DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+        readCount++;
+
+        if (capture->streamGeneration != generation) {
+            //the replay restarted, the pending NAL unit ends at the end of the file
+            UtilNalSplitter_Flush(&splitter);
+            generation = capture->streamGeneration;
+        }
+
+        if (readLen > 0 && s_readRecordCount < TEST_CAPTURE_READ_RECORD_MAX) {
+            streamLen += readLen;
+            s_readRecord[s_readRecordCount].streamEnd = streamLen;
+            s_readRecord[s_readRecordCount].timeUs = ModuleTest_GetTimeUs();
+            s_readRecordCount++;
+            UtilNalSplitter_CommitWrite(&splitter, readLen);
+        }
+    }
+    elapsedUs = ModuleTest_GetTimeUs() - startUs;
+    cpuUs = ModuleTest_GetCpuTimeUs() - cpuUs;
+
+    MODULE_TEST_CHECK(DjiCameraCapture_Close(capture) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+    //one file is one second of stream, so the replay must have looped once
+    MODULE_TEST_CHECK(generation == 1);
+    MODULE_TEST_CHECK(s_nalCount >= TEST_CAPTURE_FRAME_COUNT);
+    MODULE_TEST_CHECK(streamLen * 1000000 / elapsedUs > config.bitRate / 8 * 9 / 10);
+    MODULE_TEST_CHECK(streamLen * 1000000 / elapsedUs < config.bitRate / 8 * 11 / 10);
+
+    printf("Camera capture file backend, %u fps, %u kbit/s, %u NAL units sent:\r\n", config.frameRate,
+           config.bitRate / 1000, s_nalCount);
+    ModuleTest_Report("delivered bit rate", (double) streamLen * 8 * 1000 / (double) elapsedUs, "kbit/s");
+    ModuleTest_Report("reads per frame", (double) readCount * 1000000 / (double) elapsedUs / config.frameRate, "");
+    ModuleTest_Report("capture to first byte sent, min",
+                      s_nalCount ? (double) s_latencyMinUs / 1000 : 0, "ms");
+    ModuleTest_Report("capture to first byte sent, average",
+                      s_nalCount ? (double) s_latencySumUs / s_nalCount / 1000 : 0, "ms");
+    ModuleTest_Report("capture to first byte sent, max", (double) s_latencyMaxUs / 1000, "ms");
+    ModuleTest_Report("cpu load", (double) cpuUs * 100 / (double) elapsedUs, "%");
+
+    free(splitterBuf);
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,274 @@
+/**
+ ********************************************************************
+ * @file    test_camera_manager_download.c
+ * @brief   Test and benchmark of the camera manager download scheduler against the simulated camera.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "module_test.h"
+#include "utils/util_misc.h"
+#include "camera_manager/test_camera_manager_download_scheduler.h"
+#include "camera_manager/test_camera_manager_download_sim.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define TEST_DOWNLOAD_WORK_DIR                  "test_camera_manager_download.d"
+#define TEST_DOWNLOAD_WAIT_TIME_MS              60000
+#define TEST_DOWNLOAD_CHECK_FILE_COUNT          130
+#define TEST_DOWNLOAD_CHECK_FILE_SIZE           (16 * 1024)
+#define TEST_DOWNLOAD_CHECK_DELETE_COUNT        2
+#define TEST_DOWNLOAD_BENCH_SMALL_COUNT         200
+#define TEST_DOWNLOAD_BENCH_SMALL_SIZE          (64 * 1024)
+#define TEST_DOWNLOAD_BENCH_LARGE_COUNT         5
+#define TEST_DOWNLOAD_BENCH_LARGE_SIZE          (8 * 1024 * 1024)
+#define TEST_DOWNLOAD_BENCH_LATENCY_MS          5
+#define TEST_DOWNLOAD_BENCH_BYTES_PER_SECOND    (32 * 1024 * 1024)
+
+/* Private types -------------------------------------------------------------*/
+
+/* Private values -------------------------------------------------------------*/
+static uint32_t s_fileSizes[TEST_DOWNLOAD_BENCH_SMALL_COUNT + TEST_DOWNLOAD_BENCH_LARGE_COUNT];
+
+/* Private functions declaration ---------------------------------------------*/
+static void DjiTest_DownloadCleanWorkDir(void);
+static void DjiTest_DownloadMuteOutput(bool mute);
+static T_DjiReturnCode DjiTest_DownloadRun(const T_DjiTestDownloadRequest *request, uint8_t positionCount,
+                                           uint8_t parallelCount, T_DjiTestDownloadResult *result);
+static void DjiTest_DownloadTestRequests(void);
+static void DjiTest_DownloadBenchmark(void);
+static void DjiTest_DownloadBenchmarkPositions(uint8_t positionCount);
+
+/* Exported functions definition ---------------------------------------------*/
+int main(void)
+{
+    if (ModuleTest_Init() != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        printf("register osal handler failed\r\n");
+        return 1;
+    }
+
+    //the sink writes the downloaded files to the working directory
+    mkdir(TEST_DOWNLOAD_WORK_DIR, 0755);
+    if (chdir(TEST_DOWNLOAD_WORK_DIR) != 0) {
+        printf("enter work directory failed\r\n");
+        return 1;
+    }
+
+    DjiTest_DownloadTestRequests();
+    DjiTest_DownloadBenchmark();
+
+    DjiTest_DownloadCleanWorkDir();
+    if (chdir("..") == 0) {
+        rmdir(TEST_DOWNLOAD_WORK_DIR);
+    }
+
+    return ModuleTest_Finish("test_camera_manager_download");
+}
+
+/* Private functions definition-----------------------------------------------*/
+static void DjiTest_DownloadCleanWorkDir(void)
+{
+    struct dirent *entry;
+    DIR *dir;
+
+    dir = opendir(".");
+    if (dir == NULL) {
+        return;
+    }
+
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "DJI_SIM_", strlen("DJI_SIM_")) == 0) {
+            unlink(entry->d_name);
+        }
+    }
+
+    closedir(dir);
+}
+
+/**
+ * @brief Submit the request on positionCount mount positions from port 1 on and wait for all of them. The progress
+ * lines of the sink are dropped while the downloads run.
+ * @return Result of the first position.
+ */
+static T_DjiReturnCode DjiTest_DownloadRun(const T_DjiTestDownloadRequest *request, uint8_t positionCount,
+                                           uint8_t parallelCount, T_DjiTestDownloadResult *result)
+{
+    T_DjiTestDownloadRequest positionRequest = *request;
+    T_DjiTestDownloadResult positionResults[DJI_TEST_DOWNLOAD_SCHEDULER_PARALLEL_MAX];
+    T_DjiReturnCode submitCodes[DJI_TEST_DOWNLOAD_SCHEDULER_PARALLEL_MAX];
+    T_DjiReturnCode waitCodes[DJI_TEST_DOWNLOAD_SCHEDULER_PARALLEL_MAX];
+    T_DjiReturnCode returnCode;
+    uint8_t i;
+
+    if (positionCount == 0 || positionCount > DJI_TEST_DOWNLOAD_SCHEDULER_PARALLEL_MAX) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    returnCode = DjiTest_DownloadSchedulerInit(DjiTest_DownloadSimGetBackend(), parallelCount);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return returnCode;
+    }
+
+    DjiTest_DownloadMuteOutput(true);
+    for (i = 0; i < positionCount; i++) {
+        positionRequest.position = (E_DjiMountPosition) (DJI_MOUNT_POSITION_PAYLOAD_PORT_NO1 + i);
+        submitCodes[i] = DjiTest_DownloadSchedulerSubmit(&positionRequest);
+    }
+    for (i = 0; i < positionCount; i++) {
+        memset(&positionResults[i], 0, sizeof(T_DjiTestDownloadResult));
+        waitCodes[i] = DjiTest_DownloadSchedulerWait((E_DjiMountPosition) (DJI_MOUNT_POSITION_PAYLOAD_PORT_NO1 + i),
+                                                     TEST_DOWNLOAD_WAIT_TIME_MS, &positionResults[i]);
+    }
+    DjiTest_DownloadMuteOutput(false);
+
+    for (i = 0; i < positionCount; i++) {
+        MODULE_TEST_CHECK(submitCodes[i] == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+        MODULE_TEST_CHECK(waitCodes[i] == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+        MODULE_TEST_CHECK(positionResults[i].returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+        MODULE_TEST_CHECK(positionResults[i].downloadedCount == positionResults[0].downloadedCount);
+    }
+    *result = positionResults[0];
+
+    return DjiTest_DownloadSchedulerDeInit();
+}
+
+static void DjiTest_DownloadMuteOutput(bool mute)
+{
+    static int savedFd = -1;
+    int nullFd;
+
+    fflush(stdout);
+    if (mute && savedFd < 0) {
+        nullFd = open("/dev/null", O_WRONLY);
+        if (nullFd < 0) {
+            return;
+        }
+        savedFd = dup(STDOUT_FILENO);
+        dup2(nullFd, STDOUT_FILENO);
+        close(nullFd);
+    } else if (!mute && savedFd >= 0) {
+        dup2(savedFd, STDOUT_FILENO);
+        close(savedFd);
+        savedFd = -1;
+    }
+}
+
+/**
+ * @brief Download a listing of several slices, delete downloaded files and download part of the shortened list.
+ */
+static void DjiTest_DownloadTestRequests(void)
+{
+    T_DjiTestDownloadSimConfig config = {0};
+    T_DjiTestDownloadRequest request = {0};
+    T_DjiTestDownloadResult result = {0};
+    struct stat fileStat;
+    uint32_t i;
+
+    for (i = 0; i < TEST_DOWNLOAD_CHECK_FILE_COUNT; i++) {
+        s_fileSizes[i] = TEST_DOWNLOAD_CHECK_FILE_SIZE + i;
+    }
+    config.fileSizes = s_fileSizes;
+    config.fileCount = TEST_DOWNLOAD_CHECK_FILE_COUNT;
+    MODULE_TEST_CHECK(DjiTest_DownloadSimInit(&config) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+    request.countPerSlice = DJI_CAMERA_MANAGER_FILE_LIST_COUNT_60_PER_SLICE;
+    request.deleteCount = TEST_DOWNLOAD_CHECK_DELETE_COUNT;
+    MODULE_TEST_CHECK(DjiTest_DownloadRun(&request, 1, 1, &result) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(result.listedCount == TEST_DOWNLOAD_CHECK_FILE_COUNT);
+    MODULE_TEST_CHECK(result.downloadedCount == TEST_DOWNLOAD_CHECK_FILE_COUNT);
+    MODULE_TEST_CHECK(result.failedCount == 0);
+    MODULE_TEST_CHECK(result.retryCount == 0);
+    MODULE_TEST_CHECK(result.deletedCount == TEST_DOWNLOAD_CHECK_DELETE_COUNT);
+    MODULE_TEST_CHECK(stat("DJI_SIM_1_0003.JPG", &fileStat) == 0 &&
+                      fileStat.st_size == TEST_DOWNLOAD_CHECK_FILE_SIZE + 2);
+
+    //the deleted files are gone from the listing, the download stops after downloadCount files
+    request.deleteCount = 0;
+    request.downloadCount = 5;
+    MODULE_TEST_CHECK(DjiTest_DownloadRun(&request, 1, 1, &result) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(result.listedCount >= 5);
+    MODULE_TEST_CHECK(result.downloadedCount == 5);
+    MODULE_TEST_CHECK(result.deletedCount == 0);
+
+    request.downloadCount = 0;
+    request.countPerSlice = DJI_CAMERA_MANAGER_FILE_LIST_COUNT_ALL_PER_SLICE;
+    MODULE_TEST_CHECK(DjiTest_DownloadRun(&request, 1, 1, &result) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(result.listedCount == TEST_DOWNLOAD_CHECK_FILE_COUNT - TEST_DOWNLOAD_CHECK_DELETE_COUNT);
+    MODULE_TEST_CHECK(result.downloadedCount == TEST_DOWNLOAD_CHECK_FILE_COUNT - TEST_DOWNLOAD_CHECK_DELETE_COUNT);
+
+    DjiTest_DownloadSimDeInit();
+    DjiTest_DownloadCleanWorkDir();
+}
+
+/**
+ * @brief Download 200 small and 5 large files with a command round trip and a link throughput like a camera,
+ * from one mount position and from three positions in parallel.
+ */
+static void DjiTest_DownloadBenchmark(void)
+{
+    T_DjiTestDownloadSimConfig config = {0};
+    uint32_t i;
+
+    for (i = 0; i < TEST_DOWNLOAD_BENCH_SMALL_COUNT + TEST_DOWNLOAD_BENCH_LARGE_COUNT; i++) {
+        s_fileSizes[i] = i < TEST_DOWNLOAD_BENCH_SMALL_COUNT ? TEST_DOWNLOAD_BENCH_SMALL_SIZE :
+                         TEST_DOWNLOAD_BENCH_LARGE_SIZE;
+    }
+    config.fileSizes = s_fileSizes;
+    config.fileCount = TEST_DOWNLOAD_BENCH_SMALL_COUNT + TEST_DOWNLOAD_BENCH_LARGE_COUNT;
+    config.commandLatencyMs = TEST_DOWNLOAD_BENCH_LATENCY_MS;
+    config.bytesPerSecond = TEST_DOWNLOAD_BENCH_BYTES_PER_SECOND;
+    MODULE_TEST_CHECK(DjiTest_DownloadSimInit(&config) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+    DjiTest_DownloadBenchmarkPositions(1);
+    DjiTest_DownloadBenchmarkPositions(DJI_TEST_DOWNLOAD_SCHEDULER_PARALLEL_MAX);
+
+    DjiTest_DownloadSimDeInit();
+}
+
+static void DjiTest_DownloadBenchmarkPositions(uint8_t positionCount)
+{
+    T_DjiTestDownloadRequest request = {0};
+    T_DjiTestDownloadResult result = {0};
+    uint64_t startTimeUs;
+    double elapsedMs;
+    char name[64];
+
+    request.countPerSlice = DJI_CAMERA_MANAGER_FILE_LIST_COUNT_60_PER_SLICE;
+
+    startTimeUs = ModuleTest_GetTimeUs();
+    MODULE_TEST_CHECK(DjiTest_DownloadRun(&request, positionCount, positionCount, &result) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(result.downloadedCount == TEST_DOWNLOAD_BENCH_SMALL_COUNT + TEST_DOWNLOAD_BENCH_LARGE_COUNT);
+
+    elapsedMs = (double) (ModuleTest_GetTimeUs() - startTimeUs) / 1000;
+    snprintf(name, sizeof(name), "%u position(s) in parallel, total", positionCount);
+    ModuleTest_Report(name, elapsedMs, "ms");
+    snprintf(name, sizeof(name), "%u position(s) in parallel, per file", positionCount);
+    ModuleTest_Report(name, elapsedMs / (positionCount * USER_UTIL_MAX(result.downloadedCount, 1)), "ms");
+
+    DjiTest_DownloadCleanWorkDir();
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,327 @@
+/**
+ ********************************************************************
+ * @file    test_camera_manager_point_cloud.c
+ * @brief   Test and benchmark of the point cloud recorder and record reader with lost, reordered, duplicated and
+ *          damaged frames.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "module_test.h"
+#include "camera_manager/test_camera_manager_point_cloud.h"
+#include "utils/util_misc.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define TEST_POINT_CLOUD_RECORD_PATH            "test_camera_manager_point_cloud.rec"
+#define TEST_POINT_CLOUD_PLY_PATH               "test_camera_manager_point_cloud.ply"
+#define TEST_POINT_CLOUD_PCD_PATH               "test_camera_manager_point_cloud.pcd"
+#define TEST_POINT_CLOUD_FRAME_COUNT            1000
+#define TEST_POINT_CLOUD_POINT_MAX              1000
+#define TEST_POINT_CLOUD_POINTS_OFFSET          offsetof(T_DjiCameraManagerColorPointCloud, points)
+#define TEST_POINT_CLOUD_PACKET_SIZE_MAX        (TEST_POINT_CLOUD_POINTS_OFFSET + \
+                                                 TEST_POINT_CLOUD_POINT_MAX * sizeof(T_DjiCameraManagerPointXYZRGBInfo))
+#define TEST_POINT_CLOUD_PCD_POINT_SIZE         20
+#define TEST_POINT_CLOUD_BENCH_FRAME_COUNT      2000
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    uint32_t frameCount;
+    uint64_t pointCount;
+    uint32_t lostCount;
+    uint32_t reorderedCount;
+    uint32_t duplicateCount;
+    uint32_t invalidCount;
+} T_TestPointCloudExpect;
+
+/* Private values -------------------------------------------------------------*/
+static uint8_t s_packet[TEST_POINT_CLOUD_PACKET_SIZE_MAX];
+static long s_frameOffsets[TEST_POINT_CLOUD_FRAME_COUNT];
+
+/* Private functions declaration ---------------------------------------------*/
+static uint32_t DjiTest_PointCloudPointCount(uint32_t seqNum);
+static uint32_t DjiTest_PointCloudMakePacket(uint32_t seqNum, uint32_t pointCount);
+static void DjiTest_PointCloudSend(T_DjiTestPointCloudRecorderHandle recorder, uint32_t seqNum,
+                                   T_TestPointCloudExpect *expect, uint32_t *recordedCount, long *recordOffset);
+static void DjiTest_PointCloudTestRecord(void);
+static void DjiTest_PointCloudTestDamage(const T_TestPointCloudExpect *expect);
+static void DjiTest_PointCloudFlipByte(const char *path, long offset);
+static long DjiTest_PointCloudFileSize(const char *path);
+static void DjiTest_PointCloudBenchmark(void);
+
+/* Exported functions definition ---------------------------------------------*/
+int main(void)
+{
+    if (ModuleTest_Init() != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        printf("register osal handler failed\r\n");
+        return 1;
+    }
+
+    DjiTest_PointCloudTestRecord();
+    DjiTest_PointCloudBenchmark();
+
+    remove(TEST_POINT_CLOUD_RECORD_PATH);
+    remove(TEST_POINT_CLOUD_PLY_PATH);
+    remove(TEST_POINT_CLOUD_PCD_PATH);
+
+    return ModuleTest_Finish("test_camera_manager_point_cloud");
+}
+
+/* Private functions definition-----------------------------------------------*/
+static uint32_t DjiTest_PointCloudPointCount(uint32_t seqNum)
+{
+    return (seqNum * 37) % TEST_POINT_CLOUD_POINT_MAX;
+}
+
+static uint32_t DjiTest_PointCloudMakePacket(uint32_t seqNum, uint32_t pointCount)
+{
+    T_DjiCameraManagerColorPointCloud *pointCloud = (T_DjiCameraManagerColorPointCloud *) s_packet;
+    T_DjiCameraManagerPointXYZRGBInfo *points = (T_DjiCameraManagerPointXYZRGBInfo *) (s_packet +
+                                                                                       TEST_POINT_CLOUD_POINTS_OFFSET);
+    uint32_t i;
+
+    pointCloud->pointCloudHeader.flag = 0xFFFFFFFF;
+    pointCloud->pointCloudHeader.seqNum = seqNum;
+    pointCloud->pointCloudHeader.timestamp = (uint64_t) seqNum * 100000;
+    pointCloud->pointCloudHeader.dataByte = pointCount * sizeof(T_DjiCameraManagerPointXYZRGBInfo);
+    pointCloud->crc_header = 0;
+    pointCloud->crc_rest = 0;
+
+    for (i = 0; i < pointCount; i++) {
+        points[i].x = (dji_f32_t) seqNum;
+        points[i].y = (dji_f32_t) i;
+        points[i].z = -1.0f;
+        points[i].intensity = (uint8_t) i;
+        points[i].r = (uint8_t) seqNum;
+        points[i].g = (uint8_t) (seqNum >> 8);
+        points[i].b = 0x5A;
+    }
+
+    return TEST_POINT_CLOUD_POINTS_OFFSET + pointCloud->pointCloudHeader.dataByte;
+}
+
+static void DjiTest_PointCloudSend(T_DjiTestPointCloudRecorderHandle recorder, uint32_t seqNum,
+                                   T_TestPointCloudExpect *expect, uint32_t *recordedCount, long *recordOffset)
+{
+    uint32_t pointCount = DjiTest_PointCloudPointCount(seqNum);
+    uint32_t len = DjiTest_PointCloudMakePacket(seqNum, pointCount);
+
+    MODULE_TEST_CHECK(DjiTest_PointCloudRecorderWrite(recorder, s_packet, len) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    s_frameOffsets[(*recordedCount)++] = *recordOffset;
+    *recordOffset += (long) (sizeof(T_DjiTestPointCloudFrameHeader) + pointCount *
+                                                                      sizeof(T_DjiCameraManagerPointXYZRGBInfo));
+    expect->frameCount++;
+    expect->pointCount += pointCount;
+}
+
+/**
+ * @brief Feed a stream with lost frames, swapped neighbours, repeated frames and packets which are not point
+ * clouds, then check the recorder and reader statistics and the size of both exports.
+ */
+static void DjiTest_PointCloudTestRecord(void)
+{
+    T_DjiTestPointCloudRecorderHandle recorder = NULL;
+    T_DjiTestPointCloudRecorderStatistics recorderStatistics;
+    T_DjiTestPointCloudReaderStatistics readerStatistics;
+    T_TestPointCloudExpect expect = {0};
+    T_DjiCameraManagerColorPointCloud *pointCloud = (T_DjiCameraManagerColorPointCloud *) s_packet;
+    long recordOffset = sizeof(T_DjiTestPointCloudRecordHeader);
+    uint32_t recordedCount = 0;
+    uint32_t seqNum;
+    uint32_t len;
+    long headerSize;
+
+    MODULE_TEST_CHECK(DjiTest_PointCloudRecorderOpen(TEST_POINT_CLOUD_RECORD_PATH, DJI_MOUNT_POSITION_PAYLOAD_PORT_NO1,
+                                                     &recorder) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    if (recorder == NULL) {
+        return;
+    }
+
+    for (seqNum = 0; seqNum < TEST_POINT_CLOUD_FRAME_COUNT; seqNum++) {
+        if (seqNum % 37 == 5) {
+            expect.lostCount++;
+            continue;
+        }
+        if (seqNum % 23 == 10 && (seqNum + 1) % 37 != 5 && seqNum + 1 < TEST_POINT_CLOUD_FRAME_COUNT) {
+            DjiTest_PointCloudSend(recorder, seqNum + 1, &expect, &recordedCount, &recordOffset);
+            DjiTest_PointCloudSend(recorder, seqNum, &expect, &recordedCount, &recordOffset);
+            expect.reorderedCount++;
+            seqNum++;
+            continue;
+        }
+
+        DjiTest_PointCloudSend(recorder, seqNum, &expect, &recordedCount, &recordOffset);
+        if (seqNum % 41 == 7) {
+            len = DjiTest_PointCloudMakePacket(seqNum, DjiTest_PointCloudPointCount(seqNum));
+            MODULE_TEST_CHECK(DjiTest_PointCloudRecorderWrite(recorder, s_packet, len) ==
+                              DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+            expect.duplicateCount++;
+        }
+        if (seqNum % 50 == 20) {
+            len = DjiTest_PointCloudMakePacket(seqNum, 10);
+            pointCloud->pointCloudHeader.flag = 0x12345678;
+            MODULE_TEST_CHECK(DjiTest_PointCloudRecorderWrite(recorder, s_packet, len) !=
+                              DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+            expect.invalidCount++;
+        }
+    }
+
+    DjiTest_PointCloudRecorderGetStatistics(recorder, &recorderStatistics);
+    MODULE_TEST_CHECK(recorderStatistics.frameCount == expect.frameCount);
+    MODULE_TEST_CHECK(recorderStatistics.pointCount == expect.pointCount);
+    MODULE_TEST_CHECK(recorderStatistics.lostFrameCount == expect.lostCount);
+    MODULE_TEST_CHECK(recorderStatistics.reorderedFrameCount == expect.reorderedCount);
+    MODULE_TEST_CHECK(recorderStatistics.duplicateFrameCount == expect.duplicateCount);
+    MODULE_TEST_CHECK(recorderStatistics.invalidFrameCount == expect.invalidCount);
+    MODULE_TEST_CHECK(recorderStatistics.writtenBytes == (uint64_t) recordOffset);
+    MODULE_TEST_CHECK(DjiTest_PointCloudRecorderClose(recorder) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_PointCloudFileSize(TEST_POINT_CLOUD_RECORD_PATH) == recordOffset);
+
+    memset(&readerStatistics, 0, sizeof(readerStatistics));
+    MODULE_TEST_CHECK(DjiTest_PointCloudRecordExport(TEST_POINT_CLOUD_RECORD_PATH, TEST_POINT_CLOUD_PLY_PATH,
+                                                     DJI_TEST_POINT_CLOUD_EXPORT_FORMAT_PLY, &readerStatistics) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(readerStatistics.frameCount == expect.frameCount);
+    MODULE_TEST_CHECK(readerStatistics.pointCount == expect.pointCount);
+    MODULE_TEST_CHECK(readerStatistics.lostFrameCount == expect.lostCount);
+    MODULE_TEST_CHECK(readerStatistics.reorderedFrameCount == expect.reorderedCount);
+    MODULE_TEST_CHECK(readerStatistics.corruptFrameCount == 0);
+
+    //the text header ends with the line before the binary points
+    headerSize = DjiTest_PointCloudFileSize(TEST_POINT_CLOUD_PLY_PATH) -
+                 (long) (expect.pointCount * sizeof(T_DjiCameraManagerPointXYZRGBInfo));
+    MODULE_TEST_CHECK(headerSize > 0 && headerSize < 512);
+
+    MODULE_TEST_CHECK(DjiTest_PointCloudRecordExport(TEST_POINT_CLOUD_RECORD_PATH, TEST_POINT_CLOUD_PCD_PATH,
+                                                     DJI_TEST_POINT_CLOUD_EXPORT_FORMAT_PCD, NULL) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    headerSize = DjiTest_PointCloudFileSize(TEST_POINT_CLOUD_PCD_PATH) -
+                 (long) (expect.pointCount * TEST_POINT_CLOUD_PCD_POINT_SIZE);
+    MODULE_TEST_CHECK(headerSize > 0 && headerSize < 512);
+
+    DjiTest_PointCloudTestDamage(&expect);
+}
+
+/**
+ * @brief Damage the header of one frame and the points of another, the reader skips both and keeps the rest.
+ */
+static void DjiTest_PointCloudTestDamage(const T_TestPointCloudExpect *expect)
+{
+    T_DjiTestPointCloudReaderStatistics readerStatistics = {0};
+    uint32_t headerFrame = 100;
+    uint32_t dataFrame = 500;
+
+    //frames without points cannot have their points damaged
+    while (dataFrame + 1 < expect->frameCount &&
+           s_frameOffsets[dataFrame + 1] - s_frameOffsets[dataFrame] <= (long) sizeof(T_DjiTestPointCloudFrameHeader)) {
+        dataFrame++;
+    }
+
+    DjiTest_PointCloudFlipByte(TEST_POINT_CLOUD_RECORD_PATH,
+                               s_frameOffsets[headerFrame] + offsetof(T_DjiTestPointCloudFrameHeader, seqNum));
+    DjiTest_PointCloudFlipByte(TEST_POINT_CLOUD_RECORD_PATH,
+                               s_frameOffsets[dataFrame] + sizeof(T_DjiTestPointCloudFrameHeader));
+
+    MODULE_TEST_CHECK(DjiTest_PointCloudRecordExport(TEST_POINT_CLOUD_RECORD_PATH, TEST_POINT_CLOUD_PLY_PATH,
+                                                     DJI_TEST_POINT_CLOUD_EXPORT_FORMAT_PLY, &readerStatistics) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(readerStatistics.corruptFrameCount == 2);
+    MODULE_TEST_CHECK(readerStatistics.frameCount == expect->frameCount - 2);
+    MODULE_TEST_CHECK(readerStatistics.skippedBytes ==
+                      (uint64_t) (s_frameOffsets[headerFrame + 1] - s_frameOffsets[headerFrame]) +
+                      (uint64_t) (s_frameOffsets[dataFrame + 1] - s_frameOffsets[dataFrame]));
+}
+
+static void DjiTest_PointCloudFlipByte(const char *path, long offset)
+{
+    FILE *file;
+    int byte;
+
+    file = fopen(path, "r+b");
+    if (file == NULL) {
+        MODULE_TEST_CHECK(false);
+        return;
+    }
+
+    if (fseek(file, offset, SEEK_SET) == 0 && (byte = fgetc(file)) != EOF && fseek(file, offset, SEEK_SET) == 0) {
+        fputc(byte ^ 0xFF, file);
+    } else {
+        MODULE_TEST_CHECK(false);
+    }
+
+    fclose(file);
+}
+
+static long DjiTest_PointCloudFileSize(const char *path)
+{
+    struct stat fileStat;
+
+    if (stat(path, &fileStat) != 0) {
+        return -1;
+    }
+
+    return (long) fileStat.st_size;
+}
+
+/**
+ * @brief Record packets of the largest test size back to back, as fast as the recorder takes them.
+ */
+static void DjiTest_PointCloudBenchmark(void)
+{
+    T_DjiTestPointCloudRecorderHandle recorder = NULL;
+    T_DjiTestPointCloudRecorderStatistics statistics;
+    uint64_t startTimeUs;
+    uint64_t maxWriteUs = 0;
+    uint64_t writeStartUs;
+    uint64_t elapsedUs;
+    uint32_t len;
+    uint32_t i;
+
+    MODULE_TEST_CHECK(DjiTest_PointCloudRecorderOpen(TEST_POINT_CLOUD_RECORD_PATH, DJI_MOUNT_POSITION_PAYLOAD_PORT_NO1,
+                                                     &recorder) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    if (recorder == NULL) {
+        return;
+    }
+
+    len = DjiTest_PointCloudMakePacket(0, TEST_POINT_CLOUD_POINT_MAX);
+    startTimeUs = ModuleTest_GetTimeUs();
+    for (i = 0; i < TEST_POINT_CLOUD_BENCH_FRAME_COUNT; i++) {
+        ((T_DjiCameraManagerColorPointCloud *) s_packet)->pointCloudHeader.seqNum = i;
+        writeStartUs = ModuleTest_GetTimeUs();
+        MODULE_TEST_CHECK(DjiTest_PointCloudRecorderWrite(recorder, s_packet, len) ==
+                          DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+        maxWriteUs = USER_UTIL_MAX(maxWriteUs, ModuleTest_GetTimeUs() - writeStartUs);
+    }
+    DjiTest_PointCloudRecorderGetStatistics(recorder, &statistics);
+    MODULE_TEST_CHECK(DjiTest_PointCloudRecorderClose(recorder) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    elapsedUs = USER_UTIL_MAX(ModuleTest_GetTimeUs() - startTimeUs, 1);
+
+    MODULE_TEST_CHECK(statistics.frameCount == TEST_POINT_CLOUD_BENCH_FRAME_COUNT);
+    ModuleTest_Report("ingest rate", (double) statistics.writtenBytes / elapsedUs, "MB/s");
+    ModuleTest_Report("ingest rate", (double) statistics.frameCount * 1000000 / elapsedUs, "frames/s");
+    ModuleTest_Report("ingest rate", (double) statistics.pointCount / elapsedUs, "Mpoints/s");
+    ModuleTest_Report("longest write call", (double) maxWriteUs, "us");
+    ModuleTest_Report("writes waiting for the writer task", statistics.writerWaitCount, "writes");
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,768 @@
+/**
+ ********************************************************************
+ * @file    test_fc_subscription_dispatcher.c
+ * @brief   Test and benchmark of the FC subscription dispatcher and of the consumers sharing topics through it,
+ *          against a stub of the subscription module.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "module_test.h"
+#include "dji_fc_subscription.h"
+#include "fc_subscription/test_fc_subscription_dispatcher.h"
+#include "fc_subscription/test_fc_subscription_cache.h"
+#include "fc_subscription/test_fc_subscription_snapshot.h"
+#include "fc_subscription/test_fc_subscription_recorder.h"
+#include "utils/util_misc.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define TEST_FC_STUB_TOPIC_MAX                  16
+#define TEST_FC_DRAIN_CALLBACK_TIME_MS          50
+#define TEST_FC_TORN_RUN_TIME_MS                500
+#define TEST_FC_SNAPSHOT_TORN_RUN_TIME_MS       300
+#define TEST_FC_RECORDER_RUN_TIME_MS            100
+#define TEST_FC_RECORDER_PATH_PREFIX            "test_fc_subscription_dispatcher"
+#define TEST_FC_RECORDER_SEGMENT_PATH           TEST_FC_RECORDER_PATH_PREFIX "_0000" DJI_TEST_FC_RECORD_FILE_EXTENSION
+#define TEST_FC_CACHE_DEPTH                     4
+#define TEST_FC_BENCH_SAMPLE_COUNT              1000000
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    bool used;
+    E_DjiFcSubscriptionTopic topic;
+    E_DjiDataSubscriptionTopicFreq frequency;
+    DjiReceiveDataOfTopicCallback callback;
+} T_TestFcStubTopic;
+
+typedef struct {
+    uint32_t callCount;
+    uint16_t dataSize;
+    uint8_t data[16];
+    uint32_t millisecond;
+} T_TestFcConsumer;
+
+typedef struct {
+    bool stopRequest;
+    uint32_t sampleCount;
+} T_TestFcPublisher;
+
+typedef struct {
+    T_DjiFcSubscriptionQuaternion quaternion;
+    T_DjiFcSubscriptionVelocity velocity;
+} T_TestFcSnapshot;
+
+/* Private values -------------------------------------------------------------*/
+static T_TestFcStubTopic s_stubTopics[TEST_FC_STUB_TOPIC_MAX];
+static pthread_mutex_t s_stubMutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t s_stubSubscribeCount = 0;
+static uint32_t s_stubUnsubscribeCount = 0;
+static E_DjiFcSubscriptionTopic s_stubFailTopic = DJI_FC_SUBSCRIPTION_TOPIC_TOTAL_NUMBER;
+static uint32_t s_drainState = 0;
+
+/* Private functions declaration ---------------------------------------------*/
+static T_TestFcStubTopic *DjiTest_FcStubFind(E_DjiFcSubscriptionTopic topic);
+static bool DjiTest_FcStubPublish(E_DjiFcSubscriptionTopic topic, const void *data, uint16_t dataSize,
+                                  uint32_t millisecond);
+static void DjiTest_FcConsumerCallback(const uint8_t *data, uint16_t dataSize, const T_DjiDataTimestamp *timestamp,
+                                       void *userData);
+static void DjiTest_FcSlowConsumerCallback(const uint8_t *data, uint16_t dataSize,
+                                           const T_DjiDataTimestamp *timestamp, void *userData);
+static void *DjiTest_FcDrainPublishTask(void *arg);
+static void *DjiTest_FcVelocityPublishTask(void *arg);
+static void DjiTest_FcDispatcherTestFanOut(void);
+static void DjiTest_FcDispatcherTestDrain(void);
+static void DjiTest_FcDispatcherTestCache(void);
+static void DjiTest_FcDispatcherTestCacheTorn(void);
+static void DjiTest_FcDispatcherTestSnapshot(void);
+static void DjiTest_FcDispatcherTestRecorder(void);
+static void DjiTest_FcDispatcherBenchmark(void);
+T_DjiReturnCode __wrap_DjiFcSubscription_SubscribeTopic(E_DjiFcSubscriptionTopic topic,
+                                                        E_DjiDataSubscriptionTopicFreq frequency,
+                                                        DjiReceiveDataOfTopicCallback callback);
+T_DjiReturnCode __wrap_DjiFcSubscription_UnSubscribeTopic(E_DjiFcSubscriptionTopic topic);
+
+/* Exported functions definition ---------------------------------------------*/
+int main(void)
+{
+    if (ModuleTest_Init() != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        printf("register osal handler failed\r\n");
+        return 1;
+    }
+
+    DjiTest_FcDispatcherTestFanOut();
+    DjiTest_FcDispatcherTestDrain();
+    DjiTest_FcDispatcherTestCache();
+    DjiTest_FcDispatcherTestCacheTorn();
+    DjiTest_FcDispatcherTestSnapshot();
+    DjiTest_FcDispatcherTestRecorder();
+    DjiTest_FcDispatcherBenchmark();
+
+    return ModuleTest_Finish("test_fc_subscription_dispatcher");
+}
+
+/**
+ * @brief Stub of the subscription module linked with --wrap, one subscription per topic as in the SDK.
+ */
+T_DjiReturnCode __wrap_DjiFcSubscription_SubscribeTopic(E_DjiFcSubscriptionTopic topic,
+                                                        E_DjiDataSubscriptionTopicFreq frequency,
+                                                        DjiReceiveDataOfTopicCallback callback)
+{
+    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
+    uint32_t i;
+
+    pthread_mutex_lock(&s_stubMutex);
+    if (topic == s_stubFailTopic) {
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    } else if (DjiTest_FcStubFind(topic) != NULL) {
+        returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+    } else {
+        for (i = 0; i < TEST_FC_STUB_TOPIC_MAX; i++) {
+            if (!s_stubTopics[i].used) {
+                s_stubTopics[i].used = true;
+                s_stubTopics[i].topic = topic;
+                s_stubTopics[i].frequency = frequency;
+                s_stubTopics[i].callback = callback;
+                s_stubSubscribeCount++;
+                returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&s_stubMutex);
+
+    return returnCode;
+}
+
+T_DjiReturnCode __wrap_DjiFcSubscription_UnSubscribeTopic(E_DjiFcSubscriptionTopic topic)
+{
+    T_TestFcStubTopic *stubTopic;
+
+    pthread_mutex_lock(&s_stubMutex);
+    stubTopic = DjiTest_FcStubFind(topic);
+    if (stubTopic != NULL) {
+        stubTopic->used = false;
+        s_stubUnsubscribeCount++;
+    }
+    pthread_mutex_unlock(&s_stubMutex);
+
+    return stubTopic != NULL ? DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS : DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+}
+
+/* Private functions definition-----------------------------------------------*/
+static T_TestFcStubTopic *DjiTest_FcStubFind(E_DjiFcSubscriptionTopic topic)
+{
+    uint32_t i;
+
+    for (i = 0; i < TEST_FC_STUB_TOPIC_MAX; i++) {
+        if (s_stubTopics[i].used && s_stubTopics[i].topic == topic) {
+            return &s_stubTopics[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Deliver one sample as the SDK does, the callback runs outside the lock of the stub.
+ * @return false if the topic is not subscribed.
+ */
+static bool DjiTest_FcStubPublish(E_DjiFcSubscriptionTopic topic, const void *data, uint16_t dataSize,
+                                  uint32_t millisecond)
+{
+    T_DjiDataTimestamp timestamp = {millisecond, millisecond * 1000};
+    DjiReceiveDataOfTopicCallback callback = NULL;
+    T_TestFcStubTopic *stubTopic;
+
+    pthread_mutex_lock(&s_stubMutex);
+    stubTopic = DjiTest_FcStubFind(topic);
+    if (stubTopic != NULL) {
+        callback = stubTopic->callback;
+    }
+    pthread_mutex_unlock(&s_stubMutex);
+
+    if (callback == NULL) {
+        return false;
+    }
+
+    callback((const uint8_t *) data, dataSize, &timestamp);
+
+    return true;
+}
+
+static void DjiTest_FcConsumerCallback(const uint8_t *data, uint16_t dataSize, const T_DjiDataTimestamp *timestamp,
+                                       void *userData)
+{
+    T_TestFcConsumer *consumer = (T_TestFcConsumer *) userData;
+
+    consumer->callCount++;
+    consumer->dataSize = dataSize;
+    memcpy(consumer->data, data, USER_UTIL_MIN(dataSize, sizeof(consumer->data)));
+    consumer->millisecond = timestamp->millisecond;
+}
+
+static void DjiTest_FcSlowConsumerCallback(const uint8_t *data, uint16_t dataSize,
+                                           const T_DjiDataTimestamp *timestamp, void *userData)
+{
+    USER_UTIL_UNUSED(data);
+    USER_UTIL_UNUSED(dataSize);
+    USER_UTIL_UNUSED(timestamp);
+    USER_UTIL_UNUSED(userData);
+
+    __atomic_store_n(&s_drainState, 1, __ATOMIC_RELEASE);
+    usleep(TEST_FC_DRAIN_CALLBACK_TIME_MS * 1000);
+    __atomic_store_n(&s_drainState, 2, __ATOMIC_RELEASE);
+}
+
+static void *DjiTest_FcDrainPublishTask(void *arg)
+{
+    uint32_t value = 1;
+
+    USER_UTIL_UNUSED(arg);
+    DjiTest_FcStubPublish(DJI_FC_SUBSCRIPTION_TOPIC_ALTITUDE_FUSED, &value, sizeof(value), 1);
+
+    return NULL;
+}
+
+/**
+ * @brief Publish velocity samples as fast as possible, the three axes of a sample carry the same value so a
+ * torn read shows up as differing axes.
+ */
+static void *DjiTest_FcVelocityPublishTask(void *arg)
+{
+    T_TestFcPublisher *publisher = (T_TestFcPublisher *) arg;
+    T_DjiFcSubscriptionVelocity velocity = {0};
+
+    while (!__atomic_load_n(&publisher->stopRequest, __ATOMIC_ACQUIRE)) {
+        velocity.data.x = (dji_f32_t) publisher->sampleCount;
+        velocity.data.y = velocity.data.x;
+        velocity.data.z = velocity.data.x;
+        DjiTest_FcStubPublish(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY, &velocity, sizeof(velocity),
+                              publisher->sampleCount);
+        publisher->sampleCount++;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Several consumers of one topic share a single subscription at the highest frequency asked for, the
+ * topic is unsubscribed with its last consumer.
+ */
+static void DjiTest_FcDispatcherTestFanOut(void)
+{
+    T_TestFcConsumer consumers[DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CONSUMER_MAX + 1];
+    T_DjiTestFcSubscriptionConsumerHandle handles[DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CONSUMER_MAX + 1];
+    T_DjiTestFcSubscriptionConsumerHandle otherHandle = NULL;
+    const E_DjiDataSubscriptionTopicFreq frequencies[] = {
+        DJI_DATA_SUBSCRIPTION_TOPIC_50_HZ, DJI_DATA_SUBSCRIPTION_TOPIC_10_HZ, DJI_DATA_SUBSCRIPTION_TOPIC_100_HZ,
+        DJI_DATA_SUBSCRIPTION_TOPIC_1_HZ,
+    };
+    T_DjiFcSubscriptionQuaternion quaternion = {1.0f, 0.5f, 0.25f, 0.125f};
+    T_TestFcConsumer otherConsumer = {0};
+    uint32_t i;
+
+    memset(consumers, 0, sizeof(consumers));
+    for (i = 0; i < UTIL_ARRAY_SIZE(frequencies); i++) {
+        MODULE_TEST_CHECK(DjiTest_FcSubscriptionDispatcherRegister(DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION,
+                                                                   frequencies[i], DjiTest_FcConsumerCallback,
+                                                                   &consumers[i], &handles[i]) ==
+                          DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    }
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionDispatcherRegister(DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION,
+                                                               DJI_DATA_SUBSCRIPTION_TOPIC_1_HZ,
+                                                               DjiTest_FcConsumerCallback, &consumers[i],
+                                                               &handles[i]) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE);
+    MODULE_TEST_CHECK(DjiTest_FcStubFind(DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION) != NULL &&
+                      DjiTest_FcStubFind(DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION)->frequency ==
+                      DJI_DATA_SUBSCRIPTION_TOPIC_100_HZ);
+    MODULE_TEST_CHECK(s_stubSubscribeCount == 2 && s_stubUnsubscribeCount == 1);
+
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionDispatcherRegister(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY,
+                                                               DJI_DATA_SUBSCRIPTION_TOPIC_1_HZ,
+                                                               DjiTest_FcConsumerCallback, &otherConsumer,
+                                                               &otherHandle) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+    MODULE_TEST_CHECK(DjiTest_FcStubPublish(DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION, &quaternion, sizeof(quaternion),
+                                            1234));
+    for (i = 0; i < UTIL_ARRAY_SIZE(frequencies); i++) {
+        MODULE_TEST_CHECK(consumers[i].callCount == 1 && consumers[i].dataSize == sizeof(quaternion) &&
+                          memcmp(consumers[i].data, &quaternion, sizeof(quaternion)) == 0 &&
+                          consumers[i].millisecond == 1234);
+    }
+    MODULE_TEST_CHECK(otherConsumer.callCount == 0);
+
+    //a consumer unregistered stops receiving, the others keep the subscription
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionDispatcherUnregister(handles[0]) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionDispatcherUnregister(handles[0]) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER);
+    MODULE_TEST_CHECK(DjiTest_FcStubPublish(DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION, &quaternion, sizeof(quaternion),
+                                            1235));
+    MODULE_TEST_CHECK(consumers[0].callCount == 1 && consumers[1].callCount == 2);
+
+    for (i = 1; i < UTIL_ARRAY_SIZE(frequencies); i++) {
+        MODULE_TEST_CHECK(DjiTest_FcStubFind(DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION) != NULL);
+        MODULE_TEST_CHECK(DjiTest_FcSubscriptionDispatcherUnregister(handles[i]) ==
+                          DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    }
+    MODULE_TEST_CHECK(DjiTest_FcStubFind(DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION) == NULL);
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionDispatcherUnregister(otherHandle) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_FcStubFind(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY) == NULL);
+
+    //a failed subscription leaves nothing registered behind
+    s_stubFailTopic = DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION;
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionDispatcherRegister(DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION,
+                                                               DJI_DATA_SUBSCRIPTION_TOPIC_1_HZ,
+                                                               DjiTest_FcConsumerCallback, &consumers[0],
+                                                               &handles[0]) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    s_stubFailTopic = DJI_FC_SUBSCRIPTION_TOPIC_TOTAL_NUMBER;
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionDispatcherRegister(DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION,
+                                                               DJI_DATA_SUBSCRIPTION_TOPIC_1_HZ,
+                                                               DjiTest_FcConsumerCallback, &consumers[0],
+                                                               &handles[0]) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionDispatcherUnregister(handles[0]) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+}
+
+/**
+ * @brief Unregister while the consumer callback runs, it must return only after the callback finished.
+ */
+static void DjiTest_FcDispatcherTestDrain(void)
+{
+    T_DjiTestFcSubscriptionConsumerHandle handle = NULL;
+    pthread_t publishTask;
+
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionDispatcherRegister(DJI_FC_SUBSCRIPTION_TOPIC_ALTITUDE_FUSED,
+                                                               DJI_DATA_SUBSCRIPTION_TOPIC_1_HZ,
+                                                               DjiTest_FcSlowConsumerCallback, NULL, &handle) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    if (pthread_create(&publishTask, NULL, DjiTest_FcDrainPublishTask, NULL) != 0) {
+        MODULE_TEST_CHECK(false);
+        return;
+    }
+
+    while (__atomic_load_n(&s_drainState, __ATOMIC_ACQUIRE) == 0) {
+        usleep(1000);
+    }
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionDispatcherUnregister(handle) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(__atomic_load_n(&s_drainState, __ATOMIC_ACQUIRE) == 2);
+    pthread_join(publishTask, NULL);
+}
+
+/**
+ * @brief The cache shares velocity with another consumer, both receive every sample.
+ */
+static void DjiTest_FcDispatcherTestCache(void)
+{
+    T_DjiTestFcSubscriptionCacheTopicConfig cacheConfig = {
+        .topic = DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY,
+        .frequency = DJI_DATA_SUBSCRIPTION_TOPIC_50_HZ,
+        .dataSize = sizeof(T_DjiFcSubscriptionVelocity),
+        .depth = TEST_FC_CACHE_DEPTH,
+        .interpolate = DjiTest_FcSubscriptionCacheInterpolateVector3f,
+    };
+    T_DjiTestFcSubscriptionConsumerHandle handle = NULL;
+    T_DjiTestFcSubscriptionCacheStatistics statistics = {0};
+    T_DjiFcSubscriptionVelocity velocities[TEST_FC_CACHE_DEPTH];
+    T_DjiFcSubscriptionVelocity velocity = {0};
+    T_TestFcConsumer consumer = {0};
+    uint64_t timestampsUs[TEST_FC_CACHE_DEPTH];
+    uint64_t timestampUs = 0;
+    uint32_t sequence = 0;
+    uint32_t count = 0;
+    uint32_t i;
+
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionCacheInit(&cacheConfig, 1) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionDispatcherRegister(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY,
+                                                               DJI_DATA_SUBSCRIPTION_TOPIC_10_HZ,
+                                                               DjiTest_FcConsumerCallback, &consumer, &handle) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+    for (i = 0; i < 10; i++) {
+        velocity.data.x = (dji_f32_t) i;
+        velocity.data.y = (dji_f32_t) i * 2;
+        velocity.data.z = (dji_f32_t) i * 3;
+        MODULE_TEST_CHECK(DjiTest_FcStubPublish(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY, &velocity, sizeof(velocity),
+                                                i * 20));
+    }
+    MODULE_TEST_CHECK(consumer.callCount == 10);
+
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionCacheGetLatest(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY, (uint8_t *) &velocity,
+                                                           sizeof(velocity), &timestampUs, &sequence) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(velocity.data.x == 9.0f && timestampUs == 180000 && sequence == 9);
+
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionCacheGetAtTime(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY, 150000,
+                                                           (uint8_t *) &velocity, sizeof(velocity), &timestampUs) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(velocity.data.x == 7.5f && velocity.data.z == 22.5f && timestampUs == 150000);
+    //only depth - 1 samples are searched, sample 6 is already out of range
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionCacheGetAtTime(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY, 130000,
+                                                           (uint8_t *) &velocity, sizeof(velocity), &timestampUs) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE);
+
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionCacheGetRange(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY, 160000, 200000,
+                                                          (uint8_t *) velocities, sizeof(velocity), timestampsUs,
+                                                          TEST_FC_CACHE_DEPTH, &count) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(count == 2 && velocities[0].data.x == 8.0f && timestampsUs[1] == 180000);
+
+    DjiTest_FcSubscriptionCacheGetStatistics(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY, &statistics);
+    MODULE_TEST_CHECK(statistics.updateCount == 10 && statistics.lateUpdateCount == 0);
+
+    //the other consumer keeps the topic subscribed after the cache is gone
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionCacheDeInit() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_FcStubPublish(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY, &velocity, sizeof(velocity), 200));
+    MODULE_TEST_CHECK(consumer.callCount == 11);
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionDispatcherUnregister(handle) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+}
+
+/**
+ * @brief Read the latest sample of a small ring while another thread overwrites it as fast as it can.
+ */
+static void DjiTest_FcDispatcherTestCacheTorn(void)
+{
+    T_DjiTestFcSubscriptionCacheTopicConfig cacheConfig = {
+        .topic = DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY,
+        .frequency = DJI_DATA_SUBSCRIPTION_TOPIC_400_HZ,
+        .dataSize = sizeof(T_DjiFcSubscriptionVelocity),
+        .depth = TEST_FC_CACHE_DEPTH,
+        .interpolate = NULL,
+    };
+    T_DjiTestFcSubscriptionCacheStatistics statistics = {0};
+    T_DjiFcSubscriptionVelocity velocity;
+    T_TestFcPublisher publisher = {0};
+    T_DjiReturnCode returnCode;
+    pthread_t publishTask;
+    uint64_t startTimeUs;
+    uint32_t readCount = 0;
+    uint32_t busyCount = 0;
+    uint32_t tornCount = 0;
+
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionCacheInit(&cacheConfig, 1) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    if (pthread_create(&publishTask, NULL, DjiTest_FcVelocityPublishTask, &publisher) != 0) {
+        MODULE_TEST_CHECK(false);
+        DjiTest_FcSubscriptionCacheDeInit();
+        return;
+    }
+
+    startTimeUs = ModuleTest_GetTimeUs();
+    while (ModuleTest_GetTimeUs() - startTimeUs < TEST_FC_TORN_RUN_TIME_MS * 1000) {
+        returnCode = DjiTest_FcSubscriptionCacheGetLatest(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY, (uint8_t *) &velocity,
+                                                          sizeof(velocity), NULL, NULL);
+        if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_BUSY) {
+            busyCount++;
+        } else if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            readCount++;
+            if (velocity.data.x != velocity.data.y || velocity.data.x != velocity.data.z) {
+                tornCount++;
+            }
+        }
+    }
+
+    __atomic_store_n(&publisher.stopRequest, true, __ATOMIC_RELEASE);
+    pthread_join(publishTask, NULL);
+    DjiTest_FcSubscriptionCacheGetStatistics(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY, &statistics);
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionCacheDeInit() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+    MODULE_TEST_CHECK(readCount > 0 && publisher.sampleCount > 0);
+    MODULE_TEST_CHECK(tornCount == 0);
+    ModuleTest_Report("cache torn test samples written", publisher.sampleCount, "samples");
+    ModuleTest_Report("cache torn test reads", readCount, "reads");
+    ModuleTest_Report("cache torn test read retries", statistics.readRetryCount, "retries");
+    ModuleTest_Report("cache torn test busy reads", busyCount, "reads");
+}
+
+/**
+ * @brief The snapshot shares velocity with the cache, then is read while velocity is published as fast as
+ * possible, a read either returns a consistent snapshot or BUSY after its backoff.
+ */
+static void DjiTest_FcDispatcherTestSnapshot(void)
+{
+    const T_DjiTestFcSubscriptionSnapshotTopicConfig snapshotConfigs[] = {
+        {DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION, DJI_DATA_SUBSCRIPTION_TOPIC_50_HZ,
+         sizeof(T_DjiFcSubscriptionQuaternion), offsetof(T_TestFcSnapshot, quaternion)},
+        {DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY, DJI_DATA_SUBSCRIPTION_TOPIC_50_HZ,
+         sizeof(T_DjiFcSubscriptionVelocity), offsetof(T_TestFcSnapshot, velocity)},
+    };
+    T_DjiTestFcSubscriptionCacheTopicConfig cacheConfig = {
+        .topic = DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY,
+        .frequency = DJI_DATA_SUBSCRIPTION_TOPIC_100_HZ,
+        .dataSize = sizeof(T_DjiFcSubscriptionVelocity),
+        .depth = TEST_FC_CACHE_DEPTH,
+        .interpolate = NULL,
+    };
+    T_DjiTestFcSubscriptionSnapshotInfo info = {0};
+    T_DjiFcSubscriptionQuaternion quaternion = {1.0f, 0.5f, 0.25f, 0.125f};
+    T_DjiFcSubscriptionVelocity velocity = {0};
+    T_TestFcSnapshot snapshot;
+    T_TestFcPublisher publisher = {0};
+    T_DjiReturnCode returnCode;
+    pthread_t publishTask;
+    uint64_t startTimeUs;
+    uint32_t readCount = 0;
+    uint32_t busyCount = 0;
+    uint32_t tornCount = 0;
+
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionCacheInit(&cacheConfig, 1) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionSnapshotInit(snapshotConfigs, UTIL_ARRAY_SIZE(snapshotConfigs),
+                                                         sizeof(T_TestFcSnapshot)) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_FcStubFind(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY) != NULL &&
+                      DjiTest_FcStubFind(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY)->frequency ==
+                      DJI_DATA_SUBSCRIPTION_TOPIC_100_HZ);
+
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionSnapshotGet(&snapshot, sizeof(snapshot), &info) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(info.updateCount == 0 && info.ageMs[0] == DJI_TEST_FC_SUBSCRIPTION_SNAPSHOT_AGE_INVALID);
+
+    velocity.data.x = 3.0f;
+    velocity.data.y = 3.0f;
+    velocity.data.z = 3.0f;
+    MODULE_TEST_CHECK(DjiTest_FcStubPublish(DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION, &quaternion, sizeof(quaternion),
+                                            100));
+    MODULE_TEST_CHECK(DjiTest_FcStubPublish(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY, &velocity, sizeof(velocity), 110));
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionSnapshotGet(&snapshot, sizeof(snapshot), &info) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(memcmp(&snapshot.quaternion, &quaternion, sizeof(quaternion)) == 0 &&
+                      snapshot.velocity.data.x == 3.0f);
+    MODULE_TEST_CHECK(info.updateCount == 2 && info.timestampUs[0] == 100000 && info.timestampUs[1] == 110000 &&
+                      info.ageMs[1] != DJI_TEST_FC_SUBSCRIPTION_SNAPSHOT_AGE_INVALID);
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionCacheGetLatest(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY, (uint8_t *) &velocity,
+                                                           sizeof(velocity), NULL, NULL) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(velocity.data.x == 3.0f);
+
+    if (pthread_create(&publishTask, NULL, DjiTest_FcVelocityPublishTask, &publisher) != 0) {
+        MODULE_TEST_CHECK(false);
+    } else {
+        startTimeUs = ModuleTest_GetTimeUs();
+        while (ModuleTest_GetTimeUs() - startTimeUs < TEST_FC_SNAPSHOT_TORN_RUN_TIME_MS * 1000) {
+            returnCode = DjiTest_FcSubscriptionSnapshotGet(&snapshot, sizeof(snapshot), NULL);
+            if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_BUSY) {
+                busyCount++;
+            } else if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+                readCount++;
+                if (snapshot.velocity.data.x != snapshot.velocity.data.y ||
+                    snapshot.velocity.data.x != snapshot.velocity.data.z) {
+                    tornCount++;
+                }
+            }
+        }
+        __atomic_store_n(&publisher.stopRequest, true, __ATOMIC_RELEASE);
+        pthread_join(publishTask, NULL);
+    }
+
+    //the cache keeps velocity after the snapshot is gone
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionSnapshotDeInit() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_FcStubFind(DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION) == NULL);
+    MODULE_TEST_CHECK(DjiTest_FcStubPublish(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY, &velocity, sizeof(velocity), 1));
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionCacheDeInit() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_FcStubFind(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY) == NULL);
+
+    MODULE_TEST_CHECK(readCount > 0 && tornCount == 0);
+    ModuleTest_Report("snapshot torn test samples written", publisher.sampleCount, "samples");
+    ModuleTest_Report("snapshot torn test reads", readCount, "reads");
+    ModuleTest_Report("snapshot torn test busy reads", busyCount, "reads");
+}
+
+/**
+ * @brief The recorder, the cache and the snapshot consume velocity together, the recorder is stopped while
+ * samples are still delivered and its record must hold every sample it counted, none of them torn.
+ */
+static void DjiTest_FcDispatcherTestRecorder(void)
+{
+    const T_DjiTestFcRecorderTopicConfig recorderTopics[] = {
+        {DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY, DJI_DATA_SUBSCRIPTION_TOPIC_200_HZ},
+        {DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION, DJI_DATA_SUBSCRIPTION_TOPIC_50_HZ},
+    };
+    const T_DjiTestFcSubscriptionSnapshotTopicConfig snapshotConfig = {
+        DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY, DJI_DATA_SUBSCRIPTION_TOPIC_50_HZ,
+        sizeof(T_DjiFcSubscriptionVelocity), offsetof(T_TestFcSnapshot, velocity),
+    };
+    T_DjiTestFcSubscriptionCacheTopicConfig cacheConfig = {
+        .topic = DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY,
+        .frequency = DJI_DATA_SUBSCRIPTION_TOPIC_100_HZ,
+        .dataSize = sizeof(T_DjiFcSubscriptionVelocity),
+        .depth = TEST_FC_CACHE_DEPTH,
+        .interpolate = NULL,
+    };
+    T_DjiTestFcRecorderStatistics recorderStatistics = {0};
+    T_DjiTestFcRecordReaderStatistics readerStatistics = {0};
+    T_DjiTestFcRecordReaderHandle reader = NULL;
+    T_DjiTestFcRecorderHandle recorder = NULL;
+    T_DjiFcSubscriptionQuaternion quaternion = {1.0f, 0, 0, 0};
+    const T_DjiFcSubscriptionVelocity *velocity;
+    T_DjiTestFcRecordSample sample;
+    T_TestFcPublisher publisher = {0};
+    pthread_t publishTask;
+    uint64_t velocityCount = 0;
+    uint64_t quaternionCount = 0;
+    uint32_t tornCount = 0;
+    dji_f32_t lastVelocity = -1.0f;
+    uint32_t disorderCount = 0;
+
+    remove(TEST_FC_RECORDER_SEGMENT_PATH);
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionCacheInit(&cacheConfig, 1) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionSnapshotInit(&snapshotConfig, 1, sizeof(T_TestFcSnapshot)) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_FcRecorderStart(TEST_FC_RECORDER_PATH_PREFIX, recorderTopics,
+                                              UTIL_ARRAY_SIZE(recorderTopics), NULL, &recorder) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    if (recorder == NULL) {
+        DjiTest_FcSubscriptionSnapshotDeInit();
+        DjiTest_FcSubscriptionCacheDeInit();
+        return;
+    }
+    MODULE_TEST_CHECK(DjiTest_FcStubFind(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY)->frequency ==
+                      DJI_DATA_SUBSCRIPTION_TOPIC_200_HZ);
+
+    if (pthread_create(&publishTask, NULL, DjiTest_FcVelocityPublishTask, &publisher) != 0) {
+        MODULE_TEST_CHECK(false);
+        DjiTest_FcRecorderStop(recorder);
+        DjiTest_FcSubscriptionSnapshotDeInit();
+        DjiTest_FcSubscriptionCacheDeInit();
+        return;
+    }
+    MODULE_TEST_CHECK(DjiTest_FcStubPublish(DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION, &quaternion, sizeof(quaternion),
+                                            1));
+    usleep(TEST_FC_RECORDER_RUN_TIME_MS * 1000);
+    MODULE_TEST_CHECK(DjiTest_FcStubPublish(DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION, &quaternion, sizeof(quaternion),
+                                            2));
+
+    //stopped while the publisher keeps delivering, the other consumers keep velocity subscribed
+    DjiTest_FcRecorderGetStatistics(recorder, &recorderStatistics);
+    MODULE_TEST_CHECK(DjiTest_FcRecorderStop(recorder) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_FcStubFind(DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION) == NULL);
+    MODULE_TEST_CHECK(DjiTest_FcStubFind(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY) != NULL);
+
+    __atomic_store_n(&publisher.stopRequest, true, __ATOMIC_RELEASE);
+    pthread_join(publishTask, NULL);
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionSnapshotDeInit() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionCacheDeInit() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_FcStubFind(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY) == NULL);
+
+    MODULE_TEST_CHECK(DjiTest_FcRecordReaderOpen(TEST_FC_RECORDER_SEGMENT_PATH, &reader) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    if (reader == NULL) {
+        return;
+    }
+    while (DjiTest_FcRecordReaderNext(reader, &sample) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        if (sample.topic == DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION) {
+            quaternionCount++;
+            continue;
+        }
+        velocityCount++;
+        velocity = (const T_DjiFcSubscriptionVelocity *) sample.data;
+        if (velocity->data.x != velocity->data.y || velocity->data.x != velocity->data.z) {
+            tornCount++;
+        }
+        if (velocity->data.x <= lastVelocity) {
+            disorderCount++;
+        }
+        lastVelocity = velocity->data.x;
+    }
+    DjiTest_FcRecordReaderGetStatistics(reader, &readerStatistics);
+    DjiTest_FcRecordReaderClose(reader);
+    remove(TEST_FC_RECORDER_SEGMENT_PATH);
+
+    MODULE_TEST_CHECK(readerStatistics.indexed && readerStatistics.corruptBlockCount == 0);
+    MODULE_TEST_CHECK(quaternionCount == 2 && velocityCount > 0);
+    MODULE_TEST_CHECK(velocityCount + quaternionCount >= recorderStatistics.sampleCount);
+    MODULE_TEST_CHECK(tornCount == 0 && disorderCount == 0);
+    ModuleTest_Report("recorder test samples recorded", (double) (velocityCount + quaternionCount), "samples");
+}
+
+/**
+ * @brief Cost of one sample from the subscription callback through the dispatcher, to one and to all consumers
+ * of a topic, and of the cache update and read.
+ */
+static void DjiTest_FcDispatcherBenchmark(void)
+{
+    T_DjiTestFcSubscriptionCacheTopicConfig cacheConfig = {
+        .topic = DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY,
+        .frequency = DJI_DATA_SUBSCRIPTION_TOPIC_400_HZ,
+        .dataSize = sizeof(T_DjiFcSubscriptionVelocity),
+        .depth = 0,
+        .interpolate = NULL,
+    };
+    T_DjiTestFcSubscriptionConsumerHandle handles[DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CONSUMER_MAX];
+    T_TestFcConsumer consumers[DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CONSUMER_MAX];
+    T_DjiFcSubscriptionQuaternion quaternion = {1.0f, 0, 0, 0};
+    T_DjiFcSubscriptionVelocity velocity = {0};
+    DjiReceiveDataOfTopicCallback callback;
+    T_DjiDataTimestamp timestamp = {0};
+    uint64_t startTimeUs;
+    uint32_t consumerCount;
+    uint32_t i;
+    char name[64];
+
+    memset(consumers, 0, sizeof(consumers));
+    for (consumerCount = 1; consumerCount <= DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CONSUMER_MAX; consumerCount++) {
+        MODULE_TEST_CHECK(DjiTest_FcSubscriptionDispatcherRegister(DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION,
+                                                                   DJI_DATA_SUBSCRIPTION_TOPIC_400_HZ,
+                                                                   DjiTest_FcConsumerCallback,
+                                                                   &consumers[consumerCount - 1],
+                                                                   &handles[consumerCount - 1]) ==
+                          DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+        if (consumerCount != 1 && consumerCount != DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CONSUMER_MAX) {
+            continue;
+        }
+
+        callback = DjiTest_FcStubFind(DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION)->callback;
+        startTimeUs = ModuleTest_GetTimeUs();
+        for (i = 0; i < TEST_FC_BENCH_SAMPLE_COUNT; i++) {
+            timestamp.millisecond = i;
+            callback((const uint8_t *) &quaternion, sizeof(quaternion), &timestamp);
+        }
+        snprintf(name, sizeof(name), "dispatch to %u consumers", consumerCount);
+        ModuleTest_Report(name, (double) (ModuleTest_GetTimeUs() - startTimeUs) * 1000 / TEST_FC_BENCH_SAMPLE_COUNT,
+                          "ns/sample");
+    }
+    for (i = 0; i < DJI_TEST_FC_SUBSCRIPTION_DISPATCHER_CONSUMER_MAX; i++) {
+        MODULE_TEST_CHECK(consumers[i].callCount > 0);
+        DjiTest_FcSubscriptionDispatcherUnregister(handles[i]);
+    }
+
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionCacheInit(&cacheConfig, 1) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    callback = DjiTest_FcStubFind(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY)->callback;
+    startTimeUs = ModuleTest_GetTimeUs();
+    for (i = 0; i < TEST_FC_BENCH_SAMPLE_COUNT; i++) {
+        timestamp.millisecond = i;
+        callback((const uint8_t *) &velocity, sizeof(velocity), &timestamp);
+    }
+    ModuleTest_Report("cache update", (double) (ModuleTest_GetTimeUs() - startTimeUs) * 1000 /
+                                      TEST_FC_BENCH_SAMPLE_COUNT, "ns/sample");
+
+    startTimeUs = ModuleTest_GetTimeUs();
+    for (i = 0; i < TEST_FC_BENCH_SAMPLE_COUNT; i++) {
+        DjiTest_FcSubscriptionCacheGetLatest(DJI_FC_SUBSCRIPTION_TOPIC_VELOCITY, (uint8_t *) &velocity,
+                                             sizeof(velocity), NULL, NULL);
+    }
+    ModuleTest_Report("cache latest read", (double) (ModuleTest_GetTimeUs() - startTimeUs) * 1000 /
+                                           TEST_FC_BENCH_SAMPLE_COUNT, "ns/read");
+    MODULE_TEST_CHECK(DjiTest_FcSubscriptionCacheDeInit() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,346 @@
+/**
+ ********************************************************************
+ * @file    test_media_file_read.c
+ * @brief   Test and benchmark of the original data scatter read of the media file core.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+#include "module_test.h"
+#include "utils/util_misc.h"
+#include "camera_emu/dji_media_file_manage/dji_media_file_core.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define TEST_MEDIA_FILE_JPG_PATH                "test_media_file_read.jpg"
+#define TEST_MEDIA_FILE_MP4_PATH                "test_media_file_read.mp4"
+#define TEST_MEDIA_FILE_CHECK_SIZE              (4 * 1024 * 1024 + 4321)
+#define TEST_MEDIA_FILE_CHECK_ROUNDS            200
+#define TEST_MEDIA_FILE_CHECK_IOV_MAX           40
+#define TEST_MEDIA_FILE_CHECK_IOV_LEN_MAX       (160 * 1024)
+#define TEST_MEDIA_FILE_BENCH_CHUNK_SIZE        (1024 * 1024)
+#define TEST_MEDIA_FILE_BENCH_IOV_COUNT         16
+#define TEST_MEDIA_FILE_BENCH_LEGACY_LEN        UINT16_MAX
+#define TEST_MEDIA_FILE_MB                      (1024 * 1024)
+
+/* Private types -------------------------------------------------------------*/
+typedef enum {
+    TEST_MEDIA_FILE_READ_VEC = 0,
+    TEST_MEDIA_FILE_READ_VEC_FALLBACK,
+    TEST_MEDIA_FILE_READ_LEGACY,
+} E_TestMediaFileReadMode;
+
+/* Private values -------------------------------------------------------------*/
+static uint32_t s_randomState = 0x2545F491;
+static uint8_t *s_fileData = NULL;
+static uint8_t *s_readData = NULL;
+
+/* Private functions declaration ---------------------------------------------*/
+static uint32_t DjiTest_MediaFileRandom(void);
+static void DjiTest_MediaFileFill(uint8_t *data, uint32_t len, uint64_t offset);
+static bool DjiTest_MediaFileMakeFile(const char *path, uint64_t size);
+static void DjiTest_MediaFileTestRead(const char *path, bool isFallback);
+static void DjiTest_MediaFileTestLegacy(const char *path);
+static void DjiTest_MediaFileBenchmark(uint32_t sizeMb);
+static double DjiTest_MediaFileBenchmarkRead(T_DjiMediaFileHandle handle, uint64_t size, E_TestMediaFileReadMode mode);
+
+/* Exported functions definition ---------------------------------------------*/
+/**
+ * @brief Run the checks and benchmark 4 MB and 64 MB files, file sizes in MB given as arguments replace the
+ * benchmark sizes, for example 1024 for a 1 GB file.
+ */
+int main(int argc, char **argv)
+{
+    int i;
+
+    if (ModuleTest_Init() != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        printf("register osal handler failed\r\n");
+        return 1;
+    }
+
+    s_fileData = malloc(TEST_MEDIA_FILE_CHECK_SIZE);
+    s_readData = malloc(TEST_MEDIA_FILE_CHECK_SIZE);
+    if (s_fileData == NULL || s_readData == NULL) {
+        printf("malloc test buffers failed\r\n");
+        return 1;
+    }
+    DjiTest_MediaFileFill(s_fileData, TEST_MEDIA_FILE_CHECK_SIZE, 0);
+
+    MODULE_TEST_CHECK(DjiTest_MediaFileMakeFile(TEST_MEDIA_FILE_JPG_PATH, TEST_MEDIA_FILE_CHECK_SIZE));
+    MODULE_TEST_CHECK(DjiTest_MediaFileMakeFile(TEST_MEDIA_FILE_MP4_PATH, TEST_MEDIA_FILE_CHECK_SIZE));
+    DjiTest_MediaFileTestRead(TEST_MEDIA_FILE_JPG_PATH, false);
+    DjiTest_MediaFileTestRead(TEST_MEDIA_FILE_MP4_PATH, false);
+    DjiTest_MediaFileTestRead(TEST_MEDIA_FILE_JPG_PATH, true);
+    DjiTest_MediaFileTestLegacy(TEST_MEDIA_FILE_JPG_PATH);
+    remove(TEST_MEDIA_FILE_JPG_PATH);
+    remove(TEST_MEDIA_FILE_MP4_PATH);
+
+    if (argc > 1) {
+        for (i = 1; i < argc; i++) {
+            DjiTest_MediaFileBenchmark((uint32_t) strtoul(argv[i], NULL, 10));
+        }
+    } else {
+        DjiTest_MediaFileBenchmark(4);
+        DjiTest_MediaFileBenchmark(64);
+    }
+
+    free(s_fileData);
+    free(s_readData);
+
+    return ModuleTest_Finish("test_media_file_read");
+}
+
+/* Private functions definition-----------------------------------------------*/
+static uint32_t DjiTest_MediaFileRandom(void)
+{
+    s_randomState = s_randomState * 1103515245 + 12345;
+
+    return s_randomState >> 8;
+}
+
+/**
+ * @brief Content is a function of the file offset, so any window of a file can be checked without the whole file.
+ */
+static void DjiTest_MediaFileFill(uint8_t *data, uint32_t len, uint64_t offset)
+{
+    uint32_t i;
+
+    for (i = 0; i < len; i++) {
+        data[i] = (uint8_t) (((offset + i) * 2654435761u) >> 13);
+    }
+}
+
+static bool DjiTest_MediaFileMakeFile(const char *path, uint64_t size)
+{
+    uint8_t *chunk;
+    FILE *file;
+    uint64_t offset;
+    uint32_t len;
+    bool result = true;
+
+    chunk = malloc(TEST_MEDIA_FILE_MB);
+    file = fopen(path, "wb");
+    if (chunk == NULL || file == NULL) {
+        free(chunk);
+        if (file != NULL) {
+            fclose(file);
+        }
+        return false;
+    }
+
+    for (offset = 0; offset < size && result; offset += len) {
+        len = (uint32_t) USER_UTIL_MIN(size - offset, TEST_MEDIA_FILE_MB);
+        DjiTest_MediaFileFill(chunk, len, offset);
+        result = fwrite(chunk, 1, len, file) == len;
+    }
+
+    free(chunk);
+
+    return fclose(file) == 0 && result;
+}
+
+/**
+ * @brief Read random windows into random buffer lists, with empty buffers, more buffers than one preadv call takes
+ * and windows past the end of file, and compare them with the file content.
+ */
+static void DjiTest_MediaFileTestRead(const char *path, bool isFallback)
+{
+    struct iovec iov[TEST_MEDIA_FILE_CHECK_IOV_MAX];
+    T_DjiMediaFileHandle handle = NULL;
+    T_DjiReturnCode returnCode;
+    uint32_t round;
+    uint32_t iovCount;
+    uint32_t offset;
+    uint32_t totalLen;
+    uint32_t expectLen;
+    uint32_t realLen;
+    uint32_t len;
+    uint32_t i;
+
+    returnCode = DjiMediaFile_CreateHandle(path, &handle);
+    MODULE_TEST_CHECK(returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return;
+    }
+    MODULE_TEST_CHECK(handle->mediaFileOptItem.getDataOrgVecFunc != NULL);
+    if (isFallback) {
+        handle->mediaFileOptItem.getDataOrgVecFunc = NULL;
+    }
+
+    for (round = 0; round < TEST_MEDIA_FILE_CHECK_ROUNDS; round++) {
+        iovCount = 1 + DjiTest_MediaFileRandom() % TEST_MEDIA_FILE_CHECK_IOV_MAX;
+        totalLen = 0;
+        for (i = 0; i < iovCount; i++) {
+            len = DjiTest_MediaFileRandom() % TEST_MEDIA_FILE_CHECK_IOV_LEN_MAX;
+            if (DjiTest_MediaFileRandom() % 4 == 0) {
+                len = 0;
+            }
+            len = USER_UTIL_MIN(len, TEST_MEDIA_FILE_CHECK_SIZE - totalLen);
+            iov[i].iov_base = s_readData + totalLen;
+            iov[i].iov_len = len;
+            totalLen += len;
+        }
+        offset = round % 8 == 0 ? TEST_MEDIA_FILE_CHECK_SIZE - DjiTest_MediaFileRandom() % (totalLen + 1) :
+                 DjiTest_MediaFileRandom() % TEST_MEDIA_FILE_CHECK_SIZE;
+        expectLen = USER_UTIL_MIN(totalLen, TEST_MEDIA_FILE_CHECK_SIZE - offset);
+
+        memset(s_readData, 0, totalLen);
+        realLen = 0;
+        returnCode = DjiMediaFile_GetDataOrgVec(handle, offset, iov, iovCount, &realLen);
+        if (expectLen == 0) {
+            MODULE_TEST_CHECK(returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+            continue;
+        }
+        MODULE_TEST_CHECK(returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+        MODULE_TEST_CHECK(realLen == expectLen);
+        MODULE_TEST_CHECK(memcmp(s_readData, s_fileData + offset, expectLen) == 0);
+    }
+
+    //one buffer larger than the 64 KB of getDataOrgFunc, the whole file in one call
+    iov[0].iov_base = s_readData;
+    iov[0].iov_len = TEST_MEDIA_FILE_CHECK_SIZE;
+    realLen = 0;
+    returnCode = DjiMediaFile_GetDataOrgVec(handle, 0, iov, 1, &realLen);
+    MODULE_TEST_CHECK(returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(realLen == TEST_MEDIA_FILE_CHECK_SIZE);
+    MODULE_TEST_CHECK(memcmp(s_readData, s_fileData, TEST_MEDIA_FILE_CHECK_SIZE) == 0);
+
+    DjiMediaFile_DestroyHandle(handle);
+}
+
+/**
+ * @brief The old entry is an adapter of the scatter read, it keeps its 16-bit length and short read at end of file.
+ */
+static void DjiTest_MediaFileTestLegacy(const char *path)
+{
+    T_DjiMediaFileHandle handle = NULL;
+    T_DjiReturnCode returnCode;
+    uint32_t realLen = 0;
+
+    returnCode = DjiMediaFile_CreateHandle(path, &handle);
+    MODULE_TEST_CHECK(returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return;
+    }
+
+    returnCode = DjiMediaFile_GetDataOrg(handle, 12345, UINT16_MAX, s_readData, &realLen);
+    MODULE_TEST_CHECK(returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(realLen == UINT16_MAX);
+    MODULE_TEST_CHECK(memcmp(s_readData, s_fileData + 12345, UINT16_MAX) == 0);
+
+    realLen = 0;
+    returnCode = DjiMediaFile_GetDataOrg(handle, TEST_MEDIA_FILE_CHECK_SIZE - 100, 1000, s_readData, &realLen);
+    MODULE_TEST_CHECK(returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(realLen == 100);
+    MODULE_TEST_CHECK(memcmp(s_readData, s_fileData + TEST_MEDIA_FILE_CHECK_SIZE - 100, 100) == 0);
+
+    returnCode = DjiMediaFile_GetDataOrg(handle, TEST_MEDIA_FILE_CHECK_SIZE, 1000, s_readData, &realLen);
+    MODULE_TEST_CHECK(returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+    DjiMediaFile_DestroyHandle(handle);
+}
+
+/**
+ * @brief Read a whole file in 1 MB chunks of 16 buffers through the scatter read and through its 64 KB fallback,
+ * and in 64 KB calls of the old entry as a download did before the scatter read.
+ */
+static void DjiTest_MediaFileBenchmark(uint32_t sizeMb)
+{
+    T_DjiMediaFileHandle handle = NULL;
+    char name[64];
+    uint64_t size = (uint64_t) sizeMb * TEST_MEDIA_FILE_MB;
+    double throughput;
+
+    if (sizeMb == 0 || size > UINT32_MAX) {
+        printf("benchmark file size %u MB out of range\r\n", sizeMb);
+        return;
+    }
+    if (!DjiTest_MediaFileMakeFile(TEST_MEDIA_FILE_JPG_PATH, size)) {
+        MODULE_TEST_CHECK(false);
+        remove(TEST_MEDIA_FILE_JPG_PATH);
+        return;
+    }
+    if (DjiMediaFile_CreateHandle(TEST_MEDIA_FILE_JPG_PATH, &handle) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        MODULE_TEST_CHECK(false);
+        remove(TEST_MEDIA_FILE_JPG_PATH);
+        return;
+    }
+
+    //first pass warms the page cache, so all modes read from memory
+    DjiTest_MediaFileBenchmarkRead(handle, size, TEST_MEDIA_FILE_READ_VEC);
+
+    throughput = DjiTest_MediaFileBenchmarkRead(handle, size, TEST_MEDIA_FILE_READ_LEGACY);
+    snprintf(name, sizeof(name), "%u MB, 64 KB getDataOrg calls", sizeMb);
+    ModuleTest_Report(name, throughput, "MB/s");
+
+    throughput = DjiTest_MediaFileBenchmarkRead(handle, size, TEST_MEDIA_FILE_READ_VEC_FALLBACK);
+    snprintf(name, sizeof(name), "%u MB, 1 MB scatter read, fallback", sizeMb);
+    ModuleTest_Report(name, throughput, "MB/s");
+
+    throughput = DjiTest_MediaFileBenchmarkRead(handle, size, TEST_MEDIA_FILE_READ_VEC);
+    snprintf(name, sizeof(name), "%u MB, 1 MB scatter read", sizeMb);
+    ModuleTest_Report(name, throughput, "MB/s");
+
+    DjiMediaFile_DestroyHandle(handle);
+    remove(TEST_MEDIA_FILE_JPG_PATH);
+}
+
+static double DjiTest_MediaFileBenchmarkRead(T_DjiMediaFileHandle handle, uint64_t size, E_TestMediaFileReadMode mode)
+{
+    struct iovec iov[TEST_MEDIA_FILE_BENCH_IOV_COUNT];
+    T_DjiMediaFileOptItem optItem = handle->mediaFileOptItem;
+    uint32_t iovLen = TEST_MEDIA_FILE_BENCH_CHUNK_SIZE / TEST_MEDIA_FILE_BENCH_IOV_COUNT;
+    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    uint64_t offset = 0;
+    uint64_t startTimeUs;
+    uint64_t elapsedUs;
+    uint32_t realLen = 0;
+    uint32_t i;
+
+    for (i = 0; i < TEST_MEDIA_FILE_BENCH_IOV_COUNT; i++) {
+        iov[i].iov_base = s_readData + i * iovLen;
+        iov[i].iov_len = iovLen;
+    }
+    if (mode == TEST_MEDIA_FILE_READ_VEC_FALLBACK) {
+        handle->mediaFileOptItem.getDataOrgVecFunc = NULL;
+    }
+
+    startTimeUs = ModuleTest_GetTimeUs();
+    while (offset < size && returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        if (mode == TEST_MEDIA_FILE_READ_LEGACY) {
+            returnCode = DjiMediaFile_GetDataOrg(handle, (uint32_t) offset, TEST_MEDIA_FILE_BENCH_LEGACY_LEN,
+                                                 s_readData, &realLen);
+        } else {
+            returnCode = DjiMediaFile_GetDataOrgVec(handle, (uint32_t) offset, iov, TEST_MEDIA_FILE_BENCH_IOV_COUNT,
+                                                    &realLen);
+        }
+        offset += realLen;
+    }
+    elapsedUs = ModuleTest_GetTimeUs() - startTimeUs;
+
+    handle->mediaFileOptItem = optItem;
+    MODULE_TEST_CHECK(returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(offset == size);
+
+    return (double) size / TEST_MEDIA_FILE_MB / ((double) USER_UTIL_MAX(elapsedUs, 1) / 1000000.0);
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
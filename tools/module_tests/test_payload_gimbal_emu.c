@@ -0,0 +1,430 @@
+/**
+ ********************************************************************
+ * @file    test_payload_gimbal_emu.c
+ * @brief   Test of the gimbal emulator callbacks and benchmark of its 1 kHz loop timing under CPU load.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "module_test.h"
+#include "dji_fc_subscription.h"
+#include "gimbal_emu/test_payload_gimbal_emu.h"
+#include "utils/util_time.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define TEST_GIMBAL_WAIT_TIMEOUT_MS             2000
+#define TEST_GIMBAL_BENCH_PERIOD_NS             1000000ULL
+#define TEST_GIMBAL_BENCH_PERIOD_NUM            1000
+#define TEST_GIMBAL_BENCH_LOAD_THREAD_MAX       16
+#define TEST_GIMBAL_BENCH_READ_NUM              1000000
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    double p50Us;
+    double p99Us;
+    double p999Us;
+    double maxUs;
+    double driftUs;
+} T_TestGimbalJitter;
+
+/* Private values -------------------------------------------------------------*/
+static T_DjiGimbalCommonHandler s_commonHandler;
+static bool s_commonHandlerRegistered = false;
+static bool s_loadStop = false;
+
+/* Private functions declaration ---------------------------------------------*/
+static bool DjiTest_GimbalWaitAttitude(int32_t pitch, int32_t roll);
+static bool DjiTest_GimbalWaitMode(E_DjiGimbalMode mode);
+static void DjiTest_GimbalTestValidation(void);
+static void DjiTest_GimbalTestRotation(void);
+static void DjiTest_GimbalTestSettings(void);
+static int DjiTest_GimbalCompareUs(const void *a, const void *b);
+static void DjiTest_GimbalMeasureLoop(bool pacer, T_TestGimbalJitter *jitter);
+static void *DjiTest_GimbalLoadTask(void *arg);
+static void DjiTest_GimbalBenchmarkJitter(void);
+static void DjiTest_GimbalBenchmarkRead(void);
+T_DjiReturnCode __wrap_DjiFcSubscription_Init(void);
+T_DjiReturnCode __wrap_DjiFcSubscription_SubscribeTopic(E_DjiFcSubscriptionTopic topic,
+                                                        E_DjiDataSubscriptionTopicFreq frequency,
+                                                        DjiReceiveDataOfTopicCallback callback);
+T_DjiReturnCode __wrap_DjiFcSubscription_GetLatestValueOfTopic(E_DjiFcSubscriptionTopic topic,
+                                                               uint8_t *data, uint16_t dataSizeOfTopic,
+                                                               T_DjiDataTimestamp *timestamp);
+T_DjiReturnCode __wrap_DjiGimbal_Init(void);
+T_DjiReturnCode __wrap_DjiGimbal_DeInit(void);
+T_DjiReturnCode __wrap_DjiGimbal_RegCommonHandler(const T_DjiGimbalCommonHandler *commonHandler);
+void DjiTest_WidgetLogAppend(const char *fmt, ...);
+
+/* Exported functions definition ---------------------------------------------*/
+int main(void)
+{
+    if (ModuleTest_Init() != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        printf("register osal handler failed\r\n");
+        return 1;
+    }
+
+    MODULE_TEST_CHECK(DjiTest_GimbalStartService() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(s_commonHandlerRegistered);
+    if (!s_commonHandlerRegistered) {
+        return ModuleTest_Finish("test_payload_gimbal_emu");
+    }
+
+    DjiTest_GimbalTestValidation();
+    DjiTest_GimbalTestRotation();
+    DjiTest_GimbalTestSettings();
+    DjiTest_GimbalBenchmarkRead();
+    MODULE_TEST_CHECK(DjiTest_GimbalDeInit() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+    DjiTest_GimbalBenchmarkJitter();
+
+    return ModuleTest_Finish("test_payload_gimbal_emu");
+}
+
+T_DjiReturnCode __wrap_DjiFcSubscription_Init(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode __wrap_DjiFcSubscription_SubscribeTopic(E_DjiFcSubscriptionTopic topic,
+                                                        E_DjiDataSubscriptionTopicFreq frequency,
+                                                        DjiReceiveDataOfTopicCallback callback)
+{
+    (void) topic;
+    (void) frequency;
+    (void) callback;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief The aircraft stays level and points north.
+ */
+T_DjiReturnCode __wrap_DjiFcSubscription_GetLatestValueOfTopic(E_DjiFcSubscriptionTopic topic,
+                                                               uint8_t *data, uint16_t dataSizeOfTopic,
+                                                               T_DjiDataTimestamp *timestamp)
+{
+    T_DjiFcSubscriptionQuaternion quaternion = {1, 0, 0, 0};
+
+    if (topic != DJI_FC_SUBSCRIPTION_TOPIC_QUATERNION || dataSizeOfTopic != sizeof(quaternion)) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    memcpy(data, &quaternion, sizeof(quaternion));
+    memset(timestamp, 0, sizeof(T_DjiDataTimestamp));
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode __wrap_DjiGimbal_Init(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode __wrap_DjiGimbal_DeInit(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Keep the callbacks, the test calls them as the SDK would.
+ */
+T_DjiReturnCode __wrap_DjiGimbal_RegCommonHandler(const T_DjiGimbalCommonHandler *commonHandler)
+{
+    s_commonHandler = *commonHandler;
+    s_commonHandlerRegistered = true;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/* The widget log is not linked, the emulator only appends to it. */
+void DjiTest_WidgetLogAppend(const char *fmt, ...)
+{
+    (void) fmt;
+}
+
+/* Private functions definition-----------------------------------------------*/
+static bool DjiTest_GimbalWaitAttitude(int32_t pitch, int32_t roll)
+{
+    T_DjiGimbalAttitudeInformation attitudeInformation;
+    uint32_t i;
+
+    for (i = 0; i < TEST_GIMBAL_WAIT_TIMEOUT_MS; i++) {
+        if (s_commonHandler.GetAttitudeInformation(&attitudeInformation) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS &&
+            attitudeInformation.attitude.pitch == pitch && attitudeInformation.attitude.roll == roll) {
+            return true;
+        }
+        usleep(1000);
+    }
+
+    return false;
+}
+
+static bool DjiTest_GimbalWaitMode(E_DjiGimbalMode mode)
+{
+    T_DjiGimbalSystemState systemState;
+    uint32_t i;
+
+    for (i = 0; i < TEST_GIMBAL_WAIT_TIMEOUT_MS; i++) {
+        if (s_commonHandler.GetSystemState(&systemState) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS &&
+            systemState.gimbalMode == mode) {
+            return true;
+        }
+        usleep(1000);
+    }
+
+    return false;
+}
+
+/**
+ * @brief Invalid requests are refused by the callback itself, with the error code the SDK receives.
+ */
+static void DjiTest_GimbalTestValidation(void)
+{
+    T_DjiGimbalRotationProperty rotationProperty = {0};
+    T_DjiAttitude3d rotationValue = {0};
+    T_DjiAttitude3d fineTuneAngle = {0, 0, 0};
+
+    MODULE_TEST_CHECK(s_commonHandler.SetMode((E_DjiGimbalMode) 3) == DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER);
+    MODULE_TEST_CHECK(s_commonHandler.Reset((E_DjiGimbalResetMode) 99) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER);
+    MODULE_TEST_CHECK(s_commonHandler.SetControllerSmoothFactor(31, DJI_GIMBAL_AXIS_PITCH) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER);
+    MODULE_TEST_CHECK(s_commonHandler.SetControllerSmoothFactor(5, DJI_GIMBAL_AXIS_ROLL) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT);
+    MODULE_TEST_CHECK(s_commonHandler.SetControllerMaxSpeedPercentage(0, DJI_GIMBAL_AXIS_YAW) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER);
+    MODULE_TEST_CHECK(s_commonHandler.SetControllerMaxSpeedPercentage(101, DJI_GIMBAL_AXIS_YAW) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER);
+    MODULE_TEST_CHECK(s_commonHandler.SetControllerMaxSpeedPercentage(50, DJI_GIMBAL_AXIS_ROLL) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT);
+    MODULE_TEST_CHECK(s_commonHandler.Rotate((E_DjiGimbalRotationMode) 7, rotationProperty, rotationValue) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT);
+
+    //beyond the 10 degrees roll joint limit the fine tune is clamped to it and reported out of range
+    fineTuneAngle.roll = 200;
+    MODULE_TEST_CHECK(s_commonHandler.FineTuneAngle(fineTuneAngle) == DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE);
+    MODULE_TEST_CHECK(DjiTest_GimbalWaitAttitude(0, 100));
+    fineTuneAngle.roll = -100;
+    MODULE_TEST_CHECK(s_commonHandler.FineTuneAngle(fineTuneAngle) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_GimbalWaitAttitude(0, 0));
+}
+
+/**
+ * @brief An absolute rotation reaches its target, a second one while it runs is accepted and ignored, a speed
+ * rotation stops at the joint limit.
+ */
+static void DjiTest_GimbalTestRotation(void)
+{
+    T_DjiGimbalRotationProperty rotationProperty = {0};
+    T_DjiAttitude3d rotationValue = {0};
+    T_DjiAttitude3d speed;
+    T_DjiGimbalAttitudeInformation attitudeInformation;
+
+    MODULE_TEST_CHECK(s_commonHandler.Reset(DJI_GIMBAL_RESET_MODE_PITCH_AND_YAW) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_GimbalWaitAttitude(0, 0));
+
+    rotationValue.pitch = -300;
+    rotationProperty.absoluteAngleRotation.actionTime = 50;
+    MODULE_TEST_CHECK(s_commonHandler.Rotate(DJI_GIMBAL_ROTATION_MODE_ABSOLUTE_ANGLE, rotationProperty,
+                                             rotationValue) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    usleep(50000);
+    MODULE_TEST_CHECK(s_commonHandler.GetRotationSpeed(&speed) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(speed.pitch == -601);
+    rotationValue.pitch = 200;
+    MODULE_TEST_CHECK(s_commonHandler.Rotate(DJI_GIMBAL_ROTATION_MODE_ABSOLUTE_ANGLE, rotationProperty,
+                                             rotationValue) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_GimbalWaitAttitude(-300, 0));
+    usleep(50000);
+    MODULE_TEST_CHECK(s_commonHandler.GetAttitudeInformation(&attitudeInformation) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(attitudeInformation.attitude.pitch == -300);
+
+    rotationValue.pitch = -1800;
+    MODULE_TEST_CHECK(s_commonHandler.Rotate(DJI_GIMBAL_ROTATION_MODE_SPEED, rotationProperty, rotationValue) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_GimbalWaitAttitude(-900, 0));
+    MODULE_TEST_CHECK(s_commonHandler.GetAttitudeInformation(&attitudeInformation) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(attitudeInformation.reachLimitFlag.pitch == false);
+}
+
+/**
+ * @brief Accepted settings show in the published state from the next period on.
+ */
+static void DjiTest_GimbalTestSettings(void)
+{
+    T_DjiGimbalSystemState systemState;
+    T_DjiGimbalCalibrationState calibrationState;
+
+    MODULE_TEST_CHECK(s_commonHandler.SetMode(DJI_GIMBAL_MODE_YAW_FOLLOW) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_GimbalWaitMode(DJI_GIMBAL_MODE_YAW_FOLLOW));
+    MODULE_TEST_CHECK(s_commonHandler.SetControllerSmoothFactor(30, DJI_GIMBAL_AXIS_YAW) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(s_commonHandler.SetControllerMaxSpeedPercentage(100, DJI_GIMBAL_AXIS_PITCH) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(s_commonHandler.StartCalibrate() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    usleep(20000);
+
+    MODULE_TEST_CHECK(s_commonHandler.GetSystemState(&systemState) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(systemState.smoothFactor.yaw == 30 && systemState.maxSpeedPercentage.pitch == 100);
+    MODULE_TEST_CHECK(s_commonHandler.GetCalibrationState(&calibrationState) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(calibrationState.calibratingFlag == true);
+
+    MODULE_TEST_CHECK(s_commonHandler.RestoreFactorySettings() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_GimbalWaitMode(DJI_GIMBAL_MODE_FREE));
+}
+
+static int DjiTest_GimbalCompareUs(const void *a, const void *b)
+{
+    double left = *(const double *) a;
+    double right = *(const double *) b;
+
+    return left < right ? -1 : (left > right ? 1 : 0);
+}
+
+/**
+ * @brief Run TEST_GIMBAL_BENCH_PERIOD_NUM empty 1 ms periods, with relative sleeps as the emulator did before or on
+ * the absolute deadline pacer, and take the error of each period against 1 ms.
+ */
+static void DjiTest_GimbalMeasureLoop(bool pacer, T_TestGimbalJitter *jitter)
+{
+    static double periodErrorUs[TEST_GIMBAL_BENCH_PERIOD_NUM];
+    T_DjiUtilTimePacer timePacer;
+    uint64_t startNs;
+    uint64_t lastNs;
+    uint64_t nowNs;
+    uint32_t i;
+
+    DjiUtilTime_PacerInit(&timePacer, TEST_GIMBAL_BENCH_PERIOD_NS);
+    startNs = DjiUtilTime_GetMonotonicTimeNs();
+    lastNs = startNs;
+    for (i = 0; i < TEST_GIMBAL_BENCH_PERIOD_NUM; i++) {
+        if (pacer) {
+            DjiUtilTime_PacerWait(&timePacer);
+        } else {
+            usleep(TEST_GIMBAL_BENCH_PERIOD_NS / 1000);
+        }
+        nowNs = DjiUtilTime_GetMonotonicTimeNs();
+        periodErrorUs[i] = ((double) (nowNs - lastNs) - TEST_GIMBAL_BENCH_PERIOD_NS) / 1000;
+        periodErrorUs[i] = periodErrorUs[i] >= 0 ? periodErrorUs[i] : -periodErrorUs[i];
+        lastNs = nowNs;
+    }
+
+    jitter->driftUs = ((double) (lastNs - startNs) - (double) TEST_GIMBAL_BENCH_PERIOD_NS *
+                                                     TEST_GIMBAL_BENCH_PERIOD_NUM) / 1000;
+    qsort(periodErrorUs, TEST_GIMBAL_BENCH_PERIOD_NUM, sizeof(double), DjiTest_GimbalCompareUs);
+    jitter->p50Us = periodErrorUs[TEST_GIMBAL_BENCH_PERIOD_NUM * 50 / 100];
+    jitter->p99Us = periodErrorUs[TEST_GIMBAL_BENCH_PERIOD_NUM * 99 / 100];
+    jitter->p999Us = periodErrorUs[TEST_GIMBAL_BENCH_PERIOD_NUM * 999 / 1000];
+    jitter->maxUs = periodErrorUs[TEST_GIMBAL_BENCH_PERIOD_NUM - 1];
+}
+
+static void *DjiTest_GimbalLoadTask(void *arg)
+{
+    volatile uint32_t counter = 0;
+
+    (void) arg;
+    while (!__atomic_load_n(&s_loadStop, __ATOMIC_ACQUIRE)) {
+        counter++;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Period error percentiles and drift of relative sleeps and of the pacer, idle and with one busy thread per
+ * CPU competing with the loop.
+ */
+static void DjiTest_GimbalBenchmarkJitter(void)
+{
+    pthread_t loadTasks[TEST_GIMBAL_BENCH_LOAD_THREAD_MAX];
+    T_TestGimbalJitter jitter;
+    long cpuNum = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t loadNum = 0;
+    uint32_t load;
+    uint32_t pacer;
+    char name[96];
+    uint32_t i;
+
+    cpuNum = cpuNum < 1 ? 1 : (cpuNum > TEST_GIMBAL_BENCH_LOAD_THREAD_MAX ? TEST_GIMBAL_BENCH_LOAD_THREAD_MAX : cpuNum);
+
+    for (load = 0; load < 2; load++) {
+        if (load == 1) {
+            __atomic_store_n(&s_loadStop, false, __ATOMIC_RELEASE);
+            for (loadNum = 0; loadNum < (uint32_t) cpuNum; loadNum++) {
+                if (pthread_create(&loadTasks[loadNum], NULL, DjiTest_GimbalLoadTask, NULL) != 0) {
+                    break;
+                }
+            }
+        }
+
+        for (pacer = 0; pacer < 2; pacer++) {
+            DjiTest_GimbalMeasureLoop(pacer == 1, &jitter);
+            snprintf(name, sizeof(name), "%s, %u busy threads", pacer == 1 ? "pacer" : "relative sleep", loadNum);
+            printf("  %s\r\n", name);
+            ModuleTest_Report("period error p50", jitter.p50Us, "us");
+            ModuleTest_Report("period error p99", jitter.p99Us, "us");
+            ModuleTest_Report("period error p99.9", jitter.p999Us, "us");
+            ModuleTest_Report("period error max", jitter.maxUs, "us");
+            ModuleTest_Report("drift over 1000 periods", jitter.driftUs, "us");
+
+            //idle, the pacer keeps the schedule within a few periods where relative sleeps add up their overshoot
+            if (pacer == 1 && load == 0) {
+                MODULE_TEST_CHECK(jitter.driftUs < 5 * TEST_GIMBAL_BENCH_PERIOD_NS / 1000);
+            }
+        }
+    }
+
+    __atomic_store_n(&s_loadStop, true, __ATOMIC_RELEASE);
+    for (i = 0; i < loadNum; i++) {
+        pthread_join(loadTasks[i], NULL);
+    }
+}
+
+/**
+ * @brief Cost of a getter while the gimbal task publishes every period.
+ */
+static void DjiTest_GimbalBenchmarkRead(void)
+{
+    T_DjiGimbalAttitudeInformation attitudeInformation;
+    uint32_t busyNum = 0;
+    uint64_t startTimeUs;
+    uint64_t elapsedUs;
+    uint32_t i;
+
+    startTimeUs = ModuleTest_GetTimeUs();
+    for (i = 0; i < TEST_GIMBAL_BENCH_READ_NUM; i++) {
+        if (s_commonHandler.GetAttitudeInformation(&attitudeInformation) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            busyNum++;
+        }
+    }
+    elapsedUs = ModuleTest_GetTimeUs() - startTimeUs;
+
+    ModuleTest_Report("attitude getter cost", (double) elapsedUs * 1000 / TEST_GIMBAL_BENCH_READ_NUM, "ns/call");
+    MODULE_TEST_CHECK(busyNum == 0);
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
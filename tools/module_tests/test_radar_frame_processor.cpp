@@ -0,0 +1,429 @@
+/**
+ ********************************************************************
+ * @file    test_radar_frame_processor.cpp
+ * @brief   Test and benchmark of the radar sweep conversion, gating and hand-off with synthetic radar packets.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <pthread.h>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "module_test.h"
+#include "dji_platform.h"
+#include "perception/dji_radar_frame_processor.hpp"
+
+/* Private constants ---------------------------------------------------------*/
+#define TEST_RADAR_POSITION_COUNT               6
+#define TEST_RADAR_BENCH_PACK_NUM               4
+#define TEST_RADAR_BENCH_UNITS_PER_PACK         256
+#define TEST_RADAR_BENCH_SWEEPS_PER_POSITION    2000
+#define TEST_RADAR_POSITION_TOLERANCE_M         0.02f
+#define TEST_RADAR_VELOCITY_OFFSET              32767
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    DJIRadarFrameProcessor *processors[TEST_RADAR_POSITION_COUNT];
+    T_DjiSemaHandle notifySema;
+    bool stopRequest;
+    uint64_t sweepCount;
+    uint64_t pointCount;
+    uint64_t latencySumUs;
+    uint64_t latencyMaxUs;
+} T_TestRadarConsumer;
+
+/* Private values -------------------------------------------------------------*/
+static const E_DjiPerceptionRadarPosition s_radarPositions[TEST_RADAR_POSITION_COUNT] = {
+    RADAR_POSITION_FRONT, RADAR_POSITION_BACK, RADAR_POSITION_LEFT, RADAR_POSITION_RIGHT, RADAR_POSITION_UP,
+    RADAR_POSITION_DOWN,
+};
+
+/* Private functions declaration ---------------------------------------------*/
+static T_DjiRadarCloudUnit DjiTest_RadarMakeUnit(float azimuthRad, float elevationRad, float radiusM,
+                                                 float velocityMps, uint8_t snr, uint16_t beamAngle, bool clutter);
+static std::vector<uint8_t> DjiTest_RadarMakePacket(uint8_t curPack, uint8_t packNum,
+                                                    const std::vector<T_DjiRadarCloudUnit> &units);
+static void DjiTest_RadarTestConversion(void);
+static void DjiTest_RadarTestGate(void);
+static void DjiTest_RadarTestLossAndOverflow(void);
+static void *DjiTest_RadarConsumerTask(void *arg);
+static void DjiTest_RadarBenchmark(void);
+
+/* Exported functions definition ---------------------------------------------*/
+int main(void)
+{
+    if (ModuleTest_Init() != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        printf("register osal handler failed\r\n");
+        return 1;
+    }
+
+    DjiTest_RadarTestConversion();
+    DjiTest_RadarTestGate();
+    DjiTest_RadarTestLossAndOverflow();
+    DjiTest_RadarBenchmark();
+
+    return ModuleTest_Finish("test_radar_frame_processor");
+}
+
+/* Private functions definition-----------------------------------------------*/
+/**
+ * @brief Encode a point as the radar does: angles in 0.001 rad steps of [0, 2 PI), radius in cm, velocity with
+ * an offset of 32767 in cm/s.
+ */
+static T_DjiRadarCloudUnit DjiTest_RadarMakeUnit(float azimuthRad, float elevationRad, float radiusM,
+                                                 float velocityMps, uint8_t snr, uint16_t beamAngle, bool clutter)
+{
+    T_DjiRadarCloudUnit unit;
+
+    memset(&unit, 0, sizeof(unit));
+    if (azimuthRad < 0) {
+        azimuthRad += 2 * (float) M_PI;
+    }
+    if (elevationRad < 0) {
+        elevationRad += 2 * (float) M_PI;
+    }
+    unit.azimuth = (uint16_t) lroundf(azimuthRad * 1000);
+    unit.elevation = (uint16_t) lroundf(elevationRad * 1000);
+    unit.radius = (uint16_t) lroundf(radiusM * 100);
+    unit.ene = 250;
+    unit.base_info.velocity = (uint16_t) (TEST_RADAR_VELOCITY_OFFSET + lroundf(velocityMps * 100));
+    unit.base_info.snr = snr;
+    unit.base_info.beamAngle = beamAngle;
+    unit.base_info.clitterFlag = clutter ? 1 : 0;
+
+    return unit;
+}
+
+static std::vector<uint8_t> DjiTest_RadarMakePacket(uint8_t curPack, uint8_t packNum,
+                                                    const std::vector<T_DjiRadarCloudUnit> &units)
+{
+    std::vector<uint8_t> packet(sizeof(T_DjiRadarDataHeader) + units.size() * sizeof(T_DjiRadarCloudUnit));
+    T_DjiRadarDataHeader header;
+
+    header.dataLen = (uint16_t) units.size();
+    header.curPack = curPack;
+    header.packNum = packNum;
+    memcpy(packet.data(), &header, sizeof(header));
+    if (!units.empty()) {
+        memcpy(packet.data() + sizeof(header), units.data(), units.size() * sizeof(T_DjiRadarCloudUnit));
+    }
+
+    return packet;
+}
+
+/**
+ * @brief Points on the axes and off them come out at x = r cos(e) cos(a), y = r cos(e) sin(a), z = r sin(e),
+ * the packets of a sweep are merged into one frame.
+ */
+static void DjiTest_RadarTestConversion(void)
+{
+    DJIRadarFrameProcessor processor(RADAR_POSITION_FRONT);
+    std::vector<T_DjiRadarCloudUnit> firstUnits;
+    std::vector<T_DjiRadarCloudUnit> secondUnits;
+    std::vector<uint8_t> packet;
+    T_DjiRadarPointCloud *frame;
+    float expected[5][3];
+    const float angles[5][2] = {{0, 0}, {(float) M_PI / 2, 0}, {0, (float) M_PI / 6}, {-0.7f, -0.2f}, {3.0f, 0.4f}};
+    const float radius = 25.0f;
+    uint32_t i;
+
+    MODULE_TEST_CHECK(processor.init() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+    for (i = 0; i < 5; i++) {
+        expected[i][0] = radius * cosf(angles[i][1]) * cosf(angles[i][0]);
+        expected[i][1] = radius * cosf(angles[i][1]) * sinf(angles[i][0]);
+        expected[i][2] = radius * sinf(angles[i][1]);
+        (i < 3 ? firstUnits : secondUnits).push_back(DjiTest_RadarMakeUnit(angles[i][0], angles[i][1], radius,
+                                                                           i * 0.5f - 1.0f, 10, 449, false));
+    }
+    secondUnits[1].base_info.beamAngle = 451;
+
+    packet = DjiTest_RadarMakePacket(1, 2, firstUnits);
+    MODULE_TEST_CHECK(processor.processPacket(packet.data(), packet.size()) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(processor.acquireFrame() == nullptr);
+    packet = DjiTest_RadarMakePacket(2, 2, secondUnits);
+    MODULE_TEST_CHECK(processor.processPacket(packet.data(), packet.size()) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+    frame = processor.waitFrame(0);
+    MODULE_TEST_CHECK(frame != nullptr);
+    if (frame == nullptr) {
+        return;
+    }
+    MODULE_TEST_CHECK(frame->position == RADAR_POSITION_FRONT && frame->sequence == 0);
+    MODULE_TEST_CHECK(frame->packNum == 2 && frame->receivedPackNum == 2);
+    MODULE_TEST_CHECK(frame->rawPointCount == 5 && frame->pointCount == 5);
+    for (i = 0; i < frame->pointCount && i < 5; i++) {
+        MODULE_TEST_CHECK(fabsf(frame->x[i] - expected[i][0]) < TEST_RADAR_POSITION_TOLERANCE_M &&
+                          fabsf(frame->y[i] - expected[i][1]) < TEST_RADAR_POSITION_TOLERANCE_M &&
+                          fabsf(frame->z[i] - expected[i][2]) < TEST_RADAR_POSITION_TOLERANCE_M);
+        MODULE_TEST_CHECK(fabsf(frame->velocity[i] - (i * 0.5f - 1.0f)) < 0.001f);
+        MODULE_TEST_CHECK(fabsf(frame->energy[i] - 2.5f) < 0.001f && frame->snr[i] == 10);
+    }
+    MODULE_TEST_CHECK(fabsf(frame->beamAngle[0] - 44.9f) < 0.001f && fabsf(frame->beamAngle[4] + 44.9f) < 0.001f);
+    processor.releaseFrame(frame);
+    MODULE_TEST_CHECK(processor.acquireFrame() == nullptr);
+}
+
+/**
+ * @brief Null points, clutter, slow and fast targets and targets out of range are dropped when gated.
+ */
+static void DjiTest_RadarTestGate(void)
+{
+    DJIRadarFrameProcessor processor(RADAR_POSITION_LEFT);
+    T_DjiRadarFrameProcessorStatistics statistics;
+    T_DjiRadarGateConfig gateConfig;
+    std::vector<T_DjiRadarCloudUnit> units;
+    std::vector<uint8_t> packet;
+    T_DjiRadarPointCloud *frame;
+
+    MODULE_TEST_CHECK(processor.init() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    DjiRadarFrameProcessor_GetDefaultGateConfig(&gateConfig);
+    gateConfig.dropClutter = true;
+    gateConfig.minAbsVelocity = 0.5f;
+    gateConfig.maxAbsVelocity = 20.0f;
+    gateConfig.minRadius = 1.0f;
+    gateConfig.maxRadius = 100.0f;
+    processor.setGateConfig(gateConfig);
+
+    units.push_back(DjiTest_RadarMakeUnit(0.1f, 0, 10.0f, 2.0f, 12, 0, false));
+    units.push_back(DjiTest_RadarMakeUnit(0.1f, 0, 10.0f, 2.0f, 0, 0, false));
+    units.push_back(DjiTest_RadarMakeUnit(0.1f, 0, 10.0f, 2.0f, 12, 0, true));
+    units.push_back(DjiTest_RadarMakeUnit(0.1f, 0, 10.0f, 0.2f, 12, 0, false));
+    units.push_back(DjiTest_RadarMakeUnit(0.1f, 0, 10.0f, -25.0f, 12, 0, false));
+    units.push_back(DjiTest_RadarMakeUnit(0.1f, 0, 0.5f, 2.0f, 12, 0, false));
+    units.push_back(DjiTest_RadarMakeUnit(0.1f, 0, 150.0f, 2.0f, 12, 0, false));
+    units.push_back(DjiTest_RadarMakeUnit(0.2f, 0, 20.0f, -3.0f, 40, 0, false));
+
+    packet = DjiTest_RadarMakePacket(1, 1, units);
+    MODULE_TEST_CHECK(processor.processPacket(packet.data(), packet.size()) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    frame = processor.waitFrame(0);
+    MODULE_TEST_CHECK(frame != nullptr);
+    if (frame == nullptr) {
+        return;
+    }
+    MODULE_TEST_CHECK(frame->rawPointCount == 8 && frame->pointCount == 2);
+    MODULE_TEST_CHECK(frame->snr[0] == 12 && frame->snr[1] == 40 && fabsf(frame->velocity[1] + 3.0f) < 0.001f);
+    processor.releaseFrame(frame);
+
+    processor.getStatistics(&statistics);
+    MODULE_TEST_CHECK(statistics.rawPointCount == 8 && statistics.gatedPointCount == 6);
+}
+
+/**
+ * @brief A sweep missing packets is published when the next one starts, a short packet is counted as malformed,
+ * and sweeps beyond the queue depth are dropped with a gap in the sequence.
+ */
+static void DjiTest_RadarTestLossAndOverflow(void)
+{
+    DJIRadarFrameProcessor processor(RADAR_POSITION_DOWN, 16, 4);
+    T_DjiRadarFrameProcessorStatistics statistics;
+    std::vector<T_DjiRadarCloudUnit> units(10, DjiTest_RadarMakeUnit(0, 0, 5.0f, 1.0f, 20, 0, false));
+    std::vector<T_DjiRadarCloudUnit> smallUnits(units.begin(), units.begin() + 5);
+    std::vector<uint8_t> packet;
+    T_DjiRadarPointCloud *frame;
+    uint32_t expectedSequence;
+    uint32_t frameCount = 0;
+    uint32_t i;
+
+    MODULE_TEST_CHECK(processor.init() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+    //packet 2 of 3 is lost, the sweep is closed by packet 1 of the next sweep
+    packet = DjiTest_RadarMakePacket(1, 3, units);
+    processor.processPacket(packet.data(), packet.size());
+    packet = DjiTest_RadarMakePacket(3, 3, units);
+    processor.processPacket(packet.data(), packet.size());
+    frame = processor.acquireFrame();
+    MODULE_TEST_CHECK(frame != nullptr && frame->receivedPackNum == 2 && frame->packNum == 3);
+    //two packets of 10 points, the sweep keeps 16 of them
+    MODULE_TEST_CHECK(frame != nullptr && frame->rawPointCount == 20 && frame->pointCount == 16);
+    processor.releaseFrame(frame);
+
+    //the second packet of sweep 1 is lost, packet 1 of sweep 2 closes it
+    packet = DjiTest_RadarMakePacket(1, 2, smallUnits);
+    processor.processPacket(packet.data(), packet.size());
+    processor.processPacket(packet.data(), 3);
+    processor.processPacket(packet.data(), packet.size());
+    frame = processor.acquireFrame();
+    MODULE_TEST_CHECK(frame != nullptr && frame->sequence == 1 && frame->receivedPackNum == 1);
+    processor.releaseFrame(frame);
+    packet = DjiTest_RadarMakePacket(2, 2, smallUnits);
+    processor.processPacket(packet.data(), packet.size());
+    frame = processor.acquireFrame();
+    MODULE_TEST_CHECK(frame != nullptr && frame->sequence == 2 && frame->receivedPackNum == 2);
+    processor.releaseFrame(frame);
+
+    //ten complete sweeps without a consumer: four are queued, the others are dropped
+    packet = DjiTest_RadarMakePacket(1, 1, smallUnits);
+    for (i = 0; i < 10; i++) {
+        processor.processPacket(packet.data(), packet.size());
+    }
+    expectedSequence = 3;
+    while ((frame = processor.acquireFrame()) != nullptr) {
+        MODULE_TEST_CHECK(frame->sequence == expectedSequence);
+        expectedSequence++;
+        frameCount++;
+        processor.releaseFrame(frame);
+    }
+    MODULE_TEST_CHECK(frameCount == 4);
+    processor.processPacket(packet.data(), packet.size());
+    frame = processor.acquireFrame();
+    MODULE_TEST_CHECK(frame != nullptr && frame->sequence == 13);
+    processor.releaseFrame(frame);
+
+    processor.getStatistics(&statistics);
+    MODULE_TEST_CHECK(statistics.malformedPacketCount == 1 && statistics.incompleteSweepCount == 2);
+    MODULE_TEST_CHECK(statistics.droppedSweepCount == 6 && statistics.sweepCount == 8);
+    MODULE_TEST_CHECK(statistics.truncatedPointCount == 4);
+}
+
+/**
+ * @brief One consumer thread serving all positions through the shared semaphore, as the fusion sample does.
+ */
+static void *DjiTest_RadarConsumerTask(void *arg)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_TestRadarConsumer *consumer = (T_TestRadarConsumer *) arg;
+    T_DjiRadarPointCloud *frame;
+    uint64_t nowUs = 0;
+    uint64_t latencyUs;
+    bool stopRequest;
+    bool idle;
+    uint32_t i;
+
+    while (true) {
+        //read before the scan, so the sweeps published before the stop request are all seen by the scan
+        stopRequest = __atomic_load_n(&consumer->stopRequest, __ATOMIC_ACQUIRE);
+        idle = true;
+        for (i = 0; i < TEST_RADAR_POSITION_COUNT; i++) {
+            frame = consumer->processors[i]->acquireFrame();
+            if (frame == nullptr) {
+                continue;
+            }
+            osalHandler->GetTimeUs(&nowUs);
+            latencyUs = nowUs - frame->lastPacketTimeUs;
+            consumer->latencySumUs += latencyUs;
+            if (latencyUs > consumer->latencyMaxUs) {
+                consumer->latencyMaxUs = latencyUs;
+            }
+            consumer->sweepCount++;
+            consumer->pointCount += frame->pointCount;
+            consumer->processors[i]->releaseFrame(frame);
+            idle = false;
+        }
+        if (idle) {
+            if (stopRequest) {
+                break;
+            }
+            osalHandler->SemaphoreTimedWait(consumer->notifySema, 10);
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * @brief Six positions fed as fast as one thread can with sweeps of 4 packets of 256 points, converted, gated
+ * and handed to one consumer thread.
+ */
+static void DjiTest_RadarBenchmark(void)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiRadarFrameProcessorStatistics statistics;
+    T_TestRadarConsumer consumer;
+    std::vector<std::vector<uint8_t> > packets;
+    std::vector<T_DjiRadarCloudUnit> units;
+    uint64_t droppedSweepCount = 0;
+    uint64_t processTimeUs = 0;
+    uint64_t sweepCount;
+    uint64_t startTimeUs;
+    uint64_t startCpuTimeUs;
+    uint64_t elapsedUs;
+    uint64_t cpuTimeUs;
+    pthread_t consumerTask;
+    uint32_t sweep;
+    uint32_t i;
+    uint32_t j;
+
+    memset(&consumer, 0, sizeof(consumer));
+    MODULE_TEST_CHECK(osalHandler->SemaphoreCreate(0, &consumer.notifySema) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    for (i = 0; i < TEST_RADAR_POSITION_COUNT; i++) {
+        consumer.processors[i] = new DJIRadarFrameProcessor(s_radarPositions[i]);
+        MODULE_TEST_CHECK(consumer.processors[i]->init(consumer.notifySema) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    }
+
+    //a mix of kept points and null points, spread over the field of view
+    for (i = 0; i < TEST_RADAR_BENCH_PACK_NUM; i++) {
+        units.clear();
+        for (j = 0; j < TEST_RADAR_BENCH_UNITS_PER_PACK; j++) {
+            units.push_back(DjiTest_RadarMakeUnit((float) ((i * 256 + j) % 1500) * 0.001f - 0.75f,
+                                                  (float) (j % 600) * 0.001f - 0.3f, 1.0f + (float) (j % 400) * 0.1f,
+                                                  (float) (j % 21) - 10.0f, (uint8_t) (j % 8 == 0 ? 0 : 15 + j % 30),
+                                                  (uint16_t) (j % 900), false));
+        }
+        packets.push_back(DjiTest_RadarMakePacket((uint8_t) (i + 1), TEST_RADAR_BENCH_PACK_NUM, units));
+    }
+
+    if (pthread_create(&consumerTask, nullptr, DjiTest_RadarConsumerTask, &consumer) != 0) {
+        MODULE_TEST_CHECK(false);
+    } else {
+        startTimeUs = ModuleTest_GetTimeUs();
+        startCpuTimeUs = ModuleTest_GetCpuTimeUs();
+        for (sweep = 0; sweep < TEST_RADAR_BENCH_SWEEPS_PER_POSITION; sweep++) {
+            for (i = 0; i < TEST_RADAR_POSITION_COUNT; i++) {
+                for (j = 0; j < TEST_RADAR_BENCH_PACK_NUM; j++) {
+                    consumer.processors[i]->processPacket(packets[j].data(), packets[j].size());
+                }
+            }
+        }
+        elapsedUs = ModuleTest_GetTimeUs() - startTimeUs;
+        cpuTimeUs = ModuleTest_GetCpuTimeUs() - startCpuTimeUs;
+        __atomic_store_n(&consumer.stopRequest, true, __ATOMIC_RELEASE);
+        osalHandler->SemaphorePost(consumer.notifySema);
+        pthread_join(consumerTask, nullptr);
+
+        for (i = 0; i < TEST_RADAR_POSITION_COUNT; i++) {
+            consumer.processors[i]->getStatistics(&statistics);
+            droppedSweepCount += statistics.droppedSweepCount;
+            processTimeUs += statistics.processTimeUs;
+            MODULE_TEST_CHECK(statistics.malformedPacketCount == 0 && statistics.truncatedPointCount == 0);
+        }
+        sweepCount = (uint64_t) TEST_RADAR_POSITION_COUNT * TEST_RADAR_BENCH_SWEEPS_PER_POSITION;
+        MODULE_TEST_CHECK(consumer.sweepCount + droppedSweepCount == sweepCount);
+        MODULE_TEST_CHECK(consumer.sweepCount > 0);
+
+        ModuleTest_Report("sweeps converted per second", (double) sweepCount * 1000000 / elapsedUs, "sweeps/s");
+        ModuleTest_Report("conversion cost", (double) processTimeUs * 1000 /
+                                             (sweepCount * TEST_RADAR_BENCH_PACK_NUM * TEST_RADAR_BENCH_UNITS_PER_PACK),
+                          "ns/point");
+        ModuleTest_Report("process cpu time per sweep", (double) cpuTimeUs / sweepCount, "us/sweep");
+        ModuleTest_Report("sweeps dropped", (double) droppedSweepCount, "sweeps");
+        ModuleTest_Report("hand-off latency avg", consumer.sweepCount > 0 ?
+                                                  (double) consumer.latencySumUs / consumer.sweepCount : 0, "us");
+        ModuleTest_Report("hand-off latency max", (double) consumer.latencyMaxUs, "us");
+    }
+
+    for (i = 0; i < TEST_RADAR_POSITION_COUNT; i++) {
+        delete consumer.processors[i];
+    }
+    osalHandler->SemaphoreDestroy(consumer.notifySema);
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,438 @@
+/**
+ ********************************************************************
+ * @file    test_radar_fusion.cpp
+ * @brief   Test and benchmark of the radar occupancy grid fusion with synthetic sweeps of six radars.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <pthread.h>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "module_test.h"
+#include "dji_platform.h"
+#include "perception/dji_radar_fusion.hpp"
+
+/* Private constants ---------------------------------------------------------*/
+#define TEST_FUSION_POSITION_COUNT              6
+#define TEST_FUSION_BENCH_POINTS_PER_SWEEP      1024
+#define TEST_FUSION_BENCH_SWEEPS_PER_POSITION   50
+#define TEST_FUSION_BENCH_QUERY_PERIOD_MS       20
+#define TEST_FUSION_STRESS_POINTS_PER_SWEEP     64
+#define TEST_FUSION_STRESS_SWEEPS               20000
+
+/* Private types -------------------------------------------------------------*/
+/* A sweep owning its point arrays, cloud points into them. */
+typedef struct {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<float> velocity;
+    std::vector<float> energy;
+    std::vector<float> beamAngle;
+    std::vector<uint8_t> snr;
+    T_DjiRadarPointCloud cloud;
+} T_TestFusionSweep;
+
+typedef struct {
+    DJIRadarFusion *fusion;
+    bool stopRequest;
+    uint32_t readCount;
+    uint32_t inconsistentCount;
+} T_TestFusionReader;
+
+/* Private values -------------------------------------------------------------*/
+static const E_DjiPerceptionRadarPosition s_fusionPositions[TEST_FUSION_POSITION_COUNT] = {
+    RADAR_POSITION_FRONT, RADAR_POSITION_BACK, RADAR_POSITION_LEFT, RADAR_POSITION_RIGHT, RADAR_POSITION_UP,
+    RADAR_POSITION_DOWN,
+};
+
+/* Private functions declaration ---------------------------------------------*/
+static void DjiTest_FusionInitSweep(T_TestFusionSweep *sweep, E_DjiPerceptionRadarPosition position,
+                                    uint32_t pointCount);
+static void DjiTest_FusionStampSweep(T_TestFusionSweep *sweep, uint64_t timeUs);
+static T_DjiRadarFusionPose DjiTest_FusionMakePose(uint64_t timeUs, float yawDeg, float north, float east);
+static float DjiTest_FusionGetCell(DJIRadarFusion *fusion, uint32_t row, uint32_t col, uint32_t *occupiedCount);
+static void DjiTest_FusionTestPlacement(void);
+static void DjiTest_FusionTestStaleAndDecay(void);
+static void *DjiTest_FusionReaderTask(void *arg);
+static void DjiTest_FusionTestStatistics(void);
+static void *DjiTest_FusionQueryTask(void *arg);
+static void DjiTest_FusionBenchmark(void);
+
+/* Exported functions definition ---------------------------------------------*/
+int main(void)
+{
+    if (ModuleTest_Init() != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        printf("register osal handler failed\r\n");
+        return 1;
+    }
+
+    DjiTest_FusionTestPlacement();
+    DjiTest_FusionTestStaleAndDecay();
+    DjiTest_FusionTestStatistics();
+    DjiTest_FusionBenchmark();
+
+    return ModuleTest_Finish("test_radar_fusion");
+}
+
+/* Private functions definition-----------------------------------------------*/
+static void DjiTest_FusionInitSweep(T_TestFusionSweep *sweep, E_DjiPerceptionRadarPosition position,
+                                    uint32_t pointCount)
+{
+    sweep->x.assign(pointCount, 0);
+    sweep->y.assign(pointCount, 0);
+    sweep->z.assign(pointCount, 0);
+    sweep->velocity.assign(pointCount, 0);
+    sweep->energy.assign(pointCount, 2.5f);
+    sweep->beamAngle.assign(pointCount, 0);
+    sweep->snr.assign(pointCount, 20);
+
+    memset(&sweep->cloud, 0, sizeof(sweep->cloud));
+    sweep->cloud.position = position;
+    sweep->cloud.packNum = 1;
+    sweep->cloud.receivedPackNum = 1;
+    sweep->cloud.rawPointCount = pointCount;
+    sweep->cloud.pointCount = pointCount;
+    sweep->cloud.capacity = pointCount;
+    sweep->cloud.x = sweep->x.data();
+    sweep->cloud.y = sweep->y.data();
+    sweep->cloud.z = sweep->z.data();
+    sweep->cloud.velocity = sweep->velocity.data();
+    sweep->cloud.energy = sweep->energy.data();
+    sweep->cloud.beamAngle = sweep->beamAngle.data();
+    sweep->cloud.snr = sweep->snr.data();
+}
+
+static void DjiTest_FusionStampSweep(T_TestFusionSweep *sweep, uint64_t timeUs)
+{
+    sweep->cloud.sequence++;
+    sweep->cloud.firstPacketTimeUs = timeUs;
+    sweep->cloud.lastPacketTimeUs = timeUs;
+}
+
+/**
+ * @brief Level pose with the given heading, position in m north and east of the local origin.
+ */
+static T_DjiRadarFusionPose DjiTest_FusionMakePose(uint64_t timeUs, float yawDeg, float north, float east)
+{
+    T_DjiRadarFusionPose pose;
+    float halfYawRad = yawDeg * (float) M_PI / 360.0f;
+
+    memset(&pose, 0, sizeof(pose));
+    pose.timeUs = timeUs;
+    pose.quaternion[0] = cosf(halfYawRad);
+    pose.quaternion[3] = sinf(halfYawRad);
+    pose.position[0] = north;
+    pose.position[1] = east;
+
+    return pose;
+}
+
+static float DjiTest_FusionGetCell(DJIRadarFusion *fusion, uint32_t row, uint32_t col, uint32_t *occupiedCount)
+{
+    T_DjiRadarOccupancyGrid grid;
+    std::vector<float> occupancy(128 * 128);
+
+    memset(&grid, 0, sizeof(grid));
+    grid.occupancy = occupancy.data();
+    if (fusion->getOccupancyGrid(&grid) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS || grid.gridWidth != 128) {
+        MODULE_TEST_CHECK(false);
+        return -1;
+    }
+    if (occupiedCount != nullptr) {
+        *occupiedCount = grid.occupiedCellCount;
+    }
+
+    return occupancy[row * grid.gridWidth + col];
+}
+
+/**
+ * @brief With 0.5 m cells and 128 cells per side the aircraft is in row 64, col 64 and a point 5 m away is 10 cells
+ * from it: north is a higher row, east a higher col. The mounting and the heading of the pose both rotate the point.
+ */
+static void DjiTest_FusionTestPlacement(void)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    const struct {
+        E_DjiPerceptionRadarPosition position;
+        float yawDeg;
+        uint32_t row;
+        uint32_t col;
+    } cases[] = {
+        {RADAR_POSITION_FRONT, 0, 74, 64},
+        {RADAR_POSITION_BACK,  0, 54, 64},
+        {RADAR_POSITION_LEFT,  0, 64, 54},
+        {RADAR_POSITION_RIGHT, 0, 64, 74},
+        {RADAR_POSITION_FRONT, 90, 64, 74},
+    };
+    T_DjiRadarFusionConfig config;
+    T_TestFusionSweep sweep;
+    uint32_t occupiedCount = 0;
+    uint64_t nowUs = 0;
+
+    DjiRadarFusion_GetDefaultConfig(&config);
+    for (uint32_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        DJIRadarFusion fusion;
+
+        MODULE_TEST_CHECK(fusion.init(config) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+        osalHandler->GetTimeUs(&nowUs);
+        fusion.updatePose(DjiTest_FusionMakePose(nowUs, cases[i].yawDeg, 0, 0));
+
+        DjiTest_FusionInitSweep(&sweep, cases[i].position, 1);
+        sweep.x[0] = 5.0f;
+        DjiTest_FusionStampSweep(&sweep, nowUs);
+        MODULE_TEST_CHECK(fusion.fuseSweep(&sweep.cloud) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+        MODULE_TEST_CHECK(DjiTest_FusionGetCell(&fusion, cases[i].row, cases[i].col, &occupiedCount) > 0.9f);
+        MODULE_TEST_CHECK(occupiedCount == 1);
+    }
+
+    //the grid follows the aircraft, the same world cell moves 20 rows south when it flies 10 m north
+    {
+        DJIRadarFusion fusion;
+
+        MODULE_TEST_CHECK(fusion.init(config) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+        osalHandler->GetTimeUs(&nowUs);
+        fusion.updatePose(DjiTest_FusionMakePose(nowUs, 0, 0, 0));
+        DjiTest_FusionInitSweep(&sweep, RADAR_POSITION_FRONT, 1);
+        sweep.x[0] = 5.0f;
+        DjiTest_FusionStampSweep(&sweep, nowUs);
+        MODULE_TEST_CHECK(fusion.fuseSweep(&sweep.cloud) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+        fusion.updatePose(DjiTest_FusionMakePose(nowUs + 1, 0, 10.0f, 0));
+        MODULE_TEST_CHECK(DjiTest_FusionGetCell(&fusion, 54, 64, &occupiedCount) > 0.9f);
+        MODULE_TEST_CHECK(occupiedCount == 1);
+    }
+}
+
+/**
+ * @brief A sweep older than maxSweepAgeMs is counted and not fused, a fused hit halves every half-life.
+ */
+static void DjiTest_FusionTestStaleAndDecay(void)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiRadarFusionConfig config;
+    T_DjiRadarFusionStatistics statistics;
+    T_TestFusionSweep sweep;
+    DJIRadarFusion fusion;
+    uint32_t occupiedCount = 0;
+    uint64_t nowUs = 0;
+    float occupancy;
+
+    DjiRadarFusion_GetDefaultConfig(&config);
+    config.decayHalfLifeMs = 200;
+    config.maxSweepAgeMs = 50;
+    MODULE_TEST_CHECK(fusion.init(config) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    DjiTest_FusionInitSweep(&sweep, RADAR_POSITION_FRONT, 1);
+    sweep.x[0] = 5.0f;
+
+    osalHandler->GetTimeUs(&nowUs);
+    fusion.updatePose(DjiTest_FusionMakePose(nowUs, 0, 0, 0));
+    DjiTest_FusionStampSweep(&sweep, nowUs);
+    osalHandler->TaskSleepMs(config.maxSweepAgeMs + 20);
+    MODULE_TEST_CHECK(fusion.fuseSweep(&sweep.cloud) == DJI_ERROR_SYSTEM_MODULE_CODE_TIMEOUT);
+    MODULE_TEST_CHECK(DjiTest_FusionGetCell(&fusion, 74, 64, &occupiedCount) == 0 && occupiedCount == 0);
+
+    osalHandler->GetTimeUs(&nowUs);
+    fusion.updatePose(DjiTest_FusionMakePose(nowUs, 0, 0, 0));
+    DjiTest_FusionStampSweep(&sweep, nowUs);
+    MODULE_TEST_CHECK(fusion.fuseSweep(&sweep.cloud) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    osalHandler->TaskSleepMs(config.decayHalfLifeMs);
+    occupancy = DjiTest_FusionGetCell(&fusion, 74, 64, nullptr);
+    MODULE_TEST_CHECK(occupancy > 0.35f && occupancy < 0.55f);
+
+    fusion.getStatistics(&statistics);
+    MODULE_TEST_CHECK(statistics.staleSweepCount == 1 && statistics.sweepCount == 1);
+    MODULE_TEST_CHECK(statistics.pointCount == 1 && statistics.rejectedPointCount == 0);
+    MODULE_TEST_CHECK(statistics.poselessSweepCount == 0 && statistics.queryCount == 2);
+}
+
+static void *DjiTest_FusionReaderTask(void *arg)
+{
+    T_TestFusionReader *reader = (T_TestFusionReader *) arg;
+    T_DjiRadarFusionStatistics statistics;
+
+    while (!__atomic_load_n(&reader->stopRequest, __ATOMIC_ACQUIRE)) {
+        reader->fusion->getStatistics(&statistics);
+        if (statistics.pointCount != statistics.sweepCount * TEST_FUSION_STRESS_POINTS_PER_SWEEP ||
+            statistics.rejectedPointCount != statistics.sweepCount) {
+            reader->inconsistentCount++;
+        }
+        reader->readCount++;
+    }
+
+    return nullptr;
+}
+
+/**
+ * @brief Statistics read while sweeps are fused belong to one whole number of sweeps. Every sweep has one point
+ * above the height band, so the counters of a sweep are only consistent if they are updated together.
+ */
+static void DjiTest_FusionTestStatistics(void)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiRadarFusionConfig config;
+    T_DjiRadarFusionStatistics statistics;
+    T_TestFusionSweep sweep;
+    T_TestFusionReader reader;
+    DJIRadarFusion fusion;
+    pthread_t readerTask;
+    uint64_t nowUs = 0;
+
+    DjiRadarFusion_GetDefaultConfig(&config);
+    MODULE_TEST_CHECK(fusion.init(config) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    DjiTest_FusionInitSweep(&sweep, RADAR_POSITION_FRONT, TEST_FUSION_STRESS_POINTS_PER_SWEEP);
+    for (uint32_t i = 0; i < TEST_FUSION_STRESS_POINTS_PER_SWEEP; i++) {
+        sweep.x[i] = 1.0f + (float) i * 0.25f;
+        sweep.y[i] = (float) (i % 8) - 4.0f;
+    }
+    sweep.z[0] = config.maxRelativeHeight + 10.0f;
+
+    memset(&reader, 0, sizeof(reader));
+    reader.fusion = &fusion;
+    if (pthread_create(&readerTask, nullptr, DjiTest_FusionReaderTask, &reader) != 0) {
+        MODULE_TEST_CHECK(false);
+        return;
+    }
+
+    for (uint32_t i = 0; i < TEST_FUSION_STRESS_SWEEPS; i++) {
+        osalHandler->GetTimeUs(&nowUs);
+        DjiTest_FusionStampSweep(&sweep, nowUs);
+        MODULE_TEST_CHECK(fusion.fuseSweep(&sweep.cloud) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    }
+
+    __atomic_store_n(&reader.stopRequest, true, __ATOMIC_RELEASE);
+    pthread_join(readerTask, nullptr);
+
+    fusion.getStatistics(&statistics);
+    MODULE_TEST_CHECK(statistics.sweepCount == TEST_FUSION_STRESS_SWEEPS);
+    MODULE_TEST_CHECK(reader.readCount > 0 && reader.inconsistentCount == 0);
+}
+
+static void *DjiTest_FusionQueryTask(void *arg)
+{
+    T_TestFusionReader *reader = (T_TestFusionReader *) arg;
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiRadarOccupancyGrid grid;
+    std::vector<float> occupancy(128 * 128);
+    std::vector<float> height(128 * 128);
+
+    memset(&grid, 0, sizeof(grid));
+    grid.occupancy = occupancy.data();
+    grid.height = height.data();
+    while (!__atomic_load_n(&reader->stopRequest, __ATOMIC_ACQUIRE)) {
+        if (reader->fusion->getOccupancyGrid(&grid) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            reader->inconsistentCount++;
+        }
+        reader->readCount++;
+        osalHandler->TaskSleepMs(TEST_FUSION_BENCH_QUERY_PERIOD_MS);
+    }
+
+    return nullptr;
+}
+
+/**
+ * @brief Six radars at 20 Hz with 1024 points each, a pose at 50 Hz of an aircraft flying north at 5 m/s and
+ * turning, and a grid query at 50 Hz from another thread, like an avoidance task would.
+ */
+static void DjiTest_FusionBenchmark(void)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiRadarFusionConfig config;
+    T_DjiRadarFusionStatistics statistics;
+    T_TestFusionSweep sweeps[TEST_FUSION_POSITION_COUNT];
+    T_TestFusionReader reader;
+    DJIRadarFusion fusion;
+    pthread_t queryTask;
+    uint64_t startTimeUs;
+    uint64_t startCpuTimeUs;
+    uint64_t elapsedUs;
+    uint64_t cpuTimeUs;
+    uint64_t nowUs = 0;
+    uint32_t sweepCount = 0;
+
+    DjiRadarFusion_GetDefaultConfig(&config);
+    MODULE_TEST_CHECK(fusion.init(config) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+    //points spread over a 120 by 40 degree field of view up to 40 m, some of them out of the grid
+    for (uint32_t i = 0; i < TEST_FUSION_POSITION_COUNT; i++) {
+        DjiTest_FusionInitSweep(&sweeps[i], s_fusionPositions[i], TEST_FUSION_BENCH_POINTS_PER_SWEEP);
+        for (uint32_t j = 0; j < TEST_FUSION_BENCH_POINTS_PER_SWEEP; j++) {
+            float azimuth = ((float) ((j * 37 + i * 11) % 120) - 60.0f) * (float) M_PI / 180.0f;
+            float elevation = ((float) ((j * 13 + i * 7) % 40) - 20.0f) * (float) M_PI / 180.0f;
+            float radius = 1.0f + (float) ((j * 7 + i) % 390) * 0.1f;
+
+            sweeps[i].x[j] = radius * cosf(elevation) * cosf(azimuth);
+            sweeps[i].y[j] = radius * cosf(elevation) * sinf(azimuth);
+            sweeps[i].z[j] = radius * sinf(elevation);
+        }
+    }
+
+    memset(&reader, 0, sizeof(reader));
+    reader.fusion = &fusion;
+    if (pthread_create(&queryTask, nullptr, DjiTest_FusionQueryTask, &reader) != 0) {
+        MODULE_TEST_CHECK(false);
+        return;
+    }
+
+    //one tick is 10 ms: a pose every other tick, the sweeps of a position every fifth tick
+    startTimeUs = ModuleTest_GetTimeUs();
+    startCpuTimeUs = ModuleTest_GetCpuTimeUs();
+    for (uint32_t tick = 0; sweepCount < TEST_FUSION_POSITION_COUNT * TEST_FUSION_BENCH_SWEEPS_PER_POSITION; tick++) {
+        osalHandler->GetTimeUs(&nowUs);
+        if (tick % 2 == 0) {
+            fusion.updatePose(DjiTest_FusionMakePose(nowUs, (float) (tick % 360), (float) tick * 0.05f, 0));
+        }
+        for (uint32_t i = 0; i < TEST_FUSION_POSITION_COUNT; i++) {
+            if ((tick + i) % 5 != 0) {
+                continue;
+            }
+            DjiTest_FusionStampSweep(&sweeps[i], nowUs);
+            MODULE_TEST_CHECK(fusion.fuseSweep(&sweeps[i].cloud) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+            sweepCount++;
+        }
+        osalHandler->TaskSleepMs(10);
+    }
+    elapsedUs = ModuleTest_GetTimeUs() - startTimeUs;
+    cpuTimeUs = ModuleTest_GetCpuTimeUs() - startCpuTimeUs;
+
+    __atomic_store_n(&reader.stopRequest, true, __ATOMIC_RELEASE);
+    pthread_join(queryTask, nullptr);
+
+    fusion.getStatistics(&statistics);
+    MODULE_TEST_CHECK(statistics.sweepCount == sweepCount && statistics.staleSweepCount == 0);
+    MODULE_TEST_CHECK(statistics.poselessSweepCount == 0);
+    MODULE_TEST_CHECK(statistics.queryCount == reader.readCount && reader.inconsistentCount == 0);
+    if (statistics.sweepCount == 0 || statistics.queryCount == 0) {
+        return;
+    }
+
+    ModuleTest_Report("update latency avg", (double) statistics.updateTimeUs / statistics.sweepCount, "us");
+    ModuleTest_Report("update latency max", (double) statistics.updateTimeMaxUs, "us");
+    ModuleTest_Report("update cost", (double) statistics.updateTimeUs * 1000 / statistics.pointCount, "ns/point");
+    ModuleTest_Report("query latency avg", (double) statistics.queryTimeUs / statistics.queryCount, "us");
+    ModuleTest_Report("query latency max", (double) statistics.queryTimeMaxUs, "us");
+    ModuleTest_Report("points rejected", (double) statistics.rejectedPointCount * 100 / statistics.pointCount, "%");
+    ModuleTest_Report("cpu load", (double) cpuTimeUs * 100 / elapsedUs, "%");
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,341 @@
+/**
+ ********************************************************************
+ * @file    test_stereo_depth.cpp
+ * @brief   Test and benchmark of the stereo depth matching with synthetic image pairs of six directions.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "module_test.h"
+#include "dji_platform.h"
+#include "perception/dji_stereo_depth.hpp"
+
+/* Private constants ---------------------------------------------------------*/
+#define TEST_DEPTH_WIDTH                       640
+#define TEST_DEPTH_HEIGHT                      480
+#define TEST_DEPTH_DISPARITY                   16
+#define TEST_DEPTH_MAP_TIMEOUT_MS              2000
+#define TEST_DEPTH_FULL_SCALE_MAP_NUM          20
+#define TEST_DEPTH_BENCH_INPUT_RATE_HZ         20
+#define TEST_DEPTH_BENCH_DURATION_MS           3000
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    uint32_t mapCount;
+    uint32_t width;
+    uint32_t height;
+    uint32_t downscale;
+    float focalLength;
+    float baseline;
+    std::vector<float> depth;
+} T_TestDepthResult;
+
+/* Private values -------------------------------------------------------------*/
+static const uint32_t s_leftPositions[IMAGE_MAX_DIRECTION_NUM] = {
+    RECTIFY_DOWN_LEFT, RECTIFY_FRONT_LEFT, RECTIFY_REAR_LEFT, RECTIFY_UP_LEFT, RECTIFY_LEFT_LEFT, RECTIFY_RIGHT_LEFT,
+};
+
+/* Private functions declaration ---------------------------------------------*/
+static void DjiTest_DepthMakePair(uint32_t disparity, std::vector<uint8_t> *left, std::vector<uint8_t> *right);
+static T_DjiPerceptionImageInfo DjiTest_DepthMakeInfo(uint32_t cameraPosition, uint16_t sequence,
+                                                      uint64_t timeStamp);
+static T_DjiReturnCode DjiTest_DepthAddPair(DJIStereoDepth *depth, E_DjiPerceptionDirection direction,
+                                            uint16_t sequence, const std::vector<uint8_t> &left,
+                                            const std::vector<uint8_t> &right);
+static void DjiTest_DepthCallback(const T_DjiStereoDepthMap *depthMap, void *userData);
+static bool DjiTest_DepthWaitMapCount(T_TestDepthResult *result, uint32_t mapCount);
+static void DjiTest_DepthTestAccuracy(void);
+static void DjiTest_DepthBenchmarkFullScale(void);
+static void DjiTest_DepthBenchmarkSixDirections(void);
+
+/* Exported functions definition ---------------------------------------------*/
+int main(void)
+{
+    if (ModuleTest_Init() != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        printf("register osal handler failed\r\n");
+        return 1;
+    }
+
+    DjiTest_DepthTestAccuracy();
+    DjiTest_DepthBenchmarkFullScale();
+    DjiTest_DepthBenchmarkSixDirections();
+
+    return ModuleTest_Finish("test_stereo_depth");
+}
+
+/* Private functions definition-----------------------------------------------*/
+/**
+ * @brief A rectified pair of a fronto-parallel random texture, a point in column x of the left image is in column
+ * x - disparity of the right image.
+ */
+static void DjiTest_DepthMakePair(uint32_t disparity, std::vector<uint8_t> *left, std::vector<uint8_t> *right)
+{
+    uint32_t seed = 12345;
+
+    left->resize(TEST_DEPTH_WIDTH * TEST_DEPTH_HEIGHT);
+    right->resize(TEST_DEPTH_WIDTH * TEST_DEPTH_HEIGHT);
+    for (uint32_t i = 0; i < left->size(); i++) {
+        seed = seed * 1103515245 + 12345;
+        (*left)[i] = (uint8_t) (seed >> 16);
+    }
+    for (uint32_t y = 0; y < TEST_DEPTH_HEIGHT; y++) {
+        for (uint32_t x = 0; x < TEST_DEPTH_WIDTH; x++) {
+            (*right)[y * TEST_DEPTH_WIDTH + x] = x + disparity < TEST_DEPTH_WIDTH ?
+                                                 (*left)[y * TEST_DEPTH_WIDTH + x + disparity] : 0;
+        }
+    }
+}
+
+static T_DjiPerceptionImageInfo DjiTest_DepthMakeInfo(uint32_t cameraPosition, uint16_t sequence,
+                                                      uint64_t timeStamp)
+{
+    T_DjiPerceptionImageInfo info;
+
+    memset(&info, 0, sizeof(info));
+    info.dataType = cameraPosition;
+    info.sequence = sequence;
+    info.timeStamp = timeStamp;
+    info.rawInfo.width = TEST_DEPTH_WIDTH;
+    info.rawInfo.height = TEST_DEPTH_HEIGHT;
+    info.rawInfo.bpp = 8;
+
+    return info;
+}
+
+static T_DjiReturnCode DjiTest_DepthAddPair(DJIStereoDepth *depth, E_DjiPerceptionDirection direction,
+                                            uint16_t sequence, const std::vector<uint8_t> &left,
+                                            const std::vector<uint8_t> &right)
+{
+    T_DjiReturnCode returnCode;
+
+    returnCode = depth->addImage(DjiTest_DepthMakeInfo(s_leftPositions[direction], sequence, sequence), left.data(),
+                                 left.size());
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return returnCode;
+    }
+
+    return depth->addImage(DjiTest_DepthMakeInfo(s_leftPositions[direction] + 1, sequence, sequence), right.data(),
+                           right.size());
+}
+
+/**
+ * @brief Runs on the depth task, the map is copied for the checks of the main thread.
+ */
+static void DjiTest_DepthCallback(const T_DjiStereoDepthMap *depthMap, void *userData)
+{
+    T_TestDepthResult *result = (T_TestDepthResult *) userData;
+
+    if (result->depth.empty()) {
+        result->width = depthMap->width;
+        result->height = depthMap->height;
+        result->downscale = depthMap->downscale;
+        result->focalLength = depthMap->focalLength;
+        result->baseline = depthMap->baseline;
+        result->depth.assign(depthMap->depth, depthMap->depth + depthMap->width * depthMap->height);
+    }
+    __atomic_add_fetch(&result->mapCount, 1, __ATOMIC_RELEASE);
+}
+
+static bool DjiTest_DepthWaitMapCount(T_TestDepthResult *result, uint32_t mapCount)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    for (uint32_t i = 0; i < TEST_DEPTH_MAP_TIMEOUT_MS; i++) {
+        if (__atomic_load_n(&result->mapCount, __ATOMIC_ACQUIRE) >= mapCount) {
+            return true;
+        }
+        osalHandler->TaskSleepMs(1);
+    }
+
+    return false;
+}
+
+/**
+ * @brief Without camera parameters a pair is matched as rectified with a focal length and a baseline of 1, so the
+ * depth of a shift of d pixels is 1 / d. Left of the search range and at the image borders no depth is found.
+ */
+static void DjiTest_DepthTestAccuracy(void)
+{
+    T_DjiStereoDepthConfig config;
+    T_DjiStereoDepthStatistics statistics;
+    T_TestDepthResult result;
+    DJIStereoDepth depth;
+    std::vector<uint8_t> left;
+    std::vector<uint8_t> right;
+    std::vector<float> validDepth;
+    uint32_t checkedNum = 0;
+
+    DjiStereoDepth_GetDefaultConfig(&config);
+    config.maxDownscale = 1;
+    result.mapCount = 0;
+    MODULE_TEST_CHECK(depth.init(config, DjiTest_DepthCallback, &result) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(depth.init(config, DjiTest_DepthCallback, &result) == DJI_ERROR_SYSTEM_MODULE_CODE_BUSY);
+
+    DjiTest_DepthMakePair(TEST_DEPTH_DISPARITY, &left, &right);
+    MODULE_TEST_CHECK(depth.addImage(DjiTest_DepthMakeInfo(RECTIFY_FRONT_LEFT, 1, 1), left.data(), 100) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER);
+    MODULE_TEST_CHECK(DjiTest_DepthAddPair(&depth, DJI_PERCEPTION_RECTIFY_FRONT, 1, left, right) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_DepthWaitMapCount(&result, 1));
+    if (result.depth.empty()) {
+        return;
+    }
+
+    MODULE_TEST_CHECK(result.width == TEST_DEPTH_WIDTH && result.height == TEST_DEPTH_HEIGHT);
+    MODULE_TEST_CHECK(result.downscale == 1 && result.focalLength == 1 && result.baseline == 1);
+    for (uint32_t y = config.blockSize; y < result.height - config.blockSize; y++) {
+        for (uint32_t x = config.disparityNum + config.blockSize; x < result.width - config.blockSize; x++) {
+            checkedNum++;
+            if (result.depth[y * result.width + x] > 0) {
+                validDepth.push_back(result.depth[y * result.width + x]);
+            }
+        }
+    }
+    MODULE_TEST_CHECK(validDepth.size() * 100 > checkedNum * 95);
+    if (!validDepth.empty()) {
+        std::nth_element(validDepth.begin(), validDepth.begin() + validDepth.size() / 2, validDepth.end());
+        MODULE_TEST_CHECK(fabsf(1.0f / validDepth[validDepth.size() / 2] - TEST_DEPTH_DISPARITY) < 0.5f);
+    }
+    MODULE_TEST_CHECK(result.depth[result.width / 2] >= 0 && result.depth[0] == 0);
+
+    depth.getStatistics(DJI_PERCEPTION_RECTIFY_FRONT, &statistics);
+    MODULE_TEST_CHECK(statistics.imageCount == 2 && statistics.pairCount == 1 && statistics.depthMapCount == 1);
+    MODULE_TEST_CHECK(statistics.unpairedImageCount == 0 && statistics.skippedPairCount == 0);
+    depth.cleanup();
+}
+
+/**
+ * @brief One direction matched at full resolution, each pair added after the map of the one before.
+ */
+static void DjiTest_DepthBenchmarkFullScale(void)
+{
+    T_DjiStereoDepthConfig config;
+    T_DjiStereoDepthStatistics statistics;
+    T_TestDepthResult result;
+    DJIStereoDepth depth;
+    std::vector<uint8_t> left;
+    std::vector<uint8_t> right;
+
+    DjiStereoDepth_GetDefaultConfig(&config);
+    config.maxDownscale = 1;
+    config.targetRateHz = 1000;
+    result.mapCount = 0;
+    MODULE_TEST_CHECK(depth.init(config, DjiTest_DepthCallback, &result) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    DjiTest_DepthMakePair(TEST_DEPTH_DISPARITY, &left, &right);
+
+    for (uint16_t sequence = 1; sequence <= TEST_DEPTH_FULL_SCALE_MAP_NUM; sequence++) {
+        DjiTest_DepthAddPair(&depth, DJI_PERCEPTION_RECTIFY_FRONT, sequence, left, right);
+        if (!DjiTest_DepthWaitMapCount(&result, sequence)) {
+            MODULE_TEST_CHECK(false);
+            break;
+        }
+    }
+
+    depth.getStatistics(DJI_PERCEPTION_RECTIFY_FRONT, &statistics);
+    MODULE_TEST_CHECK(statistics.depthMapCount == TEST_DEPTH_FULL_SCALE_MAP_NUM && statistics.downscale == 1);
+    if (statistics.depthMapCount > 0) {
+        ModuleTest_Report("full scale match time avg", (double) statistics.processTimeUs / statistics.depthMapCount,
+                          "us");
+        ModuleTest_Report("full scale match time max", (double) statistics.processTimeMaxUs, "us");
+        ModuleTest_Report("full scale match rate", (double) TEST_DEPTH_WIDTH * TEST_DEPTH_HEIGHT *
+                                                   config.disparityNum * statistics.depthMapCount /
+                                                   statistics.processTimeUs, "Mdisparities/s");
+    }
+    depth.cleanup();
+}
+
+/**
+ * @brief VGA pairs of all six directions at 20 Hz with the default config, which targets 10 Hz per direction and
+ * downscales the directions that can not keep it.
+ */
+static void DjiTest_DepthBenchmarkSixDirections(void)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiStereoDepthConfig config;
+    T_DjiStereoDepthStatistics statistics;
+    T_TestDepthResult result;
+    DJIStereoDepth depth;
+    std::vector<uint8_t> left;
+    std::vector<uint8_t> right;
+    uint64_t pairCount = 0;
+    uint64_t skippedPairCount = 0;
+    uint64_t depthMapCount = 0;
+    uint64_t processTimeUs = 0;
+    uint64_t latencyUs = 0;
+    uint32_t processTimeMaxUs = 0;
+    uint32_t latencyMaxUs = 0;
+    uint32_t downscaleMax = 1;
+    uint64_t startTimeUs;
+    uint64_t startCpuTimeUs;
+    uint64_t elapsedUs;
+    uint64_t cpuTimeUs;
+    uint16_t sequence = 0;
+
+    DjiStereoDepth_GetDefaultConfig(&config);
+    result.mapCount = 0;
+    MODULE_TEST_CHECK(depth.init(config, DjiTest_DepthCallback, &result) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    DjiTest_DepthMakePair(TEST_DEPTH_DISPARITY, &left, &right);
+
+    startTimeUs = ModuleTest_GetTimeUs();
+    startCpuTimeUs = ModuleTest_GetCpuTimeUs();
+    while (ModuleTest_GetTimeUs() - startTimeUs < TEST_DEPTH_BENCH_DURATION_MS * 1000) {
+        sequence++;
+        for (uint32_t direction = 0; direction < IMAGE_MAX_DIRECTION_NUM; direction++) {
+            DjiTest_DepthAddPair(&depth, (E_DjiPerceptionDirection) direction, sequence, left, right);
+        }
+        osalHandler->TaskSleepMs(1000 / TEST_DEPTH_BENCH_INPUT_RATE_HZ);
+    }
+    elapsedUs = ModuleTest_GetTimeUs() - startTimeUs;
+    cpuTimeUs = ModuleTest_GetCpuTimeUs() - startCpuTimeUs;
+
+    for (uint32_t direction = 0; direction < IMAGE_MAX_DIRECTION_NUM; direction++) {
+        depth.getStatistics((E_DjiPerceptionDirection) direction, &statistics);
+        pairCount += statistics.pairCount;
+        skippedPairCount += statistics.skippedPairCount;
+        depthMapCount += statistics.depthMapCount;
+        processTimeUs += statistics.processTimeUs;
+        latencyUs += statistics.latencyUs;
+        processTimeMaxUs = statistics.processTimeMaxUs > processTimeMaxUs ? statistics.processTimeMaxUs :
+                           processTimeMaxUs;
+        latencyMaxUs = statistics.latencyMaxUs > latencyMaxUs ? statistics.latencyMaxUs : latencyMaxUs;
+        downscaleMax = statistics.downscale > downscaleMax ? statistics.downscale : downscaleMax;
+    }
+    depth.cleanup();
+    MODULE_TEST_CHECK(depthMapCount > 0);
+    if (depthMapCount == 0) {
+        return;
+    }
+
+    ModuleTest_Report("pairs added", (double) pairCount, "pairs");
+    ModuleTest_Report("depth maps per second", (double) depthMapCount * 1000000 / elapsedUs, "maps/s");
+    ModuleTest_Report("pairs skipped", (double) skippedPairCount * 100 / pairCount, "%");
+    ModuleTest_Report("match time avg", (double) processTimeUs / depthMapCount, "us");
+    ModuleTest_Report("match time max", (double) processTimeMaxUs, "us");
+    ModuleTest_Report("latency avg", (double) latencyUs / depthMapCount, "us");
+    ModuleTest_Report("latency max", (double) latencyMaxUs, "us");
+    ModuleTest_Report("largest downscale", (double) downscaleMax, "");
+    ModuleTest_Report("cpu load", (double) cpuTimeUs * 100 / elapsedUs, "%");
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,385 @@
+/**
+ ********************************************************************
+ * @file    test_stereo_image_buffer.cpp
+ * @brief   Test and benchmark of the stereo image triple buffers between the image callback and one consumer.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <pthread.h>
+#include <cstring>
+#include <vector>
+#include "module_test.h"
+#include "dji_platform.h"
+#include "perception/dji_stereo_image_buffer.hpp"
+
+/* Private constants ---------------------------------------------------------*/
+#define TEST_STEREO_STRESS_CAMERA_NUM          4
+#define TEST_STEREO_STRESS_IMAGE_SIZE          4096
+#define TEST_STEREO_STRESS_IMAGES_PER_CAMERA   20000
+#define TEST_STEREO_BENCH_WIDTH                640
+#define TEST_STEREO_BENCH_HEIGHT               480
+#define TEST_STEREO_BENCH_IMAGES_PER_CAMERA    400
+#define TEST_STEREO_WAIT_TIMEOUT_MS            10
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    DJIStereoImageBuffer *buffer;
+    bool stopRequest;
+    bool checkData;
+    uint64_t imageCount;
+    uint64_t tornImageCount;
+    uint64_t reorderedImageCount;
+    uint64_t latencySumUs;
+    uint64_t latencyMaxUs;
+    int32_t lastSequence[DJI_STEREO_IMAGE_CAMERA_NUM];
+} T_TestStereoConsumer;
+
+/* Private values -------------------------------------------------------------*/
+static const uint32_t s_stressPositions[TEST_STEREO_STRESS_CAMERA_NUM] = {
+    RECTIFY_DOWN_LEFT, RECTIFY_DOWN_RIGHT, RECTIFY_FRONT_LEFT, RECTIFY_RIGHT_RIGHT,
+};
+
+/* Private functions declaration ---------------------------------------------*/
+static T_DjiPerceptionImageInfo DjiTest_StereoMakeInfo(uint32_t cameraPosition, uint16_t sequence,
+                                                       uint32_t width, uint32_t height);
+static void DjiTest_StereoTestCameraIndex(void);
+static void DjiTest_StereoTestNewestImage(void);
+static void DjiTest_StereoTestWaitImage(void);
+static void *DjiTest_StereoConsumerTask(void *arg);
+static void DjiTest_StereoTestStress(void);
+static void DjiTest_StereoBenchmark(void);
+
+/* Exported functions definition ---------------------------------------------*/
+int main(void)
+{
+    if (ModuleTest_Init() != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        printf("register osal handler failed\r\n");
+        return 1;
+    }
+
+    DjiTest_StereoTestCameraIndex();
+    DjiTest_StereoTestNewestImage();
+    DjiTest_StereoTestWaitImage();
+    DjiTest_StereoTestStress();
+    DjiTest_StereoBenchmark();
+
+    return ModuleTest_Finish("test_stereo_image_buffer");
+}
+
+/* Private functions definition-----------------------------------------------*/
+static T_DjiPerceptionImageInfo DjiTest_StereoMakeInfo(uint32_t cameraPosition, uint16_t sequence,
+                                                       uint32_t width, uint32_t height)
+{
+    T_DjiPerceptionImageInfo info;
+    int32_t cameraIndex = DjiStereoImageBuffer_GetCameraIndex(cameraPosition);
+
+    memset(&info, 0, sizeof(info));
+    info.dataType = cameraPosition;
+    info.sequence = sequence;
+    info.rawInfo.width = width;
+    info.rawInfo.height = height;
+    info.rawInfo.bpp = 8;
+    info.rawInfo.direction = cameraIndex >= 0 ? (uint8_t) (cameraIndex / 2) : 0;
+
+    return info;
+}
+
+/**
+ * @brief Down to rear positions are numbered from 1, up to right from 21, each direction has a left and a right
+ * camera next to each other.
+ */
+static void DjiTest_StereoTestCameraIndex(void)
+{
+    MODULE_TEST_CHECK(DjiStereoImageBuffer_GetCameraIndex(RECTIFY_DOWN_LEFT) == 0);
+    MODULE_TEST_CHECK(DjiStereoImageBuffer_GetCameraIndex(RECTIFY_FRONT_RIGHT) == 3);
+    MODULE_TEST_CHECK(DjiStereoImageBuffer_GetCameraIndex(RECTIFY_REAR_RIGHT) == 5);
+    MODULE_TEST_CHECK(DjiStereoImageBuffer_GetCameraIndex(RECTIFY_UP_LEFT) == 2 * DJI_PERCEPTION_RECTIFY_UP);
+    MODULE_TEST_CHECK(DjiStereoImageBuffer_GetCameraIndex(RECTIFY_LEFT_RIGHT) == 2 * DJI_PERCEPTION_RECTIFY_LEFT + 1);
+    MODULE_TEST_CHECK(DjiStereoImageBuffer_GetCameraIndex(RECTIFY_RIGHT_RIGHT) == 11);
+    MODULE_TEST_CHECK(DjiStereoImageBuffer_GetCameraIndex(0) == -1);
+    MODULE_TEST_CHECK(DjiStereoImageBuffer_GetCameraIndex(7) == -1);
+    MODULE_TEST_CHECK(DjiStereoImageBuffer_GetCameraIndex(20) == -1);
+    MODULE_TEST_CHECK(DjiStereoImageBuffer_GetCameraIndex(27) == -1);
+}
+
+/**
+ * @brief The consumer gets the newest image of a camera once, the images it missed are counted as overwritten,
+ * missing sequence numbers as gaps. Slots are allocated for the first image and when an image grows.
+ */
+static void DjiTest_StereoTestNewestImage(void)
+{
+    DJIStereoImageBuffer buffer;
+    T_DjiStereoImageBufferStatistics statistics;
+    T_DjiPerceptionImageInfo info;
+    const T_DjiStereoImage *image;
+    const uint32_t frontLeft = (uint32_t) DjiStereoImageBuffer_GetCameraIndex(RECTIFY_FRONT_LEFT);
+    std::vector<uint8_t> data(64 * 48);
+    std::vector<uint8_t> largeData(128 * 96);
+
+    MODULE_TEST_CHECK(buffer.pushImage(DjiTest_StereoMakeInfo(RECTIFY_FRONT_LEFT, 0, 64, 48), data.data(),
+                                       data.size()) == DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE);
+    MODULE_TEST_CHECK(buffer.init() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(buffer.acquireImage(frontLeft) == nullptr);
+
+    data.assign(data.size(), 1);
+    MODULE_TEST_CHECK(buffer.pushImage(DjiTest_StereoMakeInfo(RECTIFY_FRONT_LEFT, 1, 64, 48), data.data(),
+                                       data.size()) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    image = buffer.acquireImage(frontLeft);
+    MODULE_TEST_CHECK(image != nullptr);
+    if (image != nullptr) {
+        MODULE_TEST_CHECK(image->info.sequence == 1 && image->dataLen == data.size() && image->data[0] == 1);
+        MODULE_TEST_CHECK(image->cameraIndex == frontLeft && image->direction == DJI_PERCEPTION_RECTIFY_FRONT);
+    }
+    MODULE_TEST_CHECK(buffer.acquireImage(frontLeft) == nullptr);
+
+    for (uint16_t sequence = 2; sequence <= 4; sequence++) {
+        data.assign(data.size(), (uint8_t) sequence);
+        MODULE_TEST_CHECK(buffer.pushImage(DjiTest_StereoMakeInfo(RECTIFY_FRONT_LEFT, sequence, 64, 48),
+                                           data.data(), data.size()) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    }
+    image = buffer.acquireImage(frontLeft);
+    MODULE_TEST_CHECK(image != nullptr && image->info.sequence == 4 && image->data[data.size() - 1] == 4);
+
+    //two images lost before sequence 7, a larger image grows the write slot only
+    largeData.assign(largeData.size(), 7);
+    MODULE_TEST_CHECK(buffer.pushImage(DjiTest_StereoMakeInfo(RECTIFY_FRONT_LEFT, 7, 128, 96), largeData.data(),
+                                       largeData.size()) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    image = buffer.acquireImage(frontLeft);
+    MODULE_TEST_CHECK(image != nullptr && image->dataLen == largeData.size() && image->data[0] == 7);
+
+    MODULE_TEST_CHECK(buffer.pushImage(DjiTest_StereoMakeInfo(RECTIFY_FRONT_RIGHT, 1, 64, 48), data.data(), 0) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER);
+    info = DjiTest_StereoMakeInfo(7, 1, 64, 48);
+    info.rawInfo.direction = DJI_PERCEPTION_RECTIFY_FRONT;
+    MODULE_TEST_CHECK(buffer.pushImage(info, data.data(), data.size()) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER);
+
+    buffer.getStatistics(DJI_PERCEPTION_RECTIFY_FRONT, &statistics);
+    MODULE_TEST_CHECK(statistics.imageCount == 5 && statistics.overwrittenImageCount == 2);
+    MODULE_TEST_CHECK(statistics.sequenceGapCount == 2 && statistics.droppedImageCount == 2);
+    MODULE_TEST_CHECK(statistics.allocCount == 4);
+    buffer.getStatistics(DJI_PERCEPTION_RECTIFY_DOWN, &statistics);
+    MODULE_TEST_CHECK(statistics.imageCount == 0 && statistics.droppedImageCount == 0);
+
+    buffer.cleanup();
+}
+
+/**
+ * @brief waitImage serves the cameras with an unread image round robin and times out without one.
+ */
+static void DjiTest_StereoTestWaitImage(void)
+{
+    DJIStereoImageBuffer buffer;
+    const T_DjiStereoImage *image;
+    std::vector<uint8_t> data(32 * 32, 0);
+    uint64_t startTimeUs;
+
+    MODULE_TEST_CHECK(buffer.init() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(buffer.pushImage(DjiTest_StereoMakeInfo(RECTIFY_RIGHT_RIGHT, 1, 32, 32), data.data(),
+                                       data.size()) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(buffer.pushImage(DjiTest_StereoMakeInfo(RECTIFY_DOWN_LEFT, 1, 32, 32), data.data(),
+                                       data.size()) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+    image = buffer.waitImage(TEST_STEREO_WAIT_TIMEOUT_MS);
+    MODULE_TEST_CHECK(image != nullptr && image->info.dataType == RECTIFY_DOWN_LEFT);
+    MODULE_TEST_CHECK(buffer.pushImage(DjiTest_StereoMakeInfo(RECTIFY_DOWN_LEFT, 2, 32, 32), data.data(),
+                                       data.size()) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    image = buffer.waitImage(TEST_STEREO_WAIT_TIMEOUT_MS);
+    MODULE_TEST_CHECK(image != nullptr && image->info.dataType == RECTIFY_RIGHT_RIGHT);
+    image = buffer.waitImage(TEST_STEREO_WAIT_TIMEOUT_MS);
+    MODULE_TEST_CHECK(image != nullptr && image->info.dataType == RECTIFY_DOWN_LEFT && image->info.sequence == 2);
+
+    //the three images taken without waiting left their posts, the fourth wait has none left and times out
+    startTimeUs = ModuleTest_GetTimeUs();
+    for (uint32_t i = 0; i < 4; i++) {
+        MODULE_TEST_CHECK(buffer.waitImage(TEST_STEREO_WAIT_TIMEOUT_MS) == nullptr);
+    }
+    MODULE_TEST_CHECK(ModuleTest_GetTimeUs() - startTimeUs >= TEST_STEREO_WAIT_TIMEOUT_MS * 1000);
+
+    buffer.cleanup();
+}
+
+static void *DjiTest_StereoConsumerTask(void *arg)
+{
+    T_TestStereoConsumer *consumer = (T_TestStereoConsumer *) arg;
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    const T_DjiStereoImage *image;
+    uint64_t nowUs = 0;
+    bool stopRequest;
+
+    for (uint32_t i = 0; i < DJI_STEREO_IMAGE_CAMERA_NUM; i++) {
+        consumer->lastSequence[i] = -1;
+    }
+
+    while (true) {
+        //read before waiting, the producer sets it after its last push
+        stopRequest = __atomic_load_n(&consumer->stopRequest, __ATOMIC_ACQUIRE);
+        image = consumer->buffer->waitImage(TEST_STEREO_WAIT_TIMEOUT_MS);
+        if (image == nullptr) {
+            if (stopRequest) {
+                break;
+            }
+            continue;
+        }
+
+        osalHandler->GetTimeUs(&nowUs);
+        consumer->imageCount++;
+        consumer->latencySumUs += nowUs - image->receiveTimeUs;
+        if (nowUs - image->receiveTimeUs > consumer->latencyMaxUs) {
+            consumer->latencyMaxUs = nowUs - image->receiveTimeUs;
+        }
+        if ((int32_t) image->info.sequence <= consumer->lastSequence[image->cameraIndex]) {
+            consumer->reorderedImageCount++;
+        }
+        consumer->lastSequence[image->cameraIndex] = image->info.sequence;
+
+        //every byte of an image is its sequence, a slot written while it is read shows two values
+        if (consumer->checkData) {
+            for (uint32_t i = 0; i < image->dataLen; i++) {
+                if (image->data[i] != (uint8_t) image->info.sequence) {
+                    consumer->tornImageCount++;
+                    break;
+                }
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * @brief One producer pushes images of four cameras as fast as it can while the consumer reads them. No image is
+ * torn or seen twice, and each pushed image is either read or counted as overwritten.
+ */
+static void DjiTest_StereoTestStress(void)
+{
+    DJIStereoImageBuffer buffer;
+    T_DjiStereoImageBufferStatistics statistics;
+    T_TestStereoConsumer consumer;
+    std::vector<uint8_t> data(TEST_STEREO_STRESS_IMAGE_SIZE);
+    uint64_t imageCount = 0;
+    uint64_t overwrittenImageCount = 0;
+    pthread_t consumerTask;
+
+    MODULE_TEST_CHECK(buffer.init() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    memset(&consumer, 0, sizeof(consumer));
+    consumer.buffer = &buffer;
+    consumer.checkData = true;
+    if (pthread_create(&consumerTask, nullptr, DjiTest_StereoConsumerTask, &consumer) != 0) {
+        MODULE_TEST_CHECK(false);
+        return;
+    }
+
+    for (uint32_t sequence = 0; sequence < TEST_STEREO_STRESS_IMAGES_PER_CAMERA; sequence++) {
+        data.assign(data.size(), (uint8_t) sequence);
+        for (uint32_t i = 0; i < TEST_STEREO_STRESS_CAMERA_NUM; i++) {
+            buffer.pushImage(DjiTest_StereoMakeInfo(s_stressPositions[i], (uint16_t) sequence, 64, 64), data.data(),
+                             data.size());
+        }
+    }
+    __atomic_store_n(&consumer.stopRequest, true, __ATOMIC_RELEASE);
+    pthread_join(consumerTask, nullptr);
+
+    for (uint32_t direction = 0; direction < IMAGE_MAX_DIRECTION_NUM; direction++) {
+        buffer.getStatistics((E_DjiPerceptionDirection) direction, &statistics);
+        imageCount += statistics.imageCount;
+        overwrittenImageCount += statistics.overwrittenImageCount;
+        MODULE_TEST_CHECK(statistics.sequenceGapCount == 0 && statistics.droppedImageCount == 0);
+        MODULE_TEST_CHECK(statistics.allocCount == (direction == DJI_PERCEPTION_RECTIFY_DOWN ? 6 :
+                                                    direction == DJI_PERCEPTION_RECTIFY_FRONT ||
+                                                    direction == DJI_PERCEPTION_RECTIFY_RIGHT ? 3 : 0));
+    }
+    MODULE_TEST_CHECK(imageCount == (uint64_t) TEST_STEREO_STRESS_CAMERA_NUM * TEST_STEREO_STRESS_IMAGES_PER_CAMERA);
+    MODULE_TEST_CHECK(consumer.imageCount + overwrittenImageCount == imageCount);
+    MODULE_TEST_CHECK(consumer.tornImageCount == 0 && consumer.reorderedImageCount == 0);
+
+    buffer.cleanup();
+}
+
+/**
+ * @brief Twelve cameras pushing VGA images back to back, with a consumer taking each image as it comes.
+ */
+static void DjiTest_StereoBenchmark(void)
+{
+    DJIStereoImageBuffer buffer;
+    T_DjiStereoImageBufferStatistics statistics;
+    T_TestStereoConsumer consumer;
+    std::vector<uint8_t> data(TEST_STEREO_BENCH_WIDTH * TEST_STEREO_BENCH_HEIGHT, 0x5a);
+    static const uint32_t cameraPositions[DJI_STEREO_IMAGE_CAMERA_NUM] = {
+        RECTIFY_DOWN_LEFT, RECTIFY_DOWN_RIGHT, RECTIFY_FRONT_LEFT, RECTIFY_FRONT_RIGHT, RECTIFY_REAR_LEFT,
+        RECTIFY_REAR_RIGHT, RECTIFY_UP_LEFT, RECTIFY_UP_RIGHT, RECTIFY_LEFT_LEFT, RECTIFY_LEFT_RIGHT,
+        RECTIFY_RIGHT_LEFT, RECTIFY_RIGHT_RIGHT,
+    };
+    uint64_t imageCount = 0;
+    uint64_t overwrittenImageCount = 0;
+    uint64_t pushTimeUs = 0;
+    uint32_t pushTimeMaxUs = 0;
+    uint32_t allocCount = 0;
+    uint64_t startTimeUs;
+    uint64_t elapsedUs;
+    pthread_t consumerTask;
+
+    MODULE_TEST_CHECK(buffer.init() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    memset(&consumer, 0, sizeof(consumer));
+    consumer.buffer = &buffer;
+    if (pthread_create(&consumerTask, nullptr, DjiTest_StereoConsumerTask, &consumer) != 0) {
+        MODULE_TEST_CHECK(false);
+        return;
+    }
+
+    startTimeUs = ModuleTest_GetTimeUs();
+    for (uint32_t sequence = 0; sequence < TEST_STEREO_BENCH_IMAGES_PER_CAMERA; sequence++) {
+        for (uint32_t i = 0; i < DJI_STEREO_IMAGE_CAMERA_NUM; i++) {
+            buffer.pushImage(DjiTest_StereoMakeInfo(cameraPositions[i], (uint16_t) sequence, TEST_STEREO_BENCH_WIDTH,
+                                                    TEST_STEREO_BENCH_HEIGHT), data.data(), data.size());
+        }
+    }
+    elapsedUs = ModuleTest_GetTimeUs() - startTimeUs;
+    __atomic_store_n(&consumer.stopRequest, true, __ATOMIC_RELEASE);
+    pthread_join(consumerTask, nullptr);
+
+    for (uint32_t direction = 0; direction < IMAGE_MAX_DIRECTION_NUM; direction++) {
+        buffer.getStatistics((E_DjiPerceptionDirection) direction, &statistics);
+        imageCount += statistics.imageCount;
+        overwrittenImageCount += statistics.overwrittenImageCount;
+        pushTimeUs += statistics.pushTimeUs;
+        allocCount += statistics.allocCount;
+        pushTimeMaxUs = statistics.pushTimeMaxUs > pushTimeMaxUs ? statistics.pushTimeMaxUs : pushTimeMaxUs;
+    }
+    MODULE_TEST_CHECK(imageCount == (uint64_t) DJI_STEREO_IMAGE_CAMERA_NUM * TEST_STEREO_BENCH_IMAGES_PER_CAMERA);
+    MODULE_TEST_CHECK(consumer.imageCount + overwrittenImageCount == imageCount);
+    MODULE_TEST_CHECK(allocCount == 3 * DJI_STEREO_IMAGE_CAMERA_NUM && consumer.reorderedImageCount == 0);
+    if (imageCount == 0 || consumer.imageCount == 0) {
+        return;
+    }
+
+    ModuleTest_Report("images pushed per second", (double) imageCount * 1000000 / elapsedUs, "images/s");
+    ModuleTest_Report("push throughput", (double) imageCount * data.size() / elapsedUs, "MB/s");
+    ModuleTest_Report("push time avg", (double) pushTimeUs / imageCount, "us");
+    ModuleTest_Report("push time max", (double) pushTimeMaxUs, "us");
+    ModuleTest_Report("images overwritten", (double) overwrittenImageCount * 100 / imageCount, "%");
+    ModuleTest_Report("hand-off latency avg", (double) consumer.latencySumUs / consumer.imageCount, "us");
+    ModuleTest_Report("hand-off latency max", (double) consumer.latencyMaxUs, "us");
+
+    buffer.cleanup();
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
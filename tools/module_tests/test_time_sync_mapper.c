@@ -0,0 +1,489 @@
+/**
+ ********************************************************************
+ * @file    test_time_sync_mapper.c
+ * @brief   Accuracy test and benchmark of the time sync mapper against a synthetic drifting clock.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "module_test.h"
+#include "time_sync/test_time_sync_mapper.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define TEST_TIME_SYNC_START_LOCAL_US           1000000000000ULL
+/* 2023-11-14 22:13:20, the aircraft time is this far ahead of the local time. */
+#define TEST_TIME_SYNC_AIRCRAFT_BASE_US         1700000000000000LL
+#define TEST_TIME_SYNC_SAMPLE_PERIOD_US         1000000
+#define TEST_TIME_SYNC_SAMPLE_NUM               3600
+#define TEST_TIME_SYNC_WARMUP_SAMPLE_NUM        60
+#define TEST_TIME_SYNC_DRIFT_PPM                25.0
+#define TEST_TIME_SYNC_SWING_PPM                0.5
+#define TEST_TIME_SYNC_SWING_PERIOD_S           1800.0
+#define TEST_TIME_SYNC_WALK_PPM                 0.01
+#define TEST_TIME_SYNC_JUMP_US                  1000000
+#define TEST_TIME_SYNC_CIVIL_STEP_S             3593
+#define TEST_TIME_SYNC_CIVIL_END_S              4102444800LL
+#define TEST_TIME_SYNC_BENCH_CONVERSION_NUM     10000000
+#define TEST_TIME_SYNC_BENCH_BATCH_SIZE         1000
+#define TEST_TIME_SYNC_BENCH_WRITER_PERIOD_US   1000
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    const char *name;
+    double sampleNoiseUs;
+    double configNoiseUs;
+    /* Percent of the samples moved by 1 to 5 ms, never two in a row. */
+    uint32_t outlierPercent;
+    /* Limits of the checks. */
+    double maxRmsUs;
+    double maxErrorUs;
+    double minBoundCoverage;
+} T_TestTimeSyncScenario;
+
+typedef struct {
+    double rmsUs;
+    double maxUs;
+    double rawRmsUs;
+    double rawMaxUs;
+    double boundCoverage;
+    uint32_t outlierNum;
+    T_DjiTestTimeSyncMapperModel model;
+} T_TestTimeSyncResult;
+
+typedef struct {
+    bool stopRequest;
+    uint32_t sampleCount;
+} T_TestTimeSyncWriter;
+
+/* Private values -------------------------------------------------------------*/
+static uint32_t s_randomSeed = 0x13579bdf;
+
+static const T_TestTimeSyncScenario s_scenarios[] = {
+    {"sample noise 1 us", 1, 1, 0, 1.5, 5, 0.99},
+    {"sample noise 5 us, 2% outliers", 5, 5, 2, 3, 12, 0.99},
+    {"sample noise 20 us", 20, 20, 0, 8, 30, 0.99},
+};
+
+/* Private functions declaration ---------------------------------------------*/
+static uint32_t DjiTest_TimeSyncRandom(void);
+static double DjiTest_TimeSyncGaussian(void);
+static void DjiTest_TimeSyncRunScenario(const T_TestTimeSyncScenario *scenario, T_TestTimeSyncResult *result);
+static void DjiTest_TimeSyncTestInit(void);
+static void DjiTest_TimeSyncTestAccuracy(void);
+static void DjiTest_TimeSyncTestJump(void);
+static void DjiTest_TimeSyncTestSampleSdk(void);
+static void DjiTest_TimeSyncTestCivilTime(void);
+static void *DjiTest_TimeSyncWriterTask(void *arg);
+static void DjiTest_TimeSyncBenchmark(void);
+T_DjiReturnCode __wrap_DjiTimeSync_TransferToAircraftTime(uint64_t localTimeUs,
+                                                          T_DjiTimeSyncAircraftTime *aircraftTime);
+
+/* Exported functions definition ---------------------------------------------*/
+int main(void)
+{
+    if (ModuleTest_Init() != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        printf("register osal handler failed\r\n");
+        return 1;
+    }
+
+    DjiTest_TimeSyncTestInit();
+    DjiTest_TimeSyncTestAccuracy();
+    DjiTest_TimeSyncTestJump();
+    DjiTest_TimeSyncTestSampleSdk();
+    DjiTest_TimeSyncTestCivilTime();
+    DjiTest_TimeSyncBenchmark();
+
+    return ModuleTest_Finish("test_time_sync_mapper");
+}
+
+/**
+ * @brief SDK conversion of a local clock running TEST_TIME_SYNC_DRIFT_PPM against the aircraft clock.
+ */
+T_DjiReturnCode __wrap_DjiTimeSync_TransferToAircraftTime(uint64_t localTimeUs,
+                                                          T_DjiTimeSyncAircraftTime *aircraftTime)
+{
+    double driftUs = (double) localTimeUs * TEST_TIME_SYNC_DRIFT_PPM * 1e-6;
+
+    DjiTest_TimeSyncMapperUsToAircraftTime(localTimeUs + TEST_TIME_SYNC_AIRCRAFT_BASE_US + llround(driftUs),
+                                           aircraftTime);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/* Private functions definition-----------------------------------------------*/
+static uint32_t DjiTest_TimeSyncRandom(void)
+{
+    s_randomSeed = s_randomSeed * 1103515245 + 12345;
+
+    return s_randomSeed >> 8;
+}
+
+static double DjiTest_TimeSyncGaussian(void)
+{
+    double u1 = ((double) DjiTest_TimeSyncRandom() + 1) / 16777217.0;
+    double u2 = (double) DjiTest_TimeSyncRandom() / 16777216.0;
+
+    return sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+}
+
+/**
+ * @brief One hour of 1 Hz samples of a local clock drifting 25 ppm with a temperature swing and a frequency random
+ * walk, quantised to microseconds like the SDK conversion. After each sample one timestamp at a random point before
+ * the next sample is converted and compared with the true aircraft time, as is applying the newest raw offset.
+ */
+static void DjiTest_TimeSyncRunScenario(const T_TestTimeSyncScenario *scenario, T_TestTimeSyncResult *result)
+{
+    T_DjiTestTimeSyncMapperConfig config;
+    uint64_t localTimeUs = TEST_TIME_SYNC_START_LOCAL_US;
+    uint64_t aircraftTimeUs;
+    uint64_t sampleAircraftTimeUs;
+    uint32_t errorBoundUs;
+    uint32_t dtUs;
+    uint32_t countedNum = 0;
+    uint32_t coveredNum = 0;
+    double trueOffsetUs = 0;
+    double walkPpm = 0;
+    double frequencyPpm;
+    double sampleErrorUs;
+    double queryOffsetUs;
+    double errorUs;
+    double rawErrorUs;
+    double sum = 0;
+    double rawSum = 0;
+    bool lastOutlier = false;
+    uint32_t i;
+
+    memset(result, 0, sizeof(T_TestTimeSyncResult));
+    DjiTest_TimeSyncMapperGetDefaultConfig(&config);
+    config.measurementNoiseUs = scenario->configNoiseUs;
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperInit(&config) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+    for (i = 0; i < TEST_TIME_SYNC_SAMPLE_NUM; i++) {
+        frequencyPpm = TEST_TIME_SYNC_DRIFT_PPM + walkPpm +
+                       TEST_TIME_SYNC_SWING_PPM * sin(2 * M_PI * i / TEST_TIME_SYNC_SWING_PERIOD_S);
+
+        sampleErrorUs = scenario->sampleNoiseUs * DjiTest_TimeSyncGaussian();
+        if (i > 2 && !lastOutlier && DjiTest_TimeSyncRandom() % 100 < scenario->outlierPercent) {
+            sampleErrorUs += (DjiTest_TimeSyncRandom() & 1 ? 1 : -1) * (1000.0 + DjiTest_TimeSyncRandom() % 4000);
+            result->outlierNum++;
+            lastOutlier = true;
+        } else {
+            lastOutlier = false;
+        }
+        sampleAircraftTimeUs = localTimeUs + TEST_TIME_SYNC_AIRCRAFT_BASE_US + llround(trueOffsetUs + sampleErrorUs);
+        MODULE_TEST_CHECK(DjiTest_TimeSyncMapperAddSample(localTimeUs, sampleAircraftTimeUs) ==
+                          DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+        dtUs = 1 + DjiTest_TimeSyncRandom() % (TEST_TIME_SYNC_SAMPLE_PERIOD_US - 1);
+        queryOffsetUs = trueOffsetUs + frequencyPpm * dtUs * 1e-6;
+        MODULE_TEST_CHECK(DjiTest_TimeSyncMapperLocalToAircraftUs(localTimeUs + dtUs, &aircraftTimeUs,
+                                                                  &errorBoundUs) ==
+                          DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+        if (i >= TEST_TIME_SYNC_WARMUP_SAMPLE_NUM) {
+            errorUs = (double) (int64_t) (aircraftTimeUs - localTimeUs - dtUs - TEST_TIME_SYNC_AIRCRAFT_BASE_US) -
+                      queryOffsetUs;
+            rawErrorUs = (double) (int64_t) (sampleAircraftTimeUs - localTimeUs - TEST_TIME_SYNC_AIRCRAFT_BASE_US) -
+                         queryOffsetUs;
+            sum += errorUs * errorUs;
+            rawSum += rawErrorUs * rawErrorUs;
+            result->maxUs = fabs(errorUs) > result->maxUs ? fabs(errorUs) : result->maxUs;
+            result->rawMaxUs = fabs(rawErrorUs) > result->rawMaxUs ? fabs(rawErrorUs) : result->rawMaxUs;
+            coveredNum += fabs(errorUs) <= errorBoundUs;
+            countedNum++;
+        }
+
+        //ppm over one second is microseconds
+        trueOffsetUs += frequencyPpm * TEST_TIME_SYNC_SAMPLE_PERIOD_US * 1e-6;
+        walkPpm += TEST_TIME_SYNC_WALK_PPM * DjiTest_TimeSyncGaussian();
+        localTimeUs += TEST_TIME_SYNC_SAMPLE_PERIOD_US;
+    }
+
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperGetModel(&result->model) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperDeInit() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+    result->rmsUs = sqrt(sum / countedNum);
+    result->rawRmsUs = sqrt(rawSum / countedNum);
+    result->boundCoverage = (double) coveredNum / countedNum;
+}
+
+/**
+ * @brief Bad configs are refused, a second init is busy until deinit, no conversion before the first sample.
+ */
+static void DjiTest_TimeSyncTestInit(void)
+{
+    T_DjiTestTimeSyncMapperConfig config;
+    uint64_t localTimeUs = TEST_TIME_SYNC_START_LOCAL_US;
+    uint64_t aircraftTimeUs;
+
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperInit(NULL) == DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER);
+    DjiTest_TimeSyncMapperGetDefaultConfig(&config);
+    config.measurementNoiseUs = 0;
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperInit(&config) == DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER);
+    DjiTest_TimeSyncMapperGetDefaultConfig(&config);
+    config.resetOutlierNum = 0;
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperInit(&config) == DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER);
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperAddSample(localTimeUs, localTimeUs) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER);
+
+    DjiTest_TimeSyncMapperGetDefaultConfig(&config);
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperInit(&config) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperInit(&config) == DJI_ERROR_SYSTEM_MODULE_CODE_BUSY);
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperLocalToAircraftUs(localTimeUs, &aircraftTimeUs, NULL) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_BUSY);
+
+    //a start that failed after the init deinits the mapper, so the next start can init it again
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperDeInit() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperInit(&config) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperAddSample(localTimeUs, localTimeUs + 5) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperAddSample(localTimeUs, localTimeUs + 5) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER);
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperLocalToAircraftUs(localTimeUs, &aircraftTimeUs, NULL) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(aircraftTimeUs == localTimeUs + 5);
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperDeInit() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+}
+
+/**
+ * @brief The model between samples is closer to the true aircraft time than the newest raw offset, its error bound
+ * holds, outliers are rejected without a restart and the drift is found.
+ */
+static void DjiTest_TimeSyncTestAccuracy(void)
+{
+    T_TestTimeSyncResult result;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(s_scenarios) / sizeof(s_scenarios[0]); i++) {
+        DjiTest_TimeSyncRunScenario(&s_scenarios[i], &result);
+
+        MODULE_TEST_CHECK(result.rmsUs < s_scenarios[i].maxRmsUs);
+        MODULE_TEST_CHECK(result.maxUs < s_scenarios[i].maxErrorUs);
+        MODULE_TEST_CHECK(result.rmsUs < result.rawRmsUs);
+        MODULE_TEST_CHECK(result.boundCoverage >= s_scenarios[i].minBoundCoverage);
+        MODULE_TEST_CHECK(result.model.rejectCount >= result.outlierNum);
+        MODULE_TEST_CHECK(result.model.resetCount == 0);
+        MODULE_TEST_CHECK(fabs(result.model.driftPpm - TEST_TIME_SYNC_DRIFT_PPM) < 2 * TEST_TIME_SYNC_SWING_PPM);
+
+        printf("  %s\r\n", s_scenarios[i].name);
+        ModuleTest_Report("mapped error rms", result.rmsUs, "us");
+        ModuleTest_Report("mapped error max", result.maxUs, "us");
+        ModuleTest_Report("newest raw offset error rms", result.rawRmsUs, "us");
+        ModuleTest_Report("newest raw offset error max", result.rawMaxUs, "us");
+        ModuleTest_Report("error bound coverage", result.boundCoverage * 100, "%");
+    }
+}
+
+/**
+ * @brief A jump of the aircraft time is rejected resetOutlierNum times, then the offset restarts and the drift of
+ * the local clock is kept.
+ */
+static void DjiTest_TimeSyncTestJump(void)
+{
+    T_DjiTestTimeSyncMapperConfig config;
+    T_DjiTestTimeSyncMapperModel model;
+    uint64_t localTimeUs = TEST_TIME_SYNC_START_LOCAL_US;
+    uint64_t aircraftTimeUs = 0;
+    uint64_t expectedTimeUs = 0;
+    double offsetUs = 0;
+    uint32_t i;
+
+    DjiTest_TimeSyncMapperGetDefaultConfig(&config);
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperInit(&config) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+    for (i = 0; i < 200; i++) {
+        expectedTimeUs = localTimeUs + TEST_TIME_SYNC_AIRCRAFT_BASE_US + llround(offsetUs);
+        if (i >= 100) {
+            expectedTimeUs += TEST_TIME_SYNC_JUMP_US;
+        }
+        MODULE_TEST_CHECK(DjiTest_TimeSyncMapperAddSample(localTimeUs, expectedTimeUs) ==
+                          DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+        MODULE_TEST_CHECK(DjiTest_TimeSyncMapperGetModel(&model) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+        if (i >= 100 && i < 100 + config.resetOutlierNum - 1) {
+            MODULE_TEST_CHECK(model.resetCount == 0);
+        }
+        offsetUs += TEST_TIME_SYNC_DRIFT_PPM;
+        localTimeUs += TEST_TIME_SYNC_SAMPLE_PERIOD_US;
+    }
+
+    MODULE_TEST_CHECK(model.resetCount == 1 && model.rejectCount == config.resetOutlierNum);
+    MODULE_TEST_CHECK(fabs(model.driftPpm - TEST_TIME_SYNC_DRIFT_PPM) < 0.5);
+    localTimeUs -= TEST_TIME_SYNC_SAMPLE_PERIOD_US;
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperLocalToAircraftUs(localTimeUs, &aircraftTimeUs, NULL) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(llabs((int64_t) (aircraftTimeUs - expectedTimeUs)) <= 2);
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperDeInit() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+}
+
+/**
+ * @brief The task path: sample the SDK conversion at the current local time and map the newest sample time back.
+ */
+static void DjiTest_TimeSyncTestSampleSdk(void)
+{
+    T_DjiTestTimeSyncMapperConfig config;
+    T_DjiTestTimeSyncMapperModel model;
+    T_DjiTimeSyncAircraftTime aircraftTime;
+    uint64_t aircraftTimeUs = 0;
+    uint32_t errorBoundUs = 0;
+    uint32_t i;
+
+    DjiTest_TimeSyncMapperGetDefaultConfig(&config);
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperInit(&config) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    for (i = 0; i < 5; i++) {
+        MODULE_TEST_CHECK(DjiTest_TimeSyncMapperSampleSdk() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+        usleep(10000);
+    }
+
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperGetModel(&model) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(model.sampleCount == 5 && model.rejectCount == 0);
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperLocalToAircraftUs(model.newestSampleLocalTimeUs, &aircraftTimeUs,
+                                                              &errorBoundUs) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    __wrap_DjiTimeSync_TransferToAircraftTime(model.newestSampleLocalTimeUs, &aircraftTime);
+    MODULE_TEST_CHECK(llabs((int64_t) (aircraftTimeUs - DjiTest_TimeSyncMapperAircraftTimeToUs(&aircraftTime))) <=
+                      errorBoundUs);
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperDeInit() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+}
+
+/**
+ * @brief Civil time of the aircraft against gmtime_r() from 1970 to 2100, and back to microseconds.
+ */
+static void DjiTest_TimeSyncTestCivilTime(void)
+{
+    T_DjiTimeSyncAircraftTime aircraftTime;
+    struct tm civilTime;
+    time_t seconds;
+    uint64_t timeUs;
+    uint32_t mismatchNum = 0;
+    int64_t i;
+
+    for (i = 0; i < TEST_TIME_SYNC_CIVIL_END_S; i += TEST_TIME_SYNC_CIVIL_STEP_S) {
+        seconds = (time_t) i;
+        gmtime_r(&seconds, &civilTime);
+        timeUs = (uint64_t) i * 1000000 + (uint64_t) (i % 1000000);
+        DjiTest_TimeSyncMapperUsToAircraftTime(timeUs, &aircraftTime);
+
+        if (aircraftTime.year != civilTime.tm_year + 1900 || aircraftTime.month != civilTime.tm_mon + 1 ||
+            aircraftTime.day != civilTime.tm_mday || aircraftTime.hour != civilTime.tm_hour ||
+            aircraftTime.minute != civilTime.tm_min || aircraftTime.second != civilTime.tm_sec ||
+            aircraftTime.microsecond != (uint32_t) (i % 1000000) ||
+            DjiTest_TimeSyncMapperAircraftTimeToUs(&aircraftTime) != timeUs) {
+            mismatchNum++;
+        }
+    }
+
+    MODULE_TEST_CHECK(mismatchNum == 0);
+}
+
+static void *DjiTest_TimeSyncWriterTask(void *arg)
+{
+    T_TestTimeSyncWriter *writer = (T_TestTimeSyncWriter *) arg;
+    uint64_t localTimeUs = TEST_TIME_SYNC_START_LOCAL_US;
+
+    while (!__atomic_load_n(&writer->stopRequest, __ATOMIC_ACQUIRE)) {
+        localTimeUs += TEST_TIME_SYNC_SAMPLE_PERIOD_US;
+        //25 ppm of drift and a few microseconds of noise, as the time sync task would see
+        DjiTest_TimeSyncMapperAddSample(localTimeUs, localTimeUs + TEST_TIME_SYNC_AIRCRAFT_BASE_US +
+                                                     (localTimeUs - TEST_TIME_SYNC_START_LOCAL_US) / 40000 +
+                                                     writer->sampleCount % 5);
+        writer->sampleCount++;
+        usleep(TEST_TIME_SYNC_BENCH_WRITER_PERIOD_US);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Conversions per second one by one and in batches, then one by one while a writer publishes a new model
+ * every millisecond, a thousand times the rate of the time sync task.
+ */
+static void DjiTest_TimeSyncBenchmark(void)
+{
+    T_DjiTestTimeSyncMapperConfig config;
+    T_TestTimeSyncWriter writer = {0};
+    static uint64_t localTimes[TEST_TIME_SYNC_BENCH_BATCH_SIZE];
+    static uint64_t aircraftTimes[TEST_TIME_SYNC_BENCH_BATCH_SIZE];
+    pthread_t writerTask;
+    uint64_t aircraftTimeUs;
+    uint64_t checksum = 0;
+    uint64_t startTimeUs;
+    uint64_t elapsedUs;
+    uint32_t errorBoundUs;
+    uint32_t busyNum = 0;
+    uint32_t i;
+
+    DjiTest_TimeSyncMapperGetDefaultConfig(&config);
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperInit(&config) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperAddSample(TEST_TIME_SYNC_START_LOCAL_US, TEST_TIME_SYNC_START_LOCAL_US +
+                                                      TEST_TIME_SYNC_AIRCRAFT_BASE_US) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+    startTimeUs = ModuleTest_GetTimeUs();
+    for (i = 0; i < TEST_TIME_SYNC_BENCH_CONVERSION_NUM; i++) {
+        DjiTest_TimeSyncMapperLocalToAircraftUs(TEST_TIME_SYNC_START_LOCAL_US + i, &aircraftTimeUs, &errorBoundUs);
+        checksum += aircraftTimeUs;
+    }
+    elapsedUs = ModuleTest_GetTimeUs() - startTimeUs;
+    ModuleTest_Report("single conversions", (double) TEST_TIME_SYNC_BENCH_CONVERSION_NUM / elapsedUs, "M/s");
+
+    for (i = 0; i < TEST_TIME_SYNC_BENCH_BATCH_SIZE; i++) {
+        localTimes[i] = TEST_TIME_SYNC_START_LOCAL_US + i * 10;
+    }
+    startTimeUs = ModuleTest_GetTimeUs();
+    for (i = 0; i < TEST_TIME_SYNC_BENCH_CONVERSION_NUM / TEST_TIME_SYNC_BENCH_BATCH_SIZE; i++) {
+        DjiTest_TimeSyncMapperLocalToAircraftUsBatch(localTimes, aircraftTimes, TEST_TIME_SYNC_BENCH_BATCH_SIZE,
+                                                     &errorBoundUs);
+        checksum += aircraftTimes[i % TEST_TIME_SYNC_BENCH_BATCH_SIZE];
+    }
+    elapsedUs = ModuleTest_GetTimeUs() - startTimeUs;
+    ModuleTest_Report("batch conversions, 1000 per batch", (double) TEST_TIME_SYNC_BENCH_CONVERSION_NUM / elapsedUs,
+                      "M/s");
+
+    if (pthread_create(&writerTask, NULL, DjiTest_TimeSyncWriterTask, &writer) != 0) {
+        MODULE_TEST_CHECK(false);
+        DjiTest_TimeSyncMapperDeInit();
+        return;
+    }
+    startTimeUs = ModuleTest_GetTimeUs();
+    for (i = 0; i < TEST_TIME_SYNC_BENCH_CONVERSION_NUM; i++) {
+        if (DjiTest_TimeSyncMapperLocalToAircraftUs(TEST_TIME_SYNC_START_LOCAL_US + i, &aircraftTimeUs,
+                                                    &errorBoundUs) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            busyNum++;
+        }
+        checksum += aircraftTimeUs;
+    }
+    elapsedUs = ModuleTest_GetTimeUs() - startTimeUs;
+    __atomic_store_n(&writer.stopRequest, true, __ATOMIC_RELEASE);
+    pthread_join(writerTask, NULL);
+
+    ModuleTest_Report("single conversions, model published every 1 ms",
+                      (double) TEST_TIME_SYNC_BENCH_CONVERSION_NUM / elapsedUs, "M/s");
+    ModuleTest_Report("busy conversions, model published every 1 ms", busyNum, "");
+    MODULE_TEST_CHECK(writer.sampleCount > 0 && busyNum < TEST_TIME_SYNC_BENCH_CONVERSION_NUM / 100);
+    MODULE_TEST_CHECK(checksum != 0);
+    MODULE_TEST_CHECK(DjiTest_TimeSyncMapperDeInit() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,459 @@
+/**
+ ********************************************************************
+ * @file    test_util_attitude.c
+ * @brief   Reference test and benchmark of the attitude math module.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "module_test.h"
+#include "utils/util_attitude.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define TEST_ATTITUDE_TRIG_SAMPLE_NUM       2000000
+#define TEST_ATTITUDE_ROUND_TRIP_NUM        200000
+/* Round trips are done in float, the fast trig error adds to a few float ulps of the products. */
+#define TEST_ATTITUDE_ROUND_TRIP_MAX_ERROR  1e-5
+#define TEST_ATTITUDE_REFERENCE_MAX_ERROR   1e-5
+#define TEST_ATTITUDE_BENCH_COUNT           100000
+#define TEST_ATTITUDE_BENCH_REPEAT          100
+
+/* Private types -------------------------------------------------------------*/
+
+/* Private values -------------------------------------------------------------*/
+static uint32_t s_randomSeed = 0x9e3779b9;
+
+/* Private functions declaration ---------------------------------------------*/
+static uint32_t DjiTest_AttitudeRandom(void);
+static dji_f32_t DjiTest_AttitudeUniform(dji_f32_t min, dji_f32_t max);
+static T_UtilAttitudeEuler DjiTest_AttitudeRandomEuler(void);
+static double DjiTest_AttitudeAngleError(double a, double b);
+static double DjiTest_AttitudeQuaternionError(T_UtilAttitudeQuaternion a, T_UtilAttitudeQuaternion b);
+static T_UtilAttitudeEuler DjiTest_AttitudeQuaternionToEulerLibm(T_UtilAttitudeQuaternion q);
+static void DjiTest_AttitudeTestFastTrig(void);
+static void DjiTest_AttitudeTestReference(void);
+static void DjiTest_AttitudeTestRoundTrip(void);
+static void DjiTest_AttitudeTestSlerp(void);
+static void DjiTest_AttitudeTestBatch(void);
+static void DjiTest_AttitudeBenchmark(void);
+
+/* Exported functions definition ---------------------------------------------*/
+int main(void)
+{
+    DjiTest_AttitudeTestFastTrig();
+    DjiTest_AttitudeTestReference();
+    DjiTest_AttitudeTestRoundTrip();
+    DjiTest_AttitudeTestSlerp();
+    DjiTest_AttitudeTestBatch();
+    DjiTest_AttitudeBenchmark();
+
+    return ModuleTest_Finish("test_util_attitude");
+}
+
+/* Private functions definition-----------------------------------------------*/
+static uint32_t DjiTest_AttitudeRandom(void)
+{
+    s_randomSeed = s_randomSeed * 1103515245 + 12345;
+
+    return s_randomSeed >> 8;
+}
+
+static dji_f32_t DjiTest_AttitudeUniform(dji_f32_t min, dji_f32_t max)
+{
+    return min + (max - min) * (dji_f32_t) DjiTest_AttitudeRandom() / 16777216.0f;
+}
+
+/* Pitch stays 5 degrees away from +-90, where roll and yaw are not separable. */
+static T_UtilAttitudeEuler DjiTest_AttitudeRandomEuler(void)
+{
+    T_UtilAttitudeEuler euler;
+
+    euler.roll = DjiTest_AttitudeUniform(-UTIL_ATTITUDE_PI, UTIL_ATTITUDE_PI);
+    euler.pitch = DjiTest_AttitudeUniform(-85 * UTIL_ATTITUDE_DEG_TO_RAD, 85 * UTIL_ATTITUDE_DEG_TO_RAD);
+    euler.yaw = DjiTest_AttitudeUniform(-UTIL_ATTITUDE_PI, UTIL_ATTITUDE_PI);
+
+    return euler;
+}
+
+/* Difference of two angles in radian, +-pi are the same angle. */
+static double DjiTest_AttitudeAngleError(double a, double b)
+{
+    double error = fmod(fabs(a - b), 2 * M_PI);
+
+    return error > M_PI ? 2 * M_PI - error : error;
+}
+
+/* q and -q are the same rotation. */
+static double DjiTest_AttitudeQuaternionError(T_UtilAttitudeQuaternion a, T_UtilAttitudeQuaternion b)
+{
+    double sameSign = fabs(a.q0 - b.q0) + fabs(a.q1 - b.q1) + fabs(a.q2 - b.q2) + fabs(a.q3 - b.q3);
+    double oppositeSign = fabs(a.q0 + b.q0) + fabs(a.q1 + b.q1) + fabs(a.q2 + b.q2) + fabs(a.q3 + b.q3);
+
+    return sameSign < oppositeSign ? sameSign : oppositeSign;
+}
+
+/* The double precision libm conversion the samples used before the module. */
+static T_UtilAttitudeEuler DjiTest_AttitudeQuaternionToEulerLibm(T_UtilAttitudeQuaternion q)
+{
+    T_UtilAttitudeEuler euler;
+    double sinPitch = 2.0 * ((double) q.q0 * q.q2 - (double) q.q1 * q.q3);
+
+    sinPitch = sinPitch > 1.0 ? 1.0 : (sinPitch < -1.0 ? -1.0 : sinPitch);
+    euler.roll = (dji_f32_t) atan2(2.0 * ((double) q.q0 * q.q1 + (double) q.q2 * q.q3),
+                                   1.0 - 2.0 * ((double) q.q1 * q.q1 + (double) q.q2 * q.q2));
+    euler.pitch = (dji_f32_t) asin(sinPitch);
+    euler.yaw = (dji_f32_t) atan2(2.0 * ((double) q.q0 * q.q3 + (double) q.q1 * q.q2),
+                                  1.0 - 2.0 * ((double) q.q2 * q.q2 + (double) q.q3 * q.q3));
+
+    return euler;
+}
+
+/**
+ * @brief Fast atan2, asin and sqrt against libm in double, over random inputs and the edge cases.
+ */
+static void DjiTest_AttitudeTestFastTrig(void)
+{
+    double atan2MaxError = 0;
+    double asinMaxError = 0;
+    double sqrtMaxError = 0;
+    double error;
+    dji_f32_t angle;
+    dji_f32_t radius;
+    dji_f32_t x;
+    dji_f32_t y;
+    uint32_t i;
+
+    for (i = 0; i < TEST_ATTITUDE_TRIG_SAMPLE_NUM; i++) {
+        angle = DjiTest_AttitudeUniform(-UTIL_ATTITUDE_PI, UTIL_ATTITUDE_PI);
+        radius = DjiTest_AttitudeUniform(1e-3f, 1e3f);
+        x = radius * cosf(angle);
+        y = radius * sinf(angle);
+        error = DjiTest_AttitudeAngleError(UtilAttitude_FastAtan2f(y, x), atan2((double) y, (double) x));
+        atan2MaxError = error > atan2MaxError ? error : atan2MaxError;
+
+        x = DjiTest_AttitudeUniform(-1.0f, 1.0f);
+        error = fabs(UtilAttitude_FastAsinf(x) - asin((double) x));
+        asinMaxError = error > asinMaxError ? error : asinMaxError;
+
+        x = DjiTest_AttitudeUniform(0.0f, 4.0f);
+        error = fabs(UtilAttitude_FastSqrtf(x) - sqrt((double) x)) / (sqrt((double) x) + 1e-30);
+        sqrtMaxError = error > sqrtMaxError ? error : sqrtMaxError;
+    }
+
+    MODULE_TEST_CHECK(atan2MaxError <= UTIL_ATTITUDE_FAST_TRIG_MAX_ERROR);
+    MODULE_TEST_CHECK(asinMaxError <= UTIL_ATTITUDE_FAST_TRIG_MAX_ERROR);
+    MODULE_TEST_CHECK(sqrtMaxError < 1e-6);
+    ModuleTest_Report("fast atan2 max error", atan2MaxError * 1e6, "urad");
+    ModuleTest_Report("fast asin max error", asinMaxError * 1e6, "urad");
+    ModuleTest_Report("fast sqrt max relative error", sqrtMaxError * 1e6, "ppm");
+
+    MODULE_TEST_CHECK(UtilAttitude_FastAtan2f(0.0f, 0.0f) == 0.0f);
+    MODULE_TEST_CHECK(fabs(UtilAttitude_FastAtan2f(0.0f, 1.0f)) <= UTIL_ATTITUDE_FAST_TRIG_MAX_ERROR);
+    MODULE_TEST_CHECK(fabs(UtilAttitude_FastAtan2f(1.0f, 0.0f) - M_PI_2) <= UTIL_ATTITUDE_FAST_TRIG_MAX_ERROR);
+    MODULE_TEST_CHECK(fabs(UtilAttitude_FastAtan2f(-1.0f, 0.0f) + M_PI_2) <= UTIL_ATTITUDE_FAST_TRIG_MAX_ERROR);
+    MODULE_TEST_CHECK(fabs(UtilAttitude_FastAtan2f(0.0f, -1.0f) - M_PI) <= UTIL_ATTITUDE_FAST_TRIG_MAX_ERROR);
+    MODULE_TEST_CHECK(fabs(UtilAttitude_FastAsinf(1.0f) - M_PI_2) <= UTIL_ATTITUDE_FAST_TRIG_MAX_ERROR);
+    MODULE_TEST_CHECK(fabs(UtilAttitude_FastAsinf(-1.0f) + M_PI_2) <= UTIL_ATTITUDE_FAST_TRIG_MAX_ERROR);
+    //a sine pushed above one by rounding is clamped instead of giving nan
+    MODULE_TEST_CHECK(fabs(UtilAttitude_FastAsinf(1.0001f) - M_PI_2) <= UTIL_ATTITUDE_FAST_TRIG_MAX_ERROR);
+    MODULE_TEST_CHECK(UtilAttitude_FastSqrtf(0.0f) == 0.0f);
+}
+
+/**
+ * @brief Conversions of known rotations against values worked out by hand, and Euler angles against the product
+ * of the three axis rotations in double.
+ */
+static void DjiTest_AttitudeTestReference(void)
+{
+    T_UtilAttitudeEuler euler = {0, 0, 30 * UTIL_ATTITUDE_DEG_TO_RAD};
+    T_UtilAttitudeQuaternion expected = {0.965926f, 0, 0, 0.258819f};
+    T_UtilAttitudeQuaternion q;
+    T_UtilAttitudeQuaternion axisRoll;
+    T_UtilAttitudeQuaternion axisPitch;
+    T_UtilAttitudeQuaternion axisYaw;
+    T_UtilAttitudeQuaternion zero = {0, 0, 0, 0};
+    T_UtilAttitudeMatrix matrix;
+    double cr;
+    double sr;
+    double cp;
+    double sp;
+    double cy;
+    double sy;
+    double reference[9];
+    double maxError = 0;
+    uint32_t i;
+
+    q = UtilAttitude_EulerToQuaternion(euler);
+    MODULE_TEST_CHECK(DjiTest_AttitudeQuaternionError(q, expected) < TEST_ATTITUDE_REFERENCE_MAX_ERROR);
+
+    euler.roll = 90 * UTIL_ATTITUDE_DEG_TO_RAD;
+    euler.yaw = 0;
+    expected.q0 = 0.707107f;
+    expected.q1 = 0.707107f;
+    expected.q3 = 0;
+    q = UtilAttitude_EulerToQuaternion(euler);
+    MODULE_TEST_CHECK(DjiTest_AttitudeQuaternionError(q, expected) < TEST_ATTITUDE_REFERENCE_MAX_ERROR);
+
+    //nose 30 degrees up: the body x axis points forward and up, z of ground frame points down
+    euler.roll = 0;
+    euler.pitch = 30 * UTIL_ATTITUDE_DEG_TO_RAD;
+    matrix = UtilAttitude_EulerToMatrix(euler);
+    MODULE_TEST_CHECK(fabs(matrix.m[0] - 0.866025) < TEST_ATTITUDE_REFERENCE_MAX_ERROR);
+    MODULE_TEST_CHECK(fabs(matrix.m[6] + 0.5) < TEST_ATTITUDE_REFERENCE_MAX_ERROR);
+
+    //yaw 30 then yaw 60 is yaw 90
+    axisYaw = UtilAttitude_EulerToQuaternion((T_UtilAttitudeEuler) {0, 0, 30 * UTIL_ATTITUDE_DEG_TO_RAD});
+    q = UtilAttitude_QuaternionMultiply(
+        UtilAttitude_EulerToQuaternion((T_UtilAttitudeEuler) {0, 0, 60 * UTIL_ATTITUDE_DEG_TO_RAD}), axisYaw);
+    MODULE_TEST_CHECK(fabs(UtilAttitude_QuaternionToEuler(q).yaw - M_PI_2) < TEST_ATTITUDE_REFERENCE_MAX_ERROR);
+
+    q = UtilAttitude_QuaternionNormalize(zero);
+    MODULE_TEST_CHECK(q.q0 == 1.0f && q.q1 == 0.0f && q.q2 == 0.0f && q.q3 == 0.0f);
+
+    for (i = 0; i < TEST_ATTITUDE_ROUND_TRIP_NUM; i++) {
+        euler = DjiTest_AttitudeRandomEuler();
+
+        //Z-Y-X: yaw about z, then pitch about the new y, then roll about the new x
+        axisRoll = (T_UtilAttitudeQuaternion) {cosf(euler.roll / 2), sinf(euler.roll / 2), 0, 0};
+        axisPitch = (T_UtilAttitudeQuaternion) {cosf(euler.pitch / 2), 0, sinf(euler.pitch / 2), 0};
+        axisYaw = (T_UtilAttitudeQuaternion) {cosf(euler.yaw / 2), 0, 0, sinf(euler.yaw / 2)};
+        expected = UtilAttitude_QuaternionMultiply(axisYaw, UtilAttitude_QuaternionMultiply(axisPitch, axisRoll));
+        q = UtilAttitude_EulerToQuaternion(euler);
+        maxError = fmax(maxError, DjiTest_AttitudeQuaternionError(q, expected));
+
+        cr = cos(euler.roll);
+        sr = sin(euler.roll);
+        cp = cos(euler.pitch);
+        sp = sin(euler.pitch);
+        cy = cos(euler.yaw);
+        sy = sin(euler.yaw);
+        reference[0] = cy * cp;
+        reference[1] = cy * sp * sr - sy * cr;
+        reference[2] = cy * sp * cr + sy * sr;
+        reference[3] = sy * cp;
+        reference[4] = sy * sp * sr + cy * cr;
+        reference[5] = sy * sp * cr - cy * sr;
+        reference[6] = -sp;
+        reference[7] = cp * sr;
+        reference[8] = cp * cr;
+        matrix = UtilAttitude_QuaternionToMatrix(q);
+        maxError = fmax(maxError, fabs(matrix.m[0] - reference[0]) + fabs(matrix.m[1] - reference[1]) +
+                                  fabs(matrix.m[2] - reference[2]) + fabs(matrix.m[3] - reference[3]) +
+                                  fabs(matrix.m[4] - reference[4]) + fabs(matrix.m[5] - reference[5]) +
+                                  fabs(matrix.m[6] - reference[6]) + fabs(matrix.m[7] - reference[7]) +
+                                  fabs(matrix.m[8] - reference[8]));
+    }
+
+    MODULE_TEST_CHECK(maxError < TEST_ATTITUDE_REFERENCE_MAX_ERROR);
+    ModuleTest_Report("conversion vs reference max error", maxError * 1e6, "ppm");
+}
+
+/**
+ * @brief Euler to quaternion and to matrix and back, quaternion to matrix and back, including the half turns which
+ * take the other branches of the matrix to quaternion conversion.
+ */
+static void DjiTest_AttitudeTestRoundTrip(void)
+{
+    const T_UtilAttitudeQuaternion halfTurns[] = {
+        {1, 0, 0, 0},
+        {0, 1, 0, 0},
+        {0, 0, 1, 0},
+        {0, 0, 0, 1},
+        {0, 0.6f, 0.8f, 0},
+    };
+    T_UtilAttitudeEuler euler;
+    T_UtilAttitudeEuler result;
+    T_UtilAttitudeQuaternion q;
+    T_UtilAttitudeMatrix matrix;
+    double quaternionMaxError = 0;
+    double matrixMaxError = 0;
+    double error;
+    uint32_t i;
+
+    for (i = 0; i < TEST_ATTITUDE_ROUND_TRIP_NUM; i++) {
+        euler = DjiTest_AttitudeRandomEuler();
+
+        q = UtilAttitude_EulerToQuaternion(euler);
+        result = UtilAttitude_QuaternionToEuler(q);
+        error = fmax(DjiTest_AttitudeAngleError(result.roll, euler.roll),
+                     fmax(DjiTest_AttitudeAngleError(result.pitch, euler.pitch),
+                          DjiTest_AttitudeAngleError(result.yaw, euler.yaw)));
+        quaternionMaxError = fmax(quaternionMaxError, error);
+
+        matrix = UtilAttitude_EulerToMatrix(euler);
+        result = UtilAttitude_MatrixToEuler(&matrix);
+        error = fmax(DjiTest_AttitudeAngleError(result.roll, euler.roll),
+                     fmax(DjiTest_AttitudeAngleError(result.pitch, euler.pitch),
+                          DjiTest_AttitudeAngleError(result.yaw, euler.yaw)));
+        matrixMaxError = fmax(matrixMaxError, error);
+
+        error = DjiTest_AttitudeQuaternionError(UtilAttitude_MatrixToQuaternion(&matrix), q);
+        MODULE_TEST_CHECK(error < TEST_ATTITUDE_ROUND_TRIP_MAX_ERROR);
+        MODULE_TEST_CHECK(UtilAttitude_MatrixToQuaternion(&matrix).q0 >= 0.0f);
+    }
+
+    MODULE_TEST_CHECK(quaternionMaxError < TEST_ATTITUDE_ROUND_TRIP_MAX_ERROR);
+    MODULE_TEST_CHECK(matrixMaxError < TEST_ATTITUDE_ROUND_TRIP_MAX_ERROR);
+    ModuleTest_Report("euler quaternion euler max error", quaternionMaxError * 1e6, "urad");
+    ModuleTest_Report("euler matrix euler max error", matrixMaxError * 1e6, "urad");
+
+    for (i = 0; i < sizeof(halfTurns) / sizeof(halfTurns[0]); i++) {
+        matrix = UtilAttitude_QuaternionToMatrix(halfTurns[i]);
+        q = UtilAttitude_MatrixToQuaternion(&matrix);
+        MODULE_TEST_CHECK(DjiTest_AttitudeQuaternionError(q, halfTurns[i]) < TEST_ATTITUDE_ROUND_TRIP_MAX_ERROR);
+    }
+}
+
+/**
+ * @brief SLERP of a quarter turn of yaw, along the shorter arc whatever the sign of the end quaternion, and between
+ * nearly equal quaternions where it interpolates linearly.
+ */
+static void DjiTest_AttitudeTestSlerp(void)
+{
+    T_UtilAttitudeQuaternion a = UtilAttitude_EulerToQuaternion((T_UtilAttitudeEuler) {0, 0, 0});
+    T_UtilAttitudeQuaternion b = UtilAttitude_EulerToQuaternion((T_UtilAttitudeEuler) {0, 0, UTIL_ATTITUDE_HALF_PI});
+    T_UtilAttitudeQuaternion negativeB = {-b.q0, -b.q1, -b.q2, -b.q3};
+    T_UtilAttitudeQuaternion close = UtilAttitude_EulerToQuaternion((T_UtilAttitudeEuler) {0, 0, 0.01f});
+    T_UtilAttitudeQuaternion q;
+    dji_f32_t t;
+
+    MODULE_TEST_CHECK(DjiTest_AttitudeQuaternionError(UtilAttitude_QuaternionSlerp(a, b, 0), a) < 1e-6);
+    MODULE_TEST_CHECK(DjiTest_AttitudeQuaternionError(UtilAttitude_QuaternionSlerp(a, b, 1), b) < 1e-6);
+
+    for (t = 0; t <= 1.0f; t += 0.125f) {
+        q = UtilAttitude_QuaternionSlerp(a, b, t);
+        MODULE_TEST_CHECK(fabs(UtilAttitude_QuaternionToEuler(q).yaw - t * M_PI_2) < TEST_ATTITUDE_REFERENCE_MAX_ERROR);
+        q = UtilAttitude_QuaternionSlerp(a, negativeB, t);
+        MODULE_TEST_CHECK(fabs(UtilAttitude_QuaternionToEuler(q).yaw - t * M_PI_2) < TEST_ATTITUDE_REFERENCE_MAX_ERROR);
+    }
+
+    q = UtilAttitude_QuaternionSlerp(a, close, 0.5f);
+    MODULE_TEST_CHECK(fabs(UtilAttitude_QuaternionToEuler(q).yaw - 0.005) < TEST_ATTITUDE_REFERENCE_MAX_ERROR);
+    MODULE_TEST_CHECK(fabs(q.q0 * q.q0 + q.q1 * q.q1 + q.q2 * q.q2 + q.q3 * q.q3 - 1) < 1e-6);
+}
+
+/**
+ * @brief The batch conversions give the scalar results, the vectorized loops may only differ by rounding.
+ */
+static void DjiTest_AttitudeTestBatch(void)
+{
+    static T_UtilAttitudeEuler euler[TEST_ATTITUDE_BENCH_COUNT];
+    static T_UtilAttitudeEuler result[TEST_ATTITUDE_BENCH_COUNT];
+    static T_UtilAttitudeQuaternion q[TEST_ATTITUDE_BENCH_COUNT];
+    static T_UtilAttitudeMatrix matrix[TEST_ATTITUDE_BENCH_COUNT];
+    T_UtilAttitudeEuler scalarEuler;
+    T_UtilAttitudeMatrix scalarMatrix;
+    double maxError = 0;
+    uint32_t i;
+    uint32_t j;
+
+    for (i = 0; i < TEST_ATTITUDE_BENCH_COUNT; i++) {
+        euler[i] = DjiTest_AttitudeRandomEuler();
+    }
+
+    UtilAttitude_EulerToQuaternionBatch(euler, q, TEST_ATTITUDE_BENCH_COUNT);
+    UtilAttitude_QuaternionToEulerBatch(q, result, TEST_ATTITUDE_BENCH_COUNT);
+    UtilAttitude_QuaternionToMatrixBatch(q, matrix, TEST_ATTITUDE_BENCH_COUNT);
+    for (i = 0; i < TEST_ATTITUDE_BENCH_COUNT; i++) {
+        maxError = fmax(maxError, DjiTest_AttitudeQuaternionError(q[i], UtilAttitude_EulerToQuaternion(euler[i])));
+        scalarEuler = UtilAttitude_QuaternionToEuler(q[i]);
+        maxError = fmax(maxError, fabs(result[i].roll - scalarEuler.roll) +
+                                  fabs(result[i].pitch - scalarEuler.pitch) + fabs(result[i].yaw - scalarEuler.yaw));
+        scalarMatrix = UtilAttitude_QuaternionToMatrix(q[i]);
+        for (j = 0; j < 9; j++) {
+            maxError = fmax(maxError, fabs(matrix[i].m[j] - scalarMatrix.m[j]));
+        }
+    }
+
+    UtilAttitude_MatrixToEulerBatch(matrix, result, TEST_ATTITUDE_BENCH_COUNT);
+    for (i = 0; i < TEST_ATTITUDE_BENCH_COUNT; i++) {
+        scalarEuler = UtilAttitude_MatrixToEuler(&matrix[i]);
+        maxError = fmax(maxError, fabs(result[i].roll - scalarEuler.roll) +
+                                  fabs(result[i].pitch - scalarEuler.pitch) + fabs(result[i].yaw - scalarEuler.yaw));
+    }
+
+    MODULE_TEST_CHECK(maxError < 1e-6);
+}
+
+/**
+ * @brief Conversions per second of the batch functions, and of quaternion to Euler in double libm as the samples
+ * did before.
+ */
+static void DjiTest_AttitudeBenchmark(void)
+{
+    static T_UtilAttitudeEuler euler[TEST_ATTITUDE_BENCH_COUNT];
+    static T_UtilAttitudeQuaternion q[TEST_ATTITUDE_BENCH_COUNT];
+    static T_UtilAttitudeMatrix matrix[TEST_ATTITUDE_BENCH_COUNT];
+    double conversionNum = (double) TEST_ATTITUDE_BENCH_COUNT * TEST_ATTITUDE_BENCH_REPEAT;
+    double checksum = 0;
+    uint64_t startTimeUs;
+    uint32_t repeat;
+    uint32_t i;
+
+    for (i = 0; i < TEST_ATTITUDE_BENCH_COUNT; i++) {
+        q[i] = UtilAttitude_EulerToQuaternion(DjiTest_AttitudeRandomEuler());
+    }
+
+    startTimeUs = ModuleTest_GetTimeUs();
+    for (repeat = 0; repeat < TEST_ATTITUDE_BENCH_REPEAT; repeat++) {
+        for (i = 0; i < TEST_ATTITUDE_BENCH_COUNT; i++) {
+            euler[i] = DjiTest_AttitudeQuaternionToEulerLibm(q[i]);
+        }
+        checksum += euler[repeat].yaw;
+    }
+    ModuleTest_Report("quaternion to euler, double libm", conversionNum / (ModuleTest_GetTimeUs() - startTimeUs),
+                      "M/s");
+
+    startTimeUs = ModuleTest_GetTimeUs();
+    for (repeat = 0; repeat < TEST_ATTITUDE_BENCH_REPEAT; repeat++) {
+        UtilAttitude_QuaternionToEulerBatch(q, euler, TEST_ATTITUDE_BENCH_COUNT);
+        checksum += euler[repeat].yaw;
+    }
+    ModuleTest_Report("quaternion to euler batch", conversionNum / (ModuleTest_GetTimeUs() - startTimeUs), "M/s");
+
+    startTimeUs = ModuleTest_GetTimeUs();
+    for (repeat = 0; repeat < TEST_ATTITUDE_BENCH_REPEAT; repeat++) {
+        UtilAttitude_EulerToQuaternionBatch(euler, q, TEST_ATTITUDE_BENCH_COUNT);
+        checksum += q[repeat].q0;
+    }
+    ModuleTest_Report("euler to quaternion batch", conversionNum / (ModuleTest_GetTimeUs() - startTimeUs), "M/s");
+
+    startTimeUs = ModuleTest_GetTimeUs();
+    for (repeat = 0; repeat < TEST_ATTITUDE_BENCH_REPEAT; repeat++) {
+        UtilAttitude_QuaternionToMatrixBatch(q, matrix, TEST_ATTITUDE_BENCH_COUNT);
+        checksum += matrix[repeat].m[0];
+    }
+    ModuleTest_Report("quaternion to matrix batch", conversionNum / (ModuleTest_GetTimeUs() - startTimeUs), "M/s");
+
+    startTimeUs = ModuleTest_GetTimeUs();
+    for (repeat = 0; repeat < TEST_ATTITUDE_BENCH_REPEAT; repeat++) {
+        UtilAttitude_MatrixToEulerBatch(matrix, euler, TEST_ATTITUDE_BENCH_COUNT);
+        checksum += euler[repeat].roll;
+    }
+    ModuleTest_Report("matrix to euler batch", conversionNum / (ModuleTest_GetTimeUs() - startTimeUs), "M/s");
+
+    MODULE_TEST_CHECK(checksum == checksum);
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,539 @@
+/**
+ ********************************************************************
+ * @file    test_util_buffer.c
+ * @brief   Test, stress test and benchmark of the lock-free buffers of util_buffer.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "module_test.h"
+#include "utils/util_buffer.h"
+#include "utils/util_misc.h"
+
+/* Private constants ---------------------------------------------------------*/
+/* Small enough for the stress test to wrap and fill the buffer all the time. */
+#define TEST_BUFFER_STRESS_SIZE             4096
+#define TEST_BUFFER_STRESS_MAX_CHUNK        700
+#define TEST_BUFFER_STRESS_PRODUCER_NUM     4
+#define TEST_BUFFER_RECORD_MAX_PAYLOAD      200
+#define TEST_BUFFER_BENCH_SIZE              16384
+#define TEST_BUFFER_BENCH_BYTES             (64 * 1024 * 1024)
+#define TEST_BUFFER_BENCH_PRODUCER_NUM      4
+
+/* ThreadSanitizer slows the stress test down several times and makes benchmark figures meaningless. */
+#ifdef __SANITIZE_THREAD__
+#define TEST_BUFFER_STRESS_SPSC_BYTES       (4 * 1024 * 1024)
+#define TEST_BUFFER_STRESS_RECORD_NUM       20000
+#else
+#define TEST_BUFFER_STRESS_SPSC_BYTES       (64 * 1024 * 1024)
+#define TEST_BUFFER_STRESS_RECORD_NUM       200000
+#endif
+
+/* Private types -------------------------------------------------------------*/
+typedef enum {
+    TEST_BUFFER_KIND_MUTEX = 0,
+    TEST_BUFFER_KIND_SPSC,
+    TEST_BUFFER_KIND_MPSC,
+} E_DjiTestBufferKind;
+
+typedef struct {
+    uint16_t producer;
+    uint16_t payloadLen;
+    uint32_t sequence;
+} T_DjiTestBufferRecordHeader;
+
+typedef struct {
+    T_UtilSpscBuffer spsc;
+    T_UtilMpscBuffer mpsc;
+    T_UtilBuffer buffer;
+    pthread_mutex_t mutex;
+    E_DjiTestBufferKind kind;
+    uint32_t chunkSize;
+    uint32_t putNum;
+    uint16_t producer;
+    uint32_t fullNum;
+    uint32_t errorNum;
+} T_DjiTestBufferContext;
+
+/* Private values -------------------------------------------------------------*/
+static uint8_t s_stressBuffer[TEST_BUFFER_STRESS_SIZE];
+static uint8_t s_benchBuffer[TEST_BUFFER_BENCH_SIZE];
+static T_DjiTestBufferContext s_context;
+
+/* Private functions declaration ---------------------------------------------*/
+static uint32_t DjiTest_BufferRandom(uint32_t *seed);
+static uint8_t DjiTest_BufferStreamByte(uint32_t position);
+static void DjiTest_BufferTestSpsc(void);
+static void DjiTest_BufferTestMpsc(void);
+static void *DjiTest_BufferSpscStressProducerTask(void *arg);
+static void DjiTest_BufferStressSpsc(void);
+static void *DjiTest_BufferMpscStressProducerTask(void *arg);
+static void DjiTest_BufferStressMpsc(void);
+static void *DjiTest_BufferBenchProducerTask(void *arg);
+static double DjiTest_BufferBenchRun(E_DjiTestBufferKind kind, uint32_t producerNum, uint32_t chunkSize);
+static void DjiTest_BufferBenchmark(void);
+
+/* Exported functions definition ---------------------------------------------*/
+int main(void)
+{
+    DjiTest_BufferTestSpsc();
+    DjiTest_BufferTestMpsc();
+    DjiTest_BufferStressSpsc();
+    DjiTest_BufferStressMpsc();
+#ifndef __SANITIZE_THREAD__
+    DjiTest_BufferBenchmark();
+#endif
+
+    return ModuleTest_Finish("test_util_buffer");
+}
+
+/* Private functions definition-----------------------------------------------*/
+static uint32_t DjiTest_BufferRandom(uint32_t *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+
+    return *seed >> 8;
+}
+
+/* Content of the SPSC stress stream at a position, not periodic at the buffer size. */
+static uint8_t DjiTest_BufferStreamByte(uint32_t position)
+{
+    return (uint8_t) (position ^ (position >> 8) ^ (position >> 17));
+}
+
+/**
+ * @brief SPSC sizes, partial puts when full, wrap around and in place spans from one thread.
+ */
+static void DjiTest_BufferTestSpsc(void)
+{
+    T_UtilSpscBuffer spsc;
+    uint8_t buffer[64];
+    uint8_t data[100];
+    uint8_t out[100];
+    const uint8_t *readSpan;
+    uint8_t *writeSpan;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t) i;
+    }
+
+    // cut to a power of two
+    UtilBuffer_SpscInit(&spsc, buffer, 48);
+    MODULE_TEST_CHECK(spsc.bufferSize == 32);
+    UtilBuffer_SpscInit(&spsc, buffer, sizeof(buffer));
+    MODULE_TEST_CHECK(UtilBuffer_SpscGetUnusedSize(&spsc) == 64);
+    MODULE_TEST_CHECK(UtilBuffer_SpscGet(&spsc, out, 10) == 0);
+
+    MODULE_TEST_CHECK(UtilBuffer_SpscPut(&spsc, data, 40) == 40);
+    MODULE_TEST_CHECK(UtilBuffer_SpscPut(&spsc, data + 40, 40) == 24);
+    MODULE_TEST_CHECK(UtilBuffer_SpscGetUnusedSize(&spsc) == 0);
+    MODULE_TEST_CHECK(UtilBuffer_SpscGetUsedSize(&spsc) == 64);
+    MODULE_TEST_CHECK(UtilBuffer_SpscGet(&spsc, out, 50) == 50);
+    MODULE_TEST_CHECK(memcmp(out, data, 50) == 0);
+
+    // the get wraps around the end of the buffer
+    MODULE_TEST_CHECK(UtilBuffer_SpscPut(&spsc, data + 64, 30) == 30);
+    MODULE_TEST_CHECK(UtilBuffer_SpscGet(&spsc, out, sizeof(out)) == 44);
+    MODULE_TEST_CHECK(memcmp(out, data + 50, 44) == 0);
+    MODULE_TEST_CHECK(UtilBuffer_SpscGetUsedSize(&spsc) == 0);
+
+    // the write index is at 30 now: the spans end at the buffer end, the rest follows from the start
+    MODULE_TEST_CHECK(UtilBuffer_SpscGetWriteSpan(&spsc, &writeSpan) == 34);
+    MODULE_TEST_CHECK(writeSpan == buffer + 30);
+    memcpy(writeSpan, data, 34);
+    UtilBuffer_SpscCommitWrite(&spsc, 34);
+    MODULE_TEST_CHECK(UtilBuffer_SpscGetWriteSpan(&spsc, &writeSpan) == 30);
+    MODULE_TEST_CHECK(writeSpan == buffer);
+    memcpy(writeSpan, data + 34, 6);
+    UtilBuffer_SpscCommitWrite(&spsc, 6);
+
+    MODULE_TEST_CHECK(UtilBuffer_SpscGetReadSpan(&spsc, &readSpan) == 34);
+    MODULE_TEST_CHECK(readSpan == buffer + 30 && memcmp(readSpan, data, 34) == 0);
+    UtilBuffer_SpscCommitRead(&spsc, 34);
+    MODULE_TEST_CHECK(UtilBuffer_SpscGetReadSpan(&spsc, &readSpan) == 6);
+    MODULE_TEST_CHECK(readSpan == buffer && memcmp(readSpan, data + 34, 6) == 0);
+    UtilBuffer_SpscCommitRead(&spsc, 6);
+    MODULE_TEST_CHECK(UtilBuffer_SpscGetReadSpan(&spsc, &readSpan) == 0);
+}
+
+/**
+ * @brief MPSC puts are stored whole or not at all.
+ */
+static void DjiTest_BufferTestMpsc(void)
+{
+    T_UtilMpscBuffer mpsc;
+    uint8_t buffer[64];
+    uint8_t data[64];
+    uint8_t out[64];
+    const uint8_t *readSpan;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t) (i * 3);
+    }
+
+    UtilBuffer_MpscInit(&mpsc, buffer, sizeof(buffer));
+    MODULE_TEST_CHECK(UtilBuffer_MpscPut(&mpsc, data, 0) == 0);
+    MODULE_TEST_CHECK(UtilBuffer_MpscPut(&mpsc, data, 40) == 40);
+    MODULE_TEST_CHECK(UtilBuffer_MpscPut(&mpsc, data, 30) == 0);
+    MODULE_TEST_CHECK(UtilBuffer_MpscGetUnusedSize(&mpsc) == 24);
+    MODULE_TEST_CHECK(UtilBuffer_MpscPut(&mpsc, data + 40, 24) == 24);
+    MODULE_TEST_CHECK(UtilBuffer_MpscPut(&mpsc, data, 1) == 0);
+
+    MODULE_TEST_CHECK(UtilBuffer_MpscGet(&mpsc, out, 50) == 50);
+    MODULE_TEST_CHECK(memcmp(out, data, 50) == 0);
+    MODULE_TEST_CHECK(UtilBuffer_MpscPut(&mpsc, data, 30) == 30);
+    MODULE_TEST_CHECK(UtilBuffer_MpscGetReadSpan(&mpsc, &readSpan) == 14);
+    MODULE_TEST_CHECK(memcmp(readSpan, data + 50, 14) == 0);
+    UtilBuffer_MpscCommitRead(&mpsc, 14);
+    MODULE_TEST_CHECK(UtilBuffer_MpscGet(&mpsc, out, sizeof(out)) == 30);
+    MODULE_TEST_CHECK(memcmp(out, data, 30) == 0);
+    MODULE_TEST_CHECK(UtilBuffer_MpscGetUnusedSize(&mpsc) == 64);
+}
+
+/* Writes the stress stream in random sized chunks, by copy and in place alternately. */
+static void *DjiTest_BufferSpscStressProducerTask(void *arg)
+{
+    T_DjiTestBufferContext *context = arg;
+    uint8_t chunk[TEST_BUFFER_STRESS_MAX_CHUNK];
+    uint32_t seed = 1;
+    uint32_t position = 0;
+    uint32_t chunkLen;
+    uint32_t putLen;
+    uint32_t i;
+    uint8_t *span;
+
+    while (position < TEST_BUFFER_STRESS_SPSC_BYTES) {
+        chunkLen = 1 + DjiTest_BufferRandom(&seed) % TEST_BUFFER_STRESS_MAX_CHUNK;
+        chunkLen = USER_UTIL_MIN(chunkLen, TEST_BUFFER_STRESS_SPSC_BYTES - position);
+
+        if (UtilBuffer_SpscGetUnusedSize(&context->spsc) > TEST_BUFFER_STRESS_SIZE) {
+            context->errorNum++;
+        }
+
+        if (chunkLen & 1) {
+            for (i = 0; i < chunkLen; i++) {
+                chunk[i] = DjiTest_BufferStreamByte(position + i);
+            }
+            putLen = UtilBuffer_SpscPut(&context->spsc, chunk, chunkLen);
+        } else {
+            putLen = USER_UTIL_MIN(UtilBuffer_SpscGetWriteSpan(&context->spsc, &span), chunkLen);
+            for (i = 0; i < putLen; i++) {
+                span[i] = DjiTest_BufferStreamByte(position + i);
+            }
+            UtilBuffer_SpscCommitWrite(&context->spsc, putLen);
+        }
+
+        if (putLen == 0) {
+            context->fullNum++;
+            sched_yield();
+        }
+        position += putLen;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief One producer and one consumer thread stream bytes through a small buffer, by copy and in place. Every byte
+ * has to arrive once and in order.
+ */
+static void DjiTest_BufferStressSpsc(void)
+{
+    uint8_t chunk[TEST_BUFFER_STRESS_MAX_CHUNK];
+    const uint8_t *span;
+    uint32_t seed = 2;
+    uint32_t position = 0;
+    uint32_t mismatchNum = 0;
+    uint32_t emptyNum = 0;
+    uint32_t getLen;
+    uint32_t i;
+    pthread_t producerTask;
+
+    memset(&s_context, 0, sizeof(s_context));
+    UtilBuffer_SpscInit(&s_context.spsc, s_stressBuffer, sizeof(s_stressBuffer));
+    if (pthread_create(&producerTask, NULL, DjiTest_BufferSpscStressProducerTask, &s_context) != 0) {
+        MODULE_TEST_CHECK(false);
+        return;
+    }
+
+    while (position < TEST_BUFFER_STRESS_SPSC_BYTES) {
+        if (UtilBuffer_SpscGetUsedSize(&s_context.spsc) > TEST_BUFFER_STRESS_SIZE) {
+            mismatchNum++;
+        }
+
+        if (DjiTest_BufferRandom(&seed) & 1) {
+            getLen = UtilBuffer_SpscGet(&s_context.spsc, chunk,
+                                        1 + DjiTest_BufferRandom(&seed) % TEST_BUFFER_STRESS_MAX_CHUNK);
+            span = chunk;
+        } else {
+            getLen = UtilBuffer_SpscGetReadSpan(&s_context.spsc, &span);
+        }
+
+        for (i = 0; i < getLen; i++) {
+            if (span[i] != DjiTest_BufferStreamByte(position + i)) {
+                mismatchNum++;
+            }
+        }
+        if (span != chunk) {
+            UtilBuffer_SpscCommitRead(&s_context.spsc, getLen);
+        }
+
+        if (getLen == 0) {
+            emptyNum++;
+            sched_yield();
+        }
+        position += getLen;
+    }
+
+    pthread_join(producerTask, NULL);
+
+    MODULE_TEST_CHECK(mismatchNum == 0);
+    MODULE_TEST_CHECK(s_context.errorNum == 0);
+    MODULE_TEST_CHECK(UtilBuffer_SpscGetUsedSize(&s_context.spsc) == 0);
+    ModuleTest_Report("spsc stress bytes", TEST_BUFFER_STRESS_SPSC_BYTES, "");
+    ModuleTest_Report("spsc stress full buffer retries", s_context.fullNum, "");
+    ModuleTest_Report("spsc stress empty buffer retries", emptyNum, "");
+}
+
+/* Puts numbered records of random length into the shared buffer, each one must arrive whole. */
+static void *DjiTest_BufferMpscStressProducerTask(void *arg)
+{
+    T_DjiTestBufferContext *context = arg;
+    uint8_t record[sizeof(T_DjiTestBufferRecordHeader) + TEST_BUFFER_RECORD_MAX_PAYLOAD];
+    T_DjiTestBufferRecordHeader header;
+    uint32_t seed = 100 + context->producer;
+    uint32_t i;
+    uint32_t j;
+
+    header.producer = context->producer;
+    for (i = 0; i < TEST_BUFFER_STRESS_RECORD_NUM; i++) {
+        header.sequence = i;
+        header.payloadLen = (uint16_t) (DjiTest_BufferRandom(&seed) % (TEST_BUFFER_RECORD_MAX_PAYLOAD + 1));
+        memcpy(record, &header, sizeof(header));
+        for (j = 0; j < header.payloadLen; j++) {
+            record[sizeof(header) + j] = (uint8_t) (i + header.producer * 7 + j);
+        }
+
+        while (UtilBuffer_MpscPut(&s_context.mpsc, record, sizeof(header) + header.payloadLen) == 0) {
+            context->fullNum++;
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Several producers put records into one small buffer, the consumer checks that records are whole, never
+ * interleaved, and in order per producer.
+ */
+static void DjiTest_BufferStressMpsc(void)
+{
+    static T_DjiTestBufferContext producers[TEST_BUFFER_STRESS_PRODUCER_NUM];
+    uint8_t payload[TEST_BUFFER_RECORD_MAX_PAYLOAD];
+    uint32_t nextSequence[TEST_BUFFER_STRESS_PRODUCER_NUM] = {0};
+    T_DjiTestBufferRecordHeader header;
+    pthread_t producerTasks[TEST_BUFFER_STRESS_PRODUCER_NUM];
+    uint32_t producerNum = 0;
+    uint32_t recordNum = 0;
+    uint32_t mismatchNum = 0;
+    uint32_t fullNum = 0;
+    uint32_t getLen;
+    uint32_t i;
+
+    memset(&s_context, 0, sizeof(s_context));
+    UtilBuffer_MpscInit(&s_context.mpsc, s_stressBuffer, sizeof(s_stressBuffer));
+    for (i = 0; i < TEST_BUFFER_STRESS_PRODUCER_NUM; i++) {
+        memset(&producers[i], 0, sizeof(producers[i]));
+        producers[i].producer = (uint16_t) i;
+        if (pthread_create(&producerTasks[i], NULL, DjiTest_BufferMpscStressProducerTask, &producers[i]) != 0) {
+            MODULE_TEST_CHECK(false);
+            break;
+        }
+        producerNum++;
+    }
+
+    while (recordNum < producerNum * TEST_BUFFER_STRESS_RECORD_NUM) {
+        getLen = UtilBuffer_MpscGet(&s_context.mpsc, (uint8_t *) &header, sizeof(header));
+        if (getLen == 0) {
+            sched_yield();
+            continue;
+        }
+
+        // a committed record is whole, its header and payload are there together
+        if (getLen != sizeof(header) || header.producer >= producerNum ||
+            header.payloadLen > TEST_BUFFER_RECORD_MAX_PAYLOAD ||
+            UtilBuffer_MpscGet(&s_context.mpsc, payload, header.payloadLen) != header.payloadLen) {
+            mismatchNum++;
+            break;
+        }
+
+        if (header.sequence != nextSequence[header.producer]) {
+            mismatchNum++;
+        }
+        nextSequence[header.producer] = header.sequence + 1;
+        for (i = 0; i < header.payloadLen; i++) {
+            if (payload[i] != (uint8_t) (header.sequence + header.producer * 7 + i)) {
+                mismatchNum++;
+            }
+        }
+        recordNum++;
+    }
+
+    for (i = 0; i < producerNum; i++) {
+        pthread_join(producerTasks[i], NULL);
+        fullNum += producers[i].fullNum;
+    }
+
+    MODULE_TEST_CHECK(producerNum == TEST_BUFFER_STRESS_PRODUCER_NUM);
+    MODULE_TEST_CHECK(mismatchNum == 0);
+    MODULE_TEST_CHECK(recordNum == producerNum * TEST_BUFFER_STRESS_RECORD_NUM);
+    ModuleTest_Report("mpsc stress records", recordNum, "");
+    ModuleTest_Report("mpsc stress full buffer retries", fullNum, "");
+}
+
+/* Puts chunks until putNum are stored, retrying while the buffer is full. */
+static void *DjiTest_BufferBenchProducerTask(void *arg)
+{
+    T_DjiTestBufferContext *context = arg;
+    uint8_t chunk[1024] = {0};
+    uint32_t putLen;
+    uint32_t i;
+
+    for (i = 0; i < context->putNum; i++) {
+        putLen = 0;
+        while (putLen < context->chunkSize) {
+            if (context->kind == TEST_BUFFER_KIND_SPSC) {
+                putLen += UtilBuffer_SpscPut(&s_context.spsc, chunk, context->chunkSize - putLen);
+            } else if (context->kind == TEST_BUFFER_KIND_MPSC) {
+                putLen = UtilBuffer_MpscPut(&s_context.mpsc, chunk, context->chunkSize);
+            } else {
+                // callers of UtilBuffer lock a mutex around it and only put whole chunks
+                pthread_mutex_lock(&s_context.mutex);
+                if (UtilBuffer_GetUnusedSize(&s_context.buffer) >= context->chunkSize) {
+                    putLen = UtilBuffer_Put(&s_context.buffer, chunk, (uint16_t) context->chunkSize);
+                }
+                pthread_mutex_unlock(&s_context.mutex);
+            }
+
+            if (putLen < context->chunkSize) {
+                sched_yield();
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/* Returns millions of puts per second. */
+static double DjiTest_BufferBenchRun(E_DjiTestBufferKind kind, uint32_t producerNum, uint32_t chunkSize)
+{
+    static T_DjiTestBufferContext producers[TEST_BUFFER_BENCH_PRODUCER_NUM];
+    pthread_t producerTasks[TEST_BUFFER_BENCH_PRODUCER_NUM];
+    uint8_t out[4096];
+    uint64_t totalBytes;
+    uint64_t readBytes = 0;
+    uint64_t startTimeUs;
+    uint64_t elapsedUs;
+    uint32_t getLen;
+    uint32_t startedNum = 0;
+    uint32_t i;
+
+    memset(&s_context, 0, sizeof(s_context));
+    UtilBuffer_SpscInit(&s_context.spsc, s_benchBuffer, sizeof(s_benchBuffer));
+    UtilBuffer_MpscInit(&s_context.mpsc, s_benchBuffer, sizeof(s_benchBuffer));
+    UtilBuffer_Init(&s_context.buffer, s_benchBuffer, sizeof(s_benchBuffer));
+    pthread_mutex_init(&s_context.mutex, NULL);
+
+    startTimeUs = ModuleTest_GetTimeUs();
+    for (i = 0; i < producerNum; i++) {
+        memset(&producers[i], 0, sizeof(producers[i]));
+        producers[i].kind = kind;
+        producers[i].chunkSize = chunkSize;
+        producers[i].putNum = TEST_BUFFER_BENCH_BYTES / chunkSize / producerNum;
+        if (pthread_create(&producerTasks[i], NULL, DjiTest_BufferBenchProducerTask, &producers[i]) != 0) {
+            MODULE_TEST_CHECK(false);
+            break;
+        }
+        startedNum++;
+    }
+    totalBytes = (uint64_t) startedNum * producers[0].putNum * chunkSize;
+
+    while (readBytes < totalBytes) {
+        if (kind == TEST_BUFFER_KIND_SPSC) {
+            getLen = UtilBuffer_SpscGet(&s_context.spsc, out, sizeof(out));
+        } else if (kind == TEST_BUFFER_KIND_MPSC) {
+            getLen = UtilBuffer_MpscGet(&s_context.mpsc, out, sizeof(out));
+        } else {
+            pthread_mutex_lock(&s_context.mutex);
+            getLen = UtilBuffer_Get(&s_context.buffer, out, sizeof(out));
+            pthread_mutex_unlock(&s_context.mutex);
+        }
+
+        if (getLen == 0) {
+            sched_yield();
+        }
+        readBytes += getLen;
+    }
+    elapsedUs = ModuleTest_GetTimeUs() - startTimeUs;
+
+    for (i = 0; i < startedNum; i++) {
+        pthread_join(producerTasks[i], NULL);
+    }
+    pthread_mutex_destroy(&s_context.mutex);
+
+    return (double) totalBytes / chunkSize / elapsedUs;
+}
+
+/**
+ * @brief Puts per second through the mutex protected UtilBuffer and the lock-free buffers, one producer against SPSC
+ * and several against MPSC, 64 MB per run.
+ */
+static void DjiTest_BufferBenchmark(void)
+{
+    const uint32_t chunkSizes[] = {16, 64, 1024};
+    char name[64];
+    uint32_t i;
+
+    for (i = 0; i < sizeof(chunkSizes) / sizeof(chunkSizes[0]); i++) {
+        snprintf(name, sizeof(name), "chunk %u, 1 producer, mutex", chunkSizes[i]);
+        ModuleTest_Report(name, DjiTest_BufferBenchRun(TEST_BUFFER_KIND_MUTEX, 1, chunkSizes[i]), "Mops/s");
+        snprintf(name, sizeof(name), "chunk %u, 1 producer, spsc", chunkSizes[i]);
+        ModuleTest_Report(name, DjiTest_BufferBenchRun(TEST_BUFFER_KIND_SPSC, 1, chunkSizes[i]), "Mops/s");
+    }
+
+    for (i = 1; i < sizeof(chunkSizes) / sizeof(chunkSizes[0]); i++) {
+        snprintf(name, sizeof(name), "chunk %u, %u producers, mutex", chunkSizes[i], TEST_BUFFER_BENCH_PRODUCER_NUM);
+        ModuleTest_Report(name, DjiTest_BufferBenchRun(TEST_BUFFER_KIND_MUTEX, TEST_BUFFER_BENCH_PRODUCER_NUM,
+                                                       chunkSizes[i]), "Mops/s");
+        snprintf(name, sizeof(name), "chunk %u, %u producers, mpsc", chunkSizes[i], TEST_BUFFER_BENCH_PRODUCER_NUM);
+        ModuleTest_Report(name, DjiTest_BufferBenchRun(TEST_BUFFER_KIND_MPSC, TEST_BUFFER_BENCH_PRODUCER_NUM,
+                                                       chunkSizes[i]), "Mops/s");
+    }
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
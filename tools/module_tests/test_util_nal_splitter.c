@@ -0,0 +1,359 @@
+/**
+ ********************************************************************
+ * @file    test_util_nal_splitter.c
+ * @brief   Test and benchmark of the Annex-B NAL unit splitter.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+#include "module_test.h"
+#include "utils/util_nal_splitter.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define TEST_NAL_SPLITTER_BUFFER_SIZE           (2 * 512 * 1024)
+#define TEST_NAL_SPLITTER_STREAM_NAL_COUNT      2000
+#define TEST_NAL_SPLITTER_MAX_NAL_SIZE          (64 * 1024)
+#define TEST_NAL_SPLITTER_BENCH_STREAM_SIZE     (64 * 1024 * 1024)
+#define TEST_NAL_SPLITTER_BENCH_NAL_SIZE        (40 * 1024)
+#define TEST_NAL_SPLITTER_BENCH_ROUNDS          4
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    uint8_t *data;
+    uint32_t len;
+} T_TestNalUnit;
+
+typedef struct {
+    const T_TestNalUnit *expectNal;
+    uint32_t expectCount;
+    uint32_t receivedCount;
+    uint32_t mismatchCount;
+    uint64_t receivedBytes;
+} T_TestNalCollector;
+
+/* Private values -------------------------------------------------------------*/
+static uint32_t s_randomSeed = 0x12345678;
+
+/* Private functions declaration ---------------------------------------------*/
+static uint32_t DjiTest_NalSplitterRandom(void);
+static uint32_t DjiTest_NalSplitterMakeNal(uint8_t *buf, uint32_t payloadLen, uint8_t startCodeLen);
+static void DjiTest_NalSplitterCollect(const uint8_t *nalData, uint32_t nalLen, void *userData);
+static const uint8_t *DjiTest_NalSplitterFindStartCodeScalar(const uint8_t *pData, const uint8_t *pEnd);
+static void DjiTest_NalSplitterTestStartCodeScan(void);
+static void DjiTest_NalSplitterTestStream(int useWritableSpan);
+static void DjiTest_NalSplitterTestOversizedNal(void);
+static void DjiTest_NalSplitterBenchmark(void);
+
+/* Exported functions definition ---------------------------------------------*/
+int main(void)
+{
+    DjiTest_NalSplitterTestStartCodeScan();
+    DjiTest_NalSplitterTestStream(0);
+    DjiTest_NalSplitterTestStream(1);
+    DjiTest_NalSplitterTestOversizedNal();
+    DjiTest_NalSplitterBenchmark();
+
+    return ModuleTest_Finish("test_util_nal_splitter");
+}
+
+/* Private functions definition-----------------------------------------------*/
+static uint32_t DjiTest_NalSplitterRandom(void)
+{
+    s_randomSeed = s_randomSeed * 1103515245 + 12345;
+
+    return s_randomSeed >> 8;
+}
+
+/**
+ * @brief Write one NAL unit with a random payload, using emulation prevention so the payload never contains a
+ * start code, and ending it with a non-zero byte so it is not mistaken for a trailing zero of the next start code.
+ * @return Length of the NAL unit including its start code.
+ */
+static uint32_t DjiTest_NalSplitterMakeNal(uint8_t *buf, uint32_t payloadLen, uint8_t startCodeLen)
+{
+    uint32_t len = 0;
+    uint32_t zeroCount = 0;
+    uint8_t value;
+
+    if (startCodeLen == 4) {
+        buf[len++] = 0x00;
+    }
+    buf[len++] = 0x00;
+    buf[len++] = 0x00;
+    buf[len++] = 0x01;
+
+    while (payloadLen-- > 1) {
+        //zero heavy payload to exercise the scanner on near matches
+        value = (DjiTest_NalSplitterRandom() & 3) == 0 ? 0x00 : (uint8_t) DjiTest_NalSplitterRandom();
+        if (zeroCount >= 2 && value <= 0x03) {
+            buf[len++] = 0x03;
+            zeroCount = 0;
+        }
+        buf[len++] = value;
+        zeroCount = value == 0x00 ? zeroCount + 1 : 0;
+    }
+    buf[len++] = 0x80;
+
+    return len;
+}
+
+static void DjiTest_NalSplitterCollect(const uint8_t *nalData, uint32_t nalLen, void *userData)
+{
+    T_TestNalCollector *collector = (T_TestNalCollector *) userData;
+    const T_TestNalUnit *expect;
+
+    if (collector->receivedCount >= collector->expectCount) {
+        collector->mismatchCount++;
+        return;
+    }
+
+    if (collector->expectNal != NULL) {
+        expect = &collector->expectNal[collector->receivedCount];
+        if (expect->len != nalLen || memcmp(expect->data, nalData, nalLen) != 0) {
+            collector->mismatchCount++;
+        }
+    }
+
+    collector->receivedCount++;
+    collector->receivedBytes += nalLen;
+}
+
+static const uint8_t *DjiTest_NalSplitterFindStartCodeScalar(const uint8_t *pData, const uint8_t *pEnd)
+{
+    const uint8_t *p;
+
+    for (p = pData; p + 2 < pEnd; p++) {
+        if (p[0] == 0x00 && p[1] == 0x00 && p[2] == 0x01) {
+            return p;
+        }
+    }
+
+    return NULL;
+}
+
+static void DjiTest_NalSplitterTestStartCodeScan(void)
+{
+    uint8_t buf[256];
+    uint32_t offset;
+    uint32_t len;
+    uint32_t round;
+    uint32_t i;
+
+    for (round = 0; round < 20000; round++) {
+        len = DjiTest_NalSplitterRandom() % sizeof(buf);
+        for (i = 0; i < len; i++) {
+            buf[i] = (DjiTest_NalSplitterRandom() & 1) == 0 ? 0x00 : (uint8_t) (DjiTest_NalSplitterRandom() & 1);
+        }
+        offset = len > 0 ? DjiTest_NalSplitterRandom() % len : 0;
+
+        MODULE_TEST_CHECK(UtilNalSplitter_FindStartCode(buf + offset, buf + len) ==
+                          DjiTest_NalSplitterFindStartCodeScalar(buf + offset, buf + len));
+    }
+}
+
+/**
+ * @brief Split a stream of mixed 3 and 4 byte start code NAL units fed in random chunk sizes, and check every NAL
+ * unit arrives complete and in order.
+ * @param useWritableSpan Feed the splitter with GetWritableSpan/CommitWrite instead of Put.
+ */
+static void DjiTest_NalSplitterTestStream(int useWritableSpan)
+{
+    T_UtilNalSplitter splitter;
+    T_TestNalCollector collector = {0};
+    T_TestNalUnit *nal;
+    uint8_t *splitterBuf;
+    uint8_t *stream;
+    uint8_t *span;
+    uint32_t streamLen = 0;
+    uint32_t offset = 0;
+    uint32_t chunkLen;
+    uint32_t spanLen;
+    uint32_t payloadLen;
+    uint32_t i;
+
+    nal = calloc(TEST_NAL_SPLITTER_STREAM_NAL_COUNT, sizeof(T_TestNalUnit));
+    stream = malloc(TEST_NAL_SPLITTER_STREAM_NAL_COUNT * (TEST_NAL_SPLITTER_MAX_NAL_SIZE * 3 / 2 + 8));
+    splitterBuf = malloc(TEST_NAL_SPLITTER_BUFFER_SIZE);
+    MODULE_TEST_CHECK(nal != NULL && stream != NULL && splitterBuf != NULL);
+    if (nal == NULL || stream == NULL || splitterBuf == NULL) {
+        goto out;
+    }
+
+    for (i = 0; i < TEST_NAL_SPLITTER_STREAM_NAL_COUNT; i++) {
+        //mostly small parameter set and slice sized units with an occasional large one
+        payloadLen = 2 + DjiTest_NalSplitterRandom() % ((i % 50) == 0 ? TEST_NAL_SPLITTER_MAX_NAL_SIZE : 2000);
+        nal[i].data = stream + streamLen;
+        nal[i].len = DjiTest_NalSplitterMakeNal(stream + streamLen, payloadLen,
+                                                (DjiTest_NalSplitterRandom() & 1) ? 4 : 3);
+        streamLen += nal[i].len;
+    }
+
+    collector.expectNal = nal;
+    collector.expectCount = TEST_NAL_SPLITTER_STREAM_NAL_COUNT;
+    UtilNalSplitter_Init(&splitter, splitterBuf, TEST_NAL_SPLITTER_BUFFER_SIZE, DjiTest_NalSplitterCollect,
+                         &collector);
+
+    while (offset < streamLen) {
+        chunkLen = 1 + DjiTest_NalSplitterRandom() % 9000;
+        chunkLen = chunkLen < streamLen - offset ? chunkLen : streamLen - offset;
+        if (useWritableSpan) {
+            spanLen = UtilNalSplitter_GetWritableSpan(&splitter, &span);
+            chunkLen = chunkLen < spanLen ? chunkLen : spanLen;
+            memcpy(span, stream + offset, chunkLen);
+            UtilNalSplitter_CommitWrite(&splitter, chunkLen);
+        } else {
+            UtilNalSplitter_Put(&splitter, stream + offset, chunkLen);
+        }
+        offset += chunkLen;
+    }
+    UtilNalSplitter_Flush(&splitter);
+
+    MODULE_TEST_CHECK(collector.receivedCount == TEST_NAL_SPLITTER_STREAM_NAL_COUNT);
+    MODULE_TEST_CHECK(collector.mismatchCount == 0);
+    MODULE_TEST_CHECK(collector.receivedBytes == streamLen);
+    MODULE_TEST_CHECK(splitter.droppedBytes == 0);
+
+out:
+    free(splitterBuf);
+    free(stream);
+    free(nal);
+}
+
+/**
+ * @brief A NAL unit larger than one buffer half is dropped, and the splitter resyncs at the following start code.
+ */
+static void DjiTest_NalSplitterTestOversizedNal(void)
+{
+    T_UtilNalSplitter splitter;
+    T_TestNalCollector collector = {0};
+    T_TestNalUnit nal[3];
+    uint8_t splitterBuf[2 * 16 * 1024];
+    uint8_t *stream;
+    uint32_t streamLen = 0;
+
+    stream = malloc(64 * 1024);
+    MODULE_TEST_CHECK(stream != NULL);
+    if (stream == NULL) {
+        return;
+    }
+
+    nal[0].data = stream + streamLen;
+    nal[0].len = DjiTest_NalSplitterMakeNal(stream + streamLen, 100, 4);
+    streamLen += nal[0].len;
+    streamLen += DjiTest_NalSplitterMakeNal(stream + streamLen, 20 * 1024, 4);
+    nal[1].data = stream + streamLen;
+    nal[1].len = DjiTest_NalSplitterMakeNal(stream + streamLen, 200, 4);
+    streamLen += nal[1].len;
+    nal[2].data = stream + streamLen;
+    nal[2].len = DjiTest_NalSplitterMakeNal(stream + streamLen, 300, 3);
+    streamLen += nal[2].len;
+
+    collector.expectCount = 3;
+    UtilNalSplitter_Init(&splitter, splitterBuf, sizeof(splitterBuf), DjiTest_NalSplitterCollect, &collector);
+    UtilNalSplitter_Put(&splitter, stream, streamLen);
+    UtilNalSplitter_Flush(&splitter);
+
+    //the tail of the dropped unit is only recognized as garbage up to the next start code
+    MODULE_TEST_CHECK(splitter.droppedBytes > 0);
+    MODULE_TEST_CHECK(collector.receivedCount >= 2);
+    MODULE_TEST_CHECK(collector.receivedCount <= 3);
+    MODULE_TEST_CHECK(collector.mismatchCount == 0);
+
+    free(stream);
+}
+
+static void DjiTest_NalSplitterBenchmark(void)
+{
+    T_UtilNalSplitter splitter;
+    T_TestNalCollector collector = {0};
+    uint8_t *splitterBuf;
+    uint8_t *stream;
+    const uint8_t *p;
+    uint32_t streamLen = 0;
+    uint32_t nalCount = 0;
+    uint32_t found;
+    uint64_t startUs;
+    uint64_t scalarUs;
+    uint64_t scanUs;
+    uint64_t splitUs;
+    uint32_t round;
+
+    stream = malloc(TEST_NAL_SPLITTER_BENCH_STREAM_SIZE + TEST_NAL_SPLITTER_BENCH_NAL_SIZE * 3);
+    splitterBuf = malloc(TEST_NAL_SPLITTER_BUFFER_SIZE);
+    MODULE_TEST_CHECK(stream != NULL && splitterBuf != NULL);
+    if (stream == NULL || splitterBuf == NULL) {
+        goto out;
+    }
+
+    while (streamLen < TEST_NAL_SPLITTER_BENCH_STREAM_SIZE) {
+        streamLen += DjiTest_NalSplitterMakeNal(stream + streamLen, TEST_NAL_SPLITTER_BENCH_NAL_SIZE / 2 +
+                                                DjiTest_NalSplitterRandom() % TEST_NAL_SPLITTER_BENCH_NAL_SIZE, 4);
+        nalCount++;
+    }
+
+    startUs = ModuleTest_GetTimeUs();
+    for (round = 0, found = 0; round < TEST_NAL_SPLITTER_BENCH_ROUNDS; round++) {
+        for (p = stream; (p = DjiTest_NalSplitterFindStartCodeScalar(p, stream + streamLen)) != NULL; p += 3) {
+            found++;
+        }
+    }
+    scalarUs = ModuleTest_GetTimeUs() - startUs;
+    MODULE_TEST_CHECK(found == nalCount * TEST_NAL_SPLITTER_BENCH_ROUNDS);
+
+    startUs = ModuleTest_GetTimeUs();
+    for (round = 0, found = 0; round < TEST_NAL_SPLITTER_BENCH_ROUNDS; round++) {
+        for (p = stream; (p = UtilNalSplitter_FindStartCode(p, stream + streamLen)) != NULL; p += 3) {
+            found++;
+        }
+    }
+    scanUs = ModuleTest_GetTimeUs() - startUs;
+    MODULE_TEST_CHECK(found == nalCount * TEST_NAL_SPLITTER_BENCH_ROUNDS);
+
+    collector.expectCount = UINT32_MAX;
+    UtilNalSplitter_Init(&splitter, splitterBuf, TEST_NAL_SPLITTER_BUFFER_SIZE, DjiTest_NalSplitterCollect,
+                         &collector);
+    startUs = ModuleTest_GetTimeUs();
+    for (round = 0; round < TEST_NAL_SPLITTER_BENCH_ROUNDS; round++) {
+        //pipe sized reads, as from the libcamera-vid output
+        for (p = stream; p < stream + streamLen; p += 65536) {
+            UtilNalSplitter_Put(&splitter, p, stream + streamLen - p < 65536 ? (uint32_t) (stream + streamLen - p) :
+                                              65536);
+        }
+        UtilNalSplitter_Flush(&splitter);
+    }
+    splitUs = ModuleTest_GetTimeUs() - startUs;
+    MODULE_TEST_CHECK(collector.receivedCount == nalCount * TEST_NAL_SPLITTER_BENCH_ROUNDS);
+
+    printf("NAL splitter benchmark, %u MB stream, %u NAL units:\r\n", streamLen >> 20, nalCount);
+    ModuleTest_Report("byte by byte start code scan", (double) streamLen * TEST_NAL_SPLITTER_BENCH_ROUNDS /
+                                                       (double) (scalarUs ? scalarUs : 1), "MB/s");
+    ModuleTest_Report("UtilNalSplitter_FindStartCode", (double) streamLen * TEST_NAL_SPLITTER_BENCH_ROUNDS /
+                                                        (double) (scanUs ? scanUs : 1), "MB/s");
+    ModuleTest_Report("UtilNalSplitter_Put, 64 KiB reads", (double) streamLen * TEST_NAL_SPLITTER_BENCH_ROUNDS /
+                                                            (double) (splitUs ? splitUs : 1), "MB/s");
+
+out:
+    free(splitterBuf);
+    free(stream);
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
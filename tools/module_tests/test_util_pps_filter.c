@@ -0,0 +1,311 @@
+/**
+ ********************************************************************
+ * @file    test_util_pps_filter.c
+ * @brief   Test and benchmark of the PPS edge filter with synthetic edges.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "module_test.h"
+#include "utils/util_pps_filter.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define TEST_PPS_EDGE_NUM                  3600
+#define TEST_PPS_START_TIME_US             1000000000ULL
+#define TEST_PPS_BOUNCE_DELAY_US           50
+#define TEST_PPS_CLOCK_STEP_US             50000
+#define TEST_PPS_BENCH_EDGE_NUM            1000000
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    const char *name;
+    uint32_t windowSize;
+    double jitterUs;
+    double driftPpm;
+    /* Percent of the edges delayed by 1 to 20 ms, missed, and followed by a bounce. */
+    uint32_t latePercent;
+    uint32_t missedPercent;
+    uint32_t bouncePercent;
+    /* Limits of the checks. */
+    double maxFilteredRmsUs;
+    double maxFilteredErrorUs;
+    double maxDriftErrorPpm;
+} T_TestPpsScenario;
+
+typedef struct {
+    double rawRmsUs;
+    double filteredRmsUs;
+    double filteredMaxUs;
+    double driftErrorPpm;
+    uint32_t lateNum;
+    uint32_t missedNum;
+    uint32_t bounceNum;
+    T_UtilPpsFilterStatistics statistics;
+} T_TestPpsResult;
+
+/* Private values -------------------------------------------------------------*/
+static uint32_t s_randomSeed = 0x2468ace1;
+
+static const T_TestPpsScenario s_scenarios[] = {
+    {"jitter 2 us, 20 ppm", 16, 2, 20, 0, 0, 0, 2, 8, 0.5},
+    {"jitter 30 us, 20 ppm", 16, 30, 20, 0, 0, 0, 20, 80, 5},
+    {"jitter 30 us, -80 ppm, late, missed, bounce", 16, 30, -80, 2, 1, 1, 20, 100, 5},
+    {"same, window of 32", 32, 30, -80, 2, 1, 1, 15, 80, 3},
+};
+
+/* Private functions declaration ---------------------------------------------*/
+static uint32_t DjiTest_PpsRandom(void);
+static double DjiTest_PpsGaussian(void);
+static void DjiTest_PpsRunScenario(const T_TestPpsScenario *scenario, T_TestPpsResult *result);
+static void DjiTest_PpsTestConfig(void);
+static void DjiTest_PpsTestScenarios(void);
+static void DjiTest_PpsTestClockStep(void);
+static void DjiTest_PpsBenchmark(void);
+
+/* Exported functions definition ---------------------------------------------*/
+int main(void)
+{
+    DjiTest_PpsTestConfig();
+    DjiTest_PpsTestScenarios();
+    DjiTest_PpsTestClockStep();
+    DjiTest_PpsBenchmark();
+
+    return ModuleTest_Finish("test_util_pps_filter");
+}
+
+/* Private functions definition-----------------------------------------------*/
+static uint32_t DjiTest_PpsRandom(void)
+{
+    s_randomSeed = s_randomSeed * 1103515245 + 12345;
+
+    return s_randomSeed >> 8;
+}
+
+/**
+ * @brief Standard normal sample by the Box-Muller transform.
+ */
+static double DjiTest_PpsGaussian(void)
+{
+    double u1 = ((double) DjiTest_PpsRandom() + 1) / 16777217.0;
+    double u2 = (double) DjiTest_PpsRandom() / 16777216.0;
+
+    return sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+}
+
+/**
+ * @brief Feed the edges of a local clock running at the given drift against the pulses, and compare the raw and
+ * the filtered edge times with the true ones. The first window of edges is the start up and not counted.
+ */
+static void DjiTest_PpsRunScenario(const T_TestPpsScenario *scenario, T_TestPpsResult *result)
+{
+    T_UtilPpsFilterConfig config;
+    T_UtilPpsFilter filter;
+    T_UtilPpsFilterEstimate estimate;
+    E_UtilPpsFilterEdgeState state;
+    double periodUs;
+    double trueTimeUs;
+    double rawErrorUs;
+    double filteredErrorUs;
+    double rawSum = 0;
+    double filteredSum = 0;
+    uint64_t edgeTimeUs;
+    uint32_t countedNum = 0;
+    uint32_t i;
+    bool late;
+
+    memset(result, 0, sizeof(T_TestPpsResult));
+    UtilPpsFilter_GetDefaultConfig(&config);
+    config.windowSize = scenario->windowSize;
+    MODULE_TEST_CHECK(UtilPpsFilter_Init(&filter, &config) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    periodUs = config.nominalPeriodUs * (1 + scenario->driftPpm * 1e-6);
+
+    for (i = 0; i < TEST_PPS_EDGE_NUM; i++) {
+        trueTimeUs = (double) TEST_PPS_START_TIME_US + periodUs * i;
+        //the first edges start the fit and are never dropped or delayed
+        if (i > 2 && DjiTest_PpsRandom() % 100 < scenario->missedPercent) {
+            result->missedNum++;
+            continue;
+        }
+
+        rawErrorUs = scenario->jitterUs * DjiTest_PpsGaussian();
+        late = i > 2 && DjiTest_PpsRandom() % 100 < scenario->latePercent;
+        if (late) {
+            rawErrorUs += 1000 + DjiTest_PpsRandom() % 19000;
+            result->lateNum++;
+        }
+        edgeTimeUs = (uint64_t) llround(trueTimeUs + rawErrorUs);
+
+        MODULE_TEST_CHECK(UtilPpsFilter_AddEdge(&filter, edgeTimeUs, &state) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+        MODULE_TEST_CHECK(state == UTIL_PPS_FILTER_EDGE_ACCEPTED || state == UTIL_PPS_FILTER_EDGE_OUTLIER);
+        MODULE_TEST_CHECK(UtilPpsFilter_GetEstimate(&filter, &estimate) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+        if (i >= scenario->windowSize) {
+            filteredErrorUs = (double) (int64_t) (estimate.edgeTimeUs - TEST_PPS_START_TIME_US) -
+                              (trueTimeUs - TEST_PPS_START_TIME_US);
+            rawSum += rawErrorUs * rawErrorUs;
+            filteredSum += filteredErrorUs * filteredErrorUs;
+            if (fabs(filteredErrorUs) > result->filteredMaxUs) {
+                result->filteredMaxUs = fabs(filteredErrorUs);
+            }
+            countedNum++;
+        }
+
+        //a bounce of a late edge is one more outlier of its pulse, only the bounces of good edges are ignored
+        if (!late && i > 2 && DjiTest_PpsRandom() % 100 < scenario->bouncePercent) {
+            MODULE_TEST_CHECK(UtilPpsFilter_AddEdge(&filter, edgeTimeUs + TEST_PPS_BOUNCE_DELAY_US, &state) ==
+                              DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+            MODULE_TEST_CHECK(state == UTIL_PPS_FILTER_EDGE_IGNORED);
+            result->bounceNum++;
+        }
+    }
+
+    MODULE_TEST_CHECK(UtilPpsFilter_GetEstimate(&filter, &estimate) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    UtilPpsFilter_GetStatistics(&filter, &result->statistics);
+    result->rawRmsUs = countedNum > 0 ? sqrt(rawSum / countedNum) : 0;
+    result->filteredRmsUs = countedNum > 0 ? sqrt(filteredSum / countedNum) : 0;
+    result->driftErrorPpm = estimate.driftPpm - scenario->driftPpm;
+}
+
+/**
+ * @brief Configs out of range are refused, a filter without an edge has no estimate.
+ */
+static void DjiTest_PpsTestConfig(void)
+{
+    T_UtilPpsFilterConfig config;
+    T_UtilPpsFilter filter;
+    T_UtilPpsFilterEstimate estimate;
+
+    UtilPpsFilter_GetDefaultConfig(&config);
+    config.windowSize = 1;
+    MODULE_TEST_CHECK(UtilPpsFilter_Init(&filter, &config) == DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER);
+    config.windowSize = UTIL_PPS_FILTER_WINDOW_MAX + 1;
+    MODULE_TEST_CHECK(UtilPpsFilter_Init(&filter, &config) == DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER);
+    UtilPpsFilter_GetDefaultConfig(&config);
+    config.nominalPeriodUs = 0;
+    MODULE_TEST_CHECK(UtilPpsFilter_Init(&filter, &config) == DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER);
+    MODULE_TEST_CHECK(UtilPpsFilter_Init(&filter, NULL) == DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER);
+
+    UtilPpsFilter_GetDefaultConfig(&config);
+    MODULE_TEST_CHECK(UtilPpsFilter_Init(&filter, &config) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(UtilPpsFilter_GetEstimate(&filter, &estimate) == DJI_ERROR_SYSTEM_MODULE_CODE_BUSY);
+}
+
+/**
+ * @brief Filtered edges are closer to the true edges than the captured ones, late edges are replaced by the fit,
+ * bounces are dropped and missed pulses counted, all without a restart.
+ */
+static void DjiTest_PpsTestScenarios(void)
+{
+    T_TestPpsResult result;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(s_scenarios) / sizeof(s_scenarios[0]); i++) {
+        DjiTest_PpsRunScenario(&s_scenarios[i], &result);
+
+        MODULE_TEST_CHECK(result.filteredRmsUs < s_scenarios[i].maxFilteredRmsUs);
+        MODULE_TEST_CHECK(result.filteredRmsUs < result.rawRmsUs);
+        MODULE_TEST_CHECK(result.filteredMaxUs < s_scenarios[i].maxFilteredErrorUs);
+        MODULE_TEST_CHECK(fabs(result.driftErrorPpm) < s_scenarios[i].maxDriftErrorPpm);
+        MODULE_TEST_CHECK(result.statistics.resetCount == 0);
+        MODULE_TEST_CHECK(result.statistics.outlierCount == result.lateNum);
+        MODULE_TEST_CHECK(result.statistics.ignoredCount == result.bounceNum);
+        MODULE_TEST_CHECK(result.statistics.missedPulseCount == result.missedNum);
+
+        printf("  %s\r\n", s_scenarios[i].name);
+        ModuleTest_Report("raw edge error rms", result.rawRmsUs, "us");
+        ModuleTest_Report("filtered edge error rms", result.filteredRmsUs, "us");
+        ModuleTest_Report("filtered edge error max", result.filteredMaxUs, "us");
+        ModuleTest_Report("drift error", fabs(result.driftErrorPpm), "ppm");
+    }
+}
+
+/**
+ * @brief After a step of the local clock the edges are outliers until resetOutlierNum of them restart the filter,
+ * which then follows the new time base.
+ */
+static void DjiTest_PpsTestClockStep(void)
+{
+    T_UtilPpsFilterConfig config;
+    T_UtilPpsFilter filter;
+    T_UtilPpsFilterEstimate estimate;
+    T_UtilPpsFilterStatistics statistics;
+    E_UtilPpsFilterEdgeState state = UTIL_PPS_FILTER_EDGE_ACCEPTED;
+    uint64_t edgeTimeUs;
+    uint32_t stepEdgeNum = 0;
+    uint32_t i;
+
+    UtilPpsFilter_GetDefaultConfig(&config);
+    MODULE_TEST_CHECK(UtilPpsFilter_Init(&filter, &config) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+    for (i = 0; i < 60; i++) {
+        edgeTimeUs = TEST_PPS_START_TIME_US + (uint64_t) i * config.nominalPeriodUs;
+        if (i >= 30) {
+            edgeTimeUs += TEST_PPS_CLOCK_STEP_US;
+        }
+        MODULE_TEST_CHECK(UtilPpsFilter_AddEdge(&filter, edgeTimeUs, &state) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+        if (i >= 30 && stepEdgeNum == 0) {
+            if (state == UTIL_PPS_FILTER_EDGE_RESET) {
+                stepEdgeNum = i - 29;
+            } else {
+                MODULE_TEST_CHECK(state == UTIL_PPS_FILTER_EDGE_OUTLIER);
+            }
+        }
+    }
+
+    MODULE_TEST_CHECK(stepEdgeNum == config.resetOutlierNum);
+    MODULE_TEST_CHECK(UtilPpsFilter_GetEstimate(&filter, &estimate) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(estimate.edgeTimeUs == edgeTimeUs && fabs(estimate.driftPpm) < 0.01);
+    UtilPpsFilter_GetStatistics(&filter, &statistics);
+    MODULE_TEST_CHECK(statistics.resetCount == 1 && statistics.outlierCount == config.resetOutlierNum);
+}
+
+static void DjiTest_PpsBenchmark(void)
+{
+    T_UtilPpsFilterConfig config;
+    T_UtilPpsFilter filter;
+    E_UtilPpsFilterEdgeState state;
+    uint64_t startTimeUs;
+    uint64_t elapsedUs;
+    uint32_t windowSizes[] = {UTIL_PPS_FILTER_DEFAULT_WINDOW_SIZE, UTIL_PPS_FILTER_WINDOW_MAX};
+    char name[64];
+    uint32_t i;
+    uint32_t j;
+
+    for (j = 0; j < sizeof(windowSizes) / sizeof(windowSizes[0]); j++) {
+        UtilPpsFilter_GetDefaultConfig(&config);
+        config.windowSize = windowSizes[j];
+        MODULE_TEST_CHECK(UtilPpsFilter_Init(&filter, &config) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+        startTimeUs = ModuleTest_GetTimeUs();
+        for (i = 0; i < TEST_PPS_BENCH_EDGE_NUM; i++) {
+            UtilPpsFilter_AddEdge(&filter, TEST_PPS_START_TIME_US + (uint64_t) i * config.nominalPeriodUs +
+                                           DjiTest_PpsRandom() % 20, &state);
+        }
+        elapsedUs = ModuleTest_GetTimeUs() - startTimeUs;
+
+        snprintf(name, sizeof(name), "add edge cost, window of %u", windowSizes[j]);
+        ModuleTest_Report(name, (double) elapsedUs * 1000 / TEST_PPS_BENCH_EDGE_NUM, "ns/edge");
+    }
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,458 @@
+/**
+ ********************************************************************
+ * @file    test_video_stream_sender.c
+ * @brief   Test of the camera video stream send path: NAL splitter, video stream sender and recording writer,
+ *          replaying a synthetic H.264 stream against a stubbed send function.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "module_test.h"
+#include "utils/util_misc.h"
+#include "utils/util_nal_splitter.h"
+#include "utils/util_async_writer.h"
+#include "camera_emu/dji_video_stream_sender.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define TEST_SENDER_AUD_LENGTH                  6
+#define TEST_SENDER_GOP_COUNT                   10
+#define TEST_SENDER_GOP_LENGTH                  30
+#define TEST_SENDER_IDR_SIZE                    150001
+#define TEST_SENDER_STREAM_SIZE_MAX             (TEST_SENDER_GOP_COUNT * (TEST_SENDER_IDR_SIZE + \
+                                                 TEST_SENDER_GOP_LENGTH * 40000 + 64))
+#define TEST_SENDER_SPLITTER_BUFFER_SIZE        (1024 * 1024 * 2)
+#define TEST_SENDER_BENCH_ROUNDS                20
+#define TEST_SENDER_RECORD_FILE                 "test_video_stream_sender.h264"
+
+/* Private types -------------------------------------------------------------*/
+typedef enum {
+    TEST_SENDER_STUB_ACCEPT = 0,
+    TEST_SENDER_STUB_REJECT_LARGE,
+    TEST_SENDER_STUB_BUSY_ONCE,
+} E_TestSenderStubMode;
+
+typedef struct {
+    E_TestSenderStubMode mode;
+    uint32_t sizeLimit;
+    bool capture;
+    uint8_t *frame;
+    uint32_t frameLen;
+    uint32_t fragmentCount;
+    uint32_t fragmentMinLen;
+    uint32_t fragmentMaxLen;
+    uint64_t sendCount;
+} T_TestSenderStub;
+
+/* Private values -------------------------------------------------------------*/
+static const uint8_t s_audData[TEST_SENDER_AUD_LENGTH] = {0x00, 0x00, 0x00, 0x01, 0x09, 0x10};
+static T_TestSenderStub s_stub;
+static T_DjiVideoStreamSender s_sender;
+static uint8_t s_senderArena[DJI_VIDEO_STREAM_SENDER_ARENA_SIZE];
+static T_UtilAsyncWriterHandle s_recordWriter = NULL;
+static uint32_t s_frameCount = 0;
+static uint32_t s_frameErrorCount = 0;
+static uint32_t s_randomSeed = 0x2468ace0;
+static uint64_t s_allocCount = 0;
+static bool s_allocCountEnable = false;
+
+/* Private functions declaration ---------------------------------------------*/
+static uint32_t DjiTest_SenderRandom(void);
+static uint32_t DjiTest_SenderMakeNal(uint8_t *buf, uint8_t nalHeader, uint32_t payloadLen);
+static uint32_t DjiTest_SenderMakeStream(uint8_t *stream);
+static T_DjiReturnCode DjiTest_SenderStubSend(const uint8_t *data, uint32_t len);
+static void DjiTest_SenderSendNal(const uint8_t *nalData, uint32_t nalLen, void *userData);
+static void DjiTest_SenderTestFraming(void);
+static void DjiTest_SenderTestSizeAdaption(void);
+static void DjiTest_SenderTestBusy(void);
+static void DjiTest_SenderBenchmark(const uint8_t *stream, uint32_t streamLen);
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+/* Exported functions definition ---------------------------------------------*/
+int main(void)
+{
+    uint8_t *stream;
+    uint32_t streamLen;
+
+    if (ModuleTest_Init() != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        printf("register osal handler failed\r\n");
+        return 1;
+    }
+
+    DjiTest_SenderTestFraming();
+    DjiTest_SenderTestSizeAdaption();
+    DjiTest_SenderTestBusy();
+
+    stream = malloc(TEST_SENDER_STREAM_SIZE_MAX);
+    MODULE_TEST_CHECK(stream != NULL);
+    if (stream != NULL) {
+        streamLen = DjiTest_SenderMakeStream(stream);
+        DjiTest_SenderBenchmark(stream, streamLen);
+        free(stream);
+    }
+
+    return ModuleTest_Finish("test_video_stream_sender");
+}
+
+/* the test target links with --wrap for these, so allocations of the replay loop can be counted */
+void *__wrap_malloc(size_t size)
+{
+    if (__atomic_load_n(&s_allocCountEnable, __ATOMIC_RELAXED)) {
+        __atomic_add_fetch(&s_allocCount, 1, __ATOMIC_RELAXED);
+    }
+
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    if (__atomic_load_n(&s_allocCountEnable, __ATOMIC_RELAXED)) {
+        __atomic_add_fetch(&s_allocCount, 1, __ATOMIC_RELAXED);
+    }
+
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    if (__atomic_load_n(&s_allocCountEnable, __ATOMIC_RELAXED)) {
+        __atomic_add_fetch(&s_allocCount, 1, __ATOMIC_RELAXED);
+    }
+
+    return __real_realloc(ptr, size);
+}
+
+/* Private functions definition-----------------------------------------------*/
+static uint32_t DjiTest_SenderRandom(void)
+{
+    s_randomSeed = s_randomSeed * 1103515245 + 12345;
+
+    return s_randomSeed >> 8;
+}
+
+static uint32_t DjiTest_SenderMakeNal(uint8_t *buf, uint8_t nalHeader, uint32_t payloadLen)
+{
+    uint32_t len = 0;
+
+    buf[len++] = 0x00;
+    buf[len++] = 0x00;
+    buf[len++] = 0x00;
+    buf[len++] = 0x01;
+    buf[len++] = nalHeader;
+    while (payloadLen-- > 0) {
+        //no zero bytes, so the payload never contains a start code
+        buf[len++] = (uint8_t) (1 + DjiTest_SenderRandom() % 255);
+    }
+
+    return len;
+}
+
+/**
+ * @brief Build a stream shaped like the libcamera-vid output: inline SPS and PPS before every IDR frame, one
+ * large IDR slice per GOP and P slices of varying size.
+ */
+static uint32_t DjiTest_SenderMakeStream(uint8_t *stream)
+{
+    uint32_t len = 0;
+    uint32_t gop;
+    uint32_t frame;
+
+    for (gop = 0; gop < TEST_SENDER_GOP_COUNT; gop++) {
+        len += DjiTest_SenderMakeNal(stream + len, 0x67, 20);
+        len += DjiTest_SenderMakeNal(stream + len, 0x68, 4);
+        len += DjiTest_SenderMakeNal(stream + len, 0x65, TEST_SENDER_IDR_SIZE);
+        for (frame = 1; frame < TEST_SENDER_GOP_LENGTH; frame++) {
+            len += DjiTest_SenderMakeNal(stream + len, 0x41, 2000 + DjiTest_SenderRandom() % 38000);
+        }
+    }
+
+    return len;
+}
+
+static T_DjiReturnCode DjiTest_SenderStubSend(const uint8_t *data, uint32_t len)
+{
+    s_stub.sendCount++;
+
+    if (len > DJI_VIDEO_STREAM_SENDER_MAX_FRAGMENT_SIZE) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+    if (s_stub.mode == TEST_SENDER_STUB_REJECT_LARGE && len > s_stub.sizeLimit) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+    if (s_stub.mode == TEST_SENDER_STUB_BUSY_ONCE) {
+        s_stub.mode = TEST_SENDER_STUB_ACCEPT;
+        return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+    }
+
+    if (s_stub.capture) {
+        memcpy(s_stub.frame + s_stub.frameLen, data, len);
+        s_stub.frameLen += len;
+        s_stub.fragmentMinLen = USER_UTIL_MIN(s_stub.fragmentMinLen, len);
+        s_stub.fragmentMaxLen = USER_UTIL_MAX(s_stub.fragmentMaxLen, len);
+        s_stub.fragmentCount++;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief NAL splitter callback doing what the Raspberry Pi camera sample does per NAL unit: record it and send it
+ * followed by the AUD.
+ */
+static void DjiTest_SenderSendNal(const uint8_t *nalData, uint32_t nalLen, void *userData)
+{
+    const T_DjiVideoStreamSlice frameSlices[] = {
+        {nalData, nalLen},
+        {s_audData, TEST_SENDER_AUD_LENGTH},
+    };
+
+    USER_UTIL_UNUSED(userData);
+
+    if (s_recordWriter != NULL) {
+        if (UtilAsyncWriter_Write(s_recordWriter, nalData, nalLen) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS ||
+            UtilAsyncWriter_Write(s_recordWriter, s_audData, TEST_SENDER_AUD_LENGTH) !=
+            DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            s_frameErrorCount++;
+        }
+    }
+
+    if (DjiVideoStreamSender_SendSlices(&s_sender, frameSlices, UTIL_ARRAY_SIZE(frameSlices)) !=
+        DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        s_frameErrorCount++;
+    }
+    s_frameCount++;
+}
+
+/**
+ * @brief Every frame arrives complete and in order, in the fewest fragments of nearly equal length, so the AUD
+ * always shares a send call with the end of the NAL unit.
+ */
+static void DjiTest_SenderTestFraming(void)
+{
+    static const uint32_t nalLenList[] = {5, 1000, 64994, 64995, 65000, 130000, 130001, 200003};
+    static const uint8_t header[] = {0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0x00, 0x00, 0x00, 0x01, 0x68, 0xce};
+    T_DjiVideoStreamSlice slices[3];
+    uint8_t *nal;
+    uint8_t *expect;
+    uint32_t expectLen;
+    uint32_t i;
+
+    nal = malloc(200003);
+    expect = malloc(200003 + sizeof(header) + TEST_SENDER_AUD_LENGTH);
+    s_stub.frame = malloc(200003 + sizeof(header) + TEST_SENDER_AUD_LENGTH);
+    MODULE_TEST_CHECK(nal != NULL && expect != NULL && s_stub.frame != NULL);
+    if (nal == NULL || expect == NULL || s_stub.frame == NULL) {
+        goto out;
+    }
+
+    DjiVideoStreamSender_Init(&s_sender, DjiTest_SenderStubSend, s_senderArena, sizeof(s_senderArena));
+    for (i = 0; i < UTIL_ARRAY_SIZE(nalLenList) * 2; i++) {
+        DjiTest_SenderMakeNal(nal, 0x65, nalLenList[i / 2] - 5);
+        //every length with and without the parameter set header in front
+        slices[0].data = header;
+        slices[0].len = (i & 1) ? sizeof(header) : 0;
+        slices[1].data = nal;
+        slices[1].len = nalLenList[i / 2];
+        slices[2].data = s_audData;
+        slices[2].len = TEST_SENDER_AUD_LENGTH;
+
+        expectLen = 0;
+        memcpy(expect + expectLen, slices[0].data, slices[0].len);
+        expectLen += slices[0].len;
+        memcpy(expect + expectLen, slices[1].data, slices[1].len);
+        expectLen += slices[1].len;
+        memcpy(expect + expectLen, slices[2].data, slices[2].len);
+        expectLen += slices[2].len;
+
+        memset(&s_stub, 0, offsetof(T_TestSenderStub, frame));
+        s_stub.capture = true;
+        s_stub.frameLen = 0;
+        s_stub.fragmentCount = 0;
+        s_stub.fragmentMinLen = UINT32_MAX;
+        s_stub.fragmentMaxLen = 0;
+
+        MODULE_TEST_CHECK(DjiVideoStreamSender_SendSlices(&s_sender, slices, 3) ==
+                          DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+        MODULE_TEST_CHECK(s_stub.frameLen == expectLen && memcmp(s_stub.frame, expect, expectLen) == 0);
+        MODULE_TEST_CHECK(s_stub.fragmentCount == (expectLen + DJI_VIDEO_STREAM_SENDER_MAX_FRAGMENT_SIZE - 1) /
+                                                  DJI_VIDEO_STREAM_SENDER_MAX_FRAGMENT_SIZE);
+        MODULE_TEST_CHECK(s_stub.fragmentMaxLen - s_stub.fragmentMinLen <= 1);
+        MODULE_TEST_CHECK(s_stub.fragmentMinLen > TEST_SENDER_AUD_LENGTH);
+    }
+    MODULE_TEST_CHECK(s_sender.statistics.sendFailCount == 0);
+
+out:
+    free(s_stub.frame);
+    s_stub.frame = NULL;
+    s_stub.capture = false;
+    free(expect);
+    free(nal);
+}
+
+/**
+ * @brief Fragments rejected as too large shrink the fragment size until they pass, the size grows back once the
+ * link accepts full fragments again.
+ */
+static void DjiTest_SenderTestSizeAdaption(void)
+{
+    T_DjiVideoStreamSlice slice;
+    uint8_t *nal;
+    uint32_t i;
+
+    nal = malloc(100000);
+    MODULE_TEST_CHECK(nal != NULL);
+    if (nal == NULL) {
+        return;
+    }
+    DjiTest_SenderMakeNal(nal, 0x41, 100000 - 5);
+    slice.data = nal;
+    slice.len = 100000;
+
+    DjiVideoStreamSender_Init(&s_sender, DjiTest_SenderStubSend, s_senderArena, sizeof(s_senderArena));
+    memset(&s_stub, 0, sizeof(s_stub));
+    s_stub.mode = TEST_SENDER_STUB_REJECT_LARGE;
+    s_stub.sizeLimit = 30000;
+
+    for (i = 0; i < 10; i++) {
+        MODULE_TEST_CHECK(DjiVideoStreamSender_SendSlices(&s_sender, &slice, 1) ==
+                          DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    }
+    MODULE_TEST_CHECK(s_sender.statistics.fragmentSize <= 30000);
+    MODULE_TEST_CHECK(s_sender.statistics.sentBytes == 10 * 100000);
+    MODULE_TEST_CHECK(s_sender.statistics.droppedBytes == 0);
+
+    s_stub.mode = TEST_SENDER_STUB_ACCEPT;
+    for (i = 0; i < 200; i++) {
+        MODULE_TEST_CHECK(DjiVideoStreamSender_SendSlices(&s_sender, &slice, 1) ==
+                          DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    }
+    MODULE_TEST_CHECK(s_sender.statistics.fragmentSize == DJI_VIDEO_STREAM_SENDER_MAX_FRAGMENT_SIZE);
+
+    free(nal);
+}
+
+/**
+ * @brief A busy link drops the frame without touching the fragment size.
+ */
+static void DjiTest_SenderTestBusy(void)
+{
+    T_DjiVideoStreamSlice slice;
+    uint8_t nal[20000];
+
+    DjiTest_SenderMakeNal(nal, 0x41, sizeof(nal) - 5);
+    slice.data = nal;
+    slice.len = sizeof(nal);
+
+    DjiVideoStreamSender_Init(&s_sender, DjiTest_SenderStubSend, s_senderArena, sizeof(s_senderArena));
+    memset(&s_stub, 0, sizeof(s_stub));
+    s_stub.mode = TEST_SENDER_STUB_BUSY_ONCE;
+
+    MODULE_TEST_CHECK(DjiVideoStreamSender_SendSlices(&s_sender, &slice, 1) == DJI_ERROR_SYSTEM_MODULE_CODE_BUSY);
+    MODULE_TEST_CHECK(s_sender.statistics.fragmentSize == DJI_VIDEO_STREAM_SENDER_MAX_FRAGMENT_SIZE);
+    MODULE_TEST_CHECK(s_sender.statistics.droppedBytes == sizeof(nal));
+    MODULE_TEST_CHECK(DjiVideoStreamSender_SendSlices(&s_sender, &slice, 1) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+}
+
+/**
+ * @brief Replay the stream through splitter, recording writer and sender as the camera sample does, and report
+ * send calls, allocations and writer syscalls per frame.
+ */
+static void DjiTest_SenderBenchmark(const uint8_t *stream, uint32_t streamLen)
+{
+    T_UtilNalSplitter splitter;
+    T_UtilAsyncWriterConfig writerConfig;
+    T_UtilAsyncWriterStatistics writerStatistics;
+    uint8_t *splitterBuf;
+    uint64_t startUs;
+    uint64_t elapsedUs;
+    uint64_t cpuUs;
+    uint32_t offset;
+    uint32_t chunkLen;
+    uint32_t round;
+
+    splitterBuf = malloc(TEST_SENDER_SPLITTER_BUFFER_SIZE);
+    MODULE_TEST_CHECK(splitterBuf != NULL);
+    if (splitterBuf == NULL) {
+        return;
+    }
+
+    UtilAsyncWriter_GetDefaultConfig(&writerConfig);
+    MODULE_TEST_CHECK(UtilAsyncWriter_Open(TEST_SENDER_RECORD_FILE, &writerConfig, &s_recordWriter) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+    UtilNalSplitter_Init(&splitter, splitterBuf, TEST_SENDER_SPLITTER_BUFFER_SIZE, DjiTest_SenderSendNal, NULL);
+    DjiVideoStreamSender_Init(&s_sender, DjiTest_SenderStubSend, s_senderArena, sizeof(s_senderArena));
+    memset(&s_stub, 0, sizeof(s_stub));
+    s_frameCount = 0;
+    s_frameErrorCount = 0;
+
+    __atomic_store_n(&s_allocCountEnable, true, __ATOMIC_RELAXED);
+    startUs = ModuleTest_GetTimeUs();
+    cpuUs = ModuleTest_GetCpuTimeUs();
+    for (round = 0; round < TEST_SENDER_BENCH_ROUNDS; round++) {
+        //pipe sized reads, as from the libcamera-vid output
+        for (offset = 0; offset < streamLen; offset += chunkLen) {
+            chunkLen = USER_UTIL_MIN(65536, streamLen - offset);
+            UtilNalSplitter_Put(&splitter, stream + offset, chunkLen);
+        }
+        UtilNalSplitter_Flush(&splitter);
+    }
+    elapsedUs = ModuleTest_GetTimeUs() - startUs;
+    cpuUs = ModuleTest_GetCpuTimeUs() - cpuUs;
+    __atomic_store_n(&s_allocCountEnable, false, __ATOMIC_RELAXED);
+
+    if (s_recordWriter != NULL) {
+        UtilAsyncWriter_Flush(s_recordWriter);
+        UtilAsyncWriter_GetStatistics(s_recordWriter, &writerStatistics);
+        MODULE_TEST_CHECK(UtilAsyncWriter_Close(s_recordWriter) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+        s_recordWriter = NULL;
+        remove(TEST_SENDER_RECORD_FILE);
+    } else {
+        memset(&writerStatistics, 0, sizeof(writerStatistics));
+    }
+
+    MODULE_TEST_CHECK(s_frameCount == TEST_SENDER_BENCH_ROUNDS * TEST_SENDER_GOP_COUNT * (TEST_SENDER_GOP_LENGTH + 2));
+    MODULE_TEST_CHECK(s_frameErrorCount == 0);
+    MODULE_TEST_CHECK(s_allocCount == 0);
+    MODULE_TEST_CHECK(writerStatistics.bytesWritten ==
+                      (uint64_t) TEST_SENDER_BENCH_ROUNDS * (streamLen + s_frameCount / TEST_SENDER_BENCH_ROUNDS *
+                                                             TEST_SENDER_AUD_LENGTH));
+
+    printf("Video stream send path, %u NAL units of %u KiB average:\r\n", s_frameCount,
+           (uint32_t) (streamLen / (TEST_SENDER_GOP_COUNT * (TEST_SENDER_GOP_LENGTH + 2)) / 1024));
+    ModuleTest_Report("throughput", (double) streamLen * TEST_SENDER_BENCH_ROUNDS /
+                                    (double) (elapsedUs ? elapsedUs : 1), "MB/s");
+    ModuleTest_Report("cpu time per NAL unit", (double) cpuUs / s_frameCount, "us");
+    ModuleTest_Report("allocations per NAL unit", (double) s_allocCount / s_frameCount, "");
+    ModuleTest_Report("send calls per NAL unit", (double) s_stub.sendCount / s_frameCount, "");
+    ModuleTest_Report("bytes gathered per NAL unit", (double) s_sender.statistics.gatheredBytes / s_frameCount, "B");
+    ModuleTest_Report("recording write() calls per NAL unit", (double) writerStatistics.writeCount / s_frameCount, "");
+    ModuleTest_Report("recording fdatasync() calls", writerStatistics.fsyncCount, "");
+    ModuleTest_Report("recording producer waits", writerStatistics.producerWaitCount, "");
+
+    free(splitterBuf);
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,538 @@
+/**
+ ********************************************************************
+ * @file    test_widget_speaker_stream.c
+ * @brief   Test and latency benchmark of the widget speaker voice stream.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <opus/opus.h>
+#include "module_test.h"
+#include "dji_platform.h"
+#include "widget/test_widget_speaker_stream.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define TEST_SPEAKER_WAV_FILE_PATH          "test_widget_speaker_stream.wav"
+#define TEST_SPEAKER_WAV_HEADER_SIZE        44
+/* 40 ms packets of the 8 kbps voice, as the speaker sample receives them. */
+#define TEST_SPEAKER_PACKET_SIZE            40
+#define TEST_SPEAKER_PACKET_MS              40
+#define TEST_SPEAKER_PACKET_FRAMES          (DJI_TEST_WIDGET_SPEAKER_STREAM_DEFAULT_SAMPLE_RATE * \
+                                             TEST_SPEAKER_PACKET_MS / 1000)
+#define TEST_SPEAKER_PACKET_NUM             50
+/* Received bytes split packets anywhere. */
+#define TEST_SPEAKER_CHUNK_SIZE             37
+/* Arrival jitter of the paced packets, below the jitter buffer so no underrun is expected. */
+#define TEST_SPEAKER_ARRIVAL_JITTER_MS      30
+#define TEST_SPEAKER_WAIT_IDLE_MS           5000
+#define TEST_SPEAKER_STOP_MAX_MS            500
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    const uint8_t *data;
+    uint32_t len;
+    T_DjiReturnCode returnCode;
+    bool finished;
+} T_DjiTestSpeakerPusher;
+
+#ifdef MODULE_TEST_OPUS_STUB
+struct OpusDecoder {
+    int channels;
+};
+#endif
+
+/* Private values -------------------------------------------------------------*/
+static uint8_t s_voiceData[TEST_SPEAKER_PACKET_NUM * TEST_SPEAKER_PACKET_SIZE];
+static uint32_t s_randomSeed = 12345;
+
+/* Private functions declaration ---------------------------------------------*/
+static uint32_t DjiTest_SpeakerRandom(void);
+static void DjiTest_SpeakerEncodeVoice(void);
+static void DjiTest_SpeakerGetConfig(T_DjiTestWidgetSpeakerStreamConfig *config, bool blockWhenFull);
+static T_DjiReturnCode DjiTest_SpeakerPushChunks(const uint8_t *data, uint32_t len);
+static int16_t *DjiTest_SpeakerReadWav(uint32_t *frames);
+static void *DjiTest_SpeakerPusherTask(void *arg);
+static void DjiTest_SpeakerTestConfig(void);
+static void DjiTest_SpeakerTestReplay(void);
+static void DjiTest_SpeakerTestDropOldest(void);
+static void DjiTest_SpeakerTestStop(void);
+static void DjiTest_SpeakerTestFfplayMissing(void);
+static void DjiTest_SpeakerBenchmark(void);
+
+/* Exported functions definition ---------------------------------------------*/
+int main(void)
+{
+    if (ModuleTest_Init() != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        printf("register osal handler failed\r\n");
+        return 1;
+    }
+
+    if (DjiTest_WidgetSpeakerStreamInit() != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        printf("init speaker stream failed\r\n");
+        return 1;
+    }
+
+    DjiTest_SpeakerEncodeVoice();
+    DjiTest_SpeakerTestConfig();
+    DjiTest_SpeakerTestReplay();
+    DjiTest_SpeakerTestDropOldest();
+    DjiTest_SpeakerTestStop();
+    DjiTest_SpeakerTestFfplayMissing();
+    DjiTest_SpeakerBenchmark();
+
+    remove(TEST_SPEAKER_WAV_FILE_PATH);
+
+    return ModuleTest_Finish("test_widget_speaker_stream");
+}
+
+#ifdef MODULE_TEST_OPUS_STUB
+/*
+ * Stub decoder: the first two bytes of a packet are its sequence number, decoded into a frame of that value so
+ * order, loss and repetition can be read back from the played audio. A packet starting with 0xFFFF is corrupt.
+ */
+OpusDecoder *opus_decoder_create(opus_int32 Fs, int channels, int *error)
+{
+    OpusDecoder *decoder;
+
+    if (Fs != DJI_TEST_WIDGET_SPEAKER_STREAM_DEFAULT_SAMPLE_RATE || channels != 1) {
+        *error = OPUS_BAD_ARG;
+        return NULL;
+    }
+
+    decoder = malloc(sizeof(OpusDecoder));
+    if (decoder == NULL) {
+        *error = OPUS_BAD_ARG;
+        return NULL;
+    }
+    decoder->channels = channels;
+    *error = OPUS_OK;
+
+    return decoder;
+}
+
+int opus_decode(OpusDecoder *st, const unsigned char *data, opus_int32 len, opus_int16 *pcm, int frame_size,
+                int decode_fec)
+{
+    uint16_t sequence = (uint16_t) (data[0] | data[1] << 8);
+    int i;
+
+    if (st == NULL || len != TEST_SPEAKER_PACKET_SIZE || frame_size < TEST_SPEAKER_PACKET_FRAMES || decode_fec != 0) {
+        return OPUS_BAD_ARG;
+    }
+    if (sequence == 0xFFFF) {
+        return OPUS_INVALID_PACKET;
+    }
+
+    for (i = 0; i < TEST_SPEAKER_PACKET_FRAMES; i++) {
+        pcm[i] = (opus_int16) sequence;
+    }
+
+    return TEST_SPEAKER_PACKET_FRAMES;
+}
+
+void opus_decoder_destroy(OpusDecoder *st)
+{
+    free(st);
+}
+
+const char *opus_strerror(int error)
+{
+    return error == OPUS_OK ? "success" : "stub error";
+}
+#endif
+
+/* Private functions definition-----------------------------------------------*/
+static uint32_t DjiTest_SpeakerRandom(void)
+{
+    s_randomSeed = s_randomSeed * 1103515245 + 12345;
+
+    return s_randomSeed >> 8;
+}
+
+/* A 440 Hz tone encoded as 8 kbps CBR voice, or sequence numbered packets for the stub decoder. */
+static void DjiTest_SpeakerEncodeVoice(void)
+{
+#ifdef MODULE_TEST_OPUS_STUB
+    uint32_t i;
+
+    memset(s_voiceData, 0x55, sizeof(s_voiceData));
+    for (i = 0; i < TEST_SPEAKER_PACKET_NUM; i++) {
+        s_voiceData[i * TEST_SPEAKER_PACKET_SIZE] = (uint8_t) i;
+        s_voiceData[i * TEST_SPEAKER_PACKET_SIZE + 1] = (uint8_t) (i >> 8);
+    }
+#else
+    opus_int16 pcm[TEST_SPEAKER_PACKET_FRAMES];
+    OpusEncoder *encoder;
+    uint32_t i;
+    uint32_t j;
+    int err;
+
+    encoder = opus_encoder_create(DJI_TEST_WIDGET_SPEAKER_STREAM_DEFAULT_SAMPLE_RATE, 1, OPUS_APPLICATION_VOIP,
+                                  &err);
+    MODULE_TEST_CHECK(err == OPUS_OK);
+    if (err != OPUS_OK) {
+        return;
+    }
+    opus_encoder_ctl(encoder, OPUS_SET_BITRATE(TEST_SPEAKER_PACKET_SIZE * 8 * 1000 / TEST_SPEAKER_PACKET_MS));
+    opus_encoder_ctl(encoder, OPUS_SET_VBR(0));
+
+    for (i = 0; i < TEST_SPEAKER_PACKET_NUM; i++) {
+        for (j = 0; j < TEST_SPEAKER_PACKET_FRAMES; j++) {
+            pcm[j] = (opus_int16) (8000 * sin(2 * M_PI * 440 * (i * TEST_SPEAKER_PACKET_FRAMES + j) /
+                                              DJI_TEST_WIDGET_SPEAKER_STREAM_DEFAULT_SAMPLE_RATE));
+        }
+        MODULE_TEST_CHECK(opus_encode(encoder, pcm, TEST_SPEAKER_PACKET_FRAMES,
+                                      s_voiceData + i * TEST_SPEAKER_PACKET_SIZE, TEST_SPEAKER_PACKET_SIZE) ==
+                          TEST_SPEAKER_PACKET_SIZE);
+    }
+
+    opus_encoder_destroy(encoder);
+#endif
+}
+
+static void DjiTest_SpeakerGetConfig(T_DjiTestWidgetSpeakerStreamConfig *config, bool blockWhenFull)
+{
+    DjiTest_WidgetSpeakerStreamGetDefaultConfig(config);
+    config->packetSize = TEST_SPEAKER_PACKET_SIZE;
+    config->blockWhenFull = blockWhenFull;
+    config->sink = DJI_TEST_WIDGET_SPEAKER_STREAM_SINK_WAV_FILE;
+    strncpy(config->wavFilePath, TEST_SPEAKER_WAV_FILE_PATH, sizeof(config->wavFilePath) - 1);
+}
+
+static T_DjiReturnCode DjiTest_SpeakerPushChunks(const uint8_t *data, uint32_t len)
+{
+    T_DjiReturnCode returnCode = DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    uint32_t chunkLen;
+
+    while (len > 0 && returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        chunkLen = len < TEST_SPEAKER_CHUNK_SIZE ? len : TEST_SPEAKER_CHUNK_SIZE;
+        returnCode = DjiTest_WidgetSpeakerStreamPushData(data, chunkLen);
+        data += chunkLen;
+        len -= chunkLen;
+    }
+
+    return returnCode;
+}
+
+/* Samples of the mono wav the stream wrote, NULL when the header does not match the data. */
+static int16_t *DjiTest_SpeakerReadWav(uint32_t *frames)
+{
+    uint8_t header[TEST_SPEAKER_WAV_HEADER_SIZE];
+    int16_t *pcm = NULL;
+    uint32_t dataSize;
+    long fileSize;
+    FILE *file;
+
+    *frames = 0;
+    file = fopen(TEST_SPEAKER_WAV_FILE_PATH, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+
+    if (fread(header, 1, sizeof(header), file) != sizeof(header) || memcmp(header, "RIFF", 4) != 0 ||
+        memcmp(header + 36, "data", 4) != 0 || fseek(file, 0, SEEK_END) != 0) {
+        goto out;
+    }
+    fileSize = ftell(file);
+    dataSize = (uint32_t) header[40] | (uint32_t) header[41] << 8 | (uint32_t) header[42] << 16 |
+               (uint32_t) header[43] << 24;
+    if (fileSize != (long) (TEST_SPEAKER_WAV_HEADER_SIZE + dataSize) || fseek(file, sizeof(header), SEEK_SET) != 0) {
+        goto out;
+    }
+
+    pcm = malloc(dataSize + 1);
+    if (pcm == NULL) {
+        goto out;
+    }
+    if (fread(pcm, 1, dataSize, file) != dataSize) {
+        free(pcm);
+        pcm = NULL;
+        goto out;
+    }
+    *frames = dataSize / sizeof(int16_t);
+
+out:
+    fclose(file);
+
+    return pcm;
+}
+
+static void *DjiTest_SpeakerPusherTask(void *arg)
+{
+    T_DjiTestSpeakerPusher *pusher = arg;
+
+    pusher->returnCode = DjiTest_SpeakerPushChunks(pusher->data, pusher->len);
+    __atomic_store_n(&pusher->finished, true, __ATOMIC_RELEASE);
+
+    return NULL;
+}
+
+static void DjiTest_SpeakerTestConfig(void)
+{
+    T_DjiTestWidgetSpeakerStreamConfig config;
+
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamInit() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamStart(NULL) == DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER);
+
+    DjiTest_SpeakerGetConfig(&config, true);
+    config.maxLatencyMs = config.jitterBufferMs;
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamStart(&config) == DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER);
+
+    DjiTest_SpeakerGetConfig(&config, true);
+    config.packetSize = DJI_TEST_WIDGET_SPEAKER_STREAM_MAX_PACKET_SIZE + 1;
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamStart(&config) == DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER);
+
+    DjiTest_SpeakerGetConfig(&config, true);
+    config.sampleRate = 12345;
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamStart(&config) != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(!DjiTest_WidgetSpeakerStreamIsActive());
+
+#ifndef ALSA_INSTALLED
+    DjiTest_SpeakerGetConfig(&config, true);
+    config.sink = DJI_TEST_WIDGET_SPEAKER_STREAM_SINK_ALSA;
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamStart(&config) == DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT);
+    DjiTest_WidgetSpeakerStreamGetDefaultConfig(&config);
+    MODULE_TEST_CHECK(config.sink == DJI_TEST_WIDGET_SPEAKER_STREAM_SINK_FFPLAY);
+#endif
+
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamPushData(s_voiceData, TEST_SPEAKER_PACKET_SIZE) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE);
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamFinish() == DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE);
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamStop() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamWaitIdle(0) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+}
+
+/**
+ * @brief A voice file pushed as fast as it can be read is played completely and in order, the producer waits for
+ * room instead of dropping audio.
+ */
+static void DjiTest_SpeakerTestReplay(void)
+{
+    T_DjiTestWidgetSpeakerStreamConfig config;
+    T_DjiTestWidgetSpeakerStreamStatistics statistics;
+    uint64_t startTimeUs;
+    uint64_t pushTimeUs;
+    uint32_t frames;
+    int16_t *pcm;
+#ifdef MODULE_TEST_OPUS_STUB
+    uint32_t mismatchNum = 0;
+    uint32_t i;
+#endif
+
+    DjiTest_SpeakerGetConfig(&config, true);
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamStart(&config) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+    startTimeUs = ModuleTest_GetTimeUs();
+    MODULE_TEST_CHECK(DjiTest_SpeakerPushChunks(s_voiceData, sizeof(s_voiceData)) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    pushTimeUs = ModuleTest_GetTimeUs() - startTimeUs;
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamPushData(NULL, 0) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamFinish() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamPushData(s_voiceData, TEST_SPEAKER_PACKET_SIZE) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE);
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamWaitIdle(TEST_SPEAKER_WAIT_IDLE_MS) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    DjiTest_WidgetSpeakerStreamGetStatistics(&statistics);
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamStop() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+    // the producer is held back to the latency bound ahead of the playback
+    MODULE_TEST_CHECK(pushTimeUs + (uint64_t) config.maxLatencyMs * 1000 >=
+                      (uint64_t) (TEST_SPEAKER_PACKET_NUM * TEST_SPEAKER_PACKET_MS - 2 * config.periodMs) * 1000);
+    MODULE_TEST_CHECK(statistics.receivedPacketCount == TEST_SPEAKER_PACKET_NUM);
+    MODULE_TEST_CHECK(statistics.droppedFrameCount == 0);
+    MODULE_TEST_CHECK(statistics.decodeErrorCount == 0);
+    MODULE_TEST_CHECK(statistics.underrunCount == 0);
+    MODULE_TEST_CHECK(statistics.latencyCount == TEST_SPEAKER_PACKET_NUM);
+
+    pcm = DjiTest_SpeakerReadWav(&frames);
+    MODULE_TEST_CHECK(pcm != NULL);
+    MODULE_TEST_CHECK(frames == TEST_SPEAKER_PACKET_NUM * TEST_SPEAKER_PACKET_FRAMES);
+#ifdef MODULE_TEST_OPUS_STUB
+    for (i = 0; pcm != NULL && i < frames; i++) {
+        if (pcm[i] != (int16_t) (i / TEST_SPEAKER_PACKET_FRAMES)) {
+            mismatchNum++;
+        }
+    }
+    MODULE_TEST_CHECK(mismatchNum == 0);
+#endif
+    free(pcm);
+}
+
+/**
+ * @brief Without blockWhenFull a burst keeps only the newest audio, within the latency bound. Corrupt packets are
+ * counted and skipped.
+ */
+static void DjiTest_SpeakerTestDropOldest(void)
+{
+    T_DjiTestWidgetSpeakerStreamConfig config;
+    T_DjiTestWidgetSpeakerStreamStatistics statistics;
+    uint32_t frames;
+    int16_t *pcm;
+#ifdef MODULE_TEST_OPUS_STUB
+    uint8_t corruptPacket[TEST_SPEAKER_PACKET_SIZE];
+#endif
+
+    DjiTest_SpeakerGetConfig(&config, false);
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamStart(&config) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+#ifdef MODULE_TEST_OPUS_STUB
+    memset(corruptPacket, 0xFF, sizeof(corruptPacket));
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamPushData(corruptPacket, sizeof(corruptPacket)) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+#endif
+    MODULE_TEST_CHECK(DjiTest_SpeakerPushChunks(s_voiceData, sizeof(s_voiceData)) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamFinish() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamWaitIdle(TEST_SPEAKER_WAIT_IDLE_MS) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    DjiTest_WidgetSpeakerStreamGetStatistics(&statistics);
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamStop() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+    MODULE_TEST_CHECK(statistics.droppedFrameCount > 0);
+    // a frame cut short by a drop is counted both as played and as dropped
+    MODULE_TEST_CHECK(statistics.droppedFrameCount + statistics.latencyCount >= TEST_SPEAKER_PACKET_NUM);
+    MODULE_TEST_CHECK(statistics.latencyMaxUs <= (uint64_t) (config.maxLatencyMs + 2 * config.periodMs) * 1000);
+#ifdef MODULE_TEST_OPUS_STUB
+    MODULE_TEST_CHECK(statistics.receivedPacketCount == TEST_SPEAKER_PACKET_NUM + 1);
+    MODULE_TEST_CHECK(statistics.decodeErrorCount == 1);
+#endif
+
+    pcm = DjiTest_SpeakerReadWav(&frames);
+    MODULE_TEST_CHECK(pcm != NULL);
+    MODULE_TEST_CHECK(frames <= config.maxLatencyMs * config.sampleRate / 1000 + TEST_SPEAKER_PACKET_FRAMES);
+#ifdef MODULE_TEST_OPUS_STUB
+    // the newest packet is always kept
+    MODULE_TEST_CHECK(pcm != NULL && frames > 0 && pcm[frames - 1] == TEST_SPEAKER_PACKET_NUM - 1);
+#endif
+    free(pcm);
+}
+
+/**
+ * @brief Stop wakes a producer waiting for room and returns without playing out the buffer.
+ */
+static void DjiTest_SpeakerTestStop(void)
+{
+    T_DjiTestWidgetSpeakerStreamConfig config;
+    T_DjiTestSpeakerPusher pusher = {s_voiceData, sizeof(s_voiceData), DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS, false};
+    pthread_t pusherTask;
+    uint64_t stopTimeUs;
+
+    DjiTest_SpeakerGetConfig(&config, true);
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamStart(&config) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    if (pthread_create(&pusherTask, NULL, DjiTest_SpeakerPusherTask, &pusher) != 0) {
+        MODULE_TEST_CHECK(false);
+        DjiTest_WidgetSpeakerStreamStop();
+        return;
+    }
+
+    usleep(200 * 1000);
+    MODULE_TEST_CHECK(!__atomic_load_n(&pusher.finished, __ATOMIC_ACQUIRE));
+
+    stopTimeUs = ModuleTest_GetTimeUs();
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamStop() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    stopTimeUs = ModuleTest_GetTimeUs() - stopTimeUs;
+    pthread_join(pusherTask, NULL);
+
+    MODULE_TEST_CHECK(stopTimeUs < TEST_SPEAKER_STOP_MAX_MS * 1000);
+    MODULE_TEST_CHECK(pusher.returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE);
+    MODULE_TEST_CHECK(!DjiTest_WidgetSpeakerStreamIsActive());
+    ModuleTest_Report("stop with a waiting producer", stopTimeUs / 1000.0, "ms");
+}
+
+/**
+ * @brief Without ffplay installed the ffplay sink fails its writes and ends the stream, the process survives the
+ * closed pipe. Skipped where ffplay exists, the test would play sound.
+ */
+static void DjiTest_SpeakerTestFfplayMissing(void)
+{
+    T_DjiTestWidgetSpeakerStreamConfig config;
+    T_DjiTestWidgetSpeakerStreamStatistics statistics;
+
+    if (system("command -v ffplay >/dev/null 2>&1") == 0) {
+        return;
+    }
+
+    DjiTest_SpeakerGetConfig(&config, true);
+    config.sink = DJI_TEST_WIDGET_SPEAKER_STREAM_SINK_FFPLAY;
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamStart(&config) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_SpeakerPushChunks(s_voiceData, sizeof(s_voiceData)) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE);
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamWaitIdle(TEST_SPEAKER_WAIT_IDLE_MS) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    DjiTest_WidgetSpeakerStreamGetStatistics(&statistics);
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamStop() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(statistics.playedPeriodCount < TEST_SPEAKER_PACKET_NUM * TEST_SPEAKER_PACKET_MS /
+                                                     config.periodMs);
+}
+
+/**
+ * @brief Voice packets arriving in real time with jitter, as a live voice does: latency from receipt to the
+ * speaker, underruns and the CPU time of decoding and playback.
+ */
+static void DjiTest_SpeakerBenchmark(void)
+{
+    T_DjiTestWidgetSpeakerStreamConfig config;
+    T_DjiTestWidgetSpeakerStreamStatistics statistics;
+    uint64_t startTimeUs;
+    uint64_t sendTimeUs;
+    uint64_t nowUs;
+    uint32_t i;
+
+    DjiTest_SpeakerGetConfig(&config, true);
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamStart(&config) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+    startTimeUs = ModuleTest_GetTimeUs();
+    for (i = 0; i < TEST_SPEAKER_PACKET_NUM; i++) {
+        sendTimeUs = startTimeUs + (uint64_t) i * TEST_SPEAKER_PACKET_MS * 1000 +
+                     DjiTest_SpeakerRandom() % (TEST_SPEAKER_ARRIVAL_JITTER_MS * 1000);
+        nowUs = ModuleTest_GetTimeUs();
+        if (sendTimeUs > nowUs) {
+            usleep((useconds_t) (sendTimeUs - nowUs));
+        }
+        MODULE_TEST_CHECK(DjiTest_SpeakerPushChunks(s_voiceData + i * TEST_SPEAKER_PACKET_SIZE,
+                                                    TEST_SPEAKER_PACKET_SIZE) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    }
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamFinish() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamWaitIdle(TEST_SPEAKER_WAIT_IDLE_MS) ==
+                      DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+    DjiTest_WidgetSpeakerStreamGetStatistics(&statistics);
+    MODULE_TEST_CHECK(DjiTest_WidgetSpeakerStreamStop() == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS);
+
+    MODULE_TEST_CHECK(statistics.droppedFrameCount == 0);
+    MODULE_TEST_CHECK(statistics.underrunCount == 0);
+    MODULE_TEST_CHECK(statistics.latencyCount == TEST_SPEAKER_PACKET_NUM);
+    MODULE_TEST_CHECK(statistics.latencyMaxUs <= (uint64_t) config.maxLatencyMs * 1000);
+
+    ModuleTest_Report("live latency avg", statistics.latencyAverageUs / 1000.0, "ms");
+    ModuleTest_Report("live latency max", statistics.latencyMaxUs / 1000.0, "ms");
+    ModuleTest_Report("live underruns", statistics.underrunCount, "");
+    ModuleTest_Report("decode cpu per packet",
+                      (double) statistics.decodeCpuTimeUs / statistics.receivedPacketCount, "us");
+    ModuleTest_Report("playback cpu per second of audio", (double) statistics.playbackCpuTimeUs * 1000 /
+                                                          (TEST_SPEAKER_PACKET_NUM * TEST_SPEAKER_PACKET_MS), "us");
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,84 @@
+/**
+ ********************************************************************
+ * @file    point_cloud_convert.c
+ * @brief   Command line tool converting point cloud records (.pcr) saved by the camera manager sample
+ *          to PCD or PLY files.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include "camera_manager/test_camera_manager_point_cloud.h"
+
+/* Private constants ---------------------------------------------------------*/
+
+/* Private types -------------------------------------------------------------*/
+
+/* Private functions declaration ---------------------------------------------*/
+static void PointCloudConvert_PrintUsage(const char *name);
+
+/* Private values -------------------------------------------------------------*/
+
+/* Exported functions definition ---------------------------------------------*/
+int main(int argc, char *argv[])
+{
+    E_DjiTestPointCloudExportFormat format;
+    T_DjiTestPointCloudReaderStatistics statistics;
+    const char *extension;
+    T_DjiReturnCode returnCode;
+
+    if (argc != 3) {
+        PointCloudConvert_PrintUsage(argv[0]);
+        return 1;
+    }
+
+    extension = strrchr(argv[2], '.');
+    if (extension != NULL && strcmp(extension, ".ply") == 0) {
+        format = DJI_TEST_POINT_CLOUD_EXPORT_FORMAT_PLY;
+    } else if (extension != NULL && strcmp(extension, ".pcd") == 0) {
+        format = DJI_TEST_POINT_CLOUD_EXPORT_FORMAT_PCD;
+    } else {
+        PointCloudConvert_PrintUsage(argv[0]);
+        return 1;
+    }
+
+    returnCode = DjiTest_PointCloudRecordExport(argv[1], argv[2], format, &statistics);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        fprintf(stderr, "Convert %s failed, error code: 0x%08llX.\n", argv[1], (unsigned long long) returnCode);
+        return 1;
+    }
+
+    printf("frames: %u, points: %llu\n", statistics.frameCount, (unsigned long long) statistics.pointCount);
+    printf("lost frames: %u in %u gaps, reordered frames: %u\n", statistics.lostFrameCount, statistics.gapCount,
+           statistics.reorderedFrameCount);
+    printf("corrupt frames: %u, skipped bytes: %llu\n", statistics.corruptFrameCount,
+           (unsigned long long) statistics.skippedBytes);
+
+    return 0;
+}
+
+/* Private functions definition-----------------------------------------------*/
+static void PointCloudConvert_PrintUsage(const char *name)
+{
+    fprintf(stderr, "Usage: %s <input.pcr> <output.pcd|output.ply>\n", name);
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
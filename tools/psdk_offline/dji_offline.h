@@ -0,0 +1,90 @@
+/**
+ ********************************************************************
+ * @file    dji_offline.h
+ * @brief   This is the header file for the offline PSDK stand-in library, defining the replay
+ * configuration and the formats of the recorded files.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef DJI_OFFLINE_H
+#define DJI_OFFLINE_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_typedef.h"
+#include "dji_perception.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+#define DJI_OFFLINE_PATH_MAX                        256
+#define DJI_OFFLINE_DEFAULT_DATA_DIR_PATH           "./offline_data"
+#define DJI_OFFLINE_DEFAULT_MOP_PORT_BASE           47000
+#define DJI_OFFLINE_DEFAULT_LIVEVIEW_FRAME_RATE     30
+
+/* Magic of the perception image records, "DPIR" in file byte order. */
+#define DJI_OFFLINE_PERCEPTION_RECORD_MAGIC         0x52495044
+
+/* Exported types ------------------------------------------------------------*/
+/**
+ * @brief Replay configuration. The defaults may be overridden by the environment variables given with each
+ * field, so an unmodified sample binary can be pointed at different recordings.
+ */
+typedef struct {
+    /*! Directory of the recorded files, see README.md. DJI_OFFLINE_DATA_DIR */
+    char dataDirPath[DJI_OFFLINE_PATH_MAX];
+    /*! Replay speed, 1 replays in real time, 0 as fast as the callbacks return. DJI_OFFLINE_RATE */
+    float rate;
+    /*! Restart every recording at its end. DJI_OFFLINE_LOOP */
+    bool loop;
+    /*! Reported by DjiAircraftInfo_GetBaseInfo. DJI_OFFLINE_AIRCRAFT_TYPE */
+    E_DjiAircraftType aircraftType;
+    /*! Reported by DjiAircraftInfo_GetBaseInfo. DJI_OFFLINE_MOUNT_POSITION */
+    E_DjiMountPosition mountPosition;
+    /*! MOP channel n listens on TCP port mopPortBase + n of the loopback interface. DJI_OFFLINE_MOP_PORT_BASE */
+    uint16_t mopPortBase;
+    /*! Frame rate of the recorded H.264 liveview streams. DJI_OFFLINE_LIVEVIEW_FPS */
+    uint32_t liveviewFrameRate;
+} T_DjiOfflineConfig;
+
+/**
+ * @brief Header of each frame in a perception image record, followed by dataLen bytes of image data.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t dataLen;
+    /*! Local receive time, the replay is paced by the differences of this field. */
+    uint64_t recvTimeUs;
+    T_DjiPerceptionImageInfo imageInfo;
+} __attribute__((packed)) T_DjiOfflinePerceptionRecordHeader;
+
+/* Exported functions --------------------------------------------------------*/
+void DjiOffline_GetDefaultConfig(T_DjiOfflineConfig *config);
+T_DjiReturnCode DjiOffline_SetConfig(const T_DjiOfflineConfig *config);
+const T_DjiOfflineConfig *DjiOffline_GetConfig(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DJI_OFFLINE_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
@@ -0,0 +1,565 @@
+/**
+ ********************************************************************
+ * @file    dji_offline_core.c
+ * @brief   Offline stand-in of the core, platform, logger and aircraft information APIs. Recorded
+ *          flight data found in the data directory is replayed to the subscription API from DjiCore_Init.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <glob.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dji_offline.h"
+#include "dji_offline_player.h"
+#include "dji_core.h"
+#include "dji_logger.h"
+#include "dji_platform.h"
+#include "dji_aircraft_info.h"
+#include "dji_fc_subscription_replay.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define DJI_OFFLINE_CONSOLE_MAX_NUM             8
+#define DJI_OFFLINE_LOG_LINE_MAX_SIZE           1024
+#define DJI_OFFLINE_FC_RECORD_PATTERN           "*.fcr"
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    E_DjiAircraftType aircraftType;
+    E_DjiAircraftSeries aircraftSeries;
+} T_DjiOfflineAircraftSeriesEntry;
+
+/* Private functions declaration ---------------------------------------------*/
+static T_DjiReturnCode DjiOffline_StartFcReplay(void);
+static void DjiOffline_StopFcReplay(void);
+static T_DjiReturnCode DjiOffline_FcReplayPeek(void *arg, uint64_t *timeUs);
+static T_DjiReturnCode DjiOffline_FcReplayDeliver(void *arg);
+static T_DjiReturnCode DjiOffline_FcReplayRewind(void *arg);
+
+/* Private values -------------------------------------------------------------*/
+static T_DjiOfflineConfig s_offlineConfig;
+static bool s_offlineConfigValid = false;
+
+static T_DjiOsalHandler s_osalHandler;
+static bool s_osalHandlerValid = false;
+static T_DjiHalUartHandler s_halUartHandler;
+static T_DjiHalUsbBulkHandler s_halUsbBulkHandler;
+static bool s_halUsbBulkHandlerValid = false;
+static T_DjiHalNetworkHandler s_halNetworkHandler;
+static bool s_halNetworkHandlerValid = false;
+static T_DjiHalI2cHandler s_halI2cHandler;
+static bool s_halI2cHandlerValid = false;
+static T_DjiFileSystemHandler s_fileSystemHandler;
+static bool s_fileSystemHandlerValid = false;
+static T_DjiSocketHandler s_socketHandler;
+static bool s_socketHandlerValid = false;
+
+static T_DjiLoggerConsole s_loggerConsoles[DJI_OFFLINE_CONSOLE_MAX_NUM];
+static uint32_t s_loggerConsoleCount = 0;
+
+static bool s_coreInited = false;
+static glob_t s_fcRecordGlob;
+static T_DjiOfflinePlayer s_fcReplayPlayer = {0};
+
+static const T_DjiOfflineAircraftSeriesEntry s_aircraftSeriesTable[] = {
+    {DJI_AIRCRAFT_TYPE_M200_V2,    DJI_AIRCRAFT_SERIES_M200_V2},
+    {DJI_AIRCRAFT_TYPE_M210_V2,    DJI_AIRCRAFT_SERIES_M200_V2},
+    {DJI_AIRCRAFT_TYPE_M210RTK_V2, DJI_AIRCRAFT_SERIES_M200_V2},
+    {DJI_AIRCRAFT_TYPE_M300_RTK,   DJI_AIRCRAFT_SERIES_M300},
+    {DJI_AIRCRAFT_TYPE_M30,        DJI_AIRCRAFT_SERIES_M30},
+    {DJI_AIRCRAFT_TYPE_M30T,       DJI_AIRCRAFT_SERIES_M30},
+    {DJI_AIRCRAFT_TYPE_M3E,        DJI_AIRCRAFT_SERIES_M3},
+    {DJI_AIRCRAFT_TYPE_M3T,        DJI_AIRCRAFT_SERIES_M3},
+    {DJI_AIRCRAFT_TYPE_M3TA,       DJI_AIRCRAFT_SERIES_M3},
+    {DJI_AIRCRAFT_TYPE_FC30,       DJI_AIRCRAFT_SERIES_FC30},
+    {DJI_AIRCRAFT_TYPE_M350_RTK,   DJI_AIRCRAFT_SERIES_M350},
+    {DJI_AIRCRAFT_TYPE_M3D,        DJI_AIRCRAFT_SERIES_M3D},
+    {DJI_AIRCRAFT_TYPE_M3TD,       DJI_AIRCRAFT_SERIES_M3D},
+    {DJI_AIRCRAFT_TYPE_M4T,        DJI_AIRCRAFT_SERIES_M4},
+    {DJI_AIRCRAFT_TYPE_M4E,        DJI_AIRCRAFT_SERIES_M4},
+    {DJI_AIRCRAFT_TYPE_M4TD,       DJI_AIRCRAFT_SERIES_M4D},
+    {DJI_AIRCRAFT_TYPE_M4D,        DJI_AIRCRAFT_SERIES_M4D},
+    {DJI_AIRCRAFT_TYPE_M400,       DJI_AIRCRAFT_SERIES_M400},
+};
+
+/* Exported functions definition ---------------------------------------------*/
+/**
+ * @brief Get the default configuration, overridden by the DJI_OFFLINE_* environment variables that are set.
+ */
+void DjiOffline_GetDefaultConfig(T_DjiOfflineConfig *config)
+{
+    const char *value;
+
+    memset(config, 0, sizeof(T_DjiOfflineConfig));
+    strncpy(config->dataDirPath, DJI_OFFLINE_DEFAULT_DATA_DIR_PATH, sizeof(config->dataDirPath) - 1);
+    config->rate = 1.0f;
+    config->loop = false;
+    config->aircraftType = DJI_AIRCRAFT_TYPE_M350_RTK;
+    config->mountPosition = DJI_MOUNT_POSITION_EXTENSION_PORT;
+    config->mopPortBase = DJI_OFFLINE_DEFAULT_MOP_PORT_BASE;
+    config->liveviewFrameRate = DJI_OFFLINE_DEFAULT_LIVEVIEW_FRAME_RATE;
+
+    if ((value = getenv("DJI_OFFLINE_DATA_DIR")) != NULL) {
+        strncpy(config->dataDirPath, value, sizeof(config->dataDirPath) - 1);
+    }
+    if ((value = getenv("DJI_OFFLINE_RATE")) != NULL) {
+        config->rate = strtof(value, NULL);
+    }
+    if ((value = getenv("DJI_OFFLINE_LOOP")) != NULL) {
+        config->loop = atoi(value) != 0;
+    }
+    if ((value = getenv("DJI_OFFLINE_AIRCRAFT_TYPE")) != NULL) {
+        config->aircraftType = (E_DjiAircraftType) atoi(value);
+    }
+    if ((value = getenv("DJI_OFFLINE_MOUNT_POSITION")) != NULL) {
+        config->mountPosition = (E_DjiMountPosition) atoi(value);
+    }
+    if ((value = getenv("DJI_OFFLINE_MOP_PORT_BASE")) != NULL) {
+        config->mopPortBase = (uint16_t) atoi(value);
+    }
+    if ((value = getenv("DJI_OFFLINE_LIVEVIEW_FPS")) != NULL) {
+        config->liveviewFrameRate = (uint32_t) atoi(value);
+    }
+}
+
+/**
+ * @brief Replace the configuration, only before DjiCore_Init.
+ */
+T_DjiReturnCode DjiOffline_SetConfig(const T_DjiOfflineConfig *config)
+{
+    if (config == NULL || config->rate < 0 || config->liveviewFrameRate == 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    if (s_coreInited) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE;
+    }
+
+    s_offlineConfig = *config;
+    s_offlineConfig.dataDirPath[sizeof(s_offlineConfig.dataDirPath) - 1] = '\0';
+    s_offlineConfigValid = true;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+const T_DjiOfflineConfig *DjiOffline_GetConfig(void)
+{
+    if (!s_offlineConfigValid) {
+        DjiOffline_GetDefaultConfig(&s_offlineConfig);
+        if (s_offlineConfig.rate < 0) {
+            s_offlineConfig.rate = 0;
+        }
+        if (s_offlineConfig.liveviewFrameRate == 0) {
+            s_offlineConfig.liveviewFrameRate = DJI_OFFLINE_DEFAULT_LIVEVIEW_FRAME_RATE;
+        }
+        s_offlineConfigValid = true;
+    }
+
+    return &s_offlineConfig;
+}
+
+T_DjiReturnCode DjiPlatform_RegHalUartHandler(const T_DjiHalUartHandler *halUartHandler)
+{
+    if (halUartHandler == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+    s_halUartHandler = *halUartHandler;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiPlatform_RegHalUsbBulkHandler(const T_DjiHalUsbBulkHandler *halUsbBulkHandler)
+{
+    if (halUsbBulkHandler == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+    s_halUsbBulkHandler = *halUsbBulkHandler;
+    s_halUsbBulkHandlerValid = true;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiPlatform_RegHalNetworkHandler(const T_DjiHalNetworkHandler *halNetworkHandler)
+{
+    if (halNetworkHandler == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+    s_halNetworkHandler = *halNetworkHandler;
+    s_halNetworkHandlerValid = true;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiPlatform_RegHalI2cHandler(const T_DjiHalI2cHandler *halI2cHandler)
+{
+    if (halI2cHandler == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+    s_halI2cHandler = *halI2cHandler;
+    s_halI2cHandlerValid = true;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiPlatform_RegOsalHandler(const T_DjiOsalHandler *osalHandler)
+{
+    if (osalHandler == NULL || osalHandler->TaskCreate == NULL || osalHandler->SemaphoreTimedWait == NULL ||
+        osalHandler->GetTimeMs == NULL || osalHandler->Malloc == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+    s_osalHandler = *osalHandler;
+    s_osalHandlerValid = true;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiPlatform_RegFileSystemHandler(const T_DjiFileSystemHandler *fileSystemHandler)
+{
+    if (fileSystemHandler == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+    s_fileSystemHandler = *fileSystemHandler;
+    s_fileSystemHandlerValid = true;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiPlatform_RegSocketHandler(const T_DjiSocketHandler *socketHandler)
+{
+    if (socketHandler == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+    s_socketHandler = *socketHandler;
+    s_socketHandlerValid = true;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiOsalHandler *DjiPlatform_GetOsalHandler(void)
+{
+    return s_osalHandlerValid ? &s_osalHandler : NULL;
+}
+
+T_DjiHalUsbBulkHandler *DjiPlatform_GetHalUsbBulkHandler(void)
+{
+    return s_halUsbBulkHandlerValid ? &s_halUsbBulkHandler : NULL;
+}
+
+T_DjiHalNetworkHandler *DjiPlatform_GetHalNetworkHandler(void)
+{
+    return s_halNetworkHandlerValid ? &s_halNetworkHandler : NULL;
+}
+
+T_DjiHalI2cHandler *DjiPlatform_GetHalI2cHandler(void)
+{
+    return s_halI2cHandlerValid ? &s_halI2cHandler : NULL;
+}
+
+T_DjiFileSystemHandler *DjiPlatform_GetFileSystemHandler(void)
+{
+    return s_fileSystemHandlerValid ? &s_fileSystemHandler : NULL;
+}
+
+T_DjiSocketHandler *DjiPlatform_GetSocketHandler(void)
+{
+    return s_socketHandlerValid ? &s_socketHandler : NULL;
+}
+
+T_DjiReturnCode DjiLogger_AddConsole(T_DjiLoggerConsole *console)
+{
+    if (console == NULL || console->func == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    if (s_loggerConsoleCount >= DJI_OFFLINE_CONSOLE_MAX_NUM) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
+    }
+    s_loggerConsoles[s_loggerConsoleCount++] = *console;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiLogger_RemoveConsole(T_DjiLoggerConsole *console)
+{
+    uint32_t i;
+
+    for (i = 0; i < s_loggerConsoleCount; i++) {
+        if (s_loggerConsoles[i].func == console->func) {
+            s_loggerConsoles[i] = s_loggerConsoles[--s_loggerConsoleCount];
+            return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+        }
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+}
+
+void DjiLogger_UserLogOutput(E_DjiLoggerConsoleLogLevel level, const char *fmt, ...)
+{
+    static const char *const levelNames[] = {"Error", "Warn", "Info", "Debug"};
+    static const char *const levelColors[] = {"\033[31m", "\033[33m", "\033[32m", "\033[37m"};
+    char line[DJI_OFFLINE_LOG_LINE_MAX_SIZE];
+    char colorLine[DJI_OFFLINE_LOG_LINE_MAX_SIZE + 16];
+    uint32_t timeMs = 0;
+    va_list args;
+    int len;
+    uint32_t i;
+
+    if ((uint32_t) level > DJI_LOGGER_CONSOLE_LOG_LEVEL_DEBUG) {
+        return;
+    }
+
+    if (s_osalHandlerValid) {
+        s_osalHandler.GetTimeMs(&timeMs);
+    }
+
+    len = snprintf(line, sizeof(line), "[%u.%03u][offline]-[%s]-", timeMs / 1000, timeMs % 1000,
+                   levelNames[level]);
+    va_start(args, fmt);
+    vsnprintf(line + len, sizeof(line) - len - 2, fmt, args);
+    va_end(args);
+    strcat(line, "\r\n");
+    snprintf(colorLine, sizeof(colorLine), "%s%s\033[0m", levelColors[level], line);
+
+    for (i = 0; i < s_loggerConsoleCount; i++) {
+        if (level <= s_loggerConsoles[i].consoleLevel) {
+            if (s_loggerConsoles[i].isSupportColor) {
+                s_loggerConsoles[i].func((const uint8_t *) colorLine, (uint16_t) strlen(colorLine));
+            } else {
+                s_loggerConsoles[i].func((const uint8_t *) line, (uint16_t) strlen(line));
+            }
+        }
+    }
+}
+
+T_DjiReturnCode DjiCore_Init(const T_DjiUserInfo *userInfo)
+{
+    const T_DjiOfflineConfig *config = DjiOffline_GetConfig();
+    T_DjiReturnCode returnCode;
+
+    if (userInfo == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    if (!s_osalHandlerValid) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE;
+    }
+
+    if (s_coreInited) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+    }
+    s_coreInited = true;
+
+    USER_LOG_INFO("Offline PSDK, app %s, data %s, rate %.2f%s.", userInfo->appName, config->dataDirPath,
+                  config->rate, config->loop ? ", loop" : "");
+
+    returnCode = DjiOffline_StartFcReplay();
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        USER_LOG_WARN("No flight data is replayed, error: 0x%08llX.", returnCode);
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiCore_SetAlias(const char *productAlias)
+{
+    return productAlias == NULL ? DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER :
+           DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiCore_SetFirmwareVersion(T_DjiFirmwareVersion version)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiCore_SetSerialNumber(const char *productSerialNumber)
+{
+    return productSerialNumber == NULL ? DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER :
+           DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiCore_ApplicationStart(void)
+{
+    return s_coreInited ? DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS :
+           DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE;
+}
+
+T_DjiReturnCode DjiCore_DeInit(void)
+{
+    if (!s_coreInited) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    DjiOffline_StopFcReplay();
+    s_coreInited = false;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiAircraftInfo_GetBaseInfo(T_DjiAircraftInfoBaseInfo *baseInfo)
+{
+    const T_DjiOfflineConfig *config = DjiOffline_GetConfig();
+    uint32_t i;
+
+    if (baseInfo == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    memset(baseInfo, 0, sizeof(T_DjiAircraftInfoBaseInfo));
+    baseInfo->aircraftType = config->aircraftType;
+    baseInfo->mountPosition = config->mountPosition;
+    for (i = 0; i < sizeof(s_aircraftSeriesTable) / sizeof(s_aircraftSeriesTable[0]); i++) {
+        if (s_aircraftSeriesTable[i].aircraftType == config->aircraftType) {
+            baseInfo->aircraftSeries = s_aircraftSeriesTable[i].aircraftSeries;
+        }
+    }
+
+    if (config->mountPosition == DJI_MOUNT_POSITION_EXTENSION_PORT) {
+        baseInfo->mountPositionType = DJI_MOUNT_POSITION_TYPE_EXTENSION_PORT;
+        baseInfo->djiAdapterType = DJI_SDK_ADAPTER_TYPE_NONE;
+    } else if (config->mountPosition == DJI_MOUNT_POSITION_EXTENSION_LITE_PORT) {
+        baseInfo->mountPositionType = DJI_MOUNT_POSITION_TYPE_EXTENSION_LITE_PORT;
+        baseInfo->djiAdapterType = DJI_SDK_ADAPTER_TYPE_NONE;
+    } else {
+        baseInfo->mountPositionType = DJI_MOUNT_POSITION_TYPE_PAYLOAD_PORT;
+        baseInfo->djiAdapterType = DJI_SDK_ADAPTER_TYPE_SKYPORT_V2;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiAircraftInfo_GetMobileAppInfo(T_DjiMobileAppInfo *mobileAppInfo)
+{
+    if (mobileAppInfo == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    mobileAppInfo->appLanguage = DJI_MOBILE_APP_LANGUAGE_ENGLISH;
+    mobileAppInfo->appScreenType = DJI_MOBILE_APP_SCREEN_TYPE_BIG_SCREEN;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiAircraftInfo_GetConnectionStatus(bool *isConnected)
+{
+    if (isConnected == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+    *isConnected = s_coreInited;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiAircraftInfo_GetAircraftVersion(T_DjiAircraftVersion *aircraftVersion)
+{
+    if (aircraftVersion == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+    memset(aircraftVersion, 0, sizeof(T_DjiAircraftVersion));
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Delete a file or an empty directory, declared by utils/util_file.h of the samples.
+ */
+T_DjiReturnCode DjiFile_Delete(const char *filePath)
+{
+    if (filePath == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    return remove(filePath) == 0 ? DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS : DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+}
+
+/* Private functions definition-----------------------------------------------*/
+/**
+ * @brief Replay the flight data records of the data directory, in name order, as if the aircraft was sending
+ * them. Subscriptions made later receive the data from that point on.
+ */
+static T_DjiReturnCode DjiOffline_StartFcReplay(void)
+{
+    T_DjiOfflinePlayerSource source = {
+        .Peek = DjiOffline_FcReplayPeek,
+        .Deliver = DjiOffline_FcReplayDeliver,
+        .Rewind = DjiOffline_FcReplayRewind,
+    };
+    char pattern[DJI_OFFLINE_PATH_MAX];
+    T_DjiReturnCode returnCode;
+
+    returnCode = DjiOffline_GetDataFilePath(pattern, sizeof(pattern), DJI_OFFLINE_FC_RECORD_PATTERN);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return returnCode;
+    }
+
+    if (glob(pattern, 0, NULL, &s_fcRecordGlob) != 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+    }
+
+    returnCode = DjiFcSubscriptionReplay_Open((const char *const *) s_fcRecordGlob.gl_pathv,
+                                              (uint32_t) s_fcRecordGlob.gl_pathc);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        globfree(&s_fcRecordGlob);
+        return returnCode;
+    }
+
+    returnCode = DjiOfflinePlayer_Start(&s_fcReplayPlayer, "offline_fc", &source, NULL);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        DjiFcSubscriptionReplay_Close();
+        globfree(&s_fcRecordGlob);
+        return returnCode;
+    }
+
+    USER_LOG_INFO("Replay %u flight data record(s).", (uint32_t) s_fcRecordGlob.gl_pathc);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+static void DjiOffline_StopFcReplay(void)
+{
+    if (!s_fcReplayPlayer.started) {
+        return;
+    }
+
+    DjiOfflinePlayer_Stop(&s_fcReplayPlayer);
+    DjiFcSubscriptionReplay_Close();
+    globfree(&s_fcRecordGlob);
+}
+
+static T_DjiReturnCode DjiOffline_FcReplayPeek(void *arg, uint64_t *timeUs)
+{
+    return DjiFcSubscriptionReplay_GetNextTimeUs(timeUs);
+}
+
+static T_DjiReturnCode DjiOffline_FcReplayDeliver(void *arg)
+{
+    return DjiFcSubscriptionReplay_Step(NULL);
+}
+
+static T_DjiReturnCode DjiOffline_FcReplayRewind(void *arg)
+{
+    DjiFcSubscriptionReplay_Close();
+
+    return DjiFcSubscriptionReplay_Open((const char *const *) s_fcRecordGlob.gl_pathv,
+                                        (uint32_t) s_fcRecordGlob.gl_pathc);
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,388 @@
+/**
+ ********************************************************************
+ * @file    dji_offline_liveview.c
+ * @brief   Offline stand-in of the liveview API. Recorded H.264 elementary streams are split into
+ *          access units and delivered to the stream callback at the configured frame rate.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include "dji_offline.h"
+#include "dji_offline_player.h"
+#include "dji_liveview.h"
+#include "dji_logger.h"
+#include "utils/util_nal_splitter.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define DJI_OFFLINE_LIVEVIEW_STREAM_NUM         4
+#define DJI_OFFLINE_LIVEVIEW_NALU_TYPE_IDR      5
+#define DJI_OFFLINE_LIVEVIEW_NALU_TYPE_SEI      6
+#define DJI_OFFLINE_LIVEVIEW_NALU_TYPE_SPS      7
+#define DJI_OFFLINE_LIVEVIEW_NALU_TYPE_PPS      8
+#define DJI_OFFLINE_LIVEVIEW_NALU_TYPE_AUD      9
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    uint32_t offset;
+    uint32_t len;
+    bool isIdr;
+} T_DjiOfflineLiveviewFrame;
+
+typedef struct {
+    E_DjiLiveViewCameraPosition position;
+    DjiLiveview_H264Callback callback;
+    uint8_t *stream;
+    uint32_t streamLen;
+    T_DjiOfflineLiveviewFrame *frames;
+    uint32_t frameCount;
+    uint32_t frameIndex;
+    uint64_t deliveredFrameCount;
+    volatile bool intraFrameRequested;
+    T_DjiOfflinePlayer player;
+} T_DjiOfflineLiveviewStream;
+
+/* Private functions declaration ---------------------------------------------*/
+static T_DjiOfflineLiveviewStream *DjiOfflineLiveview_GetStream(E_DjiLiveViewCameraPosition position);
+static T_DjiReturnCode DjiOfflineLiveview_LoadStream(T_DjiOfflineLiveviewStream *stream,
+                                                     E_DjiLiveViewCameraPosition position,
+                                                     E_DjiLiveViewCameraSource source);
+static void DjiOfflineLiveview_FreeStream(T_DjiOfflineLiveviewStream *stream);
+static uint32_t DjiOfflineLiveview_SplitFrames(const uint8_t *data, uint32_t len, T_DjiOfflineLiveviewFrame *frames);
+static T_DjiReturnCode DjiOfflineLiveview_Peek(void *arg, uint64_t *timeUs);
+static T_DjiReturnCode DjiOfflineLiveview_Deliver(void *arg);
+static T_DjiReturnCode DjiOfflineLiveview_Rewind(void *arg);
+
+/* Private values -------------------------------------------------------------*/
+static T_DjiOfflineLiveviewStream s_liveviewStreams[DJI_OFFLINE_LIVEVIEW_STREAM_NUM];
+static bool s_liveviewInited = false;
+
+/* Exported functions definition ---------------------------------------------*/
+T_DjiReturnCode DjiLiveview_Init(void)
+{
+    if (DjiPlatform_GetOsalHandler() == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE;
+    }
+
+    s_liveviewInited = true;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiLiveview_Deinit(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < DJI_OFFLINE_LIVEVIEW_STREAM_NUM; i++) {
+        DjiOfflineLiveview_FreeStream(&s_liveviewStreams[i]);
+    }
+    s_liveviewInited = false;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Start delivering the stream recorded for a camera position. The first of liveview_<position>_<source>.h264,
+ * liveview_<position>.h264 and liveview.h264 found in the data directory is used.
+ */
+T_DjiReturnCode DjiLiveview_StartH264Stream(E_DjiLiveViewCameraPosition position, E_DjiLiveViewCameraSource source,
+                                            DjiLiveview_H264Callback callback)
+{
+    T_DjiOfflinePlayerSource playerSource = {
+        .Peek = DjiOfflineLiveview_Peek,
+        .Deliver = DjiOfflineLiveview_Deliver,
+        .Rewind = DjiOfflineLiveview_Rewind,
+    };
+    T_DjiOfflineLiveviewStream *stream = DjiOfflineLiveview_GetStream(position);
+    T_DjiReturnCode returnCode;
+
+    if (!s_liveviewInited) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE;
+    }
+
+    if (stream == NULL || callback == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    if (DjiOfflinePlayer_IsRunning(&stream->player)) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+    }
+    //a stream that was played to its end is released before it is loaded again
+    DjiOfflineLiveview_FreeStream(stream);
+
+    returnCode = DjiOfflineLiveview_LoadStream(stream, position, source);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return returnCode;
+    }
+    stream->position = position;
+    stream->callback = callback;
+
+    returnCode = DjiOfflinePlayer_Start(&stream->player, "offline_liveview", &playerSource, stream);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        DjiOfflineLiveview_FreeStream(stream);
+        return returnCode;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiLiveview_StopH264Stream(E_DjiLiveViewCameraPosition position, E_DjiLiveViewCameraSource source)
+{
+    T_DjiOfflineLiveviewStream *stream = DjiOfflineLiveview_GetStream(position);
+
+    if (stream == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    DjiOfflineLiveview_FreeStream(stream);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Make the next delivered frame an IDR frame by skipping ahead to it, as the encoder would insert one.
+ */
+T_DjiReturnCode DjiLiveview_RequestIntraframeFrameData(E_DjiLiveViewCameraPosition position,
+                                                       E_DjiLiveViewCameraSource source)
+{
+    T_DjiOfflineLiveviewStream *stream = DjiOfflineLiveview_GetStream(position);
+
+    if (stream == NULL || !DjiOfflinePlayer_IsRunning(&stream->player)) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE;
+    }
+    stream->intraFrameRequested = true;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/* Private functions definition-----------------------------------------------*/
+static T_DjiOfflineLiveviewStream *DjiOfflineLiveview_GetStream(E_DjiLiveViewCameraPosition position)
+{
+    switch (position) {
+        case DJI_LIVEVIEW_CAMERA_POSITION_NO_1:
+            return &s_liveviewStreams[0];
+        case DJI_LIVEVIEW_CAMERA_POSITION_NO_2:
+            return &s_liveviewStreams[1];
+        case DJI_LIVEVIEW_CAMERA_POSITION_NO_3:
+            return &s_liveviewStreams[2];
+        case DJI_LIVEVIEW_CAMERA_POSITION_FPV:
+            return &s_liveviewStreams[3];
+        default:
+            return NULL;
+    }
+}
+
+static T_DjiReturnCode DjiOfflineLiveview_LoadStream(T_DjiOfflineLiveviewStream *stream,
+                                                     E_DjiLiveViewCameraPosition position,
+                                                     E_DjiLiveViewCameraSource source)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    char fileNames[3][64];
+    char path[DJI_OFFLINE_PATH_MAX];
+    FILE *file = NULL;
+    long fileSize;
+    uint32_t i;
+
+    snprintf(fileNames[0], sizeof(fileNames[0]), "liveview_%d_%d.h264", position, source);
+    snprintf(fileNames[1], sizeof(fileNames[1]), "liveview_%d.h264", position);
+    snprintf(fileNames[2], sizeof(fileNames[2]), "liveview.h264");
+    for (i = 0; i < 3 && file == NULL; i++) {
+        if (DjiOffline_GetDataFilePath(path, sizeof(path), fileNames[i]) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            file = fopen(path, "rb");
+        }
+    }
+    if (file == NULL) {
+        USER_LOG_ERROR("No liveview recording in %s.", DjiOffline_GetConfig()->dataDirPath);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+    }
+
+    fseek(file, 0, SEEK_END);
+    fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (fileSize <= 0 || fileSize > UINT32_MAX) {
+        fclose(file);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
+    }
+
+    memset(stream, 0, sizeof(T_DjiOfflineLiveviewStream));
+    stream->streamLen = (uint32_t) fileSize;
+    stream->stream = osalHandler->Malloc(stream->streamLen);
+    if (stream->stream == NULL) {
+        fclose(file);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+
+    if (fread(stream->stream, 1, stream->streamLen, file) != stream->streamLen) {
+        fclose(file);
+        DjiOfflineLiveview_FreeStream(stream);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+    fclose(file);
+
+    stream->frameCount = DjiOfflineLiveview_SplitFrames(stream->stream, stream->streamLen, NULL);
+    if (stream->frameCount == 0) {
+        DjiOfflineLiveview_FreeStream(stream);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+    }
+
+    stream->frames = osalHandler->Malloc(stream->frameCount * sizeof(T_DjiOfflineLiveviewFrame));
+    if (stream->frames == NULL) {
+        DjiOfflineLiveview_FreeStream(stream);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+    DjiOfflineLiveview_SplitFrames(stream->stream, stream->streamLen, stream->frames);
+
+    USER_LOG_INFO("Liveview %s loaded, %u frames.", path, stream->frameCount);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+static void DjiOfflineLiveview_FreeStream(T_DjiOfflineLiveviewStream *stream)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    DjiOfflinePlayer_Stop(&stream->player);
+    if (stream->frames != NULL) {
+        osalHandler->Free(stream->frames);
+    }
+    if (stream->stream != NULL) {
+        osalHandler->Free(stream->stream);
+    }
+    memset(stream, 0, sizeof(T_DjiOfflineLiveviewStream));
+}
+
+/**
+ * @brief Split an Annex B stream into access units, each starting at the start code of its first NAL unit.
+ * A new access unit begins at an AUD, SPS, PPS or SEI, or at a slice with first_mb_in_slice equal to 0,
+ * once the current one holds a slice.
+ * @param frames: NULL to only count the access units.
+ * @return Number of access units.
+ */
+static uint32_t DjiOfflineLiveview_SplitFrames(const uint8_t *data, uint32_t len, T_DjiOfflineLiveviewFrame *frames)
+{
+    const uint8_t *startCode = UtilNalSplitter_FindStartCode(data, data + len);
+    uint32_t frameCount = 0;
+    uint32_t frameStart = 0;
+    uint32_t startCodePos;
+    bool hasFrameStart = false;
+    bool hasSlice = false;
+    bool isIdr = false;
+    bool newFrame;
+    uint8_t naluType;
+    uint32_t i;
+
+    for (; startCode != NULL; startCode = UtilNalSplitter_FindStartCode(startCode + 3, data + len)) {
+        i = (uint32_t) (startCode - data);
+        if (i + 3 >= len) {
+            break;
+        }
+
+        startCodePos = (i > 0 && data[i - 1] == 0) ? i - 1 : i;
+        naluType = data[i + 3] & 0x1F;
+        if (naluType >= 1 && naluType <= DJI_OFFLINE_LIVEVIEW_NALU_TYPE_IDR) {
+            //the first bit of the slice header is set when first_mb_in_slice is 0
+            newFrame = hasSlice && i + 4 < len && (data[i + 4] & 0x80) != 0;
+        } else {
+            newFrame = hasSlice && naluType >= DJI_OFFLINE_LIVEVIEW_NALU_TYPE_SEI &&
+                       naluType <= DJI_OFFLINE_LIVEVIEW_NALU_TYPE_AUD;
+        }
+
+        if (newFrame) {
+            if (frames != NULL) {
+                frames[frameCount].offset = frameStart;
+                frames[frameCount].len = startCodePos - frameStart;
+                frames[frameCount].isIdr = isIdr;
+            }
+            frameCount++;
+            hasFrameStart = false;
+            hasSlice = false;
+            isIdr = false;
+        }
+
+        if (!hasFrameStart) {
+            frameStart = startCodePos;
+            hasFrameStart = true;
+        }
+        if (naluType >= 1 && naluType <= DJI_OFFLINE_LIVEVIEW_NALU_TYPE_IDR) {
+            hasSlice = true;
+            isIdr = isIdr || naluType == DJI_OFFLINE_LIVEVIEW_NALU_TYPE_IDR;
+        }
+    }
+
+    if (hasSlice) {
+        if (frames != NULL) {
+            frames[frameCount].offset = frameStart;
+            frames[frameCount].len = len - frameStart;
+            frames[frameCount].isIdr = isIdr;
+        }
+        frameCount++;
+    }
+
+    return frameCount;
+}
+
+/**
+ * @brief Frames are due at the configured frame rate, counted over all delivered frames.
+ */
+static T_DjiReturnCode DjiOfflineLiveview_Peek(void *arg, uint64_t *timeUs)
+{
+    T_DjiOfflineLiveviewStream *stream = arg;
+    uint32_t i;
+
+    if (stream->intraFrameRequested) {
+        for (i = stream->frameIndex; i < stream->frameCount && !stream->frames[i].isIdr; i++) {
+        }
+        if (i < stream->frameCount) {
+            stream->frameIndex = i;
+        }
+        stream->intraFrameRequested = false;
+    }
+
+    if (stream->frameIndex >= stream->frameCount) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+    }
+    *timeUs = stream->deliveredFrameCount * 1000000 / DjiOffline_GetConfig()->liveviewFrameRate;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+static T_DjiReturnCode DjiOfflineLiveview_Deliver(void *arg)
+{
+    T_DjiOfflineLiveviewStream *stream = arg;
+    const T_DjiOfflineLiveviewFrame *frame = &stream->frames[stream->frameIndex];
+
+    stream->callback(stream->position, stream->stream + frame->offset, frame->len);
+    stream->frameIndex++;
+    stream->deliveredFrameCount++;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+static T_DjiReturnCode DjiOfflineLiveview_Rewind(void *arg)
+{
+    T_DjiOfflineLiveviewStream *stream = arg;
+
+    stream->frameIndex = 0;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
@@ -0,0 +1,275 @@
+/**
+ ********************************************************************
+ * @file    dji_offline_mop_channel.c
+ * @brief   Offline stand-in of the MOP channel API over TCP on the loopback interface. Channel n
+ *          listens on port mopPortBase + n, so a local test client can take the place of the MSDK side.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "dji_offline.h"
+#include "dji_mop_channel.h"
+#include "dji_platform.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define DJI_OFFLINE_MOP_CHANNEL_LISTEN_BACKLOG      8
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    int fd;
+    E_DjiMopChannelTransType transType;
+} T_DjiOfflineMopChannel;
+
+/* Private functions declaration ---------------------------------------------*/
+static void DjiOfflineMopChannel_GetAddress(uint16_t channelId, struct sockaddr_in *address);
+
+/* Private values -------------------------------------------------------------*/
+static bool s_mopChannelInited = false;
+
+/* Exported functions definition ---------------------------------------------*/
+T_DjiReturnCode DjiMopChannel_Init(void)
+{
+    if (DjiPlatform_GetOsalHandler() == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE;
+    }
+
+    s_mopChannelInited = true;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiMopChannel_Create(T_DjiMopChannelHandle *channelHandle, E_DjiMopChannelTransType transType)
+{
+    T_DjiOfflineMopChannel *channel;
+
+    if (!s_mopChannelInited) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE;
+    }
+
+    if (channelHandle == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    channel = DjiPlatform_GetOsalHandler()->Malloc(sizeof(T_DjiOfflineMopChannel));
+    if (channel == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+    }
+    channel->fd = -1;
+    channel->transType = transType;
+    *channelHandle = channel;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiMopChannel_Destroy(T_DjiMopChannelHandle channelHandle)
+{
+    if (channelHandle == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    DjiMopChannel_Close(channelHandle);
+    DjiPlatform_GetOsalHandler()->Free(channelHandle);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiMopChannel_Bind(T_DjiMopChannelHandle channelHandle, uint16_t channelId)
+{
+    T_DjiOfflineMopChannel *channel = channelHandle;
+    struct sockaddr_in address;
+    int reuse = 1;
+
+    if (channel == NULL || channel->fd >= 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    channel->fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (channel->fd < 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+    setsockopt(channel->fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    DjiOfflineMopChannel_GetAddress(channelId, &address);
+    if (bind(channel->fd, (struct sockaddr *) &address, sizeof(address)) != 0 ||
+        listen(channel->fd, DJI_OFFLINE_MOP_CHANNEL_LISTEN_BACKLOG) != 0) {
+        close(channel->fd);
+        channel->fd = -1;
+        return errno == EADDRINUSE ? DJI_ERROR_SYSTEM_MODULE_CODE_BUSY : DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiMopChannel_Accept(T_DjiMopChannelHandle channelHandle, T_DjiMopChannelHandle *outChannelHandle)
+{
+    T_DjiOfflineMopChannel *channel = channelHandle;
+    T_DjiOfflineMopChannel *outChannel;
+    T_DjiReturnCode returnCode;
+    int nodelay = 1;
+    int fd;
+
+    if (channel == NULL || channel->fd < 0 || outChannelHandle == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    do {
+        fd = accept4(channel->fd, NULL, NULL, SOCK_CLOEXEC);
+    } while (fd < 0 && errno == EINTR);
+    if (fd < 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    returnCode = DjiMopChannel_Create(outChannelHandle, channel->transType);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        close(fd);
+        return returnCode;
+    }
+    outChannel = *outChannelHandle;
+    outChannel->fd = fd;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiMopChannel_Connect(T_DjiMopChannelHandle channelHandle, E_DjiChannelAddress channelAddress,
+                                      uint16_t channelId)
+{
+    T_DjiOfflineMopChannel *channel = channelHandle;
+    struct sockaddr_in address;
+    int nodelay = 1;
+
+    if (channel == NULL || channel->fd >= 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    channel->fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (channel->fd < 0) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+    }
+
+    DjiOfflineMopChannel_GetAddress(channelId, &address);
+    if (connect(channel->fd, (struct sockaddr *) &address, sizeof(address)) != 0) {
+        close(channel->fd);
+        channel->fd = -1;
+        return DJI_ERROR_MOP_CHANNEL_MODULE_CODE_CONNECTION_CLOSE;
+    }
+    setsockopt(channel->fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiMopChannel_Close(T_DjiMopChannelHandle channelHandle)
+{
+    T_DjiOfflineMopChannel *channel = channelHandle;
+
+    if (channel == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    if (channel->fd >= 0) {
+        shutdown(channel->fd, SHUT_RDWR);
+        close(channel->fd);
+        channel->fd = -1;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Send all of the data, blocking while the peer is not reading.
+ */
+T_DjiReturnCode DjiMopChannel_SendData(T_DjiMopChannelHandle channelHandle, uint8_t *data, uint32_t len,
+                                       uint32_t *realLen)
+{
+    T_DjiOfflineMopChannel *channel = channelHandle;
+    uint32_t sentLen = 0;
+    ssize_t ret;
+
+    if (channel == NULL || data == NULL || realLen == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    if (channel->fd < 0) {
+        return DJI_ERROR_MOP_CHANNEL_MODULE_CODE_CONNECTION_CLOSE;
+    }
+
+    while (sentLen < len) {
+        ret = send(channel->fd, data + sentLen, len - sentLen, MSG_NOSIGNAL);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            *realLen = sentLen;
+            return DJI_ERROR_MOP_CHANNEL_MODULE_CODE_CONNECTION_CLOSE;
+        }
+        sentLen += (uint32_t) ret;
+    }
+    *realLen = sentLen;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Receive what is available, blocking until at least one byte arrives or the peer closes.
+ */
+T_DjiReturnCode DjiMopChannel_RecvData(T_DjiMopChannelHandle channelHandle, uint8_t *data, uint32_t len,
+                                       uint32_t *realLen)
+{
+    T_DjiOfflineMopChannel *channel = channelHandle;
+    ssize_t ret;
+
+    if (channel == NULL || data == NULL || realLen == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    if (channel->fd < 0) {
+        return DJI_ERROR_MOP_CHANNEL_MODULE_CODE_CONNECTION_CLOSE;
+    }
+
+    do {
+        ret = recv(channel->fd, data, len, 0);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret <= 0) {
+        *realLen = 0;
+        return DJI_ERROR_MOP_CHANNEL_MODULE_CODE_CONNECTION_CLOSE;
+    }
+    *realLen = (uint32_t) ret;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/* Private functions definition-----------------------------------------------*/
+static void DjiOfflineMopChannel_GetAddress(uint16_t channelId, struct sockaddr_in *address)
+{
+    memset(address, 0, sizeof(struct sockaddr_in));
+    address->sin_family = AF_INET;
+    address->sin_port = htons((uint16_t) (DjiOffline_GetConfig()->mopPortBase + channelId));
+    address->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
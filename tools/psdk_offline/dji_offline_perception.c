@@ -0,0 +1,253 @@
+/**
+ ********************************************************************
+ * @file    dji_offline_perception.c
+ * @brief   Offline stand-in of the perception image API. Recorded stereo images are delivered to the
+ *          subscribed callback of each direction at their recorded pace.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include "dji_offline.h"
+#include "dji_offline_player.h"
+#include "dji_perception.h"
+#include "dji_logger.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define DJI_OFFLINE_PERCEPTION_PARAMETERS_FILE_NAME     "perception_parameters.bin"
+/* Larger records are treated as corrupt, a 1280x960 16 bit image is well below it. */
+#define DJI_OFFLINE_PERCEPTION_DATA_MAX_LEN             (16 * 1024 * 1024)
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+    E_DjiPerceptionDirection direction;
+    DjiPerceptionImageCallback callback;
+    FILE *file;
+    bool pending;
+    T_DjiOfflinePerceptionRecordHeader header;
+    uint8_t *buffer;
+    uint32_t bufferSize;
+    T_DjiOfflinePlayer player;
+} T_DjiOfflinePerceptionStream;
+
+/* Private functions declaration ---------------------------------------------*/
+static void DjiOfflinePerception_CloseStream(T_DjiOfflinePerceptionStream *stream);
+static T_DjiReturnCode DjiOfflinePerception_Peek(void *arg, uint64_t *timeUs);
+static T_DjiReturnCode DjiOfflinePerception_Deliver(void *arg);
+static T_DjiReturnCode DjiOfflinePerception_Rewind(void *arg);
+
+/* Private values -------------------------------------------------------------*/
+static T_DjiOfflinePerceptionStream s_perceptionStreams[IMAGE_MAX_DIRECTION_NUM];
+static bool s_perceptionInited = false;
+
+/* Exported functions definition ---------------------------------------------*/
+T_DjiReturnCode DjiPerception_Init(void)
+{
+    if (DjiPlatform_GetOsalHandler() == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE;
+    }
+
+    s_perceptionInited = true;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiPerception_Deinit(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < IMAGE_MAX_DIRECTION_NUM; i++) {
+        DjiOfflinePerception_CloseStream(&s_perceptionStreams[i]);
+    }
+    s_perceptionInited = false;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Start delivering the images recorded in perception_<direction>.bin of the data directory. The file is
+ * a sequence of T_DjiOfflinePerceptionRecordHeader, each followed by its image data.
+ */
+T_DjiReturnCode DjiPerception_SubscribePerceptionImage(E_DjiPerceptionDirection direction,
+                                                       DjiPerceptionImageCallback callback)
+{
+    T_DjiOfflinePlayerSource playerSource = {
+        .Peek = DjiOfflinePerception_Peek,
+        .Deliver = DjiOfflinePerception_Deliver,
+        .Rewind = DjiOfflinePerception_Rewind,
+    };
+    T_DjiOfflinePerceptionStream *stream;
+    char fileName[32];
+    char path[DJI_OFFLINE_PATH_MAX];
+    T_DjiReturnCode returnCode;
+
+    if (!s_perceptionInited) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE;
+    }
+
+    if ((uint32_t) direction >= IMAGE_MAX_DIRECTION_NUM || callback == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    stream = &s_perceptionStreams[direction];
+    if (DjiOfflinePlayer_IsRunning(&stream->player)) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+    }
+    //a recording that was played to its end is released before it is opened again
+    DjiOfflinePerception_CloseStream(stream);
+
+    snprintf(fileName, sizeof(fileName), "perception_%d.bin", direction);
+    returnCode = DjiOffline_GetDataFilePath(path, sizeof(path), fileName);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return returnCode;
+    }
+
+    memset(stream, 0, sizeof(T_DjiOfflinePerceptionStream));
+    stream->file = fopen(path, "rb");
+    if (stream->file == NULL) {
+        USER_LOG_ERROR("No perception recording %s.", path);
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+    }
+    stream->direction = direction;
+    stream->callback = callback;
+
+    returnCode = DjiOfflinePlayer_Start(&stream->player, "offline_perception", &playerSource, stream);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        DjiOfflinePerception_CloseStream(stream);
+        return returnCode;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiPerception_UnsubscribePerceptionImage(E_DjiPerceptionDirection direction)
+{
+    if ((uint32_t) direction >= IMAGE_MAX_DIRECTION_NUM) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    DjiOfflinePerception_CloseStream(&s_perceptionStreams[direction]);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Read the camera parameters from perception_parameters.bin, a T_DjiPerceptionCameraParametersPacket.
+ */
+T_DjiReturnCode DjiPerception_GetStereoCameraParameters(T_DjiPerceptionCameraParametersPacket *packet)
+{
+    char path[DJI_OFFLINE_PATH_MAX];
+    T_DjiReturnCode returnCode;
+    FILE *file;
+    size_t readLen;
+
+    if (packet == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_INVALID_PARAMETER;
+    }
+
+    returnCode = DjiOffline_GetDataFilePath(path, sizeof(path), DJI_OFFLINE_PERCEPTION_PARAMETERS_FILE_NAME);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return returnCode;
+    }
+
+    file = fopen(path, "rb");
+    if (file == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+    }
+    readLen = fread(packet, 1, sizeof(T_DjiPerceptionCameraParametersPacket), file);
+    fclose(file);
+
+    return readLen == sizeof(T_DjiPerceptionCameraParametersPacket) ? DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS :
+           DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+}
+
+/* Private functions definition-----------------------------------------------*/
+static void DjiOfflinePerception_CloseStream(T_DjiOfflinePerceptionStream *stream)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    DjiOfflinePlayer_Stop(&stream->player);
+    if (stream->file != NULL) {
+        fclose(stream->file);
+    }
+    if (stream->buffer != NULL) {
+        osalHandler->Free(stream->buffer);
+    }
+    memset(stream, 0, sizeof(T_DjiOfflinePerceptionStream));
+}
+
+static T_DjiReturnCode DjiOfflinePerception_Peek(void *arg, uint64_t *timeUs)
+{
+    T_DjiOfflinePerceptionStream *stream = arg;
+
+    if (!stream->pending) {
+        if (fread(&stream->header, sizeof(stream->header), 1, stream->file) != 1) {
+            return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+        }
+        if (stream->header.magic != DJI_OFFLINE_PERCEPTION_RECORD_MAGIC ||
+            stream->header.dataLen > DJI_OFFLINE_PERCEPTION_DATA_MAX_LEN) {
+            USER_LOG_ERROR("Perception recording of direction %d is corrupt.", stream->direction);
+            return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+        }
+        stream->pending = true;
+    }
+    *timeUs = stream->header.recvTimeUs;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+static T_DjiReturnCode DjiOfflinePerception_Deliver(void *arg)
+{
+    T_DjiOfflinePerceptionStream *stream = arg;
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    uint32_t dataLen = stream->header.dataLen;
+
+    stream->pending = false;
+    if (dataLen > stream->bufferSize) {
+        if (stream->buffer != NULL) {
+            osalHandler->Free(stream->buffer);
+        }
+        stream->buffer = osalHandler->Malloc(dataLen);
+        stream->bufferSize = stream->buffer != NULL ? dataLen : 0;
+        if (stream->buffer == NULL) {
+            return DJI_ERROR_SYSTEM_MODULE_CODE_MEMORY_ALLOC_FAILED;
+        }
+    }
+
+    if (fread(stream->buffer, 1, dataLen, stream->file) != dataLen) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND;
+    }
+    stream->callback(stream->header.imageInfo, stream->buffer, dataLen);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+static T_DjiReturnCode DjiOfflinePerception_Rewind(void *arg)
+{
+    T_DjiOfflinePerceptionStream *stream = arg;
+
+    stream->pending = false;
+
+    return fseek(stream->file, 0, SEEK_SET) == 0 ? DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS :
+           DJI_ERROR_SYSTEM_MODULE_CODE_SYSTEM_ERROR;
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
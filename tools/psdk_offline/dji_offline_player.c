@@ -0,0 +1,222 @@
+/**
+ ********************************************************************
+ * @file    dji_offline_player.c
+ * @brief   Replay task shared by the offline modules. Items of a recording are delivered on a task
+ *          of their own at the recorded pace, scaled by the configured rate.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "dji_offline.h"
+#include "dji_offline_player.h"
+#include "dji_logger.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define DJI_OFFLINE_PLAYER_TASK_STACK_SIZE      2048
+/* Items due within this margin are delivered at once rather than after another sleep. */
+#define DJI_OFFLINE_PLAYER_EARLY_MARGIN_US      500
+
+/* Private types -------------------------------------------------------------*/
+
+/* Private functions declaration ---------------------------------------------*/
+static void *DjiOfflinePlayer_Task(void *arg);
+static bool DjiOfflinePlayer_WaitUntil(T_DjiOfflinePlayer *player, uint64_t dueTimeUs);
+static uint64_t DjiOfflinePlayer_GetTimeUs(void);
+
+/* Private values -------------------------------------------------------------*/
+
+/* Exported functions definition ---------------------------------------------*/
+T_DjiReturnCode DjiOfflinePlayer_Start(T_DjiOfflinePlayer *player, const char *name,
+                                       const T_DjiOfflinePlayerSource *source, void *arg)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    T_DjiReturnCode returnCode;
+
+    if (osalHandler == NULL) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT_IN_CURRENT_STATE;
+    }
+
+    if (player->started) {
+        if (DjiOfflinePlayer_IsRunning(player)) {
+            return DJI_ERROR_SYSTEM_MODULE_CODE_BUSY;
+        }
+        DjiOfflinePlayer_Stop(player);
+    }
+
+    memset(player, 0, sizeof(T_DjiOfflinePlayer));
+    player->source = *source;
+    player->arg = arg;
+
+    returnCode = osalHandler->SemaphoreCreate(0, &player->wakeSema);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        return returnCode;
+    }
+
+    returnCode = osalHandler->SemaphoreCreate(0, &player->exitSema);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        osalHandler->SemaphoreDestroy(player->wakeSema);
+        return returnCode;
+    }
+
+    //set before the task exists, a source that is empty ends the task at once
+    __atomic_store_n(&player->running, true, __ATOMIC_RELEASE);
+    returnCode = osalHandler->TaskCreate(name, DjiOfflinePlayer_Task, DJI_OFFLINE_PLAYER_TASK_STACK_SIZE, player,
+                                         &player->task);
+    if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+        __atomic_store_n(&player->running, false, __ATOMIC_RELEASE);
+        osalHandler->SemaphoreDestroy(player->exitSema);
+        osalHandler->SemaphoreDestroy(player->wakeSema);
+        return returnCode;
+    }
+    player->started = true;
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/**
+ * @brief Stop the task and wait until it has left the user callback.
+ * @note Must not be called from a callback of the same player.
+ */
+T_DjiReturnCode DjiOfflinePlayer_Stop(T_DjiOfflinePlayer *player)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+
+    if (!player->started) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+    }
+
+    __atomic_store_n(&player->stop, true, __ATOMIC_RELEASE);
+    osalHandler->SemaphorePost(player->wakeSema);
+    osalHandler->SemaphoreWait(player->exitSema);
+    osalHandler->TaskDestroy(player->task);
+    osalHandler->SemaphoreDestroy(player->exitSema);
+    osalHandler->SemaphoreDestroy(player->wakeSema);
+    player->started = false;
+    __atomic_store_n(&player->running, false, __ATOMIC_RELEASE);
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+bool DjiOfflinePlayer_IsRunning(T_DjiOfflinePlayer *player)
+{
+    return __atomic_load_n(&player->running, __ATOMIC_ACQUIRE);
+}
+
+T_DjiReturnCode DjiOffline_GetDataFilePath(char *path, uint32_t size, const char *fileName)
+{
+    int len = snprintf(path, size, "%s/%s", DjiOffline_GetConfig()->dataDirPath, fileName);
+
+    if (len < 0 || (uint32_t) len >= size) {
+        return DJI_ERROR_SYSTEM_MODULE_CODE_OUT_OF_RANGE;
+    }
+
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/* Private functions definition-----------------------------------------------*/
+/**
+ * @brief Deliver the items of a source in order. The first item is delivered at once and each following one
+ * when its recording time, relative to the first, has passed on the local clock divided by the rate.
+ */
+static void *DjiOfflinePlayer_Task(void *arg)
+{
+    T_DjiOfflinePlayer *player = arg;
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    float rate = DjiOffline_GetConfig()->rate;
+    bool loop = DjiOffline_GetConfig()->loop && player->source.Rewind != NULL;
+    uint64_t deliveredCountAtStart = 0;
+    uint64_t mediaStartUs = 0;
+    uint64_t localStartUs = 0;
+    uint64_t mediaTimeUs;
+    uint64_t dueTimeUs;
+    bool started = false;
+    T_DjiReturnCode returnCode;
+
+    while (!__atomic_load_n(&player->stop, __ATOMIC_ACQUIRE)) {
+        returnCode = player->source.Peek(player->arg, &mediaTimeUs);
+        if (returnCode == DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND && loop &&
+            player->deliveredCount > deliveredCountAtStart &&
+            player->source.Rewind(player->arg) == DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            deliveredCountAtStart = player->deliveredCount;
+            started = false;
+            continue;
+        }
+        if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS) {
+            if (returnCode != DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND) {
+                USER_LOG_ERROR("Offline replay stopped, error: 0x%08llX.", returnCode);
+            }
+            break;
+        }
+
+        if (!started) {
+            mediaStartUs = mediaTimeUs;
+            localStartUs = DjiOfflinePlayer_GetTimeUs();
+            started = true;
+        }
+
+        if (rate > 0 && mediaTimeUs > mediaStartUs) {
+            dueTimeUs = localStartUs + (uint64_t) ((double) (mediaTimeUs - mediaStartUs) / rate);
+            if (!DjiOfflinePlayer_WaitUntil(player, dueTimeUs)) {
+                break;
+            }
+        }
+
+        player->source.Deliver(player->arg);
+        player->deliveredCount++;
+    }
+
+    __atomic_store_n(&player->running, false, __ATOMIC_RELEASE);
+    osalHandler->SemaphorePost(player->exitSema);
+
+    return NULL;
+}
+
+/**
+ * @return false when the player was stopped while waiting.
+ */
+static bool DjiOfflinePlayer_WaitUntil(T_DjiOfflinePlayer *player, uint64_t dueTimeUs)
+{
+    T_DjiOsalHandler *osalHandler = DjiPlatform_GetOsalHandler();
+    uint64_t nowUs = DjiOfflinePlayer_GetTimeUs();
+
+    while (!__atomic_load_n(&player->stop, __ATOMIC_ACQUIRE) && nowUs + DJI_OFFLINE_PLAYER_EARLY_MARGIN_US < dueTimeUs) {
+        osalHandler->SemaphoreTimedWait(player->wakeSema, (uint32_t) ((dueTimeUs - nowUs + 999) / 1000));
+        nowUs = DjiOfflinePlayer_GetTimeUs();
+    }
+
+    return !__atomic_load_n(&player->stop, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @note Pacing uses the monotonic clock rather than the OSAL time, which may follow wall clock adjustments.
+ */
+static uint64_t DjiOfflinePlayer_GetTimeUs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000000 + (uint64_t) now.tv_nsec / 1000;
+}
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/
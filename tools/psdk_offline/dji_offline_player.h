@@ -0,0 +1,78 @@
+/**
+ ********************************************************************
+ * @file    dji_offline_player.h
+ * @brief   This is the header file for "dji_offline_player.c", defining the structure and
+ * (exported) function prototypes.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef DJI_OFFLINE_PLAYER_H
+#define DJI_OFFLINE_PLAYER_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "dji_typedef.h"
+#include "dji_platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+    /*! Get the recording time of the next item, DJI_ERROR_SYSTEM_MODULE_CODE_NOT_FOUND at the end. */
+    T_DjiReturnCode (*Peek)(void *arg, uint64_t *timeUs);
+    /*! Hand the item returned by Peek to the user callback. */
+    T_DjiReturnCode (*Deliver)(void *arg);
+    /*! Start again at the first item, NULL if the source cannot loop. */
+    T_DjiReturnCode (*Rewind)(void *arg);
+} T_DjiOfflinePlayerSource;
+
+typedef struct {
+    T_DjiOfflinePlayerSource source;
+    void *arg;
+    T_DjiTaskHandle task;
+    T_DjiSemaHandle wakeSema;
+    T_DjiSemaHandle exitSema;
+    /*! Set by DjiOfflinePlayer_Stop, read by the task. Accessed with __atomic builtins only. */
+    bool stop;
+    /*! The task and semaphores exist until DjiOfflinePlayer_Stop, also after the task has ended. */
+    bool started;
+    /*! Cleared by the task when it ends, at the end of the source or on an error. Read with
+     * DjiOfflinePlayer_IsRunning. */
+    bool running;
+    uint64_t deliveredCount;
+} T_DjiOfflinePlayer;
+
+/* Exported functions --------------------------------------------------------*/
+T_DjiReturnCode DjiOfflinePlayer_Start(T_DjiOfflinePlayer *player, const char *name,
+                                       const T_DjiOfflinePlayerSource *source, void *arg);
+T_DjiReturnCode DjiOfflinePlayer_Stop(T_DjiOfflinePlayer *player);
+bool DjiOfflinePlayer_IsRunning(T_DjiOfflinePlayer *player);
+T_DjiReturnCode DjiOffline_GetDataFilePath(char *path, uint32_t size, const char *fileName);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DJI_OFFLINE_PLAYER_H
+/************************ (C) COPYRIGHT DJI Innovations *******END OF FILE******/
@@ -0,0 +1,1811 @@
+/**
+ ********************************************************************
+ * @file    dji_offline_stub.c
+ * @brief   Offline stand-ins of the PSDK functions without a recorded source. Initialization and
+ *          callback registration succeed so the samples start up, every other call reports
+ *          DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT and logs the function name once.
+ *
+ * @copyright (c) 2021 DJI. All rights reserved.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ *
+ *********************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* dji_fts.h and dji_network_rtk.h share an include guard, so the guard is cleared between the two. */
+#include "dji_network_rtk.h"
+#undef DJI_NETWORK_RTK_H
+#include "dji_fts.h"
+#include "dji_aircraft_info.h"
+#include "dji_camera_manager.h"
+#include "dji_cloud_api_by_websockt.h"
+#include "dji_flight_controller.h"
+#include "dji_gimbal.h"
+#include "dji_gimbal_manager.h"
+#include "dji_high_speed_data_channel.h"
+#include "dji_hms_customization.h"
+#include "dji_hms_manager.h"
+#include "dji_interest_point.h"
+#include "dji_liveview.h"
+#include "dji_logger.h"
+#include "dji_low_speed_data_channel.h"
+#include "dji_open_ar.h"
+#include "dji_payload_camera.h"
+#include "dji_perception.h"
+#include "dji_positioning.h"
+#include "dji_power_management.h"
+#include "dji_tethered_battery.h"
+#include "dji_time_sync.h"
+#include "dji_upgrade.h"
+#include "dji_waypoint_v2.h"
+#include "dji_waypoint_v3.h"
+#include "dji_widget.h"
+#include "dji_widget_manager.h"
+#include "dji_xport.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define DJI_OFFLINE_STUB_RETURN_NONSUPPORT()                                            \
+    do {                                                                                \
+        static bool s_logged = false;                                                   \
+        if (!s_logged) {                                                                \
+            s_logged = true;                                                            \
+            USER_LOG_WARN("%s is not supported by the offline library.", __FUNCTION__); \
+        }                                                                               \
+        return DJI_ERROR_SYSTEM_MODULE_CODE_NONSUPPORT;                                 \
+    } while (0)
+
+/* Private types -------------------------------------------------------------*/
+
+/* Private functions declaration ---------------------------------------------*/
+
+/* Private values -------------------------------------------------------------*/
+
+/* Exported functions definition ---------------------------------------------*/
+/* dji_aircraft_info.h */
+T_DjiReturnCode DjiAircraftInfo_GetEnhancedTransmission(E_DjiEnhancedTransmissionState *state)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+/* dji_camera_manager.h */
+T_DjiReturnCode DjiCameraManager_Init(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiCameraManager_DeInit(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiCameraManager_GetCameraType(E_DjiMountPosition position, E_DjiCameraType *cameraType)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetFirmwareVersion(E_DjiMountPosition position,
+                                                    T_DjiCameraManagerFirmwareVersion *firmwareVersion)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetCameraConnectStatus(E_DjiMountPosition position, bool *connectStatus)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetMode(E_DjiMountPosition position, E_DjiCameraManagerWorkMode workMode)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetMode(E_DjiMountPosition position, E_DjiCameraManagerWorkMode *workMode)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetShootPhotoMode(E_DjiMountPosition position, E_DjiCameraManagerShootPhotoMode mode)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetShootPhotoMode(E_DjiMountPosition position,
+                                                   E_DjiCameraManagerShootPhotoMode *takePhotoMode)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_StartShootPhoto(E_DjiMountPosition position, E_DjiCameraManagerShootPhotoMode mode)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_StopShootPhoto(E_DjiMountPosition position)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetCapturingState(E_DjiMountPosition position,
+                                                   E_DjiCameraManagerCapturingState *capturingState)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetPhotoBurstCount(E_DjiMountPosition position, E_DjiCameraBurstCount count)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetPhotoTimeIntervalSettings(E_DjiMountPosition position,
+                                                              T_DjiCameraPhotoTimeIntervalSettings intervalSetting)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetPhotoTimeIntervalSettings(E_DjiMountPosition position,
+                                                              T_DjiCameraPhotoTimeIntervalSettings *intervalSetting)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetIntervalShootingRemainTime(E_DjiMountPosition position, uint8_t *remainTime)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetFocusMode(E_DjiMountPosition position, E_DjiCameraManagerFocusMode focusMode)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetFocusMode(E_DjiMountPosition position, E_DjiCameraManagerFocusMode *focusMode)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetFocusTarget(E_DjiMountPosition position,
+                                                T_DjiCameraManagerFocusPosData focusPosData)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetFocusTarget(E_DjiMountPosition position,
+                                                T_DjiCameraManagerFocusPosData *tapFocusPos)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_StartContinuousOpticalZoom(E_DjiMountPosition position,
+                                                            E_DjiCameraZoomDirection zoomDirection,
+                                                            E_DjiCameraZoomSpeed zoomSpeed)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_StopContinuousOpticalZoom(E_DjiMountPosition position)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetOpticalZoomParam(E_DjiMountPosition position,
+                                                     E_DjiCameraZoomDirection zoomDirection, dji_f32_t factor)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetOpticalZoomParam(E_DjiMountPosition position,
+                                                     T_DjiCameraManagerOpticalZoomParam *opticalZoomParam)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetInfraredZoomParam(E_DjiMountPosition position, dji_f32_t factor)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetTapZoomEnabled(E_DjiMountPosition position, bool param)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetTapZoomEnabled(E_DjiMountPosition position, bool *param)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetTapZoomMultiplier(E_DjiMountPosition position, uint8_t tapZoomMultiplier)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetTapZoomMultiplier(E_DjiMountPosition position, uint8_t *tapZoomMultiplier)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_TapZoomAtTarget(E_DjiMountPosition position,
+                                                 T_DjiCameraManagerTapZoomPosData tapZoomPos)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetFocusRingRange(E_DjiMountPosition position, T_DjiCameraManagerRangeList *rangeList)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetFocusRingValue(E_DjiMountPosition position, uint16_t value)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetFocusRingValue(E_DjiMountPosition position, uint16_t *value)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetExposureMode(E_DjiMountPosition position, E_DjiCameraManagerExposureMode mode)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetExposureMode(E_DjiMountPosition position, E_DjiCameraManagerExposureMode *mode)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetISO(E_DjiMountPosition position, E_DjiCameraManagerISO iso)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetISO(E_DjiMountPosition position, E_DjiCameraManagerISO *iso)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetAperture(E_DjiMountPosition position, E_DjiCameraManagerAperture aperture)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetAperture(E_DjiMountPosition position, E_DjiCameraManagerAperture *aperture)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetShutterSpeed(E_DjiMountPosition position,
+                                                 E_DjiCameraManagerShutterSpeed shutterSpeed)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetShutterSpeed(E_DjiMountPosition position,
+                                                 E_DjiCameraManagerShutterSpeed *shutterSpeed)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetExposureCompensation(E_DjiMountPosition position,
+                                                         E_DjiCameraManagerExposureCompensation ev)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetExposureCompensation(E_DjiMountPosition position,
+                                                         E_DjiCameraManagerExposureCompensation *ev)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetAELockEnabled(E_DjiMountPosition position, bool enable)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetAELockEnabled(E_DjiMountPosition position, bool *enable)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_ResetCameraSettings(E_DjiMountPosition position)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_StartRecordVideo(E_DjiMountPosition position)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_StopRecordVideo(E_DjiMountPosition position)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetRecordingState(E_DjiMountPosition position,
+                                                   E_DjiCameraManagerRecordingState *recordingState)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetRecordingTime(E_DjiMountPosition position, uint16_t *recordingTime)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetStreamSourceRange(E_DjiMountPosition position,
+                                                      T_DjiCameraManagerRangeList *rangeList)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetStreamSource(E_DjiMountPosition position,
+                                                 E_DjiCameraManagerStreamSource streamSource)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetPhotoStorageFormatRange(E_DjiMountPosition position,
+                                                            T_DjiCameraManagerRangeList *rangeList)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetPhotoFormat(E_DjiMountPosition position,
+                                                E_DjiCameraManagerPhotoStorageFormat format)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetPhotoFormat(E_DjiMountPosition position,
+                                                E_DjiCameraManagerPhotoStorageFormat *format)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetVideoFormatRange(E_DjiMountPosition position,
+                                                     T_DjiCameraManagerRangeList *rangeList)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetVideoStorageFormat(E_DjiMountPosition position,
+                                                       E_DjiCameraManagerVideoStorageFormat format)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetVideoFormat(E_DjiMountPosition position,
+                                                E_DjiCameraManagerVideoStorageFormat *format)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetPhotoRatioRange(E_DjiMountPosition position, T_DjiCameraManagerRangeList *rangeList)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetPhotoRatio(E_DjiMountPosition position, E_DjiCameraManagerPhotoRatio photoRatio)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetPhotoRatio(E_DjiMountPosition position, E_DjiCameraManagerPhotoRatio *photoRatio)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetVideoResolutionFrameRate(E_DjiMountPosition position,
+                                                             T_DjiCameraManagerVideoFormat *videoParam)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetNightSceneModeRange(E_DjiMountPosition position,
+                                                        T_DjiCameraManagerRangeList *rangeList)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetNightSceneMode(E_DjiMountPosition position,
+                                                   E_DjiCameraManagerNightSceneMode nightSceneMode)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetNightSceneMode(E_DjiMountPosition position,
+                                                   E_DjiCameraManagerNightSceneMode *nightSceneMode)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetStreamStorageRange(E_DjiMountPosition position,
+                                                       T_DjiCameraManagerRangeList *rangeList)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetCaptureRecordingStreams(E_DjiMountPosition position,
+                                                            E_DjiCameraManagerCaptureOrRecording streamType,
+                                                            T_DjiCameraManagerStreamList *streamStorageList)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetCaptureRecordingStreams(E_DjiMountPosition position,
+                                                            E_DjiCameraManagerCaptureOrRecording streamType,
+                                                            T_DjiCameraManagerStreamList *streamStorageList)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetSynchronizedSplitScreenZoomEnabled(E_DjiMountPosition position, bool enable)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetCustomExpandName(E_DjiMountPosition position,
+                                                     E_DjiCameraManagerExpandNameType nameType, const uint8_t *nameStr,
+                                                     uint32_t nameSize)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetCustomExpandName(E_DjiMountPosition position,
+                                                     E_DjiCameraManagerExpandNameType nameType, uint8_t *nameStr,
+                                                     uint32_t *nameSize)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_DownloadFileList(E_DjiMountPosition position, T_DjiCameraManagerFileList *fileList)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_DownloadFileListBySlices(E_DjiMountPosition position,
+                                                          T_DjiCameraManagerSliceConfig sliceConfig,
+                                                          T_DjiCameraManagerFileList *fileList)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_RegDownloadFileDataCallback(E_DjiMountPosition position,
+                                                             DjiCameraManagerDownloadFileDataCallback callback)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiCameraManager_DownloadFileByIndex(E_DjiMountPosition position, uint32_t fileIndex)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_DownloadSubFileByIndexAndSubType(E_DjiMountPosition position, uint32_t index,
+                                                                  E_DjiCameraMediaFileSubType fileType)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_ObtainDownloaderRights(E_DjiMountPosition position)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_ReleaseDownloaderRights(E_DjiMountPosition position)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_FormatStorage(E_DjiMountPosition position)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetStorageInfo(E_DjiMountPosition position, T_DjiCameraManagerStorageInfo *storageInfo)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_DeleteFileByIndex(E_DjiMountPosition position, uint32_t fileIndex)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetLaserRangingInfo(E_DjiMountPosition position,
+                                                     T_DjiCameraManagerLaserRangingInfo *laserRangingInfo)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetPointThermometryCoordinate(
+    E_DjiMountPosition position, T_DjiCameraManagerPointThermometryCoordinate pointCoordinate)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetPointThermometryData(E_DjiMountPosition position,
+                                                         T_DjiCameraManagerPointThermometryData *pointThermometryData)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetAreaThermometryCoordinate(
+    E_DjiMountPosition position, T_DjiCameraManagerAreaThermometryCoordinate areaCoordinate)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetAreaThermometryData(E_DjiMountPosition position,
+                                                        T_DjiCameraManagerAreaThermometryData *areaThermometryData)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetFfcMode(E_DjiMountPosition position, E_DjiCameraManagerFfcMode ffcMode)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_TriggerFfc(E_DjiMountPosition position)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetInfraredCameraGainMode(E_DjiMountPosition position,
+                                                           E_DjiCameraManagerIrGainMode gainMode)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetInfraredCameraGainModeTemperatureRange(
+    E_DjiMountPosition position, T_DjiCameraManagerIrTempMeterRange *tempRange)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetMeteringModeRange(E_DjiMountPosition position,
+                                                      T_DjiCameraManagerRangeList *rangeList)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetMeteringMode(E_DjiMountPosition position,
+                                                 E_DjiCameraManagerMeteringMode meteringMode)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetMeteringMode(E_DjiMountPosition position,
+                                                 E_DjiCameraManagerMeteringMode *meteringMode)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetMeteringPointRegionRange(E_DjiMountPosition position, uint8_t *hrzNum,
+                                                             uint8_t *vtcNum)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetMeteringPoint(E_DjiMountPosition position, uint8_t x, uint8_t y)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_SetMeteringPointNormalized(E_DjiMountPosition position, dji_f32_t x, dji_f32_t y)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetMeteringPoint(E_DjiMountPosition position, uint8_t *x, uint8_t *y)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_GetMeteringPointNormalized(E_DjiMountPosition position, dji_f32_t *x, dji_f32_t *y)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_StartRecordPointCloud(E_DjiMountPosition position)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiCameraManager_StopRecordPointCloud(E_DjiMountPosition position)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+/* dji_cloud_api_by_websockt.h */
+T_DjiReturnCode DjiCloudApi_SendDataByWebSocket(uint8_t *data, uint32_t len, uint32_t *realLen)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+/* dji_flight_controller.h */
+T_DjiReturnCode DjiFlightController_Init(T_DjiFlightControllerRidInfo ridInfo)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiFlightController_DeInit(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiFlightController_SetPlanningAlgo(uint8_t algo)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_SetMaxVelocity(uint8_t value)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_SetMinFlightHeight(float value)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_GetExitReason(uint16_t *reason)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_RegisterOpenMisInfoCallBack(FcCmderModeOpenMisEventCbFunc callback)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiFlightController_RegisterCoreTrajCallBack(FcCmderModeCoreTrajEventCbFunc callback)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiFlightController_AntiRegisterOpenMisInfoCallBack(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiFlightController_AntiRegisterCoreTrajCallBack(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiFlightController_SetModeStartMission(T_DjiFlightControllerStartMissionReq command,
+                                                        T_DjiFlightControllerStartMissionRsp *rsp)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_SetRtkPositionEnableStatus(
+    E_DjiFlightControllerRtkPositionEnableStatus rtkEnableStatus)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_GetRtkPositionEnableStatus(
+    E_DjiFlightControllerRtkPositionEnableStatus *rtkEnableStatus)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_SetRCLostAction(E_DjiFlightControllerRCLostAction rcLostAction)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_GetRCLostAction(E_DjiFlightControllerRCLostAction *rcLostAction)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_SetHorizontalVisualObstacleAvoidanceEnableStatus(
+    E_DjiFlightControllerObstacleAvoidanceEnableStatus horizontalObstacleAvoidanceEnableStatus)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_GetHorizontalVisualObstacleAvoidanceEnableStatus(
+    E_DjiFlightControllerObstacleAvoidanceEnableStatus *horizontalObstacleAvoidanceEnableStatus)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_SetHorizontalRadarObstacleAvoidanceEnableStatus(
+    E_DjiFlightControllerObstacleAvoidanceEnableStatus horizontalObstacleAvoidanceEnableStatus)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_GetHorizontalRadarObstacleAvoidanceEnableStatus(
+    E_DjiFlightControllerObstacleAvoidanceEnableStatus *horizontalObstacleAvoidanceEnableStatus)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_SetUpwardsVisualObstacleAvoidanceEnableStatus(
+    E_DjiFlightControllerObstacleAvoidanceEnableStatus upwardsObstacleAvoidanceEnableStatus)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_GetUpwardsVisualObstacleAvoidanceEnableStatus(
+    E_DjiFlightControllerObstacleAvoidanceEnableStatus *upwardsObstacleAvoidanceEnableStatus)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_SetUpwardsRadarObstacleAvoidanceEnableStatus(
+    E_DjiFlightControllerObstacleAvoidanceEnableStatus upwardsObstacleAvoidanceEnableStatus)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_GetUpwardsRadarObstacleAvoidanceEnableStatus(
+    E_DjiFlightControllerObstacleAvoidanceEnableStatus *upwardsObstacleAvoidanceEnableStatus)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_SetDownwardsVisualObstacleAvoidanceEnableStatus(
+    E_DjiFlightControllerObstacleAvoidanceEnableStatus downwardsObstacleAvoidanceEnableStatus)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_GetDownwardsVisualObstacleAvoidanceEnableStatus(
+    E_DjiFlightControllerObstacleAvoidanceEnableStatus *downwardsObstacleAvoidanceEnableStatus)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_ArrestFlying(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_CancelArrestFlying(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_TurnOnMotors(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_TurnOffMotors(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_EmergencyStopMotor(E_DjiFlightControllerEmergencyStopMotor cmd,
+                                                       char debugMsg[EMERGENCY_STOP_MOTOR_MSG_MAX_LENGTH])
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_StartTakeoff(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_StartLanding(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_CancelLanding(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_StartConfirmLanding(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_StartForceLanding(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_SetHomeLocationUsingGPSCoordinates(T_DjiFlightControllerHomeLocation homeLocation)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_SetHomeLocationUsingCurrentAircraftLocation(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_SetGoHomeAltitude(E_DjiFlightControllerGoHomeAltitude altitude)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_GetGoHomeAltitude(E_DjiFlightControllerGoHomeAltitude *altitude)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_GetCountryCode(uint16_t *countryCode)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_StartGoHome(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_CancelGoHome(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_ObtainJoystickCtrlAuthority(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_ReleaseJoystickCtrlAuthority(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_RegJoystickCtrlAuthorityEventCallback(JoystickCtrlAuthorityEventCbFunc callback)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+void DjiFlightController_SetJoystickMode(T_DjiFlightControllerJoystickMode joystickMode)
+{
+}
+
+T_DjiReturnCode DjiFlightController_ExecuteJoystickAction(T_DjiFlightControllerJoystickCommand joystickCommand)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_ExecuteEmergencyBrakeAction(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_CancelEmergencyBrakeAction(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_GetGeneralInfo(T_DjiFlightControllerGeneralInfo *generalInfo)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_SetRCLostActionEnableStatus(E_DjiFlightControllerRCLostActionEnableStatus command)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_GetEnableRCLostActionStatus(E_DjiFlightControllerRCLostActionEnableStatus *command)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_RegTriggerFtsEventCallback(TriggerFtsEventCallback callback)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiFlightController_StartSlowRotateMotor(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_StopSlowRotateMotor(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFlightController_GetElectronicSpeedControllerStatus(
+    E_DjiFlightControllerElectronicSpeedControllerStatus *status)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+/* dji_fts.h */
+T_DjiReturnCode DjiFts_SelectFtsPwmTrigger(E_DjiMountPosition position)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiFts_GetFtsPwmTriggerStatus(T_DjiFtsPwmEscTriggerStatus* trigger_status)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+/* dji_gimbal.h */
+T_DjiReturnCode DjiGimbal_Init(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiGimbal_DeInit(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiGimbal_RegCommonHandler(const T_DjiGimbalCommonHandler *commonHandler)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/* dji_gimbal_manager.h */
+T_DjiReturnCode DjiGimbalManager_Init(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiGimbalManager_Deinit(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiGimbalManager_SetMode(E_DjiMountPosition mountPosition, E_DjiGimbalMode mode)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiGimbalManager_Reset(E_DjiMountPosition mountPosition, E_DjiGimbalResetMode resetMode)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiGimbalManager_Rotate(E_DjiMountPosition mountPosition, T_DjiGimbalManagerRotation rotation)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiGimbalManager_SetPitchRangeExtensionEnabled(E_DjiMountPosition mountPosition, bool enabledFlag)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiGimbalManager_SetControllerMaxSpeedPercentage(E_DjiMountPosition mountPosition, E_DjiGimbalAxis axis,
+                                                                 uint8_t maxSpeedPercentage)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiGimbalManager_SetControllerSmoothFactor(E_DjiMountPosition mountPosition, E_DjiGimbalAxis axis,
+                                                           uint8_t smoothingFactor)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiGimbalManager_RestoreFactorySettings(E_DjiMountPosition mountPosition)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+/* dji_high_speed_data_channel.h */
+T_DjiReturnCode DjiHighSpeedDataChannel_SetBandwidthProportion(
+    T_DjiDataChannelBandwidthProportionOfHighspeedChannel bandwidthProportion)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiHighSpeedDataChannel_GetDataStreamRemoteAddress(char *ipAddr, uint16_t *port)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiHighSpeedDataChannel_SendDataStreamData(const uint8_t *data, uint16_t len)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiHighSpeedDataChannel_GetDataStreamState(T_DjiDataChannelState *state)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+/* dji_hms_customization.h */
+T_DjiReturnCode DjiHmsCustomization_Init(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiHmsCustomization_DeInit(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiHmsCustomization_InjectHmsErrorCode(uint32_t errorCode, E_DjiHmsErrorLevel errorLevel)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiHmsCustomization_EliminateHmsErrorCode(uint32_t errorCode)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiHmsCustomization_RegDefaultHmsTextConfigByDirPath(const char *configDirPath)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiHmsCustomization_RegHmsTextConfigByDirPath(E_DjiMobileAppLanguage appLanguage,
+                                                              const char *configDirPath)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiHmsCustomization_RegDefaultHmsTextConfigByBinaryArray(
+    const T_DjiHmsBinaryArrayConfig *binaryArrayConfig)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiHmsCustomization_RegHmsTextConfigByBinaryArray(E_DjiMobileAppLanguage appLanguage,
+                                                                  const T_DjiHmsBinaryArrayConfig *binaryArrayConfig)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiHmsCustomization_AlarmEnhancedCtrl(E_DjiHmsAlarmEnhancedAction action,
+                                                      T_DjiHmsAlarmEnhancedSetting setting)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+/* dji_hms_manager.h */
+T_DjiReturnCode DjiHmsManager_Init(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiHmsManager_DeInit(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiHmsManager_RegHmsInfoCallback(DjiHmsInfoCallback callback)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/* dji_interest_point.h */
+T_DjiReturnCode DjiInterestPoint_Init(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiInterestPoint_DeInit(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiInterestPoint_Start(T_DjiInterestPointSettings settings)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiInterestPoint_Stop(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiInterestPoint_SetSpeed(dji_f32_t speed)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiInterestPoint_RegMissionStateCallback(InterestPointMissionStateCallback callback)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/* dji_liveview.h */
+T_DjiReturnCode DjiLiveview_StartImageStream(E_DjiLiveViewCameraPosition position, E_DjiLiveViewCameraSource source,
+                                             E_DjiLiveViewPixFormate pixFmt, DjiLiveview_ImageCallback callback)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLiveview_StopImageStream(E_DjiLiveViewCameraPosition position, E_DjiLiveViewCameraSource source)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLiveview_RegEncoderCallback(DjiLiveview_EncoderCallback callback)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiLiveview_UnregEncoderCallback(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiLiveview_EncodeAFrameToH264(const uint8_t *buf, uint32_t len, T_DjiLiveviewImageInfo imageInfo,
+                                               T_DjiLiveViewStandardMetaData *metaData)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLiveview_RegUserAiTargetLableList(uint8_t lableCount, const char *labels[])
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiLiveview_UnregUserAiTargetLableList(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiLiveview_SendAiMetaToPilot(T_DjiLiveViewStandardMetaData *metaData)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+/* dji_low_speed_data_channel.h */
+T_DjiReturnCode DjiLowSpeedDataChannel_Init(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiLowSpeedDataChannel_DeInit(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiLowSpeedDataChannel_SendData(E_DjiChannelAddress channelAddress, const uint8_t *data, uint8_t len)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLowSpeedDataChannel_GetSendDataState(E_DjiChannelAddress channelAddress,
+                                                        T_DjiDataChannelState *state)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLowSpeedDataChannel_RegRecvDataCallback(E_DjiChannelAddress channelAddress,
+                                                           DjiLowSpeedDataChannelRecvDataCallback callback)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/* dji_network_rtk.h */
+T_DjiReturnCode DjiNetworkRtk_RegReceiveNetworkRtkStateCallback(DjiReceiveNetworkRtkStateCallback callback)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiNetworkRtk_StartService(const T_DjiNetworkRtkServiceConfig* config)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiNetworkRtk_StopService(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+/* dji_open_ar.h */
+T_DjiReturnCode DjiLiveview_ArSetPoint(const T_DjiOpenArPointArray* entry)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLiveview_ArUpdatePoint(const T_DjiOpenArPointArray* entry)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLiveview_ArDeletePoint(const T_DjiOpenArDeletePointEntry* entry)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLiveview_ArClearPoint(uint32_t resource_id)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLiveview_ArSetLine(const T_DjiOpenArLine* entry)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLiveview_ArUpdateLine(const T_DjiOpenArLine* entry)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLiveview_ArDeleteLine(const T_DjiOpenArDeleteLineEntry* entry, uint32_t entry_len)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLiveview_ArClearLine(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLiveview_ArSetPolygon(const T_DjiOpenArPolygon* entry)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLiveview_ArUpdatePolygon(const T_DjiOpenArPolygon* entry)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLiveview_ArDeletePolygon(const T_DjiOpenArDeletePolygonEntry* entry, uint32_t entry_len)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLiveview_ArClearPolygon(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLiveview_ArSetCircle(const T_DjiOpenArCircle* entry)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLiveview_ArUpdateCircle(const T_DjiOpenArCircle* entry)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLiveview_ArDeleteCircle(const T_DjiOpenArDeleteCircleEntry* entry, uint32_t entry_len)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLiveview_ArClearCircle(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLiveview_ArSetPivotAxis(const T_DjiOpenArPivotAxis* entry)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLiveview_ArUpdatePivotAxis(const T_DjiOpenArPivotAxis* entry)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLiveview_ArDeletePivotAxis(const T_DjiOpenArDeletePovixAxisEntry* entry, uint32_t entry_len)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLiveview_ArClearPivotAxis(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiLiveview_ArRegRefleshAllCallback(DjiLiveview_ArRefleshAllCallback callback)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+/* dji_payload_camera.h */
+T_DjiReturnCode DjiPayloadCamera_Init(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiPayloadCamera_RegCommonHandler(const T_DjiCameraCommonHandler *cameraCommonHandler)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiPayloadCamera_RegExposureMeteringHandler(
+    const T_DjiCameraExposureMeteringHandler *cameraExposureMeteringHandler)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiPayloadCamera_RegFocusHandler(const T_DjiCameraFocusHandler *cameraFocusHandler)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiPayloadCamera_RegDigitalZoomHandler(const T_DjiCameraDigitalZoomHandler *cameraDigitalZoomHandler)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiPayloadCamera_RegOpticalZoomHandler(const T_DjiCameraOpticalZoomHandler *cameraOpticalZoomHandler)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiPayloadCamera_RegTapZoomHandler(const T_DjiCameraTapZoomHandler *cameraTapZoomHandler)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiPayloadCamera_SetVideoStreamType(E_DjiCameraVideoStreamType videoStreamType)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiPayloadCamera_GetVideoStreamRemoteAddress(char *ipAddr, uint16_t *port)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiPayloadCamera_RegMediaDownloadPlaybackHandler(
+    const T_DjiCameraMediaDownloadPlaybackHandler *cameraMediaHandler)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiPayloadCamera_SendVideoStream(const uint8_t *data, uint32_t len)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiPayloadCamera_GetVideoStreamState(T_DjiDataChannelState *state)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiPayloadCamera_PushAddedMediaFileInfo(const char *filePath, T_DjiCameraMediaFileInfo mediaFileInfo)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiPayloadCamera_GetCameraTypeOfPayload(E_DjiMountPosition payloadPosition, E_DjiCameraType *cameraType)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiPayloadCamera_GetCameraOpticalZoomSpecOfPayload(E_DjiMountPosition payloadPosition,
+                                                                   T_DjiCameraOpticalZoomSpec *opticalZoomSpec)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiPayloadCamera_GetCameraHybridZoomFocalLengthOfPayload(E_DjiMountPosition payloadPosition,
+                                                                         uint16_t *focalLength)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+/* dji_perception.h */
+T_DjiReturnCode DjiPerception_SubscribeLidarData(DjiPerceptionLidarDataCallback callback)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiPerception_UnsubscribeLidarData(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiPerception_SubscribeRadarData(E_DjiPerceptionRadarPosition position,
+                                                 DjiPerceptionRadarCallback callback)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiPerception_UnsubscribeRadarData(E_DjiPerceptionRadarPosition position)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+/* dji_positioning.h */
+T_DjiReturnCode DjiPositioning_Init(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+void DjiPositioning_SetTaskIndex(uint8_t index)
+{
+}
+
+T_DjiReturnCode DjiPositioning_GetPositionInformationSync(uint8_t eventCount, T_DjiPositioningEventInfo *eventInfo,
+                                                          T_DjiPositioningPositionInfo *positionInfo)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiPositioning_RegReceiveRtcmDataCallback(E_DjiPositioningRtcmDataType dataType,
+                                                          DjiReceiveRtkRtcmDataCallback callback)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/* dji_power_management.h */
+T_DjiReturnCode DjiPowerManagement_Init(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiPowerManagement_DeInit(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiPowerManagement_ApplyHighPowerSync(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiPowerManagement_ApplyHighPowerSyncV2(E_DjiHighPowerVoltage voltage)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiPowerManagement_RegWriteHighPowerApplyPinCallback(DjiWriteHighPowerApplyPinCallback callback)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiPowerManagement_RegPowerOffNotificationCallback(DjiPowerOffNotificationCallback callback)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiPowerManagement_OutputHighPower(bool stat)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+/* dji_tethered_battery.h */
+T_DjiReturnCode DjiTetheredBattery_Init(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiTetheredBattery_DeInit(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiTetheredBattery_PushTetherLineStatus(T_DjiTetherLineStatus tetherLineStatus)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+/* dji_time_sync.h */
+T_DjiReturnCode DjiTimeSync_Init(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiTimeSync_RegGetNewestPpsTriggerTimeCallback(DjiGetNewestPpsTriggerLocalTimeUsCallback callback)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiTimeSync_TransferToAircraftTime(uint64_t localTimeUs, T_DjiTimeSyncAircraftTime *aircraftTime)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+/* dji_upgrade.h */
+T_DjiReturnCode DjiUpgrade_Init(const T_DjiUpgradeConfig *upgradeConfig)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiUpgrade_EnableLocalUpgrade(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiUpgrade_RegHandler(const T_DjiUpgradeHandler *upgradeHandler)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiUpgrade_PushUpgradeState(const T_DjiUpgradeState *upgradeState)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+/* dji_waypoint_v2.h */
+T_DjiReturnCode DjiWaypointV2_Init(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiWaypointV2_Deinit(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiWaypointV2_UploadMission(const T_DjiWayPointV2MissionSettings *info)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiWaypointV2_Start(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiWaypointV2_Stop(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiWaypointV2_Pause(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiWaypointV2_Resume(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiWaypointV2_GetGlobalCruiseSpeed(T_DjiWaypointV2GlobalCruiseSpeed *cruiseSpeed)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiWaypointV2_SetGlobalCruiseSpeed(T_DjiWaypointV2GlobalCruiseSpeed cruiseSpeed)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiWaypointV2_RegisterMissionEventCallback(WaypointV2EventCbFunc callback)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiWaypointV2_RegisterMissionStateCallback(WaypointV2StateCbFunc callback)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/* dji_waypoint_v3.h */
+T_DjiReturnCode DjiWaypointV3_Init(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiWaypointV3_DeInit(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiWaypointV3_UploadKmzFile(const uint8_t *data, uint32_t dataLen)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiWaypointV3_Action(E_DjiWaypointV3Action action)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiWaypointV3_RegMissionStateCallback(WaypointV3MissionStateCallback callback)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiWaypointV3_RegActionStateCallback(WaypointV3ActionStateCallback callback)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/* dji_widget.h */
+T_DjiReturnCode DjiWidget_Init(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiWidget_RegDefaultUiConfigByDirPath(const char *widgetConfigDirPath)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiWidget_RegUiConfigByDirPath(E_DjiMobileAppLanguage appLanguage,
+                                               E_DjiMobileAppScreenType appScreenType, const char *widgetConfigDirPath)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiWidget_RegDefaultUiConfigByBinaryArray(const T_DjiWidgetBinaryArrayConfig *binaryArrayConfig)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiWidget_RegUiConfigByBinaryArray(E_DjiMobileAppLanguage appLanguage,
+                                                   E_DjiMobileAppScreenType screenType,
+                                                   const T_DjiWidgetBinaryArrayConfig *binaryArrayConfig)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiWidget_RegHandlerList(const T_DjiWidgetHandlerListItem *widgetHandlerList, uint32_t itemCount)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiWidgetFloatingWindow_ShowMessage(const char *str)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiWidgetFloatingWindow_GetChannelState(T_DjiDataChannelState *state)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiWidget_RegSpeakerHandler(const T_DjiWidgetSpeakerHandler *widgetSpeakerHandler)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+/* dji_widget_manager.h */
+T_DjiReturnCode DjiWidgetManager_Init(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiWidgetManager_DeInit(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiWidgetManager_SubscribePayloadWidgetStates(E_DjiMountPosition position,
+                                                              RecvWidgetStatesCallback recvStatesCallback)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiWidgetManager_UnsubscribePayloadWidgetStates(E_DjiMountPosition position)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiWidgetManager_SetWidgetState(E_DjiMountPosition position, T_DjiWidgetStates states)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiWidgetManager_SubscribeSpeakerStates(E_DjiMountPosition position,
+                                                        RecvSpeakerStatesCallback recvStatesCallback)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiWidgetManager_UnsubscribeSpeakerStates(E_DjiMountPosition position)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiWidgetManager_SetSpeakertState(E_DjiMountPosition position, T_DjiSpeakerWidgetStatesParam *states)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiWidgetManager_SendSpeakerAudioData(E_DjiMountPosition position,
+                                                      T_DjiSpeakerAudioFileInfo *audioFileInfo)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiWidgetManager_WidgetDownloadFileList(E_DjiMountPosition position,
+                                                        T_DjiWidgetManagerFileList *fileList)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiWidgetManager_RegDownloadFileDataCallback(E_DjiMountPosition position,
+                                                             DjiWidgetDownloadFileDataCallback recvFileCallback)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiWidgetManager_UnRegDownloadFileDataCallback(E_DjiMountPosition position)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiWidgetManager_DownloadFileByIndex(E_DjiMountPosition position, uint32_t fileIndex)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+/* dji_xport.h */
+T_DjiReturnCode DjiXPort_Init(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiXPort_DeInit(void)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiXPort_RegReceiveSystemStateCallback(DjiReceiveXPortSystemStateCallback callback)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiXPort_RegReceiveAttitudeInformationCallback(DjiReceiveXPortAttitudeInformationCallback callback)
+{
+    return DJI_ERROR_SYSTEM_MODULE_CODE_SUCCESS;
+}
+
+T_DjiReturnCode DjiXPort_SetGimbalModeSync(E_DjiGimbalMode mode)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiXPort_RotateSync(E_DjiGimbalRotationMode rotationMode, T_DjiGimbalRotationProperty rotationProperty,
+                                    T_DjiAttitude3d rotationValue)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiXPort_ReleaseControlPermissionSync(void)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiXPort_ResetSync(E_DjiGimbalResetMode mode)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiXPort_SetLimitAngleSync(E_DjiXPortLimitAngleCategory limitAngleCategory,
+                                           T_DjiXPortLimitAngle limitAngle)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiXPort_GetLimitAngleSync(E_DjiXPortLimitAngleCategory limitAngleCategory,
+                                           T_DjiXPortLimitAngle *limitAngle)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+T_DjiReturnCode DjiXPort_SetSpeedConversionFactor(float factor)
+{
+    DJI_OFFLINE_STUB_RETURN_NONSUPPORT();
+}
+
+/* Private functions definition-----------------------------------------------*/
+
+/****************** (C) COPYRIGHT DJI Innovations *****END OF FILE****/